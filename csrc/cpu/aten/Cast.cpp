@@ -1,4 +1,5 @@
-#include <ATen/Parallel.h>
+#include "Cast.h"
+#include <torch/csrc/autograd/function.h>
 #include "csrc/utils/CustomOperatorRegistration.h"
 #include "fp8_utils.h"
 
@@ -7,6 +8,10 @@ namespace cpu {
 
 using namespace torch_ipex::cpu;
 
+IPEX_DEFINE_DISPATCH(fp8_quantize_kernel_stub);
+IPEX_DEFINE_DISPATCH(fp8_cast_transpose_kernel_stub);
+IPEX_DEFINE_DISPATCH(fp8_dequantize_kernel_stub);
+
 at::ScalarType convert_to_dtype(int64_t format) {
   switch (format) {
     case Float8Format::kFloat8_E5M2:
@@ -18,68 +23,6 @@ at::ScalarType convert_to_dtype(int64_t format) {
   }
 }
 
-template <typename scalar_t, typename type_t>
-void fp8_quantize_impl(
-    at::Tensor& input,
-    at::Tensor& scale,
-    at::Tensor& amax_history,
-    at::Tensor& scale_inv,
-    int64_t& fp8_tensor_index,
-    at::Tensor& output) {
-  RECORD_FUNCTION("fp8_quantize_impl", c10::ArrayRef<c10::IValue>({}));
-
-  scalar_t* input_data = input.data_ptr<scalar_t>();
-  scalar_t* input_ptr = input_data;
-  float* scale_ptr = scale.data_ptr<float>();
-  float scale_val = scale_ptr[fp8_tensor_index];
-  type_t* output_data = output.data_ptr<type_t>();
-  type_t* output_ptr = output_data;
-
-  int64_t fp8_max =
-      output.scalar_type() == c10::ScalarType::Float8_e4m3fn ? 448 : 57344;
-  int num_threads = at::get_num_threads();
-  std::vector<float> max_buffer(num_threads, 0);
-  at::parallel_for(
-      0,
-      input.numel(),
-      at::internal::GRAIN_SIZE,
-      [&](int64_t begin, int64_t end) {
-        int tid = at::get_thread_num();
-        float local_max = 0;
-        for (const auto n : c10::irange(begin, end)) {
-          float out = input_ptr[n] * scale_val;
-          float out_saturation = out;
-          if (fabsf(out) > fp8_max) {
-            out_saturation = out > 0 ? fp8_max : (-1.0) * fp8_max;
-          }
-          output_ptr[n] = static_cast<type_t>(out_saturation);
-          local_max = fmaxf(fabsf(input_ptr[n]), local_max);
-        }
-        max_buffer[tid] = local_max;
-      });
-
-  float max = *std::max_element(max_buffer.begin(), max_buffer.end());
-  float* scale_inv_ptr = scale_inv.data_ptr<float>();
-  scale_inv_ptr[fp8_tensor_index] = 1.0 / scale_val;
-  amax_history[fp8_tensor_index] = max;
-}
-
-template <typename scalar_t>
-void fp8_quantize(
-    at::Tensor& input,
-    at::Tensor& scale,
-    at::Tensor& amax_history,
-    at::Tensor& scale_inv,
-    int64_t& fp8_tensor_index,
-    at::Tensor& output,
-    int64_t otype) {
-  IPEX_TYPE_SWITCH_FP8ONLY(
-      otype,
-      type_t,
-      fp8_quantize_impl<scalar_t, type_t>(
-          input, scale, amax_history, scale_inv, fp8_tensor_index, output););
-}
-
 at::Tensor cast_to_fp8(
     at::Tensor& input,
     at::Tensor& scale,
@@ -87,65 +30,43 @@ at::Tensor cast_to_fp8(
     at::Tensor& scale_inv,
     int64_t fp8_tensor_index,
     int64_t otype) {
+  RECORD_FUNCTION("ipex::cast_to_fp8", c10::ArrayRef<c10::IValue>({}));
+
   at::ScalarType out_type = convert_to_dtype(otype);
-  auto output = at::empty(input.sizes(), input.options().dtype(out_type));
-  AT_DISPATCH_FLOATING_TYPES_AND2(
-      at::ScalarType::BFloat16,
-      at::ScalarType::Half,
-      input.scalar_type(),
-      "fp8_quantize",
-      [&] {
-        fp8_quantize<scalar_t>(
-            input,
-            scale,
-            amax_history,
-            scale_inv,
-            fp8_tensor_index,
-            output,
-            otype);
-      });
+  auto input_ = input.contiguous();
+  auto output = at::empty(input_.sizes(), input_.options().dtype(out_type));
+  float scale_val = scale.data_ptr<float>()[fp8_tensor_index];
+  float amax = fp8_quantize_kernel_stub(kCPU, input_, scale_val, output);
+  scale_inv.data_ptr<float>()[fp8_tensor_index] = 1.0 / scale_val;
+  amax_history.data_ptr<float>()[fp8_tensor_index] = amax;
   return output;
 }
 
-template <typename scalar_t, typename type_t>
-at::Tensor fp8_dequantize_impl(
+// Quantize a 2D input like cast_to_fp8 and also return the transpose of the
+// fp8 output, e.g. to feed both the dgrad and the wgrad GEMMs of a linear
+// backward from a single pass over the gradient.
+std::tuple<at::Tensor, at::Tensor> cast_transpose_to_fp8(
     at::Tensor& input,
+    at::Tensor& scale,
+    at::Tensor& amax_history,
     at::Tensor& scale_inv,
     int64_t fp8_tensor_index,
-    at::Tensor& output) {
-  RECORD_FUNCTION("fp8_dequantize_impl", c10::ArrayRef<c10::IValue>({}));
-
-  type_t* input_data = input.data_ptr<type_t>();
-  type_t* input_ptr = input_data;
-  float* scale_inv_ptr = scale_inv.data_ptr<float>();
-  float scale_inv_val = scale_inv_ptr[fp8_tensor_index];
-  scalar_t* output_data = output.data_ptr<scalar_t>();
-  scalar_t* output_ptr = output_data;
-
-  at::parallel_for(
-      0,
-      input.numel(),
-      at::internal::GRAIN_SIZE,
-      [&](int64_t begin, int64_t end) {
-        int tid = at::get_thread_num();
-        for (const auto n : c10::irange(begin, end)) {
-          output_ptr[n] = static_cast<scalar_t>(input_ptr[n] * scale_inv_val);
-        }
-      });
-  return output;
-}
+    int64_t otype) {
+  RECORD_FUNCTION(
+      "ipex::cast_transpose_to_fp8", c10::ArrayRef<c10::IValue>({}));
 
-template <typename scalar_t>
-void fp8_dequantize(
-    at::Tensor& input,
-    at::Tensor& scale_inv,
-    int64_t fp8_tensor_index,
-    at::Tensor& output,
-    int64_t itype) {
-  IPEX_TYPE_SWITCH_FP8ONLY(itype,
-                           type_t,
-                           fp8_dequantize_impl<scalar_t, type_t>(
-                               input, scale_inv, fp8_tensor_index, output););
+  TORCH_CHECK(input.dim() == 2, "cast_transpose_to_fp8: expect a 2D input");
+  at::ScalarType out_type = convert_to_dtype(otype);
+  auto input_ = input.contiguous();
+  auto output = at::empty(input_.sizes(), input_.options().dtype(out_type));
+  auto output_t = at::empty(
+      {input_.size(1), input_.size(0)}, input_.options().dtype(out_type));
+  float scale_val = scale.data_ptr<float>()[fp8_tensor_index];
+  float amax = fp8_cast_transpose_kernel_stub(
+      kCPU, input_, scale_val, output, output_t);
+  scale_inv.data_ptr<float>()[fp8_tensor_index] = 1.0 / scale_val;
+  amax_history.data_ptr<float>()[fp8_tensor_index] = amax;
+  return std::make_tuple(output, output_t);
 }
 
 at::Tensor cast_from_fp8(
@@ -154,19 +75,108 @@ at::Tensor cast_from_fp8(
     int64_t fp8_tensor_index,
     int64_t itype,
     ScalarType otype) {
-  auto output = at::empty_like(input, otype);
-  AT_DISPATCH_FLOATING_TYPES_AND2(
-      at::ScalarType::BFloat16,
-      at::ScalarType::Half,
-      output.scalar_type(),
-      "fp8_dequantize",
-      [&] {
-        fp8_dequantize<scalar_t>(
-            input, scale_inv, fp8_tensor_index, output, itype);
-      });
+  RECORD_FUNCTION("ipex::cast_from_fp8", c10::ArrayRef<c10::IValue>({}));
+
+  TORCH_CHECK(
+      input.scalar_type() == convert_to_dtype(itype),
+      "cast_from_fp8: input dtype does not match the fp8 format");
+  auto input_ = input.contiguous();
+  auto output = at::empty_like(input_, otype);
+  float scale_inv_val = scale_inv.data_ptr<float>()[fp8_tensor_index];
+  fp8_dequantize_kernel_stub(kCPU, input_, scale_inv_val, output);
   return output;
 }
 
+// Delayed scaling recipe, i.e. the fused counterpart of
+// default_amax_and_scale_update in quantization/fp8/fp8.py. The amax of each
+// fp8 tensor is taken from amax_history, either the max over the whole
+// history or the most recent one, then the history is rolled by one row and
+// the new row 0 is cleared for the next iteration. The new scaling factor is
+// the largest power of 2 which keeps amax * scale within fp8_max / 2^margin,
+// and the previous scale is kept if amax is 0 or not finite. All the tensors
+// are updated in place.
+//
+// The amax reduction itself is fused into the cast kernels, which write the
+// amax of the tensor they quantize into row 0 of amax_history, so this op only
+// reads the [history_len, num_fp8_tensors] history. It is kept out of the
+// cast kernels on purpose: the recipe updates all the scales once per step,
+// and updating them from within a cast would change the scale of the tensors
+// cast later in the same step.
+void fp8_amax_and_scale_update(
+    at::Tensor& amax_history,
+    at::Tensor& scale,
+    at::Tensor& scale_inv,
+    double fp8_max,
+    int64_t margin,
+    c10::string_view amax_compute_algo) {
+  RECORD_FUNCTION(
+      "ipex::fp8_amax_and_scale_update", c10::ArrayRef<c10::IValue>({}));
+
+  TORCH_CHECK(
+      amax_history.dim() == 2 && amax_history.is_contiguous() &&
+          amax_history.scalar_type() == at::kFloat,
+      "fp8_amax_and_scale_update: expect a contiguous float amax_history of "
+      "shape [history_len, num_fp8_tensors]");
+  TORCH_CHECK(
+      amax_compute_algo == "max" || amax_compute_algo == "most_recent",
+      "fp8_amax_and_scale_update: unsupported amax_compute_algo ",
+      amax_compute_algo);
+  const int64_t history_len = amax_history.size(0);
+  const int64_t num_tensors = amax_history.size(1);
+  TORCH_CHECK(
+      scale.is_contiguous() && scale.scalar_type() == at::kFloat &&
+          scale.numel() == num_tensors && scale_inv.is_contiguous() &&
+          scale_inv.scalar_type() == at::kFloat &&
+          scale_inv.numel() == num_tensors,
+      "fp8_amax_and_scale_update: expect contiguous float scale and scale_inv "
+      "with one element per fp8 tensor");
+
+  float* history_ptr = amax_history.data_ptr<float>();
+  float* scale_ptr = scale.data_ptr<float>();
+  float* scale_inv_ptr = scale_inv.data_ptr<float>();
+  const bool use_max = amax_compute_algo == "max";
+  const float max_val = static_cast<float>(fp8_max);
+
+  std::vector<float> amax(history_ptr, history_ptr + num_tensors);
+  if (use_max) {
+    for (const auto i : c10::irange(1, history_len)) {
+      const float* row = history_ptr + i * num_tensors;
+      for (const auto j : c10::irange(num_tensors)) {
+        // NaN is propagated as torch.max does
+        if (std::isnan(row[j]) || row[j] > amax[j]) {
+          amax[j] = row[j];
+        }
+      }
+    }
+  }
+
+  if (history_len > 1) {
+    std::vector<float> first_row(history_ptr, history_ptr + num_tensors);
+    std::memmove(
+        history_ptr,
+        history_ptr + num_tensors,
+        (history_len - 1) * num_tensors * sizeof(float));
+    std::copy(
+        first_row.begin(),
+        first_row.end(),
+        history_ptr + (history_len - 1) * num_tensors);
+  }
+  std::fill(history_ptr, history_ptr + num_tensors, 0.f);
+
+  for (const auto j : c10::irange(num_tensors)) {
+    float exp = std::floor(std::log2(max_val / amax[j])) - margin;
+    float sf = std::round(std::pow(2.f, std::fabs(exp)));
+    if (!(amax[j] > 0.f) || !std::isfinite(amax[j])) {
+      sf = scale_ptr[j];
+    }
+    if (exp < 0.f) {
+      sf = 1.f / sf;
+    }
+    scale_ptr[j] = sf;
+    scale_inv_ptr[j] = 1.f / sf;
+  }
+}
+
 } // namespace cpu
 } // namespace torch_ipex
 
@@ -175,8 +185,22 @@ namespace {
 IPEX_LIBRARY_FRAGMENT() {
   IPEX_OP_IPEX_REGISTER_DISPATCH(
       "cast_to_fp8", torch_ipex::cpu::cast_to_fp8, c10::DispatchKey::CPU);
+  IPEX_OP_IPEX_REGISTER_DISPATCH(
+      "cast_transpose_to_fp8",
+      torch_ipex::cpu::cast_transpose_to_fp8,
+      c10::DispatchKey::CPU);
   IPEX_OP_IPEX_REGISTER_DISPATCH(
       "cast_from_fp8", torch_ipex::cpu::cast_from_fp8, c10::DispatchKey::CPU);
+  // The schema inferred from the signature would miss that the three tensors
+  // are written, so it is spelled out with alias annotations
+  m.def(
+      "fp8_amax_and_scale_update(Tensor(a!) amax_history, Tensor(b!) scale, "
+      "Tensor(c!) scale_inv, float fp8_max, int margin, "
+      "str amax_compute_algo) -> ()");
+  m.impl(
+      "fp8_amax_and_scale_update",
+      c10::DispatchKey::CPU,
+      torch_ipex::cpu::fp8_amax_and_scale_update);
 }
 
 } // namespace
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <dyndisp/DispatchStub.h>
+
+namespace torch_ipex {
+namespace cpu {
+
+at::Tensor cast_to_fp8(
+    at::Tensor& input,
+    at::Tensor& scale,
+    at::Tensor& amax_history,
+    at::Tensor& scale_inv,
+    int64_t fp8_tensor_index,
+    int64_t otype);
+
+std::tuple<at::Tensor, at::Tensor> cast_transpose_to_fp8(
+    at::Tensor& input,
+    at::Tensor& scale,
+    at::Tensor& amax_history,
+    at::Tensor& scale_inv,
+    int64_t fp8_tensor_index,
+    int64_t otype);
+
+at::Tensor cast_from_fp8(
+    at::Tensor input,
+    at::Tensor& scale_inv,
+    int64_t fp8_tensor_index,
+    int64_t itype,
+    at::ScalarType otype);
+
+void fp8_amax_and_scale_update(
+    at::Tensor& amax_history,
+    at::Tensor& scale,
+    at::Tensor& scale_inv,
+    double fp8_max,
+    int64_t margin,
+    c10::string_view amax_compute_algo);
+
+namespace {
+
+float fp8_quantize_kernel_impl(
+    const at::Tensor& input,
+    float scale,
+    at::Tensor& output);
+
+float fp8_cast_transpose_kernel_impl(
+    const at::Tensor& input,
+    float scale,
+    at::Tensor& output,
+    at::Tensor& output_t);
+
+void fp8_dequantize_kernel_impl(
+    const at::Tensor& input,
+    float scale_inv,
+    at::Tensor& output);
+} // namespace
+
+// Quantize input * scale to the fp8 dtype of output with saturation, returns
+// the amax of the input.
+using fp8_quantize_kernel_fn = float (*)(const at::Tensor&, float, at::Tensor&);
+// Same as fp8_quantize_kernel_fn for a 2D input, output_t additionally gets
+// the transpose of the quantized output.
+using fp8_cast_transpose_kernel_fn =
+    float (*)(const at::Tensor&, float, at::Tensor&, at::Tensor&);
+using fp8_dequantize_kernel_fn =
+    void (*)(const at::Tensor&, float, at::Tensor&);
+
+IPEX_DECLARE_DISPATCH(fp8_quantize_kernel_fn, fp8_quantize_kernel_stub);
+IPEX_DECLARE_DISPATCH(
+    fp8_cast_transpose_kernel_fn,
+    fp8_cast_transpose_kernel_stub);
+IPEX_DECLARE_DISPATCH(fp8_dequantize_kernel_fn, fp8_dequantize_kernel_stub);
+
+} // namespace cpu
+} // namespace torch_ipex
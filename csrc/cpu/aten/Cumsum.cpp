@@ -11,24 +11,32 @@ namespace torch_ipex {
 namespace cpu {
 
 IPEX_DEFINE_DISPATCH(cumsum_kernel_stub);
+IPEX_DEFINE_DISPATCH(cumprod_kernel_stub);
+IPEX_DEFINE_DISPATCH(logcumsumexp_kernel_stub);
 
 at::Tensor cumsum(
     const at::Tensor& self,
     int64_t dim,
-    c10::optional<at::ScalarType> dtype) {
+    c10::optional<at::ScalarType> dtype,
+    bool exclusive,
+    bool reverse) {
   auto casted_self = at::native::integer_upcast(self, dtype);
   at::Tensor result = at::empty_like(casted_self, at::MemoryFormat::Contiguous);
 
-  // pointer to cumsum_kernel_impl(result, casted_self, dim, dtype);
-  return cumsum_kernel_stub(kCPU, result, casted_self, dim, dtype);
+  // pointer to cumsum_kernel_impl(result, casted_self, dim, dtype, exclusive,
+  // reverse);
+  return cumsum_kernel_stub(
+      kCPU, result, casted_self, dim, dtype, exclusive, reverse);
 }
 
 at::Tensor& cumsum_(
     at::Tensor& self,
     int64_t dim,
-    c10::optional<at::ScalarType> dtype) {
-  // pointer to cumsum_kernel_impl(self, self, dim, dtype);
-  cumsum_kernel_stub(kCPU, self, self, dim, dtype);
+    c10::optional<at::ScalarType> dtype,
+    bool exclusive,
+    bool reverse) {
+  // pointer to cumsum_kernel_impl(self, self, dim, dtype, exclusive, reverse);
+  cumsum_kernel_stub(kCPU, self, self, dim, dtype, exclusive, reverse);
 
   return self;
 }
@@ -37,29 +45,76 @@ at::Tensor& cumsum_out(
     const at::Tensor& self,
     int64_t dim,
     c10::optional<at::ScalarType> dtype,
+    bool exclusive,
+    bool reverse,
     at::Tensor& result) {
-  // cumsum_kernel_impl(result, self.toType(result.scalar_type()), dim, dtype);
+  // cumsum_kernel_impl(result, self.toType(result.scalar_type()), dim, dtype,
+  // exclusive, reverse);
   cumsum_kernel_stub(
-      kCPU, result, self.toType(result.scalar_type()), dim, dtype);
+      kCPU,
+      result,
+      self.toType(result.scalar_type()),
+      dim,
+      dtype,
+      exclusive,
+      reverse);
 
   return result;
 }
 
+at::Tensor cumprod(
+    const at::Tensor& self,
+    int64_t dim,
+    c10::optional<at::ScalarType> dtype,
+    bool exclusive,
+    bool reverse) {
+  auto casted_self = at::native::integer_upcast(self, dtype);
+  at::Tensor result = at::empty_like(casted_self, at::MemoryFormat::Contiguous);
+
+  // pointer to cumprod_kernel_impl(result, casted_self, dim, dtype, exclusive,
+  // reverse);
+  return cumprod_kernel_stub(
+      kCPU, result, casted_self, dim, dtype, exclusive, reverse);
+}
+
+at::Tensor logcumsumexp(
+    const at::Tensor& self,
+    int64_t dim,
+    bool exclusive,
+    bool reverse) {
+  at::Tensor result = at::empty_like(self, at::MemoryFormat::Contiguous);
+
+  // pointer to logcumsumexp_kernel_impl(result, self, dim, exclusive,
+  // reverse);
+  return logcumsumexp_kernel_stub(kCPU, result, self, dim, exclusive, reverse);
+}
+
 } // namespace cpu
 
 namespace {
 
 TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
-  m.def("cumsum(Tensor self, int dim, *, ScalarType? dtype=None) -> Tensor");
+  m.def(
+      "cumsum(Tensor self, int dim, *, ScalarType? dtype=None, "
+      "bool exclusive=False, bool reverse=False) -> Tensor");
   m.impl("cumsum", c10::DispatchKey::CPU, torch_ipex::cpu::cumsum);
   m.def(
-      "cumsum_(Tensor(a!) self, int dim, *, ScalarType? dtype=None) -> "
-      "Tensor(a!)");
+      "cumsum_(Tensor(a!) self, int dim, *, ScalarType? dtype=None, "
+      "bool exclusive=False, bool reverse=False) -> Tensor(a!)");
   m.impl("cumsum_", c10::DispatchKey::CPU, torch_ipex::cpu::cumsum_);
   m.def(
       "cumsum.out(Tensor self, int dim, *, ScalarType? dtype=None, "
-      "Tensor(a!) out) -> Tensor(a!)");
+      "bool exclusive=False, bool reverse=False, Tensor(a!) out) -> "
+      "Tensor(a!)");
   m.impl("cumsum.out", c10::DispatchKey::CPU, torch_ipex::cpu::cumsum_out);
+  m.def(
+      "cumprod(Tensor self, int dim, *, ScalarType? dtype=None, "
+      "bool exclusive=False, bool reverse=False) -> Tensor");
+  m.impl("cumprod", c10::DispatchKey::CPU, torch_ipex::cpu::cumprod);
+  m.def(
+      "logcumsumexp(Tensor self, int dim, *, bool exclusive=False, "
+      "bool reverse=False) -> Tensor");
+  m.impl("logcumsumexp", c10::DispatchKey::CPU, torch_ipex::cpu::logcumsumexp);
 }
 
 } // namespace
@@ -11,16 +11,46 @@ at::Tensor cumsum_kernel_impl(
     at::Tensor& result,
     const at::Tensor& self,
     int64_t dim,
-    c10::optional<at::ScalarType> dtype);
+    c10::optional<at::ScalarType> dtype,
+    bool exclusive,
+    bool reverse);
 
-}
+at::Tensor cumprod_kernel_impl(
+    at::Tensor& result,
+    const at::Tensor& self,
+    int64_t dim,
+    c10::optional<at::ScalarType> dtype,
+    bool exclusive,
+    bool reverse);
+
+at::Tensor logcumsumexp_kernel_impl(
+    at::Tensor& result,
+    const at::Tensor& self,
+    int64_t dim,
+    bool exclusive,
+    bool reverse);
+
+} // namespace
 
+// The scans run along any dim. `exclusive` leaves out the element itself,
+// i.e. result[0] is the identity, and `reverse` scans from the end of the dim.
 using cumsum_kernel_fn = at::Tensor (*)(
     at::Tensor&,
     const at::Tensor&,
     int64_t,
-    c10::optional<at::ScalarType>);
+    c10::optional<at::ScalarType>,
+    bool,
+    bool);
 IPEX_DECLARE_DISPATCH(cumsum_kernel_fn, cumsum_kernel_stub);
+IPEX_DECLARE_DISPATCH(cumsum_kernel_fn, cumprod_kernel_stub);
+
+using logcumsumexp_kernel_fn = at::Tensor (*)(
+    at::Tensor&,
+    const at::Tensor&,
+    int64_t,
+    bool,
+    bool);
+IPEX_DECLARE_DISPATCH(logcumsumexp_kernel_fn, logcumsumexp_kernel_stub);
 
 } // namespace cpu
 } // namespace torch_ipex
@@ -1,69 +1,58 @@
 #include "csrc/utils/CustomOperatorRegistration.h"
 #include "fp8_utils.h"
 #include "ideep/IDeepConversions.h"
+#include "utils/onednn_utils.h"
 
 namespace torch_ipex {
 namespace cpu {
 
 using namespace torch_ipex::cpu;
-at::Tensor fp8_linear_impl(
-    at::Tensor inp_fp8,
-    at::Tensor scale_invA,
-    int64_t idxA,
-    at::Tensor weight_fp8,
-    at::Tensor bias,
-    at::Tensor scale_invB,
-    int64_t idxB,
+
+// out[M, N] = (src[M, K] * src_scale) x (weight[K, N] * weight_scale) + bias,
+// with src and weight in fp8. oneDNN matmul is used if the platform supports
+// fp8 primitives, otherwise the GEMM is emulated in fp32 from the dequantized
+// operands so that the fp8 recipe can be validated functionally.
+void fp8_matmul(
+    const at::Tensor& src,
+    float src_scale,
+    const at::Tensor& weight,
+    float weight_scale,
+    const at::Tensor& bias,
     at::Tensor& out) {
-  RECORD_FUNCTION("fp8_linear_impl", c10::ArrayRef<c10::IValue>({}));
+  int64_t M = src.size(0), K = src.size(1), N = weight.size(1);
+  TORCH_CHECK(
+      weight.size(0) == K && out.size(0) == M && out.size(1) == N,
+      "fp8_matmul: unexpected shapes of the operands");
+  bool with_bias = bias.defined();
 
-  const int64_t dim = inp_fp8.dim();
-  // reshape first if input dim != 2 and the reshape will cost a memory copy.
-  auto inp_fp8_reshaped = dim == 2
-      ? inp_fp8
-      : inp_fp8.reshape({-1, inp_fp8.size(inp_fp8.dim() - 1)});
-  at::Tensor out_reshaped;
-  std::vector<int64_t> out_sizes;
-  if (out.defined()) {
-    out_reshaped = out;
-    out_sizes = out.sizes().vec();
-  } else {
-    out_sizes = inp_fp8.sizes().vec();
-    out_sizes[1] = weight_fp8.size(0);
-    out_reshaped =
-        at::empty(out_sizes, device(c10::kCPU).dtype(c10::ScalarType::Float));
+  if (!torch_ipex::utils::onednn_has_fp8_type_support()) {
+    auto res = at::mm(src.to(at::kFloat), weight.to(at::kFloat))
+                   .mul_(src_scale * weight_scale);
+    if (with_bias) {
+      res.add_(bias.to(at::kFloat));
+    }
+    out.copy_(res);
+    return;
   }
 
-  float input_scale = scale_invA[idxA].item<float>();
-  float weight_scale = scale_invB[idxB].item<float>();
-  auto weight_fp8_t = weight_fp8.transpose(0, 1).contiguous();
-  auto src = torch_ipex::cpu::itensor_view_from_dense(inp_fp8_reshaped);
-  auto weight_t = torch_ipex::cpu::itensor_view_from_dense(weight_fp8_t);
-  bool with_bias = bias.defined();
-  int64_t K = inp_fp8_reshaped.size(-1), M = inp_fp8_reshaped.numel() / K,
-          N = weight_fp8_t.size(1);
+  auto src_ = src.contiguous();
+  auto weight_ = weight.contiguous();
+  auto onednn_src = torch_ipex::cpu::itensor_view_from_dense(src_);
+  auto onednn_weight = torch_ipex::cpu::itensor_view_from_dense(weight_);
+  ideep::tensor dst = torch_ipex::cpu::itensor_view_from_dense(out);
 
   std::vector<int64_t> src_dims = {M, K};
   std::vector<int64_t> weight_dims = {K, N};
   std::vector<int64_t> dst_dims = {M, N};
-  assert(out_reshaped.size(0) == M);
-  assert(out_reshaped.size(1) == N);
-
-  ideep::tensor dst = torch_ipex::cpu::itensor_view_from_dense(out_reshaped);
   auto src_desc = ideep::tensor::desc(
-      src_dims,
-      get_mkldnn_dtype(inp_fp8.scalar_type()),
-      ideep::format_tag::any);
+      src_dims, get_mkldnn_dtype(src.scalar_type()), ideep::format_tag::any);
   auto weights_desc = ideep::tensor::desc(
       weight_dims,
-      get_mkldnn_dtype(weight_fp8.scalar_type()),
+      get_mkldnn_dtype(weight.scalar_type()),
       ideep::format_tag::any);
   auto dst_desc = ideep::tensor::desc(
-      dst_dims,
-      get_mkldnn_dtype(out_reshaped.scalar_type()),
-      ideep::format_tag::any);
+      dst_dims, get_mkldnn_dtype(out.scalar_type()), ideep::format_tag::any);
   ideep::tensor onednn_bias;
-  at::Tensor bias_val_float;
   if (with_bias) {
     if (bias.dim() == 1) {
       auto b_reshape = bias.reshape({1, bias.size(0)});
@@ -78,10 +67,10 @@ at::Tensor fp8_linear_impl(
                                    ideep::format_tag::any)
                              : ideep::tensor::desc();
   auto op_attr = ideep::attr_t();
-  if (input_scale != 1.0f) {
+  if (src_scale != 1.0f) {
     op_attr.set_scales_mask(DNNL_ARG_SRC, 0);
   }
-  if (input_scale != 1.0f) {
+  if (weight_scale != 1.0f) {
     op_attr.set_scales_mask(DNNL_ARG_WEIGHTS, 0);
   }
 
@@ -107,22 +96,63 @@ at::Tensor fp8_linear_impl(
   // Prepare args and execute primitive
   ideep::tensor scratchpad(primitive_desc.scratchpad_desc());
   ideep::exec_args args;
-  args.insert({DNNL_ARG_SRC, src});
-  args.insert({DNNL_ARG_WEIGHTS, weight_t});
+  args.insert({DNNL_ARG_SRC, onednn_src});
+  args.insert({DNNL_ARG_WEIGHTS, onednn_weight});
   args.insert({DNNL_ARG_DST, dst});
   args.insert({DNNL_ARG_SCRATCHPAD, scratchpad});
   if (with_bias) {
     args.insert({DNNL_ARG_BIAS, onednn_bias});
   }
-  ideep::tensor src_scales_t = ideep::tensor(ideep::scale_t(1, input_scale));
+  ideep::tensor src_scales_t = ideep::tensor(ideep::scale_t(1, src_scale));
   ideep::tensor wei_scales_t = ideep::tensor(ideep::scale_t(1, weight_scale));
 
-  if (input_scale != 1.0f) {
+  if (src_scale != 1.0f) {
     args.insert({DNNL_ARG_ATTR_SCALES | DNNL_ARG_SRC, src_scales_t});
   }
-  args.insert({DNNL_ARG_ATTR_SCALES | DNNL_ARG_WEIGHTS, wei_scales_t});
+  if (weight_scale != 1.0f) {
+    args.insert({DNNL_ARG_ATTR_SCALES | DNNL_ARG_WEIGHTS, wei_scales_t});
+  }
 
   primitive.execute(ideep::stream::default_stream(), args);
+}
+
+at::Tensor fp8_linear_impl(
+    at::Tensor inp_fp8,
+    at::Tensor scale_invA,
+    int64_t idxA,
+    at::Tensor weight_fp8,
+    at::Tensor bias,
+    at::Tensor scale_invB,
+    int64_t idxB,
+    at::Tensor& out) {
+  RECORD_FUNCTION("fp8_linear_impl", c10::ArrayRef<c10::IValue>({}));
+
+  const int64_t dim = inp_fp8.dim();
+  // reshape first if input dim != 2 and the reshape will cost a memory copy.
+  auto inp_fp8_reshaped = dim == 2
+      ? inp_fp8
+      : inp_fp8.reshape({-1, inp_fp8.size(inp_fp8.dim() - 1)});
+  at::Tensor out_reshaped;
+  std::vector<int64_t> out_sizes;
+  if (out.defined()) {
+    out_reshaped = out;
+    out_sizes = out.sizes().vec();
+  } else {
+    out_sizes = inp_fp8.sizes().vec();
+    out_sizes[1] = weight_fp8.size(0);
+    out_reshaped =
+        at::empty(out_sizes, device(c10::kCPU).dtype(c10::ScalarType::Float));
+  }
+
+  float input_scale = scale_invA[idxA].item<float>();
+  float weight_scale = scale_invB[idxB].item<float>();
+  fp8_matmul(
+      inp_fp8_reshaped,
+      input_scale,
+      weight_fp8.transpose(0, 1),
+      weight_scale,
+      bias,
+      out_reshaped);
 
   if (dim != 2) {
     out_reshaped.reshape(out_sizes);
@@ -146,6 +176,60 @@ at::Tensor fp8_linear(
   return res;
 }
 
+// Backward of fp8_linear. grad_output is quantized to fp8 together with its
+// transpose (see cast_transpose_to_fp8), so that neither GEMM needs to
+// reorder an operand:
+//   dgrad[M, K] = grad_output[M, N] x weight[N, K]
+//   wgrad[N, K] = grad_output_t[N, M] x input[M, K]
+std::tuple<at::Tensor, at::Tensor> fp8_linear_backward(
+    at::Tensor grad_output_fp8,
+    at::Tensor grad_output_t_fp8,
+    at::Tensor scale_inv_bwd,
+    int64_t grad_output_idx,
+    at::Tensor weight_fp8,
+    at::Tensor input_fp8,
+    at::Tensor scale_inv_fwd,
+    int64_t weight_idx,
+    int64_t input_idx,
+    at::ScalarType out_dtype,
+    std::array<bool, 2> output_mask) {
+  RECORD_FUNCTION("fp8_linear_backward", c10::ArrayRef<c10::IValue>({}));
+
+  TORCH_CHECK(
+      grad_output_fp8.dim() == 2 && grad_output_t_fp8.dim() == 2 &&
+          weight_fp8.dim() == 2 && input_fp8.dim() == 2,
+      "fp8_linear_backward: expect 2D grad_output, weight and input");
+  float grad_output_scale = scale_inv_bwd[grad_output_idx].item<float>();
+  at::Tensor dgrad, wgrad;
+  if (output_mask[0]) {
+    float weight_scale = scale_inv_fwd[weight_idx].item<float>();
+    dgrad = at::empty(
+        {grad_output_fp8.size(0), weight_fp8.size(1)},
+        grad_output_fp8.options().dtype(out_dtype));
+    fp8_matmul(
+        grad_output_fp8,
+        grad_output_scale,
+        weight_fp8,
+        weight_scale,
+        at::Tensor(),
+        dgrad);
+  }
+  if (output_mask[1]) {
+    float input_scale = scale_inv_fwd[input_idx].item<float>();
+    wgrad = at::empty(
+        {grad_output_t_fp8.size(0), input_fp8.size(1)},
+        input_fp8.options().dtype(out_dtype));
+    fp8_matmul(
+        grad_output_t_fp8,
+        grad_output_scale,
+        input_fp8,
+        input_scale,
+        at::Tensor(),
+        wgrad);
+  }
+  return std::make_tuple(dgrad, wgrad);
+}
+
 } // namespace cpu
 } // namespace torch_ipex
 
@@ -154,6 +238,10 @@ namespace {
 IPEX_LIBRARY_FRAGMENT() {
   IPEX_OP_IPEX_REGISTER_DISPATCH(
       "fp8_linear", torch_ipex::cpu::fp8_linear, c10::DispatchKey::CPU);
+  IPEX_OP_IPEX_REGISTER_DISPATCH(
+      "fp8_linear_backward",
+      torch_ipex::cpu::fp8_linear_backward,
+      c10::DispatchKey::CPU);
 }
 
 } // namespace
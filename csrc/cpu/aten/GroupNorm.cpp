@@ -22,6 +22,7 @@ namespace cpu {
 
 IPEX_DEFINE_DISPATCH(GroupNormKernel);
 IPEX_DEFINE_DISPATCH(GroupNormBackwardKernel);
+IPEX_DEFINE_DISPATCH(GroupNormActKernel);
 
 void check_group_norm_inputs(
     const at::Tensor& input,
@@ -235,6 +236,113 @@ at::Tensor group_norm(
       at::native_group_norm(X, gamma, beta, N, C, HxW, num_groups, eps));
 }
 
+at::Tensor group_norm_act(
+    const at::Tensor& input,
+    int64_t num_groups,
+    const c10::optional<at::Tensor>& weight_opt,
+    const c10::optional<at::Tensor>& bias_opt,
+    double eps,
+    c10::string_view activation,
+    c10::string_view approximate,
+    const c10::optional<at::Tensor>& residual_opt,
+    double output_scale) {
+#if defined(IPEX_DISP_OP)
+  printf("torch_ipex::group_norm_act\n");
+#endif
+  RECORD_FUNCTION("torch_ipex::group_norm_act", c10::ArrayRef<c10::IValue>({}));
+
+  GroupNormPostOp post_op;
+  if (activation == "silu") {
+    post_op.activation = GroupNormActivation::SiLU;
+  } else if (activation == "gelu") {
+    TORCH_CHECK(
+        approximate == "none" || approximate == "tanh",
+        "group_norm_act: unsupported gelu approximate ",
+        approximate);
+    post_op.activation = approximate == "tanh" ? GroupNormActivation::GELUTanh
+                                               : GroupNormActivation::GELU;
+  } else {
+    TORCH_CHECK(
+        activation == "none",
+        "group_norm_act: unsupported activation ",
+        activation);
+  }
+  post_op.output_scale = output_scale;
+
+  c10::MaybeOwned<at::Tensor> weight_maybe_owned =
+      at::borrow_from_optional_tensor(weight_opt);
+  const at::Tensor& weight = *weight_maybe_owned;
+  const at::Tensor& bias =
+      c10::value_or_else(bias_opt, [] { return at::Tensor(); });
+
+  const int64_t N = input.size(0);
+  const int64_t C = input.size(1);
+  check_group_norm_inputs(input, weight, bias, C, num_groups);
+
+  const auto input_shape = input.sizes();
+  const int64_t HxW =
+      c10::multiply_integers(input_shape.cbegin() + 2, input_shape.cend());
+
+  const at::Tensor kEmpty;
+  auto memory_format = input.suggest_memory_format();
+  const auto& X =
+      is_channels_last_1d(input) ? input : input.contiguous(memory_format);
+  const auto& gamma = weight.defined()
+      ? (is_channels_last_1d(weight) ? weight : weight.contiguous())
+      : kEmpty;
+  const auto& beta = bias.defined()
+      ? (is_channels_last_1d(bias) ? bias : bias.contiguous())
+      : kEmpty;
+
+  bool mixed_type = at::native::is_mixed_type(X, gamma, beta);
+  if (mixed_type) {
+    at::native::check_mixed_data_type(X, gamma, beta);
+  }
+
+  at::Tensor Y;
+  if (is_channels_last_1d(X)) {
+    Y = at::native::empty_like(X);
+  } else {
+    Y = at::native::empty_like(
+        X,
+        c10::nullopt /* dtype */,
+        c10::nullopt /* layout */,
+        c10::nullopt /* device */,
+        c10::nullopt /* pin_memory */,
+        memory_format);
+  }
+  if (residual_opt.has_value() && residual_opt.value().defined()) {
+    const auto& residual = residual_opt.value();
+    TORCH_CHECK(
+        residual.sizes() == X.sizes() &&
+            residual.scalar_type() == X.scalar_type(),
+        "group_norm_act: expect residual of the same sizes and dtype as input");
+    // the residual is read with the same offsets as Y
+    post_op.residual = residual.strides() == Y.strides()
+        ? residual
+        : at::empty_like(Y).copy_(residual);
+  }
+
+  const auto dtype = at::native::param_scalar_type(X, mixed_type);
+  at::Tensor mean = at::empty({N, num_groups}, X.options().dtype(dtype));
+  at::Tensor rstd = at::empty({N, num_groups}, X.options().dtype(dtype));
+  GroupNormActKernel(
+      X.device().type(),
+      X,
+      gamma,
+      beta,
+      N,
+      C,
+      HxW,
+      num_groups,
+      eps,
+      post_op,
+      Y,
+      mean,
+      rstd);
+  return Y;
+}
+
 IPEX_TORCH_LIBRARY_IMPL(aten, CPU, m) {
   m.impl(
       TORCH_SELECTIVE_NAME("aten::group_norm"),
@@ -249,3 +357,19 @@ IPEX_TORCH_LIBRARY_IMPL(aten, CPU, m) {
 
 } // namespace cpu
 } // namespace torch_ipex
+
+namespace {
+
+TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
+  m.def(
+      "group_norm_act(Tensor input, int num_groups, Tensor? weight, "
+      "Tensor? bias, float eps, str activation=\"silu\", "
+      "str approximate=\"none\", Tensor? residual=None, "
+      "float output_scale=1.0) -> Tensor");
+  m.impl(
+      "group_norm_act",
+      c10::DispatchKey::CPU,
+      torch_ipex::cpu::group_norm_act);
+}
+
+} // namespace
@@ -35,8 +35,55 @@ using backward_fn = void (*)(
     at::Tensor& /* dgamma */,
     at::Tensor& /* dbeta */);
 
+// Elementwise post ops fused into the GroupNorm forward:
+//   Y = (activation(GroupNorm(X)) + residual) * output_scale
+// They are applied right after each chunk of Y is normalized, while the chunk
+// is still in cache.
+enum class GroupNormActivation : int {
+  None = 0,
+  SiLU = 1,
+  GELU = 2,
+  GELUTanh = 3,
+};
+
+struct GroupNormPostOp {
+  GroupNormActivation activation = GroupNormActivation::None;
+  // optional, same sizes, dtype and memory format as Y
+  at::Tensor residual;
+  double output_scale = 1.0;
+};
+
+using forward_act_fn = void (*)(
+    const at::Tensor& /* X */,
+    const at::Tensor& /* gamma */,
+    const at::Tensor& /* beta */,
+    int64_t /* N */,
+    int64_t /* C */,
+    int64_t /* HxW */,
+    int64_t /* group */,
+    double /* eps */,
+    const GroupNormPostOp& /* post_op */,
+    at::Tensor& /* Y */,
+    at::Tensor& /* mean */,
+    at::Tensor& /* rstd */);
+
 IPEX_DECLARE_DISPATCH(forward_fn, GroupNormKernel);
 IPEX_DECLARE_DISPATCH(backward_fn, GroupNormBackwardKernel);
+IPEX_DECLARE_DISPATCH(forward_act_fn, GroupNormActKernel);
+
+// GroupNorm followed by SiLU or GELU (approximate is "none" or "tanh" as in
+// aten::gelu), an optional residual add and output scaling, e.g. the
+// norm + nonlinearity of the ResNet blocks of diffusion UNets.
+at::Tensor group_norm_act(
+    const at::Tensor& input,
+    int64_t num_groups,
+    const c10::optional<at::Tensor>& weight_opt,
+    const c10::optional<at::Tensor>& bias_opt,
+    double eps,
+    c10::string_view activation,
+    c10::string_view approximate,
+    const c10::optional<at::Tensor>& residual_opt,
+    double output_scale);
 
 } // namespace cpu
 } // namespace torch_ipex
\ No newline at end of file
@@ -0,0 +1,17 @@
+#include "InvertedResidual.h"
+
+namespace torch_ipex {
+namespace cpu {
+
+IPEX_DEFINE_DISPATCH(inverted_residual_kernel_stub);
+at::Tensor inverted_residual(
+    const at::Tensor& input,
+    const InvertedResidualParams& params) {
+  /*
+  pointer to inverted_residual_kernel_impl(input, params);
+  */
+  return inverted_residual_kernel_stub(kCPU, input, params);
+}
+
+} // namespace cpu
+} // namespace torch_ipex
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <dyndisp/DispatchStub.h>
+
+#include <array>
+
+namespace torch_ipex {
+namespace cpu {
+
+// Elementwise post op of a convolution inside a fused block, with the oneDNN
+// eltwise semantics of alpha and beta:
+//   ReLU:      x > 0 ? x : alpha * x
+//   Clip:      min(max(x, alpha), beta)
+//   Swish:     x * sigmoid(alpha * x)
+//   HardSwish: x * min(max(alpha * x + beta, 0), 1)
+enum class BlockEltwise : int {
+  None = 0,
+  ReLU = 1,
+  Clip = 2,
+  Swish = 3,
+  HardSwish = 4,
+};
+
+struct BlockActivation {
+  BlockEltwise kind = BlockEltwise::None;
+  float alpha = 0.f;
+  float beta = 0.f;
+};
+
+// Output channels of the block weights are zero padded to a multiple of it,
+// so that the kernels never need a masked load.
+constexpr int64_t kBlockChannelAlign = 16;
+
+// MobileNet/EfficientNet inverted residual block on a 4D channels last input
+//   expand 1x1 conv -> depthwise kxk conv -> project 1x1 conv (+ residual)
+// All weights and biases are fp32 and already in the layout of the kernel,
+// with hidden_pad/out_pad the padded hidden_channels/out_channels:
+//   expand_weight:  [in_channels, hidden_pad], expand_bias: [hidden_pad]
+//   dw_weight:      [kh, kw, hidden_pad], dw_bias: [hidden_pad]
+//   project_weight: [hidden_channels, out_pad], project_bias: [out_pad]
+struct InvertedResidualParams {
+  int64_t hidden_channels;
+  int64_t out_channels;
+  at::Tensor expand_weight;
+  at::Tensor expand_bias;
+  BlockActivation expand_act;
+  at::Tensor dw_weight;
+  at::Tensor dw_bias;
+  std::array<int64_t, 2> dw_stride;
+  std::array<int64_t, 2> dw_padding;
+  std::array<int64_t, 2> dw_dilation;
+  BlockActivation dw_act;
+  at::Tensor project_weight;
+  at::Tensor project_bias;
+  BlockActivation project_act;
+  // output = project_act(project(...)) + residual_alpha * input
+  bool residual = false;
+  float residual_alpha = 1.f;
+};
+
+at::Tensor inverted_residual(
+    const at::Tensor& input,
+    const InvertedResidualParams& params);
+
+namespace {
+
+at::Tensor inverted_residual_kernel_impl(
+    const at::Tensor& input,
+    const InvertedResidualParams& params);
+
+} // namespace
+
+// The three convolutions are computed per tile of output rows, the expanded
+// and depthwise activations of a tile only live in a per thread buffer sized
+// to stay in L2, so they are never written to memory at full size.
+using inverted_residual_kernel_fn =
+    at::Tensor (*)(const at::Tensor&, const InvertedResidualParams&);
+IPEX_DECLARE_DISPATCH(
+    inverted_residual_kernel_fn,
+    inverted_residual_kernel_stub);
+
+} // namespace cpu
+} // namespace torch_ipex
@@ -6,6 +6,7 @@
 #include "WeightPack.h"
 #include "autocast/autocast_mode.h"
 #include "ideep/IDeepConversions.h"
+#include "utils/kernel_counters.h"
 
 namespace torch_ipex {
 namespace cpu {
@@ -420,6 +421,41 @@ at::Tensor woq_linear_unpack_weight(
 }
 
 IPEX_DEFINE_DISPATCH(woq_tpp_gemm_kernel_stub);
+
+// Minimum traffic of one WoQ GEMM for the roofline counters. Only one of the
+// fp32/fp16/bf16 copies of the scales, zero points and bias is read.
+static utils::KernelTraffic woq_linear_traffic(
+    const at::Tensor& self,
+    const at::Tensor& weight,
+    const std::vector<at::Tensor>& scales_list,
+    const std::vector<at::Tensor>& zps_list,
+    const std::vector<at::Tensor>& bias_list,
+    const std::vector<at::Tensor>& others,
+    bool is_int4) {
+  auto first_bytes = [](const std::vector<at::Tensor>& list) -> int64_t {
+    for (auto& t : list) {
+      if (t.defined()) {
+        return utils::kernel_tensor_bytes(t);
+      }
+    }
+    return 0;
+  };
+  auto K = self.size(-1);
+  auto M = self.numel() / K;
+  auto N = weight.size(0);
+  if (weight.dim() == 4) {
+    N = weight.size(0) * weight.size(3) * (is_int4 ? 2 : 1);
+  }
+  utils::KernelTraffic traffic;
+  traffic.weight_bytes = utils::kernel_tensor_bytes(weight) +
+      first_bytes(scales_list) + first_bytes(zps_list);
+  traffic.activation_bytes = utils::kernel_tensor_bytes(self) +
+      first_bytes(bias_list) + utils::kernel_tensor_bytes(others) +
+      M * N * self.element_size();
+  traffic.flops = 2 * M * N * K;
+  return traffic;
+}
+
 at::Tensor woq_linear_kernel(
     const at::Tensor& self,
     const at::Tensor& weight,
@@ -433,6 +469,11 @@ at::Tensor woq_linear_kernel(
     int64_t act_quant_mode) {
   int w_dtype = is_int4 ? WOQ_DTYPE_QINT4 : WOQ_DTYPE_QINT8;
   int64_t quant_w_mode = group_size > 0 ? 1 : 0;
+  utils::KernelCounterScope counter(utils::KernelCounterKind::WoqLinear);
+  if (counter.enabled()) {
+    counter.start(woq_linear_traffic(
+        self, weight, scales_list, zps_list, bias_list, {}, is_int4));
+  }
   return woq_tpp_gemm_kernel_stub(
       kCPU,
       self,
@@ -484,6 +525,11 @@ at::Tensor woq_linear_eltwise_kernel(
     }
   }
   int64_t quant_w_mode = group_size > 0 ? 1 : 0;
+  utils::KernelCounterScope counter(utils::KernelCounterKind::WoqLinear);
+  if (counter.enabled()) {
+    counter.start(woq_linear_traffic(
+        self, weight, scales_list, zps_list, bias_list, {}, is_int4));
+  }
   return woq_tpp_gemm_kernel_stub(
       kCPU,
       self,
@@ -537,6 +583,11 @@ at::Tensor woq_linear_add_kernel(
     int64_t act_quant_mode) {
   int w_dtype = is_int4 ? WOQ_DTYPE_QINT4 : WOQ_DTYPE_QINT8;
   int64_t quant_w_mode = group_size > 0 ? 1 : 0;
+  utils::KernelCounterScope counter(utils::KernelCounterKind::WoqLinear);
+  if (counter.enabled()) {
+    counter.start(woq_linear_traffic(
+        self, weight, scales_list, zps_list, bias_list, others, is_int4));
+  }
   return woq_tpp_gemm_kernel_stub(
       kCPU,
       self,
@@ -568,6 +619,11 @@ at::Tensor woq_linear_add_add_kernel(
     int64_t act_quant_mode) {
   int w_dtype = is_int4 ? WOQ_DTYPE_QINT4 : WOQ_DTYPE_QINT8;
   int64_t quant_w_mode = group_size > 0 ? 1 : 0;
+  utils::KernelCounterScope counter(utils::KernelCounterKind::WoqLinear);
+  if (counter.enabled()) {
+    counter.start(woq_linear_traffic(
+        self, weight, scales_list, zps_list, bias_list, others, is_int4));
+  }
   return woq_tpp_gemm_kernel_stub(
       kCPU,
       self,
@@ -21,6 +21,43 @@ IPEX_DEFINE_DISPATCH(mkl_prepack_sgemm_kernel_stub);
  *@param output Output tensor provided by user.
  */
 
+detail::MklSgemmJitKernel mkl_sgemm_jit_create(
+    const int64_t M,
+    const int64_t N,
+    const int64_t K,
+    float beta) {
+  detail::MklSgemmJitKernel jit_kernel;
+  void* jitter = nullptr;
+  auto status = mkl_jit_create_sgemm(
+      &jitter,
+      MKL_ROW_MAJOR,
+      MKL_NOTRANS,
+      MKL_TRANS,
+      M,
+      N,
+      K,
+      1.0f,
+      K,
+      K,
+      beta,
+      N);
+  if (status != MKL_JIT_SUCCESS) {
+    // MKL_NO_JIT: the jitter would only call the standard sgemm, which is what
+    // the cblas_sgemm path does already
+    if (jitter != nullptr) {
+      mkl_jit_destroy(jitter);
+    }
+    return jit_kernel;
+  }
+  jit_kernel.jitter = std::shared_ptr<void>(jitter, mkl_jit_destroy);
+  jit_kernel.kernel = mkl_jit_get_sgemm_ptr(jitter);
+  jit_kernel.M = M;
+  jit_kernel.N = N;
+  jit_kernel.K = K;
+  jit_kernel.beta = beta;
+  return jit_kernel;
+}
+
 at::Tensor mkl_sgemm_pack_weight(
     const int64_t M,
     const int64_t N,
@@ -33,20 +70,22 @@ void mkl_sgemm_kernel_output(
     const at::Tensor& self,
     const at::Tensor& ori_weight,
     const at::Tensor& bias,
-    at::Tensor& output) {
-  mkl_sgemm_kernel_stub(kCPU, self, ori_weight, bias, output);
+    at::Tensor& output,
+    const MklSgemmParams& params) {
+  mkl_sgemm_kernel_stub(kCPU, self, ori_weight, bias, output, params);
 }
 
 at::Tensor mkl_sgemm_kernel(
     const at::Tensor& self,
     const at::Tensor& ori_weight,
-    const at::Tensor& bias) {
+    const at::Tensor& bias,
+    const MklSgemmParams& params) {
   auto input_size = self.sizes();
   std::vector<int64_t> output_size(input_size.begin(), input_size.end() - 1);
   output_size.push_back(ori_weight.size(0));
   auto output = at::empty(output_size, self.options());
   output.set_requires_grad(self.requires_grad());
-  mkl_sgemm_kernel_output(self, ori_weight, bias, output);
+  mkl_sgemm_kernel_output(self, ori_weight, bias, output, params);
   return output;
 }
 
@@ -55,22 +94,25 @@ void mkl_prepack_sgemm_kernel_output(
     const at::Tensor& mkl_weight,
     const at::Tensor& bias,
     const int64_t out_features,
-    at::Tensor& output) {
+    at::Tensor& output,
+    const MklSgemmParams& params) {
   mkl_prepack_sgemm_kernel_stub(
-      kCPU, self, mkl_weight, bias, out_features, output);
+      kCPU, self, mkl_weight, bias, out_features, output, params);
 }
 
 at::Tensor mkl_prepack_sgemm_kernel(
     const at::Tensor& self,
     const at::Tensor& mkl_weight,
     const at::Tensor& bias,
-    const int64_t out_features) {
+    const int64_t out_features,
+    const MklSgemmParams& params) {
   auto input_size = self.sizes();
   std::vector<int64_t> output_size(input_size.begin(), input_size.end() - 1);
   output_size.push_back(out_features);
   auto output = at::empty(output_size, self.options());
   output.set_requires_grad(self.requires_grad());
-  mkl_prepack_sgemm_kernel_output(self, mkl_weight, bias, out_features, output);
+  mkl_prepack_sgemm_kernel_output(
+      self, mkl_weight, bias, out_features, output, params);
   return output;
 }
 
@@ -11,6 +11,29 @@
 namespace torch_ipex {
 namespace cpu {
 
+// The epilogue and threading of the MKL sgemm kernels.
+//   post_op_kinds/post_op_params: eltwise post-ops (see PostOpChain.h) applied
+//     on each output tile right after it is computed, while it is in cache.
+//   num_threads: the number of threads the M/N tiles of the output are spread
+//     over, 0 for at::get_num_threads().
+//   jit_kernel: a MKL JIT kernel used instead of cblas_sgemm when it was
+//     created for the shape of the call.
+struct MklSgemmParams {
+  c10::ArrayRef<int64_t> post_op_kinds = {};
+  c10::ArrayRef<double> post_op_params = {};
+  int64_t num_threads = 0;
+  const detail::MklSgemmJitKernel* jit_kernel = nullptr;
+};
+
+// Creates a MKL JIT kernel computing output = input * weight^T + beta * output
+// on the unpacked row-major weight, for a fixed small M/N/K. Returns an
+// undefined kernel if MKL does not JIT the shape.
+detail::MklSgemmJitKernel mkl_sgemm_jit_create(
+    const int64_t M,
+    const int64_t N,
+    const int64_t K,
+    float beta);
+
 at::Tensor mkl_sgemm_pack_weight(
     const int64_t M,
     const int64_t N,
@@ -21,25 +44,29 @@ void mkl_sgemm_kernel_output(
     const at::Tensor& self,
     const at::Tensor& ori_weight,
     const at::Tensor& bias,
-    at::Tensor& output);
+    at::Tensor& output,
+    const MklSgemmParams& params = {});
 
 at::Tensor mkl_sgemm_kernel(
     const at::Tensor& self,
     const at::Tensor& ori_weight,
-    const at::Tensor& bias);
+    const at::Tensor& bias,
+    const MklSgemmParams& params = {});
 
 void mkl_prepack_sgemm_kernel_output(
     const at::Tensor& self,
     const at::Tensor& mkl_weight,
     const at::Tensor& bias,
     const int64_t out_features,
-    at::Tensor& output);
+    at::Tensor& output,
+    const MklSgemmParams& params = {});
 
 at::Tensor mkl_prepack_sgemm_kernel(
     const at::Tensor& self,
     const at::Tensor& mkl_weight,
     const at::Tensor& bias,
-    const int64_t out_features);
+    const int64_t out_features,
+    const MklSgemmParams& params = {});
 
 at::Tensor mkl_sgemm_forward(
     const at::Tensor& input,
@@ -69,20 +96,23 @@ void mkl_sgemm_base_kernel_impl(
     const at::Tensor& bias,
     const int64_t N,
     at::Tensor& output,
-    bool pack);
+    bool pack,
+    const MklSgemmParams& params);
 
 void mkl_sgemm_kernel_impl(
     const at::Tensor& self,
     const at::Tensor& ori_weight,
     const at::Tensor& bias,
-    at::Tensor& output);
+    at::Tensor& output,
+    const MklSgemmParams& params);
 
 void mkl_prepack_sgemm_kernel_impl(
     const at::Tensor& self,
     const at::Tensor& mkl_weight,
     const at::Tensor& bias,
     const int64_t out_features,
-    at::Tensor& output);
+    at::Tensor& output,
+    const MklSgemmParams& params);
 
 } // namespace
 
@@ -95,13 +125,15 @@ using mkl_sgemm_kernel_fn = void (*)(
     const at::Tensor&,
     const at::Tensor&,
     const at::Tensor&,
-    at::Tensor&);
+    at::Tensor&,
+    const MklSgemmParams&);
 using mkl_prepack_sgemm_kernel_fn = void (*)(
     const at::Tensor&,
     const at::Tensor&,
     const at::Tensor&,
     const int64_t,
-    at::Tensor&);
+    at::Tensor&,
+    const MklSgemmParams&);
 IPEX_DECLARE_DISPATCH(mkl_sgemm_packB_fn, mkl_sgemm_packB_stub);
 IPEX_DECLARE_DISPATCH(mkl_sgemm_kernel_fn, mkl_sgemm_kernel_stub);
 IPEX_DECLARE_DISPATCH(
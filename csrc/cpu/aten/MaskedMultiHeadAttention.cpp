@@ -6,6 +6,7 @@ namespace torch_ipex {
 namespace cpu {
 
 IPEX_DEFINE_DISPATCH(masked_multihead_self_attention_kernel_stub);
+IPEX_DEFINE_DISPATCH(indirect_kv_cache_compact_kernel_stub);
 
 /*
  *Caculate the masked multihead attention for decoder layer in decoder only
@@ -22,6 +23,9 @@ IPEX_DEFINE_DISPATCH(masked_multihead_self_attention_kernel_stub);
  *@param head_mask
  *@param attention_mask
  *@param add_casual_mask
+ *@param tree_mask The int64 bitmask [(batch,) cur_len, (cur_len + 63) / 64] of
+ *the tokens following the prompt each of them attends, to verify a tree of
+ *speculative candidates in one step, see tree_attention_mask
  *@return {attn_weights, attn_outs}
  */
 std::tuple<at::Tensor, at::Tensor, at::Tensor, at::Tensor, at::Tensor>
@@ -37,7 +41,8 @@ masked_multihead_self_attention_forward_cpu(
     int64_t max_positions,
     const c10::optional<at::Tensor>& head_mask /* optional */,
     const c10::optional<at::Tensor>& attention_mask /* optional */,
-    c10::optional<bool> add_casual_mask /* optional */) {
+    c10::optional<bool> add_casual_mask /* optional */,
+    const c10::optional<at::Tensor>& tree_mask /* optional */) {
   return masked_multihead_self_attention_kernel_stub(
       kCPU,
       query,
@@ -51,7 +56,28 @@ masked_multihead_self_attention_forward_cpu(
       max_positions,
       head_mask,
       attention_mask,
-      add_casual_mask);
+      add_casual_mask,
+      tree_mask);
+}
+
+/*
+ *Keep the keys and values of the accepted path after the verification of a
+ *speculative token tree by masked_multihead_self_attention with a tree_mask.
+ *@param key_cache
+ *@param value_cache
+ *@param beam_idx
+ *@param offset The length of the tokens before the tree
+ *@param accepted The ascending indices of the accepted candidates [num] or
+ *[beam_size*batch, num], moved to the num tokens after offset
+ */
+void indirect_kv_cache_compact_forward_cpu(
+    at::Tensor& key_cache,
+    at::Tensor& value_cache,
+    at::Tensor& beam_idx,
+    int64_t offset,
+    const at::Tensor& accepted) {
+  return indirect_kv_cache_compact_kernel_stub(
+      kCPU, key_cache, value_cache, beam_idx, offset, accepted);
 }
 
 } // namespace cpu
@@ -63,10 +89,16 @@ TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
   m.def(
       "masked_multihead_self_attention(Tensor query, Tensor key, Tensor value, Tensor key_cache, \
        Tensor value_cache, Tensor beam_idx, Tensor seq_info, float scale_attn, int max_positions, \
-       Tensor? head_mask, Tensor? attention_mask, bool? add_casual_mask=None)-> (Tensor, Tensor, Tensor, Tensor, Tensor)");
+       Tensor? head_mask, Tensor? attention_mask, bool? add_casual_mask=None, Tensor? tree_mask=None)-> (Tensor, Tensor, Tensor, Tensor, Tensor)");
   m.impl(
       "masked_multihead_self_attention",
       c10::DispatchKey::CPU,
       torch_ipex::cpu::masked_multihead_self_attention_forward_cpu);
+  m.def(
+      "indirect_kv_cache_compact(Tensor(a!) key_cache, Tensor(a!) value_cache, Tensor(a!) beam_idx, int offset, Tensor accepted)-> ()");
+  m.impl(
+      "indirect_kv_cache_compact",
+      c10::DispatchKey::CPU,
+      torch_ipex::cpu::indirect_kv_cache_compact_forward_cpu);
 }
 } // namespace
@@ -21,7 +21,8 @@ masked_multihead_self_attention(
     int64_t max_positions,
     const c10::optional<at::Tensor>& head_mask /* optional */,
     const c10::optional<at::Tensor>& attention_mask /* optional */,
-    c10::optional<bool> add_casual_mask /* optional */);
+    c10::optional<bool> add_casual_mask /* optional */,
+    const c10::optional<at::Tensor>& tree_mask /* optional */);
 }
 
 using masked_multihead_self_attention_kernel_fn =
@@ -37,11 +38,22 @@ using masked_multihead_self_attention_kernel_fn =
         int64_t max_positions,
         const c10::optional<at::Tensor>& head_mask /* optional */,
         const c10::optional<at::Tensor>& attention_mask /* optional */,
-        c10::optional<bool> add_casual_mask /* optional */);
+        c10::optional<bool> add_casual_mask /* optional */,
+        const c10::optional<at::Tensor>& tree_mask /* optional */);
+
+using indirect_kv_cache_compact_kernel_fn = void (*)(
+    at::Tensor& key_cache,
+    at::Tensor& value_cache,
+    at::Tensor& beam_idx,
+    int64_t offset,
+    const at::Tensor& accepted);
 
 IPEX_DECLARE_DISPATCH(
     masked_multihead_self_attention_kernel_fn,
     masked_multihead_self_attention_kernel_stub);
+IPEX_DECLARE_DISPATCH(
+    indirect_kv_cache_compact_kernel_fn,
+    indirect_kv_cache_compact_kernel_stub);
 
 } // namespace cpu
 } // namespace torch_ipex
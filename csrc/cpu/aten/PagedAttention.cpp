@@ -1,12 +1,43 @@
 #include "PagedAttention.h"
 #include <torch/all.h>
 #include <torch/csrc/autograd/function.h>
+#include "utils/kernel_counters.h"
 
 namespace torch_ipex {
 namespace cpu {
 
 IPEX_DEFINE_DISPATCH(single_query_cached_kv_attention_kernel_stub);
 IPEX_DEFINE_DISPATCH(reshape_and_cache_kernel_stub);
+IPEX_DEFINE_DISPATCH(paged_kv_cache_compact_kernel_stub);
+
+// Minimum traffic of one decode step for the roofline counters: every query
+// head reads the keys and values of its context once through the block table.
+static utils::KernelTraffic paged_attention_traffic(
+    const at::Tensor& out,
+    const at::Tensor& query,
+    const at::Tensor& key_cache,
+    const at::Tensor& value_cache,
+    const at::Tensor& block_tables,
+    const at::Tensor& context_lens) {
+  auto num_heads = query.size(1);
+  auto head_size = query.size(2);
+  auto kv_heads = key_cache.size(2);
+  auto lens = context_lens.to(at::kLong).contiguous();
+  auto lens_ptr = lens.data_ptr<int64_t>();
+  int64_t tokens = 0;
+  for (int64_t i = 0; i < lens.numel(); i++) {
+    tokens += lens_ptr[i];
+  }
+  utils::KernelTraffic traffic;
+  traffic.kv_bytes = tokens * kv_heads * head_size *
+      (key_cache.element_size() + value_cache.element_size());
+  traffic.activation_bytes = utils::kernel_tensor_bytes(query) +
+      utils::kernel_tensor_bytes(out) +
+      utils::kernel_tensor_bytes(block_tables) +
+      utils::kernel_tensor_bytes(context_lens);
+  traffic.flops = 4 * tokens * num_heads * head_size;
+  return traffic;
+}
 
 /*
  *Caculate the masked multihead attention for decoder layer in decoder only
@@ -22,7 +53,13 @@ void single_query_cached_kv_attention_forward_cpu(
     at::Tensor& context_lens, // [num_seqs]
     int64_t block_size,
     int64_t max_context_len,
-    const c10::optional<at::Tensor>& alibi_slopes) {
+    const c10::optional<at::Tensor>& alibi_slopes,
+    const c10::optional<at::Tensor>& tree_mask) { // [num_seqs, words]
+  utils::KernelCounterScope counter(utils::KernelCounterKind::PagedAttention);
+  if (counter.enabled()) {
+    counter.start(paged_attention_traffic(
+        out, query, key_cache, value_cache, block_tables, context_lens));
+  }
   return single_query_cached_kv_attention_kernel_stub(
       kCPU,
       out,
@@ -35,7 +72,8 @@ void single_query_cached_kv_attention_forward_cpu(
       context_lens,
       block_size,
       max_context_len,
-      alibi_slopes);
+      alibi_slopes,
+      tree_mask);
 }
 
 void reshape_and_cache_cpu(
@@ -48,6 +86,15 @@ void reshape_and_cache_cpu(
       kCPU, key, value, key_cache, value_cache, slot_mapping);
 }
 
+void paged_kv_cache_compact_cpu(
+    at::Tensor& key_cache,
+    at::Tensor& value_cache,
+    at::Tensor& src_slots,
+    at::Tensor& dst_slots) {
+  return paged_kv_cache_compact_kernel_stub(
+      kCPU, key_cache, value_cache, src_slots, dst_slots);
+}
+
 } // namespace cpu
 } // namespace torch_ipex
 
@@ -57,7 +104,7 @@ TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
   m.def(
       "single_query_cached_kv_attention(Tensor (a!)out, Tensor (a!)query, Tensor (a!)key_cache, Tensor (a!)value_cache,\
        Tensor(a!) head_mapping, float scale, Tensor(a!) block_tables, Tensor(a!) context_lens, int block_size, int max_context_len,\
-       Tensor? alibi_slopes)-> ()");
+       Tensor? alibi_slopes, Tensor? tree_mask=None)-> ()");
   m.impl(
       "single_query_cached_kv_attention",
       c10::DispatchKey::CPU,
@@ -68,5 +115,11 @@ TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
       "reshape_and_cache",
       c10::DispatchKey::CPU,
       torch_ipex::cpu::reshape_and_cache_cpu);
+  m.def(
+      "paged_kv_cache_compact(Tensor (a!)key_cache, Tensor (a!)value_cache, Tensor src_slots, Tensor dst_slots)-> ()");
+  m.impl(
+      "paged_kv_cache_compact",
+      c10::DispatchKey::CPU,
+      torch_ipex::cpu::paged_kv_cache_compact_cpu);
 }
 } // namespace
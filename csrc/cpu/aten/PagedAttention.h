@@ -19,7 +19,8 @@ void single_query_cached_kv_attention(
     at::Tensor& context_lens, // [num_seqs]
     int64_t block_size,
     int64_t max_context_len,
-    const c10::optional<at::Tensor>& alibi_slopes);
+    const c10::optional<at::Tensor>& alibi_slopes,
+    const c10::optional<at::Tensor>& tree_mask); // [num_seqs, words]
 }
 
 void reshape_and_cache(
@@ -29,6 +30,12 @@ void reshape_and_cache(
     at::Tensor& value_cache,
     at::Tensor& slot_mapping);
 
+void paged_kv_cache_compact(
+    at::Tensor& key_cache,
+    at::Tensor& value_cache,
+    at::Tensor& src_slots,
+    at::Tensor& dst_slots);
+
 using single_query_cached_kv_attention_fn = void (*)(
     at::Tensor& out, // [num_seqs, num_heads, head_size]
     at::Tensor& query, // [num_seqs, num_heads, head_size]
@@ -40,7 +47,8 @@ using single_query_cached_kv_attention_fn = void (*)(
     at::Tensor& context_lens, // [num_seqs]
     int64_t block_size,
     int64_t max_context_len,
-    const c10::optional<at::Tensor>& alibi_slopes);
+    const c10::optional<at::Tensor>& alibi_slopes,
+    const c10::optional<at::Tensor>& tree_mask); // [num_seqs, words]
 
 using reshape_and_cache_fn = void (*)(
     at::Tensor& key,
@@ -49,10 +57,19 @@ using reshape_and_cache_fn = void (*)(
     at::Tensor& value_cache,
     at::Tensor& slot_mapping);
 
+using paged_kv_cache_compact_fn = void (*)(
+    at::Tensor& key_cache,
+    at::Tensor& value_cache,
+    at::Tensor& src_slots,
+    at::Tensor& dst_slots);
+
 IPEX_DECLARE_DISPATCH(
     single_query_cached_kv_attention_fn,
     single_query_cached_kv_attention_kernel_stub);
 IPEX_DECLARE_DISPATCH(reshape_and_cache_fn, reshape_and_cache_kernel_stub);
+IPEX_DECLARE_DISPATCH(
+    paged_kv_cache_compact_fn,
+    paged_kv_cache_compact_kernel_stub);
 
 } // namespace cpu
 } // namespace torch_ipex
@@ -3,6 +3,7 @@
 #include <torch/all.h>
 #include <torch/csrc/autograd/function.h>
 #include "tpp/xsmm_functors.h"
+#include "utils/kernel_counters.h"
 namespace torch_ipex {
 namespace cpu {
 
@@ -15,11 +16,37 @@ IPEX_DEFINE_DISPATCH(tpp_linear_relu_kernel_stub);
 IPEX_DEFINE_DISPATCH(tpp_linear_add_kernel_stub);
 IPEX_DEFINE_DISPATCH(tpp_linear_mul_kernel_stub);
 IPEX_DEFINE_DISPATCH(tpp_linear_add_add_kernel_stub);
+IPEX_DEFINE_DISPATCH(tpp_linear_lora_kernel_stub);
+IPEX_DEFINE_DISPATCH(tpp_linear_lora_backward_kernel_stub);
+
+// Minimum traffic of one TPP linear for the roofline counters. The blocked
+// weights are [Nk][Nc][Hc][Hk] (VNNI adds a trailing dim), `extra` are the
+// operands of the fused elementwise epilogue.
+static utils::KernelTraffic tpp_linear_traffic(
+    const at::Tensor& t_in,
+    at::TensorList weights,
+    at::TensorList biases,
+    at::TensorList extra = {}) {
+  auto K = t_in.size(-1);
+  auto M = t_in.numel() / K;
+  auto N = weights[0].size(0) * weights[0].size(3);
+  utils::KernelTraffic traffic;
+  traffic.weight_bytes =
+      utils::kernel_tensor_bytes(weights) + utils::kernel_tensor_bytes(biases);
+  traffic.activation_bytes = utils::kernel_tensor_bytes(t_in) +
+      utils::kernel_tensor_bytes(extra) + M * N * t_in.element_size();
+  traffic.flops = 2 * M * N * K * (int64_t)weights.size();
+  return traffic;
+}
 
 at::Tensor tpp_linear_nobias_forward_cpu(
     const at::Tensor& t_in,
     const at::Tensor& t_wt,
     c10::optional<int64_t> out_features) {
+  utils::KernelCounterScope counter(utils::KernelCounterKind::TppLinear);
+  if (counter.enabled()) {
+    counter.start(tpp_linear_traffic(t_in, {t_wt}, {}));
+  }
   return tpp_linear_nobias_kernel_stub(kCPU, t_in, t_wt);
 }
 
@@ -28,6 +55,10 @@ at::Tensor tpp_linear_bias_forward_cpu(
     const at::Tensor& t_wt,
     const at::Tensor& t_bias,
     c10::optional<int64_t> out_features) {
+  utils::KernelCounterScope counter(utils::KernelCounterKind::TppLinear);
+  if (counter.enabled()) {
+    counter.start(tpp_linear_traffic(t_in, {t_wt}, {t_bias}));
+  }
   return tpp_linear_bias_kernel_stub(kCPU, t_in, t_wt, t_bias);
 }
 
@@ -36,6 +67,10 @@ at::Tensor tpp_linear_gelu_forward_cpu(
     const at::Tensor& t_wt,
     const at::Tensor& t_bias,
     c10::optional<int64_t> out_features) {
+  utils::KernelCounterScope counter(utils::KernelCounterKind::TppLinear);
+  if (counter.enabled()) {
+    counter.start(tpp_linear_traffic(t_in, {t_wt}, {t_bias}));
+  }
   return tpp_linear_gelu_kernel_stub(kCPU, t_in, t_wt, t_bias);
 }
 
@@ -46,6 +81,11 @@ at::Tensor tpp_fused_gate_up_proj_forward_cpu(
     const at::Tensor& t_wt_up,
     const at::Tensor& t_bias_up,
     c10::optional<int64_t> out_features) {
+  utils::KernelCounterScope counter(utils::KernelCounterKind::TppLinear);
+  if (counter.enabled()) {
+    counter.start(tpp_linear_traffic(
+        t_in, {t_wt_gate, t_wt_up}, {t_bias_gate, t_bias_up}));
+  }
   return tpp_fused_gate_up_proj_kernel_stub(
       kCPU, t_in, t_wt_gate, t_bias_gate, t_wt_up, t_bias_up);
 }
@@ -55,6 +95,10 @@ at::Tensor tpp_linear_silu_forward_cpu(
     const at::Tensor& t_wt,
     const at::Tensor& t_bias,
     c10::optional<int64_t> out_features) {
+  utils::KernelCounterScope counter(utils::KernelCounterKind::TppLinear);
+  if (counter.enabled()) {
+    counter.start(tpp_linear_traffic(t_in, {t_wt}, {t_bias}));
+  }
   return tpp_linear_silu_kernel_stub(kCPU, t_in, t_wt, t_bias);
 }
 
@@ -63,6 +107,10 @@ at::Tensor tpp_linear_relu_forward_cpu(
     const at::Tensor& t_wt,
     const at::Tensor& t_bias,
     c10::optional<int64_t> out_features) {
+  utils::KernelCounterScope counter(utils::KernelCounterKind::TppLinear);
+  if (counter.enabled()) {
+    counter.start(tpp_linear_traffic(t_in, {t_wt}, {t_bias}));
+  }
   return tpp_linear_relu_kernel_stub(kCPU, t_in, t_wt, t_bias);
 }
 
@@ -73,6 +121,10 @@ at::Tensor tpp_linear_add_forward_cpu(
     const at::Tensor& t_bias,
     double scale,
     c10::optional<int64_t> out_features) {
+  utils::KernelCounterScope counter(utils::KernelCounterKind::TppLinear);
+  if (counter.enabled()) {
+    counter.start(tpp_linear_traffic(t_in, {t_wt}, {t_bias}, {t_in1}));
+  }
   return tpp_linear_add_kernel_stub(kCPU, t_in, t_in1, t_wt, t_bias, scale);
 }
 
@@ -82,6 +134,10 @@ at::Tensor tpp_linear_mul_forward_cpu(
     const at::Tensor& t_wt,
     const at::Tensor& t_bias,
     c10::optional<int64_t> out_features) {
+  utils::KernelCounterScope counter(utils::KernelCounterKind::TppLinear);
+  if (counter.enabled()) {
+    counter.start(tpp_linear_traffic(t_in, {t_wt}, {t_bias}, {t_in1}));
+  }
   return tpp_linear_mul_kernel_stub(kCPU, t_in, t_in1, t_wt, t_bias);
 }
 
@@ -93,10 +149,39 @@ at::Tensor tpp_linear_add_add_forward_cpu(
     const at::Tensor& t_bias,
     double scale,
     c10::optional<int64_t> out_features) {
+  utils::KernelCounterScope counter(utils::KernelCounterKind::TppLinear);
+  if (counter.enabled()) {
+    counter.start(tpp_linear_traffic(t_in, {t_wt}, {t_bias}, {t_in1, t_in2}));
+  }
   return tpp_linear_add_add_kernel_stub(
       kCPU, t_in, t_in1, t_in2, t_wt, t_bias, scale);
 }
 
+at::Tensor tpp_linear_lora_forward_cpu(
+    const at::Tensor& t_in,
+    const at::Tensor& t_wt,
+    const at::Tensor& t_bias,
+    const at::Tensor& t_lora_a,
+    const at::Tensor& t_lora_b,
+    const at::Tensor& t_adapter_idx,
+    double scale,
+    c10::optional<int64_t> out_features) {
+  return tpp_linear_lora_kernel_stub(
+      kCPU, t_in, t_wt, t_bias, t_lora_a, t_lora_b, t_adapter_idx, scale);
+}
+
+std::tuple<at::Tensor, at::Tensor, at::Tensor> tpp_linear_lora_backward_cpu(
+    const at::Tensor& t_grad_out,
+    const at::Tensor& t_in,
+    const at::Tensor& t_wt,
+    const at::Tensor& t_lora_a,
+    const at::Tensor& t_lora_b,
+    const at::Tensor& t_adapter_idx,
+    double scale) {
+  return tpp_linear_lora_backward_kernel_stub(
+      kCPU, t_grad_out, t_in, t_wt, t_lora_a, t_lora_b, t_adapter_idx, scale);
+}
+
 } // namespace cpu
 } // namespace torch_ipex
 
@@ -183,5 +268,23 @@ TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
       torch_ipex::cpu::tpp_linear_mul_forward_cpu);
 }
 
+TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
+  m.def(
+      "tpp_linear_lora(Tensor t_in, Tensor t_wt, Tensor t_bias, Tensor t_lora_a, Tensor t_lora_b, Tensor t_adapter_idx, float scale, int? out_features=None)-> Tensor out");
+  m.impl(
+      "tpp_linear_lora",
+      c10::DispatchKey::CPU,
+      torch_ipex::cpu::tpp_linear_lora_forward_cpu);
+}
+
+TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
+  m.def(
+      "tpp_linear_lora_backward(Tensor t_grad_out, Tensor t_in, Tensor t_wt, Tensor t_lora_a, Tensor t_lora_b, Tensor t_adapter_idx, float scale)-> (Tensor, Tensor, Tensor)");
+  m.impl(
+      "tpp_linear_lora_backward",
+      c10::DispatchKey::CPU,
+      torch_ipex::cpu::tpp_linear_lora_backward_cpu);
+}
+
 } // namespace
 #endif
\ No newline at end of file
@@ -68,6 +68,25 @@ at::Tensor tpp_linear_add_add_forward_cpu(
     double scale,
     c10::optional<int64_t> out_features);
 
+at::Tensor tpp_linear_lora_forward_cpu(
+    const at::Tensor& t_in,
+    const at::Tensor& t_wt,
+    const at::Tensor& t_bias,
+    const at::Tensor& t_lora_a,
+    const at::Tensor& t_lora_b,
+    const at::Tensor& t_adapter_idx,
+    double scale,
+    c10::optional<int64_t> out_features);
+
+std::tuple<at::Tensor, at::Tensor, at::Tensor> tpp_linear_lora_backward_cpu(
+    const at::Tensor& t_grad_out,
+    const at::Tensor& t_in,
+    const at::Tensor& t_wt,
+    const at::Tensor& t_lora_a,
+    const at::Tensor& t_lora_b,
+    const at::Tensor& t_adapter_idx,
+    double scale);
+
 } // namespace
 
 using tpp_linear_nobias_impl_fn =
@@ -113,6 +132,25 @@ using tpp_linear_add_add_kernel_impl_fn = at::Tensor (*)(
     const at::Tensor&,
     double);
 
+using tpp_linear_lora_kernel_impl_fn = at::Tensor (*)(
+    const at::Tensor&,
+    const at::Tensor&,
+    const at::Tensor&,
+    const at::Tensor&,
+    const at::Tensor&,
+    const at::Tensor&,
+    double);
+
+using tpp_linear_lora_backward_kernel_impl_fn =
+    std::tuple<at::Tensor, at::Tensor, at::Tensor> (*)(
+        const at::Tensor&,
+        const at::Tensor&,
+        const at::Tensor&,
+        const at::Tensor&,
+        const at::Tensor&,
+        const at::Tensor&,
+        double);
+
 IPEX_DECLARE_DISPATCH(tpp_linear_nobias_impl_fn, tpp_linear_nobias_kernel_stub);
 IPEX_DECLARE_DISPATCH(
     tpp_linear_bias_kernel_impl_fn,
@@ -138,6 +176,12 @@ IPEX_DECLARE_DISPATCH(
 IPEX_DECLARE_DISPATCH(
     tpp_linear_add_add_kernel_impl_fn,
     tpp_linear_add_add_kernel_stub);
+IPEX_DECLARE_DISPATCH(
+    tpp_linear_lora_kernel_impl_fn,
+    tpp_linear_lora_kernel_stub);
+IPEX_DECLARE_DISPATCH(
+    tpp_linear_lora_backward_kernel_impl_fn,
+    tpp_linear_lora_backward_kernel_stub);
 
 } // namespace cpu
 } // namespace torch_ipex
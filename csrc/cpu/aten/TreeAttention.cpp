@@ -0,0 +1,52 @@
+#include "TreeAttention.h"
+#include <torch/all.h>
+
+namespace torch_ipex {
+namespace cpu {
+
+/*
+ *Build the tree mask for the tree attention of speculative decoding.
+ *@param parents The parent index of every candidate [num_candidates], which
+ *is smaller than the index of the candidate, or -1 for the roots.
+ *@return The int64 bitmask [num_candidates, (num_candidates + 63) / 64] of
+ *the candidates every candidate attends: its ancestors and itself.
+ */
+at::Tensor tree_attention_mask(const at::Tensor& parents) {
+  TORCH_CHECK(parents.dim() == 1, "parents should be 1D");
+  auto parents_v = parents.to(at::kLong).contiguous();
+  auto num_candidates = parents_v.size(0);
+  auto words = (num_candidates + 63) / 64;
+  auto tree_mask = at::zeros({num_candidates, words}, at::kLong);
+  auto parents_ptr = parents_v.data_ptr<int64_t>();
+  auto mask_ptr = tree_mask.data_ptr<int64_t>();
+  for (auto i = 0; i < num_candidates; i++) {
+    auto parent = parents_ptr[i];
+    TORCH_CHECK(
+        parent >= -1 && parent < i,
+        "tree_attention_mask: the parent of candidate ",
+        i,
+        " should be a previous candidate or -1, got ",
+        parent);
+    auto row = mask_ptr + i * words;
+    if (parent >= 0) {
+      // the parent row is complete as candidates are in topological order
+      std::copy_n(mask_ptr + parent * words, words, row);
+    }
+    row[i >> 6] |= static_cast<int64_t>(uint64_t(1) << (i & 63));
+  }
+  return tree_mask;
+}
+
+} // namespace cpu
+} // namespace torch_ipex
+
+namespace {
+
+TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
+  m.def("tree_attention_mask(Tensor parents) -> Tensor");
+  m.impl(
+      "tree_attention_mask",
+      c10::DispatchKey::CPU,
+      torch_ipex::cpu::tree_attention_mask);
+}
+} // namespace
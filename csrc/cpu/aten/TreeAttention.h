@@ -0,0 +1,38 @@
+#pragma once
+
+#include <ATen/ATen.h>
+
+namespace torch_ipex {
+namespace cpu {
+
+// Tree-based speculative decoding verifies a tree of candidate tokens in one
+// forward, each candidate attending the cached prefix plus its ancestors and
+// itself only. With the candidates in topological order (every parent before
+// its children), the tree mask holds one int64 bitmask row per query, bit j
+// set if it attends candidate j, so the row of candidate i has bit i as its
+// highest bit.
+
+inline bool tree_mask_visible(const int64_t* row, int64_t candidate) {
+  return (row[candidate >> 6] >> (candidate & 63)) & 1;
+}
+
+// The candidate a row belongs to, i.e. its highest bit, -1 if the row is
+// empty.
+inline int64_t tree_mask_candidate(const int64_t* row, int64_t words) {
+  for (auto w = words - 1; w >= 0; w--) {
+    for (auto b = 63; row[w] != 0 && b >= 0; b--) {
+      if ((row[w] >> b) & 1) {
+        return w * 64 + b;
+      }
+    }
+  }
+  return -1;
+}
+
+// Builds the tree mask of candidates [num_candidates, (num_candidates + 63) /
+// 64] from their parent indices, -1 for the children of the last accepted
+// token.
+at::Tensor tree_attention_mask(const at::Tensor& parents);
+
+} // namespace cpu
+} // namespace torch_ipex
@@ -1,3 +1,5 @@
+#pragma once
+
 #include <ATen/Tensor.h>
 #include <c10/util/Float8_e4m3fn.h>
 #include <c10/util/Float8_e5m2.h>
@@ -0,0 +1,206 @@
+#include <aten/Cast.h>
+#include <aten/fp8_utils.h>
+
+#include <ATen/Parallel.h>
+#include <torch/csrc/autograd/function.h>
+#include "vec/vec.h"
+
+namespace torch_ipex {
+namespace cpu {
+
+namespace {
+
+template <typename fp8_t>
+inline fp8_t fp8_saturate_cast(float val) {
+  constexpr float fp8_max =
+      std::is_same<fp8_t, fp8e4m3>::value ? 448.f : 57344.f;
+  if (fabsf(val) > fp8_max) {
+    val = val > 0 ? fp8_max : -fp8_max;
+  }
+  return static_cast<fp8_t>(val);
+}
+
+template <typename scalar_t, typename fp8_t>
+float fp8_quantize_kernel(
+    const scalar_t* input_ptr,
+    fp8_t* output_ptr,
+    int64_t len,
+    float scale) {
+  if constexpr (!std::is_same<scalar_t, double>::value) {
+    // AVX512 or AVX2 kernel from vec/, with the amax reduction fused
+    return kernel::_fp8_quantize<scalar_t, fp8_t>(
+        input_ptr, output_ptr, len, scale);
+  } else {
+    float local_max = 0;
+    for (const auto n : c10::irange(len)) {
+      float in = static_cast<float>(input_ptr[n]);
+      output_ptr[n] = fp8_saturate_cast<fp8_t>(in * scale);
+      local_max = fmaxf(fabsf(in), local_max);
+    }
+    return local_max;
+  }
+}
+
+template <typename scalar_t, typename fp8_t>
+void fp8_dequantize_kernel(
+    const fp8_t* input_ptr,
+    scalar_t* output_ptr,
+    int64_t len,
+    float scale_inv) {
+  if constexpr (!std::is_same<scalar_t, double>::value) {
+    kernel::_fp8_dequantize<fp8_t, scalar_t>(
+        input_ptr, output_ptr, len, scale_inv);
+  } else {
+    for (const auto n : c10::irange(len)) {
+      output_ptr[n] =
+          static_cast<scalar_t>(static_cast<float>(input_ptr[n]) * scale_inv);
+    }
+  }
+}
+
+float fp8_quantize_kernel_impl(
+    const at::Tensor& input,
+    float scale,
+    at::Tensor& output) {
+  TORCH_CHECK(
+      input.is_contiguous() && output.is_contiguous(),
+      "fp8_quantize: expect contiguous input and output");
+  int num_threads = at::get_num_threads();
+  std::vector<float> max_buffer(num_threads, 0);
+  AT_DISPATCH_FLOATING_TYPES_AND2(
+      at::ScalarType::BFloat16,
+      at::ScalarType::Half,
+      input.scalar_type(),
+      "fp8_quantize",
+      [&] {
+        const scalar_t* input_ptr = input.data_ptr<scalar_t>();
+        auto quantize = [&](auto* output_ptr) {
+          using fp8_t = std::remove_pointer_t<decltype(output_ptr)>;
+          at::parallel_for(
+              0,
+              input.numel(),
+              at::internal::GRAIN_SIZE,
+              [&](int64_t begin, int64_t end) {
+                float local_max = fp8_quantize_kernel<scalar_t, fp8_t>(
+                    input_ptr + begin, output_ptr + begin, end - begin, scale);
+                int tid = at::get_thread_num();
+                max_buffer[tid] = fmaxf(local_max, max_buffer[tid]);
+              });
+        };
+        if (output.scalar_type() == at::ScalarType::Float8_e4m3fn) {
+          quantize(output.data_ptr<fp8e4m3>());
+        } else {
+          quantize(output.data_ptr<fp8e5m2>());
+        }
+      });
+  return *std::max_element(max_buffer.begin(), max_buffer.end());
+}
+
+float fp8_cast_transpose_kernel_impl(
+    const at::Tensor& input,
+    float scale,
+    at::Tensor& output,
+    at::Tensor& output_t) {
+  TORCH_CHECK(
+      input.dim() == 2 && input.is_contiguous(),
+      "fp8_cast_transpose: expect a contiguous 2D input");
+  // The input is processed in tiles, each tile is quantized row by row with
+  // the vectorized kernel and then transposed from the cache hot output.
+  constexpr int64_t kTile = 64;
+  const int64_t M = input.size(0), N = input.size(1);
+  const int64_t m_tiles = (M + kTile - 1) / kTile;
+  const int64_t n_tiles = (N + kTile - 1) / kTile;
+  int num_threads = at::get_num_threads();
+  std::vector<float> max_buffer(num_threads, 0);
+  AT_DISPATCH_FLOATING_TYPES_AND2(
+      at::ScalarType::BFloat16,
+      at::ScalarType::Half,
+      input.scalar_type(),
+      "fp8_cast_transpose",
+      [&] {
+        const scalar_t* input_ptr = input.data_ptr<scalar_t>();
+        auto quantize = [&](auto* output_ptr, auto* output_t_ptr) {
+          using fp8_t = std::remove_pointer_t<decltype(output_ptr)>;
+          at::parallel_for(
+              0, m_tiles * n_tiles, 1, [&](int64_t begin, int64_t end) {
+                int tid = at::get_thread_num();
+                float local_max = max_buffer[tid];
+                for (const auto t : c10::irange(begin, end)) {
+                  const int64_t m0 = t / n_tiles * kTile;
+                  const int64_t n0 = t % n_tiles * kTile;
+                  const int64_t m_len = std::min(kTile, M - m0);
+                  const int64_t n_len = std::min(kTile, N - n0);
+                  for (const auto i : c10::irange(m0, m0 + m_len)) {
+                    local_max = fmaxf(
+                        fp8_quantize_kernel<scalar_t, fp8_t>(
+                            input_ptr + i * N + n0,
+                            output_ptr + i * N + n0,
+                            n_len,
+                            scale),
+                        local_max);
+                  }
+                  for (const auto j : c10::irange(n0, n0 + n_len)) {
+                    for (const auto i : c10::irange(m0, m0 + m_len)) {
+                      output_t_ptr[j * M + i] = output_ptr[i * N + j];
+                    }
+                  }
+                }
+                max_buffer[tid] = local_max;
+              });
+        };
+        if (output.scalar_type() == at::ScalarType::Float8_e4m3fn) {
+          quantize(output.data_ptr<fp8e4m3>(), output_t.data_ptr<fp8e4m3>());
+        } else {
+          quantize(output.data_ptr<fp8e5m2>(), output_t.data_ptr<fp8e5m2>());
+        }
+      });
+  return *std::max_element(max_buffer.begin(), max_buffer.end());
+}
+
+void fp8_dequantize_kernel_impl(
+    const at::Tensor& input,
+    float scale_inv,
+    at::Tensor& output) {
+  TORCH_CHECK(
+      input.is_contiguous() && output.is_contiguous(),
+      "fp8_dequantize: expect contiguous input and output");
+  AT_DISPATCH_FLOATING_TYPES_AND2(
+      at::ScalarType::BFloat16,
+      at::ScalarType::Half,
+      output.scalar_type(),
+      "fp8_dequantize",
+      [&] {
+        scalar_t* output_ptr = output.data_ptr<scalar_t>();
+        auto dequantize = [&](const auto* input_ptr) {
+          using fp8_t = std::remove_cv_t<
+              std::remove_pointer_t<decltype(input_ptr)>>;
+          at::parallel_for(
+              0,
+              input.numel(),
+              at::internal::GRAIN_SIZE,
+              [&](int64_t begin, int64_t end) {
+                fp8_dequantize_kernel<scalar_t, fp8_t>(
+                    input_ptr + begin,
+                    output_ptr + begin,
+                    end - begin,
+                    scale_inv);
+              });
+        };
+        if (input.scalar_type() == at::ScalarType::Float8_e4m3fn) {
+          dequantize(input.data_ptr<fp8e4m3>());
+        } else {
+          dequantize(input.data_ptr<fp8e5m2>());
+        }
+      });
+}
+
+} // namespace
+
+IPEX_REGISTER_DISPATCH(fp8_quantize_kernel_stub, &fp8_quantize_kernel_impl);
+IPEX_REGISTER_DISPATCH(
+    fp8_cast_transpose_kernel_stub,
+    &fp8_cast_transpose_kernel_impl);
+IPEX_REGISTER_DISPATCH(fp8_dequantize_kernel_stub, &fp8_dequantize_kernel_impl);
+
+} // namespace cpu
+} // namespace torch_ipex
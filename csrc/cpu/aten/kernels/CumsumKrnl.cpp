@@ -8,6 +8,8 @@
 #include <aten/Cumsum.h>
 
 #include <immintrin.h>
+#include <cstring>
+#include <limits>
 #include "vec/vec.h"
 
 namespace torch_ipex {
@@ -123,51 +125,364 @@ static inline void cumsum_lastdim_kernel(
   }
 }
 
-bool cumsum_fast_path(
+// Combiners of the scan engine: the identity and the associative op in both
+// scalar and vector forms
+template <typename scalar_t>
+struct ScanSum {
+  static scalar_t identity() {
+    return scalar_t(0);
+  }
+  scalar_t operator()(scalar_t a, scalar_t b) const {
+    return a + b;
+  }
+  Vectorized<scalar_t> operator()(
+      const Vectorized<scalar_t>& a,
+      const Vectorized<scalar_t>& b) const {
+    return a + b;
+  }
+};
+
+template <typename scalar_t>
+struct ScanProd {
+  static scalar_t identity() {
+    return scalar_t(1);
+  }
+  scalar_t operator()(scalar_t a, scalar_t b) const {
+    return a * b;
+  }
+  Vectorized<scalar_t> operator()(
+      const Vectorized<scalar_t>& a,
+      const Vectorized<scalar_t>& b) const {
+    return a * b;
+  }
+};
+
+// log(exp(a) + exp(b)), where -inf stays -inf instead of exp(-inf - -inf)
+template <typename scalar_t>
+struct ScanLogAddExp {
+  static scalar_t identity() {
+    return -std::numeric_limits<scalar_t>::infinity();
+  }
+  scalar_t operator()(scalar_t a, scalar_t b) const {
+    scalar_t min = std::min(a, b);
+    scalar_t max = std::max(a, b);
+    if (min == max && std::isinf(max)) {
+      return max;
+    }
+    return max + std::log1p(std::exp(min - max));
+  }
+  Vectorized<scalar_t> operator()(
+      const Vectorized<scalar_t>& a,
+      const Vectorized<scalar_t>& b) const {
+    auto max = at::vec::maximum(a, b);
+    auto diff = at::vec::minimum(a, b) - max;
+    return Vectorized<scalar_t>::blendv(
+        max + diff.exp().log1p(), max, diff != diff);
+  }
+};
+
+// Scans [begin, end) of a row serially in the scan direction and returns the
+// total of the range
+template <typename scalar_t, typename Op>
+static inline scalar_t scan_range(
+    const scalar_t* self_ptr,
+    scalar_t* result_ptr,
+    int64_t begin,
+    int64_t end,
+    bool exclusive,
+    bool reverse,
+    const Op& op) {
+  scalar_t acc = Op::identity();
+  for (int64_t i = begin; i < end; i++) {
+    int64_t n = reverse ? begin + end - 1 - i : i;
+    scalar_t x = self_ptr[n];
+    if (exclusive) {
+      result_ptr[n] = acc;
+      acc = op(acc, x);
+    } else {
+      acc = op(acc, x);
+      result_ptr[n] = acc;
+    }
+  }
+  return acc;
+}
+
+// One step of `len` independent scans laid out contiguously, with their
+// running values in `acc`
+template <typename scalar_t, typename Op>
+static inline void scan_lanes(
+    const scalar_t* self_ptr,
+    scalar_t* result_ptr,
+    scalar_t* acc,
+    int64_t len,
+    bool exclusive,
+    const Op& op) {
+  using Vec = Vectorized<scalar_t>;
+  int64_t d = 0;
+  for (; d < len - (len % Vec::size()); d += Vec::size()) {
+    Vec x_vec = Vec::loadu(self_ptr + d);
+    Vec acc_vec = Vec::loadu(acc + d);
+    if (exclusive) {
+      acc_vec.store(result_ptr + d);
+    }
+    acc_vec = op(acc_vec, x_vec);
+    acc_vec.store(acc + d);
+    if (!exclusive) {
+      acc_vec.store(result_ptr + d);
+    }
+  }
+  for (; d < len; d++) {
+    scalar_t x = self_ptr[d];
+    if (exclusive) {
+      result_ptr[d] = acc[d];
+    }
+    acc[d] = op(acc[d], x);
+    if (!exclusive) {
+      result_ptr[d] = acc[d];
+    }
+  }
+}
+
+// rows shorter than two blocks are scanned by one thread
+constexpr int64_t SCAN_BLOCK_SIZE = 16 * 1024;
+// lanes of the inner dims scanned together by one thread
+constexpr int64_t SCAN_LANE_CHUNK = 1024;
+
+/*
+ *Scan of contiguous tensors along any dim, with the tensor viewed as
+ *[outer, N, inner] for the scan dim of size N.
+ *- inner > 1: the inner lanes are independent scans, which are vectorized
+ *  across and parallel over the outer dims and the chunks of lanes.
+ *- inner == 1 with enough rows: parallel over rows, each scanned serially.
+ *- inner == 1 with a few long rows: blocked scan, where every thread scans its
+ *  block locally, then combines the total of the preceding blocks in.
+ */
+template <typename scalar_t, typename Op>
+void cumulative_scan_kernel(
+    at::Tensor& result,
     const at::Tensor& self,
-    const at::Tensor& result,
     int64_t dim,
-    c10::optional<at::ScalarType> dtype) {
+    bool exclusive,
+    bool reverse,
+    const Op& op) {
+  using Vec = Vectorized<scalar_t>;
+  if (self.numel() == 0) {
+    return;
+  }
+
+  int64_t N = self.size(dim);
+  int64_t inner = c10::multiply_integers(self.sizes().slice(dim + 1));
+  int64_t outer = self.numel() / (N * inner);
+  const scalar_t* self_data = self.data_ptr<scalar_t>();
+  scalar_t* result_data = result.data_ptr<scalar_t>();
+  int64_t T = at::get_num_threads();
+
+  if (inner > 1) {
+    int64_t lane_chunk = std::min(inner, SCAN_LANE_CHUNK);
+    int64_t lane_slices = divup(inner, lane_chunk);
+    at::parallel_for(
+        0, outer * lane_slices, 1, [&](int64_t begin, int64_t end) {
+          std::vector<scalar_t> acc(lane_chunk);
+          for (int64_t z = begin; z < end; z++) {
+            int64_t m = z / lane_slices;
+            int64_t l = z % lane_slices * lane_chunk;
+            int64_t len = std::min(lane_chunk, inner - l);
+            std::fill_n(acc.begin(), len, Op::identity());
+            for (int64_t i = 0; i < N; i++) {
+              int64_t n = reverse ? N - 1 - i : i;
+              int64_t offset = (m * N + n) * inner + l;
+              scan_lanes<scalar_t>(
+                  self_data + offset,
+                  result_data + offset,
+                  acc.data(),
+                  len,
+                  exclusive,
+                  op);
+            }
+          }
+        });
+    return;
+  }
+
+  if (outer >= T || N < SCAN_BLOCK_SIZE * 2) {
+    int64_t grain_size = std::max(int64_t(1), at::internal::GRAIN_SIZE / N);
+    at::parallel_for(0, outer, grain_size, [&](int64_t begin, int64_t end) {
+      for (int64_t m = begin; m < end; m++) {
+        scan_range<scalar_t>(
+            self_data + m * N,
+            result_data + m * N,
+            0,
+            N,
+            exclusive,
+            reverse,
+            op);
+      }
+    });
+    return;
+  }
+
+  int64_t block_size = divup(N, std::min(T, divup(N, SCAN_BLOCK_SIZE)));
+  int64_t num_blocks = divup(N, block_size);
+  // total per block, then the offset per block
+  std::vector<scalar_t> offsets(outer * num_blocks);
+
+  // Parallel Path I: scan locally per block
+  at::parallel_for(0, num_blocks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t b = begin; b < end; b++) {
+      int64_t n_end = std::min(b * block_size + block_size, N);
+      for (int64_t m = 0; m < outer; m++) {
+        offsets[m * num_blocks + b] = scan_range<scalar_t>(
+            self_data + m * N,
+            result_data + m * N,
+            b * block_size,
+            n_end,
+            exclusive,
+            reverse,
+            op);
+      }
+    }
+  });
+
+  // the offset of a block combines the totals of the blocks before it
+  for (int64_t m = 0; m < outer; m++) {
+    scalar_t acc = Op::identity();
+    for (int64_t i = 0; i < num_blocks; i++) {
+      int64_t b = reverse ? num_blocks - 1 - i : i;
+      scalar_t total = offsets[m * num_blocks + b];
+      offsets[m * num_blocks + b] = acc;
+      acc = op(acc, total);
+    }
+  }
+
+  // Parallel Path II: apply offset (result should be in L2)
+  int64_t first_block = reverse ? num_blocks - 1 : 0;
+  at::parallel_for(0, num_blocks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t b = begin; b < end; b++) {
+      if (b == first_block) {
+        continue;
+      }
+      int64_t len = std::min(block_size, N - b * block_size);
+      for (int64_t m = 0; m < outer; m++) {
+        scalar_t* result_ptr = result_data + m * N + b * block_size;
+        scalar_t offset = offsets[m * num_blocks + b];
+        at::vec::map(
+            [=](Vec x) { return op(Vec(offset), x); },
+            result_ptr,
+            result_ptr,
+            len);
+      }
+    }
+  });
+}
+
+// Turns the inclusive scans of the last dim into the exclusive ones in place
+template <typename scalar_t>
+static inline void shift_lastdim(at::Tensor& result, scalar_t identity) {
+  if (result.numel() == 0) {
+    return;
+  }
+  int64_t N = result.size(-1);
+  int64_t M = result.numel() / N;
+  scalar_t* result_data = result.data_ptr<scalar_t>();
+  at::parallel_for(0, M, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t m = begin; m < end; m++) {
+      std::memmove(
+          result_data + m * N + 1,
+          result_data + m * N,
+          (N - 1) * sizeof(scalar_t));
+      result_data[m * N] = identity;
+    }
+  });
+}
+
+bool scan_fast_path(
+    const at::Tensor& self,
+    const at::Tensor& result,
+    c10::optional<at::ScalarType> dtype,
+    bool allow_long) {
   // check contiguous
   bool is_contig = self.is_contiguous() && (result.is_contiguous());
-  if (!is_contig)
-    return false;
-  // check dim
-  auto wrap_dim = at::maybe_wrap_dim(dim, self.dim());
-  if (wrap_dim != self.dim() - 1)
+  if (!is_contig || self.dim() == 0)
     return false;
   // check dtype matched
   auto out_dtype = result.scalar_type();
-  if (dtype.has_value() && out_dtype != dtype.value())
+  if (out_dtype != self.scalar_type() ||
+      (dtype.has_value() && out_dtype != dtype.value()))
     return false;
   // check dtype enabled
   bool is_dtype_enabled = out_dtype == at::ScalarType::Double ||
-      out_dtype == at::ScalarType::Float || out_dtype == at::ScalarType::Long;
+      out_dtype == at::ScalarType::Float ||
+      (allow_long && out_dtype == at::ScalarType::Long);
   if (!is_dtype_enabled)
     return false;
   return true;
 }
 
+// The scans composed of the ATen ops, for the data types and layouts out of
+// the fast path and for the autograd of cumprod and logcumsumexp
+at::Tensor scan_reference(
+    const at::Tensor& self,
+    int64_t dim,
+    bool exclusive,
+    bool reverse,
+    const std::function<at::Tensor(const at::Tensor&)>& scan,
+    const at::Scalar& identity) {
+  if (self.dim() == 0) {
+    return exclusive ? at::full_like(scan(self), identity) : scan(self);
+  }
+  auto out = scan(reverse ? self.flip(dim) : self);
+  if (exclusive && out.size(dim) > 0) {
+    auto first = at::full_like(out.narrow(dim, 0, 1), identity);
+    out = at::cat({first, out.narrow(dim, 0, out.size(dim) - 1)}, dim);
+  }
+  return reverse ? out.flip(dim) : out;
+}
+
 class NewCumSumOp : public torch::autograd::Function<NewCumSumOp> {
  public:
   static at::Tensor _forward(
       at::Tensor& result,
       const at::Tensor& self,
       int64_t dim,
-      c10::optional<at::ScalarType> dtype) {
+      c10::optional<at::ScalarType> dtype,
+      bool exclusive,
+      bool reverse) {
     RECORD_FUNCTION("IPEXCumSumOp::_forward", c10::ArrayRef<c10::IValue>({}));
 
     if (result.sizes() != self.sizes()) {
       at::native::resize_output(result, self.sizes());
     }
-    if (cumsum_fast_path(result, self, dim, dtype)) {
+    auto wrap_dim = at::maybe_wrap_dim(dim, self.dim());
+    if (scan_fast_path(self, result, dtype, true)) {
       AT_DISPATCH_FLOATING_TYPES_AND(
-          at::ScalarType::Long, self.scalar_type(), "cumsum_lastdim_cpu", [&] {
-            cumsum_lastdim_kernel<scalar_t>(result, self, dim);
+          at::ScalarType::Long, self.scalar_type(), "cumsum_cpu", [&] {
+            if (wrap_dim == self.dim() - 1 && !reverse) {
+              cumsum_lastdim_kernel<scalar_t>(result, self, wrap_dim);
+              if (exclusive) {
+                shift_lastdim<scalar_t>(result, scalar_t(0));
+              }
+            } else {
+              cumulative_scan_kernel<scalar_t>(
+                  result,
+                  self,
+                  wrap_dim,
+                  exclusive,
+                  reverse,
+                  ScanSum<scalar_t>());
+            }
           });
       return result;
     }
-    return at::cumsum_out(result, self, dim, dtype);
+    if (!exclusive && !reverse) {
+      return at::cumsum_out(result, self, dim, dtype);
+    }
+    return result.copy_(scan_reference(
+        self,
+        wrap_dim,
+        exclusive,
+        reverse,
+        [&](const at::Tensor& x) { return at::cumsum(x, wrap_dim, dtype); },
+        0));
   }
 
   static at::Tensor forward(
@@ -175,12 +490,16 @@ class NewCumSumOp : public torch::autograd::Function<NewCumSumOp> {
       at::Tensor& result,
       const at::Tensor& self,
       int64_t dim,
-      c10::optional<at::ScalarType> dtype) {
+      c10::optional<at::ScalarType> dtype,
+      bool exclusive,
+      bool reverse) {
     RECORD_FUNCTION("IPEXCumSumOp::forward", c10::ArrayRef<c10::IValue>({}));
 
     at::AutoDispatchBelowADInplaceOrView g;
     ctx->saved_data["dim"] = dim;
-    auto ret = _forward(result, self, dim, dtype);
+    ctx->saved_data["exclusive"] = exclusive;
+    ctx->saved_data["reverse"] = reverse;
+    auto ret = _forward(result, self, dim, dtype, exclusive, reverse);
     return ret;
   }
 
@@ -191,14 +510,32 @@ class NewCumSumOp : public torch::autograd::Function<NewCumSumOp> {
 
     at::AutoDispatchBelowADInplaceOrView g;
     int64_t dim = ctx->saved_data["dim"].toInt();
+    bool exclusive = ctx->saved_data["exclusive"].toBool();
+    bool reverse = ctx->saved_data["reverse"].toBool();
 
+    // The gradient of a scan is the scan of the gradient in the opposite
+    // direction, computed directly instead of flipping twice.
     at::Tensor grad_out = grad_outputs[0];
     at::Tensor grad_self;
-    if (grad_out.numel() <= 1 || grad_out.size(dim) == 1) {
+    if (!exclusive && (grad_out.numel() <= 1 || grad_out.size(dim) == 1)) {
       grad_self = grad_out;
+    } else {
+      grad_self = at::empty_like(grad_out, at::MemoryFormat::Contiguous);
+      _forward(
+          grad_self,
+          grad_out.contiguous(),
+          dim,
+          c10::nullopt,
+          exclusive,
+          !reverse);
     }
-    grad_self = grad_out.flip(dim).cumsum(dim).flip(dim);
-    return {at::Tensor(), grad_self, at::Tensor(), at::Tensor()};
+    return {
+        at::Tensor(),
+        grad_self,
+        at::Tensor(),
+        at::Tensor(),
+        at::Tensor(),
+        at::Tensor()};
   }
 };
 
@@ -206,15 +543,173 @@ at::Tensor cumsum_kernel_impl(
     at::Tensor& result,
     const at::Tensor& self,
     int64_t dim,
-    c10::optional<at::ScalarType> dtype) {
+    c10::optional<at::ScalarType> dtype,
+    bool exclusive,
+    bool reverse) {
+  if (at::GradMode::is_enabled() && self.requires_grad())
+    return NewCumSumOp::apply(result, self, dim, dtype, exclusive, reverse);
+  return NewCumSumOp::_forward(result, self, dim, dtype, exclusive, reverse);
+}
+
+enum ScanKind { SCAN_PROD = 0, SCAN_LOGSUMEXP = 1 };
+
+at::Tensor scan_reference(
+    int64_t kind,
+    const at::Tensor& self,
+    int64_t dim,
+    c10::optional<at::ScalarType> dtype,
+    bool exclusive,
+    bool reverse) {
+  if (kind == SCAN_PROD) {
+    return scan_reference(
+        self,
+        dim,
+        exclusive,
+        reverse,
+        [&](const at::Tensor& x) { return at::cumprod(x, dim, dtype); },
+        1);
+  }
+  return scan_reference(
+      self,
+      dim,
+      exclusive,
+      reverse,
+      [&](const at::Tensor& x) { return at::logcumsumexp(x, dim); },
+      -std::numeric_limits<double>::infinity());
+}
+
+class NewCumulativeScanOp
+    : public torch::autograd::Function<NewCumulativeScanOp> {
+ public:
+  static at::Tensor _forward(
+      at::Tensor& result,
+      const at::Tensor& self,
+      int64_t dim,
+      c10::optional<at::ScalarType> dtype,
+      bool exclusive,
+      bool reverse,
+      int64_t kind) {
+    RECORD_FUNCTION(
+        "IPEXCumulativeScanOp::_forward", c10::ArrayRef<c10::IValue>({}));
+
+    if (result.sizes() != self.sizes()) {
+      at::native::resize_output(result, self.sizes());
+    }
+    auto wrap_dim = at::maybe_wrap_dim(dim, self.dim());
+    if (kind == SCAN_PROD && scan_fast_path(self, result, dtype, true)) {
+      AT_DISPATCH_FLOATING_TYPES_AND(
+          at::ScalarType::Long, self.scalar_type(), "cumprod_cpu", [&] {
+            cumulative_scan_kernel<scalar_t>(
+                result,
+                self,
+                wrap_dim,
+                exclusive,
+                reverse,
+                ScanProd<scalar_t>());
+          });
+      return result;
+    }
+    if (kind == SCAN_LOGSUMEXP && scan_fast_path(self, result, dtype, false)) {
+      AT_DISPATCH_FLOATING_TYPES(self.scalar_type(), "logcumsumexp_cpu", [&] {
+        cumulative_scan_kernel<scalar_t>(
+            result,
+            self,
+            wrap_dim,
+            exclusive,
+            reverse,
+            ScanLogAddExp<scalar_t>());
+      });
+      return result;
+    }
+    return result.copy_(
+        scan_reference(kind, self, wrap_dim, dtype, exclusive, reverse));
+  }
+
+  static at::Tensor forward(
+      torch::autograd::AutogradContext* ctx,
+      at::Tensor& result,
+      const at::Tensor& self,
+      int64_t dim,
+      c10::optional<at::ScalarType> dtype,
+      bool exclusive,
+      bool reverse,
+      int64_t kind) {
+    RECORD_FUNCTION(
+        "IPEXCumulativeScanOp::forward", c10::ArrayRef<c10::IValue>({}));
+
+    at::AutoDispatchBelowADInplaceOrView g;
+    ctx->saved_data["dim"] = dim;
+    ctx->saved_data["exclusive"] = exclusive;
+    ctx->saved_data["reverse"] = reverse;
+    ctx->saved_data["kind"] = kind;
+    ctx->save_for_backward({self});
+    return _forward(result, self, dim, dtype, exclusive, reverse, kind);
+  }
+
+  static torch::autograd::tensor_list backward(
+      torch::autograd::AutogradContext* ctx,
+      torch::autograd::tensor_list grad_outputs) {
+    RECORD_FUNCTION(
+        "IPEXCumulativeScanOp::backward", c10::ArrayRef<c10::IValue>({}));
+
+    int64_t dim = ctx->saved_data["dim"].toInt();
+    bool exclusive = ctx->saved_data["exclusive"].toBool();
+    bool reverse = ctx->saved_data["reverse"].toBool();
+    int64_t kind = ctx->saved_data["kind"].toInt();
+    auto self = ctx->get_saved_variables()[0].detach().requires_grad_(true);
+
+    // Recompute the scan on the ATen ops for their gradient formulas, which
+    // take care of the zeros of cumprod and the -inf of logcumsumexp.
+    at::Tensor grad_self;
+    {
+      at::AutoGradMode enable_grad(true);
+      auto out =
+          scan_reference(kind, self, dim, c10::nullopt, exclusive, reverse);
+      grad_self = torch::autograd::grad({out}, {self}, {grad_outputs[0]})[0];
+    }
+    return {
+        at::Tensor(),
+        grad_self,
+        at::Tensor(),
+        at::Tensor(),
+        at::Tensor(),
+        at::Tensor(),
+        at::Tensor()};
+  }
+};
+
+at::Tensor cumprod_kernel_impl(
+    at::Tensor& result,
+    const at::Tensor& self,
+    int64_t dim,
+    c10::optional<at::ScalarType> dtype,
+    bool exclusive,
+    bool reverse) {
+  if (at::GradMode::is_enabled() && self.requires_grad())
+    return NewCumulativeScanOp::apply(
+        result, self, dim, dtype, exclusive, reverse, SCAN_PROD);
+  return NewCumulativeScanOp::_forward(
+      result, self, dim, dtype, exclusive, reverse, SCAN_PROD);
+}
+
+at::Tensor logcumsumexp_kernel_impl(
+    at::Tensor& result,
+    const at::Tensor& self,
+    int64_t dim,
+    bool exclusive,
+    bool reverse) {
   if (at::GradMode::is_enabled() && self.requires_grad())
-    return NewCumSumOp::apply(result, self, dim, dtype);
-  return NewCumSumOp::_forward(result, self, dim, dtype);
+    return NewCumulativeScanOp::apply(
+        result, self, dim, c10::nullopt, exclusive, reverse, SCAN_LOGSUMEXP);
+  return NewCumulativeScanOp::_forward(
+      result, self, dim, c10::nullopt, exclusive, reverse, SCAN_LOGSUMEXP);
 }
 
 } // anonymous namespace
 
 IPEX_REGISTER_DISPATCH(cumsum_kernel_stub, &cumsum_kernel_impl);
+IPEX_REGISTER_DISPATCH(cumprod_kernel_stub, &cumprod_kernel_impl);
+IPEX_REGISTER_DISPATCH(logcumsumexp_kernel_stub, &logcumsumexp_kernel_impl);
 
 } // namespace cpu
 } // namespace torch_ipex
@@ -62,12 +62,27 @@ static inline Tensor _embedding_bag_index_add_select_fast(
 
   Tensor output = empty({output_size, src.size(1)}, src.options());
   auto* output_data = output.data_ptr<T>();
+  const auto& gather_opt = gather_options();
   parallel_for(0, output_size, 16, [&](int64_t start, int64_t end) {
+    // Prefetch rows of upcoming indices across bag boundaries, up to the
+    // last index owned by this thread.
+    const int64_t prefetch_end =
+        end - 1 == last_offset ? last_index : offsets_data[end];
+    auto prefetch = [&](int64_t s) {
+      int64_t ahead = s + gather_opt.prefetch_distance;
+      if (gather_opt.prefetch_distance > 0 && ahead < prefetch_end) {
+        gather_prefetch_row(
+            &src_data[indices_accessor[ahead] * ddim],
+            ddim * sizeof(T),
+            gather_opt.prefetch_max_lines);
+      }
+    };
     for (int64_t i = start; i < end; i++) {
       auto* out_data_ptr = &output_data[i * ddim];
       auto inputs_start = offsets_data[i];
       auto inputs_end = i == last_offset ? last_index : offsets_data[i + 1];
       if (inputs_end - inputs_start == 1) {
+        prefetch(inputs_start);
         T* select_data_ptr = &src_data[indices_accessor[inputs_start] * ddim];
         move_ker(out_data_ptr, select_data_ptr, ddim);
       } else {
@@ -75,6 +90,7 @@ static inline Tensor _embedding_bag_index_add_select_fast(
         acc_t temp_out[ddim];
         zero_ker(temp_out, ddim);
         for (int64_t s = inputs_start; s < inputs_end; s++) {
+          prefetch(s);
           T* select_data_ptr = &src_data[indices_accessor[s] * ddim];
           add_ker(temp_out, select_data_ptr, ddim);
         }
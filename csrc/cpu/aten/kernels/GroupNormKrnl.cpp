@@ -29,6 +29,81 @@ namespace cpu {
 
 namespace {
 
+// Y = (act(Y) + residual) * output_scale
+template <typename T, GroupNormActivation act>
+void ApplyPostOpImpl(
+    T* Y_ptr,
+    const T* R_ptr,
+    int64_t len,
+    double output_scale) {
+  auto act_fn = [](auto x) {
+    using fVec = decltype(x);
+    if constexpr (act == GroupNormActivation::SiLU) {
+      return x / (fVec(1) + x.neg().exp());
+    } else if constexpr (act == GroupNormActivation::GELU) {
+      return fVec(0.5) * x * (fVec(1) + (x * fVec(M_SQRT1_2)).erf());
+    } else if constexpr (act == GroupNormActivation::GELUTanh) {
+      const fVec kBeta(M_SQRT2 * M_2_SQRTPI * 0.5);
+      const fVec kKappa(0.044715);
+      auto inner = kBeta * (x + kKappa * x * x * x);
+      return fVec(0.5) * x * (fVec(1) + inner.tanh());
+    } else {
+      return x;
+    }
+  };
+  if (R_ptr != nullptr) {
+    at::vec::map2<T>(
+        [&](auto y, auto r) {
+          return (act_fn(y) + r) * decltype(y)(output_scale);
+        },
+        Y_ptr,
+        Y_ptr,
+        R_ptr,
+        len);
+  } else if (act != GroupNormActivation::None || output_scale != 1.0) {
+    at::vec::map<T>(
+        [&](auto y) { return act_fn(y) * decltype(y)(output_scale); },
+        Y_ptr,
+        Y_ptr,
+        len);
+  }
+}
+
+// Apply the post op on Y_data[offset, offset + len) right after it is
+// normalized, so that it is still in cache.
+template <typename T>
+inline void ApplyPostOp(
+    const GroupNormPostOp* post_op,
+    T* Y_data,
+    int64_t offset,
+    int64_t len) {
+  if (post_op == nullptr) {
+    return;
+  }
+  T* Y_ptr = Y_data + offset;
+  const T* R_ptr = post_op->residual.defined()
+      ? post_op->residual.data_ptr<T>() + offset
+      : nullptr;
+  switch (post_op->activation) {
+    case GroupNormActivation::None:
+      ApplyPostOpImpl<T, GroupNormActivation::None>(
+          Y_ptr, R_ptr, len, post_op->output_scale);
+      break;
+    case GroupNormActivation::SiLU:
+      ApplyPostOpImpl<T, GroupNormActivation::SiLU>(
+          Y_ptr, R_ptr, len, post_op->output_scale);
+      break;
+    case GroupNormActivation::GELU:
+      ApplyPostOpImpl<T, GroupNormActivation::GELU>(
+          Y_ptr, R_ptr, len, post_op->output_scale);
+      break;
+    case GroupNormActivation::GELUTanh:
+      ApplyPostOpImpl<T, GroupNormActivation::GELUTanh>(
+          Y_ptr, R_ptr, len, post_op->output_scale);
+      break;
+  }
+}
+
 template <typename T, typename PT>
 void GroupNormKernelImplInternal(
     const at::Tensor& X,
@@ -41,7 +116,8 @@ void GroupNormKernelImplInternal(
     double eps,
     at::Tensor& Y,
     at::Tensor& mean,
-    at::Tensor& rstd) {
+    at::Tensor& rstd,
+    const GroupNormPostOp* post_op = nullptr) {
   TORCH_CHECK(X.numel() == N * C * HxW);
   TORCH_CHECK(!gamma.defined() || gamma.numel() == C);
   TORCH_CHECK(!beta.defined() || beta.numel() == C);
@@ -72,6 +148,7 @@ void GroupNormKernelImplInternal(
         for (const auto j : c10::irange(inner_size)) {
           Y_ptr[j] = (X_ptr[j] - mean_val) * rstd_val;
         }
+        ApplyPostOp(post_op, Y_data, i * inner_size, inner_size);
       } else {
         const int64_t g = i % G;
         for (const auto j : c10::irange(D)) {
@@ -85,6 +162,7 @@ void GroupNormKernelImplInternal(
           for (const auto k : c10::irange(HxW)) {
             Y_ptr[k] = scale * X_ptr[k] + bias;
           }
+          ApplyPostOp(post_op, Y_data, (i * D + j) * HxW, HxW);
         }
       }
       mean_data[i] = mean_val;
@@ -306,7 +384,8 @@ void GroupNormKernelImplChannelsLastInternal(
     double eps,
     at::Tensor& Y,
     at::Tensor& mean,
-    at::Tensor& rstd) {
+    at::Tensor& rstd,
+    const GroupNormPostOp* post_op = nullptr) {
   TORCH_CHECK(X.numel() == N * C * HxW);
   TORCH_CHECK(!gamma.defined() || gamma.numel() == C);
   TORCH_CHECK(!beta.defined() || beta.numel() == C);
@@ -388,6 +467,7 @@ void GroupNormKernelImplChannelsLastInternal(
           const T* X_ptr = X_data + n * HxW * C + m * C + g * D;
           T* Y_ptr = Y_data + n * HxW * C + m * C + g * D;
           ApplyScaleBias<T, opmath_t>(Y_ptr, X_ptr, scale_ptr, bias_ptr, D);
+          ApplyPostOp(post_op, Y_data, n * HxW * C + m * C + g * D, D);
         }
         at::native::data_index_step(n, N, g, G);
       }
@@ -498,13 +578,14 @@ void GroupNormKernelImplChannelsLastInternal(
         opmath_t* scale_ptr = buffer_data + n * 2 * C;
         opmath_t* bias_ptr = scale_ptr + C;
         ApplyScaleBias<T, opmath_t>(Y_ptr, X_ptr, scale_ptr, bias_ptr, C);
+        ApplyPostOp(post_op, Y_data, i * C, C);
         at::native::data_index_step(n, N, m, HxW);
       }
     });
   }
 }
 
-void GroupNormKernelImpl(
+void GroupNormForward(
     const at::Tensor& X,
     const at::Tensor& gamma,
     const at::Tensor& beta,
@@ -515,7 +596,8 @@ void GroupNormKernelImpl(
     double eps,
     at::Tensor& Y,
     at::Tensor& mean,
-    at::Tensor& rstd) {
+    at::Tensor& rstd,
+    const GroupNormPostOp* post_op) {
   const bool mixed_type = at::native::is_mixed_type(X, gamma, beta);
   switch (X.suggest_memory_format()) {
     case at::MemoryFormat::Contiguous: {
@@ -529,18 +611,62 @@ void GroupNormKernelImpl(
             if (!is_channels_last_1d(X)) {
               if (mixed_type) {
                 GroupNormKernelImplInternal<scalar_t, param_t>(
-                    X, gamma, beta, N, C, HxW, group, eps, Y, mean, rstd);
+                    X,
+                    gamma,
+                    beta,
+                    N,
+                    C,
+                    HxW,
+                    group,
+                    eps,
+                    Y,
+                    mean,
+                    rstd,
+                    post_op);
               } else {
                 GroupNormKernelImplInternal<scalar_t, scalar_t>(
-                    X, gamma, beta, N, C, HxW, group, eps, Y, mean, rstd);
+                    X,
+                    gamma,
+                    beta,
+                    N,
+                    C,
+                    HxW,
+                    group,
+                    eps,
+                    Y,
+                    mean,
+                    rstd,
+                    post_op);
               }
             } else {
               if (mixed_type) {
                 GroupNormKernelImplChannelsLastInternal<scalar_t, param_t>(
-                    X, gamma, beta, N, C, HxW, group, eps, Y, mean, rstd);
+                    X,
+                    gamma,
+                    beta,
+                    N,
+                    C,
+                    HxW,
+                    group,
+                    eps,
+                    Y,
+                    mean,
+                    rstd,
+                    post_op);
               } else {
                 GroupNormKernelImplChannelsLastInternal<scalar_t, scalar_t>(
-                    X, gamma, beta, N, C, HxW, group, eps, Y, mean, rstd);
+                    X,
+                    gamma,
+                    beta,
+                    N,
+                    C,
+                    HxW,
+                    group,
+                    eps,
+                    Y,
+                    mean,
+                    rstd,
+                    post_op);
               }
             }
           });
@@ -557,10 +683,32 @@ void GroupNormKernelImpl(
             using param_t = at::opmath_type<scalar_t>;
             if (mixed_type) {
               GroupNormKernelImplChannelsLastInternal<scalar_t, param_t>(
-                  X, gamma, beta, N, C, HxW, group, eps, Y, mean, rstd);
+                  X,
+                  gamma,
+                  beta,
+                  N,
+                  C,
+                  HxW,
+                  group,
+                  eps,
+                  Y,
+                  mean,
+                  rstd,
+                  post_op);
             } else {
               GroupNormKernelImplChannelsLastInternal<scalar_t, scalar_t>(
-                  X, gamma, beta, N, C, HxW, group, eps, Y, mean, rstd);
+                  X,
+                  gamma,
+                  beta,
+                  N,
+                  C,
+                  HxW,
+                  group,
+                  eps,
+                  Y,
+                  mean,
+                  rstd,
+                  post_op);
             }
           });
       break;
@@ -572,6 +720,39 @@ void GroupNormKernelImpl(
   }
 }
 
+void GroupNormKernelImpl(
+    const at::Tensor& X,
+    const at::Tensor& gamma,
+    const at::Tensor& beta,
+    int64_t N,
+    int64_t C,
+    int64_t HxW,
+    int64_t group,
+    double eps,
+    at::Tensor& Y,
+    at::Tensor& mean,
+    at::Tensor& rstd) {
+  GroupNormForward(
+      X, gamma, beta, N, C, HxW, group, eps, Y, mean, rstd, nullptr);
+}
+
+void GroupNormActKernelImpl(
+    const at::Tensor& X,
+    const at::Tensor& gamma,
+    const at::Tensor& beta,
+    int64_t N,
+    int64_t C,
+    int64_t HxW,
+    int64_t group,
+    double eps,
+    const GroupNormPostOp& post_op,
+    at::Tensor& Y,
+    at::Tensor& mean,
+    at::Tensor& rstd) {
+  GroupNormForward(
+      X, gamma, beta, N, C, HxW, group, eps, Y, mean, rstd, &post_op);
+}
+
 template <typename T, typename opmath_t>
 typename std::enable_if<std::is_same<T, opmath_t>::value, void>::type
 ComputeInternalGradients(
@@ -1737,6 +1918,7 @@ void GroupNormBackwardKernelImpl(
 } // namespace
 
 IPEX_REGISTER_DISPATCH(GroupNormKernel, &GroupNormKernelImpl);
+IPEX_REGISTER_DISPATCH(GroupNormActKernel, &GroupNormActKernelImpl);
 IPEX_REGISTER_DISPATCH(GroupNormBackwardKernel, &GroupNormBackwardKernelImpl);
 
 } // namespace cpu
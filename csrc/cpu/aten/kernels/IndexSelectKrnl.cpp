@@ -15,6 +15,7 @@
 #include <utils/library.h>
 
 #include <aten/TensorAdvancedIndexing.h>
+#include "vec/vec.h"
 
 namespace torch_ipex {
 namespace cpu {
@@ -60,12 +61,17 @@ static void index_select_firstdim_impl(
     scalar_t* result_data,
     scalar_t* self_data,
     index_t* index_data,
+    int64_t dim_size,
     int64_t index_size,
     int64_t inner_size) {
   constexpr int64_t grain_size = at::internal::GRAIN_SIZE / 2;
   if (inner_size > grain_size) {
     constexpr int64_t block_size = 2048;
     int64_t num_blocks = at::divup(inner_size, block_size);
+    // Rows are long enough for the hardware prefetcher, only the output
+    // streaming is worth doing here.
+    const bool streaming = kernel::gather_use_streaming_store(
+        index_size * inner_size * sizeof(scalar_t), kernel::gather_options());
     at::parallel_for(
         0,
         index_size * num_blocks,
@@ -82,27 +88,45 @@ static void index_select_firstdim_impl(
                 self_data + offset * inner_size + inner_idx_begin;
             scalar_t* result_ptr =
                 result_data + j * inner_size + inner_idx_begin;
-            copy_stub(result_ptr, self_ptr, size);
+            if (streaming) {
+              kernel::gather_stream_row(result_ptr, self_ptr, size);
+            } else {
+              copy_stub(result_ptr, self_ptr, size);
+            }
+          }
+          if (streaming) {
+            kernel::gather_stream_fence();
           }
         });
   } else {
+    // Small rows: the copy is latency bound on the random row reads, so run
+    // it through the gather engine with prefetch, streaming stores for large
+    // outputs and page-ordered visiting for long index lists over big tables.
+    const auto& opt = kernel::gather_options();
+    const int64_t row_bytes = inner_size * sizeof(scalar_t);
+    std::vector<int64_t> order;
+    if (kernel::gather_use_page_grouping(
+            index_size, row_bytes, dim_size * row_bytes, opt)) {
+      order = kernel::gather_page_order(index_data, index_size, row_bytes);
+    }
+    // Page order scatters the writes, which defeats streaming stores.
+    const bool streaming = order.empty() &&
+        kernel::gather_use_streaming_store(index_size * row_bytes, opt);
     at::parallel_for(
         0,
         index_size,
         grain_size / inner_size,
         [&](int64_t begin, int64_t end) {
-          for (const auto j : c10::irange(begin, end)) {
-            index_t offset = index_data[j];
-#ifdef __GNUC__
-            if (j + 1 < index_size) {
-              __builtin_prefetch(
-                  self_data + index_data[j + 1] * inner_size, 0, 1);
-            }
-#endif // __GNUC__
-            scalar_t* self_ptr = self_data + offset * inner_size;
-            scalar_t* result_ptr = result_data + j * inner_size;
-            copy_stub(result_ptr, self_ptr, inner_size);
-          }
+          kernel::gather_rows(
+              result_data,
+              self_data,
+              index_data,
+              order.empty() ? nullptr : order.data(),
+              begin,
+              end,
+              inner_size,
+              streaming,
+              opt);
         });
   }
 }
@@ -244,7 +268,7 @@ void cpu_index_select_dispatch(
         result_data, self_data, index_data, outer_size, dim_size, index_size);
   } else if (outer_size == 1) {
     index_select_firstdim_impl<scalar_t, index_t>(
-        result_data, self_data, index_data, index_size, inner_size);
+        result_data, self_data, index_data, dim_size, index_size, inner_size);
   } else {
     index_select_non_firstdim_impl<scalar_t, index_t>(
         result_data,
@@ -0,0 +1,351 @@
+#include <ATen/ATen.h>
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec/functional.h>
+#include <ATen/cpu/vec/vec.h>
+#include <c10/util/irange.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <aten/InvertedResidual.h>
+#include "vec/vec.h"
+
+namespace torch_ipex {
+namespace cpu {
+
+namespace {
+
+using Vec = at::vec::Vectorized<float>;
+
+// Per thread working set of a tile: the expanded rows feeding the depthwise
+// conv, the depthwise output of the tile and one projected output row.
+constexpr int64_t kTileBytes = 1024 * 1024;
+// Fewer rows per tile make the expand conv of the halo rows dominate
+constexpr int64_t kMinTileRows = 2;
+
+void apply_activation(float* data, int64_t len, const BlockActivation& act) {
+  const Vec alpha(act.alpha);
+  const Vec beta(act.beta);
+  const Vec zero(0.f);
+  const Vec one(1.f);
+  switch (act.kind) {
+    case BlockEltwise::None:
+      break;
+    case BlockEltwise::ReLU:
+      for (int64_t i = 0; i < len; i += Vec::size()) {
+        Vec x = Vec::loadu(data + i);
+        Vec::blendv(x * alpha, x, x > zero).store(data + i);
+      }
+      break;
+    case BlockEltwise::Clip:
+      for (int64_t i = 0; i < len; i += Vec::size()) {
+        at::vec::clamp(Vec::loadu(data + i), alpha, beta).store(data + i);
+      }
+      break;
+    case BlockEltwise::Swish:
+      for (int64_t i = 0; i < len; i += Vec::size()) {
+        Vec x = Vec::loadu(data + i);
+        (x / (one + (zero - alpha * x).exp())).store(data + i);
+      }
+      break;
+    case BlockEltwise::HardSwish:
+      for (int64_t i = 0; i < len; i += Vec::size()) {
+        Vec x = Vec::loadu(data + i);
+        (x * at::vec::clamp(at::vec::fmadd(alpha, x, beta), zero, one))
+            .store(data + i);
+      }
+      break;
+  }
+}
+
+// kBlockM x kBlockN vectors of the output of pointwise_conv, accumulated in
+// registers.
+template <typename T, int64_t kBlockM, int64_t kBlockN>
+inline void pointwise_conv_block(
+    const T* const* a,
+    const float* weight,
+    const float* bias,
+    float* dst,
+    int64_t rows,
+    int64_t K,
+    int64_t N) {
+  constexpr int64_t kVecLen = Vec::size();
+  Vec acc[kBlockM][kBlockN];
+  for (const auto j : c10::irange(kBlockN)) {
+    Vec b = Vec::loadu(bias + j * kVecLen);
+    for (const auto i : c10::irange(kBlockM)) {
+      acc[i][j] = b;
+    }
+  }
+  for (int64_t k = 0; k < K; k++) {
+    Vec w[kBlockN];
+    for (const auto j : c10::irange(kBlockN)) {
+      w[j] = Vec::loadu(weight + k * N + j * kVecLen);
+    }
+    for (const auto i : c10::irange(kBlockM)) {
+      Vec x(static_cast<float>(a[i][k]));
+      for (const auto j : c10::irange(kBlockN)) {
+        acc[i][j] = at::vec::fmadd(x, w[j], acc[i][j]);
+      }
+    }
+  }
+  for (const auto i : c10::irange(rows)) {
+    for (const auto j : c10::irange(kBlockN)) {
+      acc[i][j].store(dst + i * N + j * kVecLen);
+    }
+  }
+}
+
+// 1x1 convolution of M pixels as a GEMM:
+//   dst[m, n] = bias[n] + sum_k src[m * lda + k] * weight[k, n]
+// N, the row length of weight/bias/dst, is a multiple of kBlockChannelAlign.
+template <typename T>
+void pointwise_conv(
+    const T* src,
+    int64_t lda,
+    const float* weight,
+    const float* bias,
+    float* dst,
+    int64_t M,
+    int64_t K,
+    int64_t N) {
+  constexpr int64_t kBlockM = 4;
+  constexpr int64_t kVecLen = Vec::size();
+  static_assert(
+      kBlockChannelAlign % kVecLen == 0,
+      "padded channels must be a multiple of the vector length");
+  for (int64_t m = 0; m < M; m += kBlockM) {
+    // Rows beyond M repeat the last row and are not stored
+    const T* a[kBlockM];
+    for (const auto i : c10::irange(kBlockM)) {
+      a[i] = src + std::min(m + i, M - 1) * lda;
+    }
+    const int64_t rows = std::min(kBlockM, M - m);
+    int64_t n = 0;
+    for (; n + 2 * kVecLen <= N; n += 2 * kVecLen) {
+      pointwise_conv_block<T, kBlockM, 2>(
+          a, weight + n, bias + n, dst + m * N + n, rows, K, N);
+    }
+    if (n < N) {
+      pointwise_conv_block<T, kBlockM, 1>(
+          a, weight + n, bias + n, dst + m * N + n, rows, K, N);
+    }
+  }
+}
+
+template <typename T>
+void inverted_residual_kernel(
+    const at::Tensor& input,
+    const InvertedResidualParams& params,
+    at::Tensor& output) {
+  const int64_t batch = input.size(0);
+  const int64_t in_channels = input.size(1);
+  const int64_t height = input.size(2);
+  const int64_t width = input.size(3);
+  const int64_t hidden = params.hidden_channels;
+  const int64_t hidden_pad = params.dw_bias.size(0);
+  const int64_t out_channels = params.out_channels;
+  const int64_t out_pad = params.project_bias.size(0);
+  const int64_t out_height = output.size(2);
+  const int64_t out_width = output.size(3);
+  const int64_t kernel_h = params.dw_weight.size(0);
+  const int64_t kernel_w = params.dw_weight.size(1);
+  const int64_t stride_h = params.dw_stride[0];
+  const int64_t stride_w = params.dw_stride[1];
+  const int64_t pad_h = params.dw_padding[0];
+  const int64_t pad_w = params.dw_padding[1];
+  const int64_t dilation_h = params.dw_dilation[0];
+  const int64_t dilation_w = params.dw_dilation[1];
+
+  auto in_rows = [&](int64_t rows) {
+    return std::min(
+        (rows - 1) * stride_h + (kernel_h - 1) * dilation_h + 1, height);
+  };
+  auto tile_floats = [&](int64_t rows) {
+    return (in_rows(rows) * width + rows * out_width) * hidden_pad +
+        out_width * out_pad;
+  };
+
+  // As many output rows per tile as fit the cache budget, but no more than
+  // needed to give every thread a tile.
+  const int64_t num_threads = at::get_num_threads();
+  int64_t tile_rows = out_height;
+  while (tile_rows > 1 &&
+         tile_floats(tile_rows) * (int64_t)sizeof(float) > kTileBytes) {
+    tile_rows--;
+  }
+  const int64_t rows_per_thread = at::divup(batch * out_height, num_threads);
+  tile_rows = std::min(
+      tile_rows, std::max(rows_per_thread, std::min(kMinTileRows, tile_rows)));
+  const int64_t tiles_per_image = at::divup(out_height, tile_rows);
+
+  const int64_t buffer_size = tile_floats(tile_rows);
+  auto buffer = at::empty({num_threads, buffer_size}, at::kFloat);
+  float* buffer_data = buffer.data_ptr<float>();
+
+  const T* input_data = input.data_ptr<T>();
+  T* output_data = output.data_ptr<T>();
+  const float* expand_weight = params.expand_weight.data_ptr<float>();
+  const float* expand_bias = params.expand_bias.data_ptr<float>();
+  const float* dw_weight = params.dw_weight.data_ptr<float>();
+  const float* dw_bias = params.dw_bias.data_ptr<float>();
+  const float* project_weight = params.project_weight.data_ptr<float>();
+  const float* project_bias = params.project_bias.data_ptr<float>();
+
+  at::parallel_for(
+      0, batch * tiles_per_image, 1, [&](int64_t begin, int64_t end) {
+        float* expanded = buffer_data + at::get_thread_num() * buffer_size;
+        float* dw_out = expanded + in_rows(tile_rows) * width * hidden_pad;
+        float* out_row = dw_out + tile_rows * out_width * hidden_pad;
+        std::vector<float> residual_row(out_channels);
+        // (offset in expanded, offset in dw_weight) of the valid taps
+        std::vector<std::pair<int64_t, int64_t>> taps;
+        taps.reserve(kernel_h * kernel_w);
+
+        for (const auto task : c10::irange(begin, end)) {
+          const int64_t n = task / tiles_per_image;
+          const int64_t oh_begin = (task % tiles_per_image) * tile_rows;
+          const int64_t oh_end = std::min(oh_begin + tile_rows, out_height);
+          const int64_t ih_begin =
+              std::max<int64_t>(oh_begin * stride_h - pad_h, 0);
+          const int64_t ih_end = std::min(
+              (oh_end - 1) * stride_h - pad_h + (kernel_h - 1) * dilation_h + 1,
+              height);
+          const T* image = input_data + n * height * width * in_channels;
+
+          // expand: the input rows needed by the tile, with halo
+          if (ih_end > ih_begin) {
+            const int64_t pixels = (ih_end - ih_begin) * width;
+            pointwise_conv<T>(
+                image + ih_begin * width * in_channels,
+                in_channels,
+                expand_weight,
+                expand_bias,
+                expanded,
+                pixels,
+                in_channels,
+                hidden_pad);
+            apply_activation(expanded, pixels * hidden_pad, params.expand_act);
+          }
+
+          for (const auto oh : c10::irange(oh_begin, oh_end)) {
+            // depthwise
+            float* dw_row = dw_out + (oh - oh_begin) * out_width * hidden_pad;
+            for (const auto ow : c10::irange(out_width)) {
+              taps.clear();
+              for (const auto kh : c10::irange(kernel_h)) {
+                const int64_t ih = oh * stride_h - pad_h + kh * dilation_h;
+                if (ih < 0 || ih >= height) {
+                  continue;
+                }
+                for (const auto kw : c10::irange(kernel_w)) {
+                  const int64_t iw = ow * stride_w - pad_w + kw * dilation_w;
+                  if (iw < 0 || iw >= width) {
+                    continue;
+                  }
+                  taps.emplace_back(
+                      ((ih - ih_begin) * width + iw) * hidden_pad,
+                      (kh * kernel_w + kw) * hidden_pad);
+                }
+              }
+              float* dst = dw_row + ow * hidden_pad;
+              for (int64_t c = 0; c < hidden_pad; c += Vec::size()) {
+                Vec acc = Vec::loadu(dw_bias + c);
+                for (const auto& tap : taps) {
+                  acc = at::vec::fmadd(
+                      Vec::loadu(expanded + tap.first + c),
+                      Vec::loadu(dw_weight + tap.second + c),
+                      acc);
+                }
+                acc.store(dst + c);
+              }
+            }
+            apply_activation(dw_row, out_width * hidden_pad, params.dw_act);
+
+            // project, with the residual added in fp32
+            pointwise_conv<float>(
+                dw_row,
+                hidden_pad,
+                project_weight,
+                project_bias,
+                out_row,
+                out_width,
+                hidden,
+                out_pad);
+            apply_activation(out_row, out_width * out_pad, params.project_act);
+            const int64_t offset = (n * out_height + oh) * out_width;
+            for (const auto ow : c10::irange(out_width)) {
+              float* src = out_row + ow * out_pad;
+              if (params.residual) {
+                at::vec::convert(
+                    input_data + (offset + ow) * in_channels,
+                    residual_row.data(),
+                    out_channels);
+                at::vec::map2<float>(
+                    [&](Vec x, Vec y) {
+                      return at::vec::fmadd(Vec(params.residual_alpha), y, x);
+                    },
+                    src,
+                    src,
+                    residual_row.data(),
+                    out_channels);
+              }
+              at::vec::convert(
+                  src,
+                  output_data + (offset + ow) * out_channels,
+                  out_channels);
+            }
+          }
+        }
+      });
+}
+
+at::Tensor inverted_residual_kernel_impl(
+    const at::Tensor& input,
+    const InvertedResidualParams& params) {
+  TORCH_CHECK(
+      input.dim() == 4 && input.is_contiguous(at::MemoryFormat::ChannelsLast),
+      "inverted_residual: expect a 4D channels last input");
+  TORCH_CHECK(
+      params.expand_weight.size(0) == input.size(1),
+      "inverted_residual: input channels mismatch");
+  TORCH_CHECK(
+      !params.residual || params.out_channels == input.size(1),
+      "inverted_residual: residual requires in_channels == out_channels");
+  const int64_t kernel_h = params.dw_weight.size(0);
+  const int64_t kernel_w = params.dw_weight.size(1);
+  const int64_t out_height = (input.size(2) + 2 * params.dw_padding[0] -
+                              params.dw_dilation[0] * (kernel_h - 1) - 1) /
+          params.dw_stride[0] +
+      1;
+  const int64_t out_width = (input.size(3) + 2 * params.dw_padding[1] -
+                             params.dw_dilation[1] * (kernel_w - 1) - 1) /
+          params.dw_stride[1] +
+      1;
+  TORCH_CHECK(
+      !params.residual ||
+          (out_height == input.size(2) && out_width == input.size(3)),
+      "inverted_residual: residual requires the same input and output size");
+
+  auto output = at::empty(
+      {input.size(0), params.out_channels, out_height, out_width},
+      input.options().memory_format(at::MemoryFormat::ChannelsLast));
+  if (output.numel() == 0) {
+    return output;
+  }
+  AT_DISPATCH_FLOATING_TYPES_AND(
+      at::ScalarType::BFloat16,
+      input.scalar_type(),
+      "inverted_residual_kernel_impl",
+      [&] { inverted_residual_kernel<scalar_t>(input, params, output); });
+  return output;
+}
+
+} // anonymous namespace
+
+IPEX_REGISTER_DISPATCH(
+    inverted_residual_kernel_stub,
+    &inverted_residual_kernel_impl);
+
+} // namespace cpu
+} // namespace torch_ipex
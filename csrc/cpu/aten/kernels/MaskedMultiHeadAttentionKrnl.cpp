@@ -1,9 +1,13 @@
 #include <ATen/Tensor.h>
 #include <aten/FlashAttention.h>
 #include <aten/MaskedMultiHeadAttention.h>
+#include <aten/TreeAttention.h>
 #include <torch/all.h>
 #include <torch/csrc/autograd/function.h>
+#include <cstring>
 #include <limits>
+#include "utils/kernel_counters.h"
+#include "utils/long_lived_alloc.h"
 #include "vec/vec.h"
 
 namespace torch_ipex {
@@ -114,6 +118,60 @@ void reduce_head(
   }
   return;
 }
+#elif defined(CPU_CAPABILITY_AVX2)
+// 256-bit versions share the kernels of the paged attention, see
+// vec/vec256/perf_kernel/add_softmax.h
+template <>
+void reduce_head(
+    const float* q_ptr_start,
+    const float* k_ptr_start,
+    float* attn_w_pos,
+    int64_t head_size,
+    bool store_key,
+    float* k_cache_start) {
+  torch_ipex::cpu::kernel::_reduce_head<float, float, float>(
+      q_ptr_start,
+      k_ptr_start,
+      attn_w_pos,
+      head_size,
+      store_key,
+      k_cache_start);
+}
+
+template <>
+void reduce_head(
+    const at::BFloat16* q_ptr_start,
+    const at::BFloat16* k_ptr_start,
+    float* attn_w_pos,
+    int64_t head_size,
+    bool store_key,
+    at::BFloat16* k_cache_start) {
+  torch_ipex::cpu::kernel::
+      _reduce_head<at::BFloat16, at::BFloat16, at::BFloat16>(
+          q_ptr_start,
+          k_ptr_start,
+          attn_w_pos,
+          head_size,
+          store_key,
+          k_cache_start);
+}
+
+template <>
+void reduce_head(
+    const at::Half* q_ptr_start,
+    const at::Half* k_ptr_start,
+    float* attn_w_pos,
+    int64_t head_size,
+    bool store_key,
+    at::Half* k_cache_start) {
+  torch_ipex::cpu::kernel::_reduce_head<at::Half, at::Half, at::Half>(
+      q_ptr_start,
+      k_ptr_start,
+      attn_w_pos,
+      head_size,
+      store_key,
+      k_cache_start);
+}
 #endif
 
 #if defined(CPU_CAPABILITY_AVX512_FP16)
@@ -411,6 +469,99 @@ void mul_attenion_weights_and_value_of_head(
   }
   return;
 }
+#elif defined(CPU_CAPABILITY_AVX2)
+template <>
+void mul_attenion_weights_and_value_of_head(
+    float& attn_w,
+    const float* v_ptr_start,
+    float* attn_out_start,
+    int64_t head_size,
+    bool store_value,
+    float* v_cache_start,
+    bool accumulate) {
+  torch_ipex::cpu::kernel::_mul_and_accumulate<float, float, float>(
+      attn_w,
+      v_ptr_start,
+      attn_out_start,
+      head_size,
+      store_value,
+      v_cache_start,
+      accumulate);
+}
+template <>
+void mul_attenion_weights_and_value_of_head(
+    float& attn_w,
+    const at::BFloat16* v_ptr_start,
+    at::BFloat16* attn_out_start,
+    int64_t head_size,
+    bool store_value,
+    at::BFloat16* v_cache_start,
+    bool accumulate) {
+  torch_ipex::cpu::kernel::
+      _mul_and_accumulate<at::BFloat16, at::BFloat16, at::BFloat16>(
+          attn_w,
+          v_ptr_start,
+          attn_out_start,
+          head_size,
+          store_value,
+          v_cache_start,
+          accumulate);
+}
+template <>
+void mul_attenion_weights_and_value_of_head(
+    float& attn_w,
+    const at::BFloat16* v_ptr_start,
+    float* attn_out_start,
+    int64_t head_size,
+    bool store_value,
+    at::BFloat16* v_cache_start,
+    bool accumulate) {
+  torch_ipex::cpu::kernel::
+      _mul_and_accumulate<at::BFloat16, float, at::BFloat16>(
+          attn_w,
+          v_ptr_start,
+          attn_out_start,
+          head_size,
+          store_value,
+          v_cache_start,
+          accumulate);
+}
+template <>
+void mul_attenion_weights_and_value_of_head(
+    float& attn_w,
+    const at::Half* v_ptr_start,
+    at::Half* attn_out_start,
+    int64_t head_size,
+    bool store_value,
+    at::Half* v_cache_start,
+    bool accumulate) {
+  torch_ipex::cpu::kernel::_mul_and_accumulate<at::Half, at::Half, at::Half>(
+      attn_w,
+      v_ptr_start,
+      attn_out_start,
+      head_size,
+      store_value,
+      v_cache_start,
+      accumulate);
+}
+template <>
+void mul_attenion_weights_and_value_of_head(
+    float& attn_w,
+    const at::Half* v_ptr_start,
+    float* attn_out_start,
+    int64_t head_size,
+    bool store_value,
+    at::Half* v_cache_start,
+    bool accumulate) {
+  torch_ipex::cpu::kernel::_mul_and_accumulate<at::Half, float, at::Half>(
+      attn_w,
+      v_ptr_start,
+      attn_out_start,
+      head_size,
+      store_value,
+      v_cache_start,
+      accumulate);
+}
 #endif
 
 #if defined(CPU_CAPABILITY_AVX512_FP16)
@@ -489,6 +640,17 @@ void copy_key_value(
   }
 }
 
+// Whether the tree mask hides the current token `token` from the query of
+// `row`, the past tokens are always visible.
+inline bool is_tree_masked(
+    const int64_t* tree_mask_ptr,
+    int64_t row,
+    int64_t words,
+    int64_t token) {
+  return tree_mask_ptr != nullptr &&
+      !tree_mask_visible(tree_mask_ptr + row * words, token);
+}
+
 /*
  *The scale-dot product for indirect access kv chache and fuse
  *matmul+div+add+softmax to improve data reuse
@@ -508,6 +670,9 @@ void copy_key_value(
  *@param  head_mask Which is not used by our kernel now.
  *@param  attention_mask Which is combined mask for padding mask and casual
  *mask.
+ *@param  tree_mask Optional int64 bitmask [(batch,) cur_len, words] of the
+ *current tokens each of them attends, for the tree verification of
+ *speculative decoding.
  *@return attn_outs, None, key_cache, value_cache, beam_idx
  */
 template <typename QT, typename VT>
@@ -521,7 +686,8 @@ scale_dot_product_for_indirect_access_kv_cache(
     at::Tensor& beam_idx,
     const int64_t offset,
     const double scale_factor,
-    at::Tensor& attention_mask) {
+    at::Tensor& attention_mask,
+    const at::Tensor& tree_mask) {
   RECORD_FUNCTION(
       "ipex::scale_dot_product_for_indirect_access_kv_cache",
       c10::ArrayRef<c10::IValue>({}));
@@ -544,6 +710,11 @@ scale_dot_product_for_indirect_access_kv_cache(
   auto mask_head_num = attention_mask.size(1);
   auto mask_dim2 = attention_mask.size(2);
   auto mask_bs_stride = mask_head_num * mask_dim2 * seq_len;
+  auto tree_mask_ptr =
+      tree_mask.defined() ? tree_mask.data_ptr<int64_t>() : nullptr;
+  auto tree_mask_words = tree_mask.defined() ? tree_mask.size(-1) : 0;
+  auto tree_mask_bs_rows =
+      tree_mask.defined() && tree_mask.dim() == 3 ? cur_len : 0;
   // value realted
   value = value.contiguous();
   auto attn_outs =
@@ -585,8 +756,14 @@ scale_dot_product_for_indirect_access_kv_cache(
             attn_w_pos[0] = 0.0f;
             auto kc_token_start = ti * kc_token_stride;
             auto kc_t_beam_start = kc_token_start;
-            if (ti > query_ti + offset) { // only caculate the innerproduct for
-                                          // the past token and current token
+            if (ti > query_ti + offset ||
+                (ti >= offset &&
+                 is_tree_masked(
+                     tree_mask_ptr,
+                     bi * tree_mask_bs_rows + query_ti,
+                     tree_mask_words,
+                     ti - offset))) { // only caculate the innerproduct for
+                                      // the past token and current token
               attn_w_pos[0] = -10000.0f;
             } else if (ti == query_ti + offset) { // caculate the innerproduct
                                                   // for the current token and
@@ -626,11 +803,6 @@ scale_dot_product_for_indirect_access_kv_cache(
               } else {
                 kc_t_beam_start = kc_t_beam_start +
                     new_beam_idx[bi][ti] * kv_head * head_size;
-                if (cur_len > 1) {
-                  auto beam_size = beam_batch / bs;
-                  kc_t_beam_start =
-                      kc_t_beam_start + bi * beam_size * kv_head * head_size;
-                }
                 auto kc_head_start =
                     k_cache_ptr + kc_t_beam_start + kv_hi * head_size;
                 reduce_head<QT>(
@@ -660,7 +832,7 @@ scale_dot_product_for_indirect_access_kv_cache(
           auto attn_w_query_start =
               attn_w_ptr + attn_w_stride + query_ti * seq_len;
 // div+add+softmax
-#if defined(CPU_CAPABILITY_AVX512)
+#if defined(CPU_CAPABILITY_AVX512) || defined(CPU_CAPABILITY_AVX2)
           for (auto qi = 0; qi < 1; qi++) {
             auto max_val = -100000.0f;
             torch_ipex::cpu::kernel::
@@ -736,6 +908,20 @@ scale_dot_product_for_indirect_access_kv_cache(
             auto attn_out_start = private_attn_out_ptr + attn_out_head_stride +
                 query_ti * head_size;
 
+            if (vi > query_ti + offset ||
+                (vi >= offset &&
+                 is_tree_masked(
+                     tree_mask_ptr,
+                     bi * tree_mask_bs_rows + query_ti,
+                     tree_mask_words,
+                     vi - offset))) {
+              // not attended, the private row is still initialized on the
+              // first visit as the flag is per head
+              if (flag_access[thread_id][bi][hi] == 0) {
+                torch_ipex::cpu::kernel::zero_ker(attn_out_start, head_size);
+              }
+              continue;
+            }
             auto vc_token_start = vi * kc_token_stride;
             if (vi == query_ti + offset) { // caculate the attention values
                                            // for the current token
@@ -780,11 +966,6 @@ scale_dot_product_for_indirect_access_kv_cache(
               } else {
                 auto vc_t_beam_start =
                     vc_token_start + new_beam_idx[bi][vi] * kv_head * head_size;
-                if (cur_len > 1) {
-                  auto beam_size = beam_batch / bs;
-                  vc_t_beam_start =
-                      vc_t_beam_start + bi * beam_size * kv_head * head_size;
-                }
                 auto v_cache_head_start =
                     v_cache_ptr + vc_t_beam_start + kv_hi * head_size;
                 mul_attenion_weights_and_value_of_head<VT, float>(
@@ -852,7 +1033,8 @@ scale_dot_product_for_indirect_access_kv_cache_half(
     at::Tensor& beam_idx,
     const int64_t offset,
     const double scale_factor,
-    at::Tensor& attention_mask) {
+    at::Tensor& attention_mask,
+    const at::Tensor& tree_mask) {
   RECORD_FUNCTION(
       "ipex::scale_dot_product_for_indirect_access_kv_cache_half",
       c10::ArrayRef<c10::IValue>({}));
@@ -876,6 +1058,11 @@ scale_dot_product_for_indirect_access_kv_cache_half(
   auto mask_head_num = attention_mask.size(1);
   auto mask_dim2 = attention_mask.size(2);
   auto mask_bs_stride = mask_head_num * mask_dim2 * seq_len;
+  auto tree_mask_ptr =
+      tree_mask.defined() ? tree_mask.data_ptr<int64_t>() : nullptr;
+  auto tree_mask_words = tree_mask.defined() ? tree_mask.size(-1) : 0;
+  auto tree_mask_bs_rows =
+      tree_mask.defined() && tree_mask.dim() == 3 ? cur_len : 0;
   // value realted
   value = value.contiguous();
   auto attn_outs =
@@ -917,8 +1104,14 @@ scale_dot_product_for_indirect_access_kv_cache_half(
             attn_w_pos[0] = 0.0f;
             auto kc_token_start = ti * kc_token_stride;
             auto kc_t_beam_start = kc_token_start;
-            if (ti > query_ti + offset) { // only caculate the innerproduct for
-                                          // the past token and current token
+            if (ti > query_ti + offset ||
+                (ti >= offset &&
+                 is_tree_masked(
+                     tree_mask_ptr,
+                     bi * tree_mask_bs_rows + query_ti,
+                     tree_mask_words,
+                     ti - offset))) { // only caculate the innerproduct for
+                                      // the past token and current token
               attn_w_pos[0] = -10000.0f;
             } else if (ti == query_ti + offset) { // caculate the innerproduct
                                                   // for the current token and
@@ -958,11 +1151,6 @@ scale_dot_product_for_indirect_access_kv_cache_half(
               } else {
                 kc_t_beam_start = kc_t_beam_start +
                     new_beam_idx[bi][ti] * kv_head * head_size;
-                if (cur_len > 1) {
-                  auto beam_size = beam_batch / bs;
-                  kc_t_beam_start =
-                      kc_t_beam_start + bi * beam_size * kv_head * head_size;
-                }
                 auto kc_head_start =
                     k_cache_ptr + kc_t_beam_start + kv_hi * head_size;
                 reduce_head_half(
@@ -1042,6 +1230,15 @@ scale_dot_product_for_indirect_access_kv_cache_half(
             auto attn_out_start = private_attn_out_ptr + attn_out_head_stride +
                 query_ti * head_size;
 
+            // hidden by the tree mask, the private rows are zero-initialized
+            if (vi >= offset && vi <= query_ti + offset &&
+                is_tree_masked(
+                    tree_mask_ptr,
+                    bi * tree_mask_bs_rows + query_ti,
+                    tree_mask_words,
+                    vi - offset)) {
+              continue;
+            }
             auto vc_token_start = vi * kc_token_stride;
             if (vi == query_ti + offset) { // caculate the attention values
                                            // for the current token
@@ -1086,11 +1283,6 @@ scale_dot_product_for_indirect_access_kv_cache_half(
               } else {
                 auto vc_t_beam_start =
                     vc_token_start + new_beam_idx[bi][vi] * kv_head * head_size;
-                if (cur_len > 1) {
-                  auto beam_size = beam_batch / bs;
-                  vc_t_beam_start =
-                      vc_t_beam_start + bi * beam_size * kv_head * head_size;
-                }
                 auto v_cache_head_start =
                     v_cache_ptr + vc_t_beam_start + kv_hi * head_size;
                 mul_attenion_weights_and_value_of_head_half(
@@ -1150,7 +1342,8 @@ zero_copy_kv_cache_masked_multihead_self_attention_kernel_impl(
     at::Tensor& beam_idx,
     const int64_t offset,
     const double scale_attn,
-    at::Tensor& attention_mask) {
+    at::Tensor& attention_mask,
+    const at::Tensor& tree_mask) {
   assert(
       key.scalar_type() == at::kBFloat16 || key.scalar_type() == at::kFloat ||
       key.scalar_type() == at::kHalf);
@@ -1164,7 +1357,8 @@ zero_copy_kv_cache_masked_multihead_self_attention_kernel_impl(
         beam_idx,
         offset,
         scale_attn,
-        attention_mask);
+        attention_mask,
+        tree_mask);
   } else if (
       query.scalar_type() == at::kFloat &&
       value.scalar_type() == at::kBFloat16) {
@@ -1177,7 +1371,8 @@ zero_copy_kv_cache_masked_multihead_self_attention_kernel_impl(
         beam_idx,
         offset,
         scale_attn,
-        attention_mask);
+        attention_mask,
+        tree_mask);
   } else if (
       key.scalar_type() == at::kBFloat16 && value.scalar_type() == at::kFloat) {
     return scale_dot_product_for_indirect_access_kv_cache<at::BFloat16, float>(
@@ -1189,7 +1384,8 @@ zero_copy_kv_cache_masked_multihead_self_attention_kernel_impl(
         beam_idx,
         offset,
         scale_attn,
-        attention_mask);
+        attention_mask,
+        tree_mask);
   } else if (
       query.scalar_type() == at::kHalf && value.scalar_type() == at::kHalf) {
 #if defined(CPU_CAPABILITY_AVX512_FP16)
@@ -1202,7 +1398,8 @@ zero_copy_kv_cache_masked_multihead_self_attention_kernel_impl(
         beam_idx,
         offset,
         scale_attn,
-        attention_mask);
+        attention_mask,
+        tree_mask);
 #else
     return scale_dot_product_for_indirect_access_kv_cache<at::Half, at::Half>(
         query,
@@ -1213,7 +1410,8 @@ zero_copy_kv_cache_masked_multihead_self_attention_kernel_impl(
         beam_idx,
         offset,
         scale_attn,
-        attention_mask);
+        attention_mask,
+        tree_mask);
 #endif
   } else if (
       query.scalar_type() == at::kFloat && value.scalar_type() == at::kHalf) {
@@ -1226,7 +1424,8 @@ zero_copy_kv_cache_masked_multihead_self_attention_kernel_impl(
         beam_idx,
         offset,
         scale_attn,
-        attention_mask);
+        attention_mask,
+        tree_mask);
   } else if (
       query.scalar_type() == at::kHalf && value.scalar_type() == at::kFloat) {
     return scale_dot_product_for_indirect_access_kv_cache<at::Half, float>(
@@ -1238,7 +1437,8 @@ zero_copy_kv_cache_masked_multihead_self_attention_kernel_impl(
         beam_idx,
         offset,
         scale_attn,
-        attention_mask);
+        attention_mask,
+        tree_mask);
   }
   return scale_dot_product_for_indirect_access_kv_cache<
       at::BFloat16,
@@ -1251,7 +1451,8 @@ zero_copy_kv_cache_masked_multihead_self_attention_kernel_impl(
       beam_idx,
       offset,
       scale_attn,
-      attention_mask);
+      attention_mask,
+      tree_mask);
 }
 
 std::tuple<at::Tensor, at::Tensor, at::Tensor, at::Tensor, at::Tensor>
@@ -1342,6 +1543,64 @@ first_token_masked_mha(
   return std::make_tuple(
       attn_outputs, attn_weights, key_cache, value_cache, beam_idx);
 }
+
+// The rows of the current tokens, the tree candidates, are [(batch,)
+// cur_len, words], each token attends itself (and no later token) so that its
+// key and value are still stored to the cache.
+void check_tree_mask(
+    const at::Tensor& tree_mask,
+    int64_t bs,
+    int64_t cur_len) {
+  TORCH_CHECK(
+      tree_mask.scalar_type() == at::kLong,
+      "tree_mask should be an int64 bitmask");
+  TORCH_CHECK(
+      (tree_mask.dim() == 2 ||
+       (tree_mask.dim() == 3 && tree_mask.size(0) == bs)) &&
+          tree_mask.size(-2) == cur_len &&
+          tree_mask.size(-1) == (cur_len + 63) / 64,
+      "tree_mask should be of the shape [(batch,) cur_len, (cur_len + 63) / 64]");
+  auto words = tree_mask.size(-1);
+  auto rows = tree_mask.numel() / words;
+  auto mask_ptr = tree_mask.data_ptr<int64_t>();
+  for (auto r = 0; r < rows; r++) {
+    TORCH_CHECK(
+        tree_mask_candidate(mask_ptr + r * words, words) == r % cur_len,
+        "tree_mask: the highest bit of the row of token ",
+        r % cur_len,
+        " should be its own");
+  }
+}
+
+// Minimum traffic of one decode step over the indirect access kv cache for
+// the roofline counters: the cached keys and values of every beam are read
+// once through beam_idx and the new token is appended to the cache.
+utils::KernelTraffic indirect_kv_cache_attention_traffic(
+    const at::Tensor& query,
+    const at::Tensor& key,
+    const at::Tensor& value,
+    const at::Tensor& attention_mask,
+    int64_t offset) {
+  auto bs = query.size(0);
+  auto cur_len = query.size(1);
+  auto head_num = query.size(2);
+  auto head_size = query.size(3);
+  auto kv_head = key.size(2);
+  auto seq_len = offset + cur_len;
+  utils::KernelTraffic traffic;
+  // keys and values of every step plus its beam_idx entry
+  auto kv_token_bytes = kv_head * head_size *
+          (key.element_size() + value.element_size()) +
+      (int64_t)sizeof(int64_t);
+  traffic.kv_bytes = bs * seq_len * kv_token_bytes;
+  traffic.activation_bytes = utils::kernel_tensor_bytes(query) +
+      utils::kernel_tensor_bytes(key) + utils::kernel_tensor_bytes(value) +
+      utils::kernel_tensor_bytes(attention_mask) +
+      bs * head_num * cur_len * head_size * value.element_size();
+  traffic.flops = 4 * bs * head_num * cur_len * seq_len * head_size;
+  return traffic;
+}
+
 std::tuple<at::Tensor, at::Tensor, at::Tensor, at::Tensor, at::Tensor>
 masked_multihead_self_attention_kernel_impl(
     at::Tensor& query,
@@ -1355,7 +1614,8 @@ masked_multihead_self_attention_kernel_impl(
     int64_t max_positions,
     const c10::optional<at::Tensor>& head_mask /* optional */,
     const c10::optional<at::Tensor>& attention_mask /* optional */,
-    c10::optional<bool> add_casual_mask /* optional */) {
+    c10::optional<bool> add_casual_mask /* optional */,
+    const c10::optional<at::Tensor>& tree_mask /* optional */) {
   TORCH_CHECK(
       attention_mask.has_value(),
       "Attention mask is necessary for ipex::masked_multihead_self_attention_kernel_impl");
@@ -1380,12 +1640,20 @@ masked_multihead_self_attention_kernel_impl(
   auto offset = seq_info.data_ptr<long>()[0];
   auto cache_size = key_cache.size(0);
   auto cur_len = query.size(1);
+  at::Tensor tree_mask_v;
+  if (tree_mask.has_value()) {
+    TORCH_CHECK(
+        offset > 0,
+        "tree_mask is only supported for the tokens following the prompt");
+    tree_mask_v = tree_mask.value().contiguous();
+    check_tree_mask(tree_mask_v, query.size(0), cur_len);
+  }
   if (offset == 0) {
     max_positions =
         max_positions > cur_len ? max_positions : max_positions + cur_len;
-    key_cache = at::empty(
+    key_cache = utils::empty_long_lived(
         {max_positions, beam_batch, key.size(2), key.size(3)}, key.options());
-    value_cache = at::empty(
+    value_cache = utils::empty_long_lived(
         {max_positions, beam_batch, value.size(2), value.size(3)},
         value.options());
     beam_idx = at::empty({max_positions, beam_batch}, beam_idx.options());
@@ -1402,9 +1670,9 @@ masked_multihead_self_attention_kernel_impl(
     }
   } else if (offset > 0 && offset + cur_len > cache_size) {
     auto new_cache_size = cache_size * 2;
-    auto new_key_cache = at::empty(
+    auto new_key_cache = utils::empty_long_lived(
         {new_cache_size, beam_batch, key.size(2), key.size(3)}, key.options());
-    auto new_value_cache = at::empty(
+    auto new_value_cache = utils::empty_long_lived(
         {new_cache_size, beam_batch, value.size(2), value.size(3)},
         value.options());
     auto new_beam_idx =
@@ -1424,6 +1692,12 @@ masked_multihead_self_attention_kernel_impl(
     beam_idx = new_beam_idx;
   }
   if (offset > 0) {
+    utils::KernelCounterScope counter(
+        utils::KernelCounterKind::IndirectKVCacheAttention);
+    if (counter.enabled()) {
+      counter.start(indirect_kv_cache_attention_traffic(
+          query, key, value, attention_mask_v, offset));
+    }
     return zero_copy_kv_cache_masked_multihead_self_attention_kernel_impl(
         query,
         key,
@@ -1433,7 +1707,8 @@ masked_multihead_self_attention_kernel_impl(
         beam_idx,
         offset,
         scale_attn,
-        attention_mask_v);
+        attention_mask_v,
+        tree_mask_v);
   } else {
     return first_token_masked_mha(
         query,
@@ -1448,11 +1723,85 @@ masked_multihead_self_attention_kernel_impl(
         add_casual_mask.value_or(true));
   }
 }
+
+void indirect_kv_cache_compact_kernel_impl(
+    at::Tensor& key_cache,
+    at::Tensor& value_cache,
+    at::Tensor& beam_idx,
+    int64_t offset,
+    const at::Tensor& accepted) {
+  RECORD_FUNCTION(
+      "ipex::indirect_kv_cache_compact_kernel_impl",
+      c10::ArrayRef<c10::IValue>({}));
+  TORCH_CHECK(
+      key_cache.is_contiguous() && value_cache.is_contiguous() &&
+          beam_idx.is_contiguous(),
+      "key_cache, value_cache and beam_idx should be contiguous");
+  auto cache_size = key_cache.size(0);
+  auto beam_batch = key_cache.size(1);
+  auto kv_head = key_cache.size(2);
+  auto accepted_v = accepted.to(at::kLong).contiguous();
+  TORCH_CHECK(
+      accepted_v.dim() == 1 ||
+          (accepted_v.dim() == 2 && accepted_v.size(0) == beam_batch),
+      "accepted should be of the shape [num] or [beam_size*batch, num]");
+  auto num = accepted_v.size(-1);
+  auto accepted_bs_stride = accepted_v.dim() == 2 ? num : 0;
+  auto accepted_ptr = accepted_v.data_ptr<int64_t>();
+  for (auto i = 0; i < accepted_v.numel(); i++) {
+    auto k = i % num;
+    TORCH_CHECK(
+        accepted_ptr[i] >= 0 &&
+            (k == 0 || accepted_ptr[i] > accepted_ptr[i - 1]),
+        "accepted should be ascending candidate indices");
+    TORCH_CHECK(
+        offset + accepted_ptr[i] < cache_size,
+        "accepted candidate out of the cache");
+  }
+  auto key_head_bytes = key_cache.size(3) * key_cache.element_size();
+  auto value_head_bytes = value_cache.size(3) * value_cache.element_size();
+  auto key_cache_ptr = static_cast<char*>(key_cache.data_ptr());
+  auto value_cache_ptr = static_cast<char*>(value_cache.data_ptr());
+  // the heads are independent, the tokens of every head move in order as
+  // the target of a move can be the source of an earlier one
+#pragma omp parallel for collapse(2)
+  for (auto bi = 0; bi < beam_batch; bi++) {
+    for (auto hi = 0; hi < kv_head; hi++) {
+      for (auto k = 0; k < num; k++) {
+        auto src = offset + accepted_ptr[bi * accepted_bs_stride + k];
+        auto dst = offset + k;
+        if (src == dst) {
+          continue;
+        }
+        auto src_head = (src * beam_batch + bi) * kv_head + hi;
+        auto dst_head = (dst * beam_batch + bi) * kv_head + hi;
+        std::memcpy(
+            key_cache_ptr + dst_head * key_head_bytes,
+            key_cache_ptr + src_head * key_head_bytes,
+            key_head_bytes);
+        std::memcpy(
+            value_cache_ptr + dst_head * value_head_bytes,
+            value_cache_ptr + src_head * value_head_bytes,
+            value_head_bytes);
+      }
+    }
+  }
+  auto beam_idx_access = beam_idx.accessor<long, 2>();
+  for (auto bi = 0; bi < beam_batch; bi++) {
+    for (auto k = 0; k < num; k++) {
+      auto src = offset + accepted_ptr[bi * accepted_bs_stride + k];
+      beam_idx_access[offset + k][bi] = beam_idx_access[src][bi];
+    }
+  }
+}
 } // anonymous namespace
 
 IPEX_REGISTER_DISPATCH(
     masked_multihead_self_attention_kernel_stub,
     &masked_multihead_self_attention_kernel_impl);
+IPEX_REGISTER_DISPATCH(
+    indirect_kv_cache_compact_kernel_stub,
+    &indirect_kv_cache_compact_kernel_impl);
 
 } // namespace cpu
 } // namespace torch_ipex
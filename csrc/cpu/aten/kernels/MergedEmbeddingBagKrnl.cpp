@@ -18,6 +18,32 @@ namespace {
 using namespace at;
 using namespace torch_ipex::cpu::kernel;
 
+// Issue prefetches for the rows `prefetch_distance` indices ahead of every
+// index of the current bag. The look-ahead runs across bag boundaries up to
+// `prefetch_end`, the end of the indices of the last bag in this block, so the
+// next bag finds its first rows already in flight.
+template <typename data_t, typename index_t>
+inline void prefetch_bag_rows(
+    const index_t* indices,
+    const data_t* weight,
+    int64_t start_idx,
+    int64_t end_idx,
+    int64_t prefetch_end,
+    int64_t emb_dim,
+    const GatherOptions& opt) {
+  for (int64_t j = start_idx; j < end_idx; ++j) {
+    gather_prefetch_ahead(weight, indices, j, prefetch_end, emb_dim, opt);
+  }
+}
+
+template <typename index_t>
+inline int64_t bags_indices_end(
+    const int64_t bs_end,
+    const index_t last_offset,
+    const index_t* offsets) {
+  return last_offset != -1 ? last_offset : offsets[bs_end];
+}
+
 template <typename data_t>
 inline void copy_dense(
     const int64_t bs_bgein,
@@ -50,11 +76,15 @@ typename std::enable_if<
         int64_t result_stride,
         int64_t pooling_mode) {
   using Vec = at::vec::Vectorized<data_t>;
+  const auto& opt = gather_options();
+  const int64_t prefetch_end = bags_indices_end(bs_end, last_offset, offsets);
   auto vec_size = Vec::size();
   for (int64_t b = bs_begin; b < bs_end; ++b) {
     int64_t start_idx = offsets[b];
     int64_t end_idx =
         ((b + 1) == bs_end && last_offset != -1) ? last_offset : offsets[b + 1];
+    prefetch_bag_rows(
+        indices, weight, start_idx, end_idx, prefetch_end, emb_dim, opt);
     // vec
     Vec w_vec;
     int64_t i = 0;
@@ -107,12 +137,16 @@ typename std::enable_if<
         int64_t result_stride,
         int64_t pooling_mode) {
   using lpVec = at::vec::Vectorized<data_t>;
+  const auto& opt = gather_options();
+  const int64_t prefetch_end = bags_indices_end(bs_end, last_offset, offsets);
   using fVec = at::vec::Vectorized<float>;
   auto vec_size = lpVec::size();
   for (int64_t b = bs_begin; b < bs_end; ++b) {
     int64_t start_idx = offsets[b];
     int64_t end_idx =
         ((b + 1) == bs_end && last_offset != -1) ? last_offset : offsets[b + 1];
+    prefetch_bag_rows(
+        indices, weight, start_idx, end_idx, prefetch_end, emb_dim, opt);
     // vec
     fVec f_w_vec1, f_w_vec2;
     int64_t i = 0;
@@ -177,6 +211,9 @@ typename std::enable_if<std::is_same<data_t, float>::value, void>::
   // num_bags = [3,2,1,2,6,1,1,1,1,7,3,8,1,6,9,5,1,1,1,12,100,27,10,3,1,1] for
   // each table
   if (emb_dim == 128) {
+    const auto& opt = gather_options();
+    const int64_t prefetch_end =
+        bags_indices_end(bs_end, last_offset, offsets);
     for (int64_t b = bs_begin; b < bs_end; ++b) {
       __m512 w0[8];
       __m512 wj[8];
@@ -184,6 +221,8 @@ typename std::enable_if<std::is_same<data_t, float>::value, void>::
       int64_t end_idx = ((b + 1) == bs_end && last_offset != -1)
           ? last_offset
           : offsets[b + 1];
+      prefetch_bag_rows(
+          indices, weight, start_idx, end_idx, prefetch_end, emb_dim, opt);
       // load first indices
       int64_t idx = indices[start_idx] * emb_dim;
       compile_time_for<8>::op(load_fp32, w0, &weight[idx]);
@@ -239,6 +278,9 @@ typename std::enable_if<std::is_same<data_t, Half>::value, void>::
   // num_bags = [3,2,1,2,6,1,1,1,1,7,3,8,1,6,9,5,1,1,1,12,100,27,10,3,1,1] for
   // each table
   if (emb_dim == 128) {
+    const auto& opt = gather_options();
+    const int64_t prefetch_end =
+        bags_indices_end(bs_end, last_offset, offsets);
     for (int64_t b = bs_begin; b < bs_end; ++b) {
       __m512i fp16_w0[4], fp16_wj[4];
       __m512 fp32_w0[8], fp32_wj[8];
@@ -246,6 +288,8 @@ typename std::enable_if<std::is_same<data_t, Half>::value, void>::
       int64_t end_idx = ((b + 1) == bs_end && last_offset != -1)
           ? last_offset
           : offsets[b + 1];
+      prefetch_bag_rows(
+          indices, weight, start_idx, end_idx, prefetch_end, emb_dim, opt);
       // load first indices
       int64_t idx = indices[start_idx] * emb_dim;
       compile_time_for<4>::op(
@@ -303,6 +347,9 @@ typename std::enable_if<std::is_same<data_t, BFloat16>::value, void>::
   // num_bags = [3,2,1,2,6,1,1,1,1,7,3,8,1,6,9,5,1,1,1,12,100,27,10,3,1,1] for
   // each table
   if (emb_dim == 128) {
+    const auto& opt = gather_options();
+    const int64_t prefetch_end =
+        bags_indices_end(bs_end, last_offset, offsets);
     for (int64_t b = bs_begin; b < bs_end; ++b) {
       __m512i bf16_w0[4], bf16_wj[4];
       __m512 fp32_w0[8], fp32_wj[8];
@@ -310,6 +357,8 @@ typename std::enable_if<std::is_same<data_t, BFloat16>::value, void>::
       int64_t end_idx = ((b + 1) == bs_end && last_offset != -1)
           ? last_offset
           : offsets[b + 1];
+      prefetch_bag_rows(
+          indices, weight, start_idx, end_idx, prefetch_end, emb_dim, opt);
       // load first indices
       int64_t idx = indices[start_idx] * emb_dim;
       compile_time_for<4>::op(
@@ -1,4 +1,10 @@
+#include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec/functional.h>
+#include <ATen/cpu/vec/vec.h>
+#include <ATen/native/cpu/utils.h>
 #include <aten/MultiHeadAttention.h>
+#include <limits>
 #include "csrc/cpu/tpp/woq/tla.h"
 #include "mkl.h"
 #include "vec/vec.h"
@@ -118,8 +124,11 @@ at::Tensor sd_mha_base_kernel(
     at::BFloat16* query,
     at::BFloat16* key,
     at::BFloat16* value,
+    const int64_t& qStrideB,
     const int64_t& qStride,
+    const int64_t& kStrideB,
     const int64_t& kStride,
+    const int64_t& vStrideB,
     const int64_t& vStride,
     const int64_t& batchSize,
     const int64_t& qSize,
@@ -280,7 +289,7 @@ at::Tensor sd_mha_base_kernel(
               headSize,
               av_gemm_K,
               headSize,
-              kStride,
+              vStride,
               headSize,
               xform_v,
               true),
@@ -292,7 +301,7 @@ at::Tensor sd_mha_base_kernel(
               headSize,
               av_gemm_K_tail,
               headSize,
-              kStride,
+              vStride,
               headSize,
               xform_v,
               true),
@@ -315,15 +324,13 @@ at::Tensor sd_mha_base_kernel(
           // main
           if (headSize % 2 == 0) {
             xform_tpp_k(
-                key + i * kvSize * kStride + headSize * j +
-                    l * kvSplitSize * kStride,
+                key + i * kStrideB + headSize * j + l * kvSplitSize * kStride,
                 key_reorder_ptr + i * num_head * headSize * kvSize +
                     j * headSize * kvSize + l * kvSplitSize * headSize);
           }
           if (kvSplitSize % 2 == 0) {
             xform_tpp_v(
-                value + i * kvSize * vStride + headSize * j +
-                    l * kvSplitSize * vStride,
+                value + i * vStrideB + headSize * j + l * kvSplitSize * vStride,
                 value_reorder_ptr + i * num_head * kvSize * headSize +
                     j * kvSize * headSize + l * kvSplitSize * headSize);
           }
@@ -331,15 +338,13 @@ at::Tensor sd_mha_base_kernel(
           // Tail
           if (headSize % 2 == 0) {
             xform_tpp_k_tail(
-                key + i * kvSize * kStride + headSize * j +
-                    l * kvSplitSize * kStride,
+                key + i * kStrideB + headSize * j + l * kvSplitSize * kStride,
                 key_reorder_ptr + i * num_head * headSize * kvSize +
                     j * headSize * kvSize + l * kvSplitSize * headSize);
           }
           if (kvTail % 2 == 0) {
             xform_tpp_v_tail(
-                value + i * kvSize * vStride + headSize * j +
-                    l * kvSplitSize * vStride,
+                value + i * vStrideB + headSize * j + l * kvSplitSize * vStride,
                 value_reorder_ptr + i * num_head * kvSize * headSize +
                     j * kvSize * headSize + l * kvSplitSize * headSize);
           }
@@ -371,17 +376,16 @@ at::Tensor sd_mha_base_kernel(
                 kvBlockSize,
                 headSize,
                 1.f,
-                (const MKL_BF16*)(query + i * qSize * qStride + headSize * j + k * qSplitSize * qStride),
+                (const MKL_BF16*)(query + i * qStrideB + headSize * j + k * qSplitSize * qStride),
                 qStride,
-                (const MKL_BF16*)(key + i * kvSize * kStride + headSize * j + l * kvSplitSize * kStride),
+                (const MKL_BF16*)(key + i * kStrideB + headSize * j + l * kvSplitSize * kStride),
                 kStride,
                 0.f,
                 qk_fp32_ptr + ompIdx * qSplitSize * kvSplitSize,
                 kvBlockSize);
           } else if (l != kvSlice - 1) {
             qk_gemm_tpp(
-                query + i * qSize * qStride + headSize * j +
-                    k * qSplitSize * qStride,
+                query + i * qStrideB + headSize * j + k * qSplitSize * qStride,
                 key_reorder_ptr + i * num_head * headSize * kvSize +
                     j * headSize * kvSize + l * kvSplitSize * headSize,
                 qk_fp32_ptr + ompIdx * qSplitSize * kvSplitSize,
@@ -390,8 +394,7 @@ at::Tensor sd_mha_base_kernel(
           } else {
             // Tail
             qk_gemm_tpp_tail(
-                query + i * qSize * qStride + headSize * j +
-                    k * qSplitSize * qStride,
+                query + i * qStrideB + headSize * j + k * qSplitSize * qStride,
                 key_reorder_ptr + i * num_head * headSize * kvSize +
                     j * headSize * kvSize + l * kvSplitSize * headSize,
                 qk_fp32_ptr + ompIdx * qSplitSize * kvSplitSize,
@@ -424,7 +427,7 @@ at::Tensor sd_mha_base_kernel(
                 1.f,
                 (const MKL_BF16*)(qk_bf16_ptr + ompIdx * qSplitSize * kvSplitSize),
                 kvBlockSize,
-                (const MKL_BF16*)(value + i * kvSize * vStride + headSize * j + l * kvSplitSize * vStride),
+                (const MKL_BF16*)(value + i * vStrideB + headSize * j + l * kvSplitSize * vStride),
                 vStride,
                 l == 0 ? 0.f : 1.f,
                 dst_fp32_ptr + ompIdx * qSplitSize * headSize,
@@ -476,18 +479,16 @@ at::Tensor sd_mha_base_kernel(
   }
   return output;
 }
-#endif
 
-at::Tensor bert_mha_kernel_impl(
+// Flash Attention kernel for the BERT MHA fusion in BF16, where query, key and
+// value are the three slices of `qkv` [batchSize, sequenceSize, qkvColSize]
+at::Tensor bert_mha_base_kernel(
     const at::Tensor& qkv,
     const at::Tensor& rel_kv,
     const int64_t& num_head,
     const int64_t& headSize,
-    const double& dim_per_head) {
-  TORCH_CHECK(
-      qkv.dtype() == at::kBFloat16,
-      "Currently the BERT MHA fusion only supports BF16 data type.");
-
+    const double& dim_per_head,
+    const int64_t& qSplitSize) {
   int64_t batchSize = qkv.dim() > 2 ? qkv.size(0) : 1;
   int64_t sequenceSize = qkv.dim() > 2 ? qkv.size(1) : qkv.size(0);
   int64_t hiddenSize = num_head * headSize;
@@ -495,14 +496,6 @@ at::Tensor bert_mha_kernel_impl(
   at::Tensor output =
       at::empty({batchSize, sequenceSize, num_head, headSize}, at::kBFloat16);
 
-#if defined(CPU_CAPABILITY_AVX512)
-  int64_t qSplitSize = sequenceSize;
-  for (int i = 0; i < qsplit_ranges.size(); ++i) {
-    if (sequenceSize > qsplit_ranges[i]) {
-      qSplitSize = qsplit_sizes[i];
-      break;
-    }
-  }
   int64_t kvSplitSize =
       sequenceSize >= kvsplit_size ? kvsplit_size : sequenceSize;
 
@@ -557,7 +550,7 @@ at::Tensor bert_mha_kernel_impl(
                   ompIdx * qSplitSize * kvSplitSize,
               dst_fp32.data_ptr<float>() + ompIdx * qSplitSize * headSize,
               rel_kv.data_ptr<at::BFloat16>() + i * sequenceSize +
-                  l * qSplitSize,
+                  l * kvSplitSize,
               qk_max.data_ptr<float>() + ompIdx * qSplitSize,
               qk_sum.data_ptr<float>() + ompIdx * qSplitSize,
               dim_per_head,
@@ -593,76 +586,331 @@ at::Tensor bert_mha_kernel_impl(
     }
   }
   return output;
+}
 #endif
-  auto qkv_mat = dil_mat_split<at::BFloat16>(
-      qkv, at::IntArrayRef({hiddenSize, hiddenSize, hiddenSize}));
-  auto query = qkv_mat[0];
-  auto key = qkv_mat[1];
-  auto value = qkv_mat[2];
-  query.resize_({batchSize, sequenceSize, num_head, headSize}).transpose_(1, 2);
-  key.resize_({batchSize, sequenceSize, num_head, headSize})
-      .transpose_(1, 2)
-      .transpose_(2, 3);
-  value.resize_({batchSize, sequenceSize, num_head, headSize}).transpose_(1, 2);
-
-  auto qk = at::div(at::matmul(query, key), dim_per_head);
-  auto qk_sm = at::softmax(at::add(qk, rel_kv, 1.f), -1);
-  output = at::matmul(qk_sm, value);
-
-  output = output.transpose_(1, 2).contiguous();
+
+// Flash Attention kernel with FP32 accumulation for the data types and hosts
+// the BF16 TPP kernel above does not cover (FP32, FP16, or no AVX512). The
+// scores go through MKL sgemm with the Q/K/V tiles in FP16/BF16 converted to
+// FP32 in the per-thread buffer, and the softmax is built on at::vec, so that
+// it compiles for every ISA. The key and value may come from another source
+// than the query (cross-attention), with their own length and strides.
+// `rel_kv` is an optional additive mask [batchSize, kvSize] in FP32.
+template <typename scalar_t>
+at::Tensor mha_fp32_acc_kernel(
+    const scalar_t* query,
+    const scalar_t* key,
+    const scalar_t* value,
+    const float* rel_kv,
+    const int64_t& qStrideB,
+    const int64_t& qStride,
+    const int64_t& kStrideB,
+    const int64_t& kStride,
+    const int64_t& vStrideB,
+    const int64_t& vStride,
+    const int64_t& batchSize,
+    const int64_t& qSize,
+    const int64_t& kvSize,
+    const int64_t& num_head,
+    const int64_t& headSize,
+    const int64_t& hiddenSize,
+    const double& scale,
+    const int64_t& qsplitSize) {
+  using Vec = at::vec::Vectorized<float>;
+  constexpr bool is_fp32 = std::is_same<scalar_t, float>::value;
+  at::Tensor output = at::empty(
+      {batchSize, qSize, hiddenSize},
+      c10::CppTypeToScalarType<scalar_t>::value);
+
+  int64_t qSplitSize = qSize >= qsplitSize ? qsplitSize : qSize;
+  int64_t kvSplitSize = kvSize >= kvsplit_size ? kvsplit_size : kvSize;
+  int64_t qSlice = (qSize - 1) / qSplitSize + 1;
+  int64_t num_thread = at::get_num_threads();
+
+  // qk, max, sum and dst, plus the FP32 copies of the Q/K/V tiles
+  int64_t size_per_thread = qSplitSize * kvSplitSize + qSplitSize * 2 +
+      qSplitSize * headSize +
+      (is_fp32 ? 0 : (qSplitSize + kvSplitSize * 2) * headSize);
+  at::Tensor buf = at::empty({num_thread, size_per_thread}, at::kFloat);
+  auto buf_data = buf.data_ptr<float>();
+  auto output_ptr = output.data_ptr<scalar_t>();
+  float alpha = scale;
+
+  at::parallel_for(
+      0, batchSize * num_head * qSlice, 1, [&](int64_t begin, int64_t end) {
+        int64_t i = 0, j = 0, k = 0;
+        at::native::data_index_init(
+            begin, i, batchSize, j, num_head, k, qSlice);
+        float* qk_data = buf_data + at::get_thread_num() * size_per_thread;
+        float* qk_max_data = qk_data + qSplitSize * kvSplitSize;
+        float* qk_sum_data = qk_max_data + qSplitSize;
+        float* dst_data = qk_sum_data + qSplitSize;
+        float* q_fp32 = dst_data + qSplitSize * headSize;
+        float* k_fp32 = q_fp32 + qSplitSize * headSize;
+        float* v_fp32 = k_fp32 + kvSplitSize * headSize;
+
+        // Converts a tile of rows to FP32 unless it is FP32 already
+        auto to_fp32 = [&](const scalar_t* src,
+                           int64_t ld,
+                           int64_t rows,
+                           float* tmp,
+                           int64_t& ld_fp32) -> const float* {
+          if constexpr (is_fp32) {
+            ld_fp32 = ld;
+            return src;
+          } else {
+            for (int64_t r = 0; r < rows; ++r) {
+              at::vec::convert(src + r * ld, tmp + r * headSize, headSize);
+            }
+            ld_fp32 = headSize;
+            return tmp;
+          }
+        };
+
+        for (int64_t z = begin; z < end; ++z) {
+          int64_t m = k * qSplitSize;
+          int64_t qBlockSize = std::min(qSplitSize, qSize - m);
+          int64_t ldq = 0, ldk = 0, ldv = 0;
+          auto q_ptr = to_fp32(
+              query + i * qStrideB + j * headSize + m * qStride,
+              qStride,
+              qBlockSize,
+              q_fp32,
+              ldq);
+          torch_ipex::cpu::kernel::fill_stub(
+              qk_max_data, -std::numeric_limits<float>::infinity(), qBlockSize);
+          torch_ipex::cpu::kernel::fill_stub(qk_sum_data, 0.f, qBlockSize);
+
+          for (int64_t n = 0; n < kvSize; n += kvSplitSize) {
+            int64_t kvBlockSize = std::min(kvSplitSize, kvSize - n);
+            auto k_ptr = to_fp32(
+                key + i * kStrideB + j * headSize + n * kStride,
+                kStride,
+                kvBlockSize,
+                k_fp32,
+                ldk);
+            auto v_ptr = to_fp32(
+                value + i * vStrideB + j * headSize + n * vStride,
+                vStride,
+                kvBlockSize,
+                v_fp32,
+                ldv);
+            // [qBlockSize,headSize] x [headSize,kvBlockSize]
+            cblas_sgemm(
+                CblasRowMajor,
+                CblasNoTrans,
+                CblasTrans,
+                qBlockSize,
+                kvBlockSize,
+                headSize,
+                alpha,
+                q_ptr,
+                ldq,
+                k_ptr,
+                ldk,
+                0.f,
+                qk_data,
+                kvBlockSize);
+
+            for (int64_t row = 0; row < qBlockSize; ++row) {
+              float* qk_row = qk_data + row * kvBlockSize;
+              if (rel_kv != nullptr) {
+                at::vec::map2<float>(
+                    [](Vec x, Vec y) { return x + y; },
+                    qk_row,
+                    qk_row,
+                    rel_kv + i * kvSize + n,
+                    kvBlockSize);
+              }
+              float tmp_max = std::max(
+                  qk_max_data[row],
+                  at::vec::reduce_all<float>(
+                      [](Vec& x, Vec& y) { return at::vec::maximum(x, y); },
+                      qk_row,
+                      kvBlockSize));
+              at::vec::map<float>(
+                  [tmp_max](Vec x) { return (x - Vec(tmp_max)).exp(); },
+                  qk_row,
+                  qk_row,
+                  kvBlockSize);
+              float tmp_sum = at::vec::reduce_all<float>(
+                  [](Vec& x, Vec& y) { return x + y; }, qk_row, kvBlockSize);
+              float exp_tmp = std::exp(qk_max_data[row] - tmp_max);
+              qk_sum_data[row] = tmp_sum + exp_tmp * qk_sum_data[row];
+              qk_max_data[row] = tmp_max;
+              if (n > 0) {
+                at::vec::map<float>(
+                    [exp_tmp](Vec x) { return x * Vec(exp_tmp); },
+                    dst_data + row * headSize,
+                    dst_data + row * headSize,
+                    headSize);
+              }
+            }
+            // [qBlockSize,kvBlockSize] x [kvBlockSize,headSize]
+            cblas_sgemm(
+                CblasRowMajor,
+                CblasNoTrans,
+                CblasNoTrans,
+                qBlockSize,
+                headSize,
+                kvBlockSize,
+                1.f,
+                qk_data,
+                kvBlockSize,
+                v_ptr,
+                ldv,
+                n == 0 ? 0.f : 1.f,
+                dst_data,
+                headSize);
+          }
+
+          for (int64_t row = 0; row < qBlockSize; ++row) {
+            float sum_reciprocal = 1 / qk_sum_data[row];
+            at::vec::map<float>(
+                [sum_reciprocal](Vec x) { return x * Vec(sum_reciprocal); },
+                dst_data + row * headSize,
+                dst_data + row * headSize,
+                headSize);
+            at::vec::convert(
+                dst_data + row * headSize,
+                output_ptr + i * qSize * hiddenSize + (m + row) * hiddenSize +
+                    j * headSize,
+                headSize);
+          }
+          at::native::data_index_step(i, batchSize, j, num_head, k, qSlice);
+        }
+      });
   return output;
 }
 
-at::Tensor sd_mha_kernel_v1_impl(
+bool is_mha_fusion_dtype(const at::ScalarType& dtype) {
+  return dtype == at::kBFloat16 || dtype == at::kHalf || dtype == at::kFloat;
+}
+
+at::Tensor bert_mha_kernel_impl(
     const at::Tensor& qkv,
+    const at::Tensor& rel_kv,
+    const int64_t& num_head,
+    const int64_t& headSize,
+    const double& dim_per_head) {
+  TORCH_CHECK(
+      is_mha_fusion_dtype(qkv.scalar_type()),
+      "The BERT MHA fusion only supports BF16, FP16 and FP32 data types.");
+
+  int64_t batchSize = qkv.dim() > 2 ? qkv.size(0) : 1;
+  int64_t sequenceSize = qkv.dim() > 2 ? qkv.size(1) : qkv.size(0);
+  int64_t hiddenSize = num_head * headSize;
+  int64_t qkvColSize = hiddenSize * 3;
+  int64_t qSplitSize = sequenceSize;
+  for (int i = 0; i < qsplit_ranges.size(); ++i) {
+    if (sequenceSize > qsplit_ranges[i]) {
+      qSplitSize = qsplit_sizes[i];
+      break;
+    }
+  }
+#if defined(CPU_CAPABILITY_AVX512)
+  if (qkv.scalar_type() == at::kBFloat16) {
+    return bert_mha_base_kernel(
+        qkv, rel_kv, num_head, headSize, dim_per_head, qSplitSize);
+  }
+#endif
+  auto qkv_ = qkv.contiguous();
+  // The relative mask is shared by all the heads and queries of a sample
+  auto rel_kv_ = rel_kv.to(at::kFloat)
+                     .reshape({-1, sequenceSize})
+                     .expand({batchSize, sequenceSize})
+                     .contiguous();
+  auto output = AT_DISPATCH_FLOATING_TYPES_AND2(
+      at::kBFloat16, at::kHalf, qkv_.scalar_type(), "bert_mha_kernel", [&] {
+        auto qkv_ptr = qkv_.data_ptr<scalar_t>();
+        return mha_fp32_acc_kernel<scalar_t>(
+            qkv_ptr,
+            qkv_ptr + hiddenSize,
+            qkv_ptr + hiddenSize * 2,
+            rel_kv_.data_ptr<float>(),
+            sequenceSize * qkvColSize,
+            qkvColSize,
+            sequenceSize * qkvColSize,
+            qkvColSize,
+            sequenceSize * qkvColSize,
+            qkvColSize,
+            batchSize,
+            sequenceSize,
+            sequenceSize,
+            num_head,
+            headSize,
+            hiddenSize,
+            1.0 / dim_per_head,
+            qSplitSize);
+      });
+  return output.view({batchSize, sequenceSize, num_head, headSize});
+}
+
+at::Tensor sd_mha_kernel_v1_impl(
+    const at::Tensor& _qkv,
     const int64_t& num_head,
     const int64_t& headSize,
     const double& scale) {
+  auto qkv = _qkv.stride(-1) == 1 ? _qkv : _qkv.contiguous();
   TORCH_CHECK(
-      qkv.dtype() == at::kBFloat16,
-      "Currently the Stable-Diffusion MHA fusion only supports BF16 data type.");
+      is_mha_fusion_dtype(qkv.scalar_type()),
+      "The Stable-Diffusion MHA fusion only supports BF16, FP16 and FP32 data types.");
 
   int64_t qkvOffset = num_head * headSize;
-  int64_t qkvStride = qkv.size(-1);
+  int64_t qkvStrideB = qkv.stride(0);
+  int64_t qkvStride = qkv.stride(1);
   int64_t batchSize = qkv.size(0);
   int64_t sequenceSize = qkv.size(1);
   int64_t hiddenSize = num_head * headSize;
 #if defined(CPU_CAPABILITY_AVX512)
-  return sd_mha_base_kernel(
-      qkv.data_ptr<at::BFloat16>(),
-      qkv.data_ptr<at::BFloat16>() + qkvOffset,
-      qkv.data_ptr<at::BFloat16>() + qkvOffset * 2,
-      qkvStride,
-      qkvStride,
-      qkvStride,
-      batchSize,
-      sequenceSize,
-      sequenceSize,
-      num_head,
-      headSize,
-      hiddenSize,
-      scale);
+  if (qkv.scalar_type() == at::kBFloat16) {
+    return sd_mha_base_kernel(
+        qkv.data_ptr<at::BFloat16>(),
+        qkv.data_ptr<at::BFloat16>() + qkvOffset,
+        qkv.data_ptr<at::BFloat16>() + qkvOffset * 2,
+        qkvStrideB,
+        qkvStride,
+        qkvStrideB,
+        qkvStride,
+        qkvStrideB,
+        qkvStride,
+        batchSize,
+        sequenceSize,
+        sequenceSize,
+        num_head,
+        headSize,
+        hiddenSize,
+        scale);
+  }
 #endif
-  auto qkv_mat = dil_mat_split<at::BFloat16>(
-      qkv, at::IntArrayRef({hiddenSize, hiddenSize, hiddenSize}));
-  auto query = qkv_mat[0];
-  auto key = qkv_mat[1];
-  auto value = qkv_mat[2];
-  query.resize_({batchSize, sequenceSize, num_head, headSize}).transpose_(1, 2);
-  key.resize_({batchSize, sequenceSize, num_head, headSize})
-      .transpose_(1, 2)
-      .transpose_(2, 3);
-  value.resize_({batchSize, sequenceSize, num_head, headSize}).transpose_(1, 2);
-
-  auto qk = at::matmul(query, key);
-  qk = at::softmax(at::mul(qk, scale), -1);
-  auto output = at::matmul(qk, value);
-
-  output = output.transpose_(1, 2).contiguous().resize_(
-      {batchSize, sequenceSize, hiddenSize});
-  return output;
+  return AT_DISPATCH_FLOATING_TYPES_AND2(
+      at::kBFloat16, at::kHalf, qkv.scalar_type(), "sd_mha_kernel_v1", [&] {
+        auto qkv_ptr = qkv.data_ptr<scalar_t>();
+        return mha_fp32_acc_kernel<scalar_t>(
+            qkv_ptr,
+            qkv_ptr + qkvOffset,
+            qkv_ptr + qkvOffset * 2,
+            nullptr,
+            qkvStrideB,
+            qkvStride,
+            qkvStrideB,
+            qkvStride,
+            qkvStrideB,
+            qkvStride,
+            batchSize,
+            sequenceSize,
+            sequenceSize,
+            num_head,
+            headSize,
+            hiddenSize,
+            scale,
+            qsplit_size);
+      });
 }
 
+// The key and value may come from another source than the query, like the
+// encoder states in the cross-attention of UNet, so they can have another
+// length and row stride (e.g. the two slices of a fused KV projection).
 at::Tensor sd_mha_kernel_v2_impl(
     const at::Tensor& _query,
     const at::Tensor& _key,
@@ -670,50 +918,72 @@ at::Tensor sd_mha_kernel_v2_impl(
     const int64_t& num_head,
     const int64_t& headSize,
     const double& scale) {
-  auto query = _query.contiguous();
-  auto key = _key.contiguous();
-  auto value = _value.contiguous();
+  auto query = _query.stride(-1) == 1 ? _query : _query.contiguous();
+  auto key = _key.stride(-1) == 1 ? _key : _key.contiguous();
+  auto value = _value.stride(-1) == 1 ? _value : _value.contiguous();
+  TORCH_CHECK(
+      is_mha_fusion_dtype(query.scalar_type()) &&
+          key.scalar_type() == query.scalar_type() &&
+          value.scalar_type() == query.scalar_type(),
+      "The Stable-Diffusion MHA fusion only supports query, key and value of the same data type in BF16, FP16 or FP32.");
   TORCH_CHECK(
-      (query.dtype() == at::kBFloat16 && key.dtype() == at::kBFloat16 &&
-       value.dtype() == at::kBFloat16),
-      "Currently the Stable-Diffusion MHA fusion only supports BF16 data type.");
+      key.size(0) == query.size(0) && value.size(0) == query.size(0) &&
+          key.size(1) == value.size(1),
+      "The Stable-Diffusion MHA fusion expects key and value of the same length and the same batch size as query.");
 
   int64_t batchSize = query.size(0);
-  int64_t qStride = query.size(-1);
-  int64_t kStride = key.size(-1);
-  int64_t vStride = value.size(-1);
+  int64_t qStrideB = query.stride(0);
+  int64_t qStride = query.stride(1);
+  int64_t kStrideB = key.stride(0);
+  int64_t kStride = key.stride(1);
+  int64_t vStrideB = value.stride(0);
+  int64_t vStride = value.stride(1);
   int64_t qSize = query.size(1);
   int64_t kvSize = value.size(1);
   int64_t hiddenSize = num_head * headSize;
 #if defined(CPU_CAPABILITY_AVX512)
-  return sd_mha_base_kernel(
-      query.data_ptr<at::BFloat16>(),
-      key.data_ptr<at::BFloat16>(),
-      value.data_ptr<at::BFloat16>(),
-      qStride,
-      kStride,
-      vStride,
-      batchSize,
-      qSize,
-      kvSize,
-      num_head,
-      headSize,
-      hiddenSize,
-      scale);
+  if (query.scalar_type() == at::kBFloat16) {
+    return sd_mha_base_kernel(
+        query.data_ptr<at::BFloat16>(),
+        key.data_ptr<at::BFloat16>(),
+        value.data_ptr<at::BFloat16>(),
+        qStrideB,
+        qStride,
+        kStrideB,
+        kStride,
+        vStrideB,
+        vStride,
+        batchSize,
+        qSize,
+        kvSize,
+        num_head,
+        headSize,
+        hiddenSize,
+        scale);
+  }
 #endif
-  query.resize_({batchSize, qSize, num_head, headSize}).transpose_(1, 2);
-  key.resize_({batchSize, kvSize, num_head, headSize})
-      .transpose_(1, 2)
-      .transpose_(2, 3);
-  value.resize_({batchSize, kvSize, num_head, headSize}).transpose_(1, 2);
-
-  auto qk = at::matmul(query, key);
-  qk = at::softmax(at::mul(qk, scale), -1);
-  auto output = at::matmul(qk, value);
-
-  output = output.transpose_(1, 2).contiguous().resize_(
-      {batchSize, qSize, hiddenSize});
-  return output;
+  return AT_DISPATCH_FLOATING_TYPES_AND2(
+      at::kBFloat16, at::kHalf, query.scalar_type(), "sd_mha_kernel_v2", [&] {
+        return mha_fp32_acc_kernel<scalar_t>(
+            query.data_ptr<scalar_t>(),
+            key.data_ptr<scalar_t>(),
+            value.data_ptr<scalar_t>(),
+            nullptr,
+            qStrideB,
+            qStride,
+            kStrideB,
+            kStride,
+            vStrideB,
+            vStride,
+            batchSize,
+            qSize,
+            kvSize,
+            num_head,
+            headSize,
+            hiddenSize,
+            scale,
+            qsplit_size);
+      });
 }
 
 } // anonymous namespace
@@ -723,4 +993,4 @@ IPEX_REGISTER_DISPATCH(sd_mha_kernel_v1_stub, &sd_mha_kernel_v1_impl);
 IPEX_REGISTER_DISPATCH(sd_mha_kernel_v2_stub, &sd_mha_kernel_v2_impl);
 
 } // namespace cpu
-} // namespace torch_ipex
\ No newline at end of file
+} // namespace torch_ipex
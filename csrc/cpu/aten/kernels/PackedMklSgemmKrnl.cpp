@@ -1,7 +1,13 @@
 #include <ATen/Parallel.h>
+#include <ATen/cpu/vec/functional.h>
+#include <ATen/cpu/vec/vec.h>
 #include <torch/csrc/autograd/function.h>
+
+#include <algorithm>
+
 #include "aten/LinearMKL.h"
 #include "aten/utils/utils.h"
+#include "cpu/kernels/PostOpChain.h"
 #include "vec/vec.h"
 
 namespace torch_ipex {
@@ -9,6 +15,181 @@ namespace cpu {
 
 namespace {
 
+using Vec = at::vec::Vectorized<float>;
+using namespace torch_ipex::cpu::detail;
+
+// The smallest output tile a thread computes with the unpacked weight. A
+// narrower tile makes the per call overhead of cblas_sgemm dominate.
+constexpr int64_t kMinTileM = 16;
+constexpr int64_t kMinTileN = 64;
+
+// Sets the number of threads of the MKL calls on the current thread, and
+// restores it on destruction. 0 keeps the MKL setting.
+class MklNumThreadsGuard {
+ public:
+  explicit MklNumThreadsGuard(int64_t num_threads)
+      : active_(num_threads > 0),
+        prev_(
+            active_ ? mkl_set_num_threads_local(static_cast<int>(num_threads))
+                    : 0) {}
+
+  ~MklNumThreadsGuard() {
+    if (active_) {
+      mkl_set_num_threads_local(prev_);
+    }
+  }
+
+ private:
+  bool active_;
+  int prev_;
+};
+
+template <typename Op>
+void map_rows(float* out, int64_t ldc, int64_t rows, int64_t cols, Op op) {
+  for (int64_t r = 0; r < rows; r++) {
+    at::vec::map(op, out + r * ldc, out + r * ldc, cols);
+  }
+}
+
+// Applies the eltwise post-ops on a rows x cols tile of the output.
+void apply_post_ops(
+    float* out,
+    int64_t ldc,
+    int64_t rows,
+    int64_t cols,
+    const MklSgemmParams& params) {
+  const Vec zero(0.f);
+  const Vec one(1.f);
+  const Vec half(0.5f);
+  for (size_t i = 0; i < params.post_op_kinds.size(); i++) {
+    const Vec alpha(
+        static_cast<float>(params.post_op_params[i * kPostOpParamsNum]));
+    const Vec beta(
+        static_cast<float>(params.post_op_params[i * kPostOpParamsNum + 1]));
+    switch (params.post_op_kinds[i]) {
+      case kPostOpRelu:
+        map_rows(out, ldc, rows, cols, [&](Vec x) {
+          return Vec::blendv(x * alpha, x, x > zero);
+        });
+        break;
+      case kPostOpGeluErf:
+        map_rows(out, ldc, rows, cols, [&](Vec x) {
+          return x * half * (one + (x * Vec(M_SQRT1_2)).erf());
+        });
+        break;
+      case kPostOpGeluTanh:
+        map_rows(out, ldc, rows, cols, [&](Vec x) {
+          const Vec kBeta(M_SQRT2 * M_2_SQRTPI * 0.5);
+          const Vec kKappa(0.044715f);
+          auto inner = kBeta * (x + kKappa * x * x * x);
+          return half * x * (one + inner.tanh());
+        });
+        break;
+      case kPostOpClip:
+        map_rows(out, ldc, rows, cols, [&](Vec x) {
+          return at::vec::clamp(x, alpha, beta);
+        });
+        break;
+      case kPostOpElu:
+        map_rows(out, ldc, rows, cols, [&](Vec x) {
+          return Vec::blendv(alpha * x.expm1(), x, x > zero);
+        });
+        break;
+      case kPostOpSwish:
+        map_rows(out, ldc, rows, cols, [&](Vec x) {
+          return x / (one + x.neg().exp());
+        });
+        break;
+      case kPostOpSigmoid:
+        map_rows(out, ldc, rows, cols, [&](Vec x) {
+          return one / (one + x.neg().exp());
+        });
+        break;
+      case kPostOpTanh:
+        map_rows(out, ldc, rows, cols, [](Vec x) { return x.tanh(); });
+        break;
+      case kPostOpAbs:
+        map_rows(out, ldc, rows, cols, [](Vec x) { return x.abs(); });
+        break;
+      case kPostOpExp:
+        map_rows(out, ldc, rows, cols, [](Vec x) { return x.exp(); });
+        break;
+      case kPostOpLog:
+        map_rows(out, ldc, rows, cols, [](Vec x) { return x.log(); });
+        break;
+      case kPostOpSqrt:
+        map_rows(out, ldc, rows, cols, [](Vec x) { return x.sqrt(); });
+        break;
+      case kPostOpSquare:
+        map_rows(out, ldc, rows, cols, [](Vec x) { return x * x; });
+        break;
+      case kPostOpRound:
+        map_rows(out, ldc, rows, cols, [](Vec x) { return x.round(); });
+        break;
+      case kPostOpHardswish:
+        map_rows(out, ldc, rows, cols, [&](Vec x) {
+          return x * at::vec::clamp(x + Vec(3.f), zero, Vec(6.f)) / Vec(6.f);
+        });
+        break;
+      case kPostOpHardsigmoid:
+        map_rows(out, ldc, rows, cols, [&](Vec x) {
+          return at::vec::clamp(x + Vec(3.f), zero, Vec(6.f)) / Vec(6.f);
+        });
+        break;
+      case kPostOpMish:
+        map_rows(out, ldc, rows, cols, [](Vec x) {
+          return x * x.exp().log1p().tanh();
+        });
+        break;
+      case kPostOpPow:
+        map_rows(out, ldc, rows, cols, [&](Vec x) {
+          return alpha * x.pow(beta);
+        });
+        break;
+      case kPostOpLinear:
+        map_rows(out, ldc, rows, cols, [&](Vec x) {
+          return at::vec::fmadd(alpha, x, beta);
+        });
+        break;
+      default:
+        TORCH_CHECK(
+            false,
+            "mkl_sgemm: post-op ",
+            params.post_op_kinds[i],
+            " is not an eltwise post-op");
+    }
+  }
+}
+
+void fill_bias(
+    float* out,
+    int64_t ldc,
+    const float* bias_ptr,
+    int64_t rows,
+    int64_t cols) {
+  for (int64_t r = 0; r < rows; r++) {
+    memcpy(out + r * ldc, bias_ptr, sizeof(float) * cols);
+  }
+}
+
+// Splits the M x N output into at most num_threads tiles. N is split first:
+// at small batch sizes the sgemm is bound by reading the weight, and each N
+// tile reads a disjoint slice of it. M takes the remaining threads.
+void partition_output(
+    int64_t M,
+    int64_t N,
+    int64_t num_threads,
+    int64_t& tile_m,
+    int64_t& tile_n) {
+  int64_t tiles_n = std::min(num_threads, std::max<int64_t>(1, N / kMinTileN));
+  int64_t tiles_m = std::min(
+      std::max<int64_t>(1, num_threads / tiles_n),
+      std::max<int64_t>(1, M / kMinTileM));
+  // Keep the N tiles a multiple of the vector length for the post-ops
+  tile_n = at::divup(at::divup(N, tiles_n), Vec::size()) * Vec::size();
+  tile_m = at::divup(M, tiles_m);
+}
+
 void _mkl_sgemm_packB_impl(
     const int64_t M,
     const int64_t N,
@@ -46,58 +227,122 @@ void mkl_sgemm_base_kernel_impl(
     const at::Tensor& bias,
     const int64_t N,
     at::Tensor& output,
-    bool pack) {
+    bool pack,
+    const MklSgemmParams& params) {
   auto self_ = self.is_contiguous() ? self : self.contiguous();
   const int64_t dim = self.dim();
   auto self_reshaped =
       dim == 2 ? self_ : self_.reshape({-1, self.size(self.dim() - 1)});
   auto M = self_reshaped.size(0);
   auto K = self_reshaped.size(1);
+  if (M == 0 || N == 0) {
+    return;
+  }
 
   auto in_ptr = self_.data_ptr<float>();
   auto weight_ptr = weight.data_ptr<float>();
   auto out_ptr = output.data_ptr<float>();
+  auto bias_ = bias.defined() ? bias.contiguous() : bias;
+  const float* bias_ptr = bias.defined() ? bias_.data_ptr<float>() : nullptr;
+  const float beta = bias.defined() ? 1.f : 0.f;
+  const bool has_post_ops = !params.post_op_kinds.empty();
 
-  if (bias.defined()) {
-    auto bias_ = self.is_contiguous() ? bias : bias.contiguous();
-    auto bias_ptr = bias_.data_ptr<float>();
-    at::parallel_for(0, M, 1, [&](int64_t begin, int64_t end) {
-      for (const auto d : c10::irange(begin, end)) {
-        memcpy(out_ptr + d * N, bias_ptr, sizeof(float) * N);
-      }
-    });
+  auto jit_kernel = params.jit_kernel;
+  if (!pack && jit_kernel != nullptr && jit_kernel->defined() &&
+      jit_kernel->M == M && jit_kernel->N == N && jit_kernel->K == K &&
+      jit_kernel->beta == beta) {
+    // Tiny fixed shape, a single thread running the JIT kernel beats any
+    // split of the output
+    if (bias.defined()) {
+      fill_bias(out_ptr, N, bias_ptr, M, N);
+    }
+    jit_kernel->kernel(jit_kernel->jitter.get(), in_ptr, weight_ptr, out_ptr);
+    apply_post_ops(out_ptr, N, M, N, params);
+    return;
   }
+
   if (pack) {
-    cblas_sgemm_compute(
-        CblasRowMajor,
-        CblasNoTrans,
-        CblasPacked,
-        M,
-        N,
-        K,
-        in_ptr,
-        K,
-        weight_ptr,
-        K,
-        bias.defined() ? 1.f : 0.f,
-        out_ptr,
-        N);
-  } else {
+    // The packed weight is opaque and only valid for the whole M/N/K it was
+    // packed for, the split of the output is left to MKL
+    if (bias.defined()) {
+      at::parallel_for(0, M, 1, [&](int64_t begin, int64_t end) {
+        fill_bias(out_ptr + begin * N, N, bias_ptr, end - begin, N);
+      });
+    }
+    {
+      MklNumThreadsGuard guard(params.num_threads);
+      cblas_sgemm_compute(
+          CblasRowMajor,
+          CblasNoTrans,
+          CblasPacked,
+          M,
+          N,
+          K,
+          in_ptr,
+          K,
+          weight_ptr,
+          K,
+          beta,
+          out_ptr,
+          N);
+    }
+    if (has_post_ops) {
+      at::parallel_for(0, M, 1, [&](int64_t begin, int64_t end) {
+        apply_post_ops(out_ptr + begin * N, N, end - begin, N, params);
+      });
+    }
+    return;
+  }
+
+  // Each thread computes its own tiles of the output with a single threaded
+  // sgemm, so that the bias and the post-ops are applied on the tile while
+  // it is still in cache
+  int64_t num_threads =
+      params.num_threads > 0 ? params.num_threads : at::get_num_threads();
+  int64_t tile_m = 0;
+  int64_t tile_n = 0;
+  partition_output(M, N, num_threads, tile_m, tile_n);
+  const int64_t tiles_m = at::divup(M, tile_m);
+  const int64_t tiles_n = at::divup(N, tile_n);
+  auto compute_tile = [&](int64_t tile) {
+    const int64_t m0 = (tile / tiles_n) * tile_m;
+    const int64_t n0 = (tile % tiles_n) * tile_n;
+    const int64_t rows = std::min(tile_m, M - m0);
+    const int64_t cols = std::min(tile_n, N - n0);
+    if (rows <= 0 || cols <= 0) {
+      return;
+    }
+    float* out_tile = out_ptr + m0 * N + n0;
+    if (bias.defined()) {
+      fill_bias(out_tile, N, bias_ptr + n0, rows, cols);
+    }
     cblas_sgemm(
         CblasRowMajor,
         CblasNoTrans,
         CblasTrans,
-        M,
-        N,
+        rows,
+        cols,
         K,
         1.0f,
-        in_ptr,
+        in_ptr + m0 * K,
         K,
-        weight_ptr,
+        weight_ptr + n0 * K,
         K,
-        bias.defined() ? 1.f : 0.f,
-        out_ptr,
+        beta,
+        out_tile,
         N);
+    apply_post_ops(out_tile, N, rows, cols, params);
+  };
+  const int64_t num_tiles = tiles_m * tiles_n;
+  if (num_tiles == 1) {
+    MklNumThreadsGuard guard(num_threads);
+    compute_tile(0);
+    return;
+  }
+#pragma omp parallel for num_threads(num_tiles)
+  for (int64_t tile = 0; tile < num_tiles; tile++) {
+    MklNumThreadsGuard guard(1);
+    compute_tile(tile);
   }
 }
 
@@ -105,9 +350,10 @@ void mkl_sgemm_kernel_impl(
     const at::Tensor& self,
     const at::Tensor& ori_weight,
     const at::Tensor& bias,
-    at::Tensor& output) {
+    at::Tensor& output,
+    const MklSgemmParams& params) {
   mkl_sgemm_base_kernel_impl(
-      self, ori_weight, bias, ori_weight.size(0), output, false);
+      self, ori_weight, bias, ori_weight.size(0), output, false, params);
 }
 
 void mkl_prepack_sgemm_kernel_impl(
@@ -115,9 +361,10 @@ void mkl_prepack_sgemm_kernel_impl(
     const at::Tensor& mkl_weight,
     const at::Tensor& bias,
     const int64_t out_features,
-    at::Tensor& output) {
+    at::Tensor& output,
+    const MklSgemmParams& params) {
   mkl_sgemm_base_kernel_impl(
-      self, mkl_weight, bias, out_features, output, true);
+      self, mkl_weight, bias, out_features, output, true, params);
 }
 
 } // anonymous namespace
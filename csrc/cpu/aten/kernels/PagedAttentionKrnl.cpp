@@ -1,7 +1,9 @@
 #include <ATen/Tensor.h>
 #include <aten/PagedAttention.h>
+#include <aten/TreeAttention.h>
 #include <torch/all.h>
 #include <torch/csrc/autograd/function.h>
+#include <cstring>
 #include <limits>
 #include "vec/vec.h"
 
@@ -17,7 +19,7 @@ void reduce_head(
     float* attn_w_pos,
     int64_t head_size) {
   attn_w_pos[0] = 0;
-#if defined(CPU_CAPABILITY_AVX512)
+#if defined(CPU_CAPABILITY_AVX512) || defined(CPU_CAPABILITY_AVX2)
   torch_ipex::cpu::kernel::_reduce_head<QT, KT, KT>(
       q_ptr_start, k_cache_start, attn_w_pos, head_size, false, nullptr);
 #else
@@ -36,7 +38,7 @@ inline void mul_attenion_weights_and_value_of_head(
     bool accumulated) {
   auto vec_size = 16; // 512/32
   auto hsi = 0;
-#if defined(CPU_CAPABILITY_AVX512)
+#if defined(CPU_CAPABILITY_AVX512) || defined(CPU_CAPABILITY_AVX2)
   torch_ipex::cpu::kernel::_mul_and_accumulate<CT, OT, CT>(
       attn_w,
       v_cache_start,
@@ -84,6 +86,12 @@ inline void mul_attenion_weights_and_value_of_head(
  * @param max_context_len Maximum context length.
  * @param alibi_slopes  Optional tensor of alibi slopes with the shape of
  * (num_heads).
+ * @param tree_mask     Optional int64 bitmask [num_seqs, words] to verify a
+ * tree of speculative candidates in one step, one query per candidate. The
+ * candidates are the last tokens of the context in topological order (see
+ * tree_attention_mask), the context of a query ends with its own candidate,
+ * the highest bit of its row, and only the candidates whose bits are set are
+ * attended besides the prefix.
  */
 template <typename scalar_t>
 void single_query_cached_kv_attention_kernel(
@@ -97,7 +105,8 @@ void single_query_cached_kv_attention_kernel(
     at::Tensor& context_lens,
     int64_t block_size,
     int64_t max_context_len,
-    const c10::optional<at::Tensor>& alibi_slopes) {
+    const c10::optional<at::Tensor>& alibi_slopes,
+    const c10::optional<at::Tensor>& tree_mask) {
   auto out_ptr = out.data_ptr<scalar_t>();
   auto query_ptr = query.data_ptr<scalar_t>();
   auto key_cache_ptr = key_cache.data_ptr<scalar_t>();
@@ -128,6 +137,36 @@ void single_query_cached_kv_attention_kernel(
         "alibi_slopes size is not equal to num_heads");
   }
 
+  // first token of the tree in the context of every query
+  std::vector<int64_t> tree_start(num_seqs, max_context_len);
+  auto tree_mask_v = tree_mask.has_value() ? tree_mask.value().contiguous()
+                                           : at::Tensor();
+  auto tree_mask_ptr =
+      tree_mask.has_value() ? tree_mask_v.data_ptr<int64_t>() : nullptr;
+  auto tree_mask_words = tree_mask.has_value() ? tree_mask_v.size(1) : 0;
+  if (tree_mask.has_value()) {
+    TORCH_CHECK(
+        tree_mask_v.scalar_type() == at::kLong && tree_mask_v.dim() == 2 &&
+            tree_mask_v.size(0) == num_seqs,
+        "tree_mask should be an int64 bitmask of the shape [num_seqs, words]");
+    for (auto seq_id = 0; seq_id < num_seqs; seq_id++) {
+      auto candidate = tree_mask_candidate(
+          tree_mask_ptr + seq_id * tree_mask_words, tree_mask_words);
+      TORCH_CHECK(
+          candidate >= 0 && candidate < context_lens_ptr[seq_id],
+          "tree_mask: the row of query ",
+          seq_id,
+          " should have its own candidate in its context");
+      tree_start[seq_id] = context_lens_ptr[seq_id] - 1 - candidate;
+    }
+  }
+  auto is_tree_masked = [&](int64_t seq_id, int64_t token_id) {
+    return token_id >= tree_start[seq_id] &&
+        !tree_mask_visible(
+               tree_mask_ptr + seq_id * tree_mask_words,
+               token_id - tree_start[seq_id]);
+  };
+
 #pragma omp parallel for collapse(3)
   for (auto seq_id = 0; seq_id < num_seqs; seq_id++) {
     for (auto head_id = 0; head_id < num_heads; head_id++) {
@@ -137,6 +176,10 @@ void single_query_cached_kv_attention_kernel(
           continue;
         auto attn_w_pos = attn_weights_ptr + seq_id * attn_weights_stride +
             head_id * max_context_len + token_id;
+        if (is_tree_masked(seq_id, token_id)) {
+          attn_w_pos[0] = -10000.0f;
+          continue;
+        }
         auto q_ptr_start = query_ptr + seq_id * q_stride + head_id * head_size;
         auto block_id = block_tables_ptr
             [seq_id * max_num_blocks_per_seq + token_id / block_size];
@@ -159,7 +202,7 @@ void single_query_cached_kv_attention_kernel(
       auto context_len = context_lens_ptr[seq_id];
       auto attn_w_start = attn_weights_ptr + seq_id * attn_weights_stride +
           head_id * max_context_len;
-#if defined(CPU_CAPABILITY_AVX512)
+#if defined(CPU_CAPABILITY_AVX512) || defined(CPU_CAPABILITY_AVX2)
       if (alibi_slopes_ptr != nullptr) {
         auto alibi_slope = alibi_slopes_ptr[head_id];
         torch_ipex::cpu::kernel::
@@ -229,7 +272,7 @@ void single_query_cached_kv_attention_kernel(
       for (auto token_id = 0; token_id < max_context_len; token_id++) {
         auto context_len = context_lens_ptr[seq_id];
         auto thread_id = omp_get_thread_num();
-        if (token_id >= context_len)
+        if (token_id >= context_len || is_tree_masked(seq_id, token_id))
           continue;
         auto attn_w = attn_weights_ptr
             [seq_id * attn_weights_stride + head_id * max_context_len +
@@ -358,7 +401,8 @@ void single_query_cached_kv_attention_kernel_impl(
     at::Tensor& context_lens, // [num_seqs]
     int64_t block_size,
     int64_t max_context_len,
-    const c10::optional<at::Tensor>& alibi_slopes) {
+    const c10::optional<at::Tensor>& alibi_slopes,
+    const c10::optional<at::Tensor>& tree_mask) {
   RECORD_FUNCTION(
       "ipex::single_query_cached_kv_attention_kernel_impl",
       c10::ArrayRef<c10::IValue>({}));
@@ -375,7 +419,8 @@ void single_query_cached_kv_attention_kernel_impl(
         context_lens,
         block_size,
         max_context_len,
-        alibi_slopes);
+        alibi_slopes,
+        tree_mask);
   } else if (out.scalar_type() == at::ScalarType::BFloat16) {
     single_query_cached_kv_attention_kernel<at::BFloat16>(
         out,
@@ -388,7 +433,8 @@ void single_query_cached_kv_attention_kernel_impl(
         context_lens,
         block_size,
         max_context_len,
-        alibi_slopes);
+        alibi_slopes,
+        tree_mask);
   } else {
     TORCH_CHECK(
         false, "Unsupported data type for single_query_cached_kv_attention");
@@ -426,6 +472,75 @@ void reshape_and_cache_cpu_kernel_impl(
   }
 }
 
+/**
+ * Compacts the key and value caches after the verification of a speculative
+ * token tree, keeping the keys and values of the accepted path only.
+ *
+ * @param key_cache   The key cache [num_blocks, block_size, num_heads,
+ * head_size].
+ * @param value_cache The value cache [num_blocks, block_size, num_heads,
+ * head_size].
+ * @param src_slots   The slots of the accepted candidates [num_slots], int32
+ * like the slot mapping of reshape_and_cache.
+ * @param dst_slots   The slots they are moved to [num_slots], usually the
+ * slots right after the prefix. The moves are done in order, so the
+ * destination of a move can be the source of an earlier one, as along an
+ * accepted path.
+ */
+void paged_kv_cache_compact_kernel_impl(
+    at::Tensor& key_cache,
+    at::Tensor& value_cache,
+    at::Tensor& src_slots,
+    at::Tensor& dst_slots) {
+  TORCH_CHECK(
+      key_cache.is_contiguous() && value_cache.is_contiguous(),
+      "key_cache and value_cache should be contiguous");
+  TORCH_CHECK(
+      src_slots.scalar_type() == at::kInt &&
+          dst_slots.scalar_type() == at::kInt &&
+          src_slots.numel() == dst_slots.numel(),
+      "src_slots and dst_slots should be int32 of the same size");
+  RECORD_FUNCTION(
+      "ipex::paged_kv_cache_compact_kernel_impl",
+      c10::ArrayRef<c10::IValue>({}));
+  auto src = src_slots.contiguous();
+  auto dst = dst_slots.contiguous();
+  auto src_ptr = src.data_ptr<int>();
+  auto dst_ptr = dst.data_ptr<int>();
+  auto num_slots = src.numel();
+  auto num_cache_slots = key_cache.size(0) * key_cache.size(1);
+  for (auto i = 0; i < num_slots; i++) {
+    TORCH_CHECK(
+        src_ptr[i] >= 0 && src_ptr[i] < num_cache_slots && dst_ptr[i] >= 0 &&
+            dst_ptr[i] < num_cache_slots,
+        "paged_kv_cache_compact: slot out of the cache");
+  }
+  auto head_num = key_cache.size(2);
+  auto key_head_bytes = key_cache.size(3) * key_cache.element_size();
+  auto value_head_bytes = value_cache.size(3) * value_cache.element_size();
+  auto key_cache_ptr = static_cast<char*>(key_cache.data_ptr());
+  auto value_cache_ptr = static_cast<char*>(value_cache.data_ptr());
+  // the heads are independent, the moves of every head are done in order
+#pragma omp parallel for
+  for (auto hi = 0; hi < head_num; hi++) {
+    for (auto i = 0; i < num_slots; i++) {
+      if (src_ptr[i] == dst_ptr[i]) {
+        continue;
+      }
+      auto src_head = src_ptr[i] * head_num + hi;
+      auto dst_head = dst_ptr[i] * head_num + hi;
+      std::memcpy(
+          key_cache_ptr + dst_head * key_head_bytes,
+          key_cache_ptr + src_head * key_head_bytes,
+          key_head_bytes);
+      std::memcpy(
+          value_cache_ptr + dst_head * value_head_bytes,
+          value_cache_ptr + src_head * value_head_bytes,
+          value_head_bytes);
+    }
+  }
+}
+
 } // namespace
 
 IPEX_REGISTER_DISPATCH(
@@ -434,6 +549,9 @@ IPEX_REGISTER_DISPATCH(
 IPEX_REGISTER_DISPATCH(
     reshape_and_cache_kernel_stub,
     &reshape_and_cache_cpu_kernel_impl);
+IPEX_REGISTER_DISPATCH(
+    paged_kv_cache_compact_kernel_stub,
+    &paged_kv_cache_compact_kernel_impl);
 
 } // namespace cpu
 } // namespace torch_ipex
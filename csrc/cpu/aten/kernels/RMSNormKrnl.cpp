@@ -8,7 +8,7 @@ namespace cpu {
 
 namespace {
 
-#if defined(CPU_CAPABILITY_AVX512)
+#if defined(CPU_CAPABILITY_AVX512) || defined(CPU_CAPABILITY_AVX2)
 template <typename T, typename T1>
 void RMSNormKernelImpl(
     const at::Tensor& a,
@@ -36,7 +36,7 @@ at::Tensor rmsnorm_kernel_impl(
     const at::Tensor& input,
     const at::Tensor& b,
     float eps) {
-#if defined(CPU_CAPABILITY_AVX512)
+#if defined(CPU_CAPABILITY_AVX512) || defined(CPU_CAPABILITY_AVX2)
   const auto input_shape = input.sizes();
   const auto input_ndim = input.dim();
   const int axis = input_ndim - 1;
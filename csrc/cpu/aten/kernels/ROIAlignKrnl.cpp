@@ -509,6 +509,7 @@ inline void roi_align_single_framework_channels_last_backward(
     const T* grad_output,
     const ACC_T count,
     int64_t channels,
+    int64_t channels_block,
     int64_t height,
     int64_t width,
     int64_t pooled_height,
@@ -539,7 +540,8 @@ inline void roi_align_single_framework_channels_last_backward(
           Vec w3_vec = Vec(static_cast<T>(pc.w3 / count));
           Vec w4_vec = Vec(static_cast<T>(pc.w4 / count));
           int64_t d2 = 0;
-          for (; d2 < channels - (channels % Vec::size()); d2 += Vec::size()) {
+          for (; d2 < channels_block - (channels_block % Vec::size());
+               d2 += Vec::size()) {
             Vec g_in1_vec =
                 Vec::loadu(g_in1 + d2) + Vec::loadu(g_out + d2) * w1_vec;
             g_in1_vec.store(g_in1 + d2);
@@ -553,7 +555,7 @@ inline void roi_align_single_framework_channels_last_backward(
                 Vec::loadu(g_in4 + d2) + Vec::loadu(g_out + d2) * w4_vec;
             g_in4_vec.store(g_in4 + d2);
           }
-          for (; d2 < channels; d2++) {
+          for (; d2 < channels_block; d2++) {
             g_in1[d2] += g_out[d2] * pc.w1 / count;
             g_in2[d2] += g_out[d2] * pc.w2 / count;
             g_in3[d2] += g_out[d2] * pc.w3 / count;
@@ -571,6 +573,7 @@ void roi_align_backward_kernel_body(
     int64_t n_rois,
     const T* grad_output,
     const ACC_T& spatial_scale,
+    int64_t batch_size,
     int64_t channels,
     int64_t height,
     int64_t width,
@@ -581,89 +584,127 @@ void roi_align_backward_kernel_body(
     T* grad_input,
     const ACC_T* rois,
     bool is_channels_last) {
-  // (n, c, ph, pw) is an element in the pooled output
-  // can be parallelized using omp
-  // at::parallel_for(0, n_rois, 1, [&](int64_t begin, int64_t end) {
+  // ROIs of the same image scatter-add into overlapping regions of the same
+  // grad_input plane, so the work is partitioned by (image, channel block)
+  // instead of by ROI. Every task walks all the ROIs of its image in order,
+  // thus each grad_input element is owned by a single thread and accumulated
+  // in the same order as the serial loop, which keeps the result
+  // deterministic. The bilinear weights are recomputed per task, which is
+  // cheap compared to the channel loop.
+  std::vector<std::vector<int64_t>> image_rois(batch_size);
   for (int64_t n = 0; n < n_rois; n++) {
-    const ACC_T* offset_rois = rois + n * 5;
-    int64_t roi_batch_ind = offset_rois[0];
-
-    // Do not using rounding; this implementation detail is critical
-    ACC_T offset = aligned ? (ACC_T)0.5 : (ACC_T)0.0;
-    ACC_T roi_start_w = offset_rois[1] * spatial_scale - offset;
-    ACC_T roi_start_h = offset_rois[2] * spatial_scale - offset;
-    ACC_T roi_end_w = offset_rois[3] * spatial_scale - offset;
-    ACC_T roi_end_h = offset_rois[4] * spatial_scale - offset;
-
-    ACC_T roi_width = roi_end_w - roi_start_w;
-    ACC_T roi_height = roi_end_h - roi_start_h;
-    if (!aligned) {
-      // Force malformed ROIs to be 1x1
-      roi_width = std::max(roi_width, (ACC_T)1.);
-      roi_height = std::max(roi_height, (ACC_T)1.);
-    }
+    int64_t roi_batch_ind = rois[n * 5];
+    TORCH_CHECK(
+        roi_batch_ind >= 0 && roi_batch_ind < batch_size,
+        "roi_align_backward: batch index of the roi is out of range");
+    image_rois[roi_batch_ind].push_back(n);
+  }
 
-    ACC_T bin_size_h =
-        static_cast<ACC_T>(roi_height) / static_cast<ACC_T>(pooled_height);
-    ACC_T bin_size_w =
-        static_cast<ACC_T>(roi_width) / static_cast<ACC_T>(pooled_width);
-
-    // We use roi_bin_grid to sample the grid and mimic integral
-    int64_t roi_bin_grid_h = (sampling_ratio > 0)
-        ? sampling_ratio
-        : ceil(roi_height / pooled_height); // e.g., = 2
-    int64_t roi_bin_grid_w =
-        (sampling_ratio > 0) ? sampling_ratio : ceil(roi_width / pooled_width);
-
-    // We do average (integral) pooling inside a bin
-    const ACC_T count = roi_bin_grid_h * roi_bin_grid_w; // e.g. = 4
-
-    // we want to precalculate indices and weights shared by all channels,
-    // this is the key point of optimization
-    std::vector<PreCalc<ACC_T>> pre_calc(
-        roi_bin_grid_h * roi_bin_grid_w * pooled_width * pooled_height);
-    pre_calc_for_bilinear_interpolate(
-        height,
-        width,
-        pooled_height,
-        pooled_width,
-        roi_start_h,
-        roi_start_w,
-        bin_size_h,
-        bin_size_w,
-        roi_bin_grid_h,
-        roi_bin_grid_w,
-        pre_calc);
-
-    if (is_channels_last) {
-      roi_align_single_framework_channels_last_backward<T, ACC_T>(
-          grad_output + n * channels * pooled_height * pooled_width,
-          count,
-          channels,
-          height,
-          width,
-          pooled_height,
-          pooled_width,
-          roi_bin_grid_h,
-          roi_bin_grid_w,
-          pre_calc,
-          grad_input + roi_batch_ind * channels * height * width);
-    } else {
-      roi_align_single_framework_backward<T, ACC_T>(
-          grad_output + n * channels * pooled_height * pooled_width,
-          count,
-          channels,
-          height,
-          width,
-          pooled_height,
-          pooled_width,
-          roi_bin_grid_h,
-          roi_bin_grid_w,
-          pre_calc,
-          grad_input + roi_batch_ind * channels * height * width);
-    }
-  } // for n
-  // });
+  using Vec = at::vec::Vectorized<T>;
+  int64_t num_threads = at::get_num_threads();
+  int64_t channel_blocks = std::min(
+      channels, (num_threads + batch_size - 1) / batch_size);
+  int64_t channels_per_block = (channels + channel_blocks - 1) / channel_blocks;
+  if (is_channels_last) {
+    // keep the channel blocks vectorizable
+    channels_per_block =
+        (channels_per_block + Vec::size() - 1) / Vec::size() * Vec::size();
+  }
+  channel_blocks = (channels + channels_per_block - 1) / channels_per_block;
+
+  at::parallel_for(
+      0, batch_size * channel_blocks, 1, [&](int64_t begin, int64_t end) {
+        std::vector<PreCalc<ACC_T>> pre_calc;
+        for (int64_t task = begin; task < end; task++) {
+          int64_t b = task / channel_blocks;
+          int64_t c_begin = task % channel_blocks * channels_per_block;
+          int64_t c_len = std::min(channels_per_block, channels - c_begin);
+
+          for (int64_t n : image_rois[b]) {
+            const ACC_T* offset_rois = rois + n * 5;
+
+            // Do not using rounding; this implementation detail is critical
+            ACC_T offset = aligned ? (ACC_T)0.5 : (ACC_T)0.0;
+            ACC_T roi_start_w = offset_rois[1] * spatial_scale - offset;
+            ACC_T roi_start_h = offset_rois[2] * spatial_scale - offset;
+            ACC_T roi_end_w = offset_rois[3] * spatial_scale - offset;
+            ACC_T roi_end_h = offset_rois[4] * spatial_scale - offset;
+
+            ACC_T roi_width = roi_end_w - roi_start_w;
+            ACC_T roi_height = roi_end_h - roi_start_h;
+            if (!aligned) {
+              // Force malformed ROIs to be 1x1
+              roi_width = std::max(roi_width, (ACC_T)1.);
+              roi_height = std::max(roi_height, (ACC_T)1.);
+            }
+
+            ACC_T bin_size_h = static_cast<ACC_T>(roi_height) /
+                static_cast<ACC_T>(pooled_height);
+            ACC_T bin_size_w = static_cast<ACC_T>(roi_width) /
+                static_cast<ACC_T>(pooled_width);
+
+            // We use roi_bin_grid to sample the grid and mimic integral
+            int64_t roi_bin_grid_h = (sampling_ratio > 0)
+                ? sampling_ratio
+                : ceil(roi_height / pooled_height); // e.g., = 2
+            int64_t roi_bin_grid_w = (sampling_ratio > 0)
+                ? sampling_ratio
+                : ceil(roi_width / pooled_width);
+
+            // We do average (integral) pooling inside a bin
+            const ACC_T count = roi_bin_grid_h * roi_bin_grid_w; // e.g. = 4
+
+            // we want to precalculate indices and weights shared by all
+            // channels, this is the key point of optimization
+            pre_calc.resize(
+                roi_bin_grid_h * roi_bin_grid_w * pooled_width *
+                pooled_height);
+            pre_calc_for_bilinear_interpolate(
+                height,
+                width,
+                pooled_height,
+                pooled_width,
+                roi_start_h,
+                roi_start_w,
+                bin_size_h,
+                bin_size_w,
+                roi_bin_grid_h,
+                roi_bin_grid_w,
+                pre_calc);
+
+            if (is_channels_last) {
+              roi_align_single_framework_channels_last_backward<T, ACC_T>(
+                  grad_output + n * channels * pooled_height * pooled_width +
+                      c_begin,
+                  count,
+                  channels,
+                  c_len,
+                  height,
+                  width,
+                  pooled_height,
+                  pooled_width,
+                  roi_bin_grid_h,
+                  roi_bin_grid_w,
+                  pre_calc,
+                  grad_input + b * channels * height * width + c_begin);
+            } else {
+              roi_align_single_framework_backward<T, ACC_T>(
+                  grad_output +
+                      (n * channels + c_begin) * pooled_height * pooled_width,
+                  count,
+                  c_len,
+                  height,
+                  width,
+                  pooled_height,
+                  pooled_width,
+                  roi_bin_grid_h,
+                  roi_bin_grid_w,
+                  pre_calc,
+                  grad_input + (b * channels + c_begin) * height * width);
+            }
+          } // for n
+        } // for task
+      });
 }
 
 at::Tensor roi_align_forward_kernel_impl(
@@ -770,6 +811,7 @@ at::Tensor roi_align_backward_kernel_impl(
             grad_.size(0),
             grad_.data_ptr<scalar_t>(),
             spatial_scale,
+            batch_size,
             channels,
             height,
             width,
@@ -240,6 +240,145 @@ at::Tensor tpp_linear_mul_kernel_impl(
   return t_out;
 }
 
+// Stacks a single adapter [C][R] / [R][K] as [1][C][R] / [1][R][K] and checks
+// that the adapters match the linear and each other.
+void check_lora_adapters(
+    const at::Tensor& t_in,
+    const at::Tensor& t_wt,
+    at::Tensor& t_lora_a,
+    at::Tensor& t_lora_b,
+    const at::Tensor& t_adapter_idx) {
+  if (t_lora_a.dim() == 2)
+    t_lora_a = t_lora_a.unsqueeze(0);
+  if (t_lora_b.dim() == 2)
+    t_lora_b = t_lora_b.unsqueeze(0);
+  auto wt_sizes = t_wt.sizes();
+  auto C = t_in.size(2);
+  auto K = wt_sizes[0] * wt_sizes[3];
+  TORCH_CHECK(
+      t_lora_a.dim() == 3 && t_lora_b.dim() == 3,
+      "tpp_linear_lora: expect LoRA A as [n_adapters, in_features, rank] and B as [n_adapters, rank, out_features]");
+  TORCH_CHECK(
+      t_lora_a.size(0) == t_lora_b.size(0) && t_lora_a.size(1) == C &&
+          t_lora_a.size(2) == t_lora_b.size(1) && t_lora_b.size(2) == K,
+      "tpp_linear_lora: LoRA A ",
+      t_lora_a.sizes(),
+      " and B ",
+      t_lora_b.sizes(),
+      " do not match a linear of ",
+      C,
+      " to ",
+      K,
+      " features");
+  TORCH_CHECK(
+      t_lora_a.scalar_type() == t_wt.scalar_type() &&
+          t_lora_b.scalar_type() == t_wt.scalar_type(),
+      "tpp_linear_lora: LoRA adapters must have the dtype of the weight");
+  TORCH_CHECK(
+      t_wt.scalar_type() != at::kBFloat16 || t_lora_a.size(2) % 2 == 0,
+      "tpp_linear_lora: BFloat16 adapters need an even rank");
+  if (t_adapter_idx.numel() > 0) {
+    TORCH_CHECK(
+        t_adapter_idx.scalar_type() == at::kLong &&
+            t_adapter_idx.is_contiguous(),
+        "tpp_linear_lora: expect contiguous int64 adapter indices");
+    TORCH_CHECK(
+        t_adapter_idx.numel() == t_in.size(0) * t_in.size(1),
+        "tpp_linear_lora: expect one adapter index per input row");
+    TORCH_CHECK(
+        t_adapter_idx.max().item<int64_t>() < t_lora_a.size(0),
+        "tpp_linear_lora: adapter index out of range");
+  }
+}
+
+at::Tensor tpp_linear_lora_kernel_impl(
+    const at::Tensor& t_in,
+    const at::Tensor& t_wt,
+    const at::Tensor& t_bias,
+    const at::Tensor& t_lora_a,
+    const at::Tensor& t_lora_b,
+    const at::Tensor& t_adapter_idx,
+    double scale) {
+  auto t_lora_a_ = t_lora_a;
+  auto t_lora_b_ = t_lora_b;
+  check_lora_adapters(t_in, t_wt, t_lora_a_, t_lora_b_, t_adapter_idx);
+  auto sizes = t_in.sizes().vec();
+  auto wt_sizes = t_wt.sizes();
+  sizes[2] = wt_sizes[0] * wt_sizes[3];
+
+  auto t_out = t_in.new_empty(sizes);
+  auto dt = t_wt.dtype();
+  if (dt == at::kFloat) {
+    torch_ipex::tpp::tpp_linear_lora<float>(
+        t_in, t_wt, t_bias, t_lora_a_, t_lora_b_, t_adapter_idx, scale, t_out);
+  } else if (dt == at::kBFloat16) {
+    torch_ipex::tpp::tpp_linear_lora<at::BFloat16>(
+        t_in, t_wt, t_bias, t_lora_a_, t_lora_b_, t_adapter_idx, scale, t_out);
+  } else {
+    AT_ASSERT(
+        0,
+        "TPP does not support current weight dtype %s:%d\n",
+        __FILE__,
+        __LINE__);
+  }
+  return t_out;
+}
+
+std::tuple<at::Tensor, at::Tensor, at::Tensor>
+tpp_linear_lora_backward_kernel_impl(
+    const at::Tensor& t_grad_out,
+    const at::Tensor& t_in,
+    const at::Tensor& t_wt,
+    const at::Tensor& t_lora_a,
+    const at::Tensor& t_lora_b,
+    const at::Tensor& t_adapter_idx,
+    double scale) {
+  auto t_lora_a_ = t_lora_a;
+  auto t_lora_b_ = t_lora_b;
+  check_lora_adapters(t_in, t_wt, t_lora_a_, t_lora_b_, t_adapter_idx);
+  auto t_grad_in = at::empty_like(t_in);
+  auto t_grad_a = at::empty_like(t_lora_a_);
+  auto t_grad_b = at::empty_like(t_lora_b_);
+  auto dt = t_wt.dtype();
+  if (dt == at::kFloat) {
+    torch_ipex::tpp::tpp_linear_lora_bwd<float>(
+        t_grad_out,
+        t_in,
+        t_wt,
+        t_lora_a_,
+        t_lora_b_,
+        t_adapter_idx,
+        scale,
+        t_grad_in,
+        t_grad_a,
+        t_grad_b);
+  } else if (dt == at::kBFloat16) {
+    torch_ipex::tpp::tpp_linear_lora_bwd<at::BFloat16>(
+        t_grad_out,
+        t_in,
+        t_wt,
+        t_lora_a_,
+        t_lora_b_,
+        t_adapter_idx,
+        scale,
+        t_grad_in,
+        t_grad_a,
+        t_grad_b);
+  } else {
+    AT_ASSERT(
+        0,
+        "TPP does not support current weight dtype %s:%d\n",
+        __FILE__,
+        __LINE__);
+  }
+  // Adapters given without the adapter dimension get their gradients back in
+  // the same shape.
+  return std::make_tuple(
+      t_grad_in,
+      t_grad_a.view(t_lora_a.sizes()),
+      t_grad_b.view(t_lora_b.sizes()));
+}
+
 } // namespace
 
 IPEX_REGISTER_DISPATCH(
@@ -265,6 +404,12 @@ IPEX_REGISTER_DISPATCH(tpp_linear_add_kernel_stub, &tpp_linear_add_kernel_impl);
 IPEX_REGISTER_DISPATCH(
     tpp_linear_add_add_kernel_stub,
     &tpp_linear_add_add_kernel_impl);
+IPEX_REGISTER_DISPATCH(
+    tpp_linear_lora_kernel_stub,
+    &tpp_linear_lora_kernel_impl);
+IPEX_REGISTER_DISPATCH(
+    tpp_linear_lora_backward_kernel_stub,
+    &tpp_linear_lora_backward_kernel_impl);
 } // namespace cpu
 } // namespace torch_ipex
 #endif
\ No newline at end of file
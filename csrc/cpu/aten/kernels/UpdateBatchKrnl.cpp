@@ -18,26 +18,62 @@ namespace {
 
 using namespace torch_ipex::cpu::kernel;
 
-#if defined(CPU_CAPABILITY_AVX512)
+#if defined(CPU_CAPABILITY_AVX512) || defined(CPU_CAPABILITY_AVX2)
 
-template <typename T>
+// hidden[:, idx, :] = hidden_prime[:, idx, :], parallel over the (layer, idx)
+// rows. hidden_prime may be in another dtype than hidden, e.g. fp32 states out
+// of the LSTM kept as bf16 for the next loop, the rows are converted on copy.
+template <typename T, typename T_prime>
 inline void update_hidden_kernel(
-    std::vector<int64_t> idx,
-    at::Tensor hidden,
-    at::Tensor hidden_prime) {
+    const std::vector<int64_t>& idx,
+    at::Tensor& hidden,
+    const at::Tensor& hidden_prime) {
   auto* hidden_ptr = hidden.data_ptr<T>();
-  auto* hidden_prime_ptr = hidden_prime.data_ptr<T>();
+  auto* hidden_prime_ptr = hidden_prime.data_ptr<T_prime>();
 
   int64_t idx_len = idx.size();
   int64_t ld = hidden.size(0);
-  int64_t bs = hidden.size(1);
   int64_t feature_size = hidden.size(2);
-  // TODO: at::parallel_for
-  for (int64_t i = 0; i < ld; i++) {
-    for (int64_t j = 0; j < idx_len; j++) {
-      auto pos = i * bs * feature_size + idx[j] * feature_size;
-      move_ker(&hidden_ptr[pos], &hidden_prime_ptr[pos], feature_size);
+  int64_t h_stride_l = hidden.stride(0);
+  int64_t h_stride_b = hidden.stride(1);
+  int64_t hp_stride_l = hidden_prime.stride(0);
+  int64_t hp_stride_b = hidden_prime.stride(1);
+  at::parallel_for(0, ld * idx_len, 16, [&](int64_t start, int64_t end) {
+    for (int64_t r = start; r < end; r++) {
+      auto i = r / idx_len;
+      auto j = idx[r % idx_len];
+      move_ker(
+          &hidden_ptr[i * h_stride_l + j * h_stride_b],
+          &hidden_prime_ptr[i * hp_stride_l + j * hp_stride_b],
+          feature_size);
     }
+  });
+}
+
+inline void update_hidden_kernel(
+    const std::vector<int64_t>& idx,
+    at::Tensor hidden,
+    const at::Tensor& hidden_prime) {
+  TORCH_CHECK(
+      hidden.stride(2) == 1 && hidden_prime.stride(2) == 1,
+      "rnnt_update_batch: the feature dim of hidden and hidden_prime should be contiguous");
+  TORCH_CHECK(
+      hidden.sizes() == hidden_prime.sizes(),
+      "rnnt_update_batch: hidden and hidden_prime should be in the same shape");
+  auto dtype = hidden.scalar_type();
+  auto prime_dtype = hidden_prime.scalar_type();
+  TORCH_CHECK(
+      (dtype == at::kBFloat16 || dtype == at::kFloat) &&
+          (prime_dtype == at::kBFloat16 || prime_dtype == at::kFloat),
+      "rnnt_update_batch: only support hidden and hidden_prime to be float or bf16 tensors");
+  if (dtype == at::kBFloat16 && prime_dtype == at::kBFloat16) {
+    update_hidden_kernel<at::BFloat16, at::BFloat16>(idx, hidden, hidden_prime);
+  } else if (dtype == at::kBFloat16) {
+    update_hidden_kernel<at::BFloat16, float>(idx, hidden, hidden_prime);
+  } else if (prime_dtype == at::kBFloat16) {
+    update_hidden_kernel<float, at::BFloat16>(idx, hidden, hidden_prime);
+  } else {
+    update_hidden_kernel<float, float>(idx, hidden, hidden_prime);
   }
 }
 
@@ -90,21 +126,16 @@ inline void label_index_put_kernel(
 
   int32_t* label_col_ptr = static_cast<int32_t*>(label_col.data_ptr());
 
-  at::parallel_for(0, batch_size, 16, [&](int64_t start, int64_t end) {
-    for (int64_t i = start; i < end; i++) {
-      label_tensor_out_ptr[i * max_len * max_symbols + label_col_ptr[i]] +=
-          label_to_put_out_ptr[i];
-    }
-  });
-
   // label_tensor.gather(1, label_col.to(torch.int64).unsqueeze(1))
-  // TODO: merge with label_tensor_out_ptr
+  // Every row is only touched by its own batch index, so the gather reads the
+  // label just accumulated in the same pass.
   int64_t* label_for_next_loop_out_ptr =
       static_cast<int64_t*>(label_for_next_loop_out.data_ptr());
   at::parallel_for(0, batch_size, 16, [&](int64_t start, int64_t end) {
     for (int64_t i = start; i < end; i++) {
-      label_for_next_loop_out_ptr[i] =
-          label_tensor_out_ptr[i * max_len * max_symbols + label_col_ptr[i]];
+      auto pos = i * max_len * max_symbols + label_col_ptr[i];
+      label_tensor_out_ptr[pos] += label_to_put_out_ptr[i];
+      label_for_next_loop_out_ptr[i] = label_tensor_out_ptr[pos];
     }
   });
 }
@@ -116,30 +147,21 @@ inline void update_hidden_idx_kernel(
     const at::Tensor& hidden_prime_0,
     const at::Tensor& hidden_prime_1,
     int64_t batch_size) {
-  std::vector<int64_t> idx;
   int32_t* not_blank_out_ptr = static_cast<int32_t*>(not_blank_out.data_ptr());
-  // TODO: merge idx into update_hidden_kernel
-  // Have data dependency here, shouldn't be parallelled
+  // idx = (not_blank).nonzero(as_tuple=True)[0], a cheap serial pass over the
+  // batch ahead of the parallel row copies.
+  std::vector<int64_t> idx;
+  idx.reserve(batch_size);
   for (int64_t i = 0; i < batch_size; i++) {
     if (not_blank_out_ptr[i] != 0)
       idx.push_back(i);
   }
-
-  AT_ASSERTM(
-      hidden_0.scalar_type() == hidden_1.scalar_type(),
-      "hidden_0 and hidden_1 should be in same dtype.");
-  AT_ASSERTM(
-      (hidden_0.scalar_type() == at::kBFloat16 ||
-       hidden_0.scalar_type() == at::kFloat),
-      "only support hidden_0 to be float or bf16 tensor");
-
-  if (hidden_0.scalar_type() == at::kBFloat16) {
-    update_hidden_kernel<at::BFloat16>(idx, hidden_0, hidden_prime_0);
-    update_hidden_kernel<at::BFloat16>(idx, hidden_1, hidden_prime_1);
-  } else {
-    update_hidden_kernel<float>(idx, hidden_0, hidden_prime_0);
-    update_hidden_kernel<float>(idx, hidden_1, hidden_prime_1);
+  if (idx.empty()) {
+    return;
   }
+
+  update_hidden_kernel(idx, hidden_0, hidden_prime_0);
+  update_hidden_kernel(idx, hidden_1, hidden_prime_1);
 }
 
 inline void update_feature_idx_kernel(
@@ -186,9 +208,11 @@ inline void update_feature_idx_kernel(
 
   hidden_0: the hx to be updated for next loop, [D∗num_layers, batch_size, 320],
   f32 or bf16 hidden_1: the cx to be updated for next loop, [D∗num_layers,
-  batch_size, 320], f32 hidden_prime_0: the hx calculated for the current loop,
-  [D∗num_layers, batch_size, 320], f32 or bf16 hidden_prime_1: the cx calculated
-  for the current loop, [D∗num_layers, batch_size, 320], f32 x: the feature got
+  batch_size, 320], f32 or bf16 hidden_prime_0: the hx calculated for the
+  current loop, [D∗num_layers, batch_size, 320], f32 or bf16, converted to the
+  dtype of hidden_0 on update hidden_prime_1: the cx calculated for the current
+  loop, [D∗num_layers, batch_size, 320], f32 or bf16, converted to the dtype of
+  hidden_1 on update x: the feature got
   from the encoder. dim 0 and dim1 of x has been transposed in the encoder,
   [batch_size, time_step, 1024], f32 or bf16 f: the feature of the corresponding
   time idx. [batch_size, 1, 1024],same dtype as x
@@ -223,7 +247,7 @@ bool rnnt_update_batch_kernel_impl(
     int64_t batch_size,
     int64_t _SOS,
     int64_t max_len) {
-#if defined(CPU_CAPABILITY_AVX512)
+#if defined(CPU_CAPABILITY_AVX512) || defined(CPU_CAPABILITY_AVX2)
   update_batch_kernel(
       k,
       out_lens,
@@ -303,12 +327,14 @@ bool rnnt_update_batch_kernel_impl(
   auto idx = not_blank_out.nonzero_numpy()[0];
   hidden_0.index_put_(
       {at::indexing::Slice(), idx, at::indexing::Slice()},
-      hidden_prime_0.index(
-          {at::indexing::Slice(), idx, at::indexing::Slice()}));
+      hidden_prime_0
+          .index({at::indexing::Slice(), idx, at::indexing::Slice()})
+          .to(hidden_0.scalar_type()));
   hidden_1.index_put_(
       {at::indexing::Slice(), idx, at::indexing::Slice()},
-      hidden_prime_1.index(
-          {at::indexing::Slice(), idx, at::indexing::Slice()}));
+      hidden_prime_1
+          .index({at::indexing::Slice(), idx, at::indexing::Slice()})
+          .to(hidden_1.scalar_type()));
 
   // label_col += not_blank
   // label_tensor.index_put_([label_row, label_col.to(torch.int64)],
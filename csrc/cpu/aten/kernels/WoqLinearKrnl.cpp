@@ -14,6 +14,7 @@
 #include <unordered_map>
 #include <vector>
 #include "mkl.h"
+#include "vec/vec.h"
 
 namespace torch_ipex {
 namespace cpu {
@@ -2464,6 +2465,45 @@ struct Function_matching<T1, T2, has_bias, 0> {
   }
 };
 
+#if !defined(CPU_CAPABILITY_AVX512)
+// Without AVX512 the weight is kept unpacked. A per channel int4 weight with
+// float qparams is dequantized row by row with the 256-bit kernel instead of
+// the scalar at::Tensor::dequantize.
+at::Tensor woq_dequantize_weight(const at::Tensor& weight) {
+#if defined(CPU_CAPABILITY_AVX2)
+  if (weight.scalar_type() == c10::ScalarType::QUInt4x2 &&
+      weight.qscheme() == c10::kPerChannelAffineFloatQParams &&
+      weight.dim() == 2 && weight.q_per_channel_axis() == 0 &&
+      weight.size(1) % 2 == 0) {
+    auto N = weight.size(0);
+    auto K = weight.size(1);
+    auto weight_contig = weight.contiguous();
+    auto scales = weight.q_per_channel_scales().to(c10::kFloat).contiguous();
+    auto zero_points =
+        weight.q_per_channel_zero_points().to(c10::kFloat).contiguous();
+    auto weight_dequant =
+        at::empty({N, K}, at::device(c10::kCPU).dtype(c10::kFloat));
+    auto weight_ptr = reinterpret_cast<uint8_t*>(weight_contig.data_ptr());
+    auto scales_ptr = scales.data_ptr<float>();
+    auto zero_points_ptr = zero_points.data_ptr<float>();
+    auto weight_dequant_ptr = weight_dequant.data_ptr<float>();
+    at::parallel_for(0, N, 1, [&](int64_t start, int64_t end) {
+      for (const auto n : c10::irange(start, end)) {
+        kernel::_dequant_int4_row(
+            weight_ptr + n * K / 2,
+            weight_dequant_ptr + n * K,
+            K,
+            scales_ptr[n],
+            zero_points_ptr[n]);
+      }
+    });
+    return weight_dequant;
+  }
+#endif
+  return weight.dequantize();
+}
+#endif
+
 void woq_gemm_kernel_impl(
     const at::Tensor& self,
     const at::Tensor& weight,
@@ -2810,14 +2850,14 @@ void woq_gemm_kernel_impl(
   }
 #else
   if (self.scalar_type() == c10::ScalarType::Float) {
-    auto w = weight.dequantize();
+    auto w = woq_dequantize_weight(weight);
     if (bias.defined()) {
       at::linear_out(output, self, w, bias.detach());
     } else {
       at::linear_out(output, self, w);
     }
   } else if (self_.scalar_type() == at::kBFloat16) {
-    auto w = weight.dequantize();
+    auto w = woq_dequantize_weight(weight);
     auto x = self.to(c10::ScalarType::Float);
     // This is to align with the AVX512 kernel
     // so that UT test_weight_only_quantization_autocast can pass
@@ -2830,7 +2870,9 @@ void woq_gemm_kernel_impl(
     }
     output = out.to(self.scalar_type());
   } else {
-    auto w = weight.dequantize().to(self_.scalar_type()).to(c10::kFloat);
+    auto w = woq_dequantize_weight(weight)
+                 .to(self_.scalar_type())
+                 .to(c10::kFloat);
     auto x = self.to(c10::ScalarType::Float);
     auto out = at::linear(x, w);
     if (bias.defined()) {
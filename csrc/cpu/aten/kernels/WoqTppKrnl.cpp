@@ -5,7 +5,10 @@
 #include <ATen/cpu/vec/functional.h>
 #include <ATen/cpu/vec/vec.h>
 #include <aten/Linear.h>
+#include <utils/long_lived_alloc.h>
+#include "csrc/cpu/tpp/prefetch.h"
 #include "csrc/cpu/tpp/woq/tla.h"
+#include "vec/vec.h"
 
 #ifdef __GNUC__
 #include <features.h>
@@ -135,7 +138,22 @@ float dequantize_nf4_scalar(uint8_t val) {
 
 #define SMALL_BATCH_THRESHOLD 32
 #define PARALLEL_M_THRESHOLD 128
-constexpr long PREFETCH_K_DIST = 64; // TODO(jgong5): do not hard-code
+// Kernels instantiated with PREFETCH_K_DIST > 0 prefetch the weight rows
+// woq_prefetch_k_dist ahead into L1, TPP_WOQ_PREFETCH_K_DIST tunes it and 0
+// turns the prefetch off.
+constexpr long PREFETCH_K_DIST = 64;
+static const long woq_prefetch_k_dist = [] {
+  long dist = env2int("TPP_WOQ_PREFETCH_K_DIST", PREFETCH_K_DIST);
+  if (dist < 0) {
+    TORCH_WARN(
+        "TPP_WOQ_PREFETCH_K_DIST must not be negative, got ",
+        dist,
+        "; using ",
+        PREFETCH_K_DIST);
+    return PREFETCH_K_DIST;
+  }
+  return dist;
+}();
 constexpr long LOOP_K_UNROLL = 4; // TODO(jgong5): do not hard-code
 
 #define UNQUANT_A -1
@@ -710,14 +728,17 @@ struct GemmMicroKernel<
           }
         }
         if constexpr (PREFETCH_K_DIST > 0) {
-          if constexpr (is_4bit_flag) {
-            _mm_prefetch(
-                ADDRESS(B, k + PREFETCH_K_DIST, col * V::VLEN / 2, ldb / 2),
-                _MM_HINT_T0);
-          } else {
-            _mm_prefetch(
-                ADDRESS(B, k + PREFETCH_K_DIST, col * V::VLEN, ldb),
-                _MM_HINT_T0);
+          if (woq_prefetch_k_dist > 0) {
+            if constexpr (is_4bit_flag) {
+              _mm_prefetch(
+                  ADDRESS(
+                      B, k + woq_prefetch_k_dist, col * V::VLEN / 2, ldb / 2),
+                  _MM_HINT_T0);
+            } else {
+              _mm_prefetch(
+                  ADDRESS(B, k + woq_prefetch_k_dist, col * V::VLEN, ldb),
+                  _MM_HINT_T0);
+            }
           }
         }
       }
@@ -838,7 +859,10 @@ struct GemmMicroKernel<
         vb[col] = _mm512_sub_epi8(vb[col], vzps[col]);
         vcompensate[col] = _mm512_dpbusd_epi32(vcompensate[col], ones, vb[col]);
         if constexpr (PREFETCH_K_DIST > 0) {
-          _mm_prefetch(pqB[(k + PREFETCH_K_DIST) / 4][col * 16], _MM_HINT_T0);
+          if (woq_prefetch_k_dist > 0) {
+            _mm_prefetch(
+                pqB[(k + woq_prefetch_k_dist) / 4][col * 16], _MM_HINT_T0);
+          }
         }
       }
 
@@ -1720,6 +1744,13 @@ void qlinear_woq_affine_impl(
   auto pw = GetVLAPtr<uint8_t>(
       (uint8_t*)qw_packed.data_ptr(), {Kc, Kb * (is_4bit_flag ? Nb / 2 : Nb)});
   auto py = GetVLAPtr<Tout>(y, {Nc, Nb}); /*[M, Nc, Nb]*/
+  // Each thread walks pw[nc][kc] in address order in both loops below, so
+  // small M (decode) runs as a weight stream with an L2 prefetch ahead.
+  auto w_block_bytes = Kb * (is_4bit_flag ? Nb / 2 : Nb);
+  auto w_prefetch = WeightStreamPrefetch(
+      qw_packed.data_ptr(), qw_packed.nbytes(), M <= GEMV_M_THRESHOLD);
+  auto next_w_prefetch =
+      NextWeightPrefetch(qw_packed.data_ptr(), M <= GEMV_M_THRESHOLD);
   auto py_concat = GetVLAPtr<Tout>(
       y, {M, Nc / num_concats, Nb}); /*[num_concats, M, Nc/num_concats, Nb]*/
   int scales_kc = quant_w_mode == QUANT_W_PER_CHANNEL ? QUANT_W_PER_K_BLOCK
@@ -1961,6 +1992,7 @@ void qlinear_woq_affine_impl(
                       }
                     }
                     bool is_rem = (m + BLOCK_M > M);
+                    w_prefetch(pw[nc][kc], w_block_bytes);
                     TGemmOut* y_ptr = num_concats <= 1
                         ? (TGemmOut*)py[m][nc]
                         : (TGemmOut*)py_concat[nc / (Nc / num_concats)][m]
@@ -2041,7 +2073,10 @@ void qlinear_woq_affine_impl(
                     // TODO(jgong5): post-op fusion
                   },
                   [&]() { dequant_gemm_tpp.config(); },
-                  [&]() { dequant_gemm_tpp.release(); });
+                  [&]() {
+                    dequant_gemm_tpp.release();
+                    next_w_prefetch();
+                  });
             } else {
               auto num_threads = omp_get_max_threads();
               TGemmOut* y_private = nullptr;
@@ -2105,6 +2140,7 @@ void qlinear_woq_affine_impl(
                       }
                     }
                     for (int kc = kc_start; kc < kc_end; kc++) {
+                      w_prefetch(pw[nc][kc], w_block_bytes);
                       TComp* x_ptr = (TComp*)px[m][kc];
                       float* scale_a = nullptr;
                       int32_t* zp_a = nullptr;
@@ -2223,7 +2259,10 @@ void qlinear_woq_affine_impl(
                     }
                   },
                   [&]() { dequant_gemm_tpp.config(); },
-                  [&]() { dequant_gemm_tpp.release(); });
+                  [&]() {
+                    dequant_gemm_tpp.release();
+                    next_w_prefetch();
+                  });
               if (k_splits > 1) {
                 TLA_ASSERT(
                     M % BLOCK_M == 0,
@@ -2289,7 +2328,8 @@ at::Tensor qlinear_woq_pack(
   const int Kc = K / block_k;
   if (is_4bit_flag) {
     // TODO(jgong5): support lowp_mode == LOWP_MODE_INT8
-    auto result = at::empty({Nc, Kc, block_k, block_n / 2}, qw.options());
+    auto result = utils::empty_long_lived(
+        {Nc, Kc, block_k, block_n / 2}, qw.options());
     // Pack weight in [N,K] to [N/block_n, K/block_k, block_k, block_n]
     // And then, pre-shuffle per 32 or 64 4-bit values to save shuffle at
     // runtime Take 32 4-bit values as an example below: x0 x1 x2 x3 x4 x5 x6 x7
@@ -2330,7 +2370,8 @@ at::Tensor qlinear_woq_pack(
     TLA_ASSERT(
         lowp_mode != LOWP_MODE_INT8,
         "lowp mode int8 is not supported yet with int8 weight");
-    auto result = at::empty({Nc, Kc, block_k, block_n}, qw.options());
+    auto result =
+        utils::empty_long_lived({Nc, Kc, block_k, block_n}, qw.options());
     // Pack weight in [N,K] to [N/block_n, K/block_k, block_k, block_n]
     int8_t* src_data = (int8_t*)qw.data_ptr();
     int8_t* dst_data = (int8_t*)result.data_ptr();
@@ -3556,6 +3597,38 @@ at::Tensor qlinear_woq_affine(
         } else if (qw_type == QINT4) {
           TLA_ASSERT(
               !sym_quant, "Weight must be asymmetrically quantized for INT4");
+#if defined(CPU_CAPABILITY_AVX2)
+          if (quant_w_mode == 0 && scales_list[fp32_idx].numel() == N &&
+              zp_list[fp32_idx].numel() == N) {
+            // per channel int4, dequantized row by row with the 256-bit
+            // kernel instead of the unpack + sub + mul op chain below
+            auto Kw = qw.size(1) * 2;
+            auto qw_c = qw.contiguous();
+            auto scale_c = scales_list[fp32_idx].to(at::kFloat).contiguous();
+            auto zp_c = zp_list[fp32_idx].to(at::kFloat).contiguous();
+            auto dqw = at::empty({N, Kw}, qw.options().dtype(at::kFloat));
+            auto qw_ptr = qw_c.data_ptr<uint8_t>();
+            auto scale_ptr = scale_c.data_ptr<float>();
+            auto zp_ptr = zp_c.data_ptr<float>();
+            auto dqw_ptr = dqw.data_ptr<float>();
+            at::parallel_for(0, N, 1, [&](int64_t start, int64_t end) {
+              for (int64_t n = start; n < end; n++) {
+                kernel::_dequant_int4_row(
+                    qw_ptr + n * Kw / 2,
+                    dqw_ptr + n * Kw,
+                    Kw,
+                    scale_ptr[n],
+                    zp_ptr[n]);
+              }
+            });
+            if (K != Kw) {
+              TORCH_CHECK(
+                  K < Kw, "WOQ Linear kernel: Unexpected weight shape");
+              return dqw.narrow(1, 0, K);
+            }
+            return dqw;
+          }
+#endif
           using namespace at::indexing;
           auto w_int8 =
               at::empty({N, qw.size(1) * 2}, qw.options().dtype(at::kByte));
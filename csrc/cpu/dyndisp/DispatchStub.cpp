@@ -9,6 +9,7 @@
 #include <algorithm>
 #include <cstdlib>
 #include <cstring>
+#include <mutex>
 
 namespace torch_ipex {
 namespace cpu {
@@ -148,6 +149,29 @@ cpu_isa ipex_isa_to_onednn_isa(CPUCapability ipex_isa) {
   }
 }
 
+bool parse_cpu_capability(const char* name, CPUCapability& isa) {
+  if (strcmp(name, "avx512_fp16") == 0) {
+    isa = CPUCapability::AVX512_FP16;
+  } else if (strcmp(name, "amx") == 0) {
+    isa = CPUCapability::AMX;
+  } else if (strcmp(name, "avx512_bf16") == 0) {
+    isa = CPUCapability::AVX512_BF16;
+  } else if (strcmp(name, "avx512_vnni") == 0) {
+    isa = CPUCapability::AVX512_VNNI;
+  } else if (strcmp(name, "avx512") == 0) {
+    isa = CPUCapability::AVX512;
+  } else if (strcmp(name, "avx2_vnni") == 0) {
+    isa = CPUCapability::AVX2_VNNI;
+  } else if (strcmp(name, "avx2") == 0) {
+    isa = CPUCapability::AVX2;
+  } else if (strcmp(name, "default") == 0) {
+    isa = CPUCapability::DEFAULT;
+  } else {
+    return false;
+  }
+  return true;
+}
+
 static CPUCapability compute_cpu_capability() {
   CPUCapability highest_cpu_supported_isa_level =
       _get_highest_cpu_support_isa_level();
@@ -163,25 +187,9 @@ static CPUCapability compute_cpu_capability() {
   */
   auto envar = std::getenv("ATEN_CPU_CAPABILITY");
   if (envar) {
-    if (strcmp(envar, "avx512_fp16") == 0) {
-      manual_setup_isa_level = CPUCapability::AVX512_FP16;
-    } else if (strcmp(envar, "amx") == 0) {
-      manual_setup_isa_level = CPUCapability::AMX;
-    } else if (strcmp(envar, "avx512_bf16") == 0) {
-      manual_setup_isa_level = CPUCapability::AVX512_BF16;
-    } else if (strcmp(envar, "avx512_vnni") == 0) {
-      manual_setup_isa_level = CPUCapability::AVX512_VNNI;
-    } else if (strcmp(envar, "avx512") == 0) {
-      manual_setup_isa_level = CPUCapability::AVX512;
-    } else if (strcmp(envar, "avx2_vnni") == 0) {
-      manual_setup_isa_level = CPUCapability::AVX2_VNNI;
-    } else if (strcmp(envar, "avx2") == 0) {
-      manual_setup_isa_level = CPUCapability::AVX2;
-    } else if (strcmp(envar, "default") == 0) {
-      manual_setup_isa_level = CPUCapability::DEFAULT;
-    } else {
+    b_manual_setup = parse_cpu_capability(envar, manual_setup_isa_level);
+    if (!b_manual_setup) {
       TORCH_WARN("ignoring invalid value for ATEN_CPU_CAPABILITY: ", envar);
-      b_manual_setup = false;
     }
   } else {
     b_manual_setup = false;
@@ -244,9 +252,12 @@ void* DispatchStubImpl::get_call_ptr(
   switch (device_type) {
     case DeviceType::CPU: {
       // Use memory_order_relaxed here since even if two threads race,
-      // they will still compute the same value for cpu_dispatch_ptr.
+      // they will still compute the same value for cpu_dispatch_ptr. Only
+      // set_dispatch_stub_capability() changes the value, it bumps
+      // selection_epoch before clearing cpu_dispatch_ptr.
       auto fptr = cpu_dispatch_ptr.load(std::memory_order_relaxed);
-      if (!fptr) {
+      while (!fptr) {
+        auto epoch = selection_epoch.load();
         fptr = choose_cpu_impl(
             DEFAULT
 #ifdef HAVE_AVX512_FP16_CPU_DEFINITION
@@ -278,7 +289,11 @@ void* DispatchStubImpl::get_call_ptr(
             AVX2
 #endif
         );
-        cpu_dispatch_ptr.store(fptr, std::memory_order_relaxed);
+        cpu_dispatch_ptr.store(fptr);
+        if (epoch != selection_epoch.load()) {
+          // the override changed meanwhile, choose again
+          fptr = nullptr;
+        }
       }
       return fptr;
     }
@@ -326,8 +341,15 @@ void* DispatchStubImpl::choose_cpu_impl(
     void* AVX2
 #endif
 ) {
-  auto capability = static_cast<int>(get_cpu_capability());
+  auto override_capability = override_isa.load();
+  auto capability = override_capability >= 0
+      ? override_capability
+      : static_cast<int>(get_cpu_capability());
   (void)capability;
+  auto select = [this](CPUCapability isa, void* fn) {
+    selected_isa.store(static_cast<int>(isa), std::memory_order_relaxed);
+    return fn;
+  };
 #ifdef HAVE_AVX512_FP16_CPU_DEFINITION
   if (capability >= static_cast<int>(CPUCapability::AVX512_FP16)) {
     // Quantization kernels have also been disabled on Windows
@@ -336,9 +358,9 @@ void* DispatchStubImpl::choose_cpu_impl(
     if (C10_UNLIKELY(!AVX512_FP16)) {
       // dispatch to AVX2, since the AVX512 kernel is missing
       TORCH_INTERNAL_ASSERT(AVX2, "DispatchStub: missing AVX2 kernel");
-      return AVX2;
+      return select(CPUCapability::AVX2, AVX2);
     } else {
-      return AVX512_FP16;
+      return select(CPUCapability::AVX512_FP16, AVX512_FP16);
     }
   }
 #endif
@@ -350,9 +372,9 @@ void* DispatchStubImpl::choose_cpu_impl(
     if (C10_UNLIKELY(!AMX)) {
       // dispatch to AVX2, since the AVX512 kernel is missing
       TORCH_INTERNAL_ASSERT(AVX2, "DispatchStub: missing AVX2 kernel");
-      return AVX2;
+      return select(CPUCapability::AVX2, AVX2);
     } else {
-      return AMX;
+      return select(CPUCapability::AMX, AMX);
     }
   }
 #endif
@@ -364,9 +386,9 @@ void* DispatchStubImpl::choose_cpu_impl(
     if (C10_UNLIKELY(!AVX512_BF16)) {
       // dispatch to AVX2, since the AVX512 kernel is missing
       TORCH_INTERNAL_ASSERT(AVX2, "DispatchStub: missing AVX2 kernel");
-      return AVX2;
+      return select(CPUCapability::AVX2, AVX2);
     } else {
-      return AVX512_BF16;
+      return select(CPUCapability::AVX512_BF16, AVX512_BF16);
     }
   }
 #endif
@@ -378,9 +400,9 @@ void* DispatchStubImpl::choose_cpu_impl(
     if (C10_UNLIKELY(!AVX512_VNNI)) {
       // dispatch to AVX2, since the AVX512 kernel is missing
       TORCH_INTERNAL_ASSERT(AVX2, "DispatchStub: missing AVX2 kernel");
-      return AVX2;
+      return select(CPUCapability::AVX2, AVX2);
     } else {
-      return AVX512_VNNI;
+      return select(CPUCapability::AVX512_VNNI, AVX512_VNNI);
     }
   }
 #endif
@@ -392,27 +414,132 @@ void* DispatchStubImpl::choose_cpu_impl(
     if (C10_UNLIKELY(!AVX512)) {
       // dispatch to AVX2, since the AVX512 kernel is missing
       TORCH_INTERNAL_ASSERT(AVX2, "DispatchStub: missing AVX2 kernel");
-      return AVX2;
+      return select(CPUCapability::AVX2, AVX2);
     } else {
-      return AVX512;
+      return select(CPUCapability::AVX512, AVX512);
     }
   }
 #endif
 #ifdef HAVE_AVX2_VNNI_CPU_DEFINITION
   if (capability >= static_cast<int>(CPUCapability::AVX2_VNNI)) {
     TORCH_INTERNAL_ASSERT(AVX2_VNNI, "DispatchStub: missing AVX2_VNNI kernel");
-    return AVX2_VNNI;
+    return select(CPUCapability::AVX2_VNNI, AVX2_VNNI);
   }
 #endif
 #ifdef HAVE_AVX2_CPU_DEFINITION
   if (capability >= static_cast<int>(CPUCapability::AVX2)) {
     TORCH_INTERNAL_ASSERT(AVX2, "DispatchStub: missing AVX2 kernel");
-    return AVX2;
+    return select(CPUCapability::AVX2, AVX2);
   }
 #endif
 
   TORCH_INTERNAL_ASSERT(DEFAULT, "DispatchStub: missing default kernel");
-  return DEFAULT;
+  return select(CPUCapability::DEFAULT, DEFAULT);
+}
+
+std::atomic<bool> DispatchStubImpl::count_calls{false};
+
+struct DispatchStubEntry {
+  DispatchStubImpl* impl;
+  DispatchStubImpl::VariantFn variant;
+};
+
+// Stubs are registered by static initializers of other translation units,
+// so the registry is created on first use.
+static std::vector<DispatchStubEntry>& dispatch_stub_registry() {
+  static std::vector<DispatchStubEntry> registry;
+  return registry;
+}
+
+static std::mutex& dispatch_stub_registry_mutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+void DispatchStubImpl::register_stub(const char* stub_name, VariantFn variant) {
+  name = stub_name;
+  std::lock_guard<std::mutex> lock(dispatch_stub_registry_mutex());
+  dispatch_stub_registry().push_back({this, variant});
+}
+
+static bool match_stub_name(const std::string& pattern, const char* name) {
+  if (!pattern.empty() && pattern.back() == '*') {
+    return strncmp(name, pattern.c_str(), pattern.size() - 1) == 0;
+  }
+  return pattern == name;
+}
+
+static int64_t update_stub_override(const std::string& pattern, int isa) {
+  std::lock_guard<std::mutex> lock(dispatch_stub_registry_mutex());
+  int64_t matched = 0;
+  for (auto& entry : dispatch_stub_registry()) {
+    auto impl = entry.impl;
+    if (match_stub_name(pattern, impl->name)) {
+      impl->override_isa.store(isa);
+      impl->selection_epoch.fetch_add(1);
+      impl->cpu_dispatch_ptr.store(nullptr);
+      matched++;
+    }
+  }
+  return matched;
+}
+
+int64_t set_dispatch_stub_capability(
+    const std::string& pattern,
+    CPUCapability isa) {
+  CPUCapability max_support_isa_level = std::min(
+      _get_highest_cpu_support_isa_level(),
+      _get_highest_binary_support_isa_level());
+  TORCH_CHECK(
+      isa <= max_support_isa_level,
+      "DispatchStub: ",
+      CPUCapabilityToString(isa),
+      " is not supported, the highest available level is ",
+      CPUCapabilityToString(max_support_isa_level));
+  return update_stub_override(pattern, static_cast<int>(isa));
+}
+
+int64_t reset_dispatch_stub_capability(const std::string& pattern) {
+  return update_stub_override(pattern, -1);
+}
+
+std::vector<DispatchStubInfo> get_dispatch_stub_info() {
+  std::lock_guard<std::mutex> lock(dispatch_stub_registry_mutex());
+  std::vector<DispatchStubInfo> infos;
+  for (auto& entry : dispatch_stub_registry()) {
+    auto impl = entry.impl;
+    DispatchStubInfo info;
+    info.name = impl->name;
+    for (int i = 0; i < static_cast<int>(CPUCapability::NUM_OPTIONS); i++) {
+      auto isa = static_cast<CPUCapability>(i);
+      if (entry.variant(isa)) {
+        info.compiled.push_back(isa);
+      }
+      info.calls[i] = impl->call_counts[i].load(std::memory_order_relaxed);
+    }
+    auto selected = impl->selected_isa.load();
+    info.selected = selected >= 0 ? static_cast<CPUCapability>(selected)
+                                  : CPUCapability::NUM_OPTIONS;
+    auto override_isa = impl->override_isa.load();
+    info.override_isa = override_isa >= 0
+        ? static_cast<CPUCapability>(override_isa)
+        : CPUCapability::NUM_OPTIONS;
+    infos.push_back(std::move(info));
+  }
+  return infos;
+}
+
+void set_dispatch_stub_call_counting(bool enabled) {
+  DispatchStubImpl::count_calls.store(enabled);
+}
+
+void reset_dispatch_stub_call_counts() {
+  std::lock_guard<std::mutex> lock(dispatch_stub_registry_mutex());
+  for (auto& entry : dispatch_stub_registry()) {
+    for (auto& count : entry.impl->call_counts) {
+      count.store(0, std::memory_order_relaxed);
+    }
+  }
 }
 
 } // namespace cpu
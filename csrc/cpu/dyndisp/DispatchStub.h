@@ -5,8 +5,11 @@
 #include <c10/util/Exception.h>
 
 #include <Macros.h>
+#include <array>
 #include <atomic>
+#include <string>
 #include <type_traits>
+#include <vector>
 
 using namespace c10;
 
@@ -70,6 +73,42 @@ bool check_not_sync_onednn_isa_level();
 
 CPUCapability get_cpu_capability();
 
+// Parses the lower case names accepted by ATEN_CPU_CAPABILITY, e.g. "avx2".
+// Returns false if `name` is not one of them.
+bool parse_cpu_capability(const char* name, CPUCapability& isa);
+
+// Runtime view of a registered DispatchStub, see get_dispatch_stub_info().
+struct DispatchStubInfo {
+  std::string name;
+  // capabilities with a kernel compiled into the binary
+  std::vector<CPUCapability> compiled;
+  // capability of the kernel in use, NUM_OPTIONS until the first call
+  CPUCapability selected;
+  // capability requested by set_dispatch_stub_capability(), NUM_OPTIONS if
+  // the stub follows the process wide get_cpu_capability()
+  CPUCapability override_isa;
+  // calls per selected capability, only counted while
+  // set_dispatch_stub_call_counting(true) is in effect
+  std::array<int64_t, static_cast<int>(CPUCapability::NUM_OPTIONS)> calls;
+};
+
+IPEX_API std::vector<DispatchStubInfo> get_dispatch_stub_info();
+
+// Makes the stubs matching `pattern` dispatch as if get_cpu_capability()
+// returned `isa`, from their next call on. `pattern` is a stub name, a
+// prefix ending with '*' to select a group of stubs, or "*" for all of them.
+// `isa` must be supported by both the cpu and the binary, a stub without a
+// kernel for it falls back the same way as for the process wide capability.
+// Returns the number of matched stubs.
+IPEX_API int64_t
+set_dispatch_stub_capability(const std::string& pattern, CPUCapability isa);
+
+// Drops the override of the stubs matching `pattern`.
+IPEX_API int64_t reset_dispatch_stub_capability(const std::string& pattern);
+
+IPEX_API void set_dispatch_stub_call_counting(bool enabled);
+IPEX_API void reset_dispatch_stub_call_counts();
+
 template <typename FnPtr, typename T>
 struct DispatchStub;
 
@@ -80,6 +119,23 @@ struct DispatchStub;
  * number of specialization of the DispatchStub<> class.
  */
 struct IPEX_API DispatchStubImpl {
+  using VariantFn = void* (*)(CPUCapability);
+
+  // Called once per stub object, `variant` returns the registered kernel of a
+  // capability or nullptr.
+  void register_stub(const char* stub_name, VariantFn variant);
+
+  void count_call() {
+    auto isa = selected_isa.load(std::memory_order_relaxed);
+    if (isa >= 0) {
+      call_counts[isa].fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  static bool call_counting_enabled() {
+    return count_calls.load(std::memory_order_relaxed);
+  }
+
   void* get_call_ptr(
       DeviceType device_type,
       void* DEFAULT
@@ -159,6 +215,18 @@ struct IPEX_API DispatchStubImpl {
   std::atomic<void*> cpu_dispatch_ptr{nullptr};
   void* xpu_dispatch_ptr = nullptr;
 #endif
+
+  const char* name = nullptr;
+  // CPUCapability values, -1 when not chosen yet / not overridden
+  std::atomic<int> selected_isa{-1};
+  std::atomic<int> override_isa{-1};
+  // bumped on every override change, so that a concurrent choose_cpu_impl()
+  // can not publish a kernel picked with the previous setting
+  std::atomic<int> selection_epoch{0};
+  std::atomic<int64_t>
+      call_counts[static_cast<int>(CPUCapability::NUM_OPTIONS)] = {};
+
+  static std::atomic<bool> count_calls;
 };
 
 template <typename rT, typename T, typename... Args>
@@ -166,6 +234,9 @@ struct DispatchStub<rT (*)(Args...), T> {
   using FnPtr = rT (*)(Args...);
 
   DispatchStub() = default;
+  explicit DispatchStub(const char* name) {
+    impl.register_stub(name, &get_variant);
+  }
   DispatchStub(const DispatchStub&) = delete;
   DispatchStub& operator=(const DispatchStub&) = delete;
 
@@ -209,6 +280,9 @@ struct DispatchStub<rT (*)(Args...), T> {
   template <typename... ArgTypes>
   rT operator()(DeviceType device_type, ArgTypes&&... args) {
     FnPtr call_ptr = get_call_ptr(device_type);
+    if (C10_UNLIKELY(DispatchStubImpl::call_counting_enabled())) {
+      impl.count_call();
+    }
     return (*call_ptr)(std::forward<ArgTypes>(args)...);
   }
 
@@ -240,6 +314,43 @@ struct DispatchStub<rT (*)(Args...), T> {
 #endif
 
  private:
+  static void* get_variant(CPUCapability isa) {
+    switch (isa) {
+      case CPUCapability::DEFAULT:
+        return reinterpret_cast<void*>(DEFAULT);
+#ifdef HAVE_AVX512_FP16_CPU_DEFINITION
+      case CPUCapability::AVX512_FP16:
+        return reinterpret_cast<void*>(AVX512_FP16);
+#endif
+#ifdef HAVE_AMX_CPU_DEFINITION
+      case CPUCapability::AMX:
+        return reinterpret_cast<void*>(AMX);
+#endif
+#ifdef HAVE_AVX512_BF16_CPU_DEFINITION
+      case CPUCapability::AVX512_BF16:
+        return reinterpret_cast<void*>(AVX512_BF16);
+#endif
+#ifdef HAVE_AVX512_VNNI_CPU_DEFINITION
+      case CPUCapability::AVX512_VNNI:
+        return reinterpret_cast<void*>(AVX512_VNNI);
+#endif
+#ifdef HAVE_AVX512_CPU_DEFINITION
+      case CPUCapability::AVX512:
+        return reinterpret_cast<void*>(AVX512);
+#endif
+#ifdef HAVE_AVX2_VNNI_CPU_DEFINITION
+      case CPUCapability::AVX2_VNNI:
+        return reinterpret_cast<void*>(AVX2_VNNI);
+#endif
+#ifdef HAVE_AVX2_CPU_DEFINITION
+      case CPUCapability::AVX2:
+        return reinterpret_cast<void*>(AVX2);
+#endif
+      default:
+        return nullptr;
+    }
+  }
+
   DispatchStubImpl impl;
 };
 
@@ -265,12 +376,12 @@ struct RegisterHIPDispatch {
 // adding parentheses and using helper struct to get rid of the parentheses, do
 // not work with MSVC. So do a `using`-declaration if you need to pass in such
 // `fn`, e.g., grid_sampler_2d_backward_cpu_kernel in GridSampleKernel.h.
-#define IPEX_DECLARE_DISPATCH(fn, name)    \
-  struct name : DispatchStub<fn, name> {   \
-    name() = default;                      \
-    name(const name&) = delete;            \
-    name& operator=(const name&) = delete; \
-  };                                       \
+#define IPEX_DECLARE_DISPATCH(fn, name)       \
+  struct name : DispatchStub<fn, name> {      \
+    name() : DispatchStub<fn, name>(#name) {} \
+    name(const name&) = delete;               \
+    name& operator=(const name&) = delete;    \
+  };                                          \
   extern IPEX_API struct name name
 
 #define IPEX_DEFINE_DISPATCH(name) struct name name
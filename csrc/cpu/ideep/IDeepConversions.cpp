@@ -2,6 +2,7 @@
 #include <ATen/OpaqueTensorImpl.h>
 #include <Macros.h>
 #include <c10/core/Allocator.h>
+#include "utils/long_lived_alloc.h"
 
 namespace torch_ipex {
 
@@ -228,7 +229,8 @@ at::Tensor mkldnn_to_dense(
 // Init a aten tensor according to ideep tensor's desc.
 at::Tensor empty_aten_tensor_from_desc(
     const ideep::tensor::desc& desc,
-    const at::TensorOptions& options) {
+    const at::TensorOptions& options,
+    bool long_lived) {
   auto ndims = dynamic_cast<const dnnl::memory::desc*>(&desc)
                    ->get_ndims(); // desc.data.ndims;
   auto nblks = desc.get_inner_nblks(); // desc.blocking_desc().inner_nblks;
@@ -244,6 +246,9 @@ at::Tensor empty_aten_tensor_from_desc(
   for (auto i = 0; i < ndims; i++) {
     at_sizes[i] = padded_dims[i] / blk_size_per_dim[i];
   }
+  if (long_lived) {
+    return utils::empty_long_lived(at_sizes, options);
+  }
   return at::empty(at_sizes, options);
 }
 
@@ -35,9 +35,12 @@ at::Tensor mkldnn_to_dense(
     const at::Tensor& self,
     c10::optional<at::ScalarType> dtype = c10::nullopt);
 
+// With long_lived set, the tensor is allocated by utils::empty_long_lived,
+// e.g. for packed weights.
 at::Tensor empty_aten_tensor_from_desc(
     const ideep::tensor::desc& desc,
-    const at::TensorOptions& options);
+    const at::TensorOptions& options,
+    bool long_lived = false);
 
 // ##Background##
 // This function returns the input tensor's stride with a workaround that checks
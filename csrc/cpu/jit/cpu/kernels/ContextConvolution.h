@@ -4,10 +4,27 @@
 
 #include <ideep.hpp>
 
+#include <memory>
+#include <mutex>
+
 namespace torch_ipex {
 namespace cpu {
 namespace detail {
 
+// fp32 weight and bias in the layout of the fused block kernels which do not
+// run the oneDNN primitive, see convolution_inverted_residual_run. They are
+// built from the packed weight the first time the conv enters a fused block,
+// and rebuilt when the version of the packed weight or bias changes, e.g.
+// after load_from_ctx copied a new state dict into them.
+struct BlockWeightCache {
+  std::mutex mutex;
+  // versions of at_weight_/at_bias_ the cache was built from, -1 if not built
+  int64_t weight_version = -1;
+  int64_t bias_version = -1;
+  at::Tensor weight;
+  at::Tensor bias;
+};
+
 struct ContextConvolution final {
   ideep::tensor::desc original_desc_;
   ideep::tensor weight_packed_;
@@ -27,6 +44,8 @@ struct ContextConvolution final {
   bool weight_is_channels_last_;
   ideep::convolution_forward_params conv_params_;
   ideep::convolution_forward::super conv_desc_;
+  std::shared_ptr<BlockWeightCache> block_weight_ =
+      std::make_shared<BlockWeightCache>();
 
   ContextConvolution() = delete;
 
@@ -4,14 +4,38 @@
 
 #include <ideep.hpp>
 
+#include <memory>
+
+#include "mkl.h"
+
 namespace torch_ipex {
 namespace cpu {
 namespace detail {
+
+// A MKL JIT sgemm kernel generated for a fixed M/N/K and beta, see
+// mkl_sgemm_jit_create. Copies share the jitter.
+struct MklSgemmJitKernel {
+  std::shared_ptr<void> jitter;
+  sgemm_jit_kernel_t kernel = nullptr;
+  int64_t M = 0;
+  int64_t N = 0;
+  int64_t K = 0;
+  float beta = 0.f;
+
+  bool defined() const {
+    return kernel != nullptr;
+  }
+};
+
 struct ContextLinearMKL final {
   std::vector<int64_t> sgemm_sizes_ = {0, 0, 0};
   at::Tensor at_weight_; // packed at weight
   at::Tensor ori_weight_; // non-packed at weight
   c10::optional<at::Tensor> at_bias_;
+  // JIT kernel for the packed batch size when it is small enough
+  MklSgemmJitKernel jit_kernel_;
+  // threads the sgemm is spread over, 0 for at::get_num_threads()
+  int64_t num_threads_ = 0;
 
   ContextLinearMKL() = delete;
 
@@ -3,8 +3,11 @@
 #include <ideep.hpp>
 #include <ideep/utils.hpp>
 #include "aten/Conv.h"
+#include "aten/InvertedResidual.h"
 #include "aten/ParamUtils.h"
 #include "aten/WeightPack.h"
+#include "PackedWeightSerialization.h"
+#include "PostOpChain.h"
 #include "aten/utils/utils.h"
 #include "ideep/IDeepConversions.h"
 
@@ -171,6 +174,42 @@ c10::intrusive_ptr<ConvolutionOpContext> createConvolutionPrePackOpContext(
       ideep::attr_t(torch_ipex::fpmath_mode));
 }
 
+c10::intrusive_ptr<ConvolutionOpContext> loadConvolutionPrePackOpContext(
+    SerializationTypeConvolutionPrePack&& state) {
+  auto& weight = std::get<0>(state);
+  if (!serialization::is_serialized_weight(weight)) {
+    return createConvolutionPrePackOpContext(
+        std::move(weight),
+        std::move(std::get<1>(state)),
+        std::move(std::get<2>(state)),
+        std::move(std::get<3>(state)),
+        std::move(std::get<4>(state)),
+        std::get<5>(state),
+        std::get<6>(state),
+        std::move(std::get<7>(state)));
+  }
+  RECORD_FUNCTION(
+      "ipex_prepack::loadConvolutionPrePackOpContext",
+      c10::ArrayRef<c10::IValue>({}));
+  auto packed = serialization::deserialize_weight(weight);
+  // The packed layout produced by another oneDNN version can not be
+  // interpreted by oneDNN, repack from the public weight in this case
+  auto public_weight = packed.same_library
+      ? serialization::empty_public_weight(packed)
+      : serialization::to_public(packed);
+  return IpexConvolutionOpContext::create_context(
+      std::move(public_weight),
+      std::move(std::get<1>(state)),
+      std::move(std::get<2>(state)),
+      std::move(std::get<3>(state)),
+      std::move(std::get<4>(state)),
+      std::get<5>(state),
+      std::get<6>(state),
+      std::move(std::get<7>(state)),
+      ideep::attr_t(torch_ipex::fpmath_mode),
+      packed.same_library ? &packed : nullptr);
+}
+
 at::Tensor convolution_run(
     const at::Tensor& input,
     const c10::intrusive_ptr<ConvolutionOpContext>& op_context) {
@@ -480,6 +519,204 @@ at::Tensor convolution_bottleneck_run(
   }
 }
 
+// Get the post ops fused in the attr of a convolution of an inverted residual
+// block, returns false if they are not supported by the fused block kernel.
+// The project conv of a block with residual has a single sum post op.
+static bool get_block_post_op(
+    const ideep::attr_t& attr,
+    bool with_sum,
+    BlockActivation& activation) {
+  auto post_ops = attr.get_post_ops();
+  activation = BlockActivation();
+  if (with_sum) {
+    return post_ops.len() == 1 &&
+        post_ops.kind(0) == dnnl::primitive::kind::sum;
+  }
+  if (post_ops.len() == 0) {
+    return true;
+  }
+  if (post_ops.len() > 1 ||
+      post_ops.kind(0) != dnnl::primitive::kind::eltwise) {
+    return false;
+  }
+  dnnl::algorithm alg;
+  post_ops.get_params_eltwise(0, alg, activation.alpha, activation.beta);
+  switch (alg) {
+    case dnnl::algorithm::eltwise_relu:
+      activation.kind = BlockEltwise::ReLU;
+      return true;
+    case dnnl::algorithm::eltwise_clip:
+    case dnnl::algorithm::eltwise_clip_v2:
+      activation.kind = BlockEltwise::Clip;
+      return true;
+    case dnnl::algorithm::eltwise_swish:
+      activation.kind = BlockEltwise::Swish;
+      return true;
+    case dnnl::algorithm::eltwise_hardswish:
+      activation.kind = BlockEltwise::HardSwish;
+      return true;
+    default:
+      return false;
+  }
+}
+
+static bool is_pointwise_conv(const ContextConvolution& context) {
+  auto dims = context.weight_packed_.get_dims();
+  auto is_one = [](int64_t v) { return v == 1; };
+  auto is_zero = [](int64_t v) { return v == 0; };
+  return dims.size() == 4 && dims[2] == 1 && dims[3] == 1 &&
+      context.groups_ == 1 &&
+      std::all_of(context.stride_.begin(), context.stride_.end(), is_one) &&
+      std::all_of(context.padding_.begin(), context.padding_.end(), is_zero);
+}
+
+// Inference tensors do not track their version, they are only updated by
+// load_from_ctx which invalidates the block weight cache itself.
+static int64_t tensor_version(const at::Tensor& t) {
+  return t.is_inference() ? 0 : static_cast<int64_t>(t._version());
+}
+
+// Weight of the convolution as fp32 [in_channels / groups, kh, kw, out_pad],
+// with out_pad the output channels rounded up to kBlockChannelAlign, and the
+// zero padded fp32 bias. They are returned by value since another thread may
+// rebuild the cache once the lock is released.
+static std::pair<at::Tensor, at::Tensor> get_block_weight(
+    ContextConvolution& context) {
+  auto& cache = *context.block_weight_;
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  const int64_t weight_version = tensor_version(context.at_weight_);
+  const int64_t bias_version = context.at_bias_.has_value()
+      ? tensor_version(context.at_bias_.value())
+      : 0;
+  if (cache.weight_version == weight_version &&
+      cache.bias_version == bias_version) {
+    return {cache.weight, cache.bias};
+  }
+  auto weight = unpack(context, context.at_weight_).to(at::kFloat);
+  auto out_channels = weight.size(0);
+  auto out_pad = (out_channels + kBlockChannelAlign - 1) / kBlockChannelAlign *
+      kBlockChannelAlign;
+  auto weight_t = weight.permute({1, 2, 3, 0});
+  cache.weight = at::zeros(
+      {weight_t.size(0), weight_t.size(1), weight_t.size(2), out_pad},
+      at::kFloat);
+  cache.weight.narrow(3, 0, out_channels).copy_(weight_t);
+  cache.bias = at::zeros({out_pad}, at::kFloat);
+  if (context.at_bias_.has_value()) {
+    cache.bias.narrow(0, 0, out_channels).copy_(context.at_bias_.value());
+  }
+  cache.weight_version = weight_version;
+  cache.bias_version = bias_version;
+  return {cache.weight, cache.bias};
+}
+
+// Check whether the block can run in the fused kernel and fill its params
+static bool get_inverted_residual_params(
+    const at::Tensor& input,
+    ContextConvolution& context1,
+    ContextConvolution& context2,
+    ContextConvolution& context3,
+    const c10::optional<at::Scalar>& alpha,
+    InvertedResidualParams& params) {
+  if (input.dim() != 4 ||
+      (input.scalar_type() != at::kFloat &&
+       input.scalar_type() != at::kBFloat16)) {
+    return false;
+  }
+  if (!is_pointwise_conv(context1) || !is_pointwise_conv(context3)) {
+    return false;
+  }
+  auto dims1 = context1.weight_packed_.get_dims();
+  auto dims2 = context2.weight_packed_.get_dims();
+  auto dims3 = context3.weight_packed_.get_dims();
+  const int64_t hidden = dims1[0];
+  if (input.size(1) != dims1[1] || dims2.size() != 4 || dims2[0] != hidden ||
+      dims2[1] != 1 || context2.groups_ != hidden || dims3[1] != hidden ||
+      context2.stride_.size() != 2 || context2.padding_.size() != 2) {
+    return false;
+  }
+  if (!get_block_post_op(
+          context1.conv_params_.op_attr, false, params.expand_act) ||
+      !get_block_post_op(context2.conv_params_.op_attr, false, params.dw_act) ||
+      !get_block_post_op(
+          context3.conv_params_.op_attr,
+          alpha.has_value(),
+          params.project_act)) {
+    return false;
+  }
+
+  params.hidden_channels = hidden;
+  params.out_channels = dims3[0];
+  for (const auto i : c10::irange(2)) {
+    params.dw_stride[i] = context2.stride_[i];
+    params.dw_padding[i] = context2.padding_[i];
+    params.dw_dilation[i] = context2.dilation_[i];
+  }
+  params.residual = alpha.has_value();
+  if (params.residual) {
+    params.residual_alpha = alpha.value().to<float>();
+    auto out_h = (input.size(2) + 2 * params.dw_padding[0] -
+                  params.dw_dilation[0] * (dims2[2] - 1) - 1) /
+            params.dw_stride[0] +
+        1;
+    auto out_w = (input.size(3) + 2 * params.dw_padding[1] -
+                  params.dw_dilation[1] * (dims2[3] - 1) - 1) /
+            params.dw_stride[1] +
+        1;
+    if (params.out_channels != input.size(1) || out_h != input.size(2) ||
+        out_w != input.size(3)) {
+      return false;
+    }
+  }
+
+  auto weight1 = get_block_weight(context1);
+  auto weight2 = get_block_weight(context2);
+  auto weight3 = get_block_weight(context3);
+  params.expand_weight = weight1.first.view({dims1[1], -1});
+  params.expand_bias = weight1.second;
+  params.dw_weight = weight2.first.select(0, 0);
+  params.dw_bias = weight2.second;
+  params.project_weight = weight3.first.view({hidden, -1});
+  params.project_bias = weight3.second;
+  return true;
+}
+
+at::Tensor convolution_inverted_residual_run(
+    const at::Tensor& input,
+    const c10::intrusive_ptr<ConvolutionOpContext>& op_context1,
+    const c10::intrusive_ptr<ConvolutionOpContext>& op_context2,
+    const c10::intrusive_ptr<ConvolutionOpContext>& op_context3,
+    const c10::optional<at::Scalar>& alpha) {
+  RECORD_FUNCTION(
+      "ipex_prepack::convolution_inverted_residual_run",
+      c10::ArrayRef<c10::IValue>({}));
+
+  auto& context1 = op_context1->get_context();
+  auto& context2 = op_context2->get_context();
+  auto& context3 = op_context3->get_context();
+
+  // The expanded activation only lives in per thread tiles of the fused
+  // kernel, otherwise run the three convolutions one by one.
+  InvertedResidualParams params;
+  if (get_inverted_residual_params(
+          input, context1, context2, context3, alpha, params)) {
+    return inverted_residual(
+        input.contiguous(at::MemoryFormat::ChannelsLast), params);
+  }
+  auto output1 = run(context1, input, context1.conv_params_.op_attr);
+  auto output2 = run(context2, output1, context2.conv_params_.op_attr);
+  if (!alpha.has_value()) {
+    return run(context3, output2, context3.conv_params_.op_attr);
+  }
+  auto accumu = input.clone(input.suggest_memory_format());
+  return run(
+      context3,
+      output2,
+      accumu,
+      ideep::attr_t::fuse_sum(alpha.value().to<float>())
+          .set_fpmath_mode(torch_ipex::fpmath_mode));
+}
+
 ContextConvolution create(
     const at::Tensor& weight,
     const c10::optional<at::Tensor>& bias,
@@ -489,7 +726,8 @@ ContextConvolution create(
     const int64_t groups,
     const bool weight_is_channels_last,
     const std::vector<int64_t>& input_size_,
-    const ideep::attr_t& attr) {
+    const ideep::attr_t& attr,
+    const serialization::PackedWeight* prepacked) {
   auto input_size = input_size_.empty()
       ? gen_dummy_input_size_for(weight.sizes(), groups)
       : input_size_;
@@ -592,20 +830,33 @@ ContextConvolution create(
   ideep::data_type dtype = w.get_data_type();
   auto expected_desc =
       ideep::tensor::desc(conv_params.pd.weights_desc(), groups);
-  auto at_weight = empty_aten_tensor_from_desc(expected_desc, weight.options());
+  at::Tensor at_weight;
   ideep::tensor packed_weight;
-  if (ideep::data_type::f32 == dtype) {
-    packed_weight.init(expected_desc, at_weight.template data_ptr<float>());
-  } else if (ideep::data_type::bf16 == dtype) {
-    packed_weight.init(
-        expected_desc, at_weight.template data_ptr<c10::BFloat16>());
+  if (prepacked != nullptr && prepacked->host_compatible &&
+      prepacked->packed_desc == expected_desc) {
+    // The serialized weight is already in the expected layout, use it in place
+    at_weight = prepacked->packed;
+    packed_weight.init(expected_desc, at_weight.data_ptr());
   } else {
-    TORCH_CHECK(
-        ideep::data_type::f16 == dtype,
-        "Only support bfloat16, float16 and float for weight prepack of convolution");
-    packed_weight.init(expected_desc, at_weight.template data_ptr<c10::Half>());
+    at_weight = empty_aten_tensor_from_desc(expected_desc, weight.options());
+    if (ideep::data_type::f32 == dtype) {
+      packed_weight.init(expected_desc, at_weight.template data_ptr<float>());
+    } else if (ideep::data_type::bf16 == dtype) {
+      packed_weight.init(
+          expected_desc, at_weight.template data_ptr<c10::BFloat16>());
+    } else {
+      TORCH_CHECK(
+          ideep::data_type::f16 == dtype,
+          "Only support bfloat16, float16 and float for weight prepack of convolution");
+      packed_weight.init(
+          expected_desc, at_weight.template data_ptr<c10::Half>());
+    }
+    if (prepacked != nullptr) {
+      packed_weight.feed_from(serialization::packed_itensor(*prepacked));
+    } else {
+      packed_weight.feed_from(w);
+    }
   }
-  packed_weight.feed_from(w);
 
   return ContextConvolution{
       std::move(ori_desc),
@@ -622,6 +873,35 @@ ContextConvolution create(
       ideep::convolution_forward::super(conv_params.pd)};
 }
 
+at::Tensor convolution_post_ops_run(
+    const at::Tensor& input,
+    c10::ArrayRef<int64_t> post_op_kinds,
+    c10::ArrayRef<double> post_op_params,
+    const c10::intrusive_ptr<ConvolutionOpContext>& op_context) {
+  RECORD_FUNCTION(
+      "ipex_prepack::convolution_post_ops_run",
+      c10::ArrayRef<c10::IValue>({}));
+  return run_post_op_chain(
+      op_context->get_context(),
+      input,
+      at::Tensor(),
+      post_op_kinds,
+      post_op_params);
+}
+
+at::Tensor convolution_sum_post_ops_run(
+    const at::Tensor& input,
+    const at::Tensor& accumu,
+    c10::ArrayRef<int64_t> post_op_kinds,
+    c10::ArrayRef<double> post_op_params,
+    const c10::intrusive_ptr<ConvolutionOpContext>& op_context) {
+  RECORD_FUNCTION(
+      "ipex_prepack::convolution_sum_post_ops_run",
+      c10::ArrayRef<c10::IValue>({}));
+  return run_post_op_chain(
+      op_context->get_context(), input, accumu, post_op_kinds, post_op_params);
+}
+
 at::Tensor run(
     const ContextConvolution& context,
     const at::Tensor& input,
@@ -884,6 +1164,43 @@ std::tuple<at::Tensor, at::Tensor, at::Tensor> run_backward(
       output_mask);
 }
 
+at::Tensor run_post_op_chain(
+    const ContextConvolution& context,
+    const at::Tensor& input,
+    const at::Tensor& accumu,
+    c10::ArrayRef<int64_t> post_op_kinds,
+    c10::ArrayRef<double> post_op_params) {
+  auto num_srcs = check_post_op_chain(post_op_kinds, post_op_params);
+  for (auto kind : post_op_kinds) {
+    TORCH_CHECK(
+        !is_binary_post_op(kind),
+        "convolution post-op chain: binary post-ops are not supported");
+  }
+  TORCH_CHECK(
+      accumu.defined() == (num_srcs == 1),
+      "convolution post-op chain: accumu should be given with the sum "
+      "post-op");
+  auto attr = make_post_op_chain_attr(post_op_kinds, post_op_params);
+  if (!accumu.defined()) {
+    return run(context, input, attr);
+  }
+  auto output_size = calc_conv_output_size(
+      input.sizes(),
+      context.weight_packed_.get_dims(),
+      context.padding_,
+      context.stride_,
+      context.dilation_);
+  if (accumu.sizes() == output_size &&
+      accumu.scalar_type() == input.scalar_type()) {
+    auto output = accumu.clone();
+    return run(context, input, output, attr);
+  }
+  // accumu has to be broadcast, add it and apply the chain after the conv
+  auto output = run(
+      context, input, ideep::attr_t().set_fpmath_mode(torch_ipex::fpmath_mode));
+  return apply_post_op_chain(output, {accumu}, post_op_kinds, post_op_params);
+}
+
 at::Tensor get_at_packed_weight(ContextConvolution& context) {
   return context.at_weight_;
 }
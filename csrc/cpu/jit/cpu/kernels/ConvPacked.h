@@ -35,6 +35,11 @@ c10::intrusive_ptr<ConvolutionOpContext> createConvolutionPrePackOpContext(
     bool weight_is_channels_last,
     std::vector<int64_t>&& input_size);
 
+// Restore the op context from its pickled state, which holds either the public
+// weight (legacy format) or a serialized packed weight blob
+c10::intrusive_ptr<ConvolutionOpContext> loadConvolutionPrePackOpContext(
+    SerializationTypeConvolutionPrePack&& state);
+
 at::Tensor convolution_run(
     const at::Tensor& input,
     const c10::intrusive_ptr<ConvolutionOpContext>& op_context);
@@ -112,6 +117,36 @@ at::Tensor convolution_bottleneck_run(
     const c10::intrusive_ptr<ConvolutionOpContext>& op_context3,
     const c10::intrusive_ptr<ConvolutionOpContext>& op_context4);
 
+// MobileNet/EfficientNet inverted residual block: expand 1x1 conv (op_context1)
+// -> depthwise conv (op_context2) -> project 1x1 conv (op_context3), each with
+// the post op fused in its context. If alpha is given, alpha * input is added
+// to the output of the block.
+at::Tensor convolution_inverted_residual_run(
+    const at::Tensor& input,
+    const c10::intrusive_ptr<ConvolutionOpContext>& op_context1,
+    const c10::intrusive_ptr<ConvolutionOpContext>& op_context2,
+    const c10::intrusive_ptr<ConvolutionOpContext>& op_context3,
+    const c10::optional<at::Scalar>& alpha);
+
+// Convolution with a chain of eltwise post-ops fused into its epilogue, see
+// PostOpChain.h. For the sum variant the chain starts with a sum post-op of
+// accumu, which is not modified.
+at::Tensor convolution_post_ops_run(
+    const at::Tensor& input,
+    c10::ArrayRef<int64_t> post_op_kinds,
+    c10::ArrayRef<double> post_op_params,
+    const c10::intrusive_ptr<ConvolutionOpContext>& op_context);
+
+at::Tensor convolution_sum_post_ops_run(
+    const at::Tensor& input,
+    const at::Tensor& accumu,
+    c10::ArrayRef<int64_t> post_op_kinds,
+    c10::ArrayRef<double> post_op_params,
+    const c10::intrusive_ptr<ConvolutionOpContext>& op_context);
+
+// If prepacked is given, weight only provides the public sizes/strides and
+// dtype, and the packed data is taken from prepacked: it is adopted without copy
+// when its layout is the expected one, otherwise it is reordered.
 ContextConvolution create(
     const at::Tensor& weight,
     const c10::optional<at::Tensor>& bias,
@@ -121,7 +156,8 @@ ContextConvolution create(
     const int64_t groups,
     const bool weight_is_channels_last,
     const std::vector<int64_t>& input_size,
-    const ideep::attr_t& attr);
+    const ideep::attr_t& attr,
+    const serialization::PackedWeight* prepacked = nullptr);
 
 at::Tensor run(
     const ContextConvolution& context,
@@ -150,6 +186,15 @@ void run_core_fallback(
     at::Tensor& accumu,
     const ideep::attr_t& attr);
 
+// Runs the convolution with the post-op chain, accumu is the source of its
+// leading sum post-op if it is defined. Binary post-ops are not supported.
+at::Tensor run_post_op_chain(
+    const ContextConvolution& context,
+    const at::Tensor& input,
+    const at::Tensor& accumu,
+    c10::ArrayRef<int64_t> post_op_kinds,
+    c10::ArrayRef<double> post_op_params);
+
 // Runing backward for conv by given grad_output, input and grad_masks.
 // Will using the mkldnn_weight/bias stored in the context
 std::tuple<at::Tensor, at::Tensor, at::Tensor> run_backward(
@@ -1,4 +1,4 @@
-#include "Matmul.h"
+#include "Einsum.h"
 
 #include <ATen/Context.h>
 #include <ATen/InferSize.h>
@@ -8,10 +8,15 @@
 #include <torch/csrc/autograd/function.h>
 
 #include <limits>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
 
 #include <ideep.hpp>
 #include "Matmul.h"
 #include "ideep/IDeepConversions.h"
+#include "mkl.h"
 
 namespace torch_ipex {
 namespace cpu {
@@ -727,6 +732,779 @@ einsum_prepare(
       unsqueezed_dim_info);
 }
 
+namespace {
+
+// Label ids of the plan: [0, 52) are the letters of the equation as given by
+// einsum_label_to_index, the dims covered by the ellipsis follow from 52 on,
+// aligned to the right.
+constexpr int kEllipsisLabel = 52;
+
+// Plans are built per equation and operand sizes/strides, the cache is simply
+// dropped when it is full as models only use a handful of them.
+constexpr size_t kMaxCachedEinsumPlans = 1024;
+
+// Dims of M, N or K that cannot be merged with the inner ones are looped over
+// around the GEMM. That is only done if the merged dim is at least this large,
+// for smaller GEMMs it is cheaper to pack the operands.
+constexpr int64_t kMinSplitGemmDim = 32;
+
+// A dim of an operand of the plan, repeated labels of an operand are merged
+// into one dim with the sum of their strides, i.e. a diagonal view.
+struct EinsumDim {
+  int label;
+  int64_t size;
+  int64_t stride;
+};
+using EinsumDims = std::vector<EinsumDim>;
+
+// Sum out the labels of an input operand that no other operand nor the output
+// has, before any contraction.
+struct EinsumReduce {
+  int64_t operand;
+  std::vector<int64_t> sizes;
+  std::vector<int64_t> strides;
+  std::vector<int64_t> dims;
+  std::vector<int64_t> out_sizes;
+};
+
+// A strided batch-reduce GEMM, for each batch index b
+//   C[b] = beta * C[b] + sum_r A[b, r] x B[b, r]
+// A[b, r] is at a_offsets[b] + a_reduce_offsets[r] of the A operand, and so
+// on, with the layout of each matrix given as for cblas (row major). The r
+// loop covers the contracted dims that cannot be merged into k because of
+// their strides, so that no operand has to be transposed in memory for them.
+// MKL has no batch-reduce GEMM, so run_einsum_gemm issues one
+// cblas_sgemm_batch per r that accumulates into C with beta = 1, i.e. C is
+// re-read and re-written once per reduce step.
+struct EinsumGemm {
+  bool swap_operands = false;
+  MKL_INT m = 1;
+  MKL_INT n = 1;
+  MKL_INT k = 1;
+  CBLAS_TRANSPOSE trans_a = CblasNoTrans;
+  CBLAS_TRANSPOSE trans_b = CblasNoTrans;
+  MKL_INT lda = 1;
+  MKL_INT ldb = 1;
+  MKL_INT ldc = 1;
+  std::vector<int64_t> a_offsets;
+  std::vector<int64_t> b_offsets;
+  std::vector<int64_t> c_offsets;
+  std::vector<int64_t> a_reduce_offsets;
+  std::vector<int64_t> b_reduce_offsets;
+};
+
+// Contraction of two operands of the plan, the inputs come first in the
+// operand list of the plan and the result of each step is appended to it. An
+// operand is packed, i.e. copied to a contiguous tensor, only if its strides
+// cannot be expressed by the GEMM.
+struct EinsumStep {
+  int64_t lhs;
+  int64_t rhs;
+  bool pack_lhs = false;
+  bool pack_rhs = false;
+  // the strided view of the operand in the order of the packed tensor
+  std::vector<int64_t> lhs_pack_sizes, lhs_pack_strides;
+  std::vector<int64_t> rhs_pack_sizes, rhs_pack_strides;
+  // the result is contiguous with these sizes
+  std::vector<int64_t> out_sizes;
+  EinsumGemm gemm;
+};
+
+struct EinsumPlan {
+  std::vector<EinsumReduce> reduces;
+  std::vector<EinsumStep> steps;
+  // the einsum output as a view of the result of the last step
+  std::vector<int64_t> out_sizes;
+  std::vector<int64_t> out_strides;
+};
+
+const EinsumDim* find_dim(const EinsumDims& dims, int label) {
+  for (const auto& dim : dims) {
+    if (dim.label == label) {
+      return &dim;
+    }
+  }
+  return nullptr;
+}
+
+bool has_label(const EinsumDims& dims, int label) {
+  return find_dim(dims, label) != nullptr;
+}
+
+// dims of the given labels of a contiguous tensor in this order
+EinsumDims contiguous_dims(
+    const std::vector<int>& labels,
+    const std::unordered_map<int, int64_t>& label_size) {
+  EinsumDims dims(labels.size());
+  int64_t stride = 1;
+  for (int64_t i = labels.size() - 1; i >= 0; i--) {
+    dims[i] = {labels[i], label_size.at(labels[i]), stride};
+    stride *= dims[i].size;
+  }
+  return dims;
+}
+
+// labels sorted from the outermost to the innermost dim of the operand
+std::vector<int> sort_by_stride(
+    std::vector<int> labels,
+    const EinsumDims& dims) {
+  std::stable_sort(labels.begin(), labels.end(), [&](int a, int b) {
+    return find_dim(dims, a)->stride > find_dim(dims, b)->stride;
+  });
+  return labels;
+}
+
+// Merge the dims of the labels (outermost first) into a single dim. Size 1
+// dims are skipped since their stride is never used.
+bool collapse_dims(
+    const std::vector<int>& labels,
+    const EinsumDims& dims,
+    int64_t& size,
+    int64_t& stride) {
+  size = 1;
+  stride = 1;
+  for (auto it = labels.rbegin(); it != labels.rend(); ++it) {
+    const auto* dim = find_dim(dims, *it);
+    if (dim->size == 1) {
+      continue;
+    }
+    if (size == 1) {
+      stride = dim->stride;
+    } else if (dim->stride != stride * size) {
+      return false;
+    }
+    size *= dim->size;
+  }
+  return true;
+}
+
+// offsets of all the indices of the labels (row major) in each operand, an
+// operand without the label is broadcast along it
+std::vector<std::vector<int64_t>> label_offsets(
+    const std::vector<int>& labels,
+    const std::vector<const EinsumDims*>& operands) {
+  std::vector<std::vector<int64_t>> offsets(
+      operands.size(), std::vector<int64_t>(1, 0));
+  for (const auto label : labels) {
+    int64_t size = 1;
+    for (const auto* operand : operands) {
+      if (const auto* dim = find_dim(*operand, label)) {
+        size = dim->size;
+      }
+    }
+    if (size == 1) {
+      continue;
+    }
+    for (const auto i : c10::irange(operands.size())) {
+      const auto* dim = find_dim(*operands[i], label);
+      const int64_t stride = dim ? dim->stride : 0;
+      std::vector<int64_t> expanded;
+      expanded.reserve(offsets[i].size() * size);
+      for (const auto offset : offsets[i]) {
+        for (const auto j : c10::irange(size)) {
+          expanded.push_back(offset + j * stride);
+        }
+      }
+      offsets[i] = std::move(expanded);
+    }
+  }
+  return offsets;
+}
+
+bool fits_mkl_int(int64_t value) {
+  return value <= std::numeric_limits<MKL_INT>::max();
+}
+
+// Layout of a rows x cols operand of cblas (row major) with the given strides
+bool gemm_operand_layout(
+    int64_t rows,
+    int64_t cols,
+    int64_t row_stride,
+    int64_t col_stride,
+    CBLAS_TRANSPOSE& trans,
+    MKL_INT& ld) {
+  if ((cols == 1 || col_stride == 1) && (rows == 1 || row_stride >= cols)) {
+    trans = CblasNoTrans;
+    ld = rows == 1 ? std::max<int64_t>(cols, 1) : row_stride;
+    return fits_mkl_int(ld);
+  }
+  if ((rows == 1 || row_stride == 1) && (cols == 1 || col_stride >= rows)) {
+    trans = CblasTrans;
+    ld = cols == 1 ? std::max<int64_t>(rows, 1) : col_stride;
+    return fits_mkl_int(ld);
+  }
+  return false;
+}
+
+// Merge the innermost labels into a single dim of both x and y as long as the
+// strides allow, returns the number of outer labels that are left.
+size_t split_dims(
+    const std::vector<int>& labels,
+    const EinsumDims& x,
+    const EinsumDims& y,
+    int64_t& size,
+    int64_t& x_stride,
+    int64_t& y_stride) {
+  size_t begin = 0;
+  for (; begin < labels.size(); begin++) {
+    std::vector<int> inner(labels.begin() + begin, labels.end());
+    if (collapse_dims(inner, x, size, x_stride) &&
+        collapse_dims(inner, y, size, y_stride)) {
+      return begin;
+    }
+  }
+  size = x_stride = y_stride = 1;
+  return begin;
+}
+
+// Map C[batch, M, N] = sum_K A[batch, M, K] x B[batch, K, N] with the given
+// dims of the operands to a strided batch-reduce GEMM. The outer dims of M
+// and N that cannot be merged are looped over as batch dims and those of K by
+// the batch-reduce.
+bool make_einsum_gemm(
+    const std::vector<int>& batch,
+    const std::vector<int>& m_labels,
+    const std::vector<int>& n_labels,
+    const std::vector<int>& k_labels,
+    const EinsumDims& a,
+    const EinsumDims& b,
+    const EinsumDims& c,
+    EinsumGemm& result) {
+  EinsumGemm gemm;
+  int64_t m, a_m_stride, c_m_stride;
+  int64_t n, b_n_stride, c_n_stride;
+  int64_t k, a_k_stride, b_k_stride;
+  const size_t m_begin = split_dims(m_labels, a, c, m, a_m_stride, c_m_stride);
+  const size_t n_begin = split_dims(n_labels, b, c, n, b_n_stride, c_n_stride);
+  const size_t k_begin = split_dims(k_labels, a, b, k, a_k_stride, b_k_stride);
+  if ((m_begin > 0 && m < kMinSplitGemmDim) ||
+      (n_begin > 0 && n < kMinSplitGemmDim) ||
+      (k_begin > 0 && k < kMinSplitGemmDim)) {
+    return false;
+  }
+  if (!fits_mkl_int(m) || !fits_mkl_int(n) || !fits_mkl_int(k)) {
+    return false;
+  }
+
+  // C has to be row major, otherwise compute C^T = B^T x A^T
+  MKL_INT ldc;
+  CBLAS_TRANSPOSE trans_c;
+  bool swap = false;
+  if (!gemm_operand_layout(m, n, c_m_stride, c_n_stride, trans_c, ldc) ||
+      trans_c != CblasNoTrans) {
+    if (!gemm_operand_layout(n, m, c_n_stride, c_m_stride, trans_c, ldc) ||
+        trans_c != CblasNoTrans) {
+      return false;
+    }
+    swap = true;
+  }
+  if (!swap) {
+    if (!gemm_operand_layout(
+            m, k, a_m_stride, a_k_stride, gemm.trans_a, gemm.lda) ||
+        !gemm_operand_layout(
+            k, n, b_k_stride, b_n_stride, gemm.trans_b, gemm.ldb)) {
+      return false;
+    }
+    gemm.m = m;
+    gemm.n = n;
+  } else {
+    if (!gemm_operand_layout(
+            n, k, b_n_stride, b_k_stride, gemm.trans_a, gemm.lda) ||
+        !gemm_operand_layout(
+            k, m, a_k_stride, a_m_stride, gemm.trans_b, gemm.ldb)) {
+      return false;
+    }
+    gemm.m = n;
+    gemm.n = m;
+  }
+  gemm.swap_operands = swap;
+  gemm.k = k;
+  gemm.ldc = ldc;
+
+  std::vector<int> batch_labels(batch);
+  batch_labels.insert(
+      batch_labels.end(), m_labels.begin(), m_labels.begin() + m_begin);
+  batch_labels.insert(
+      batch_labels.end(), n_labels.begin(), n_labels.begin() + n_begin);
+  auto batch_offsets = label_offsets(batch_labels, {&a, &b, &c});
+  const std::vector<int> outer_k(k_labels.begin(), k_labels.begin() + k_begin);
+  auto reduce_offsets = label_offsets(outer_k, {&a, &b});
+  const int swap_idx = swap ? 1 : 0;
+  gemm.a_offsets = std::move(batch_offsets[swap_idx]);
+  gemm.b_offsets = std::move(batch_offsets[1 - swap_idx]);
+  gemm.c_offsets = std::move(batch_offsets[2]);
+  gemm.a_reduce_offsets = std::move(reduce_offsets[swap_idx]);
+  gemm.b_reduce_offsets = std::move(reduce_offsets[1 - swap_idx]);
+  if (!fits_mkl_int(gemm.c_offsets.size())) {
+    return false;
+  }
+  result = std::move(gemm);
+  return true;
+}
+
+// Plan the contraction of lhs and rhs into out, the labels kept in the
+// result are the ones in `needed`. The result of the last step is laid out as
+// the einsum output if the GEMM can write it so.
+bool plan_einsum_step(
+    EinsumStep& step,
+    const EinsumDims& lhs,
+    const EinsumDims& rhs,
+    const std::unordered_set<int>& needed,
+    const std::vector<int>* out_labels,
+    const std::unordered_map<int, int64_t>& label_size,
+    EinsumDims& out) {
+  std::vector<int> batch, m_labels, n_labels, k_labels;
+  for (const auto& dim : lhs) {
+    if (!has_label(rhs, dim.label)) {
+      m_labels.push_back(dim.label);
+    } else if (needed.count(dim.label)) {
+      batch.push_back(dim.label);
+    } else {
+      k_labels.push_back(dim.label);
+    }
+  }
+  for (const auto& dim : rhs) {
+    if (!has_label(lhs, dim.label)) {
+      n_labels.push_back(dim.label);
+    }
+  }
+  batch = sort_by_stride(batch, lhs);
+  m_labels = sort_by_stride(m_labels, lhs);
+  k_labels = sort_by_stride(k_labels, lhs);
+  n_labels = sort_by_stride(n_labels, rhs);
+
+  auto concat = [](std::initializer_list<const std::vector<int>*> parts) {
+    std::vector<int> labels;
+    for (const auto* part : parts) {
+      labels.insert(labels.end(), part->begin(), part->end());
+    }
+    return labels;
+  };
+  const auto planned_labels = concat({&batch, &m_labels, &n_labels});
+  const auto lhs_pack_labels = concat({&batch, &m_labels, &k_labels});
+  const auto rhs_pack_labels = concat({&batch, &k_labels, &n_labels});
+
+  std::vector<const std::vector<int>*> out_layouts;
+  if (out_labels != nullptr) {
+    out_layouts.push_back(out_labels);
+  }
+  out_layouts.push_back(&planned_labels);
+  for (const auto* out_layout : out_layouts) {
+    out = contiguous_dims(*out_layout, label_size);
+    for (int pack = 0; pack < 4; pack++) {
+      const bool pack_lhs = pack & 1;
+      const bool pack_rhs = pack & 2;
+      const auto a =
+          pack_lhs ? contiguous_dims(lhs_pack_labels, label_size) : lhs;
+      const auto b =
+          pack_rhs ? contiguous_dims(rhs_pack_labels, label_size) : rhs;
+      if (!make_einsum_gemm(
+              batch, m_labels, n_labels, k_labels, a, b, out, step.gemm)) {
+        continue;
+      }
+      step.pack_lhs = pack_lhs;
+      step.pack_rhs = pack_rhs;
+      if (pack_lhs) {
+        for (const auto label : lhs_pack_labels) {
+          step.lhs_pack_sizes.push_back(find_dim(lhs, label)->size);
+          step.lhs_pack_strides.push_back(find_dim(lhs, label)->stride);
+        }
+      }
+      if (pack_rhs) {
+        for (const auto label : rhs_pack_labels) {
+          step.rhs_pack_sizes.push_back(find_dim(rhs, label)->size);
+          step.rhs_pack_strides.push_back(find_dim(rhs, label)->stride);
+        }
+      }
+      for (const auto& dim : out) {
+        step.out_sizes.push_back(dim.size);
+      }
+      return true;
+    }
+  }
+  // packing both operands with the planned layout of the result always works
+  // unless the sizes overflow the GEMM
+  return false;
+}
+
+// Parse the equation into the dims of each operand and the output labels,
+// returns false for what the plan does not handle (broadcasting of size 1
+// dims, zero sized dims or an invalid equation), these go to the reference
+// implementation which also reports the errors.
+bool parse_einsum(
+    c10::string_view equation,
+    const c10::List<at::Tensor>& operands,
+    std::vector<EinsumDims>& op_dims,
+    std::vector<int>& out_labels,
+    std::unordered_map<int, int64_t>& label_size) {
+  constexpr int ELLIPSIS = -1;
+  const auto arrow_pos = equation.find("->");
+  const auto lhs = equation.substr(0, arrow_pos);
+  const auto num_ops = operands.size();
+
+  std::vector<std::vector<int>> op_labels(1);
+  for (size_t i = 0; i < lhs.length(); i++) {
+    const unsigned char label = lhs[i];
+    if (label == ' ') {
+      continue;
+    } else if (label == ',') {
+      op_labels.emplace_back();
+    } else if (label == '.') {
+      if (lhs.substr(i, 3) != "...") {
+        return false;
+      }
+      op_labels.back().push_back(ELLIPSIS);
+      i += 2;
+    } else if (einsum_check_label(label)) {
+      op_labels.back().push_back(einsum_label_to_index(label));
+    } else {
+      return false;
+    }
+  }
+  if (op_labels.size() != num_ops) {
+    return false;
+  }
+
+  int64_t ell_num_dim = 0;
+  for (const auto i : c10::irange(num_ops)) {
+    const auto& labels = op_labels[i];
+    const int64_t num_ell = std::count(labels.begin(), labels.end(), ELLIPSIS);
+    const int64_t num_dim = operands.get(i).dim();
+    const int64_t num_letters = labels.size() - num_ell;
+    if (num_ell > 1 || (num_ell == 0 && num_letters != num_dim) ||
+        num_letters > num_dim) {
+      return false;
+    }
+    if (num_ell) {
+      ell_num_dim = std::max(ell_num_dim, num_dim - num_letters);
+    }
+  }
+
+  std::vector<int64_t> label_count(kEllipsisLabel, 0);
+  op_dims.assign(num_ops, {});
+  for (const auto i : c10::irange(num_ops)) {
+    const at::Tensor operand = operands.get(i);
+    int64_t d = 0;
+    for (const auto label : op_labels[i]) {
+      std::vector<int> dim_labels;
+      if (label == ELLIPSIS) {
+        const int64_t num_dim = operand.dim() - (op_labels[i].size() - 1);
+        for (const auto e : c10::irange(num_dim)) {
+          dim_labels.push_back(kEllipsisLabel + ell_num_dim - num_dim + e);
+        }
+      } else {
+        label_count[label]++;
+        dim_labels.push_back(label);
+      }
+      for (const auto dim_label : dim_labels) {
+        const int64_t size = operand.size(d);
+        const int64_t stride = operand.stride(d++);
+        auto it = label_size.find(dim_label);
+        if (size == 0 || (it != label_size.end() && it->second != size)) {
+          return false;
+        }
+        label_size[dim_label] = size;
+        auto& dims = op_dims[i];
+        auto dim = std::find_if(dims.begin(), dims.end(), [&](const auto& x) {
+          return x.label == dim_label;
+        });
+        if (dim != dims.end()) {
+          dim->stride += stride;
+        } else {
+          dims.push_back({dim_label, size, stride});
+        }
+      }
+    }
+  }
+
+  out_labels.clear();
+  if (arrow_pos == c10::string_view::npos) {
+    for (const auto e : c10::irange(ell_num_dim)) {
+      out_labels.push_back(kEllipsisLabel + e);
+    }
+    for (const auto label : c10::irange(kEllipsisLabel)) {
+      if (label_count[label] == 1) {
+        out_labels.push_back(label);
+      }
+    }
+  } else {
+    const auto rhs = equation.substr(arrow_pos + 2);
+    bool found_ell = false;
+    for (size_t i = 0; i < rhs.length(); i++) {
+      const unsigned char label = rhs[i];
+      if (label == ' ') {
+        continue;
+      } else if (label == '.') {
+        if (found_ell || rhs.substr(i, 3) != "...") {
+          return false;
+        }
+        for (const auto e : c10::irange(ell_num_dim)) {
+          out_labels.push_back(kEllipsisLabel + e);
+        }
+        found_ell = true;
+        i += 2;
+      } else if (einsum_check_label(label)) {
+        const int index = einsum_label_to_index(label);
+        if (label_count[index] == 0 ||
+            std::count(out_labels.begin(), out_labels.end(), index)) {
+          return false;
+        }
+        out_labels.push_back(index);
+      } else {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+std::shared_ptr<const EinsumPlan> build_einsum_plan(
+    c10::string_view equation,
+    const c10::List<at::Tensor>& operands) {
+  std::vector<EinsumDims> op_dims;
+  std::vector<int> out_labels;
+  std::unordered_map<int, int64_t> label_size;
+  if (operands.size() < 2 ||
+      !parse_einsum(equation, operands, op_dims, out_labels, label_size)) {
+    return nullptr;
+  }
+  const std::unordered_set<int> out_set(out_labels.begin(), out_labels.end());
+  auto plan = std::make_shared<EinsumPlan>();
+
+  struct Node {
+    int64_t operand;
+    EinsumDims dims;
+  };
+  std::vector<Node> nodes;
+  for (const auto i : c10::irange(operands.size())) {
+    nodes.push_back({static_cast<int64_t>(i), op_dims[i]});
+  }
+  auto needed_labels = [&](size_t skip0, size_t skip1) {
+    std::unordered_set<int> needed(out_set);
+    for (const auto i : c10::irange(nodes.size())) {
+      if (i != skip0 && i != skip1) {
+        for (const auto& dim : nodes[i].dims) {
+          needed.insert(dim.label);
+        }
+      }
+    }
+    return needed;
+  };
+
+  // sum out the labels that only appear in one operand
+  for (const auto i : c10::irange(nodes.size())) {
+    const auto needed = needed_labels(i, i);
+    EinsumReduce reduce;
+    reduce.operand = nodes[i].operand;
+    std::vector<int> kept;
+    for (const auto d : c10::irange(nodes[i].dims.size())) {
+      const auto& dim = nodes[i].dims[d];
+      reduce.sizes.push_back(dim.size);
+      reduce.strides.push_back(dim.stride);
+      if (needed.count(dim.label)) {
+        kept.push_back(dim.label);
+        reduce.out_sizes.push_back(dim.size);
+      } else {
+        reduce.dims.push_back(d);
+      }
+    }
+    if (!reduce.dims.empty()) {
+      nodes[i].dims = contiguous_dims(kept, label_size);
+      plan->reduces.push_back(std::move(reduce));
+    }
+  }
+
+  // greedily contract the pair with the smallest result, then the smallest
+  // number of multiply-adds
+  int64_t num_operands = operands.size();
+  while (nodes.size() > 1) {
+    size_t best_i = 0, best_j = 1;
+    std::pair<int64_t, int64_t> best_cost(-1, -1);
+    for (const auto i : c10::irange(nodes.size())) {
+      for (const auto j : c10::irange(i + 1, nodes.size())) {
+        const auto needed = needed_labels(i, j);
+        int64_t out_numel = 1, macs = 1;
+        std::unordered_set<int> labels;
+        for (const auto* dims : {&nodes[i].dims, &nodes[j].dims}) {
+          for (const auto& dim : *dims) {
+            if (labels.insert(dim.label).second) {
+              macs *= dim.size;
+              out_numel *= needed.count(dim.label) ? dim.size : 1;
+            }
+          }
+        }
+        const auto cost = std::make_pair(out_numel, macs);
+        if (best_cost.first < 0 || cost < best_cost) {
+          best_cost = cost;
+          best_i = i;
+          best_j = j;
+        }
+      }
+    }
+    const auto needed = needed_labels(best_i, best_j);
+    const bool last = nodes.size() == 2;
+    EinsumStep step;
+    step.lhs = nodes[best_i].operand;
+    step.rhs = nodes[best_j].operand;
+    EinsumDims out_dims;
+    if (!plan_einsum_step(
+            step,
+            nodes[best_i].dims,
+            nodes[best_j].dims,
+            needed,
+            last ? &out_labels : nullptr,
+            label_size,
+            out_dims)) {
+      return nullptr;
+    }
+    plan->steps.push_back(std::move(step));
+    nodes.erase(nodes.begin() + best_j);
+    nodes[best_i] = {num_operands++, std::move(out_dims)};
+  }
+
+  for (const auto label : out_labels) {
+    const auto* dim = find_dim(nodes[0].dims, label);
+    plan->out_sizes.push_back(dim->size);
+    plan->out_strides.push_back(dim->stride);
+  }
+  return plan;
+}
+
+std::shared_ptr<const EinsumPlan> get_einsum_plan(
+    c10::string_view equation,
+    const c10::List<at::Tensor>& operands) {
+  std::ostringstream key_stream;
+  key_stream << equation;
+  for (const auto i : c10::irange(operands.size())) {
+    const at::Tensor operand = operands.get(i);
+    if (operand.scalar_type() != at::kFloat || operand.requires_grad()) {
+      return nullptr;
+    }
+    key_stream << "|" << operand.sizes() << operand.strides();
+  }
+  const auto key = key_stream.str();
+
+  static std::mutex cache_mutex;
+  static std::unordered_map<std::string, std::shared_ptr<const EinsumPlan>>
+      plan_cache;
+  {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    auto it = plan_cache.find(key);
+    if (it != plan_cache.end()) {
+      return it->second;
+    }
+  }
+  // unsupported equations are cached as nullptr as well
+  auto plan = build_einsum_plan(equation, operands);
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  if (plan_cache.size() >= kMaxCachedEinsumPlans) {
+    plan_cache.clear();
+  }
+  plan_cache.emplace(key, plan);
+  return plan;
+}
+
+void run_einsum_gemm(
+    const EinsumGemm& gemm,
+    const float* lhs,
+    const float* rhs,
+    float* out,
+    float beta) {
+  const float* a = gemm.swap_operands ? rhs : lhs;
+  const float* b = gemm.swap_operands ? lhs : rhs;
+  const MKL_INT batch = gemm.c_offsets.size();
+  std::vector<const float*> a_array(batch), b_array(batch);
+  std::vector<float*> c_array(batch);
+  for (const auto i : c10::irange(batch)) {
+    c_array[i] = out + gemm.c_offsets[i];
+  }
+  const float alpha = 1.0f;
+  for (const auto r : c10::irange(gemm.a_reduce_offsets.size())) {
+    for (const auto i : c10::irange(batch)) {
+      a_array[i] = a + gemm.a_offsets[i] + gemm.a_reduce_offsets[r];
+      b_array[i] = b + gemm.b_offsets[i] + gemm.b_reduce_offsets[r];
+    }
+    const float beta_r = r == 0 ? beta : 1.0f;
+    cblas_sgemm_batch(
+        CblasRowMajor,
+        &gemm.trans_a,
+        &gemm.trans_b,
+        &gemm.m,
+        &gemm.n,
+        &gemm.k,
+        &alpha,
+        a_array.data(),
+        &gemm.lda,
+        b_array.data(),
+        &gemm.ldb,
+        &beta_r,
+        c_array.data(),
+        &gemm.ldc,
+        1,
+        &batch);
+  }
+}
+
+// If add_arg is defined, computes einsum + alpha * add_arg. The add is fused
+// as the initial value of the GEMM output when add_arg broadcasts to it.
+at::Tensor run_einsum_plan(
+    const EinsumPlan& plan,
+    const c10::List<at::Tensor>& operands,
+    const at::Tensor& add_arg,
+    const c10::Scalar& alpha) {
+  std::vector<at::Tensor> tensors = operands.vec();
+  for (const auto& reduce : plan.reduces) {
+    auto& operand = tensors[reduce.operand];
+    auto out = at::empty(reduce.out_sizes, operand.options());
+    at::sum_out(
+        out, operand.as_strided(reduce.sizes, reduce.strides), reduce.dims);
+    operand = out;
+  }
+
+  bool fuse_add = add_arg.defined() && add_arg.scalar_type() == at::kFloat &&
+      add_arg.dim() <= static_cast<int64_t>(plan.out_sizes.size()) &&
+      at::infer_size(plan.out_sizes, add_arg.sizes()) == plan.out_sizes;
+  at::Tensor result;
+  for (const auto s : c10::irange(plan.steps.size())) {
+    const auto& step = plan.steps[s];
+    auto lhs = step.pack_lhs
+        ? tensors[step.lhs]
+              .as_strided(step.lhs_pack_sizes, step.lhs_pack_strides)
+              .contiguous()
+        : tensors[step.lhs];
+    auto rhs = step.pack_rhs
+        ? tensors[step.rhs]
+              .as_strided(step.rhs_pack_sizes, step.rhs_pack_strides)
+              .contiguous()
+        : tensors[step.rhs];
+    auto out = at::empty(step.out_sizes, lhs.options());
+    float beta = 0.0f;
+    if (s == plan.steps.size() - 1) {
+      result = out.as_strided(plan.out_sizes, plan.out_strides);
+      if (fuse_add) {
+        result.copy_(add_arg);
+        if (alpha.to<float>() != 1.0f) {
+          result.mul_(alpha);
+        }
+        beta = 1.0f;
+      }
+    }
+    run_einsum_gemm(
+        step.gemm,
+        lhs.data_ptr<float>(),
+        rhs.data_ptr<float>(),
+        out.data_ptr<float>(),
+        beta);
+    tensors.push_back(out);
+  }
+  if (add_arg.defined() && !fuse_add) {
+    result = at::add(result, add_arg, alpha);
+  }
+  return result;
+}
+
+} // namespace
+
 //! function: einsum_binary
 /*!
  * This function use oneDNN binary post-ops to do the einsum+binary fusion.
@@ -743,6 +1521,12 @@ at::Tensor einsum_binary(
     const at::Tensor& add_arg,
     const c10::Scalar& alpha) {
   RECORD_FUNCTION("dil_einsum_binary", c10::ArrayRef<c10::IValue>({}));
+  if (auto plan = get_einsum_plan(equation, operands)) {
+    return run_einsum_plan(*plan, operands, add_arg, alpha);
+  }
+  if (operands.size() != 2) {
+    return at::add(at::einsum(equation, operands.vec()), add_arg, alpha);
+  }
   auto prepare_res = einsum_prepare(equation, operands);
   bool has_zero_size_dim = std::get<0>(prepare_res);
   auto out_size = std::get<1>(prepare_res);
@@ -787,5 +1571,27 @@ at::Tensor einsum_binary(
   return result;
 }
 
+//! function: einsum_planned
+/*!
+ * Einsum of any number of operands through a plan cached per equation and
+ * operand sizes/strides. The plan picks the contraction order greedily and
+ * maps each pairwise contraction to a strided batch-reduce GEMM on the
+ * operands as they are laid out in memory, they are only copied when their
+ * strides cannot be expressed by the GEMM. Falls back to at::einsum for what
+ * the plan does not handle (non fp32 operands, broadcasting of size 1 dims,
+ * zero sized dims).
+ *\param equation:  The subscripts for the Einstein summation.
+ *\param operands: The tensors to compute the Einstein summation of.
+ */
+at::Tensor einsum_planned(
+    c10::string_view equation,
+    const c10::List<at::Tensor>& operands) {
+  RECORD_FUNCTION("dil_einsum", c10::ArrayRef<c10::IValue>({}));
+  if (auto plan = get_einsum_plan(equation, operands)) {
+    return run_einsum_plan(*plan, operands, at::Tensor(), 1);
+  }
+  return at::einsum(equation, operands.vec());
+}
+
 } // namespace cpu
 } // namespace torch_ipex
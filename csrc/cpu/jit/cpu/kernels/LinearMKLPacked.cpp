@@ -1,7 +1,9 @@
 #include "LinearMKLPacked.h"
 #include <ideep.hpp>
+#include "PackedWeightSerialization.h"
 #include "aten/LinearMKL.h"
 #include "aten/WeightPack.h"
+#include "PostOpChain.h"
 #include "ideep/IDeepConversions.h"
 
 namespace torch_ipex {
@@ -9,6 +11,9 @@ namespace cpu {
 namespace detail {
 namespace mkl_sgemm {
 
+// MKL only generates JIT kernels for small matrices, see mkl_jit_create_sgemm
+constexpr int64_t kMklSgemmJitMaxDim = 128;
+
 c10::intrusive_ptr<MKLOpContext> createLinearMKLPrePackOpContext(
     at::Tensor&& weight,
     c10::optional<at::Tensor>&& bias,
@@ -21,6 +26,25 @@ c10::intrusive_ptr<MKLOpContext> createLinearMKLPrePackOpContext(
       std::move(weight), std::move(bias), batch_size);
 }
 
+c10::intrusive_ptr<MKLOpContext> loadLinearMKLPrePackOpContext(
+    SerializationTypeMKLPrePack&& state) {
+  auto& weight = std::get<0>(state);
+  if (!serialization::is_serialized_weight(weight)) {
+    return createLinearMKLPrePackOpContext(
+        std::move(weight), std::move(std::get<1>(state)), std::get<2>(state));
+  }
+  RECORD_FUNCTION(
+      "ipex_prepack::loadLinearMKLPrePackOpContext",
+      c10::ArrayRef<c10::IValue>({}));
+  auto packed = serialization::deserialize_weight(weight);
+  auto plain_weight = packed.plain;
+  return IpexLinearMKLOpContext::create_context(
+      std::move(plain_weight),
+      std::move(std::get<1>(state)),
+      std::get<2>(state),
+      &packed);
+}
+
 at::Tensor mkl_sgemm_run(
     const at::Tensor& input,
     c10::intrusive_ptr<MKLOpContext> op_context) {
@@ -30,10 +54,22 @@ at::Tensor mkl_sgemm_run(
   return op_context->run(input);
 }
 
+at::Tensor mkl_sgemm_post_ops_run(
+    const at::Tensor& input,
+    c10::ArrayRef<int64_t> post_op_kinds,
+    c10::ArrayRef<double> post_op_params,
+    c10::intrusive_ptr<MKLOpContext> op_context) {
+  RECORD_FUNCTION(
+      "ipex_prepack::mkl_sgemm_post_ops_run", c10::ArrayRef<c10::IValue>({}));
+
+  return run(op_context->get_context(), input, post_op_kinds, post_op_params);
+}
+
 ContextLinearMKL create(
     at::Tensor& weight,
     const c10::optional<at::Tensor>& bias,
-    const c10::optional<int64_t> batch_size) {
+    const c10::optional<int64_t> batch_size,
+    const serialization::PackedWeight* prepacked) {
   weight = weight.contiguous();
   auto out_features = weight.size(0);
   auto in_features = weight.size(1);
@@ -43,36 +79,75 @@ ContextLinearMKL create(
   sgemm_sizes.push_back(in_features);
   sgemm_sizes.push_back(out_features);
 
-  auto mkl_weight =
-      mkl_sgemm_pack_weight(batch, out_features, in_features, weight);
+  at::Tensor mkl_weight;
+  // same size as the buffer allocated by mkl_sgemm_pack_weight
+  auto pack_buf_size = cblas_sgemm_pack_get_size(
+      CblasBMatrix, batch, out_features, in_features);
+  int64_t pack_size = (int64_t)(pack_buf_size / sizeof(float) + 1);
+  if (prepacked != nullptr && prepacked->host_compatible &&
+      prepacked->packed.numel() == pack_size) {
+    // The packed buffer is opaque and only valid for the MKL version and code
+    // path that produced it, which host_compatible guarantees
+    mkl_weight = prepacked->packed;
+  } else {
+    mkl_weight =
+        mkl_sgemm_pack_weight(batch, out_features, in_features, weight);
+  }
 
-  return ContextLinearMKL{
+  auto context = ContextLinearMKL{
       std::move(sgemm_sizes),
       std::move(mkl_weight),
       std::move(weight),
       bias.has_value() ? c10::make_optional(*bias) : c10::nullopt,
   };
+  // Tiny fixed shapes are dominated by the call overhead of cblas_sgemm,
+  // MKL generates a kernel for them
+  if (batch <= kMklSgemmJitMaxDim && out_features <= kMklSgemmJitMaxDim &&
+      in_features <= kMklSgemmJitMaxDim) {
+    context.jit_kernel_ = mkl_sgemm_jit_create(
+        batch, out_features, in_features, bias.has_value() ? 1.f : 0.f);
+  }
+  return context;
 }
 
 at::Tensor run(ContextLinearMKL& context, const at::Tensor& input) {
+  return run(context, input, {}, {});
+}
+
+at::Tensor run(
+    ContextLinearMKL& context,
+    const at::Tensor& input,
+    c10::ArrayRef<int64_t> post_op_kinds,
+    c10::ArrayRef<double> post_op_params) {
   int64_t K = input.size(input.dim() - 1);
   TORCH_CHECK(
       K == context.sgemm_sizes_[1],
       "Check the shapes of mat1 and mat2, they cannot be multiplied!");
+  TORCH_CHECK(
+      check_post_op_chain(post_op_kinds, post_op_params) == 0,
+      "mkl_sgemm only supports eltwise post-ops");
   auto input_ = input.contiguous();
   c10::MaybeOwned<at::Tensor> bias_maybe_owned =
       at::borrow_from_optional_tensor(context.at_bias_);
   const at::Tensor& bias = *bias_maybe_owned;
   int64_t input_batch = (int64_t)(input_.numel() / K);
+  MklSgemmParams params;
+  params.post_op_kinds = post_op_kinds;
+  params.post_op_params = post_op_params;
+  params.num_threads = context.num_threads_;
 
   // Since MKL prepack API only accepts fixed M/N/K, a repack is required
   // when M changes. To avoid frequently repacking the weights,
   // it will fall back to the MKL cblas_sgemm kernel when M-dim is
   // dynamically changed.
   if (input_batch != context.sgemm_sizes_[0])
-    return mkl_sgemm_kernel(input_, context.ori_weight_, bias);
+    return mkl_sgemm_kernel(input_, context.ori_weight_, bias, params);
+  if (context.jit_kernel_.defined()) {
+    params.jit_kernel = &context.jit_kernel_;
+    return mkl_sgemm_kernel(input_, context.ori_weight_, bias, params);
+  }
   return mkl_prepack_sgemm_kernel(
-      input_, context.at_weight_, bias, context.sgemm_sizes_[2]);
+      input_, context.at_weight_, bias, context.sgemm_sizes_[2], params);
 }
 
 at::Tensor& run(
@@ -88,11 +163,21 @@ at::Tensor& run(
       at::borrow_from_optional_tensor(context.at_bias_);
   const at::Tensor& bias = *bias_maybe_owned;
   int64_t input_batch = (int64_t)(input_.numel() / K);
+  MklSgemmParams params;
+  params.num_threads = context.num_threads_;
   if (input_batch != context.sgemm_sizes_[0]) {
-    mkl_sgemm_kernel_output(input_, context.ori_weight_, bias, accumu);
+    mkl_sgemm_kernel_output(input_, context.ori_weight_, bias, accumu, params);
+  } else if (context.jit_kernel_.defined()) {
+    params.jit_kernel = &context.jit_kernel_;
+    mkl_sgemm_kernel_output(input_, context.ori_weight_, bias, accumu, params);
   } else {
     mkl_prepack_sgemm_kernel_output(
-        input_, context.at_weight_, bias, context.sgemm_sizes_[2], accumu);
+        input_,
+        context.at_weight_,
+        bias,
+        context.sgemm_sizes_[2],
+        accumu,
+        params);
   }
   return accumu;
 }
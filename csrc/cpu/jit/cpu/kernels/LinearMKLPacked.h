@@ -14,17 +14,39 @@ c10::intrusive_ptr<MKLOpContext> createLinearMKLPrePackOpContext(
     c10::optional<at::Tensor>&& bias,
     c10::optional<int64_t> batch_size);
 
+// Restore the op context from its pickled state, which holds either the public
+// weight (legacy format) or a serialized packed weight blob
+c10::intrusive_ptr<MKLOpContext> loadLinearMKLPrePackOpContext(
+    SerializationTypeMKLPrePack&& state);
+
 at::Tensor mkl_sgemm_run(
     const at::Tensor& input,
     c10::intrusive_ptr<MKLOpContext> op_context);
 
+// mkl_sgemm_run followed by a chain of eltwise post-ops (see PostOpChain.h),
+// applied on each output tile by the sgemm kernel
+at::Tensor mkl_sgemm_post_ops_run(
+    const at::Tensor& input,
+    c10::ArrayRef<int64_t> post_op_kinds,
+    c10::ArrayRef<double> post_op_params,
+    c10::intrusive_ptr<MKLOpContext> op_context);
+
+// If prepacked is given, its MKL packed buffer is adopted without copy when it
+// was packed by the same MKL on the same code path, otherwise weight is packed.
 ContextLinearMKL create(
     at::Tensor& weight,
     const c10::optional<at::Tensor>& bias,
-    const c10::optional<int64_t> batch_size);
+    const c10::optional<int64_t> batch_size,
+    const serialization::PackedWeight* prepacked = nullptr);
 
 at::Tensor run(ContextLinearMKL& context, const at::Tensor& input);
 
+at::Tensor run(
+    ContextLinearMKL& context,
+    const at::Tensor& input,
+    c10::ArrayRef<int64_t> post_op_kinds,
+    c10::ArrayRef<double> post_op_params);
+
 at::Tensor& run(
     ContextLinearMKL& context,
     const at::Tensor& input,
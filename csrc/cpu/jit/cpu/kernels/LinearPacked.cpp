@@ -2,7 +2,10 @@
 #include <ideep.hpp>
 #include "aten/Linear.h"
 #include "aten/WeightPack.h"
+#include "PackedWeightSerialization.h"
+#include "PostOpChain.h"
 #include "ideep/IDeepConversions.h"
+#include "utils/long_lived_alloc.h"
 
 namespace torch_ipex {
 namespace cpu {
@@ -34,6 +37,32 @@ c10::intrusive_ptr<LinearOpContext> createLinearPrePackOpContext(
       std::move(weight), std::move(bias), batch_size);
 }
 
+c10::intrusive_ptr<LinearOpContext> loadLinearPrePackOpContext(
+    SerializationTypeLinearPrePack&& state) {
+  auto& weight = std::get<0>(state);
+  if (!serialization::is_serialized_weight(weight)) {
+    return createLinearPrePackOpContext(
+        std::move(weight), std::move(std::get<1>(state)), std::get<2>(state));
+  }
+  RECORD_FUNCTION(
+      "ipex_prepack::loadLinearPrePackOpContext",
+      c10::ArrayRef<c10::IValue>({}));
+  auto packed = serialization::deserialize_weight(weight);
+  if (!packed.same_library) {
+    // The packed layout was produced by another oneDNN version, repack from
+    // the public weight
+    return IpexLinearOpContext::create_context(
+        serialization::to_public(packed),
+        std::move(std::get<1>(state)),
+        std::get<2>(state));
+  }
+  return IpexLinearOpContext::create_context(
+      serialization::empty_public_weight(packed),
+      std::move(std::get<1>(state)),
+      std::get<2>(state),
+      &packed);
+}
+
 at::Tensor linear_run(
     const at::Tensor& input,
     const c10::intrusive_ptr<LinearOpContext>& op_context) {
@@ -224,10 +253,28 @@ at::Tensor linear_mul_add_run(
       input, post_op_tensors, op_attr.set_fpmath_mode(torch_ipex::fpmath_mode));
 }
 
+at::Tensor linear_post_ops_run(
+    const at::Tensor& input,
+    c10::ArrayRef<at::Tensor> post_op_srcs,
+    c10::ArrayRef<int64_t> post_op_kinds,
+    c10::ArrayRef<double> post_op_params,
+    const c10::intrusive_ptr<LinearOpContext>& op_context) {
+  RECORD_FUNCTION(
+      "ipex_prepack::linear_post_ops_run", c10::ArrayRef<c10::IValue>({}));
+  return run_post_op_chain(
+      op_context->get_context(),
+      input,
+      at::Tensor(),
+      post_op_srcs,
+      post_op_kinds,
+      post_op_params);
+}
+
 ContextLinear create(
     const at::Tensor& weight,
     const c10::optional<at::Tensor>& bias,
-    const c10::optional<int64_t> batch_size) {
+    const c10::optional<int64_t> batch_size,
+    const serialization::PackedWeight* prepacked) {
   auto out_features = weight.size(0);
   auto in_features = weight.size(1);
   ideep::tensor packed_weight;
@@ -243,7 +290,22 @@ ContextLinear create(
       input_size,
       /* weight dtype */ dtype,
       /* src dtype */ dtype);
-  auto at_weight = empty_aten_tensor_from_desc(packed_desc, weight.options());
+  if (prepacked != nullptr && prepacked->host_compatible &&
+      prepacked->packed_desc == packed_desc) {
+    // The serialized weight is already in the expected layout, use it in place
+    // from the loaded storage. If huge pages are enabled for packed weights it
+    // is copied once into a huge page mapping like a freshly packed weight.
+    auto at_weight = utils::to_long_lived(prepacked->packed);
+    packed_weight.init(packed_desc, at_weight.data_ptr());
+    return ContextLinear{
+        std::move(ori_desc),
+        std::move(packed_weight),
+        std::move(at_weight),
+        bias.has_value() ? c10::make_optional(*bias) : c10::nullopt,
+    };
+  }
+  auto at_weight = empty_aten_tensor_from_desc(
+      packed_desc, weight.options(), /*long_lived*/ true);
   if (ideep::data_type::f32 == dtype) {
     packed_weight.init(packed_desc, at_weight.template data_ptr<float>());
   } else if (ideep::data_type::bf16 == dtype) {
@@ -255,7 +317,11 @@ ContextLinear create(
         "Only support bfloat16, float16 and float for weight prepack of linear");
     packed_weight.init(packed_desc, at_weight.template data_ptr<c10::Half>());
   }
-  packed_weight.feed_from(w);
+  if (prepacked != nullptr) {
+    packed_weight.feed_from(serialization::packed_itensor(*prepacked));
+  } else {
+    packed_weight.feed_from(w);
+  }
   return ContextLinear{
       std::move(ori_desc),
       std::move(packed_weight),
@@ -340,6 +406,108 @@ void run_core(
   }
 }
 
+// View a binary post-op source as a 2D tensor which oneDNN can broadcast to
+// the [M, N] inner product output, see [Note: onednn inner product with
+// Pytorch Linear]: either one of the output shape, or a row of N elements, or a
+// single element. Return an undefined tensor for other shapes.
+static at::Tensor post_op_src_view_2d(
+    const at::Tensor& src,
+    at::IntArrayRef output_size) {
+  auto out_features = output_size.back();
+  if (src.dim() > static_cast<int64_t>(output_size.size())) {
+    return at::Tensor();
+  }
+  if (src.sizes() == output_size) {
+    return src.reshape({-1, out_features});
+  }
+  if (src.numel() == 1) {
+    return src.reshape({1, 1});
+  }
+  if (src.dim() > 0 && src.size(-1) == out_features &&
+      src.numel() == out_features) {
+    return src.reshape({1, out_features});
+  }
+  return at::Tensor();
+}
+
+at::Tensor run_post_op_chain(
+    const ContextLinear& context,
+    const at::Tensor& input,
+    at::Tensor output,
+    c10::ArrayRef<at::Tensor> post_op_srcs,
+    c10::ArrayRef<int64_t> post_op_kinds,
+    c10::ArrayRef<double> post_op_params) {
+  TORCH_CHECK(
+      input.size(input.dim() - 1) == context.weight_packed_.get_dims()[1],
+      "Check the shapes of mat1 and mat2, they cannot be multiplied!");
+  auto num_srcs = check_post_op_chain(post_op_kinds, post_op_params);
+  TORCH_CHECK(
+      num_srcs == static_cast<int64_t>(post_op_srcs.size()),
+      "linear post-op chain: expected ",
+      num_srcs,
+      " post-op sources, got ",
+      post_op_srcs.size());
+  TORCH_CHECK(
+      std::find(post_op_kinds.begin(), post_op_kinds.end(), kPostOpSum) ==
+          post_op_kinds.end(),
+      "linear post-op chain: the sum post-op is not supported, use a binary "
+      "add instead");
+
+  auto input_ = input.contiguous();
+  c10::MaybeOwned<at::Tensor> bias_maybe_owned =
+      at::borrow_from_optional_tensor(context.at_bias_);
+  const at::Tensor& bias = *bias_maybe_owned;
+  auto output_size = input_.sizes().vec();
+  output_size.back() = context.weight_packed_.get_dim(0);
+  auto linear_output = output.defined() && output.sizes() == output_size
+      ? output
+      : at::empty(output_size, input_.options());
+
+  // Binary post-op sources are computed in the dtype of the output, oneDNN
+  // accumulates in fp32 and applies the chain before the down conversion.
+  std::vector<at::Tensor> srcs_2d;
+  std::vector<ideep::tensor> onednn_srcs;
+  std::vector<ideep::tensor::desc> src_descs;
+  for (const auto& src : post_op_srcs) {
+    auto src_2d = post_op_src_view_2d(
+        src.to(input_.scalar_type()).contiguous(), output_size);
+    if (!src_2d.defined()) {
+      break;
+    }
+    srcs_2d.push_back(src_2d);
+    onednn_srcs.push_back(itensor_view_from_dense(src_2d));
+    src_descs.push_back(onednn_srcs.back().get_desc());
+  }
+
+  at::Tensor result;
+  if (srcs_2d.size() == post_op_srcs.size()) {
+    linear_kernel_output(
+        input_,
+        context.weight_packed_,
+        bias,
+        linear_output,
+        make_post_op_chain_attr(post_op_kinds, post_op_params, src_descs),
+        onednn_srcs);
+    result = linear_output;
+  } else {
+    linear_kernel_output(
+        input_,
+        context.weight_packed_,
+        bias,
+        linear_output,
+        ideep::attr_t().set_fpmath_mode(torch_ipex::fpmath_mode));
+    result = apply_post_op_chain(
+        linear_output, post_op_srcs, post_op_kinds, post_op_params);
+  }
+  if (!output.defined()) {
+    return result;
+  }
+  if (!result.is_same(output)) {
+    output.copy_(result);
+  }
+  return output;
+}
+
 std::tuple<at::Tensor, at::Tensor, at::Tensor> run_backward(
     ContextLinear& context,
     const at::Tensor& input,
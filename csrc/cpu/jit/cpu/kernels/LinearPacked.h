@@ -19,6 +19,11 @@ c10::intrusive_ptr<LinearOpContext> createLinearPrePackOpContext(
     c10::optional<at::Tensor>&& bias,
     c10::optional<int64_t> batch_size);
 
+// Restore the op context from its pickled state, which holds either the public
+// weight (legacy format) or a serialized packed weight blob
+c10::intrusive_ptr<LinearOpContext> loadLinearPrePackOpContext(
+    SerializationTypeLinearPrePack&& state);
+
 at::Tensor linear_run(
     const at::Tensor& input,
     const c10::intrusive_ptr<LinearOpContext>& op_context);
@@ -88,10 +93,23 @@ at::Tensor linear_mul_add_run(
     const at::Tensor& to_add,
     const c10::intrusive_ptr<LinearOpContext>& op_context);
 
+// Linear with a chain of eltwise/binary post-ops fused into its epilogue, see
+// PostOpChain.h. post_op_srcs holds the operands of the binary post-ops.
+at::Tensor linear_post_ops_run(
+    const at::Tensor& input,
+    c10::ArrayRef<at::Tensor> post_op_srcs,
+    c10::ArrayRef<int64_t> post_op_kinds,
+    c10::ArrayRef<double> post_op_params,
+    const c10::intrusive_ptr<LinearOpContext>& op_context);
+
+// If prepacked is given, weight only provides the public sizes/strides and
+// dtype, and the packed data is taken from prepacked: it is adopted without copy
+// when its layout is the expected one, otherwise it is reordered.
 ContextLinear create(
     const at::Tensor& weight,
     const c10::optional<at::Tensor>& bias,
-    const c10::optional<int64_t> batch_size);
+    const c10::optional<int64_t> batch_size,
+    const serialization::PackedWeight* prepacked = nullptr);
 
 at::Tensor run(
     const ContextLinear& context,
@@ -116,6 +134,17 @@ void run_core(
     at::Tensor& accumu,
     const ideep::attr_t attr);
 
+// Runs linear with the post-op chain into output if it is defined, otherwise
+// into a new tensor, and returns the result. If a binary post-op source can not
+// be broadcast by oneDNN, the chain is applied with ATen ops after linear.
+at::Tensor run_post_op_chain(
+    const ContextLinear& context,
+    const at::Tensor& input,
+    at::Tensor output,
+    c10::ArrayRef<at::Tensor> post_op_srcs,
+    c10::ArrayRef<int64_t> post_op_kinds,
+    c10::ArrayRef<double> post_op_params);
+
 // Runing backward for ConvTranspose by given grad_output, input and grad_masks.
 // Will using the mkldnn_weight stored in the context
 std::tuple<at::Tensor, at::Tensor, at::Tensor> run_backward(
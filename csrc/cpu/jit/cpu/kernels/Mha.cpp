@@ -207,7 +207,7 @@ at::Tensor dil_mha_matmul_trans(
 /**
  *  This kernel implements Flast attention
  * (https://hazyresearch.stanford.edu/blog/2023-01-12-flashattention-long-sequences)
- * on Bert models for BF16 dtype
+ * on Bert models for BF16, FP16 and FP32 dtypes
  */
 at::Tensor dil_bert_flash_mha(
     const at::Tensor& qkv,
@@ -225,10 +225,10 @@ at::Tensor dil_bert_flash_mha(
 
 /**
  *  This kernel implements Flast attention on stable-diffusion models (from
- * Diffusers 0.12.1 and 0.13) for BF16 dtype, where qkv is from one
- * aten::linear; Note that in 0.13, aten::scaled_dot_product_attention uses the
- * scale of sqrt(headSize) if no scale is provided for query, where we are
- * following
+ * Diffusers 0.12.1 and 0.13) for BF16, FP16 and FP32 dtypes, where qkv is
+ * from one aten::linear; Note that in 0.13, aten::scaled_dot_product_attention
+ * uses the scale of sqrt(headSize) if no scale is provided for query, where we
+ * are following
  */
 at::Tensor dil_sd_flash_mha(
     const at::Tensor& qkv,
@@ -247,9 +247,11 @@ at::Tensor dil_sd_flash_mha(
 
 /**
  *  This kernel implements Flast attention on stable-diffusion models (from
- * Diffusers 0.12.1 and 0.13) for BF16 dtype, where qkv is splited; Note that
- * in 0.13, aten::scaled_dot_product_attention uses the scale of sqrt(headSize)
- * if no scale is provided for query, where we are following
+ * Diffusers 0.12.1 and 0.13) for BF16, FP16 and FP32 dtypes, where qkv is
+ * splited, and key and value may have another length than query for the
+ * cross-attention; Note that in 0.13, aten::scaled_dot_product_attention uses
+ * the scale of sqrt(headSize) if no scale is provided for query, where we are
+ * following
  */
 at::Tensor dil_sd_flash_mha(
     const at::Tensor& query,
@@ -306,6 +308,9 @@ c10::List<at::Tensor> dil_split_tensor(
     const at::Tensor& mat,
     const at::IntArrayRef& split_list) {
   RECORD_FUNCTION("dil_split_tensor", c10::ArrayRef<c10::IValue>({}));
+  if (mat.scalar_type() == at::kHalf) {
+    return c10::List<at::Tensor>(dil_mat_split<at::Half>(mat, split_list));
+  }
   return c10::List<at::Tensor>(dil_mat_split<at::BFloat16>(mat, split_list));
 }
 } // namespace cpu
@@ -5,6 +5,7 @@
 #include "LinearMKLPacked.h"
 #include "LinearPacked.h"
 #include "LinearWoqPacked.h"
+#include "PackedWeightSerialization.h"
 
 namespace torch_ipex {
 namespace cpu {
@@ -45,7 +46,8 @@ c10::intrusive_ptr<ConvolutionOpContext> IpexConvolutionOpContext::
         int64_t groups,
         bool weight_is_channels_last,
         std::vector<int64_t>&& input_size,
-        const ideep::attr_t& attr) {
+        const ideep::attr_t& attr,
+        const detail::serialization::PackedWeight* prepacked) {
   auto op_context = torch_ipex::cpu::detail::convolution::create(
       weight,
       bias,
@@ -55,7 +57,8 @@ c10::intrusive_ptr<ConvolutionOpContext> IpexConvolutionOpContext::
       groups,
       weight_is_channels_last,
       input_size,
-      attr);
+      attr,
+      prepacked);
   return c10::make_intrusive<IpexConvolutionOpContext>(
       std::move(stride),
       std::move(padding),
@@ -64,6 +67,25 @@ c10::intrusive_ptr<ConvolutionOpContext> IpexConvolutionOpContext::
       std::move(op_context));
 }
 
+SerializationTypeConvolutionPrePack ConvolutionOpContext::serialize() {
+  auto& context = this->get_context();
+  auto weight_blob = detail::serialization::serialize_onednn_weight(
+      context.weight_packed_.get_desc(),
+      context.at_weight_,
+      context.groups_,
+      context.original_desc_.get_dims(),
+      context.original_desc_.get_strides());
+  return std::make_tuple(
+      weight_blob,
+      context.at_bias_,
+      stride_,
+      padding_,
+      dilation_,
+      context.groups_,
+      context.weight_is_channels_last_,
+      input_size_);
+}
+
 std::vector<int64_t> ConvolutionOpContext::get_stride() {
   return this->get_context().stride_;
 }
@@ -133,18 +155,34 @@ at::Tensor IpexConvolutionOpContext::get_data_handle() {
 void IpexConvolutionOpContext::load_from_ctx(
     c10::intrusive_ptr<ConvolutionOpContext> other) {
   load_from_ctx_template(this, other);
+  // The fp32 weights of the fused blocks are derived from the packed weight
+  auto& cache = *op_context_.block_weight_;
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  cache.weight_version = -1;
 }
 
 c10::intrusive_ptr<LinearOpContext> IpexLinearOpContext::create_context(
     at::Tensor&& weight,
     c10::optional<at::Tensor>&& bias,
-    c10::optional<int64_t> batch_size) {
-  auto op_context =
-      torch_ipex::cpu::detail::linear::create(weight, bias, batch_size);
+    c10::optional<int64_t> batch_size,
+    const detail::serialization::PackedWeight* prepacked) {
+  auto op_context = torch_ipex::cpu::detail::linear::create(
+      weight, bias, batch_size, prepacked);
   return c10::make_intrusive<IpexLinearOpContext>(
       batch_size, std::move(op_context));
 }
 
+SerializationTypeLinearPrePack LinearOpContext::serialize() {
+  auto& context = this->get_context();
+  auto weight_blob = detail::serialization::serialize_onednn_weight(
+      context.weight_packed_.get_desc(),
+      context.at_weight_,
+      /* groups */ 1,
+      context.original_desc_.get_dims(),
+      context.original_desc_.get_strides());
+  return std::make_tuple(weight_blob, context.at_bias_, batch_size_);
+}
+
 at::Tensor IpexLinearOpContext::get_data_handle() {
   at::Tensor ptr = at::empty(1, at::kLong);
   ptr[0] = reinterpret_cast<int64_t>(this);
@@ -239,13 +277,29 @@ c10::intrusive_ptr<ConvTransposeOpContext> IpexConvTransposeOpContext::
 c10::intrusive_ptr<MKLOpContext> IpexLinearMKLOpContext::create_context(
     at::Tensor&& weight,
     c10::optional<at::Tensor>&& bias,
-    c10::optional<int64_t> batch_size) {
-  auto op_context =
-      torch_ipex::cpu::detail::mkl_sgemm::create(weight, bias, batch_size);
+    c10::optional<int64_t> batch_size,
+    const detail::serialization::PackedWeight* prepacked) {
+  auto op_context = torch_ipex::cpu::detail::mkl_sgemm::create(
+      weight, bias, batch_size, prepacked);
   return c10::make_intrusive<IpexLinearMKLOpContext>(
       batch_size, std::move(op_context));
 }
 
+SerializationTypeMKLPrePack MKLOpContext::serialize() {
+  auto& context = this->get_context();
+  auto weight_blob = detail::serialization::serialize_mkl_weight(
+      context.at_weight_, context.ori_weight_);
+  return std::make_tuple(weight_blob, context.at_bias_, batch_size_);
+}
+
+void MKLOpContext::set_num_threads(int64_t num_threads) {
+  TORCH_CHECK(
+      num_threads >= 0,
+      "MKLOpContext: expected a non-negative number of threads, got ",
+      num_threads);
+  this->get_context().num_threads_ = num_threads;
+}
+
 at::Tensor IpexLinearMKLOpContext::get_at_packed_weight() {
   return op_context_.at_weight_;
 }
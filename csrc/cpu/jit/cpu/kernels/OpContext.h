@@ -14,6 +14,11 @@
 
 namespace torch_ipex {
 namespace cpu {
+namespace detail {
+namespace serialization {
+struct PackedWeight;
+} // namespace serialization
+} // namespace detail
 
 using SerializationTypeConvolutionPrePack = std::tuple<
     at::Tensor,
@@ -51,6 +56,10 @@ class ConvolutionOpContext : public torch::jit::CustomClassHolder {
         input_size_);
   }
 
+  // Same as unpack, but the weight is kept in its packed layout and wrapped in
+  // a serialized blob, see PackedWeightSerialization.h
+  SerializationTypeConvolutionPrePack serialize();
+
   virtual at::Tensor run(
       const at::Tensor& input,
       const ideep::attr_t& attr) = 0;
@@ -156,7 +165,8 @@ class IpexConvolutionOpContext final : public ConvolutionOpContext {
       int64_t groups,
       bool weight_is_channels_last,
       std::vector<int64_t>&& input_size,
-      const ideep::attr_t& attr);
+      const ideep::attr_t& attr,
+      const detail::serialization::PackedWeight* prepacked = nullptr);
 };
 
 // linear op
@@ -174,6 +184,10 @@ class LinearOpContext : public torch::jit::CustomClassHolder {
     return std::make_tuple(orig_weight_, orig_bias_, batch_size_);
   }
 
+  // Same as unpack, but the weight is kept in its packed layout and wrapped in
+  // a serialized blob, see PackedWeightSerialization.h
+  SerializationTypeLinearPrePack serialize();
+
   virtual at::Tensor get_data_handle() = 0;
 
   virtual at::Tensor run(
@@ -266,7 +280,8 @@ class IpexLinearOpContext final : public LinearOpContext {
   static c10::intrusive_ptr<LinearOpContext> create_context(
       at::Tensor&& weight,
       c10::optional<at::Tensor>&& bias,
-      c10::optional<int64_t> batch_size);
+      c10::optional<int64_t> batch_size,
+      const detail::serialization::PackedWeight* prepacked = nullptr);
 
   virtual void load_from_ctx(
       c10::intrusive_ptr<LinearOpContext> other) override;
@@ -286,6 +301,10 @@ class MKLOpContext : public torch::jit::CustomClassHolder {
     return std::make_tuple(orig_weight, orig_bias, batch_size_);
   }
 
+  // Same as unpack, but the MKL packed buffer is kept and wrapped in a
+  // serialized blob, see PackedWeightSerialization.h
+  SerializationTypeMKLPrePack serialize();
+
   virtual at::Tensor get_at_packed_weight() = 0;
 
   virtual c10::optional<at::Tensor> get_at_bias() = 0;
@@ -309,6 +328,10 @@ class MKLOpContext : public torch::jit::CustomClassHolder {
 
   c10::optional<int64_t> get_batchsize();
 
+  // The number of threads the sgemm is spread over, 0 for
+  // at::get_num_threads(). Not serialized, it depends on the deployment.
+  void set_num_threads(int64_t num_threads);
+
   // The load_state_dict behavior for nn.Modules are inplace copy weight from
   // state_dict So the load_state_dict for optimizer can only handle the states
   // and keep parameter groups un-changed Thus we need this method to apply
@@ -354,7 +377,8 @@ class IpexLinearMKLOpContext final : public MKLOpContext {
   static c10::intrusive_ptr<MKLOpContext> create_context(
       at::Tensor&& weight,
       c10::optional<at::Tensor>&& bias,
-      c10::optional<int64_t> batch_size);
+      c10::optional<int64_t> batch_size,
+      const detail::serialization::PackedWeight* prepacked = nullptr);
 
   virtual void load_from_ctx(c10::intrusive_ptr<MKLOpContext> other) override;
 };
@@ -0,0 +1,373 @@
+#include "PackedWeightSerialization.h"
+
+#include <ATen/ATen.h>
+#include <dnnl.hpp>
+#include <cstring>
+#include "mkl.h"
+
+namespace torch_ipex {
+namespace cpu {
+namespace detail {
+namespace serialization {
+
+namespace {
+
+constexpr char kMagic[8] = {'I', 'P', 'E', 'X', 'P', 'K', 'W', '\0'};
+constexpr int32_t kFormatVersion = 1;
+// Keep sections cache line aligned, which is also the alignment of the storage
+// allocated by the default CPU allocator when the blob is loaded back.
+constexpr int64_t kSectionAlignment = 64;
+constexpr int64_t kMaxSections = 4;
+
+enum OneDNNSection {
+  // oneDNN memory desc blob of the packed weight
+  kPackedDesc = 0,
+  // [ndims, nblks, dims, padded_dims, strides, inner_blks, inner_idxs]
+  kLayout = 1,
+  // [ndims, sizes, strides] of the public weight
+  kPublic = 2,
+  kOneDNNData = 3,
+};
+
+enum MKLSection {
+  // cblas_sgemm_pack buffer
+  kMKLData = 0,
+  kPlainData = 1,
+  // sizes of the plain weight
+  kPlainSizes = 2,
+};
+
+struct BlobHeader {
+  char magic[8];
+  int32_t format_version;
+  int32_t kind;
+  int32_t isa;
+  int32_t dtype;
+  int64_t lib_version;
+  int64_t groups;
+  int64_t num_sections;
+  int64_t section_offset[kMaxSections];
+  int64_t section_size[kMaxSections];
+};
+
+struct Section {
+  const void* data;
+  int64_t size;
+};
+
+inline int64_t round_up(int64_t value) {
+  return (value + kSectionAlignment - 1) / kSectionAlignment *
+      kSectionAlignment;
+}
+
+int32_t onednn_isa() {
+  return static_cast<int32_t>(dnnl::get_effective_cpu_isa());
+}
+
+int64_t onednn_version() {
+  const dnnl_version_t* v = dnnl_version();
+  return v->major * 10000 + v->minor * 100 + v->patch;
+}
+
+int32_t mkl_isa() {
+  return static_cast<int32_t>(mkl_cbwr_get_auto_branch());
+}
+
+int64_t mkl_version() {
+  MKLVersion version;
+  mkl_get_version(&version);
+  return static_cast<int64_t>(version.MajorVersion) * 10000 +
+      version.MinorVersion * 100 + version.UpdateVersion;
+}
+
+BlobHeader make_header(
+    PackedWeightKind kind,
+    int32_t isa,
+    at::ScalarType dtype,
+    int64_t lib_version,
+    int64_t groups) {
+  BlobHeader header = {};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.format_version = kFormatVersion;
+  header.kind = static_cast<int32_t>(kind);
+  header.isa = isa;
+  header.dtype = static_cast<int32_t>(dtype);
+  header.lib_version = lib_version;
+  header.groups = groups;
+  return header;
+}
+
+at::Tensor make_blob(BlobHeader& header, const std::vector<Section>& sections) {
+  TORCH_INTERNAL_ASSERT(sections.size() <= kMaxSections);
+  int64_t offset = round_up(sizeof(BlobHeader));
+  header.num_sections = sections.size();
+  for (size_t i = 0; i < sections.size(); i++) {
+    header.section_offset[i] = offset;
+    header.section_size[i] = sections[i].size;
+    offset = round_up(offset + sections[i].size);
+  }
+  auto blob = at::zeros({offset}, at::kByte);
+  auto blob_ptr = blob.data_ptr<uint8_t>();
+  std::memcpy(blob_ptr, &header, sizeof(BlobHeader));
+  for (size_t i = 0; i < sections.size(); i++) {
+    std::memcpy(
+        blob_ptr + header.section_offset[i],
+        sections[i].data,
+        sections[i].size);
+  }
+  return blob;
+}
+
+BlobHeader read_header(const at::Tensor& blob) {
+  BlobHeader header;
+  std::memcpy(&header, blob.data_ptr<uint8_t>(), sizeof(BlobHeader));
+  TORCH_CHECK(
+      header.format_version == kFormatVersion,
+      "Unsupported serialized packed weight format version ",
+      header.format_version,
+      ", expected ",
+      kFormatVersion);
+  TORCH_CHECK(
+      header.num_sections <= kMaxSections,
+      "Corrupted serialized packed weight");
+  for (int64_t i = 0; i < header.num_sections; i++) {
+    TORCH_CHECK(
+        header.section_offset[i] + header.section_size[i] <= blob.numel(),
+        "Corrupted serialized packed weight");
+  }
+  return header;
+}
+
+// The returned tensor is a view of the blob, no copy is made
+at::Tensor section_view(
+    const at::Tensor& blob,
+    const BlobHeader& header,
+    int64_t idx) {
+  return blob.narrow(0, header.section_offset[idx], header.section_size[idx]);
+}
+
+std::vector<int64_t> section_ints(
+    const at::Tensor& blob,
+    const BlobHeader& header,
+    int64_t idx) {
+  auto ints = section_view(blob, header, idx).view(at::kLong);
+  auto ints_ptr = ints.data_ptr<int64_t>();
+  return std::vector<int64_t>(ints_ptr, ints_ptr + ints.numel());
+}
+
+// Sizes of the aten tensor holding the packed weight, follow the same rule as
+// empty_aten_tensor_from_desc: outer (padded) dims followed by inner blocks.
+std::vector<int64_t> packed_sizes_from_layout(
+    const std::vector<int64_t>& layout) {
+  int64_t ndims = layout[0];
+  int64_t nblks = layout[1];
+  const int64_t* padded_dims = layout.data() + 2 + ndims;
+  const int64_t* blks = layout.data() + 2 + 3 * ndims;
+  const int64_t* idxs = blks + nblks;
+  std::vector<int64_t> blk_size_per_dim(ndims, 1);
+  for (int64_t i = 0; i < nblks; i++) {
+    blk_size_per_dim[idxs[i]] *= blks[i];
+  }
+  std::vector<int64_t> sizes(ndims + nblks);
+  for (int64_t i = 0; i < ndims; i++) {
+    sizes[i] = padded_dims[i] / blk_size_per_dim[i];
+  }
+  for (int64_t i = 0; i < nblks; i++) {
+    sizes[ndims + i] = blks[i];
+  }
+  return sizes;
+}
+
+} // namespace
+
+at::Tensor serialize_onednn_weight(
+    const ideep::tensor::desc& packed_desc,
+    const at::Tensor& at_packed_weight,
+    int64_t groups,
+    at::IntArrayRef public_sizes,
+    at::IntArrayRef public_strides) {
+  // Use the plain oneDNN view of the desc, ideep hides the group dim
+  const auto& md = static_cast<const dnnl::memory::desc&>(packed_desc);
+  auto desc_blob = md.get_blob();
+
+  auto dims = md.get_dims();
+  auto padded_dims = md.get_padded_dims();
+  auto strides = md.get_strides();
+  auto nblks = md.get_inner_nblks();
+  auto blks = md.get_inner_blks();
+  auto idxs = md.get_inner_idxs();
+  std::vector<int64_t> layout = {(int64_t)dims.size(), (int64_t)nblks};
+  layout.insert(layout.end(), dims.begin(), dims.end());
+  layout.insert(layout.end(), padded_dims.begin(), padded_dims.end());
+  layout.insert(layout.end(), strides.begin(), strides.end());
+  layout.insert(layout.end(), blks.begin(), blks.begin() + nblks);
+  layout.insert(layout.end(), idxs.begin(), idxs.begin() + nblks);
+
+  std::vector<int64_t> public_meta = {(int64_t)public_sizes.size()};
+  public_meta.insert(
+      public_meta.end(), public_sizes.begin(), public_sizes.end());
+  public_meta.insert(
+      public_meta.end(), public_strides.begin(), public_strides.end());
+
+  auto header = make_header(
+      PackedWeightKind::OneDNN,
+      onednn_isa(),
+      at_packed_weight.scalar_type(),
+      onednn_version(),
+      groups);
+  return make_blob(
+      header,
+      {{desc_blob.data(), (int64_t)desc_blob.size()},
+       {layout.data(), (int64_t)(layout.size() * sizeof(int64_t))},
+       {public_meta.data(), (int64_t)(public_meta.size() * sizeof(int64_t))},
+       {at_packed_weight.data_ptr(), (int64_t)at_packed_weight.nbytes()}});
+}
+
+at::Tensor serialize_mkl_weight(
+    const at::Tensor& mkl_weight,
+    const at::Tensor& ori_weight) {
+  auto ori_weight_ = ori_weight.contiguous();
+  auto plain_sizes = ori_weight_.sizes().vec();
+
+  auto header = make_header(
+      PackedWeightKind::MKL,
+      mkl_isa(),
+      ori_weight_.scalar_type(),
+      mkl_version(),
+      1);
+  return make_blob(
+      header,
+      {{mkl_weight.data_ptr(), (int64_t)mkl_weight.nbytes()},
+       {ori_weight_.data_ptr(), (int64_t)ori_weight_.nbytes()},
+       {plain_sizes.data(), (int64_t)(plain_sizes.size() * sizeof(int64_t))}});
+}
+
+bool is_serialized_weight(const at::Tensor& tensor) {
+  if (!tensor.defined() || tensor.dim() != 1 ||
+      tensor.scalar_type() != at::kByte ||
+      tensor.numel() < (int64_t)sizeof(BlobHeader)) {
+    return false;
+  }
+  return std::memcmp(
+             tensor.contiguous().data_ptr<uint8_t>(), kMagic, sizeof(kMagic)) ==
+      0;
+}
+
+PackedWeight deserialize_weight(const at::Tensor& blob) {
+  TORCH_CHECK(
+      is_serialized_weight(blob), "Expected a serialized packed weight");
+  auto blob_ = blob;
+  // Sections are reinterpreted in place, which needs the blob to start at an
+  // aligned address. That is always the case for a freshly loaded storage.
+  if (!blob_.is_contiguous() ||
+      reinterpret_cast<uintptr_t>(blob_.data_ptr()) % kSectionAlignment != 0) {
+    blob_ = blob_.clone(at::MemoryFormat::Contiguous);
+  }
+  auto header = read_header(blob_);
+  auto kind = static_cast<PackedWeightKind>(header.kind);
+  auto dtype = static_cast<at::ScalarType>(header.dtype);
+
+  PackedWeight packed;
+  packed.kind = kind;
+  packed.dtype = dtype;
+  packed.groups = header.groups;
+  if (kind == PackedWeightKind::OneDNN) {
+    TORCH_CHECK(header.num_sections == 4, "Corrupted serialized packed weight");
+    packed.same_library = header.lib_version == onednn_version();
+    packed.host_compatible = packed.same_library && header.isa == onednn_isa();
+    if (packed.same_library) {
+      // The desc blob format is internal to oneDNN and only interpreted by the
+      // version which produced it
+      auto bytes = section_view(blob_, header, kPackedDesc);
+      auto bytes_ptr = bytes.data_ptr<uint8_t>();
+      std::vector<uint8_t> desc_blob(bytes_ptr, bytes_ptr + bytes.numel());
+      packed.packed_desc =
+          ideep::tensor::desc(dnnl::memory::desc(desc_blob), header.groups);
+    }
+    packed.layout = section_ints(blob_, header, kLayout);
+    auto public_meta = section_ints(blob_, header, kPublic);
+    int64_t public_ndims = public_meta[0];
+    packed.public_sizes = std::vector<int64_t>(
+        public_meta.begin() + 1, public_meta.begin() + 1 + public_ndims);
+    packed.public_strides = std::vector<int64_t>(
+        public_meta.begin() + 1 + public_ndims, public_meta.end());
+    packed.packed = section_view(blob_, header, kOneDNNData)
+                        .view(dtype)
+                        .view(packed_sizes_from_layout(packed.layout));
+  } else {
+    TORCH_CHECK(
+        kind == PackedWeightKind::MKL && header.num_sections == 3,
+        "Corrupted serialized packed weight");
+    packed.same_library = header.lib_version == mkl_version();
+    packed.host_compatible = packed.same_library && header.isa == mkl_isa();
+    packed.packed = section_view(blob_, header, kMKLData).view(dtype);
+    packed.plain = section_view(blob_, header, kPlainData)
+                       .view(dtype)
+                       .view(section_ints(blob_, header, kPlainSizes));
+  }
+  return packed;
+}
+
+at::Tensor empty_public_weight(const PackedWeight& packed) {
+  TORCH_INTERNAL_ASSERT(packed.kind == PackedWeightKind::OneDNN);
+  return at::empty_strided(
+      packed.public_sizes,
+      packed.public_strides,
+      at::TensorOptions().dtype(packed.dtype));
+}
+
+at::Tensor to_public(const PackedWeight& packed) {
+  TORCH_INTERNAL_ASSERT(packed.kind == PackedWeightKind::OneDNN);
+  const auto& layout = packed.layout;
+  int64_t ndims = layout[0];
+  int64_t nblks = layout[1];
+  const int64_t* dims = layout.data() + 2;
+  const int64_t* padded_dims = dims + ndims;
+  const int64_t* strides = padded_dims + ndims;
+  const int64_t* blks = strides + ndims;
+  const int64_t* idxs = blks + nblks;
+
+  // View the buffer as [outer dims..., inner blocks...]. Outer dims use the
+  // strides of the desc, inner blocks are dense and innermost.
+  auto sizes = packed_sizes_from_layout(layout);
+  std::vector<int64_t> view_strides(strides, strides + ndims);
+  view_strides.resize(ndims + nblks);
+  int64_t inner_stride = 1;
+  for (int64_t i = nblks - 1; i >= 0; i--) {
+    view_strides[ndims + i] = inner_stride;
+    inner_stride *= blks[i];
+  }
+  auto blocked = packed.packed.reshape({-1}).as_strided(sizes, view_strides);
+
+  // Move every inner block next to the outer dim it splits, the first block
+  // of a dim being the outermost one.
+  std::vector<int64_t> perm;
+  for (int64_t i = 0; i < ndims; i++) {
+    perm.push_back(i);
+    for (int64_t j = 0; j < nblks; j++) {
+      if (idxs[j] == i) {
+        perm.push_back(ndims + j);
+      }
+    }
+  }
+  auto unblocked = blocked.permute(perm).reshape(
+      std::vector<int64_t>(padded_dims, padded_dims + ndims));
+  for (int64_t i = 0; i < ndims; i++) {
+    unblocked = unblocked.narrow(i, 0, dims[i]);
+  }
+  // Grouped weights carry an extra leading group dim
+  auto result = empty_public_weight(packed);
+  result.copy_(unblocked.reshape(packed.public_sizes));
+  return result;
+}
+
+ideep::tensor packed_itensor(const PackedWeight& packed) {
+  TORCH_INTERNAL_ASSERT(
+      packed.kind == PackedWeightKind::OneDNN && packed.same_library);
+  return ideep::tensor(packed.packed_desc, packed.packed.data_ptr());
+}
+
+} // namespace serialization
+} // namespace detail
+} // namespace cpu
+} // namespace torch_ipex
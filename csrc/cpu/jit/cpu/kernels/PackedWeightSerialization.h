@@ -0,0 +1,86 @@
+#pragma once
+
+#include <ATen/Tensor.h>
+
+#include <ideep.hpp>
+
+namespace torch_ipex {
+namespace cpu {
+namespace detail {
+namespace serialization {
+
+// Prepacked weights are serialized as a 1-D uint8 tensor ("blob") that keeps
+// the blocked layout produced at prepack time, so that loading a frozen model
+// does not need to reorder every weight again. The blob layout is
+//
+//   | header | section 0 | section 1 | ... |
+//
+// where every section starts at a 64 bytes aligned offset, so the packed data
+// can be used in place from the loaded storage. The header records the target
+// ISA and the version of the library which produced the packed layout.
+//
+// The blob is stored in the weight slot of the existing pickle tuples of the
+// op contexts. A plain weight is never a 1-D uint8 tensor, so models saved in
+// the legacy format are still loadable.
+
+enum class PackedWeightKind : int32_t {
+  OneDNN = 0,
+  MKL = 1,
+};
+
+struct PackedWeight {
+  PackedWeightKind kind;
+  at::ScalarType dtype;
+  int64_t groups;
+  // The blob was produced by the same version of oneDNN/MKL, so the packed
+  // layout description can be interpreted by this build.
+  bool same_library;
+  // Additionally the target ISA matches, i.e. the packed layout is likely the
+  // one this host would produce.
+  bool host_compatible;
+  // oneDNN only, valid if same_library
+  ideep::tensor::desc packed_desc;
+  // Views of the blob storage, no copy is made when deserializing.
+  // oneDNN: the packed weight. MKL: the sgemm packed buffer.
+  at::Tensor packed;
+  // MKL only, plain [out_features, in_features] weight
+  at::Tensor plain;
+  // oneDNN only, library independent description of the blocked layout and
+  // sizes/strides of the public weight, used to unpack on version mismatch
+  std::vector<int64_t> layout;
+  std::vector<int64_t> public_sizes;
+  std::vector<int64_t> public_strides;
+};
+
+at::Tensor serialize_onednn_weight(
+    const ideep::tensor::desc& packed_desc,
+    const at::Tensor& at_packed_weight,
+    int64_t groups,
+    at::IntArrayRef public_sizes,
+    at::IntArrayRef public_strides);
+
+at::Tensor serialize_mkl_weight(
+    const at::Tensor& mkl_weight,
+    const at::Tensor& ori_weight);
+
+bool is_serialized_weight(const at::Tensor& tensor);
+
+PackedWeight deserialize_weight(const at::Tensor& blob);
+
+// Create an uninitialized tensor with the public sizes/strides of a
+// deserialized oneDNN weight. It only carries the meta information needed by
+// the prepack routines, its pages are never touched when the packed layout is
+// adopted.
+at::Tensor empty_public_weight(const PackedWeight& packed);
+
+// Unpack a deserialized oneDNN weight to its public layout without relying on
+// oneDNN, used when the blob was produced by a different oneDNN version.
+at::Tensor to_public(const PackedWeight& packed);
+
+// Get the packed weight as an ideep tensor sharing the blob storage.
+ideep::tensor packed_itensor(const PackedWeight& packed);
+
+} // namespace serialization
+} // namespace detail
+} // namespace cpu
+} // namespace torch_ipex
@@ -0,0 +1,239 @@
+#include "PostOpChain.h"
+
+#include <ATen/ATen.h>
+
+#include "ideep/IDeepConversions.h"
+
+namespace torch_ipex {
+namespace cpu {
+namespace detail {
+
+bool is_binary_post_op(int64_t kind) {
+  return kind >= kPostOpBinaryAdd && kind <= kPostOpBinaryMin;
+}
+
+int64_t check_post_op_chain(
+    c10::ArrayRef<int64_t> post_op_kinds,
+    c10::ArrayRef<double> post_op_params) {
+  TORCH_CHECK(
+      post_op_params.size() == post_op_kinds.size() * kPostOpParamsNum,
+      "post-op chain: expected ",
+      kPostOpParamsNum,
+      " params per post-op, got ",
+      post_op_params.size(),
+      " params for ",
+      post_op_kinds.size(),
+      " post-ops");
+  int64_t num_srcs = 0;
+  for (size_t i = 0; i < post_op_kinds.size(); i++) {
+    auto kind = post_op_kinds[i];
+    TORCH_CHECK(
+        kind >= 0 && kind < kPostOpKindNum,
+        "post-op chain: unknown post-op kind ",
+        kind);
+    TORCH_CHECK(
+        kind != kPostOpSum || i == 0,
+        "post-op chain: the sum post-op should be the first one");
+    if (is_binary_post_op(kind) || kind == kPostOpSum) {
+      num_srcs++;
+    }
+  }
+  return num_srcs;
+}
+
+static dnnl::algorithm eltwise_algorithm(int64_t kind) {
+  switch (kind) {
+    case kPostOpRelu:
+      return dnnl::algorithm::eltwise_relu;
+    case kPostOpGeluErf:
+      return dnnl::algorithm::eltwise_gelu_erf;
+    case kPostOpGeluTanh:
+      return dnnl::algorithm::eltwise_gelu_tanh;
+    case kPostOpClip:
+      return dnnl::algorithm::eltwise_clip;
+    case kPostOpElu:
+      return dnnl::algorithm::eltwise_elu;
+    case kPostOpSwish:
+      return dnnl::algorithm::eltwise_swish;
+    case kPostOpSigmoid:
+      return dnnl::algorithm::eltwise_logistic;
+    case kPostOpTanh:
+      return dnnl::algorithm::eltwise_tanh;
+    case kPostOpAbs:
+      return dnnl::algorithm::eltwise_abs;
+    case kPostOpExp:
+      return dnnl::algorithm::eltwise_exp;
+    case kPostOpLog:
+      return dnnl::algorithm::eltwise_log;
+    case kPostOpSqrt:
+      return dnnl::algorithm::eltwise_sqrt;
+    case kPostOpSquare:
+      return dnnl::algorithm::eltwise_square;
+    case kPostOpRound:
+      return dnnl::algorithm::eltwise_round;
+    case kPostOpHardswish:
+      return dnnl::algorithm::eltwise_hardswish;
+    case kPostOpHardsigmoid:
+      return dnnl::algorithm::eltwise_hardsigmoid;
+    case kPostOpMish:
+      return dnnl::algorithm::eltwise_mish;
+    case kPostOpPow:
+      return dnnl::algorithm::eltwise_pow;
+    case kPostOpLinear:
+      return dnnl::algorithm::eltwise_linear;
+    default:
+      TORCH_CHECK(false, "post-op chain: ", kind, " is not an eltwise post-op");
+  }
+}
+
+static dnnl::algorithm binary_algorithm(int64_t kind) {
+  switch (kind) {
+    case kPostOpBinaryAdd:
+      return dnnl::algorithm::binary_add;
+    case kPostOpBinarySub:
+      return dnnl::algorithm::binary_sub;
+    case kPostOpBinaryMul:
+      return dnnl::algorithm::binary_mul;
+    case kPostOpBinaryDiv:
+      return dnnl::algorithm::binary_div;
+    case kPostOpBinaryMax:
+      return dnnl::algorithm::binary_max;
+    case kPostOpBinaryMin:
+      return dnnl::algorithm::binary_min;
+    default:
+      TORCH_CHECK(false, "post-op chain: ", kind, " is not a binary post-op");
+  }
+}
+
+ideep::attr_t make_post_op_chain_attr(
+    c10::ArrayRef<int64_t> post_op_kinds,
+    c10::ArrayRef<double> post_op_params,
+    const std::vector<ideep::tensor::desc>& binary_descs) {
+  ideep::attr_t attr;
+  ideep::post_ops po;
+  size_t binary_idx = 0;
+  for (size_t i = 0; i < post_op_kinds.size(); i++) {
+    auto kind = post_op_kinds[i];
+    auto alpha = static_cast<float>(post_op_params[i * kPostOpParamsNum]);
+    auto beta = static_cast<float>(post_op_params[i * kPostOpParamsNum + 1]);
+    if (kind == kPostOpSum) {
+      po.append_sum(alpha);
+    } else if (is_binary_post_op(kind)) {
+      TORCH_CHECK(
+          binary_idx < binary_descs.size(),
+          "post-op chain: missing the source of binary post-op ",
+          i);
+      po.append_binary(binary_algorithm(kind), binary_descs[binary_idx++]);
+    } else {
+      po.append_eltwise(eltwise_algorithm(kind), alpha, beta);
+    }
+  }
+  attr.set_post_ops(po);
+  return attr.set_fpmath_mode(torch_ipex::fpmath_mode);
+}
+
+at::Tensor apply_post_op_chain(
+    at::Tensor output,
+    c10::ArrayRef<at::Tensor> post_op_srcs,
+    c10::ArrayRef<int64_t> post_op_kinds,
+    c10::ArrayRef<double> post_op_params) {
+  auto x = output;
+  size_t src_idx = 0;
+  auto next_src = [&]() {
+    TORCH_CHECK(
+        src_idx < post_op_srcs.size(), "post-op chain: missing post-op source");
+    return post_op_srcs[src_idx++].to(x.scalar_type());
+  };
+  for (size_t i = 0; i < post_op_kinds.size(); i++) {
+    auto alpha = post_op_params[i * kPostOpParamsNum];
+    auto beta = post_op_params[i * kPostOpParamsNum + 1];
+    switch (post_op_kinds[i]) {
+      case kPostOpRelu:
+        x = alpha == 0 ? at::relu(x) : at::leaky_relu(x, alpha);
+        break;
+      case kPostOpGeluErf:
+        x = at::gelu(x);
+        break;
+      case kPostOpGeluTanh:
+        x = at::gelu(x, "tanh");
+        break;
+      case kPostOpClip:
+        x = at::clamp(x, alpha, beta);
+        break;
+      case kPostOpElu:
+        x = at::elu(x, alpha);
+        break;
+      case kPostOpSwish:
+        x = at::silu(x);
+        break;
+      case kPostOpSigmoid:
+        x = at::sigmoid(x);
+        break;
+      case kPostOpTanh:
+        x = at::tanh(x);
+        break;
+      case kPostOpAbs:
+        x = at::abs(x);
+        break;
+      case kPostOpExp:
+        x = at::exp(x);
+        break;
+      case kPostOpLog:
+        x = at::log(x);
+        break;
+      case kPostOpSqrt:
+        x = at::sqrt(x);
+        break;
+      case kPostOpSquare:
+        x = at::square(x);
+        break;
+      case kPostOpRound:
+        x = at::round(x);
+        break;
+      case kPostOpHardswish:
+        x = at::hardswish(x);
+        break;
+      case kPostOpHardsigmoid:
+        x = at::hardsigmoid(x);
+        break;
+      case kPostOpMish:
+        x = at::mish(x);
+        break;
+      case kPostOpPow:
+        x = at::mul(at::pow(x, beta), alpha);
+        break;
+      case kPostOpLinear:
+        x = at::add(at::mul(x, alpha), beta);
+        break;
+      case kPostOpBinaryAdd:
+        x = at::add(x, next_src());
+        break;
+      case kPostOpBinarySub:
+        x = at::sub(x, next_src());
+        break;
+      case kPostOpBinaryMul:
+        x = at::mul(x, next_src());
+        break;
+      case kPostOpBinaryDiv:
+        x = at::div(x, next_src());
+        break;
+      case kPostOpBinaryMax:
+        x = at::maximum(x, next_src());
+        break;
+      case kPostOpBinaryMin:
+        x = at::minimum(x, next_src());
+        break;
+      case kPostOpSum:
+        x = at::add(x, next_src(), alpha);
+        break;
+      default:
+        TORCH_CHECK(
+            false, "post-op chain: unknown post-op kind ", post_op_kinds[i]);
+    }
+  }
+  return x;
+}
+
+} // namespace detail
+} // namespace cpu
+} // namespace torch_ipex
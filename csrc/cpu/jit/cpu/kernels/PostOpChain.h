@@ -0,0 +1,76 @@
+#pragma once
+
+#include <ATen/Tensor.h>
+
+#include <ideep.hpp>
+
+#include <vector>
+
+namespace torch_ipex {
+namespace cpu {
+namespace detail {
+
+// A chain of post-ops fused into the epilogue of a conv/linear, applied in
+// order on its output. Every post-op takes kPostOpParamsNum float params
+// (alpha, beta) in post_op_params, and a binary post-op reads the next tensor
+// of the post-op sources as its second operand.
+enum PostOpKind : int64_t {
+  kPostOpRelu = 0, // alpha: negative slope
+  kPostOpGeluErf,
+  kPostOpGeluTanh,
+  kPostOpClip, // alpha: lower bound, beta: upper bound
+  kPostOpElu, // alpha
+  kPostOpSwish,
+  kPostOpSigmoid,
+  kPostOpTanh,
+  kPostOpAbs,
+  kPostOpExp,
+  kPostOpLog,
+  kPostOpSqrt,
+  kPostOpSquare,
+  kPostOpRound,
+  kPostOpHardswish,
+  kPostOpHardsigmoid,
+  kPostOpMish,
+  kPostOpPow, // beta: exponent
+  kPostOpLinear, // alpha * x + beta
+  kPostOpBinaryAdd,
+  kPostOpBinarySub,
+  kPostOpBinaryMul,
+  kPostOpBinaryDiv,
+  kPostOpBinaryMax,
+  kPostOpBinaryMin,
+  // x + alpha * src, accumulated in place on the output which holds src
+  // beforehand. Only valid as the first post-op of a conv chain.
+  kPostOpSum,
+  kPostOpKindNum,
+};
+
+constexpr int64_t kPostOpParamsNum = 2;
+
+bool is_binary_post_op(int64_t kind);
+
+// Checks the chain is well-formed and returns the number of post-op sources
+// it reads, i.e. its binary post-ops plus the sum.
+int64_t check_post_op_chain(
+    c10::ArrayRef<int64_t> post_op_kinds,
+    c10::ArrayRef<double> post_op_params);
+
+// The oneDNN attr of the chain, binary_descs holds the descs of the binary
+// post-op sources in chain order (the sum source excluded).
+ideep::attr_t make_post_op_chain_attr(
+    c10::ArrayRef<int64_t> post_op_kinds,
+    c10::ArrayRef<double> post_op_params,
+    const std::vector<ideep::tensor::desc>& binary_descs = {});
+
+// Applies the chain with ATen ops on a conv/linear output computed without
+// it, for the post-op sources oneDNN cannot broadcast.
+at::Tensor apply_post_op_chain(
+    at::Tensor output,
+    c10::ArrayRef<at::Tensor> post_op_srcs,
+    c10::ArrayRef<int64_t> post_op_kinds,
+    c10::ArrayRef<double> post_op_params);
+
+} // namespace detail
+} // namespace cpu
+} // namespace torch_ipex
@@ -12,8 +12,11 @@ namespace torch_ipex {
 namespace cpu {
 using detail::conv_transpose::createConvTransposePrePackOpContext;
 using detail::convolution::createConvolutionPrePackOpContext;
+using detail::convolution::loadConvolutionPrePackOpContext;
 using detail::linear::createLinearPrePackOpContext;
+using detail::linear::loadLinearPrePackOpContext;
 using detail::mkl_sgemm::createLinearMKLPrePackOpContext;
+using detail::mkl_sgemm::loadLinearMKLPrePackOpContext;
 #ifdef USE_LIBXSMM
 using detail::woq_linear::createWoqLinearPrePackOpContext;
 using detail::woq_linear::createWoqLinearPrePackOpContextInt4;
@@ -24,19 +27,11 @@ TORCH_LIBRARY(ipex_prepack, m) {
       .def_pickle(
           [](const c10::intrusive_ptr<ConvolutionOpContext>& op_context)
               -> SerializationTypeConvolutionPrePack { // __getstate__
-            return op_context->unpack();
+            return op_context->serialize();
           },
           [](SerializationTypeConvolutionPrePack state)
               -> c10::intrusive_ptr<ConvolutionOpContext> { // __setstate__
-            return createConvolutionPrePackOpContext(
-                std::move(std::get<0>(state)),
-                std::move(std::get<1>(state)),
-                std::move(std::get<2>(state)),
-                std::move(std::get<3>(state)),
-                std::move(std::get<4>(state)),
-                std::move(std::get<5>(state)),
-                std::move(std::get<6>(state)),
-                std::move(std::get<7>(state)));
+            return loadConvolutionPrePackOpContext(std::move(state));
           })
       .def(
           "get_weight",
@@ -54,14 +49,11 @@ TORCH_LIBRARY(ipex_prepack, m) {
       .def_pickle(
           [](const c10::intrusive_ptr<LinearOpContext>& op_context)
               -> SerializationTypeLinearPrePack { // __getstate__
-            return op_context->unpack();
+            return op_context->serialize();
           },
           [](SerializationTypeLinearPrePack state)
               -> c10::intrusive_ptr<LinearOpContext> { // __setstate__
-            return createLinearPrePackOpContext(
-                std::move(std::get<0>(state)),
-                std::move(std::get<1>(state)),
-                std::move(std::get<2>(state)));
+            return loadLinearPrePackOpContext(std::move(state));
           })
       .def(
           "get_weight", &torch_ipex::cpu::LinearOpContext::get_at_packed_weight)
@@ -75,20 +67,18 @@ TORCH_LIBRARY(ipex_prepack, m) {
       .def_pickle(
           [](const c10::intrusive_ptr<MKLOpContext>& op_context)
               -> SerializationTypeMKLPrePack { // __getstate__
-            return op_context->unpack();
+            return op_context->serialize();
           },
           [](SerializationTypeMKLPrePack state)
               -> c10::intrusive_ptr<MKLOpContext> { // __setstate__
-            return createLinearMKLPrePackOpContext(
-                std::move(std::get<0>(state)),
-                std::move(std::get<1>(state)),
-                std::move(std::get<2>(state)));
+            return loadLinearMKLPrePackOpContext(std::move(state));
           })
       .def("get_weight", &torch_ipex::cpu::MKLOpContext::get_at_packed_weight)
       .def("get_bias", &torch_ipex::cpu::MKLOpContext::get_at_bias)
       .def("pack", &torch_ipex::cpu::MKLOpContext::pack)
       .def("to_public", &torch_ipex::cpu::MKLOpContext::to_public)
       .def("get_data_handle", &torch_ipex::cpu::MKLOpContext::get_data_handle)
+      .def("set_num_threads", &torch_ipex::cpu::MKLOpContext::set_num_threads)
       .def("load_from_ctx", &torch_ipex::cpu::MKLOpContext::load_from_ctx);
   m.class_<ConvTransposeOpContext>("ConvTransposeOpContext")
       .def_pickle(
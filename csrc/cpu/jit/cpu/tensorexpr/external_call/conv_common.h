@@ -96,6 +96,8 @@ typedef enum _ConvFusedOp {
   kConvSilu,
   kConvAdd,
   kConvHardsigmoid,
+  kConvPostOps,
+  kConvSumPostOps,
 } ConvFusedOp;
 
 static ideep::attr_t empty_attr;
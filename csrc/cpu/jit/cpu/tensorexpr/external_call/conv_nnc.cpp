@@ -13,6 +13,7 @@
 #include "conv_log.h"
 #include "conv_mish.h"
 #include "conv_non.h"
+#include "conv_post_ops.h"
 #include "conv_pow.h"
 #include "conv_relu.h"
 #include "conv_round.h"
@@ -49,6 +50,8 @@ using LeakyReluTrait = LoweringFuncTrait<ConvFusedOp::kConvLeakyRelu>;
 using SiluTrait = LoweringFuncTrait<ConvFusedOp::kConvSilu>;
 using AddTrait = LoweringFuncTrait<ConvFusedOp::kConvAdd>;
 using HardsigmoidTrait = LoweringFuncTrait<ConvFusedOp::kConvHardsigmoid>;
+using PostOpsTrait = LoweringFuncTrait<ConvFusedOp::kConvPostOps>;
+using SumPostOpsTrait = LoweringFuncTrait<ConvFusedOp::kConvSumPostOps>;
 
 #define REG_NNC_OPERATOR(schema, trait)     \
   static NNCOperatorRegister schema##trait( \
@@ -75,4 +78,14 @@ REG_NNC_OPERATOR(kConvLeakyReluSchema, LeakyReluTrait);
 REG_NNC_OPERATOR(kConvSiluSchema, SiluTrait);
 REG_NNC_OPERATOR(kConvAddSchema, AddTrait);
 REG_NNC_OPERATOR(kConvHardsigmoidSchema, HardsigmoidTrait);
+
+#define REG_NNC_POST_OPS_OPERATOR(schema, trait) \
+  static NNCOperatorRegister schema##trait(      \
+      schema,                                    \
+      trait::get_external_func(),                \
+      computeConv<trait>,                        \
+      nncConvPostOps<trait>)
+
+REG_NNC_POST_OPS_OPERATOR(kConvPostOpsSchema, PostOpsTrait);
+REG_NNC_POST_OPS_OPERATOR(kConvSumPostOpsSchema, SumPostOpsTrait);
 } // namespace
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <ideep.hpp>
+#include <ideep/utils.hpp>
+
+#include "conv_common.h"
+#include "csrc/cpu/aten/Conv.h"
+#include "csrc/cpu/jit/cpu/kernels/ConvPacked.h"
+#include "csrc/cpu/jit/cpu/kernels/PostOpChain.h"
+#include "csrc/cpu/jit/cpu/tensorexpr/utils.h"
+
+namespace torch_ipex {
+namespace jit {
+namespace cpu {
+namespace tensorexpr {
+
+/**
+ * @brief The common operations of the conv fused with a post-op chain, see
+ * PostOpChain.h. NUM_SRCS is 1 if the chain starts with a sum post-op.
+ *
+ * The chain is passed to the external function as extra args, a (kind, alpha,
+ * beta) triple of doubles per post-op.
+ */
+template <int NUM_SRCS>
+struct ConvPostOpsOperations : public ConvCommonOperations {
+  static constexpr int kNumSrcs = NUM_SRCS;
+
+  static std::vector<pytnnc::BufHandle> get_input_buf(
+      const std::vector<pytnnc::ArgValue>& inputs) {
+    std::vector<pytnnc::BufHandle> res = {};
+    TORCH_INTERNAL_ASSERT_DEBUG_ONLY(inputs.size() == NUM_SRCS + 4);
+    // The order is:
+    //     0: activator tensor
+    //     1 ~ NUM_SRCS: accumu tensor of the sum post-op if any
+    //     NUM_SRCS + 1: post_op_kinds
+    //     NUM_SRCS + 2: post_op_params
+    //     NUM_SRCS + 3: conv op context
+    for (int i = 0; i <= NUM_SRCS; i++) {
+      res.push_back(std::get<pytnnc::BufHandle>(inputs[i]));
+    }
+    res.push_back(std::get<pytnnc::BufHandle>(inputs[NUM_SRCS + 3]));
+    return res;
+  }
+
+  static std::vector<pytnnc::ExprHandle> get_extra_args(
+      const std::vector<pytnnc::ArgValue>& inputs) {
+    const auto& kinds = std::get<pytnnc::IntList>(inputs[NUM_SRCS + 1]);
+    const auto& params = std::get<pytnnc::DoubleList>(inputs[NUM_SRCS + 2]);
+    torch_ipex::cpu::detail::check_post_op_chain(kinds, params);
+    std::vector<pytnnc::ExprHandle> extra_args;
+    for (size_t i = 0; i < kinds.size(); i++) {
+      extra_args.push_back(static_cast<double>(kinds[i]));
+      for (int j = 0; j < torch_ipex::cpu::detail::kPostOpParamsNum; j++) {
+        extra_args.push_back(
+            params[i * torch_ipex::cpu::detail::kPostOpParamsNum + j]);
+      }
+    }
+    return extra_args;
+  }
+
+  static void get_post_op_chain(
+      int64_t args_num,
+      int64_t* extra_args,
+      std::vector<int64_t>& post_op_kinds,
+      std::vector<double>& post_op_params) {
+    constexpr int64_t step = torch_ipex::cpu::detail::kPostOpParamsNum + 1;
+    auto args = reinterpret_cast<double*>(extra_args);
+    for (int64_t i = 0; i + step <= args_num; i += step) {
+      post_op_kinds.push_back(static_cast<int64_t>(args[i]));
+      post_op_params.insert(
+          post_op_params.end(), args + i + 1, args + i + step);
+    }
+  }
+
+  static torch_ipex::cpu::ConvolutionOpContext* get_conv_op_context(
+      void** buf_data) {
+    // The order is:
+    //     0: output tensor
+    //     1: activator tensor
+    //     2 ~ NUM_SRCS + 1: accumu tensor of the sum post-op if any
+    //     NUM_SRCS + 2: conv op context
+    return reinterpret_cast<torch_ipex::cpu::ConvolutionOpContext*>(
+        buf_data[NUM_SRCS + 2]);
+  }
+};
+
+template <>
+struct LoweringFuncTrait<ConvFusedOp::kConvPostOps>
+    : public ConvPostOpsOperations<0> {
+  DECLARE_CONV_FUNC_AND_RES(post_ops)
+
+  /**
+   * @note This operator fuses conv and a chain of eltwise post-ops.
+   *
+   * Its schema is  "ipex_prepack::convolution_post_ops_run(
+   *  Tensor input,
+   *  int[] post_op_kinds,
+   *  float[] post_op_params,
+   *  __torch__.torch.classes.ipex_prepack.ConvolutionOpContext W_prepack) ->
+   * Tensor"
+   *
+   */
+};
+
+template <>
+struct LoweringFuncTrait<ConvFusedOp::kConvSumPostOps>
+    : public ConvPostOpsOperations<1> {
+  DECLARE_CONV_FUNC_AND_RES(sum_post_ops)
+
+  /**
+   * @note This operator fuses conv and a chain of post-ops starting with the
+   * sum of accumu. Unlike convolution_add_run, accumu is not written.
+   *
+   * Its schema is  "ipex_prepack::convolution_sum_post_ops_run(
+   *  Tensor input,
+   *  Tensor accumu,
+   *  int[] post_op_kinds,
+   *  float[] post_op_params,
+   *  __torch__.torch.classes.ipex_prepack.ConvolutionOpContext W_prepack) ->
+   * Tensor"
+   *
+   */
+};
+
+template <typename LoweringFunc>
+void nncConvPostOps(
+    int64_t bufs_num,
+    void** buf_data,
+    int64_t* buf_ranks,
+    int64_t* buf_dims,
+    int64_t* buf_strides,
+    int8_t* buf_dtypes,
+    int64_t args_num,
+    int64_t* extra_args) {
+  constexpr int output_buf_idx = 0;
+  constexpr int input_buf_idx = 1;
+  constexpr int accumu_buf_idx = 2;
+
+  auto op_context = LoweringFunc::get_conv_op_context(buf_data);
+  const auto& context = op_context->get_context();
+  std::vector<at::Tensor> tensors = constructTensors(
+      bufs_num - 1, buf_data, buf_ranks, buf_dims, buf_strides, buf_dtypes);
+  std::vector<int64_t> post_op_kinds;
+  std::vector<double> post_op_params;
+  LoweringFunc::get_post_op_chain(
+      args_num, extra_args, post_op_kinds, post_op_params);
+
+  auto suggested_mem_format = context.weight_is_channels_last_
+      ? ((buf_ranks[input_buf_idx] == 4) ? c10::MemoryFormat::ChannelsLast
+                                         : c10::MemoryFormat::ChannelsLast3d)
+      : c10::MemoryFormat::Contiguous;
+  at::Tensor activation =
+      at::native::contiguous(tensors[input_buf_idx], suggested_mem_format);
+  at::Tensor output =
+      at::native::contiguous(tensors[output_buf_idx], suggested_mem_format);
+  if (LoweringFunc::kNumSrcs == 1) {
+    const auto& accumu = tensors[accumu_buf_idx];
+    auto conv_output_size = torch_ipex::cpu::calc_conv_output_size(
+        activation.sizes(),
+        context.weight_packed_.get_dims(),
+        context.padding_,
+        context.stride_,
+        context.dilation_);
+    if (accumu.sizes() != conv_output_size ||
+        output.sizes() != conv_output_size) {
+      // accumu has to be broadcast, the sum can not be done in place
+      tensors[output_buf_idx].copy_(
+          torch_ipex::cpu::detail::convolution::run_post_op_chain(
+              context, activation, accumu, post_op_kinds, post_op_params));
+      return;
+    }
+    output.copy_(accumu);
+  }
+  torch_ipex::cpu::detail::convolution::run_core_fallback(
+      context,
+      activation,
+      output,
+      torch_ipex::cpu::detail::make_post_op_chain_attr(
+          post_op_kinds, post_op_params));
+  if (output.data_ptr() != tensors[output_buf_idx].data_ptr()) {
+    tensors[output_buf_idx].copy_(output);
+  }
+}
+
+} // namespace tensorexpr
+} // namespace cpu
+} // namespace jit
+} // namespace torch_ipex
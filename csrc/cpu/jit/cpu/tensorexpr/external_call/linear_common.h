@@ -56,6 +56,9 @@ typedef enum _LinearFusedOp {
   kLinearAdd,
   kLinearHardsigmoid,
   kLinearAddRelu,
+  kLinearPostOps,
+  kLinearBinaryPostOps,
+  kLinearBinary2PostOps,
 } LinearFusedOp;
 
 static ideep::attr_t empty_attr;
@@ -13,6 +13,7 @@
 #include "linear_log.h"
 #include "linear_mish.h"
 #include "linear_non.h"
+#include "linear_post_ops.h"
 #include "linear_pow.h"
 #include "linear_relu.h"
 #include "linear_round.h"
@@ -49,6 +50,11 @@ using LeakyReluTrait = LoweringFuncTrait<LinearFusedOp::kLinearLeakyRelu>;
 using AddTrait = LoweringFuncTrait<LinearFusedOp::kLinearAdd>;
 using HardsigmoidTrait = LoweringFuncTrait<LinearFusedOp::kLinearHardsigmoid>;
 using AddReluTrait = LoweringFuncTrait<LinearFusedOp::kLinearAddRelu>;
+using PostOpsTrait = LoweringFuncTrait<LinearFusedOp::kLinearPostOps>;
+using BinaryPostOpsTrait =
+    LoweringFuncTrait<LinearFusedOp::kLinearBinaryPostOps>;
+using Binary2PostOpsTrait =
+    LoweringFuncTrait<LinearFusedOp::kLinearBinary2PostOps>;
 
 #define REG_NNC_OPERATOR(schema, trait)     \
   static NNCOperatorRegister schema##trait( \
@@ -78,4 +84,15 @@ REG_NNC_OPERATOR(kLinearLeakyReluSchema, LeakyReluTrait);
 REG_NNC_OPERATOR(kLinearAddSchema, AddTrait);
 REG_NNC_OPERATOR(kLinearHardsigmoidSchema, HardsigmoidTrait);
 REG_NNC_OPERATOR(kLinearAddReluSchema, AddReluTrait);
+
+#define REG_NNC_POST_OPS_OPERATOR(schema, trait) \
+  static NNCOperatorRegister schema##trait(      \
+      schema,                                    \
+      trait::get_external_func(),                \
+      computeLinear<trait>,                      \
+      nncLinearPostOps<trait>)
+
+REG_NNC_POST_OPS_OPERATOR(kLinearPostOpsSchema, PostOpsTrait);
+REG_NNC_POST_OPS_OPERATOR(kLinearBinaryPostOpsSchema, BinaryPostOpsTrait);
+REG_NNC_POST_OPS_OPERATOR(kLinearBinary2PostOpsSchema, Binary2PostOpsTrait);
 } // namespace
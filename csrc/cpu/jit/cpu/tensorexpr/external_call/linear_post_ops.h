@@ -0,0 +1,179 @@
+#pragma once
+
+#include <ideep.hpp>
+#include <ideep/utils.hpp>
+
+#include "csrc/cpu/jit/cpu/kernels/LinearPacked.h"
+#include "csrc/cpu/jit/cpu/kernels/PostOpChain.h"
+#include "csrc/cpu/jit/cpu/tensorexpr/utils.h"
+#include "linear_common.h"
+
+namespace torch_ipex {
+namespace jit {
+namespace cpu {
+namespace tensorexpr {
+
+/**
+ * @brief The common operations of the linear fused with a post-op chain, see
+ * PostOpChain.h. NUM_SRCS is the number of binary post-op sources.
+ *
+ * The chain is passed to the external function as extra args, a (kind, alpha,
+ * beta) triple of doubles per post-op.
+ */
+template <int NUM_SRCS>
+struct LinearPostOpsOperations : public LinearCommonOperations {
+  static constexpr int kNumSrcs = NUM_SRCS;
+
+  static std::vector<pytnnc::BufHandle> get_input_buf(
+      const std::vector<pytnnc::ArgValue>& inputs) {
+    std::vector<pytnnc::BufHandle> res = {};
+    TORCH_INTERNAL_ASSERT_DEBUG_ONLY(inputs.size() == NUM_SRCS + 4);
+    // The order is:
+    //     0: activator tensor
+    //     1 ~ NUM_SRCS: binary post-op sources
+    //     NUM_SRCS + 1: post_op_kinds
+    //     NUM_SRCS + 2: post_op_params
+    //     NUM_SRCS + 3: linear op context
+    for (int i = 0; i <= NUM_SRCS; i++) {
+      res.push_back(std::get<pytnnc::BufHandle>(inputs[i]));
+    }
+    res.push_back(std::get<pytnnc::BufHandle>(inputs[NUM_SRCS + 3]));
+    return res;
+  }
+
+  static std::vector<pytnnc::ExprHandle> get_extra_args(
+      const std::vector<pytnnc::ArgValue>& inputs) {
+    const auto& kinds = std::get<pytnnc::IntList>(inputs[NUM_SRCS + 1]);
+    const auto& params = std::get<pytnnc::DoubleList>(inputs[NUM_SRCS + 2]);
+    torch_ipex::cpu::detail::check_post_op_chain(kinds, params);
+    std::vector<pytnnc::ExprHandle> extra_args;
+    for (size_t i = 0; i < kinds.size(); i++) {
+      extra_args.push_back(static_cast<double>(kinds[i]));
+      for (int j = 0; j < torch_ipex::cpu::detail::kPostOpParamsNum; j++) {
+        extra_args.push_back(
+            params[i * torch_ipex::cpu::detail::kPostOpParamsNum + j]);
+      }
+    }
+    return extra_args;
+  }
+
+  static void get_post_op_chain(
+      int64_t args_num,
+      int64_t* extra_args,
+      std::vector<int64_t>& post_op_kinds,
+      std::vector<double>& post_op_params) {
+    constexpr int64_t step = torch_ipex::cpu::detail::kPostOpParamsNum + 1;
+    auto args = reinterpret_cast<double*>(extra_args);
+    for (int64_t i = 0; i + step <= args_num; i += step) {
+      post_op_kinds.push_back(static_cast<int64_t>(args[i]));
+      post_op_params.insert(
+          post_op_params.end(), args + i + 1, args + i + step);
+    }
+  }
+
+  static torch_ipex::cpu::LinearOpContext* get_linear_op_context(
+      void** buf_data) {
+    // The order is:
+    //     0: output tensor
+    //     1: activator tensor
+    //     2 ~ NUM_SRCS + 1: binary post-op sources
+    //     NUM_SRCS + 2: linear op context
+    return reinterpret_cast<torch_ipex::cpu::LinearOpContext*>(
+        buf_data[NUM_SRCS + 2]);
+  }
+};
+
+template <>
+struct LoweringFuncTrait<LinearFusedOp::kLinearPostOps>
+    : public LinearPostOpsOperations<0> {
+  DECLARE_LINEAR_FUNC_AND_RES(post_ops)
+
+  /**
+   * @note This operator fuses linear and a chain of eltwise post-ops.
+   *
+   * Its schema is  "ipex_prepack::linear_post_ops_run(
+   *  Tensor input,
+   *  int[] post_op_kinds,
+   *  float[] post_op_params,
+   *  __torch__.torch.classes.ipex_prepack.LinearOpContext W_prepack) ->
+   * Tensor"
+   *
+   */
+};
+
+template <>
+struct LoweringFuncTrait<LinearFusedOp::kLinearBinaryPostOps>
+    : public LinearPostOpsOperations<1> {
+  DECLARE_LINEAR_FUNC_AND_RES(binary_post_ops)
+
+  /**
+   * @note This operator fuses linear and a chain of post-ops with one binary
+   * post-op.
+   *
+   * Its schema is  "ipex_prepack::linear_binary_post_ops_run(
+   *  Tensor input,
+   *  Tensor other,
+   *  int[] post_op_kinds,
+   *  float[] post_op_params,
+   *  __torch__.torch.classes.ipex_prepack.LinearOpContext W_prepack) ->
+   * Tensor"
+   *
+   */
+};
+
+template <>
+struct LoweringFuncTrait<LinearFusedOp::kLinearBinary2PostOps>
+    : public LinearPostOpsOperations<2> {
+  DECLARE_LINEAR_FUNC_AND_RES(binary2_post_ops)
+
+  /**
+   * @note This operator fuses linear and a chain of post-ops with two binary
+   * post-ops.
+   *
+   * Its schema is  "ipex_prepack::linear_binary2_post_ops_run(
+   *  Tensor input,
+   *  Tensor other,
+   *  Tensor other2,
+   *  int[] post_op_kinds,
+   *  float[] post_op_params,
+   *  __torch__.torch.classes.ipex_prepack.LinearOpContext W_prepack) ->
+   * Tensor"
+   *
+   */
+};
+
+template <typename LoweringFunc>
+void nncLinearPostOps(
+    int64_t bufs_num,
+    void** buf_data,
+    int64_t* buf_ranks,
+    int64_t* buf_dims,
+    int64_t* buf_strides,
+    int8_t* buf_dtypes,
+    int64_t args_num,
+    int64_t* extra_args) {
+  constexpr int output_buf_idx = 0;
+  constexpr int input_buf_idx = 1;
+  constexpr int src_buf_idx = 2;
+
+  auto op_context = LoweringFunc::get_linear_op_context(buf_data);
+  std::vector<at::Tensor> tensors = constructTensors(
+      bufs_num - 1, buf_data, buf_ranks, buf_dims, buf_strides, buf_dtypes);
+  std::vector<int64_t> post_op_kinds;
+  std::vector<double> post_op_params;
+  LoweringFunc::get_post_op_chain(
+      args_num, extra_args, post_op_kinds, post_op_params);
+  torch_ipex::cpu::detail::linear::run_post_op_chain(
+      op_context->get_context(),
+      tensors[input_buf_idx],
+      tensors[output_buf_idx],
+      c10::ArrayRef<at::Tensor>(tensors).slice(
+          src_buf_idx, LoweringFunc::kNumSrcs),
+      post_op_kinds,
+      post_op_params);
+}
+
+} // namespace tensorexpr
+} // namespace cpu
+} // namespace jit
+} // namespace torch_ipex
@@ -33,7 +33,9 @@ void registerCustomOp2NncFuser() {
        kLinearSqrtSchema,  kLinearSquareSchema,    kLinearTanhSchema,
        kLinearSiluSchema,  kLinearLogSchema,       kLinearRoundSchema,
        kLinearClampSchema, kLinearEluSchema,       kLinearGeluSchema,
-       kLinearPowSchema,   kLinearLeakyReluSchema, kLinearHardsigmoidSchema});
+       kLinearPowSchema,   kLinearLeakyReluSchema, kLinearHardsigmoidSchema,
+       kConvPostOpsSchema, kConvSumPostOpsSchema,  kLinearPostOpsSchema,
+       kLinearBinaryPostOpsSchema, kLinearBinary2PostOpsSchema});
 }
 
 } // namespace tensorexpr
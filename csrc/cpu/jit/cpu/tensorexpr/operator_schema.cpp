@@ -49,6 +49,10 @@ const char kConvAddSchema[] =
     "ipex_prepack::convolution_add_run(Tensor input, Tensor(a!) accumu, *, Scalar? alpha, __torch__.torch.classes.ipex_prepack.ConvolutionOpContext W_prepack) -> Tensor";
 const char kConvHardsigmoidSchema[] =
     "ipex_prepack::convolution_hardsigmoid_run(Tensor input, __torch__.torch.classes.ipex_prepack.ConvolutionOpContext W_prepack) -> Tensor";
+const char kConvPostOpsSchema[] =
+    "ipex_prepack::convolution_post_ops_run(Tensor input, int[] post_op_kinds, float[] post_op_params, __torch__.torch.classes.ipex_prepack.ConvolutionOpContext W_prepack) -> Tensor";
+const char kConvSumPostOpsSchema[] =
+    "ipex_prepack::convolution_sum_post_ops_run(Tensor input, Tensor accumu, int[] post_op_kinds, float[] post_op_params, __torch__.torch.classes.ipex_prepack.ConvolutionOpContext W_prepack) -> Tensor";
 const char kLinearNoneSchema[] =
     "ipex_prepack::linear_run(Tensor input, __torch__.torch.classes.ipex_prepack.LinearOpContext W_prepack) -> Tensor";
 const char kLinearAbsSchema[] =
@@ -91,6 +95,12 @@ const char kLinearHardsigmoidSchema[] =
     "ipex_prepack::linear_hardsigmoid_run(Tensor input, __torch__.torch.classes.ipex_prepack.LinearOpContext W_prepack) -> Tensor";
 const char kLinearAddReluSchema[] =
     "ipex_prepack::linear_add_relu_run(Tensor input, Tensor(a!) accumu, *, Scalar? alpha, __torch__.torch.classes.ipex_prepack.LinearOpContext W_prepack) -> Tensor(a!)";
+const char kLinearPostOpsSchema[] =
+    "ipex_prepack::linear_post_ops_run(Tensor input, int[] post_op_kinds, float[] post_op_params, __torch__.torch.classes.ipex_prepack.LinearOpContext W_prepack) -> Tensor";
+const char kLinearBinaryPostOpsSchema[] =
+    "ipex_prepack::linear_binary_post_ops_run(Tensor input, Tensor other, int[] post_op_kinds, float[] post_op_params, __torch__.torch.classes.ipex_prepack.LinearOpContext W_prepack) -> Tensor";
+const char kLinearBinary2PostOpsSchema[] =
+    "ipex_prepack::linear_binary2_post_ops_run(Tensor input, Tensor other, Tensor other2, int[] post_op_kinds, float[] post_op_params, __torch__.torch.classes.ipex_prepack.LinearOpContext W_prepack) -> Tensor";
 } // namespace tensorexpr
 } // namespace cpu
 } // namespace jit
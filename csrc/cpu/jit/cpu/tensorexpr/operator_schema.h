@@ -27,6 +27,8 @@ extern const char kConvLeakyReluSchema[];
 extern const char kConvSiluSchema[];
 extern const char kConvAddSchema[];
 extern const char kConvHardsigmoidSchema[];
+extern const char kConvPostOpsSchema[];
+extern const char kConvSumPostOpsSchema[];
 extern const char kLinearNoneSchema[];
 extern const char kLinearAbsSchema[];
 extern const char kLinearExpSchema[];
@@ -48,6 +50,9 @@ extern const char kLinearLeakyReluSchema[];
 extern const char kLinearAddSchema[];
 extern const char kLinearHardsigmoidSchema[];
 extern const char kLinearAddReluSchema[];
+extern const char kLinearPostOpsSchema[];
+extern const char kLinearBinaryPostOpsSchema[];
+extern const char kLinearBinary2PostOpsSchema[];
 
 } // namespace tensorexpr
 } // namespace cpu
@@ -83,6 +83,7 @@ void IPEXFusionPass(std::shared_ptr<Graph>& graph) {
 
   // ipex einsum
   graph_rewrite::FusedEinsumPost(graph);
+  graph_rewrite::FusedEinsum(graph);
 
   // replace python GELU to Aten GELU which are equally in math for more post-op
   // fusions
@@ -119,13 +120,18 @@ void IPEXFusionPass(std::shared_ptr<Graph>& graph) {
 
   // convolution fusion
   GRAPH_DUMP(
-      "After insertPrePackedConvOp.Before fuseConvWithEltwiseAdd", graph);
+      "After insertPrePackedConvOp.Before fuseConvWithPostOpChain", graph);
+  graph_rewrite::fuseConvWithPostOpChain(graph);
+  GRAPH_DUMP(
+      "After fuseConvWithPostOpChain.Before fuseConvWithEltwiseAdd", graph);
   graph_rewrite::fuseConvWithEltwiseAdd(graph);
   GRAPH_DUMP("After fuseConvWithEltwiseAdd.Before fuseConvAddRelu", graph);
   graph_rewrite::fuseConvAddRelu(graph);
   GRAPH_DUMP("After fuseConvAddRelu.Before fuseBottleneck", graph);
   graph_rewrite::fuseBottleneck(graph);
-  GRAPH_DUMP("After fuseBottleneck.", graph);
+  GRAPH_DUMP("After fuseBottleneck.Before fuseInvertedResidual", graph);
+  graph_rewrite::fuseInvertedResidual(graph);
+  GRAPH_DUMP("After fuseInvertedResidual.", graph);
 
   // TODO: Record original aten nodes, while convert aten linear-> ipex linear,
   // will ignore these aten linear (if they are fp32 dtype). For BF16 dtype,
@@ -149,7 +155,10 @@ void IPEXFusionPass(std::shared_ptr<Graph>& graph) {
       aten_linear_recorder.get_records(),
       aten_linear_recorder.use_mkl());
   GRAPH_DUMP(
-      "After insertPrePackedLinearOp.Before fuseLinearWithEltwise", graph);
+      "After insertPrePackedLinearOp.Before fuseLinearWithPostOpChain", graph);
+  graph_rewrite::fuseLinearWithPostOpChain(graph);
+  GRAPH_DUMP(
+      "After fuseLinearWithPostOpChain.Before fuseLinearWithEltwise", graph);
   graph_rewrite::fuseLinearWithEltwise(graph);
   GRAPH_DUMP("After fuseLinearWithEltwise.Before fuseLinearAddRelu", graph);
   graph_rewrite::fuseLinearAddRelu(graph);
@@ -162,6 +171,8 @@ void IPEXFusionPass(std::shared_ptr<Graph>& graph) {
   graph_rewrite::FuseRMSNorm(graph);
   // fuse add+layernorm
   graph_rewrite::FuseAddLayerNorm(graph);
+  // fuse group_norm+silu/gelu
+  graph_rewrite::FuseGroupNormAct(graph);
 
   // deconvolution fusion
   GRAPH_DUMP(
@@ -229,6 +229,49 @@ void FuseAddLayerNorm(std::shared_ptr<Graph>& graph) {
   rewriter_aten.runOnGraph(graph);
 }
 
+void FuseGroupNormAct(std::shared_ptr<Graph>& graph) {
+  auto aten_group_norm_silu = at::jit::CodeTemplate(R"(
+      graph(%input, %num_groups:int, %w, %b, %eps:float, %cudnn_enabled:bool):
+        %n = aten::group_norm(%input, %num_groups, %w, %b, %eps, %cudnn_enabled)
+        %r = aten::${silu}(%n)
+        return (%r) )");
+  std::string fused_group_norm_silu = R"(
+      graph(%input, %num_groups:int, %w, %b, %eps:float, %cudnn_enabled:bool):
+        %act : str = prim::Constant[value="silu"]()
+        %approximate : str = prim::Constant[value="none"]()
+        %residual : NoneType = prim::Constant()
+        %scale : float = prim::Constant[value=1.0]()
+        %r = torch_ipex::group_norm_act(%input, %num_groups, %w, %b, %eps, %act, %approximate, %residual, %scale)
+        return (%r) )";
+  auto aten_group_norm_gelu = at::jit::CodeTemplate(R"(
+      graph(%input, %num_groups:int, %w, %b, %eps:float, %cudnn_enabled:bool, %approximate:str):
+        %n = aten::group_norm(%input, %num_groups, %w, %b, %eps, %cudnn_enabled)
+        %r = aten::${gelu}(%n, %approximate)
+        return (%r) )");
+  std::string fused_group_norm_gelu = R"(
+      graph(%input, %num_groups:int, %w, %b, %eps:float, %cudnn_enabled:bool, %approximate:str):
+        %act : str = prim::Constant[value="gelu"]()
+        %residual : NoneType = prim::Constant()
+        %scale : float = prim::Constant[value=1.0]()
+        %r = torch_ipex::group_norm_act(%input, %num_groups, %w, %b, %eps, %act, %approximate, %residual, %scale)
+        return (%r) )";
+
+  SubgraphRewriter rewriter_aten;
+  for (const auto& silu : std::vector<std::string>{"silu", "silu_"}) {
+    at::jit::TemplateEnv env;
+    env.s("silu", silu);
+    rewriter_aten.RegisterRewritePattern(
+        aten_group_norm_silu.format(env), fused_group_norm_silu);
+  }
+  for (const auto& gelu : std::vector<std::string>{"gelu", "gelu_"}) {
+    at::jit::TemplateEnv env;
+    env.s("gelu", gelu);
+    rewriter_aten.RegisterRewritePattern(
+        aten_group_norm_gelu.format(env), fused_group_norm_gelu);
+  }
+  rewriter_aten.runOnGraph(graph);
+}
+
 void FuseMatmulDivOrMul(std::shared_ptr<Graph>& graph) {
   const std::string div_str = R"(div)";
   const std::string div_inplace_str = R"(div_)";
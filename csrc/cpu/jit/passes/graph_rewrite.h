@@ -51,6 +51,10 @@ void insertPrePackedConvOp(std::shared_ptr<torch::jit::Graph>& graph);
 void fuseConvWithEltwiseAdd(std::shared_ptr<torch::jit::Graph>& graph);
 void fuseConvAddRelu(std::shared_ptr<torch::jit::Graph>& graph);
 void fuseBottleneck(std::shared_ptr<torch::jit::Graph>& graph);
+void fuseInvertedResidual(std::shared_ptr<torch::jit::Graph>& graph);
+// Fuse a chain of eltwise and binary ops following a prepacked conv/linear into
+// a single ipex_prepack::*_post_ops_run op running them as oneDNN post-ops
+void fuseConvWithPostOpChain(std::shared_ptr<torch::jit::Graph>& graph);
 void RecordAtenLinearNodes(
     std::shared_ptr<torch::jit::Graph>& graph,
     std::unordered_set<torch::jit::Node*>& aten_linear,
@@ -62,9 +66,13 @@ void insertPrePackedLinearOp(
 void fuseLinearWithEltwise(std::shared_ptr<torch::jit::Graph>& graph);
 void fuseLinearAddRelu(std::shared_ptr<torch::jit::Graph>& graph);
 void fuseLinearMulAdd(std::shared_ptr<torch::jit::Graph>& graph);
+// Same as fuseConvWithPostOpChain for linear_run, and for mkl_sgemm_run with
+// eltwise post-ops only, which the MKL sgemm kernel applies itself
+void fuseLinearWithPostOpChain(std::shared_ptr<torch::jit::Graph>& graph);
 
 void FuseRMSNorm(std::shared_ptr<torch::jit::Graph>& graph);
 void FuseAddLayerNorm(std::shared_ptr<torch::jit::Graph>& graph);
+void FuseGroupNormAct(std::shared_ptr<torch::jit::Graph>& graph);
 void FuseMatmulDivOrMul(std::shared_ptr<torch::jit::Graph>& graph);
 void FuseConcatBnRelu(std::shared_ptr<torch::jit::Graph>& graph);
 
@@ -73,6 +81,7 @@ void fuseConvTransposeWithEltwise(std::shared_ptr<torch::jit::Graph>& graph);
 void fuseConvTransposeAdd(std::shared_ptr<torch::jit::Graph>& graph);
 
 void FusedEinsumPost(std::shared_ptr<torch::jit::Graph>& graph);
+void FusedEinsum(std::shared_ptr<torch::jit::Graph>& graph);
 
 void FusedTransFreeMha(std::shared_ptr<torch::jit::Graph>& graph);
 void FusePythonGELUWithAten(std::shared_ptr<torch::jit::Graph>& graph);
@@ -518,6 +518,118 @@ void fuseBottleneck(std::shared_ptr<Graph>& graph) {
   rewriter_v2.runOnGraph(graph, filter_v2);
 }
 
+// Call of ipex_prepack::convolution_${op}_run with input x and the packed
+// weight of the given index, the extra inputs of the op are added to
+// graph_inputs.
+static std::string convUnaryRunString(
+    const std::string& op,
+    const std::vector<std::string>& op_inputs,
+    const std::string& x,
+    const std::string& index,
+    std::vector<std::string>& graph_inputs) {
+  std::vector<std::string> inputs = {x};
+  for (const auto& op_input : op_inputs) {
+    inputs.push_back(op_input + index);
+    graph_inputs.push_back(op_input + index);
+  }
+  inputs.push_back("%packed_weight" + index);
+  return "ipex_prepack::convolution_" + op + "_run(" +
+      c10::Join(", ", inputs) + ")";
+}
+
+void fuseInvertedResidual(std::shared_ptr<Graph>& graph) {
+  SubgraphRewriter rewriter_add, rewriter;
+  // Post ops of the expand and depthwise convolutions in MobileNet (ReLU,
+  // ReLU6 as hardtanh) and EfficientNet (SiLU as swish, hardswish), and the
+  // extra inputs of their run ops.
+  std::vector<std::pair<std::string, std::vector<std::string>>> unary_ops = {
+      {"relu", {}},
+      {"hardtanh", {"%lower", "%upper"}},
+      {"swish", {}},
+      {"hardswish", {}},
+  };
+
+  // expand 1x1 conv -> depthwise conv -> project 1x1 conv (+ input)
+  // SE blocks need the whole depthwise output before the projection, they are
+  // not matched.
+  auto inverted_residual_add_rstring = CodeTemplate(R"(
+    graph(${graph_inputs}, %alpha):
+        %res1 = ${conv1}
+        %res2 = ${conv2}
+        %res = ipex_prepack::convolution_add_run(%res2, %input, %alpha, %packed_weight3)
+        return (%res))");
+  auto inverted_residual_add_fused = CodeTemplate(R"(
+    graph(${graph_inputs}, %alpha):
+        %res = ipex_prepack::convolution_inverted_residual_run(%input, %packed_weight1, %packed_weight2, %packed_weight3, %alpha)
+        return (%res))");
+
+  auto inverted_residual_rstring = CodeTemplate(R"(
+    graph(${graph_inputs}):
+        %res1 = ${conv1}
+        %res2 = ${conv2}
+        %res = ipex_prepack::convolution_run(%res2, %packed_weight3)
+        return (%res))");
+  auto inverted_residual_fused = CodeTemplate(R"(
+    graph(${graph_inputs}):
+        %alpha : NoneType = prim::Constant()
+        %res = ipex_prepack::convolution_inverted_residual_run(%input, %packed_weight1, %packed_weight2, %packed_weight3, %alpha)
+        return (%res))");
+
+  for (const auto& op1 : unary_ops) {
+    for (const auto& op2 : unary_ops) {
+      std::vector<std::string> graph_inputs = {
+          "%input", "%packed_weight1", "%packed_weight2", "%packed_weight3"};
+      TemplateEnv env;
+      env.s(
+          "conv1",
+          convUnaryRunString(
+              op1.first, op1.second, "%input", "1", graph_inputs));
+      env.s(
+          "conv2",
+          convUnaryRunString(
+              op2.first, op2.second, "%res1", "2", graph_inputs));
+      env.s("graph_inputs", c10::Join(", ", graph_inputs));
+      rewriter_add.RegisterRewritePattern(
+          inverted_residual_add_rstring.format(env),
+          inverted_residual_add_fused.format(env));
+      rewriter.RegisterRewritePattern(
+          inverted_residual_rstring.format(env),
+          inverted_residual_fused.format(env));
+    }
+  }
+
+  // Requires channels last weights, ungrouped expand/project convolutions, a
+  // grouped middle convolution and constant alpha. Kernel sizes and strides
+  // are checked at runtime, where the op falls back to three convolutions.
+  auto filter = [](const Match& match,
+                   const std::unordered_map<std::string, Value*>& vmap) {
+    for (const std::string name :
+         {"packed_weight1", "packed_weight2", "packed_weight3"}) {
+      auto packed_weight = match.values_map.at(vmap.at(name))->node();
+      auto weight_is_channels_last =
+          constant_as<bool>(packed_weight->inputs().at(6));
+      auto groups = constant_as<int64_t>(packed_weight->inputs().at(5));
+      if (!weight_is_channels_last.has_value() ||
+          !weight_is_channels_last.value() || !groups.has_value()) {
+        return false;
+      }
+      if ((groups.value() > 1) != (name == "packed_weight2")) {
+        return false;
+      }
+    }
+    if (vmap.count("alpha")) {
+      auto alpha = match.values_map.at(vmap.at("alpha"))->node();
+      if (alpha->kind() != prim::Constant) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  rewriter_add.runOnGraph(graph, filter);
+  rewriter.runOnGraph(graph, filter);
+}
+
 } // namespace graph_rewrite
 } // namespace jit
 } // namespace torch_ipex
@@ -20,8 +20,15 @@ auto ipex_einsum_filter =
                           .value()
                           .toStringView();
       int num_ops = std::count(equation.begin(), equation.end(), ',') + 1;
-      if (num_ops != 2) {
-        return false; // only process the 2 operands
+      if (num_ops < 2) {
+        return false; // nothing to contract for a single operand
+      }
+      // ipex::einsum plans its own contraction order and takes no path, so
+      // leave einsum with an explicit path to aten
+      auto path = torch_ipex::jit::graph_rewrite_helper::getIValue(
+          "path", match_vmap, vmap);
+      if (!path.has_value() || !path.value().isNone()) {
+        return false;
       }
       return true;
     };
@@ -48,6 +55,20 @@ void FusedEinsumPost(std::shared_ptr<Graph>& graph) {
   rewriter_einsum_binary.runOnGraph(graph, ipex_einsum_filter);
 }
 
+void FusedEinsum(std::shared_ptr<Graph>& graph) {
+  std::string aten_einsum = R"(
+     graph(%equation, %inputs, %path):
+        %res = aten::einsum(%equation, %inputs, %path)
+        return (%res))";
+  std::string ipex_einsum = R"(
+    graph(%equation, %inputs, %path):
+        %res = ipex::einsum(%equation, %inputs)
+        return (%res))";
+  SubgraphRewriter rewriter_einsum;
+  rewriter_einsum.RegisterRewritePattern(aten_einsum, ipex_einsum);
+  rewriter_einsum.runOnGraph(graph, ipex_einsum_filter);
+}
+
 } // namespace graph_rewrite
 } // namespace jit
 } // namespace torch_ipex
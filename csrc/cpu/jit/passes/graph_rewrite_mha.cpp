@@ -10,6 +10,16 @@ namespace graph_rewrite {
 
 using namespace at::jit;
 using namespace torch::jit;
+
+// The Stable-Diffusion Flash Attention kernels run in BF16, FP16 and FP32
+bool is_sd_flash_mha_dtype(const TensorTypePtr& type) {
+  if (!type->scalarType().has_value()) {
+    return false;
+  }
+  auto dtype = type->scalarType().value();
+  return dtype == at::kBFloat16 || dtype == at::kHalf || dtype == at::kFloat;
+}
+
 auto bert_flash_mha_filter =
     [](const Match& match,
        const std::unordered_map<std::string, Value*>& vmap) {
@@ -28,8 +38,10 @@ auto bert_flash_mha_filter =
           toIValue(graph_rewrite_helper::getValue("trans_b", match_vmap, vmap))
               ->toInt();
       std::vector<int64_t> permute_ref = {0, 2, 1, 3};
+      // FP32 stays on the transpose-free matmul path of oneDNN
       if (permute_sizes != permute_ref || !(trans_a == -1 && trans_b == -2) ||
-          qkv->scalarType().value() != at::kBFloat16) {
+          (qkv->scalarType().value() != at::kBFloat16 &&
+           qkv->scalarType().value() != at::kHalf)) {
         return false;
       }
       // Checking the dtype as None
@@ -74,10 +86,18 @@ auto sd_flash_mha_filter_v1 = [](const Match& match,
                  ->toInt();
   auto two = toIValue(graph_rewrite_helper::getValue("two", match_vmap, vmap))
                  ->toInt();
+  // The qkv of FP32 is split by aten::split_with_sizes on the last dim
+  if (vmap.count("split_dim")) {
+    auto split_dim =
+        graph_rewrite_helper::getIValue("split_dim", match_vmap, vmap);
+    if (!split_dim.has_value() || split_dim.value().toInt() != -1) {
+      return false;
+    }
+  }
   std::vector<int64_t> permute_ref = {0, 2, 1, 3};
   if (permute_sizes != permute_ref ||
       !(zero == 0 && neg_one == -1 && neg_two == -2 && one == 1 && two == 2) ||
-      qkv->scalarType().value() != at::kBFloat16 || split_idx.size() != 3 ||
+      !is_sd_flash_mha_dtype(qkv) || split_idx.size() != 3 ||
       split_idx[0] != split_idx[1] || split_idx[0] != split_idx[2]) {
     return false;
   }
@@ -110,7 +130,7 @@ auto sd_flash_mha_filter_v2 = [](const Match& match,
   std::vector<int64_t> permute_ref = {0, 2, 1, 3};
   if (permute_sizes != permute_ref ||
       !(zero == 0 && neg_one == -1 && neg_two == -2 && one == 1 && two == 2) ||
-      query0->scalarType().value() != at::kBFloat16) {
+      !is_sd_flash_mha_dtype(query0)) {
     return false;
   }
   return true;
@@ -137,7 +157,7 @@ auto sd_flash_mha_filter_v3 =
                      ->type()
                      ->cast<TensorType>();
       if (!(one == 1 && two == 2 && neg_one == -1) ||
-          qkv->scalarType().value() != at::kBFloat16 || split_idx.size() != 3 ||
+          !is_sd_flash_mha_dtype(qkv) || split_idx.size() != 3 ||
           split_idx[0] != split_idx[1] || split_idx[0] != split_idx[2]) {
         return false;
       }
@@ -162,7 +182,7 @@ auto sd_flash_mha_filter_v4 =
                         ->type()
                         ->cast<TensorType>();
       if (!(one == 1 && two == 2 && neg_one == -1) ||
-          query0->scalarType().value() != at::kBFloat16) {
+          !is_sd_flash_mha_dtype(query0)) {
         return false;
       }
       return true;
@@ -283,7 +303,8 @@ auto split_replace_filter =
               ->type()
               ->cast<TensorType>();
       if (!to_split->scalarType().has_value() ||
-          to_split->scalarType().value() != at::kBFloat16)
+          (to_split->scalarType().value() != at::kBFloat16 &&
+           to_split->scalarType().value() != at::kHalf))
         return false;
       auto dim =
           toIValue(graph_rewrite_helper::getValue("dim", match_vmap, vmap))
@@ -401,6 +422,9 @@ void FusedTransFreeMha(std::shared_ptr<Graph>& graph) {
   std::string sd_mha_graph_v1 = R"(
       graph(%qkv: Tensor, %split_idx: int[], %zero, %neg_one, %neg_two, %one, %two, %idx, %scale: float, %no, %device, %dtype, %headsize, %num_head, %permutelist): )";
 
+  std::string sd_mha_graph_v1_aten = R"(
+      graph(%qkv: Tensor, %split_idx: int[], %split_dim: int, %zero, %neg_one, %neg_two, %one, %two, %idx, %scale: float, %no, %device, %dtype, %headsize, %num_head, %permutelist): )";
+
   std::string sd_mha_graph_v2 = R"(
       graph(%query0: Tensor, %key0: Tensor, %value0: Tensor, %zero, %neg_one, %neg_two, %one, %two, %idx, %scale: float, %no, %device, %dtype, %headsize, %num_head, %permutelist): )";
 
@@ -414,6 +438,11 @@ void FusedTransFreeMha(std::shared_ptr<Graph>& graph) {
         %qkv_list = ipex::split_tensor(%qkv, %split_idx)
         %query0, %key0, %value0 = prim::ListUnpack(%qkv_list) )";
 
+  // FP32 keeps aten::split_with_sizes, which is only replaced for BF16/FP16
+  std::string sd_qkv_split_aten = R"(
+        %qkv_list = aten::split_with_sizes(%qkv, %split_idx, %split_dim)
+        %query0, %key0, %value0 = prim::ListUnpack(%qkv_list) )";
+
   std::string sd_mha_query = R"(
         %query1 = aten::size(%query0, %zero)
         %query2 = prim::NumToTensor(%query1)
@@ -514,11 +543,15 @@ void FusedTransFreeMha(std::shared_ptr<Graph>& graph) {
 
   auto sd_mha_pattern_v1 = sd_mha_graph_v1 + sd_qkv_split + sd_mha_query +
       sd_mha_key + sd_mha_value + sd_mha_main_v1;
+  auto sd_mha_pattern_v1_aten = sd_mha_graph_v1_aten + sd_qkv_split_aten +
+      sd_mha_query + sd_mha_key + sd_mha_value + sd_mha_main_v1;
   auto sd_mha_pattern_v2 = sd_mha_graph_v2 + sd_mha_query + sd_mha_key +
       sd_mha_value + sd_mha_main_v1;
   auto sd_mha_pattern_v3 = sd_mha_graph_v3 + sd_qkv_split + sd_mha_main_v2;
   auto sd_mha_pattern_v4 = sd_mha_graph_v4 + sd_mha_main_v2;
   auto sd_fused_mha_pattern_v1 = sd_mha_graph_v1 + sd_fused_mha_main_v1;
+  auto sd_fused_mha_pattern_v1_aten =
+      sd_mha_graph_v1_aten + sd_fused_mha_main_v1;
   auto sd_fused_mha_pattern_v2 = sd_mha_graph_v2 + sd_fused_mha_main_v2;
   auto sd_fused_mha_pattern_v3 = sd_mha_graph_v3 + sd_fused_mha_main_v1;
   auto sd_fused_mha_pattern_v4 = sd_mha_graph_v4 + sd_fused_mha_main_v2;
@@ -526,6 +559,8 @@ void FusedTransFreeMha(std::shared_ptr<Graph>& graph) {
       sd_mha_fusion_v4;
   sd_mha_fusion_v1.RegisterRewritePattern(
       sd_mha_pattern_v1, sd_fused_mha_pattern_v1);
+  sd_mha_fusion_v1.RegisterRewritePattern(
+      sd_mha_pattern_v1_aten, sd_fused_mha_pattern_v1_aten);
   sd_mha_fusion_v1.runOnGraph(graph, sd_flash_mha_filter_v1);
   sd_mha_fusion_v2.RegisterRewritePattern(
       sd_mha_pattern_v2, sd_fused_mha_pattern_v2);
@@ -0,0 +1,462 @@
+#include <torch/csrc/jit/ir/alias_analysis.h>
+#include <torch/csrc/jit/ir/constants.h>
+#include <torch/csrc/jit/jit_log.h>
+
+#include "cpu/kernels/PostOpChain.h"
+#include "graph_rewrite.h"
+
+#include <limits>
+
+namespace torch_ipex {
+namespace jit {
+namespace graph_rewrite {
+
+using namespace torch::jit;
+using namespace torch_ipex::cpu::detail;
+
+namespace {
+
+// A post-op absorbed into the chain. src_idx is the input of node holding the
+// source of a binary or sum post-op, -1 for an eltwise post-op.
+struct PostOp {
+  Node* node;
+  int64_t kind;
+  double alpha;
+  double beta;
+  int src_idx;
+};
+
+// The max number of binary post-op sources of a linear chain, one per
+// linear_binary*_post_ops_run schema.
+constexpr int kMaxLinearPostOpSrcs = 2;
+
+bool isKind(const Node* n, const char* name) {
+  return n->kind() == Symbol::aten(name) ||
+      n->kind() == Symbol::aten(std::string(name) + "_");
+}
+
+bool isInplace(const Node* n) {
+  auto name = std::string(n->kind().toUnqualString());
+  return name.back() == '_';
+}
+
+c10::optional<double> constantScalar(Value* v) {
+  auto ivalue = toIValue(v);
+  if (!ivalue.has_value()) {
+    return c10::nullopt;
+  }
+  if (ivalue->isDouble()) {
+    return ivalue->toDouble();
+  }
+  if (ivalue->isInt()) {
+    return static_cast<double>(ivalue->toInt());
+  }
+  return c10::nullopt;
+}
+
+bool isConstantNone(Value* v) {
+  auto ivalue = toIValue(v);
+  return ivalue.has_value() && ivalue->isNone();
+}
+
+bool isTensor(Value* v) {
+  return v->type()->cast<TensorType>() != nullptr;
+}
+
+// The second operand of a binary post-op has to keep the result dtype of the
+// chain, since it is converted to the dtype of the conv/linear output.
+bool isSameDtypeTensor(Value* v, Value* chain_value) {
+  auto t = v->type()->cast<TensorType>();
+  auto chain_t = chain_value->type()->cast<TensorType>();
+  return t && chain_t && t->scalarType().has_value() &&
+      t->scalarType() == chain_t->scalarType();
+}
+
+bool matchEltwise(Node* n, PostOp& op) {
+  op.alpha = 0.f;
+  op.beta = 0.f;
+  op.src_idx = -1;
+  const auto num_inputs = n->inputs().size();
+  if (num_inputs == 1) {
+    static const std::vector<std::pair<const char*, int64_t>> kUnaryOps = {
+        {"relu", kPostOpRelu},
+        {"sigmoid", kPostOpSigmoid},
+        {"tanh", kPostOpTanh},
+        {"abs", kPostOpAbs},
+        {"exp", kPostOpExp},
+        {"log", kPostOpLog},
+        {"sqrt", kPostOpSqrt},
+        {"square", kPostOpSquare},
+        {"round", kPostOpRound},
+        {"mish", kPostOpMish},
+        {"gelu", kPostOpGeluErf},
+    };
+    if (isKind(n, "silu")) {
+      op.kind = kPostOpSwish;
+      op.alpha = 1.f;
+      return true;
+    }
+    // oneDNN computes hardsigmoid as clamp(alpha * x + beta, 0, 1) and
+    // hardswish as x times that, PyTorch's are alpha = 1/6 and beta = 1/2
+    if (isKind(n, "hardswish") || isKind(n, "hardsigmoid")) {
+      op.kind = isKind(n, "hardswish") ? kPostOpHardswish : kPostOpHardsigmoid;
+      op.alpha = 1.f / 6;
+      op.beta = 0.5f;
+      return true;
+    }
+    for (const auto& it : kUnaryOps) {
+      if (isKind(n, it.first)) {
+        op.kind = it.second;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  if (isKind(n, "gelu") && num_inputs == 2) {
+    auto approximate = toIValue(n->input(1));
+    if (!approximate.has_value() || !approximate->isString()) {
+      return false;
+    }
+    if (approximate->toStringRef() == "none") {
+      op.kind = kPostOpGeluErf;
+      return true;
+    }
+    if (approximate->toStringRef() == "tanh") {
+      op.kind = kPostOpGeluTanh;
+      return true;
+    }
+    return false;
+  }
+  if (isKind(n, "leaky_relu") && num_inputs == 2) {
+    auto slope = constantScalar(n->input(1));
+    if (!slope.has_value()) {
+      return false;
+    }
+    op.kind = kPostOpRelu;
+    op.alpha = slope.value();
+    return true;
+  }
+  if ((isKind(n, "hardtanh") || isKind(n, "clamp")) && num_inputs == 3) {
+    auto lo = constantScalar(n->input(1));
+    auto hi = constantScalar(n->input(2));
+    if ((!lo.has_value() && !isConstantNone(n->input(1))) ||
+        (!hi.has_value() && !isConstantNone(n->input(2))) ||
+        (!lo.has_value() && !hi.has_value())) {
+      return false;
+    }
+    op.kind = kPostOpClip;
+    op.alpha = lo.value_or(std::numeric_limits<float>::lowest());
+    op.beta = hi.value_or(std::numeric_limits<float>::max());
+    return true;
+  }
+  if (isKind(n, "elu") && num_inputs == 4) {
+    auto alpha = constantScalar(n->input(1));
+    auto scale = constantScalar(n->input(2));
+    auto input_scale = constantScalar(n->input(3));
+    if (!alpha.has_value() || scale != 1. || input_scale != 1.) {
+      return false;
+    }
+    op.kind = kPostOpElu;
+    op.alpha = alpha.value();
+    return true;
+  }
+  if (isKind(n, "pow") && num_inputs == 2) {
+    auto exponent = constantScalar(n->input(1));
+    if (!exponent.has_value()) {
+      return false;
+    }
+    op.kind = kPostOpPow;
+    op.alpha = 1.f;
+    op.beta = exponent.value();
+    return true;
+  }
+  return false;
+}
+
+// Arithmetic with a constant scalar as a linear post-op alpha * x + beta, x
+// being the chain value which must be the first input.
+bool matchScalarArithmetic(Node* n, PostOp& op) {
+  op.src_idx = -1;
+  op.kind = kPostOpLinear;
+  const auto num_inputs = n->inputs().size();
+  auto other = constantScalar(n->input(1));
+  if (!other.has_value()) {
+    return false;
+  }
+  if ((isKind(n, "add") || isKind(n, "sub") || n->kind() == aten::rsub) &&
+      num_inputs == 3) {
+    auto alpha = constantScalar(n->input(2));
+    if (!alpha.has_value()) {
+      return false;
+    }
+    if (n->kind() == aten::rsub) {
+      op.alpha = -alpha.value();
+      op.beta = other.value();
+    } else {
+      op.alpha = 1.f;
+      op.beta = isKind(n, "add") ? alpha.value() * other.value()
+                                 : -alpha.value() * other.value();
+    }
+    return true;
+  }
+  if (isKind(n, "mul") && num_inputs == 2) {
+    op.alpha = other.value();
+    op.beta = 0.f;
+    return true;
+  }
+  if (isKind(n, "div") && num_inputs == 2 && other.value() != 0.) {
+    op.alpha = 1. / other.value();
+    op.beta = 0.f;
+    return true;
+  }
+  return false;
+}
+
+// Arithmetic with a tensor as a binary post-op, or as a sum post-op for a
+// conv chain which does not support binary post-ops.
+bool matchBinary(Node* n, Value* x, bool is_conv, int pos, PostOp& op) {
+  const auto num_inputs = n->inputs().size();
+  if (num_inputs < 2 || !isTensor(n->input(0)) || !isTensor(n->input(1)) ||
+      n->input(0) == n->input(1)) {
+    return false;
+  }
+  bool x_first = n->input(0) == x;
+  // An inplace op writes its first input, which can only be the chain value
+  if (isInplace(n) && !x_first) {
+    return false;
+  }
+  op.src_idx = x_first ? 1 : 0;
+  op.alpha = 1.f;
+  op.beta = 0.f;
+  if (!isSameDtypeTensor(n->input(op.src_idx), x)) {
+    return false;
+  }
+  if (isKind(n, "add") && num_inputs == 3) {
+    auto alpha = constantScalar(n->input(2));
+    if (!alpha.has_value()) {
+      return false;
+    }
+    if (is_conv) {
+      // x + alpha * src accumulated on src, for the first post-op only
+      if (pos != 0 || (!x_first && alpha.value() != 1.)) {
+        return false;
+      }
+      op.kind = kPostOpSum;
+      op.alpha = alpha.value();
+      return true;
+    }
+    op.kind = kPostOpBinaryAdd;
+    return alpha.value() == 1.;
+  }
+  if (is_conv) {
+    return false;
+  }
+  if (isKind(n, "sub") && num_inputs == 3 && x_first) {
+    op.kind = kPostOpBinarySub;
+    return constantScalar(n->input(2)) == 1.;
+  }
+  if (isKind(n, "mul") && num_inputs == 2) {
+    op.kind = kPostOpBinaryMul;
+    return true;
+  }
+  if (isKind(n, "div") && num_inputs == 2 && x_first) {
+    op.kind = kPostOpBinaryDiv;
+    return true;
+  }
+  if (n->kind() == aten::maximum || n->kind() == aten::minimum) {
+    op.kind = n->kind() == aten::maximum ? kPostOpBinaryMax : kPostOpBinaryMin;
+    return true;
+  }
+  return false;
+}
+
+bool matchPostOp(Node* n, Value* x, bool is_conv, int pos, PostOp& op) {
+  if (n->inputs().empty()) {
+    return false;
+  }
+  op.node = n;
+  if (n->input(0) == x && matchEltwise(n, op)) {
+    return true;
+  }
+  if (n->inputs().size() >= 2 && n->input(0) == x && !isTensor(n->input(1)) &&
+      matchScalarArithmetic(n, op)) {
+    return true;
+  }
+  return matchBinary(n, x, is_conv, pos, op);
+}
+
+// Chains of a single post-op, or which the conv/linear fusion passes running
+// after this one fuse with an inplace accumulation, are left to them.
+bool isLeftToOtherPasses(const std::vector<PostOp>& chain, bool is_conv) {
+  if (chain.size() < 2) {
+    return true;
+  }
+  if (chain.size() > 2) {
+    return false;
+  }
+  auto first = chain[0].kind;
+  auto second = chain[1].kind;
+  if (is_conv) {
+    return first == kPostOpSum && second == kPostOpRelu;
+  }
+  return (first == kPostOpBinaryMul && second == kPostOpBinaryAdd) ||
+      (first == kPostOpBinaryAdd && second == kPostOpRelu);
+}
+
+class PostOpChainFuser {
+ public:
+  explicit PostOpChainFuser(std::shared_ptr<Graph> graph)
+      : graph_(std::move(graph)) {}
+
+  void run(const Symbol& root_kind) {
+    collectChains(graph_->block(), root_kind);
+    // Rewrite after collecting all the chains, the alias db is only valid for
+    // the original graph. Nodes rather than values are kept since a chain
+    // source may be the result of another rewritten chain.
+    for (auto& it : chains_) {
+      rewriteChain(it.first, it.second, root_kind == conv_run_);
+    }
+    chains_.clear();
+    aliasDb_ = nullptr;
+  }
+
+ private:
+  AliasDb* getAliasDb() {
+    if (!aliasDb_) {
+      aliasDb_ = std::make_unique<AliasDb>(graph_);
+    }
+    return aliasDb_.get();
+  }
+
+  void collectChains(Block* b, const Symbol& root_kind) {
+    std::vector<Node*> roots;
+    for (Node* n : b->nodes()) {
+      for (Block* sub : n->blocks()) {
+        collectChains(sub, root_kind);
+      }
+      if (n->kind() == root_kind) {
+        roots.push_back(n);
+      }
+    }
+    const bool is_conv = root_kind == conv_run_;
+    // The MKL sgemm kernel only runs eltwise post-ops, and no other pass fuses
+    // a single post-op into it
+    const bool is_mkl = root_kind == mkl_sgemm_run_;
+    for (Node* root : roots) {
+      auto chain = matchChain(root, is_conv, is_mkl ? 0 : kMaxLinearPostOpSrcs);
+      if (is_mkl ? !chain.empty() : !isLeftToOtherPasses(chain, is_conv)) {
+        chains_.emplace_back(root, std::move(chain));
+      }
+    }
+  }
+
+  std::vector<PostOp> matchChain(Node* root, bool is_conv, int max_srcs) {
+    std::vector<PostOp> chain;
+    int num_srcs = 0;
+    Value* x = root->output();
+    while (x->uses().size() == 1) {
+      Node* n = x->uses()[0].user;
+      PostOp op;
+      if (n->owningBlock() != root->owningBlock() || n->outputs().size() != 1 ||
+          !matchPostOp(n, x, is_conv, chain.size(), op)) {
+        break;
+      }
+      if (op.src_idx >= 0 && !is_conv && num_srcs == max_srcs) {
+        break;
+      }
+      // The conv/linear is run at the last post-op, make sure its input and
+      // the sources read before are not written in between.
+      if (!getAliasDb()->moveBeforeTopologicallyValid(root, n)) {
+        break;
+      }
+      num_srcs += op.src_idx >= 0 ? 1 : 0;
+      chain.push_back(op);
+      x = n->output();
+    }
+    return chain;
+  }
+
+  void rewriteChain(
+      Node* root,
+      const std::vector<PostOp>& chain,
+      bool is_conv) {
+    std::vector<Value*> srcs;
+    std::vector<int64_t> kinds;
+    std::vector<double> params;
+    for (const auto& op : chain) {
+      if (op.src_idx >= 0) {
+        srcs.push_back(op.node->input(op.src_idx));
+      }
+      kinds.push_back(op.kind);
+      params.push_back(op.alpha);
+      params.push_back(op.beta);
+    }
+
+    std::string fused_op;
+    if (root->kind() == mkl_sgemm_run_) {
+      fused_op = "ipex_prepack::mkl_sgemm_post_ops_run";
+    } else if (is_conv) {
+      fused_op = srcs.empty() ? "ipex_prepack::convolution_post_ops_run"
+                              : "ipex_prepack::convolution_sum_post_ops_run";
+    } else if (srcs.empty()) {
+      fused_op = "ipex_prepack::linear_post_ops_run";
+    } else {
+      fused_op = srcs.size() == 1 ? "ipex_prepack::linear_binary_post_ops_run"
+                                  : "ipex_prepack::linear_binary2_post_ops_run";
+    }
+
+    Node* last = chain.back().node;
+    WithInsertPoint guard(last);
+    auto fused =
+        graph_->create(Symbol::fromQualString(fused_op), /*num_outputs=*/1);
+    fused->addInput(root->input(0));
+    for (auto src : srcs) {
+      fused->addInput(src);
+    }
+    fused->addInput(graph_->insertConstant(IValue(kinds)));
+    fused->addInput(graph_->insertConstant(IValue(params)));
+    fused->addInput(root->input(1));
+    fused->output()->setType(last->output()->type());
+    graph_->insertNode(fused);
+    GRAPH_UPDATE(
+        "Fusing ",
+        chain.size(),
+        " post-ops of ",
+        root->kind().toQualString(),
+        " into ",
+        fused_op);
+
+    last->output()->replaceAllUsesWith(fused->output());
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+      it->node->destroy();
+    }
+    root->destroy();
+  }
+
+  std::shared_ptr<Graph> graph_;
+  std::unique_ptr<AliasDb> aliasDb_ = nullptr;
+  std::vector<std::pair<Node*, std::vector<PostOp>>> chains_;
+  const Symbol conv_run_ =
+      Symbol::fromQualString("ipex_prepack::convolution_run");
+  const Symbol mkl_sgemm_run_ =
+      Symbol::fromQualString("ipex_prepack::mkl_sgemm_run");
+};
+
+} // namespace
+
+void fuseConvWithPostOpChain(std::shared_ptr<Graph>& graph) {
+  PostOpChainFuser(graph).run(
+      Symbol::fromQualString("ipex_prepack::convolution_run"));
+}
+
+void fuseLinearWithPostOpChain(std::shared_ptr<Graph>& graph) {
+  PostOpChainFuser(graph).run(
+      Symbol::fromQualString("ipex_prepack::linear_run"));
+  PostOpChainFuser(graph).run(
+      Symbol::fromQualString("ipex_prepack::mkl_sgemm_run"));
+}
+
+} // namespace graph_rewrite
+} // namespace jit
+} // namespace torch_ipex
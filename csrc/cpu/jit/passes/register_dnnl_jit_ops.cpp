@@ -484,6 +484,68 @@ torch::jit::RegisterOperators op({
           };
         },
         aliasAnalysisFromSchema()),
+    Operator(
+        "ipex_prepack::convolution_inverted_residual_run(Tensor input, "
+        "__torch__.torch.classes.ipex_prepack.ConvolutionOpContext W_prepack1, "
+        "__torch__.torch.classes.ipex_prepack.ConvolutionOpContext W_prepack2, "
+        "__torch__.torch.classes.ipex_prepack.ConvolutionOpContext W_prepack3, "
+        "Scalar? alpha) -> Tensor",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto result = convolution_inverted_residual_run(
+                (std::move(peek(stack, 0, 5))).toTensor(),
+                (std::move(peek(stack, 1, 5)))
+                    .toCustomClass<ConvolutionOpContext>(),
+                (std::move(peek(stack, 2, 5)))
+                    .toCustomClass<ConvolutionOpContext>(),
+                (std::move(peek(stack, 3, 5)))
+                    .toCustomClass<ConvolutionOpContext>(),
+                (std::move(peek(stack, 4, 5))).toOptional<at::Scalar>());
+            drop(stack, 5);
+            torch::jit::pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
+    Operator(
+        "ipex_prepack::convolution_post_ops_run(Tensor input, "
+        "int[] post_op_kinds, float[] post_op_params, "
+        "__torch__.torch.classes.ipex_prepack.ConvolutionOpContext "
+        "W_prepack) -> Tensor",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto result = convolution_post_ops_run(
+                (std::move(peek(stack, 0, 4))).toTensor(),
+                (std::move(peek(stack, 1, 4))).toIntVector(),
+                (std::move(peek(stack, 2, 4))).toDoubleVector(),
+                (std::move(peek(stack, 3, 4)))
+                    .toCustomClass<ConvolutionOpContext>());
+            drop(stack, 4);
+            torch::jit::pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
+    Operator(
+        "ipex_prepack::convolution_sum_post_ops_run(Tensor input, "
+        "Tensor accumu, int[] post_op_kinds, float[] post_op_params, "
+        "__torch__.torch.classes.ipex_prepack.ConvolutionOpContext "
+        "W_prepack) -> Tensor",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto result = convolution_sum_post_ops_run(
+                (std::move(peek(stack, 0, 5))).toTensor(),
+                (std::move(peek(stack, 1, 5))).toTensor(),
+                (std::move(peek(stack, 2, 5))).toIntVector(),
+                (std::move(peek(stack, 3, 5))).toDoubleVector(),
+                (std::move(peek(stack, 4, 5)))
+                    .toCustomClass<ConvolutionOpContext>());
+            drop(stack, 5);
+            torch::jit::pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
     Operator(
         "ipex_prepack::convolution_gelu_run(Tensor input, str approximate, "
         "__torch__.torch.classes.ipex_prepack.ConvolutionOpContext "
@@ -682,6 +744,68 @@ torch::jit::RegisterOperators op({
           };
         },
         aliasAnalysisFromSchema()),
+    Operator(
+        "ipex_prepack::linear_post_ops_run(Tensor input, int[] post_op_kinds, "
+        "float[] post_op_params, "
+        "__torch__.torch.classes.ipex_prepack.LinearOpContext W_prepack) "
+        "-> Tensor",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto result = linear_post_ops_run(
+                (std::move(peek(stack, 0, 4))).toTensor(),
+                {},
+                (std::move(peek(stack, 1, 4))).toIntVector(),
+                (std::move(peek(stack, 2, 4))).toDoubleVector(),
+                (std::move(peek(stack, 3, 4)))
+                    .toCustomClass<LinearOpContext>());
+            drop(stack, 4);
+            torch::jit::pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
+    Operator(
+        "ipex_prepack::linear_binary_post_ops_run(Tensor input, Tensor other, "
+        "int[] post_op_kinds, float[] post_op_params, "
+        "__torch__.torch.classes.ipex_prepack.LinearOpContext W_prepack) "
+        "-> Tensor",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto result = linear_post_ops_run(
+                (std::move(peek(stack, 0, 5))).toTensor(),
+                {(std::move(peek(stack, 1, 5))).toTensor()},
+                (std::move(peek(stack, 2, 5))).toIntVector(),
+                (std::move(peek(stack, 3, 5))).toDoubleVector(),
+                (std::move(peek(stack, 4, 5)))
+                    .toCustomClass<LinearOpContext>());
+            drop(stack, 5);
+            torch::jit::pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
+    Operator(
+        "ipex_prepack::linear_binary2_post_ops_run(Tensor input, "
+        "Tensor other, Tensor other2, int[] post_op_kinds, "
+        "float[] post_op_params, "
+        "__torch__.torch.classes.ipex_prepack.LinearOpContext W_prepack) "
+        "-> Tensor",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto result = linear_post_ops_run(
+                (std::move(peek(stack, 0, 6))).toTensor(),
+                {(std::move(peek(stack, 1, 6))).toTensor(),
+                 (std::move(peek(stack, 2, 6))).toTensor()},
+                (std::move(peek(stack, 3, 6))).toIntVector(),
+                (std::move(peek(stack, 4, 6))).toDoubleVector(),
+                (std::move(peek(stack, 5, 6)))
+                    .toCustomClass<LinearOpContext>());
+            drop(stack, 6);
+            torch::jit::pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
     Operator(
         "ipex_prepack::mkl_sgemm_run(Tensor input, "
         "__torch__.torch.classes.ipex_prepack.MKLOpContext "
@@ -697,6 +821,24 @@ torch::jit::RegisterOperators op({
           };
         },
         aliasAnalysisFromSchema()),
+    Operator(
+        "ipex_prepack::mkl_sgemm_post_ops_run(Tensor input, "
+        "int[] post_op_kinds, float[] post_op_params, "
+        "__torch__.torch.classes.ipex_prepack.MKLOpContext W_prepack) "
+        "-> Tensor",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto result = mkl_sgemm_post_ops_run(
+                (std::move(peek(stack, 0, 4))).toTensor(),
+                (std::move(peek(stack, 1, 4))).toIntVector(),
+                (std::move(peek(stack, 2, 4))).toDoubleVector(),
+                (std::move(peek(stack, 3, 4))).toCustomClass<MKLOpContext>());
+            drop(stack, 4);
+            torch::jit::pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
 
     // ConvTranspose fusion run OP
     CreateConvTransposeUnaryPostOpRun(run),
@@ -1552,6 +1694,19 @@ torch::jit::RegisterOperators op({
           };
         },
         aliasAnalysisFromSchema()),
+    Operator(
+        "ipex::einsum(str equation, Tensor[] tensors) -> Tensor",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto result = einsum_planned(
+                (std::move(peek(stack, 0, 2))).toStringView(),
+                (std::move(peek(stack, 1, 2))).toTensorList());
+            drop(stack, 2);
+            torch::jit::pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
     Operator(
         "ipex::max_pool2d(Tensor input, int[2] kernel_size, int[2] stride, "
         "int[2] padding, int[2] dilation, bool ceil_mode) -> Tensor",
@@ -1,4 +1,11 @@
+#include <c10/util/Exception.h>
+#include <omp.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
 #include <functional>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include "threaded_loops.h"
@@ -404,5 +411,242 @@ std::unordered_map<std::string, par_loop_kernel> pre_defined_loops = {
     {"ACb", par_nested_loops_ACb},
     {"ABCD", par_nested_loops_ABCD},
 };
+
+LoopSchedule getDefaultLoopSchedule() {
+  static const LoopSchedule schedule = [] {
+    const char* env = getenv("TPP_LOOP_SCHEDULE");
+    std::string val = env ? env : "";
+    if (val == "dynamic")
+      return LoopSchedule::Dynamic;
+    if (val == "auto")
+      return LoopSchedule::Auto;
+    if (val != "" && val != "static") {
+      TORCH_WARN_ONCE(
+          "TPP_LOOP_SCHEDULE: unknown schedule '",
+          val,
+          "', expected static, dynamic or auto; using static");
+    }
+    return LoopSchedule::Static;
+  }();
+  return schedule;
+}
+
+DynamicLoopPlan getDynamicLoopPlan(const std::string& scheme) {
+  DynamicLoopPlan plan;
+  bool seen[MAX_LOGICAL_LOOPS] = {false};
+  int parBegin = -1, parEnd = -1;
+  int n = 0;
+  for (char c : scheme) {
+    bool upper = c >= 'A' && c <= 'Z';
+    bool lower = c >= 'a' && c <= 'z';
+    if (!upper && !lower)
+      return plan;
+    int l = upper ? c - 'A' : c - 'a';
+    if (l >= MAX_LOGICAL_LOOPS || seen[l])
+      return plan;
+    seen[l] = true;
+    if (upper) {
+      if (parBegin == -1)
+        parBegin = n;
+      else if (parEnd != n)
+        return plan;
+      parEnd = n + 1;
+    }
+    plan.order[n++] = l;
+  }
+  for (int l = 0; l < n; l++) {
+    if (!seen[l])
+      return plan;
+  }
+  if (parBegin == -1)
+    return plan;
+  plan.nLoops = n;
+  plan.parBegin = parBegin;
+  plan.parEnd = parEnd;
+  plan.valid = true;
+  return plan;
+}
+
+static long loop_trip_count(const LoopSpecs& spec) {
+  if (spec.end <= spec.start)
+    return 0;
+  return (spec.end - spec.start + spec.step - 1) / spec.step;
+}
+
+bool isImbalancedLoop(LoopSpecs* loopSpecs, const DynamicLoopPlan& plan) {
+  long nPar = 1;
+  for (int i = plan.parBegin; i < plan.parEnd; i++)
+    nPar *= loop_trip_count(loopSpecs[plan.order[i]]);
+  if (nPar % omp_get_max_threads() != 0)
+    return true;
+  for (int i = plan.parBegin; i < plan.nLoops; i++) {
+    auto& spec = loopSpecs[plan.order[i]];
+    if ((spec.end - spec.start) % spec.step != 0)
+      return true;
+  }
+  return false;
+}
+
+namespace {
+
+// Remaining parallel iterations [front, back) of one thread, packed in one
+// word so that the owner (taking from the front) and thieves (taking from
+// the back) agree through a single compare-exchange.
+struct alignas(64) StealRange {
+  std::atomic<uint64_t> range{0};
+};
+
+inline uint64_t pack_range(uint64_t front, uint64_t back) {
+  return (back << 32) | front;
+}
+
+inline bool take_front(StealRange& r, long& iter) {
+  uint64_t v = r.range.load(std::memory_order_relaxed);
+  while (true) {
+    uint64_t front = v & 0xffffffff, back = v >> 32;
+    if (front >= back)
+      return false;
+    if (r.range.compare_exchange_weak(
+            v, pack_range(front + 1, back), std::memory_order_acq_rel)) {
+      iter = front;
+      return true;
+    }
+  }
+}
+
+// Steals the back half of the largest range left on another thread.
+inline bool steal_back(
+    StealRange* ranges,
+    int nthr,
+    int tid,
+    uint64_t& begin,
+    uint64_t& end) {
+  while (true) {
+    int victim = -1;
+    uint64_t victim_v = 0, most = 0;
+    for (int i = 1; i < nthr; i++) {
+      int t = (tid + i) % nthr;
+      uint64_t v = ranges[t].range.load(std::memory_order_relaxed);
+      uint64_t front = v & 0xffffffff, back = v >> 32;
+      if (front < back && back - front > most) {
+        most = back - front;
+        victim = t;
+        victim_v = v;
+      }
+    }
+    if (victim == -1)
+      return false;
+    uint64_t front = victim_v & 0xffffffff, back = victim_v >> 32;
+    uint64_t split = back - (most + 1) / 2;
+    if (ranges[victim].range.compare_exchange_strong(
+            victim_v, pack_range(front, split), std::memory_order_acq_rel)) {
+      begin = split;
+      end = back;
+      return true;
+    }
+  }
+}
+
+} // namespace
+
+bool par_nested_loops_dynamic(
+    LoopSpecs* loopSpecs,
+    const DynamicLoopPlan& plan,
+    std::function<void(int*)> body_func,
+    std::function<void()> init_func,
+    std::function<void()> fini_func) {
+  // per outer iteration ranges of all threads, beyond this the static
+  // schedule is used
+  constexpr long kMaxOuterIters = 256;
+  long trips[MAX_LOGICAL_LOOPS];
+  long nOuter = 1, nPar = 1;
+  for (int i = 0; i < plan.nLoops; i++) {
+    auto& spec = loopSpecs[plan.order[i]];
+    if (spec.nBlockingLevels > 0)
+      return false;
+    trips[i] = loop_trip_count(spec);
+    if (i < plan.parBegin)
+      nOuter *= trips[i];
+    else if (i < plan.parEnd)
+      nPar *= trips[i];
+  }
+  if (nOuter > kMaxOuterIters || nPar >= (1L << 32))
+    return false;
+
+  int nthr = omp_get_max_threads();
+  std::unique_ptr<StealRange[]> ranges(new StealRange[nOuter * nthr]);
+  for (long o = 0; o < nOuter; o++) {
+    for (int t = 0; t < nthr; t++) {
+      // same contiguous split as the static schedule
+      uint64_t front = nPar * t / nthr, back = nPar * (t + 1) / nthr;
+      ranges[o * nthr + t].range.store(pack_range(front, back));
+    }
+  }
+
+  // Runs every inner iteration of the flat parallel iteration `p`.
+  auto run_iter = [&](int* ind, long p) {
+    for (int i = plan.parEnd - 1; i >= plan.parBegin; i--) {
+      auto& spec = loopSpecs[plan.order[i]];
+      ind[plan.order[i]] = spec.start + (p % trips[i]) * spec.step;
+      p /= trips[i];
+    }
+    long inner[MAX_LOGICAL_LOOPS] = {0};
+    for (int i = plan.parEnd; i < plan.nLoops; i++) {
+      if (trips[i] == 0)
+        return;
+      ind[plan.order[i]] = loopSpecs[plan.order[i]].start;
+    }
+    while (true) {
+      body_func(ind);
+      int i = plan.nLoops - 1;
+      for (; i >= plan.parEnd; i--) {
+        auto& spec = loopSpecs[plan.order[i]];
+        if (++inner[i] < trips[i]) {
+          ind[plan.order[i]] += spec.step;
+          break;
+        }
+        inner[i] = 0;
+        ind[plan.order[i]] = spec.start;
+      }
+      if (i < plan.parEnd)
+        return;
+    }
+  };
+
+#pragma omp parallel num_threads(nthr)
+  {
+    if (init_func)
+      init_func();
+    int tid = omp_get_thread_num();
+    int ind[MAX_LOGICAL_LOOPS] = {0};
+    for (long o = 0; o < nOuter; o++) {
+      if (o > 0) {
+#pragma omp barrier
+      }
+      long q = o;
+      for (int i = plan.parBegin - 1; i >= 0; i--) {
+        auto& spec = loopSpecs[plan.order[i]];
+        ind[plan.order[i]] = spec.start + (q % trips[i]) * spec.step;
+        q /= trips[i];
+      }
+      auto* outer_ranges = &ranges[o * nthr];
+      auto& own = outer_ranges[tid];
+      while (true) {
+        long p;
+        while (take_front(own, p))
+          run_iter(ind, p);
+        uint64_t begin, end;
+        if (!steal_back(outer_ranges, nthr, tid, begin, end))
+          break;
+        // the own range is empty, so only its owner writes it here
+        own.range.store(pack_range(begin, end), std::memory_order_release);
+      }
+    }
+    if (fini_func)
+      fini_func();
+  }
+  return true;
+}
+
 } // namespace tpp
 } // namespace torch_ipex
\ No newline at end of file
@@ -2,9 +2,11 @@
 #include <ATen/record_function.h>
 #include <aten/TPPGEMM.h>
 #include <torch/all.h>
+#include <algorithm>
 #include <iostream>
 #include <vector>
 #include "tpp/ext_tpp.h"
+#include "tpp/prefetch.h"
 #include "tpp/utils.h"
 #ifndef NO_PARLOOPER
 #include "tpp/threaded_loops.h"
@@ -48,6 +50,15 @@ REGISTER_LOCAL_SCOPE(
 REGISTER_LOCAL_SCOPE(
     tpp_linear_relu_krnl,
     "tpp_linear_relu_krnl"); // linear bias + relu
+REGISTER_LOCAL_SCOPE(
+    tpp_linear_lora_krnl,
+    "tpp_linear_lora_krnl"); // linear bias + LoRA adapters
+REGISTER_LOCAL_SCOPE(
+    tpp_lora_shrink_krnl,
+    "tpp_lora_shrink_krnl"); // LoRA down projection
+REGISTER_LOCAL_SCOPE(
+    tpp_linear_lora_bwd_krnl,
+    "tpp_linear_lora_bwd_krnl"); // LoRA input and adapter gradients
 
 REGISTER_LOCAL_SCOPE(fftkn, "fftkn");
 
@@ -117,6 +128,10 @@ inline void tpp_linear_bias(
   auto in = GetVLAPtr<T>(t_in, {Nc, Hc});
 
   auto wt_V = GetVLAPtr<T>(t_wt_V, {Nc, Hc * Hk});
+  auto wt_prefetch = WeightStreamPrefetch(
+      t_wt_V.data_ptr(), t_wt_V.nbytes(), BS <= GEMV_M_THRESHOLD);
+  auto next_wt_prefetch =
+      NextWeightPrefetch(t_wt.data_ptr(), BS <= GEMV_M_THRESHOLD);
 
   auto bias = GetVLAPtr<T>(t_bias, {Hk});
 
@@ -148,6 +163,7 @@ inline void tpp_linear_bias(
           int nc = ind[0], s1 = ind[1], nk = ind[2];
           auto count = nc + Ncb < Nc ? Ncb : Nc - nc;
           bool is_rem = (s1 + BSb > BS);
+          wt_prefetch(wt_V[nk][nc], count * Hc * Hk * sizeof(T));
           if (!is_rem) {
             if (nc == 0) {
               if (with_bias) {
@@ -170,7 +186,10 @@ inline void tpp_linear_bias(
           }
         },
         [&]() { brgemm_tpp.config(); },
-        [&]() { brgemm_tpp.release(); });
+        [&]() {
+          brgemm_tpp.release();
+          next_wt_prefetch();
+        });
   }
 }
 
@@ -201,6 +220,10 @@ inline void tpp_linear_no_bias(
 
   auto in = GetVLAPtr<T>(t_in, {Nc, Hc});
   auto wt_V = GetVLAPtr<T>(t_wt_V, {Nc, Hc * Hk});
+  auto wt_prefetch = WeightStreamPrefetch(
+      t_wt_V.data_ptr(), t_wt_V.nbytes(), BS <= GEMV_M_THRESHOLD);
+  auto next_wt_prefetch =
+      NextWeightPrefetch(t_wt.data_ptr(), BS <= GEMV_M_THRESHOLD);
   auto out = GetVLAPtr<Tout>(t_out, {Nk, Hk});
 
   auto Ncb = Nc;
@@ -226,6 +249,7 @@ inline void tpp_linear_no_bias(
           int nc = ind[0], s1 = ind[1], nk = ind[2];
           auto count = nc + Ncb < Nc ? Ncb : Nc - nc;
           bool is_rem = (s1 + BSb > BS);
+          wt_prefetch(wt_V[nk][nc], count * Hc * Hk * sizeof(T));
           if (!is_rem) {
             if (nc == 0) {
               zero_tpp(out[s1][nk]);
@@ -240,7 +264,10 @@ inline void tpp_linear_no_bias(
           }
         },
         [&]() { brgemm_tpp.config(); },
-        [&]() { brgemm_tpp.release(); });
+        [&]() {
+          brgemm_tpp.release();
+          next_wt_prefetch();
+        });
   }
 }
 
@@ -272,6 +299,10 @@ inline void tpp_linear_mul(
   auto in = GetVLAPtr<T>(t_in, {Nc, Hc});
   auto in1 = GetVLAPtr<T>(t_in1, {Nk, Hk});
   auto wt_V = GetVLAPtr<T>(t_wt_V, {Nc, Hc * Hk});
+  auto wt_prefetch = WeightStreamPrefetch(
+      t_wt_V.data_ptr(), t_wt_V.nbytes(), BS <= GEMV_M_THRESHOLD);
+  auto next_wt_prefetch =
+      NextWeightPrefetch(t_wt.data_ptr(), BS <= GEMV_M_THRESHOLD);
   auto bias = GetVLAPtr<T>(t_bias, {Hk});
   auto out = GetVLAPtr<T>(t_out, {Nk, Hk});
 
@@ -304,6 +335,7 @@ inline void tpp_linear_mul(
           int nc = ind[0], s1 = ind[1], nk = ind[2];
           auto count = nc + Ncb < Nc ? Ncb : Nc - nc;
           bool is_rem = (s1 + BSb > BS);
+          wt_prefetch(wt_V[nk][nc], count * Hc * Hk * sizeof(T));
           if (!is_rem) {
             if (nc == 0) {
               if (with_bias) {
@@ -332,7 +364,10 @@ inline void tpp_linear_mul(
           }
         },
         [&]() { brgemm_tpp.config(); },
-        [&]() { brgemm_tpp.release(); });
+        [&]() {
+          brgemm_tpp.release();
+          next_wt_prefetch();
+        });
   }
 }
 
@@ -368,6 +403,10 @@ inline void tpp_linear_add_add(
   auto in1 = GetVLAPtr<T>(t_in1, {Nk, Hk});
   auto in2 = GetVLAPtr<T>(t_in2, {Nk, Hk});
   auto wt_V = GetVLAPtr<T>(t_wt_V, {Nc, Hc * Hk});
+  auto wt_prefetch = WeightStreamPrefetch(
+      t_wt_V.data_ptr(), t_wt_V.nbytes(), BS <= GEMV_M_THRESHOLD);
+  auto next_wt_prefetch =
+      NextWeightPrefetch(t_wt.data_ptr(), BS <= GEMV_M_THRESHOLD);
   auto bias = GetVLAPtr<T>(t_bias, {Hk});
   auto out = GetVLAPtr<T>(t_out, {Nk, Hk});
 
@@ -401,6 +440,7 @@ inline void tpp_linear_add_add(
           int nc = ind[0], s1 = ind[1], nk = ind[2];
           auto count = nc + Ncb < Nc ? Ncb : Nc - nc;
           bool is_rem = (s1 + BSb > BS);
+          wt_prefetch(wt_V[nk][nc], count * Hc * Hk * sizeof(T));
           if (!is_rem) {
             if (nc == 0) {
               if (with_bias) {
@@ -431,7 +471,10 @@ inline void tpp_linear_add_add(
           }
         },
         [&]() { brgemm_tpp.config(); },
-        [&]() { brgemm_tpp.release(); });
+        [&]() {
+          brgemm_tpp.release();
+          next_wt_prefetch();
+        });
   }
 }
 
@@ -461,6 +504,10 @@ inline void tpp_linear_gelu(
 
   auto in = GetVLAPtr<T>(t_in, {Nc, Hc});
   auto wt_V = GetVLAPtr<T>(t_wt_V, {Nc, Hc * Hk});
+  auto wt_prefetch = WeightStreamPrefetch(
+      t_wt_V.data_ptr(), t_wt_V.nbytes(), BS <= GEMV_M_THRESHOLD);
+  auto next_wt_prefetch =
+      NextWeightPrefetch(t_wt.data_ptr(), BS <= GEMV_M_THRESHOLD);
   auto bias = GetVLAPtr<T>(t_bias, {Hk});
   auto out = GetVLAPtr<T>(t_out, {Nk, Hk});
 
@@ -492,6 +539,7 @@ inline void tpp_linear_gelu(
           int nc = ind[0], s1 = ind[1], nk = ind[2];
           auto count = nc + Ncb < Nc ? Ncb : Nc - nc;
           bool is_rem = (s1 + BSb > BS);
+          wt_prefetch(wt_V[nk][nc], count * Hc * Hk * sizeof(T));
           if (!is_rem) {
             if (nc == 0) {
               if (with_bias) {
@@ -520,7 +568,10 @@ inline void tpp_linear_gelu(
           }
         },
         [&]() { brgemm_tpp.config(); },
-        [&]() { brgemm_tpp.release(); });
+        [&]() {
+          brgemm_tpp.release();
+          next_wt_prefetch();
+        });
   }
 }
 
@@ -571,6 +622,12 @@ inline void tpp_fused_gate_up_proj(
   auto in = GetVLAPtr<T>(t_in, {Nc, Hc});
   auto wt_gate_V = GetVLAPtr<T>(t_wt_gate_V, {Nc, Hc * Hk});
   auto wt_up_V = GetVLAPtr<T>(t_wt_up_V, {Nc, Hc * Hk});
+  auto wt_gate_prefetch = WeightStreamPrefetch(
+      t_wt_gate_V.data_ptr(), t_wt_gate_V.nbytes(), BS <= GEMV_M_THRESHOLD);
+  auto wt_up_prefetch = WeightStreamPrefetch(
+      t_wt_up_V.data_ptr(), t_wt_up_V.nbytes(), BS <= GEMV_M_THRESHOLD);
+  auto next_wt_prefetch =
+      NextWeightPrefetch(t_wt_up.data_ptr(), BS <= GEMV_M_THRESHOLD);
   auto bias_gate = GetVLAPtr<T>(t_bias_gate, {Hk});
   auto bias_up = GetVLAPtr<T>(t_bias_up, {Hk});
   auto out = GetVLAPtr<T>(t_out, {Nk, Hk});
@@ -608,6 +665,9 @@ inline void tpp_fused_gate_up_proj(
           int nc = ind[0], s1 = ind[1], nk = ind[2];
           auto count = nc + Ncb < Nc ? Ncb : Nc - nc;
           bool is_rem = (s1 + BSb > BS);
+          auto wt_bytes = count * Hc * Hk * sizeof(T);
+          wt_gate_prefetch(wt_gate_V[nk][nc], wt_bytes);
+          wt_up_prefetch(wt_up_V[nk][nc], wt_bytes);
           if (!is_rem) {
             if (nc == 0) {
               if (with_bias_gate) {
@@ -655,7 +715,10 @@ inline void tpp_fused_gate_up_proj(
           }
         },
         [&]() { brgemm_tpp.config(); },
-        [&]() { brgemm_tpp.release(); });
+        [&]() {
+          brgemm_tpp.release();
+          next_wt_prefetch();
+        });
   }
 }
 
@@ -688,6 +751,10 @@ inline void tpp_linear_add(
   auto in = GetVLAPtr<T>(t_in, {Nc, Hc});
   auto in1 = GetVLAPtr<T>(t_in1, {Nk, Hk});
   auto wt_V = GetVLAPtr<T>(t_wt_V, {Nc, Hc * Hk});
+  auto wt_prefetch = WeightStreamPrefetch(
+      t_wt_V.data_ptr(), t_wt_V.nbytes(), BS <= GEMV_M_THRESHOLD);
+  auto next_wt_prefetch =
+      NextWeightPrefetch(t_wt.data_ptr(), BS <= GEMV_M_THRESHOLD);
   auto bias = GetVLAPtr<T>(t_bias, {Hk});
   auto out = GetVLAPtr<T>(t_out, {Nk, Hk});
 
@@ -720,6 +787,7 @@ inline void tpp_linear_add(
           int nc = ind[0], s1 = ind[1], nk = ind[2];
           auto count = nc + Ncb < Nc ? Ncb : Nc - nc;
           bool is_rem = (s1 + BSb > BS);
+          wt_prefetch(wt_V[nk][nc], count * Hc * Hk * sizeof(T));
           if (!is_rem) {
             if (nc == 0) {
               if (with_bias) {
@@ -748,7 +816,10 @@ inline void tpp_linear_add(
           }
         },
         [&]() { brgemm_tpp.config(); },
-        [&]() { brgemm_tpp.release(); });
+        [&]() {
+          brgemm_tpp.release();
+          next_wt_prefetch();
+        });
   }
 }
 
@@ -778,6 +849,10 @@ inline void tpp_linear_silu(
 
   auto in = GetVLAPtr<T>(t_in, {Nc, Hc});
   auto wt_V = GetVLAPtr<T>(t_wt_V, {Nc, Hc * Hk});
+  auto wt_prefetch = WeightStreamPrefetch(
+      t_wt_V.data_ptr(), t_wt_V.nbytes(), BS <= GEMV_M_THRESHOLD);
+  auto next_wt_prefetch =
+      NextWeightPrefetch(t_wt.data_ptr(), BS <= GEMV_M_THRESHOLD);
   auto bias = GetVLAPtr<T>(t_bias, {Hk});
   auto out = GetVLAPtr<T>(t_out, {Nk, Hk});
 
@@ -810,6 +885,7 @@ inline void tpp_linear_silu(
           int nc = ind[0], s1 = ind[1], nk = ind[2];
           auto count = nc + Ncb < Nc ? Ncb : Nc - nc;
           bool is_rem = (s1 + BSb > BS);
+          wt_prefetch(wt_V[nk][nc], count * Hc * Hk * sizeof(T));
           if (!is_rem) {
             if (nc == 0) {
               if (with_bias) {
@@ -838,7 +914,10 @@ inline void tpp_linear_silu(
           }
         },
         [&]() { brgemm_tpp.config(); },
-        [&]() { brgemm_tpp.release(); });
+        [&]() {
+          brgemm_tpp.release();
+          next_wt_prefetch();
+        });
   }
 }
 
@@ -868,6 +947,10 @@ inline void tpp_linear_relu(
 
   auto in = GetVLAPtr<T>(t_in, {Nc, Hc});
   auto wt_V = GetVLAPtr<T>(t_wt_V, {Nc, Hc * Hk});
+  auto wt_prefetch = WeightStreamPrefetch(
+      t_wt_V.data_ptr(), t_wt_V.nbytes(), BS <= GEMV_M_THRESHOLD);
+  auto next_wt_prefetch =
+      NextWeightPrefetch(t_wt.data_ptr(), BS <= GEMV_M_THRESHOLD);
   auto bias = GetVLAPtr<T>(t_bias, {Hk});
   auto out = GetVLAPtr<T>(t_out, {Nk, Hk});
 
@@ -900,6 +983,7 @@ inline void tpp_linear_relu(
           int nc = ind[0], s1 = ind[1], nk = ind[2];
           auto count = nc + Ncb < Nc ? Ncb : Nc - nc;
           bool is_rem = (s1 + BSb > BS);
+          wt_prefetch(wt_V[nk][nc], count * Hc * Hk * sizeof(T));
           if (!is_rem) {
             if (nc == 0) {
               if (with_bias) {
@@ -928,7 +1012,461 @@ inline void tpp_linear_relu(
           }
         },
         [&]() { brgemm_tpp.config(); },
-        [&]() { brgemm_tpp.release(); });
+        [&]() {
+          brgemm_tpp.release();
+          next_wt_prefetch();
+        });
+  }
+}
+
+// LoRA adapters add (scale * x * A) * B to the output of the linear. Several
+// adapters are stacked as A [n_adapters][C][R] and B [n_adapters][R][K], row i
+// of the input uses adapter adapter_idx[i] and none if that is negative. A
+// null adapter_idx applies adapter 0 to every row.
+constexpr long kLoRANoAdapter = -1;
+constexpr long kLoRAMixedAdapters = -2;
+
+// Adapter shared by all rows of each BSb row block, kLoRANoAdapter if none of
+// them has one and kLoRAMixedAdapters if they differ.
+inline std::vector<long> lora_block_adapters(
+    const int64_t* adapter_idx,
+    long BS,
+    long BSb) {
+  long nblocks = (BS + BSb - 1) / BSb;
+  std::vector<long> blk_ad(nblocks, 0);
+  if (adapter_idx == nullptr)
+    return blk_ad;
+  for (long b = 0; b < nblocks; b++) {
+    long s1 = b * BSb;
+    long end = std::min(s1 + BSb, BS);
+    long ad = adapter_idx[s1] < 0 ? kLoRANoAdapter : adapter_idx[s1];
+    for (long i = s1 + 1; i < end; i++) {
+      long ad_i = adapter_idx[i] < 0 ? kLoRANoAdapter : adapter_idx[i];
+      if (ad_i != ad) {
+        ad = kLoRAMixedAdapters;
+        break;
+      }
+    }
+    blk_ad[b] = ad;
+  }
+  return blk_ad;
+}
+
+// [n_adapters][C][R] -> [n_adapters][Nc][Hc][R], VNNI packed for bf16
+inline at::Tensor lora_wt_for_shrink(const at::Tensor& t_a, long Nc, long Hc) {
+  auto n_adapters = t_a.size(0);
+  auto R = t_a.size(2);
+  auto t_a_ = t_a.contiguous().view({n_adapters, Nc, Hc, R});
+  return wt_tensor_for_fwd(n_adapters, R, Nc, Hc, t_a_);
+}
+
+// [n_adapters][R][K] -> [n_adapters][Nk][R][Hk], VNNI packed for bf16
+inline at::Tensor lora_wt_for_expand(const at::Tensor& t_b, long Nk, long Hk) {
+  auto n_adapters = t_b.size(0);
+  auto R = t_b.size(1);
+  auto t_b_ = t_b.reshape({n_adapters, R, Nk, Hk})
+                  .permute({0, 2, 1, 3})
+                  .contiguous()
+                  .view({n_adapters * Nk, 1, R, Hk});
+  return wt_tensor_for_fwd(n_adapters * Nk, Hk, 1, R, t_b_);
+}
+
+// t_xa[i] = scale * t_in[i] * A[adapter of row i], zero for rows without an
+// adapter. Rows of a block sharing one adapter run as a single BRGEMM, mixed
+// blocks fall back to one BRGEMM per row.
+template <typename T>
+inline void tpp_lora_shrink(
+    const at::Tensor& t_in,
+    const at::Tensor& t_a_V,
+    const int64_t* adapter_idx,
+    const std::vector<long>& blk_ad,
+    long BSb,
+    long Nc,
+    long Hc,
+    double scale,
+    at::Tensor& t_xa) {
+  auto BS = t_xa.size(0);
+  auto R = t_xa.size(1);
+  auto C = Nc * Hc;
+  auto rem = BS % BSb;
+  auto t_xa_f = at::empty({BS, R}, at::kFloat);
+
+  auto in = GetVLAPtr<T>(t_in, {C});
+  auto a_V = GetVLAPtr<T>(t_a_V, {Nc * Hc * R});
+  auto xa_f = GetVLAPtr<float>(t_xa_f, {R});
+  auto xa = GetVLAPtr<T>(t_xa, {R});
+
+  auto brgemm_tpp = SCOPEITGEMM(
+      (BrgemmTPP<T, float>(BSb, R, Hc, Hc, Hc * R, C, R, R, 0.0, 0, Nc)));
+  auto brgemm_tpp_rem = SCOPEITGEMM(
+      (BrgemmTPP<T, float>(rem, R, Hc, Hc, Hc * R, C, R, R, 0.0, 0, Nc)));
+  auto brgemm_tpp_row = SCOPEITGEMM(
+      (BrgemmTPP<T, float>(1, R, Hc, Hc, Hc * R, C, R, R, 0.0, 0, Nc)));
+  auto zero_tpp = SCOPEIT(SetZeroTPP<float>(R), EW_ZERO);
+  auto scale_tpp = SCOPEIT((ScaleTPP<float, T>(BSb * R)), EW_SCL);
+  auto scale_tpp_rem = SCOPEIT((ScaleTPP<float, T>(rem * R)), EW_SCL);
+
+  {
+    RECORD_SCOPE(tpp_lora_shrink_krnl, {t_in, t_a_V});
+    long nblocks = blk_ad.size();
+#pragma omp parallel for
+    for (long b = 0; b < nblocks; b++) {
+      long s1 = b * BSb;
+      bool is_rem = (s1 + BSb > BS);
+      long ad = blk_ad[b];
+      if (ad >= 0) {
+        if (!is_rem) {
+          brgemm_tpp(in[s1], a_V[ad], xa_f[s1], Nc);
+        } else {
+          brgemm_tpp_rem(in[s1], a_V[ad], xa_f[s1], Nc);
+        }
+      } else {
+        long end = is_rem ? BS : s1 + BSb;
+        for (long i = s1; i < end; i++) {
+          long ad_i = ad == kLoRANoAdapter ? -1 : adapter_idx[i];
+          if (ad_i >= 0) {
+            brgemm_tpp_row(in[i], a_V[ad_i], xa_f[i], Nc);
+          } else {
+            zero_tpp(xa_f[i]);
+          }
+        }
+      }
+      if (!is_rem) {
+        scale_tpp(xa_f[s1], xa[s1], scale);
+      } else {
+        scale_tpp_rem(xa_f[s1], xa[s1], scale);
+      }
+    }
+  }
+}
+
+template <typename T>
+inline void tpp_linear_lora(
+    const at::Tensor& t_in,
+    const at::Tensor& t_wt,
+    const at::Tensor& t_bias,
+    const at::Tensor& t_lora_a,
+    const at::Tensor& t_lora_b,
+    const at::Tensor& t_adapter_idx,
+    double scale,
+    at::Tensor& t_out) {
+  auto t_wt_ = t_wt;
+  auto in_sizes = t_in.sizes();
+  auto wt_sizes = t_wt_.sizes();
+  auto BS = in_sizes[0] * in_sizes[1];
+  if (BS > FT_OPT_SIZE) { // first token compute
+    if (wt_sizes[3] != 100) {
+      t_wt_ = wt_tensor_for_first_token<T>(t_wt_);
+      wt_sizes = t_wt_.sizes();
+    }
+    large_cache_opt = true;
+  }
+
+  auto C = in_sizes[2];
+
+  auto Nc = wt_sizes[1];
+  auto Hc = C / Nc;
+  auto Nk = wt_sizes[0];
+  auto Hk = wt_sizes[3];
+  auto K = Nk * Hk;
+  auto R = t_lora_a.size(2);
+
+  auto t_wt_V = torch_ipex::tpp::wt_tensor_for_fwd(Nk, Hk, Nc, Hc, t_wt_);
+  auto t_b_V = lora_wt_for_expand(t_lora_b, Nk, Hk);
+
+  auto in = GetVLAPtr<T>(t_in, {Nc, Hc});
+  auto wt_V = GetVLAPtr<T>(t_wt_V, {Nc, Hc * Hk});
+  auto wt_prefetch = WeightStreamPrefetch(
+      t_wt_V.data_ptr(), t_wt_V.nbytes(), BS <= GEMV_M_THRESHOLD);
+  auto next_wt_prefetch =
+      NextWeightPrefetch(t_wt.data_ptr(), BS <= GEMV_M_THRESHOLD);
+  auto bias = GetVLAPtr<T>(t_bias, {Hk});
+  auto b_V = GetVLAPtr<T>(t_b_V, {Nk, R * Hk});
+  auto out = GetVLAPtr<T>(t_out, {Nk, Hk});
+
+  auto Ncb = Nc;
+  auto BSb = 64L;
+  auto rem = BS % 64;
+  if (large_cache_opt)
+    Ncb = NCB_BLOCK_SIZE;
+
+  const int64_t* adapter_idx = t_adapter_idx.numel() > 0
+      ? t_adapter_idx.data_ptr<int64_t>()
+      : nullptr;
+  auto blk_ad = lora_block_adapters(adapter_idx, BS, BSb);
+
+  // The rank R down projection is computed once per row block ahead of the
+  // base GEMM, its up projection is then folded into the last K block of the
+  // base GEMM while the output block is still in cache. The shrink stays a
+  // separate parallel pass because the loop scheme may spread the Nk blocks
+  // of one row block across threads, and every expand of that row block
+  // needs its complete input * A first. This costs one more read of the
+  // input and a BS x R intermediate, against a BS x K one for unfused LoRA.
+  auto t_xa = t_in.new_empty({BS, R});
+  tpp_lora_shrink<T>(
+      t_in,
+      lora_wt_for_shrink(t_lora_a, Nc, Hc),
+      adapter_idx,
+      blk_ad,
+      BSb,
+      Nc,
+      Hc,
+      scale,
+      t_xa);
+  auto xa = GetVLAPtr<T>(t_xa, {R});
+
+  bool with_bias = (t_bias.numel() > 0);
+  auto copy_bias_tpp = SCOPEIT(CpyBiasTPP<T>(BSb, Hk, K), BIAS);
+  auto copy_bias_tpp_rem = SCOPEIT(CpyBiasTPP<T>(rem, Hk, K), BIAS);
+  auto zero_tpp = SCOPEIT(SetZeroTPP<T>(BSb, Hk, K), EW_ZERO);
+  auto zero_tpp_rem = SCOPEIT(SetZeroTPP<T>(rem, Hk, K), EW_ZERO);
+  auto brgemm_tpp = SCOPEITGEMM(
+      (BrgemmTPP<T, T>(BSb, Hk, Hc, Hc, Hk * Hc, C, Hk, K, 1.0, 0, Ncb)));
+  auto brgemm_tpp_rem = SCOPEITGEMM(
+      (BrgemmTPP<T, T>(rem, Hk, Hc, Hc, Hk * Hc, C, Hk, K, 1.0, 0, Ncb)));
+  auto expand_tpp = SCOPEITGEMM(
+      (BrgemmTPP<T, T>(BSb, Hk, R, R * Hk, R * Hk, R, Hk, K, 1.0, 0, 1)));
+  auto expand_tpp_rem = SCOPEITGEMM(
+      (BrgemmTPP<T, T>(rem, Hk, R, R * Hk, R * Hk, R, Hk, K, 1.0, 0, 1)));
+  auto expand_tpp_row = SCOPEITGEMM(
+      (BrgemmTPP<T, T>(1, Hk, R, R * Hk, R * Hk, R, Hk, K, 1.0, 0, 1)));
+
+  // Adds the up projection of rows [s1, s1 + BSb) to output block nk. The
+  // expand kernels set up their own tiles, so the base GEMM tile config is
+  // restored afterwards.
+  auto lora_expand = [&](long s1, long nk, bool is_rem) {
+    long ad = blk_ad[s1 / BSb];
+    if (ad == kLoRANoAdapter)
+      return;
+    if (ad >= 0) {
+      if (!is_rem) {
+        expand_tpp(xa[s1], b_V[ad][nk], out[s1][nk], 1);
+      } else {
+        expand_tpp_rem(xa[s1], b_V[ad][nk], out[s1][nk], 1);
+      }
+    } else {
+      long end = is_rem ? BS : s1 + BSb;
+      for (long i = s1; i < end; i++) {
+        if (adapter_idx[i] >= 0) {
+          expand_tpp_row(xa[i], b_V[adapter_idx[i]][nk], out[i][nk], 1);
+        }
+      }
+    }
+    brgemm_tpp.config();
+  };
+
+  {
+    RECORD_SCOPE(tpp_linear_lora_krnl, {t_in, t_wt_V});
+    auto loop_scheme = large_cache_opt ? GEMM_LOOP_SCHEME : "aCb";
+    auto ogemm_loop = torch_ipex::tpp::ThreadedLoop<3>(
+        {{0, Nc, Ncb, false}, {0L, BS, BSb}, {Nk}}, loop_scheme);
+    ogemm_loop(
+        [&](int* ind) {
+          int nc = ind[0], s1 = ind[1], nk = ind[2];
+          auto count = nc + Ncb < Nc ? Ncb : Nc - nc;
+          bool is_rem = (s1 + BSb > BS);
+          wt_prefetch(wt_V[nk][nc], count * Hc * Hk * sizeof(T));
+          if (!is_rem) {
+            if (nc == 0) {
+              if (with_bias) {
+                copy_bias_tpp(bias[nk], out[s1][nk]);
+              } else {
+                zero_tpp(out[s1][nk]);
+              }
+            }
+            brgemm_tpp(in[s1][nc], wt_V[nk][nc], out[s1][nk], count, true);
+          } else {
+            if (nc == 0) {
+              if (with_bias) {
+                copy_bias_tpp_rem(bias[nk], out[s1][nk]);
+              } else {
+                zero_tpp_rem(out[s1][nk]);
+              }
+            }
+            brgemm_tpp_rem(in[s1][nc], wt_V[nk][nc], out[s1][nk], count, false);
+            brgemm_tpp.config();
+          }
+          if (!(nc + Ncb < Nc)) { // last nc iter
+            lora_expand(s1, nk, is_rem);
+          }
+        },
+        [&]() { brgemm_tpp.config(); },
+        [&]() {
+          brgemm_tpp.release();
+          next_wt_prefetch();
+        });
+  }
+}
+
+// Gradients of tpp_linear_lora for fine-tuning, the base weight and bias are
+// frozen. With g = scale * grad_out * B^T, taken per adapter like A and B:
+//   grad_in = grad_out * W + g * A^T
+//   grad_a = in^T * g
+//   grad_b = (scale * in * A)^T * grad_out
+template <typename T>
+inline void tpp_linear_lora_bwd(
+    const at::Tensor& t_grad_out,
+    const at::Tensor& t_in,
+    const at::Tensor& t_wt,
+    const at::Tensor& t_lora_a,
+    const at::Tensor& t_lora_b,
+    const at::Tensor& t_adapter_idx,
+    double scale,
+    at::Tensor& t_grad_in,
+    at::Tensor& t_grad_a,
+    at::Tensor& t_grad_b) {
+  auto t_wt_ = t_wt;
+  auto in_sizes = t_in.sizes();
+  auto wt_sizes = t_wt_.sizes();
+  auto BS = in_sizes[0] * in_sizes[1];
+  auto C = in_sizes[2];
+
+  auto Nc = wt_sizes[1];
+  auto Hc = C / Nc;
+  auto Nk = wt_sizes[0];
+  auto Hk = wt_sizes[3];
+  auto K = Nk * Hk;
+  auto R = t_lora_a.size(2);
+  auto n_adapters = t_lora_a.size(0);
+
+  auto BSb = 64L;
+  auto rem = BS % 64;
+
+  const int64_t* adapter_idx = t_adapter_idx.numel() > 0
+      ? t_adapter_idx.data_ptr<int64_t>()
+      : nullptr;
+  auto blk_ad = lora_block_adapters(adapter_idx, BS, BSb);
+
+  auto t_xa = t_in.new_empty({BS, R});
+  auto t_g = t_in.new_empty({BS, R});
+  tpp_lora_shrink<T>(
+      t_in,
+      lora_wt_for_shrink(t_lora_a, Nc, Hc),
+      adapter_idx,
+      blk_ad,
+      BSb,
+      Nc,
+      Hc,
+      scale,
+      t_xa);
+  tpp_lora_shrink<T>(
+      t_grad_out,
+      lora_wt_for_shrink(t_lora_b.transpose(1, 2), Nk, Hk),
+      adapter_idx,
+      blk_ad,
+      BSb,
+      Nk,
+      Hk,
+      scale,
+      t_g);
+
+  auto t_wt_TV = wt_tensor_for_bwd_compact(Nk, Hk, Nc, Hc, t_wt_);
+  auto t_at_V = lora_wt_for_expand(t_lora_a.transpose(1, 2), Nc, Hc);
+
+  auto grad_out = GetVLAPtr<T>(t_grad_out, {Nk, Hk});
+  auto wt_TV = GetVLAPtr<T>(t_wt_TV, {Nk, Hk * Hc});
+  auto g = GetVLAPtr<T>(t_g, {R});
+  auto at_V = GetVLAPtr<T>(t_at_V, {Nc, R * Hc});
+  auto grad_in = GetVLAPtr<T>(t_grad_in, {Nc, Hc});
+
+  auto di_gemm_tpp = SCOPEITGEMM(
+      (BrgemmTPP<T, T>(BSb, Hc, Hk, Hk, Hk * Hc, K, Hc, C, 0.0, 0, Nk)));
+  auto di_gemm_tpp_rem = SCOPEITGEMM(
+      (BrgemmTPP<T, T>(rem, Hc, Hk, Hk, Hk * Hc, K, Hc, C, 0.0, 0, Nk)));
+  auto expand_tpp = SCOPEITGEMM(
+      (BrgemmTPP<T, T>(BSb, Hc, R, R * Hc, R * Hc, R, Hc, C, 1.0, 0, 1)));
+  auto expand_tpp_rem = SCOPEITGEMM(
+      (BrgemmTPP<T, T>(rem, Hc, R, R * Hc, R * Hc, R, Hc, C, 1.0, 0, 1)));
+  auto expand_tpp_row = SCOPEITGEMM(
+      (BrgemmTPP<T, T>(1, Hc, R, R * Hc, R * Hc, R, Hc, C, 1.0, 0, 1)));
+
+  {
+    RECORD_SCOPE(tpp_linear_lora_bwd_krnl, {t_grad_out, t_wt_TV});
+    auto di_loop =
+        torch_ipex::tpp::ThreadedLoop<2>({{0L, BS, BSb}, {Nc}}, "AB");
+    di_loop(
+        [&](int* ind) {
+          int s1 = ind[0], nc = ind[1];
+          bool is_rem = (s1 + BSb > BS);
+          if (!is_rem) {
+            di_gemm_tpp(
+                grad_out[s1][0], wt_TV[nc][0], grad_in[s1][nc], Nk, true);
+          } else {
+            di_gemm_tpp_rem(
+                grad_out[s1][0], wt_TV[nc][0], grad_in[s1][nc], Nk, false);
+            di_gemm_tpp.config();
+          }
+          long ad = blk_ad[s1 / BSb];
+          if (ad == kLoRANoAdapter)
+            return;
+          if (ad >= 0) {
+            if (!is_rem) {
+              expand_tpp(g[s1], at_V[ad][nc], grad_in[s1][nc], 1);
+            } else {
+              expand_tpp_rem(g[s1], at_V[ad][nc], grad_in[s1][nc], 1);
+            }
+          } else {
+            long end = is_rem ? BS : s1 + BSb;
+            for (long i = s1; i < end; i++) {
+              if (adapter_idx[i] >= 0) {
+                expand_tpp_row(
+                    g[i], at_V[adapter_idx[i]][nc], grad_in[i][nc], 1);
+              }
+            }
+          }
+          di_gemm_tpp.config();
+        },
+        [&]() { di_gemm_tpp.config(); },
+        [&]() { di_gemm_tpp.release(); });
+  }
+
+  // The adapter gradients reduce over the rows of each adapter. With several
+  // adapters in the batch the rows are grouped by adapter first so that each
+  // one becomes a single GEMM over its segment.
+  auto t_in2 = t_in.view({BS, C});
+  auto t_grad_out2 = t_grad_out.view({BS, K});
+  t_grad_a.zero_();
+  t_grad_b.zero_();
+  if (adapter_idx == nullptr) {
+    auto t_grad_a0 = t_grad_a.select(0, 0);
+    auto t_grad_b0 = t_grad_b.select(0, 0);
+    at::mm_out(t_grad_a0, t_in2.t(), t_g);
+    at::mm_out(t_grad_b0, t_xa.t(), t_grad_out2);
+    return;
+  }
+  std::vector<long> offsets(n_adapters + 1, 0);
+  for (long i = 0; i < BS; i++) {
+    if (adapter_idx[i] >= 0)
+      offsets[adapter_idx[i] + 1]++;
+  }
+  for (long n = 0; n < n_adapters; n++) {
+    offsets[n + 1] += offsets[n];
+  }
+  auto t_order = at::empty({offsets[n_adapters]}, at::kLong);
+  auto order = t_order.data_ptr<int64_t>();
+  auto pos = offsets;
+  for (long i = 0; i < BS; i++) {
+    if (adapter_idx[i] >= 0)
+      order[pos[adapter_idx[i]]++] = i;
+  }
+  auto t_in_s = t_in2.index_select(0, t_order);
+  auto t_grad_out_s = t_grad_out2.index_select(0, t_order);
+  auto t_g_s = t_g.index_select(0, t_order);
+  auto t_xa_s = t_xa.index_select(0, t_order);
+  for (long n = 0; n < n_adapters; n++) {
+    auto len = offsets[n + 1] - offsets[n];
+    if (len == 0)
+      continue;
+    auto t_grad_a_n = t_grad_a.select(0, n);
+    auto t_grad_b_n = t_grad_b.select(0, n);
+    at::mm_out(
+        t_grad_a_n,
+        t_in_s.narrow(0, offsets[n], len).t(),
+        t_g_s.narrow(0, offsets[n], len));
+    at::mm_out(
+        t_grad_b_n,
+        t_xa_s.narrow(0, offsets[n], len).t(),
+        t_grad_out_s.narrow(0, offsets[n], len));
   }
 }
 
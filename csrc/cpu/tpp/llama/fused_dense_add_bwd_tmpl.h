@@ -0,0 +1,20 @@
+RECORD_FUNCTION("llama_bwd", std::vector<c10::IValue>());
+auto in_sizes = t_in.sizes();
+auto wt_sizes = t_wt.sizes();
+auto S1 = in_sizes[0];
+auto Nc = in_sizes[1];
+auto S2 = in_sizes[2];
+auto Hc = in_sizes[3];
+
+auto Nk = wt_sizes[0];
+auto Hk = wt_sizes[3];
+
+// The residual gradient is grad_out itself and is returned by the caller,
+// only the projection needs a backward pass here.
+auto t_grad_y = t_grad_out.contiguous();
+auto t_grad_y_V = t_grad_y;
+if (t_grad_y.dtype() == at::kBFloat16) {
+  t_grad_y_V = act_tensor_n2v_compact(S1, Nk, S2, Hk, t_grad_y);
+}
+#include "fused_dense_bwd_gemm_tmpl.h"
+return std::vector<at::Tensor>({t_grad_in, t_grad_wt});
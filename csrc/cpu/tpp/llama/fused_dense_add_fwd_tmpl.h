@@ -0,0 +1,53 @@
+RECORD_FUNCTION("llama_fwd", std::vector<c10::IValue>());
+auto in_sizes = t_in.sizes();
+auto wt_sizes = t_wt.sizes();
+auto S1 = in_sizes[0];
+auto Nc = in_sizes[1];
+auto S2 = in_sizes[2];
+auto Hc = in_sizes[3];
+
+auto Nk = wt_sizes[0];
+auto Hk = wt_sizes[3];
+
+auto t_wt_V = wt_tensor_for_fwd(Nk, Hk, Nc, Hc, t_wt);
+
+auto t_out = t_in.new_empty({S1, Nk, S2, Hk});
+
+auto Ncb = Nc;
+if (Nc > Nk && Nc % Nk == 0) {
+  Ncb = Nk;
+}
+// Create TPPs
+auto copy_tpp = SCOPEIT(CpyTPP<T>(S2 * Hk), EW_COPY);
+auto brgemm_tpp = SCOPEITGEMM((BrgemmExtTPP<T, T>(
+    S2,
+    Hk,
+    Hc,
+    S2* Hc,
+    Hk* Hc,
+    1.0,
+    XformTPP::XFORM_NONE_TPP,
+    0,
+    Ncb)));
+
+{
+  RECORD_SCOPE(lo_gemm, {t_in, t_wt_V});
+  auto gemm_loop = ThreadedLoop<3>(
+      {LoopSpecs{0, Nc, Ncb, false}, LoopSpecs{S1}, LoopSpecs{Nk}}, "acB");
+  gemm_loop(
+      [&](int* ind) {
+        int nc = ind[0], s1 = ind[1], nk = ind[2];
+        DECL_VLA_PTR_PT(T, in, [Nc][S2 * Hc], t_in);
+        DECL_VLA_PTR_PT(T, in2, [Nk][S2 * Hk], t_in2);
+        DECL_VLA_PTR_PT(T, wt_V, [Nc][Hc * Hk], t_wt_V);
+        DECL_VLA_PTR_PT(T, out, [Nk][S2 * Hk], t_out);
+        // The residual seeds the accumulator so the add costs no extra pass
+        if (nc == 0) {
+          copy_tpp(in2[s1][nk], out[s1][nk]);
+        }
+        brgemm_tpp(in[s1][nc], wt_V[nk][nc], out[s1][nk], Ncb, true);
+      },
+      [&]() { brgemm_tpp.config(); },
+      [&]() { brgemm_tpp.release(); });
+}
+return std::vector<at::Tensor>({t_out});
@@ -0,0 +1,110 @@
+// Shared input / weight gradient GEMMs of a blocked linear layer.
+// Expects t_in [S1][Nc][S2][Hc], t_wt, the output gradient t_grad_y
+// [S1][Nk][S2][Hk] and its VNNI form t_grad_y_V, and defines t_grad_in and
+// t_grad_wt.
+const auto grad_wt_flag =
+    (t_wt.dim() == 5 ? XformTPP::XFORM_N2V_TPP : XformTPP::XFORM_NONE_TPP);
+const auto input_trans_flag =
+    (t_in.dtype() == at::kFloat ? XformTPP::XFORM_XPOSE_TPP
+                                : XformTPP::XFORM_NONE_TPP);
+auto t_wt_TV = wt_tensor_for_bwd_compact(Nk, Hk, Nc, Hc, t_wt);
+
+auto t_in_T = t_in;
+if (input_trans_flag == XformTPP::XFORM_NONE_TPP) {
+  t_in_T = act_tensor_trans_compact(S1, Nc, S2, Hc, t_in);
+}
+auto in_blk = LToPBlockAccessMapper<T>(S1, Nc);
+auto gdout_blk = LToPBlockAccessMapper<T>(S1, Nk);
+
+auto t_grad_in = at::empty_like(t_in);
+auto t_grad_wt = at::empty_like(t_wt);
+
+constexpr int64_t BS = 8;
+auto Nkb = Nk;
+if (Nk > Nc && Nk % Nc == 0) {
+  Nkb = Nc;
+}
+
+auto di_gemm_b0_tpp = SCOPEITGEMM((BrgemmExtTPP<T, T>(
+    S2,
+    Hc,
+    Hk,
+    S2* Hk,
+    Hk* Hc,
+    0.0,
+    XformTPP::XFORM_NONE_TPP,
+    0,
+    Nkb)));
+auto di_gemm_b1_tpp = SCOPEITGEMM((BrgemmExtTPP<T, T>(
+    S2,
+    Hc,
+    Hk,
+    S2* Hk,
+    Hk* Hc,
+    1.0,
+    XformTPP::XFORM_NONE_TPP,
+    0,
+    Nkb)));
+auto dw_set_zero_tpp = SCOPEIT(SetZeroTPP<T>(Hk * Hc), EW_ZERO);
+auto dw_cpy_tpp = SCOPEIT(CpyTPP<T>(Hk * Hc), VNNI);
+auto dw_n2v_tpp =
+    SCOPEIT(XformExtTPP<T>(Hc, Hk, XformTPP::XFORM_N2V_TPP, true), VNNI);
+auto dw_gemm_tpp = SCOPEITGEMM((BrgemmExtTPP<T, T>(
+    Hc,
+    Hk,
+    S2,
+    input_trans_flag == XformTPP::XFORM_NONE_TPP ? S2 * Hc : Nc * S2 * Hc,
+    input_trans_flag == XformTPP::XFORM_NONE_TPP ? S2 * Hk : Nk * S2 * Hk,
+    1.0,
+    XformTPP::XFORM_NONE_TPP,
+    input_trans_flag,
+    BS)));
+{
+  RECORD_SCOPE(di_gemm, {t_grad_y, t_wt_TV});
+  auto di_loop = ThreadedLoop<3>(
+      {LoopSpecs{0, Nk, Nkb, false}, LoopSpecs{S1}, LoopSpecs{Nc}}, "acB");
+  di_loop(
+      [&](int* ind) {
+        int nk = ind[0], s1 = ind[1], nc = ind[2];
+        DECL_VLA_PTR_PT(T, grad_y, [Nk][S2 * Hk], t_grad_y);
+        DECL_VLA_PTR_PT(T, wt_TV, [Nk][Hk * Hc], t_wt_TV);
+        DECL_VLA_PTR_PT(T, grad_in, [Nc][S2 * Hc], t_grad_in);
+        if (nk == 0)
+          di_gemm_b0_tpp(
+              grad_y[s1][nk], wt_TV[nc][nk], grad_in[s1][nc], Nkb, true);
+        else
+          di_gemm_b1_tpp(
+              grad_y[s1][nk], wt_TV[nc][nk], grad_in[s1][nc], Nkb, true);
+      },
+      [&]() { di_gemm_b0_tpp.config(); },
+      [&]() { di_gemm_b0_tpp.release(); });
+}
+{
+  RECORD_SCOPE(dw_gemm, {t_in_T, t_grad_y_V});
+  auto dw_loop = ThreadedLoop<3>(
+      {LoopSpecs{0, S1, BS, true}, LoopSpecs{Nk}, LoopSpecs{Nc}}, "aBC");
+  dw_loop(
+      [&](int* ind) {
+        int s1 = ind[0], nk = ind[1], nc = ind[2];
+        int count = (s1 + BS <= S1 ? BS : S1 - s1);
+        DECL_VLA_PTR_PT(T, grad_wt, [Nc][Hc * Hk], t_grad_wt);
+        DECL_VLA_PTR_PT(T, in_T, [Hc * S2], t_in_T);
+        DECL_VLA_PTR_PT(T, grad_y_V, [S2 * Hk], t_grad_y_V);
+        if (s1 == 0)
+          dw_set_zero_tpp(grad_wt[nk][nc]);
+        dw_gemm_tpp(
+            in_T[in_blk(s1, nc)],
+            grad_y_V[gdout_blk(s1, nk)],
+            grad_wt[nk][nc],
+            count,
+            true);
+        bool is_last_iter = !(s1 + BS < S1);
+        if (grad_wt_flag != XformTPP::XFORM_NONE_TPP && is_last_iter) {
+          T tmp[Hc * Hk];
+          dw_cpy_tpp(grad_wt[nk][nc], tmp);
+          dw_n2v_tpp(tmp, grad_wt[nk][nc]);
+        }
+      },
+      [&]() { dw_gemm_tpp.config(); },
+      [&]() { dw_gemm_tpp.release(); });
+}
@@ -0,0 +1,49 @@
+RECORD_FUNCTION("llama_bwd", std::vector<c10::IValue>());
+auto in_sizes = t_in.sizes();
+auto wt_sizes = t_wt.sizes();
+auto S1 = in_sizes[0];
+auto Nc = in_sizes[1];
+auto S2 = in_sizes[2];
+auto Hc = in_sizes[3];
+
+auto Nk = wt_sizes[0];
+auto Hk = wt_sizes[3];
+auto Nf = Nk / 2;
+
+auto t_grad_y = t_y.new_empty({S1, Nk, S2, Hk});
+auto t_grad_y_V = t_grad_y;
+if (t_grad_y.dtype() == at::kBFloat16) {
+  t_grad_y_V = t_grad_y.new_empty({Nk, S1, S2 / 2, Hk, 2});
+}
+auto gy_blk = LToPBlockAccessMapper<T>(S1, Nk);
+
+auto swiglu_bwd_tpp = SCOPEIT(SwiGLUBwdTPP<T>(S2 * Hk), ACT);
+auto n2v_tpp =
+    SCOPEIT(XformExtTPP<T>(S2, Hk, XformTPP::XFORM_N2V_TPP, true), VNNI);
+{
+  RECORD_SCOPE(dswiglu, {t_grad_out, t_y});
+  DECL_VLA_PTR_PT(T, grad_out, [Nf][S2 * Hk], t_grad_out);
+  DECL_VLA_PTR_PT(T, y, [Nk][S2 * Hk], t_y);
+  DECL_VLA_PTR_PT(T, grad_y, [Nk][S2 * Hk], t_grad_y);
+  DECL_VLA_PTR_PT(T, grad_y_V, [S2 * Hk], t_grad_y_V);
+  {
+    RECORD_FUNCTION("parallel_for", std::vector<c10::IValue>());
+#pragma omp parallel for collapse(2)
+    for (int s1 = 0; s1 < S1; s1++) {
+      for (int nf = 0; nf < Nf; nf++) {
+        swiglu_bwd_tpp(
+            grad_out[s1][nf],
+            y[s1][nf],
+            y[s1][Nf + nf],
+            grad_y[s1][nf],
+            grad_y[s1][Nf + nf]);
+        if (t_grad_y.dtype() == at::kBFloat16) {
+          n2v_tpp(grad_y[s1][nf], grad_y_V[gy_blk(s1, nf)]);
+          n2v_tpp(grad_y[s1][Nf + nf], grad_y_V[gy_blk(s1, Nf + nf)]);
+        }
+      }
+    }
+  }
+}
+#include "fused_dense_bwd_gemm_tmpl.h"
+return std::vector<at::Tensor>({t_grad_in, t_grad_wt});
@@ -0,0 +1,69 @@
+RECORD_FUNCTION("llama_fwd", std::vector<c10::IValue>());
+// t_wt packs gate_proj and up_proj: [2 * Nf][Nc][Hc][Hk], the first Nf
+// output blocks are the gate, the last Nf blocks are up.
+auto in_sizes = t_in.sizes();
+auto wt_sizes = t_wt.sizes();
+auto S1 = in_sizes[0];
+auto Nc = in_sizes[1];
+auto S2 = in_sizes[2];
+auto Hc = in_sizes[3];
+
+auto Nk = wt_sizes[0];
+auto Hk = wt_sizes[3];
+PCL_ASSERT(Nk % 2 == 0, "gate and up blocks do not match\n");
+auto Nf = Nk / 2;
+
+auto t_wt_V = wt_tensor_for_fwd(Nk, Hk, Nc, Hc, t_wt);
+
+auto t_y = t_in.new_empty({S1, Nk, S2, Hk}); // Saved For BWD
+auto t_out = t_in.new_empty({S1, Nf, S2, Hk});
+
+auto Ncb = Nc;
+if (Nc > Nf && Nc % Nf == 0) {
+  Ncb = Nf;
+}
+// Create TPPs
+auto set_zero_tpp = SCOPEIT(SetZeroTPP<T>(S2 * Hk), EW_ZERO);
+auto brgemm_tpp = SCOPEITGEMM((BrgemmExtTPP<T, T>(
+    S2,
+    Hk,
+    Hc,
+    S2* Hc,
+    Hk* Hc,
+    1.0,
+    XformTPP::XFORM_NONE_TPP,
+    0,
+    Ncb)));
+auto swiglu_fwd_tpp = SCOPEIT(SwiGLUFwdTPP<T>(S2 * Hk), ACT);
+
+{
+  RECORD_SCOPE(gu_gemm, {t_in, t_wt_V});
+  auto gemm_loop = ThreadedLoop<3>(
+      {LoopSpecs{0, Nc, Ncb, false}, LoopSpecs{S1}, LoopSpecs{Nf}}, "acB");
+  gemm_loop(
+      [&](int* ind) {
+        int nc = ind[0], s1 = ind[1], nf = ind[2];
+        DECL_VLA_PTR_PT(T, in, [Nc][S2 * Hc], t_in);
+        DECL_VLA_PTR_PT(T, wt_V, [Nc][Hc * Hk], t_wt_V);
+        DECL_VLA_PTR_PT(T, y, [Nk][S2 * Hk], t_y);
+        DECL_VLA_PTR_PT(T, out, [Nf][S2 * Hk], t_out);
+
+        // gate and up of the same block run on one thread so the gating
+        // can be applied as soon as the last input block is accumulated
+        if (nc == 0) {
+          set_zero_tpp(y[s1][nf]);
+          set_zero_tpp(y[s1][Nf + nf]);
+        }
+        brgemm_tpp(in[s1][nc], wt_V[nf][nc], y[s1][nf], Ncb, true);
+        brgemm_tpp(in[s1][nc], wt_V[Nf + nf][nc], y[s1][Nf + nf], Ncb, true);
+        if (nc == Nc - Ncb) { // last iter
+          swiglu_fwd_tpp(y[s1][nf], y[s1][Nf + nf], out[s1][nf]);
+        }
+      },
+      [&]() { brgemm_tpp.config(); },
+      [&]() { brgemm_tpp.release(); });
+}
+if (!training) {
+  t_y = at::Tensor();
+}
+return std::vector<at::Tensor>({t_out, t_y});
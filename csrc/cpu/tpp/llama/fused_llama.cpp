@@ -0,0 +1,230 @@
+
+#include <ATen/record_function.h>
+
+#include <dyndisp/DispatchStub.h>
+#include <torch/all.h>
+#include <iostream>
+#include <vector>
+#include "ext_tpp.h"
+#include "tensor_helper.h"
+#include "threaded_loops.h"
+#include "timing.h"
+#include "xsmm_functors.h"
+
+namespace torch_ipex {
+namespace tpp {
+
+static int my_rank = guess_mpi_rank();
+
+REGISTER_LOCAL_SCOPE(rms_norm, "rms_norm");
+REGISTER_LOCAL_SCOPE(lq_gemm, "lq_gemm");
+REGISTER_LOCAL_SCOPE(lk_gemm, "lk_gemm");
+REGISTER_LOCAL_SCOPE(lv_gemm, "lv_gemm");
+REGISTER_LOCAL_SCOPE(lac_gemm, "lac_gemm");
+REGISTER_LOCAL_SCOPE(lo_gemm, "lo_gemm");
+REGISTER_LOCAL_SCOPE(gu_gemm, "gu_gemm");
+
+REGISTER_LOCAL_SCOPE(drms_norm, "drms_norm");
+REGISTER_LOCAL_SCOPE(dswiglu, "dswiglu");
+REGISTER_LOCAL_SCOPE(di_gemm, "di_gemm");
+REGISTER_LOCAL_SCOPE(dw_gemm, "dw_gemm");
+REGISTER_LOCAL_SCOPE(ldac_gemm, "ldac_gemm");
+REGISTER_LOCAL_SCOPE(dkv_red, "dkv_red");
+REGISTER_LOCAL_SCOPE(ldiq_gemm, "ldiq_gemm");
+REGISTER_LOCAL_SCOPE(ldik_gemm, "ldik_gemm");
+REGISTER_LOCAL_SCOPE(ldiv_gemm, "ldiv_gemm");
+REGISTER_LOCAL_SCOPE(ldwqkv_gemm, "ldwqkv_gemm");
+
+template <typename T>
+inline void omp_reduce_buf(
+    int num_threads,
+    int N,
+    float** ptrs,
+    T* buf,
+    bool accumulate = false) {
+  ScopedTimer _t(EW_RED);
+#pragma omp for
+  for (int i = 0; i < N; i++) {
+    float sum = 0.0;
+    for (int j = 0; j < num_threads; j++) {
+      sum += ptrs[j][i];
+    }
+    if (accumulate) {
+      buf[i] += sum;
+    } else {
+      buf[i] = sum;
+    }
+  }
+}
+
+static std::vector<at::Tensor> fused_rmsnorm_fwd_unpad(
+    double eps,
+    at::Tensor t_in,
+    at::Tensor t_gamma) {
+  GlobalPass _gp(FWD);
+  if (t_in.dtype() == at::kFloat) {
+    typedef float T;
+#include "fused_rmsnorm_fwd_tmpl.h"
+  } else {
+    typedef bfloat16 T;
+#include "fused_rmsnorm_fwd_tmpl.h"
+  }
+}
+
+static std::vector<at::Tensor> fused_rmsnorm_bwd_unpad(
+    at::Tensor t_grad_out,
+    at::Tensor t_in,
+    at::Tensor t_gamma,
+    at::Tensor t_rstd) {
+  GlobalPass _gp(BWD);
+  if (t_grad_out.dtype() == at::kFloat) {
+    typedef float T;
+#include "fused_rmsnorm_bwd_tmpl.h"
+  } else {
+    typedef bfloat16 T;
+#include "fused_rmsnorm_bwd_tmpl.h"
+  }
+}
+
+static std::vector<at::Tensor> fused_llama_attention_fwd_unpad(
+    std::vector<at::Tensor> inputs,
+    bool training) {
+  GlobalPass _gp(FWD);
+  if (inputs[3].dtype() == at::kFloat) {
+    typedef float T;
+#include "fused_llama_attention_fwd_tmpl.h"
+  } else {
+    typedef bfloat16 T;
+#include "fused_llama_attention_fwd_tmpl.h"
+  }
+}
+
+static std::vector<at::Tensor> fused_llama_attention_bwd_unpad(
+    std::vector<at::Tensor> inputs) {
+  GlobalPass _gp(BWD);
+  if (inputs[0].dtype() == at::kFloat) {
+    typedef float T;
+#include "fused_llama_attention_bwd_tmpl.h"
+  } else {
+    typedef bfloat16 T;
+#include "fused_llama_attention_bwd_tmpl.h"
+  }
+}
+
+static std::vector<at::Tensor> fused_dense_add_fwd_unpad(
+    at::Tensor t_in,
+    at::Tensor t_in2,
+    at::Tensor t_wt) {
+  GlobalPass _gp(FWD);
+  if (t_in.dtype() == at::kFloat) {
+    typedef float T;
+#include "fused_dense_add_fwd_tmpl.h"
+  } else {
+    typedef bfloat16 T;
+#include "fused_dense_add_fwd_tmpl.h"
+  }
+}
+
+static std::vector<at::Tensor> fused_dense_add_bwd_unpad(
+    at::Tensor t_grad_out,
+    at::Tensor t_in,
+    at::Tensor t_wt) {
+  GlobalPass _gp(BWD);
+  if (t_grad_out.dtype() == at::kFloat) {
+    typedef float T;
+#include "fused_dense_add_bwd_tmpl.h"
+  } else {
+    typedef bfloat16 T;
+#include "fused_dense_add_bwd_tmpl.h"
+  }
+}
+
+static std::vector<at::Tensor> fused_dense_swiglu_fwd_unpad(
+    at::Tensor t_in,
+    at::Tensor t_wt,
+    bool training) {
+  GlobalPass _gp(FWD);
+  if (t_in.dtype() == at::kFloat) {
+    typedef float T;
+#include "fused_dense_swiglu_fwd_tmpl.h"
+  } else {
+    typedef bfloat16 T;
+#include "fused_dense_swiglu_fwd_tmpl.h"
+  }
+}
+
+static std::vector<at::Tensor> fused_dense_swiglu_bwd_unpad(
+    at::Tensor t_grad_out,
+    at::Tensor t_y,
+    at::Tensor t_in,
+    at::Tensor t_wt) {
+  GlobalPass _gp(BWD);
+  if (t_grad_out.dtype() == at::kFloat) {
+    typedef float T;
+#include "fused_dense_swiglu_bwd_tmpl.h"
+  } else {
+    typedef bfloat16 T;
+#include "fused_dense_swiglu_bwd_tmpl.h"
+  }
+}
+} // namespace tpp
+} // namespace torch_ipex
+namespace {
+TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
+  m.def(
+      torch::schema(
+          "torch_ipex::fused_rmsnorm_fwd_unpad(float eps, Tensor t_in, "
+          "Tensor t_gamma) -> Tensor[]",
+          c10::AliasAnalysisKind::PURE_FUNCTION),
+      torch_ipex::tpp::fused_rmsnorm_fwd_unpad);
+
+  m.def(
+      torch::schema(
+          "torch_ipex::fused_rmsnorm_bwd_unpad(Tensor t_grad_out, Tensor t_in, "
+          "Tensor t_gamma, Tensor t_rstd) -> Tensor[]",
+          c10::AliasAnalysisKind::PURE_FUNCTION),
+      torch_ipex::tpp::fused_rmsnorm_bwd_unpad);
+
+  m.def(
+      torch::schema(
+          "torch_ipex::fused_llama_attention_fwd_unpad(Tensor[] inputs, "
+          "bool training) -> Tensor[]",
+          c10::AliasAnalysisKind::PURE_FUNCTION),
+      torch_ipex::tpp::fused_llama_attention_fwd_unpad);
+
+  m.def(
+      torch::schema(
+          "torch_ipex::fused_llama_attention_bwd_unpad(Tensor[] inputs) -> "
+          "Tensor[]",
+          c10::AliasAnalysisKind::PURE_FUNCTION),
+      torch_ipex::tpp::fused_llama_attention_bwd_unpad);
+
+  m.def(
+      torch::schema(
+          "torch_ipex::fused_dense_add_fwd_unpad(Tensor t_in, Tensor t_in2, "
+          "Tensor t_wt) -> Tensor[]",
+          c10::AliasAnalysisKind::PURE_FUNCTION),
+      torch_ipex::tpp::fused_dense_add_fwd_unpad);
+
+  m.def(
+      torch::schema(
+          "torch_ipex::fused_dense_add_bwd_unpad(Tensor t_grad_out, "
+          "Tensor t_in, Tensor t_wt) -> Tensor[]",
+          c10::AliasAnalysisKind::PURE_FUNCTION),
+      torch_ipex::tpp::fused_dense_add_bwd_unpad);
+
+  m.def(
+      torch::schema(
+          "torch_ipex::fused_dense_swiglu_fwd_unpad(Tensor t_in, Tensor t_wt, "
+          "bool training) -> Tensor[]",
+          c10::AliasAnalysisKind::PURE_FUNCTION),
+      torch_ipex::tpp::fused_dense_swiglu_fwd_unpad);
+
+  m.def(
+      torch::schema(
+          "torch_ipex::fused_dense_swiglu_bwd_unpad(Tensor t_grad_out, "
+          "Tensor t_y, Tensor t_in, Tensor t_wt) -> Tensor[]",
+          c10::AliasAnalysisKind::PURE_FUNCTION),
+      torch_ipex::tpp::fused_dense_swiglu_bwd_unpad);
+}
+} // namespace
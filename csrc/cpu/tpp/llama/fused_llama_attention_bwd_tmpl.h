@@ -0,0 +1,342 @@
+RECORD_FUNCTION("llama_bwd", std::vector<c10::IValue>());
+int i = 0;
+auto t_dCL = inputs[i++];
+auto t_Wq = inputs[i++]; // [N][N][H][H]
+auto t_Wk = inputs[i++]; // [Nkv][N][H][H]
+auto t_Wv = inputs[i++]; // [Nkv][N][H][H]
+auto t_HS_T = inputs[i++];
+auto t_QL_T = inputs[i++];
+auto t_KL_V = inputs[i++];
+auto t_VL_TV = inputs[i++];
+auto t_AP = inputs[i++];
+auto t_AP_T = inputs[i++];
+auto t_cos = inputs[i++]; // [S1 * S2][H], float
+auto t_sin = inputs[i++]; // [S1 * S2][H], float
+auto t_offs = inputs[i++]; // [B+1]
+auto t_offs2 = inputs[i++]; // [B+1]
+
+int64_t B = t_offs.sizes()[0] - 1;
+int64_t SS1 = t_offs2[B].item().to<int64_t>();
+auto sizes = t_dCL.sizes();
+auto S1 = sizes[0];
+int64_t N = sizes[1];
+auto S2 = sizes[2];
+int64_t H = sizes[3];
+int64_t Nkv = t_Wk.sizes()[0];
+int64_t G = N / Nkv;
+float one_by_sqrt_H = 1.0 / sqrt(H);
+constexpr int64_t BS = 8;
+bool dt_bf16 = (t_dCL.dtype() == at::kBFloat16);
+
+auto t_dQL = t_QL_T.new_empty({S1, N, S2, H});
+auto t_dQL_V = t_dQL;
+// Key / value gradients are first produced per query head and then summed
+// over the G query heads that share a key / value head.
+auto t_dKL_h = t_QL_T.new_empty({S1, N, S2, H});
+auto t_dVL_h = t_QL_T.new_empty({S1, N, S2, H});
+auto t_dKL = t_QL_T.new_empty({S1, Nkv, S2, H});
+auto t_dKL_V = t_dKL;
+auto t_dVL = t_QL_T.new_empty({S1, Nkv, S2, H});
+auto t_dVL_V = t_dVL;
+
+auto t_dWq = t_QL_T.new_empty({N, N, H, H});
+auto t_dWk = t_QL_T.new_empty({Nkv, N, H, H});
+auto t_dWv = t_QL_T.new_empty({Nkv, N, H, H});
+
+auto t_dHS = t_QL_T.new_empty({S1, N, S2, H});
+auto t_dAPD_V = t_AP.new_empty({N, SS1, S2, S2});
+
+auto t_dCL_V = t_dCL;
+if (dt_bf16) {
+  t_dQL_V = t_QL_T.new_empty({N, S1, S2 / 2, H, 2});
+  t_dKL_V = t_KL_V.new_empty({Nkv, S1, S2 / 2, H, 2});
+  t_dVL_V = t_VL_TV.new_empty({Nkv, S1, S2 / 2, H, 2});
+  t_dCL_V = act_tensor_n2v_compact(S1, N, S2, H, t_dCL);
+}
+auto atrans_blk = LToPBlockAccessMapper<T>(S1, N);
+auto kv_blk = LToPBlockAccessMapper<T>(S1, Nkv);
+const auto grad_wt_flag =
+    (t_Wq.dim() == 5 ? XformTPP::XFORM_N2V_TPP : XformTPP::XFORM_NONE_TPP);
+const auto a_trans_flag =
+    (dt_bf16 ? XformTPP::XFORM_NONE_TPP : XformTPP::XFORM_XPOSE_TPP);
+if (grad_wt_flag == XformTPP::XFORM_N2V_TPP) {
+  t_dWq = t_dWq.view({N, N, H / 2, H, 2});
+  t_dWk = t_dWk.view({Nkv, N, H / 2, H, 2});
+  t_dWv = t_dWv.view({Nkv, N, H / 2, H, 2});
+  t_dAPD_V = t_dAPD_V.view({N, SS1, S2 / 2, S2, 2});
+}
+auto t_Wq_TV = wt_tensor_for_bwd_compact(N, H, N, H, t_Wq);
+auto t_Wk_TV = wt_tensor_for_bwd_compact(Nkv, H, N, H, t_Wk);
+auto t_Wv_TV = wt_tensor_for_bwd_compact(Nkv, H, N, H, t_Wv);
+
+{
+  DECL_VLA_PTR_PT(T, QL_T, [H * S2], t_QL_T);
+  DECL_VLA_PTR_PT(T, KL_V, [Nkv][S2 * H], t_KL_V);
+  DECL_VLA_PTR_PT(T, VL_TV, [Nkv][H * S2], t_VL_TV);
+  DECL_VLA_PTR_PT(T, dQL, [N][S2 * H], t_dQL);
+  DECL_VLA_PTR_PT(T, dQL_V, [S2 * H], t_dQL_V);
+  DECL_VLA_PTR_PT(T, dKL_h, [N][S2 * H], t_dKL_h);
+  DECL_VLA_PTR_PT(T, dVL_h, [N][S2 * H], t_dVL_h);
+  DECL_VLA_PTR_PT(T, dKL, [Nkv][S2 * H], t_dKL);
+  DECL_VLA_PTR_PT(T, dKL_V, [S2 * H], t_dKL_V);
+  DECL_VLA_PTR_PT(T, dVL, [Nkv][S2 * H], t_dVL);
+  DECL_VLA_PTR_PT(T, dVL_V, [S2 * H], t_dVL_V);
+  DECL_VLA_PTR_PT(T, AP, [SS1][S2 * S2], t_AP);
+  DECL_VLA_PTR_PT(T, AP_T, [SS1][S2 * S2], t_AP_T);
+  DECL_VLA_PTR_PT(T, dCL, [N][S2 * H], t_dCL);
+  DECL_VLA_PTR_PT(T, dCL_V, [S2 * H], t_dCL_V);
+  DECL_VLA_PTR_PT(T, dAPD_V, [SS1][S2 * S2], t_dAPD_V);
+  DECL_VLA_PTR_PT(float, cos, [S2 * H], t_cos);
+  DECL_VLA_PTR_PT(float, sin, [S2 * H], t_sin);
+  auto offs = t_offs.data_ptr<int64_t>();
+  auto offs2 = t_offs2.data_ptr<int64_t>();
+
+  auto cw_gemm_tpp = SCOPEITGEMM((BrgemmExtTPP<T, T>(
+      S2,
+      H,
+      S2,
+      S2 * S2,
+      dt_bf16 ? S2 * H : N * S2 * H,
+      0.0,
+      XformTPP::XFORM_NONE_TPP,
+      0 /*a_trans_flag*/, // We transpose in FWD to have fixed stride of blocks
+      1)));
+  auto cw_n2v_tpp =
+      SCOPEIT(XformExtTPP<T>(S2, H, XformTPP::XFORM_N2V_TPP, true), VNNI);
+  auto ci_gemm_tpp = SCOPEITGEMM((BrgemmExtTPP<T, float>(
+      S2, S2, H, S2 * H, S2 * H, 0.0, XformTPP::XFORM_NONE_TPP, 0, 1)));
+  auto softmax_bwd_tpp =
+      SCOPEIT((VarSoftMaxBwdTPP<float, float, T>(S2, S2)), SOFTMAX);
+  auto scale_tpp = SCOPEIT((ScaleTPP<float, T>(S2 * S2)), EW_SCL);
+  auto a_n2v_tpp =
+      SCOPEIT(XformExtTPP<T>(S2, S2, XformTPP::XFORM_N2V_TPP, true), VNNI);
+  auto ai_gemm_tpp = SCOPEITGEMM((BrgemmExtTPP<T, T>(
+      S2, H, S2, S2 * S2, Nkv * S2 * H, 0.0, XformTPP::XFORM_NONE_TPP, 0, S1)));
+  auto aw_gemm_tpp = SCOPEITGEMM((BrgemmExtTPP<T, T>(
+      H,
+      S2,
+      S2,
+      a_trans_flag == XformTPP::XFORM_NONE_TPP ? S2 * H : N * S2 * H,
+      S2 * S2,
+      0.0,
+      XformTPP::XFORM_XPOSE_TPP,
+      a_trans_flag,
+      1)));
+  auto rope_bwd_tpp = SCOPEIT(RotaryEmbTPP<T>(S2, H, true), ROPE);
+  auto rope_bwd_f32_tpp = SCOPEIT(RotaryEmbTPP<float>(S2, H, true), ROPE);
+  auto cvt_f32_tpp = SCOPEIT((ConvertTPP<T, float>(S2 * H)), EW_COPY);
+  auto cvt_tpp = SCOPEIT((ConvertTPP<float, T>(S2 * H)), EW_COPY);
+  auto add_tpp = SCOPEIT((AddTPP<float, float>(S2 * H)), EW_ADD);
+  auto vi_gemm_tpp = SCOPEITGEMM((BrgemmExtTPP<T, T>(
+      S2, H, H, S2 * H, H * H, 0.0, XformTPP::XFORM_NONE_TPP, 0, Nkv)));
+  auto ki_gemm_tpp = SCOPEITGEMM((BrgemmExtTPP<T, T>(
+      S2, H, H, S2 * H, H * H, 1.0, XformTPP::XFORM_NONE_TPP, 0, Nkv)));
+  auto qi_gemm_tpp = SCOPEITGEMM((BrgemmExtTPP<T, T>(
+      S2, H, H, S2 * H, H * H, 1.0, XformTPP::XFORM_NONE_TPP, 0, N)));
+  auto dw_cpy_tpp = SCOPEIT(CpyTPP<T>(H * H), VNNI);
+  auto dw_n2v_tpp =
+      SCOPEIT(XformExtTPP<T>(H, H, XformTPP::XFORM_N2V_TPP, true), VNNI);
+  auto qw_gemm_tpp = SCOPEITGEMM((BrgemmExtTPP<T, T>(
+      H,
+      H,
+      S2,
+      a_trans_flag == XformTPP::XFORM_NONE_TPP ? S2 * H : N * S2 * H,
+      a_trans_flag == XformTPP::XFORM_NONE_TPP ? S2 * H : N * S2 * H,
+      1.0,
+      XformTPP::XFORM_NONE_TPP,
+      a_trans_flag,
+      BS)));
+  auto kvw_gemm_tpp = SCOPEITGEMM((BrgemmExtTPP<T, T>(
+      H,
+      H,
+      S2,
+      a_trans_flag == XformTPP::XFORM_NONE_TPP ? S2 * H : N * S2 * H,
+      a_trans_flag == XformTPP::XFORM_NONE_TPP ? S2 * H : Nkv * S2 * H,
+      1.0,
+      XformTPP::XFORM_NONE_TPP,
+      a_trans_flag,
+      BS)));
+  auto set_zero_dw_tpp = SCOPEIT(SetZeroTPP<T>(H * H), EW_ZERO);
+
+  {
+    RECORD_SCOPE(ldac_gemm, {t_AP_T, t_dCL_V});
+    {
+      RECORD_FUNCTION("parallel_for", std::vector<c10::IValue>());
+#pragma omp parallel for collapse(2) schedule(static, 1)
+      for (int b = 0; b < B; b++) {
+        for (int n = 0; n < N; n++) {
+          int64_t kv = n / G;
+          int64_t start = offs[b];
+          int64_t ss = offs2[b];
+          int64_t end = offs[b + 1];
+          int64_t len = end - start;
+          // Key block k only received attention from query blocks k..len-1
+          for (int s21 = start; s21 < end; s21++) {
+            int64_t k = s21 - start;
+            // dVL = AP_T * dCL
+            cw_gemm_tpp(
+                AP_T[n][ss + k * len + k],
+                dCL_V[atrans_blk(s21, n)],
+                dVL_h[s21][n],
+                len - k);
+          }
+          for (int s11 = start, ss1 = ss; s11 < end; s11++, ss1 += len) {
+            int64_t l = s11 - start;
+            float dtAPD[l + 1][S2][S2];
+            T dtAPD_bf[l + 1][S2][S2];
+            for (int s21 = start; s21 <= s11; s21++) {
+              auto ls21 = s21 - start;
+              ci_gemm_tpp(dCL[s11][n], VL_TV[s21][kv], dtAPD[ls21][0], 1);
+            }
+            softmax_bwd_tpp(l + 1, dtAPD[0][0], dtAPD[0][0], AP[n][ss1]);
+            for (int ls21 = 0; ls21 <= l; ls21++) {
+              scale_tpp(dtAPD[ls21][0], dtAPD_bf[ls21][0], one_by_sqrt_H);
+              a_n2v_tpp(dtAPD_bf[ls21][0], dAPD_V[n][ss + ls21 * len + l]);
+            }
+            // dQL = dADP * KL_V, then back through the rotary embedding
+            ai_gemm_tpp(dtAPD_bf[0][0], KL_V[start][kv], dQL[s11][n], l + 1);
+            rope_bwd_tpp(dQL[s11][n], cos[s11], sin[s11], dQL[s11][n]);
+            if (dt_bf16)
+              cw_n2v_tpp(dQL[s11][n], dQL_V[atrans_blk(s11, n)]);
+          }
+          for (int s21 = start; s21 < end; s21++) {
+            int64_t k = s21 - start;
+            // dKL = (QL_T * dAPD)T
+            aw_gemm_tpp(
+                QL_T[atrans_blk(s21, n)],
+                dAPD_V[n][ss + k * len + k],
+                dKL_h[s21][n],
+                len - k);
+          }
+        }
+      }
+    }
+  }
+  {
+    RECORD_SCOPE(dkv_red, {t_dKL_h, t_dVL_h});
+    {
+      RECORD_FUNCTION("parallel_for", std::vector<c10::IValue>());
+#pragma omp parallel for collapse(2)
+      for (int s1 = 0; s1 < S1; s1++) {
+        for (int kv = 0; kv < Nkv; kv++) {
+          float dk[S2 * H], dv[S2 * H], tmp[S2 * H];
+          cvt_f32_tpp(dKL_h[s1][kv * G], dk);
+          cvt_f32_tpp(dVL_h[s1][kv * G], dv);
+          for (int g = 1; g < G; g++) {
+            cvt_f32_tpp(dKL_h[s1][kv * G + g], tmp);
+            add_tpp(dk, tmp, dk);
+            cvt_f32_tpp(dVL_h[s1][kv * G + g], tmp);
+            add_tpp(dv, tmp, dv);
+          }
+          rope_bwd_f32_tpp(dk, cos[s1], sin[s1], dk);
+          cvt_tpp(dk, dKL[s1][kv]);
+          cvt_tpp(dv, dVL[s1][kv]);
+          if (dt_bf16) {
+            cw_n2v_tpp(dKL[s1][kv], dKL_V[kv_blk(s1, kv)]);
+            cw_n2v_tpp(dVL[s1][kv], dVL_V[kv_blk(s1, kv)]);
+          }
+        }
+      }
+    }
+  }
+  auto qkv_loop = ThreadedLoop<2>({LoopSpecs{S1}, LoopSpecs{N}}, "bA");
+  {
+    RECORD_SCOPE(ldiv_gemm, {t_dVL, t_Wv_TV});
+    qkv_loop(
+        [&](int* ind) {
+          int s1 = ind[0], nc = ind[1];
+          DECL_VLA_PTR_PT(T, dVL, [Nkv][S2 * H], t_dVL);
+          DECL_VLA_PTR_PT(T, Wv_TV, [Nkv][H * H], t_Wv_TV);
+          DECL_VLA_PTR_PT(T, dHS, [N][S2 * H], t_dHS);
+          vi_gemm_tpp(dVL[s1][0], Wv_TV[nc][0], dHS[s1][nc], Nkv, true);
+        },
+        [&]() { vi_gemm_tpp.config(); },
+        [&]() { vi_gemm_tpp.release(); });
+  }
+  {
+    RECORD_SCOPE(ldik_gemm, {t_dKL, t_Wk_TV});
+    qkv_loop(
+        [&](int* ind) {
+          int s1 = ind[0], nc = ind[1];
+          DECL_VLA_PTR_PT(T, dKL, [Nkv][S2 * H], t_dKL);
+          DECL_VLA_PTR_PT(T, Wk_TV, [Nkv][H * H], t_Wk_TV);
+          DECL_VLA_PTR_PT(T, dHS, [N][S2 * H], t_dHS);
+          ki_gemm_tpp(dKL[s1][0], Wk_TV[nc][0], dHS[s1][nc], Nkv, true);
+        },
+        [&]() { ki_gemm_tpp.config(); },
+        [&]() { ki_gemm_tpp.release(); });
+  }
+  {
+    RECORD_SCOPE(ldiq_gemm, {t_dQL, t_Wq_TV});
+    qkv_loop(
+        [&](int* ind) {
+          int s1 = ind[0], nc = ind[1];
+          DECL_VLA_PTR_PT(T, dQL, [N][S2 * H], t_dQL);
+          DECL_VLA_PTR_PT(T, Wq_TV, [N][H * H], t_Wq_TV);
+          DECL_VLA_PTR_PT(T, dHS, [N][S2 * H], t_dHS);
+          qi_gemm_tpp(dQL[s1][0], Wq_TV[nc][0], dHS[s1][nc], N, true);
+        },
+        [&]() { qi_gemm_tpp.config(); },
+        [&]() { qi_gemm_tpp.release(); });
+  }
+  {
+    RECORD_SCOPE(ldwqkv_gemm, {t_HS_T, t_dQL_V});
+    auto qkvw_loop = ThreadedLoop<3>(
+        {LoopSpecs{0, S1, BS, true}, LoopSpecs{N}, LoopSpecs{N}}, "aBC");
+    qkvw_loop(
+        [&](int* ind) {
+          int s1 = ind[0], nk = ind[1], nc = ind[2];
+          int count = (s1 + BS <= S1 ? BS : S1 - s1);
+          bool is_last_iter = !(s1 + BS < S1);
+          DECL_VLA_PTR_PT(T, dWv, [N][H * H], t_dWv);
+          DECL_VLA_PTR_PT(T, dWk, [N][H * H], t_dWk);
+          DECL_VLA_PTR_PT(T, dWq, [N][H * H], t_dWq);
+          DECL_VLA_PTR_PT(T, HS_T, [H * S2], t_HS_T);
+          DECL_VLA_PTR_PT(T, dVL_V, [S2 * H], t_dVL_V);
+          DECL_VLA_PTR_PT(T, dKL_V, [S2 * H], t_dKL_V);
+          DECL_VLA_PTR_PT(T, dQL_V, [S2 * H], t_dQL_V);
+          if (s1 == 0) {
+            set_zero_dw_tpp(dWq[nk][nc]);
+            if (nk < Nkv) {
+              set_zero_dw_tpp(dWk[nk][nc]);
+              set_zero_dw_tpp(dWv[nk][nc]);
+            }
+          }
+          qw_gemm_tpp(
+              HS_T[atrans_blk(s1, nc)],
+              dQL_V[atrans_blk(s1, nk)],
+              dWq[nk][nc],
+              count,
+              true);
+          if (grad_wt_flag != XformTPP::XFORM_NONE_TPP && is_last_iter) {
+            T tmp[H * H];
+            dw_cpy_tpp(dWq[nk][nc], tmp);
+            dw_n2v_tpp(tmp, dWq[nk][nc]);
+          }
+          if (nk >= Nkv)
+            return;
+          kvw_gemm_tpp(
+              HS_T[atrans_blk(s1, nc)],
+              dKL_V[kv_blk(s1, nk)],
+              dWk[nk][nc],
+              count,
+              true);
+          kvw_gemm_tpp(
+              HS_T[atrans_blk(s1, nc)],
+              dVL_V[kv_blk(s1, nk)],
+              dWv[nk][nc],
+              count,
+              true);
+          if (grad_wt_flag != XformTPP::XFORM_NONE_TPP && is_last_iter) {
+            T tmp[H * H];
+            dw_cpy_tpp(dWk[nk][nc], tmp);
+            dw_n2v_tpp(tmp, dWk[nk][nc]);
+            dw_cpy_tpp(dWv[nk][nc], tmp);
+            dw_n2v_tpp(tmp, dWv[nk][nc]);
+          }
+        },
+        [&]() { qw_gemm_tpp.config(); },
+        [&]() { qw_gemm_tpp.release(); });
+  }
+}
+return std::vector<at::Tensor>({t_dWq, t_dWk, t_dWv, t_dHS});
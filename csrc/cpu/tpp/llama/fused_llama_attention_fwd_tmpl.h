@@ -0,0 +1,218 @@
+RECORD_FUNCTION("llama_fwd", std::vector<c10::IValue>());
+// B - Batch size
+// S - Max seq len
+// N - Number of query heads
+// Nkv - Number of key / value heads, N % Nkv == 0
+// H - Head size
+auto t_Wq = inputs[0]; // [HS][NH] --> [N][N][H][H]
+auto t_Wk = inputs[1]; // [HS][NkvH] --> [Nkv][N][H][H]
+auto t_Wv = inputs[2]; // [HS][NkvH] --> [Nkv][N][H][H]
+auto t_HS = inputs[3]; // [B][S][HS] --> [S1][N][S2][H]
+auto t_cos = inputs[4]; // [S1 * S2][H], float
+auto t_sin = inputs[5]; // [S1 * S2][H], float
+auto t_offs = inputs[6]; // [B+1]
+auto t_offs2 = inputs[7]; // [B+1]
+
+int64_t B = t_offs.sizes()[0] - 1;
+int64_t SS1 = t_offs2[B].item().to<int64_t>();
+auto sizes = t_HS.sizes();
+int64_t S1 = sizes[0];
+int64_t N = sizes[1];
+int64_t S2 = sizes[2];
+int64_t H = sizes[3];
+int64_t Nkv = t_Wk.sizes()[0];
+PCL_ASSERT(N % Nkv == 0, "query heads must be a multiple of kv heads\n");
+int64_t G = N / Nkv;
+float one_by_sqrt_H = 1.0 / sqrt(H);
+bool dt_bf16 = (t_HS.dtype() == at::kBFloat16);
+bool bf16_training = (training && dt_bf16);
+
+auto t_HS_T = t_HS;
+
+auto t_Wq_V = wt_tensor_for_fwd(N, H, N, H, t_Wq);
+auto t_Wk_V = wt_tensor_for_fwd(Nkv, H, N, H, t_Wk);
+auto t_Wv_V = wt_tensor_for_fwd(Nkv, H, N, H, t_Wv);
+
+auto t_QL = t_HS.new_empty({S1, N, S2, H});
+auto t_QL_T = t_QL;
+auto t_KL_TV = t_HS.new_empty({S1, Nkv, H, S2});
+if (dt_bf16)
+  t_KL_TV = t_KL_TV.view({S1, Nkv, H / 2, S2, 2});
+auto t_KL_V = t_KL_TV;
+auto t_VL_V = t_HS.new_empty({S1, Nkv, S2, H});
+if (dt_bf16)
+  t_VL_V = t_VL_V.view({S1, Nkv, S2 / 2, H, 2});
+auto t_VL_TV = t_VL_V;
+auto t_AP = t_QL.new_empty({N, SS1, S2, S2});
+auto t_CL = t_AP.new_empty({S1, N, S2, H});
+auto t_AP_T = t_AP;
+
+if (bf16_training) {
+  t_HS_T = t_HS.new_empty({N, S1, H, S2}); // For BWD only
+  t_QL_T = t_HS.new_empty({N, S1, H, S2}); // For BWD only
+}
+if (training) {
+  if (dt_bf16) {
+    t_KL_V = t_HS.new_empty({S1, Nkv, S2 / 2, H, 2}); // Saved For BWD
+    t_VL_TV = t_HS.new_empty({S1, Nkv, H / 2, S2, 2}); // For BWD only
+  } else {
+    t_KL_V = t_HS.new_empty({S1, Nkv, S2, H}); // Saved For BWD
+    t_VL_TV = t_HS.new_empty({S1, Nkv, H, S2}); // For BWD only
+  }
+  t_AP_T = t_QL.new_empty({N, SS1, S2, S2}); // For BWD only
+}
+
+{
+  DECL_VLA_PTR_PT(T, QL, [N][S2 * H], t_QL);
+  DECL_VLA_PTR_PT(T, KL_TV, [Nkv][H * S2], t_KL_TV);
+  DECL_VLA_PTR_PT(T, VL_V, [Nkv][S2 * H], t_VL_V);
+  DECL_VLA_PTR_PT(T, AP, [SS1][S2 * S2], t_AP);
+  DECL_VLA_PTR_PT(T, AP_T, [SS1][S2 * S2], t_AP_T); // For BWD only
+  DECL_VLA_PTR_PT(T, CL, [N][S2 * H], t_CL);
+  auto offs = t_offs.data_ptr<int64_t>();
+  auto offs2 = t_offs2.data_ptr<int64_t>();
+
+  auto qkv_gemm_tpp = SCOPEITGEMM((BrgemmExtTPP<T, T>(
+      S2, H, H, S2 * H, H * H, 0.0, XformTPP::XFORM_NONE_TPP, 0, N)));
+  auto rope_fwd_tpp = SCOPEIT(RotaryEmbTPP<T>(S2, H), ROPE);
+  auto xpose_tpp =
+      SCOPEIT(XformExtTPP<T>(S2, H, XformTPP::XFORM_XPOSE_TPP), XPOSE);
+  auto k_xpose_tpp_1 = SCOPEIT(
+      XformExtTPP<T>(
+          S2,
+          H,
+          training ? XformTPP::XFORM_N2V_TPP : XformTPP::XFORM_XPOSE_N2V_TPP,
+          true),
+      XPOSE);
+  auto kv_xpose_tpp_2 =
+      SCOPEIT(XformExtTPP<T>(S2, H, XformTPP::XFORM_XPOSE_N2V_TPP, true), VNNI);
+  auto v_xpose_tpp_1 =
+      SCOPEIT(XformExtTPP<T>(S2, H, XformTPP::XFORM_N2V_TPP, true), VNNI);
+  auto a_gemm_tpp = SCOPEITGEMM((BrgemmExtTPP<T, float>(
+      S2, S2, H, S2 * H, H * S2, 0.0, XformTPP::XFORM_NONE_TPP, 0, 1)));
+  auto scale_tpp = SCOPEIT((ScaleTPP<float, float>(S2 * S2)), EW_SCL);
+  auto softmax_fwd_tpp = SCOPEIT((VarSoftMaxFwdTPP<float, T>(S2, S2)), SOFTMAX);
+  auto a_xpose_tpp =
+      SCOPEIT(XformExtTPP<T>(S2, S2, XformTPP::XFORM_XPOSE_TPP), XPOSE);
+  auto c_gemm_tpp = SCOPEITGEMM((BrgemmExtTPP<T, T>(
+      S2, H, S2, S2 * S2, Nkv * S2 * H, 0.0, XformTPP::XFORM_NONE_TPP, 0, S1)));
+
+  {
+    RECORD_SCOPE(lq_gemm, {t_HS, t_Wq_V});
+    auto q_loop = ThreadedLoop<2>({LoopSpecs{S1}, LoopSpecs{N}}, "bA");
+    q_loop(
+        [&](int* ind) {
+          int s1 = ind[0], nk = ind[1];
+          DECL_VLA_PTR_PT(T, HS, [N][S2 * H], t_HS);
+          DECL_VLA_PTR_PT(T, HS_T, [S1][H * S2], t_HS_T); // for BWD only
+          DECL_VLA_PTR_PT(T, Wq_V, [N][H * H], t_Wq_V);
+          DECL_VLA_PTR_PT(T, QL, [N][S2 * H], t_QL);
+          DECL_VLA_PTR_PT(T, QL_T, [S1][H * S2], t_QL_T); // For BWD only
+          DECL_VLA_PTR_PT(float, cos, [S2 * H], t_cos);
+          DECL_VLA_PTR_PT(float, sin, [S2 * H], t_sin);
+          if (bf16_training && nk == 0)
+            xpose_tpp(N, S2 * H, S1 * S2 * H, HS[s1][0], HS_T[0][s1]);
+          qkv_gemm_tpp(HS[s1][0], Wq_V[nk][0], QL[s1][nk], N, true);
+          rope_fwd_tpp(QL[s1][nk], cos[s1], sin[s1], QL[s1][nk]);
+          if (bf16_training)
+            xpose_tpp(QL[s1][nk], QL_T[nk][s1]);
+        },
+        [&]() { qkv_gemm_tpp.config(); },
+        [&]() { qkv_gemm_tpp.release(); });
+  }
+
+  {
+    RECORD_SCOPE(lk_gemm, {t_HS, t_Wk_V});
+    auto kv_loop = ThreadedLoop<2>({LoopSpecs{S1}, LoopSpecs{Nkv}}, "bA");
+    kv_loop(
+        [&](int* ind) {
+          int s1 = ind[0], nk = ind[1];
+          DECL_VLA_PTR_PT(T, HS, [N][S2 * H], t_HS);
+          DECL_VLA_PTR_PT(T, Wk_V, [N][H * H], t_Wk_V);
+          DECL_VLA_PTR_PT(T, KL_V, [Nkv][S2 * H], t_KL_V);
+          DECL_VLA_PTR_PT(T, KL_TV, [Nkv][H * S2], t_KL_TV);
+          DECL_VLA_PTR_PT(float, cos, [S2 * H], t_cos);
+          DECL_VLA_PTR_PT(float, sin, [S2 * H], t_sin);
+
+          T tmp[S2 * H];
+          T* tmpp = (training && !bf16_training) ? KL_V[s1][nk] : tmp;
+          qkv_gemm_tpp(HS[s1][0], Wk_V[nk][0], tmpp, N, true);
+          rope_fwd_tpp(tmpp, cos[s1], sin[s1], tmpp);
+          k_xpose_tpp_1(tmpp, KL_V[s1][nk]); // KL_V = KL_VT if not training
+          if (training)
+            kv_xpose_tpp_2(tmpp, KL_TV[s1][nk]);
+        },
+        [&]() { qkv_gemm_tpp.config(); },
+        [&]() { qkv_gemm_tpp.release(); });
+  }
+
+  {
+    RECORD_SCOPE(lv_gemm, {t_HS, t_Wv_V});
+    auto kv_loop = ThreadedLoop<2>({LoopSpecs{S1}, LoopSpecs{Nkv}}, "bA");
+    kv_loop(
+        [&](int* ind) {
+          int s1 = ind[0], nk = ind[1];
+          DECL_VLA_PTR_PT(T, HS, [N][S2 * H], t_HS);
+          DECL_VLA_PTR_PT(T, Wv_V, [N][H * H], t_Wv_V);
+          DECL_VLA_PTR_PT(T, VL_V, [Nkv][S2 * H], t_VL_V);
+          DECL_VLA_PTR_PT(T, VL_TV, [Nkv][H * S2], t_VL_TV);
+
+          T tmp[S2 * H];
+          T* tmpp = (!dt_bf16) ? VL_V[s1][nk] : tmp;
+          qkv_gemm_tpp(HS[s1][0], Wv_V[nk][0], tmpp, N, true);
+          v_xpose_tpp_1(tmpp, VL_V[s1][nk]);
+          if (training)
+            kv_xpose_tpp_2(tmpp, VL_TV[s1][nk]);
+        },
+        [&]() { qkv_gemm_tpp.config(); },
+        [&]() { qkv_gemm_tpp.release(); });
+  }
+  // Causal attention: query block l of a sequence only sees key blocks
+  // 0..l, and the diagonal block is masked above its diagonal. Query head n
+  // reads key / value head n / G.
+  {
+    RECORD_SCOPE(lac_gemm, {t_QL, t_KL_TV});
+    {
+      RECORD_FUNCTION("parallel_for", std::vector<c10::IValue>());
+#ifndef _WIN32 // TODO: Fix crash on ICX Windows.
+#pragma omp parallel for collapse(2) schedule(static, 1)
+#else
+#pragma omp for
+#endif
+      for (int b = 0; b < B; b++) {
+        for (int n = 0; n < N; n++) {
+          int64_t kv = n / G;
+          int64_t start = offs[b];
+          int64_t ss1 = offs2[b];
+          int64_t end = offs[b + 1];
+          int64_t len = end - start;
+          for (int s11 = start; s11 < end; s11++, ss1 += len) {
+            int64_t l = s11 - start;
+            float AS[l + 1][S2][S2];
+            for (int s21 = start; s21 <= s11; s21++) {
+              int64_t ls21 = s21 - start;
+              a_gemm_tpp(QL[s11][n], KL_TV[s21][kv], AS[ls21][0], 1);
+              scale_tpp(AS[ls21][0], AS[ls21][0], one_by_sqrt_H);
+            }
+            for (int i = 0; i < S2; i++) {
+              for (int j = i + 1; j < S2; j++) {
+                AS[l][i][j] = -1e9f;
+              }
+            }
+            softmax_fwd_tpp(l + 1, AS[0][0], AP[n][ss1]);
+            if (training) {
+              int64_t ss = offs2[b];
+              // xpose S1xS1 part as well here to allow fix stride in GEMM in
+              // bwd
+              a_xpose_tpp(
+                  l + 1, S2 * S2, len * S2 * S2, AP[n][ss1], AP_T[n][ss + l]);
+            }
+            c_gemm_tpp(AP[n][ss1], VL_V[start][kv], CL[s11][n], l + 1);
+          }
+        }
+      }
+    }
+  }
+}
+return std::vector<at::Tensor>(
+    {t_CL, t_HS_T, t_QL_T, t_KL_V, t_VL_TV, t_AP, t_AP_T});
@@ -12,6 +12,7 @@
 #endif
 
 #include <atomic>
+#include <vector>
 
 namespace torch_ipex {
 namespace tpp {
@@ -95,6 +96,75 @@ static int sparse_add_use_lock_free() {
   return lock_free;
 }
 
+// Sparse rows grouped by the thread that owns their dense row. Thread `t`
+// owns dense rows [t * M / nthr, (t + 1) * M / nthr) and applies the sparse
+// rows rows[offsets[t]] .. rows[offsets[t + 1] - 1].
+struct SparseRowBuckets {
+  int nthr;
+  std::vector<long> offsets;
+  std::vector<long> rows;
+};
+
+// Two-pass counting sort of the NS sparse indices by owning thread: every
+// thread histograms a chunk of the indices, then scatters the chunk into the
+// buckets. The sort is stable, so duplicate indices are applied in the same
+// order as a serial loop would apply them. Work is O(NS + nthr^2) instead of
+// the O(NS * nthr) of letting every thread scan all indices.
+static SparseRowBuckets bucket_sparse_rows(
+    const long* indices,
+    long NS,
+    long M,
+    int nthr) {
+  SparseRowBuckets buckets;
+  buckets.nthr = nthr;
+  buckets.offsets.assign(nthr + 1, 0);
+  buckets.rows.resize(NS);
+  std::vector<long> row_begin(nthr + 1);
+  for (int t = 0; t <= nthr; t++) {
+    row_begin[t] = (t * M) / nthr;
+  }
+  auto owner = [&](long ind) {
+    int t = (ind * nthr) / M;
+    while (t + 1 < nthr && ind >= row_begin[t + 1])
+      t++;
+    while (t > 0 && ind < row_begin[t])
+      t--;
+    return t;
+  };
+  // hist[c * nthr + t]: rows of chunk c owned by thread t, turned into the
+  // scatter position of that (chunk, owner) pair by the prefix sum below.
+  std::vector<long> hist((long)nthr * nthr, 0);
+#pragma omp parallel for schedule(static, 1)
+  for (int c = 0; c < nthr; c++) {
+    long i_begin = (c * NS) / nthr;
+    long i_end = ((c + 1) * NS) / nthr;
+    long* h = &hist[(long)c * nthr];
+    for (long i = i_begin; i < i_end; i++) {
+      h[owner(indices[i])]++;
+    }
+  }
+  long pos = 0;
+  for (int t = 0; t < nthr; t++) {
+    buckets.offsets[t] = pos;
+    for (int c = 0; c < nthr; c++) {
+      long cnt = hist[(long)c * nthr + t];
+      hist[(long)c * nthr + t] = pos;
+      pos += cnt;
+    }
+  }
+  buckets.offsets[nthr] = pos;
+#pragma omp parallel for schedule(static, 1)
+  for (int c = 0; c < nthr; c++) {
+    long i_begin = (c * NS) / nthr;
+    long i_end = ((c + 1) * NS) / nthr;
+    long* h = &hist[(long)c * nthr];
+    for (long i = i_begin; i < i_end; i++) {
+      buckets.rows[h[owner(indices[i])]++] = i;
+    }
+  }
+  return buckets;
+}
+
 template <typename scalar_t>
 void dense_sparse_add_tmpl(
     at::Tensor t_dense,
@@ -103,10 +173,13 @@ void dense_sparse_add_tmpl(
   auto NS = t_sparse._nnz();
   auto M = t_dense.size(0);
   auto E = t_dense.size(1);
-  auto t_values = t_sparse._values();
-  auto t_indices = t_sparse._indices();
+  auto t_values = t_sparse._values().contiguous();
+  auto t_indices = t_sparse._indices().contiguous();
 
   PCL_ASSERT(t_dense.is_contiguous(), "dense tensor must be contiguous\n");
+  PCL_ASSERT(
+      t_values.dtype() == t_dense.dtype(),
+      "sparse values must have the dense tensor dtype\n");
   // Not using below due to spurious compiler warnings
   // DECL_VLA_PTR_PT(scalar_t, dense, [E], t_dense);
   // DECL_VLA_PTR_PT(scalar_t, values, [E], t_values);
@@ -123,18 +196,17 @@ void dense_sparse_add_tmpl(
     int nthr = max_thr;
     if (M < nthr)
       nthr = M;
-#pragma omp parallel num_threads(nthr)
-    {
-      int tid = omp_get_thread_num();
-      long j_begin = (tid * M) / nthr;
-      long j_end = ((tid + 1) * M) / nthr;
-      for (long i = 0; i < NS; i++) {
+    if (NS == 0 || nthr == 0)
+      return;
+    auto buckets = bucket_sparse_rows(indices, NS, M, nthr);
+#pragma omp parallel for schedule(static, 1)
+    for (int tid = 0; tid < nthr; tid++) {
+      for (long b = buckets.offsets[tid]; b < buckets.offsets[tid + 1]; b++) {
+        auto i = buckets.rows[b];
         auto ind = indices[i];
-        if (ind >= j_begin && ind < j_end) {
-          auto wa = &dense[ind * E];
-          auto va = &values[i * E];
-          embbag_upd(va, wa, lr);
-        }
+        auto wa = &dense[ind * E];
+        auto va = &values[i * E];
+        embbag_upd(va, wa, lr);
       }
     }
   } else {
@@ -165,10 +237,10 @@ void dense_sparse_add_(
   RECORD_SCOPE(dense_sparse_add, {dense, sparse, alpha});
   if (dense.dtype() == at::kFloat) {
     dense_sparse_add_tmpl<float>(dense, sparse, alpha);
-    //} else if (dense.dtype() == at::kBFloat16) {
-    //  dense_sparse_add_tmpl<bfloat16>(dense, sparse, alpha);
-    //} else if (dense.dtype() == at::kHalf) {
-    //  dense_sparse_add_tmpl<half>(dense, sparse, alpha);
+  } else if (dense.dtype() == at::kBFloat16) {
+    dense_sparse_add_tmpl<bfloat16>(dense, sparse, alpha);
+  } else if (dense.dtype() == at::kHalf) {
+    dense_sparse_add_tmpl<half>(dense, sparse, alpha);
   } else {
     PCL_ASSERT(0, "This datatype is not supported\n");
   }
@@ -188,8 +260,8 @@ void bf16_split_add_(
     auto NS = sparse._nnz();
     auto M = hi_bits.size(0);
     auto E = hi_bits.size(1);
-    auto values_tensor = sparse._values();
-    auto indices = sparse._indices();
+    auto values_tensor = sparse._values().contiguous();
+    auto indices = sparse._indices().contiguous();
     auto indices_data = indices.data_ptr<long>();
     auto split_sgd_kernel = SplitSGDTPP(E);
 
@@ -202,19 +274,19 @@ void bf16_split_add_(
       int nthr = max_thr;
       if (M < nthr)
         nthr = M;
-#pragma omp parallel num_threads(nthr)
-      {
-        int tid = omp_get_thread_num();
-        long j_begin = (tid * M) / nthr;
-        long j_end = ((tid + 1) * M) / nthr;
-        for (long i = 0; i < NS; i++) {
+      if (NS == 0 || nthr == 0)
+        return;
+      auto buckets = bucket_sparse_rows(indices_data, NS, M, nthr);
+#pragma omp parallel for schedule(static, 1)
+      for (int tid = 0; tid < nthr; tid++) {
+        for (long b = buckets.offsets[tid]; b < buckets.offsets[tid + 1];
+             b++) {
+          auto i = buckets.rows[b];
           auto ind = indices_data[i];
-          if (ind >= j_begin && ind < j_end) {
-            auto ha = &hi_data[ind * E];
-            auto la = &lo_data[ind * E];
-            auto va = &values_data[i * E];
-            split_sgd_kernel((at::BFloat16*)ha, (at::BFloat16*)la, va, lr);
-          }
+          auto ha = &hi_data[ind * E];
+          auto la = &lo_data[ind * E];
+          auto va = &values_data[i * E];
+          split_sgd_kernel((at::BFloat16*)ha, (at::BFloat16*)la, va, lr);
         }
       }
     } else {
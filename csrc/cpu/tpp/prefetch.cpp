@@ -0,0 +1,149 @@
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "prefetch.h"
+
+namespace torch_ipex {
+namespace tpp {
+
+namespace {
+
+using WeakStorage = c10::weak_intrusive_ptr<c10::StorageImpl>;
+
+struct NextWeightHint {
+  // storage of the weight the hint is keyed by, to detect a freed weight
+  // whose address got reused
+  WeakStorage weight;
+  long weight_offset;
+  WeakStorage next;
+  long next_offset;
+  long next_nbytes;
+};
+
+using NextWeightMap = std::unordered_map<const void*, NextWeightHint>;
+
+// The kernels look the hints up on every call, so readers never lock: the
+// map is an immutable snapshot published through an atomic pointer, and
+// set / clear publish a modified copy under the writer mutex. A replaced
+// snapshot is retired and only freed once no reader is inside
+// get_next_weight, readers announce themselves in `readers` before loading
+// the pointer.
+std::atomic<const NextWeightMap*> current_hints{nullptr};
+std::atomic<long> readers{0};
+
+std::mutex& writer_mutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::vector<std::unique_ptr<const NextWeightMap>>& retired_hints() {
+  static std::vector<std::unique_ptr<const NextWeightMap>> retired;
+  return retired;
+}
+
+long storage_offset_bytes(const at::Tensor& t) {
+  return (const char*)t.data_ptr() -
+      (const char*)t.storage().data_ptr().get();
+}
+
+const char* live_data(
+    const WeakStorage& weak,
+    long offset,
+    c10::intrusive_ptr<c10::StorageImpl>& strong) {
+  strong = weak.lock();
+  if (!strong) {
+    return nullptr;
+  }
+  auto base = (const char*)strong->data_ptr().get();
+  return base == nullptr ? nullptr : base + offset;
+}
+
+// Called with the writer mutex held.
+void publish(std::unique_ptr<const NextWeightMap> hints) {
+  auto old = current_hints.exchange(hints.release());
+  auto& retired = retired_hints();
+  if (old != nullptr) {
+    retired.emplace_back(old);
+  }
+  // readers that come after the exchange see the new snapshot
+  if (readers.load() == 0) {
+    retired.clear();
+  }
+}
+
+} // namespace
+
+void set_next_weight(const at::Tensor& weight, const at::Tensor& next) {
+  PCL_ASSERT(
+      weight.is_contiguous() && next.is_contiguous(),
+      "set_next_weight: weights must be contiguous\n");
+  std::lock_guard<std::mutex> lock(writer_mutex());
+  auto hints = std::make_unique<NextWeightMap>();
+  if (auto cur = current_hints.load()) {
+    // drop the hints of freed weights on the way
+    c10::intrusive_ptr<c10::StorageImpl> strong;
+    for (const auto& kv : *cur) {
+      const auto& hint = kv.second;
+      if (live_data(hint.weight, hint.weight_offset, strong) == kv.first &&
+          live_data(hint.next, hint.next_offset, strong) != nullptr) {
+        hints->emplace(kv);
+      }
+    }
+  }
+  (*hints)[weight.data_ptr()] = NextWeightHint{
+      WeakStorage(weight.storage().getIntrusivePtr()),
+      storage_offset_bytes(weight),
+      WeakStorage(next.storage().getIntrusivePtr()),
+      storage_offset_bytes(next),
+      (long)next.nbytes()};
+  publish(std::move(hints));
+}
+
+void clear_next_weights() {
+  std::lock_guard<std::mutex> lock(writer_mutex());
+  publish(nullptr);
+}
+
+NextWeight get_next_weight(const void* weight) {
+  NextWeight next;
+  readers.fetch_add(1);
+  auto hints = current_hints.load();
+  auto it = hints == nullptr ? NextWeightMap::const_iterator()
+                             : hints->find(weight);
+  if (hints != nullptr && it != hints->end()) {
+    const auto& hint = it->second;
+    c10::intrusive_ptr<c10::StorageImpl> weight_storage;
+    if (live_data(hint.weight, hint.weight_offset, weight_storage) ==
+        weight) {
+      next.data = live_data(hint.next, hint.next_offset, next.storage);
+      next.nbytes = next.data == nullptr ? 0 : hint.next_nbytes;
+    }
+  }
+  readers.fetch_sub(1);
+  return next;
+}
+
+long next_weight_prefetch_bytes() {
+  static long bytes = [] {
+    long val = env2int(
+        "TPP_NEXT_WEIGHT_PREFETCH_BYTES", (int)(4 * weight_prefetch_bytes()));
+    return val <= 0 ? 0L : (val + 63) / 64 * 64;
+  }();
+  return bytes;
+}
+
+void NextWeightPrefetch::prefetch_slice() const {
+  long nthreads = omp_get_num_threads();
+  long slice = next.nbytes / nthreads;
+  auto p = next.data + omp_get_thread_num() * slice;
+  auto last = p + std::min(slice, next_weight_prefetch_bytes());
+  for (; p < last; p += 64) {
+    _mm_prefetch(p, _MM_HINT_T1);
+  }
+}
+
+} // namespace tpp
+} // namespace torch_ipex
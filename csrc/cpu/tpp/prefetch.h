@@ -0,0 +1,129 @@
+#ifndef _TPP_PREFETCH_H_
+#define _TPP_PREFETCH_H_
+
+#include <immintrin.h>
+#include <algorithm>
+// __GLIBC__ comes from the C library headers included above
+#if defined(__GLIBC__)
+#include <unistd.h>
+#endif
+#include "utils.h"
+
+namespace torch_ipex {
+namespace tpp {
+
+// Linears with at most this many rows (the decode phase of LLMs) are pure
+// weight streams and run in the GEMV streaming mode below.
+constexpr long GEMV_M_THRESHOLD = 8;
+
+// Default distance of the L2 weight prefetch. It has to cover the DRAM
+// latency at the per-core share of the bandwidth, which grows with the size
+// of the L2 of the platform (1/256 of it, i.e. 8KB on a 2MB L2).
+// Without glibc the L2 size is not queried and taken as 1MB.
+inline long default_weight_prefetch_bytes() {
+  long l2_bytes = 0;
+#if defined(__GLIBC__)
+  l2_bytes = sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+  if (l2_bytes <= 0) {
+    l2_bytes = 1L << 20;
+  }
+  return std::min(std::max(l2_bytes / 256, 2048L), 32768L);
+}
+
+// TPP_WEIGHT_PREFETCH_BYTES overrides the distance, 0 disables the prefetch.
+inline long weight_prefetch_bytes() {
+  static long bytes = [] {
+    long val = env2int(
+        "TPP_WEIGHT_PREFETCH_BYTES", (int)default_weight_prefetch_bytes());
+    return val <= 0 ? 0L : (val + 63) / 64 * 64;
+  }();
+  return bytes;
+}
+
+// Software prefetch of a weight tensor that is consumed block by block in
+// address order, as each thread does for its contiguous range of output
+// blocks in the GEMV loops. Called with the block about to be computed, it
+// keeps the stream `distance` bytes ahead in L2:
+//   - blocks smaller than the distance prefetch their own size at the
+//     distance, so consecutive calls issue every line exactly once;
+//   - larger blocks prefetch the head of the next block, which is where the
+//     hardware streamer has to restart.
+// Prefetches past the range of the thread fall into the first blocks of the
+// next thread, which are read anyway.
+class WeightStreamPrefetch {
+ public:
+  WeightStreamPrefetch(const void* begin, long nbytes, bool enabled)
+      : end((const char*)begin + nbytes),
+        distance(enabled ? weight_prefetch_bytes() : 0) {}
+
+  bool enabled() const {
+    return distance > 0;
+  }
+
+  void operator()(const void* block, long block_bytes) const {
+    if (distance == 0) {
+      return;
+    }
+    auto p = (const char*)block + std::max(block_bytes, distance);
+    auto last = std::min(p + std::min(block_bytes, distance), end);
+    for (; p < last; p += 64) {
+      _mm_prefetch(p, _MM_HINT_T1);
+    }
+  }
+
+ private:
+  const char* end;
+  long distance;
+};
+
+// Hints of the weight that is read after a given one, e.g. the next linear
+// of a decoder layer during decode. They are registered once from the model
+// and looked up by the data pointer of the weight passed to the kernel. The
+// hints only hold weak references to the storages of both weights, a hint is
+// ignored once either of them is freed and dropped at the next registration.
+void set_next_weight(const at::Tensor& weight, const at::Tensor& next);
+void clear_next_weights();
+
+// The next weight of a hint, `storage` keeps it alive while it is prefetched.
+// Empty if there is no live hint for `weight`.
+struct NextWeight {
+  c10::intrusive_ptr<c10::StorageImpl> storage;
+  const char* data = nullptr;
+  long nbytes = 0;
+};
+NextWeight get_next_weight(const void* weight);
+
+// Bytes of the next weight prefetched by each thread, at most its share of
+// it. TPP_NEXT_WEIGHT_PREFETCH_BYTES overrides the default of 4 times the
+// stream distance, 0 disables the prefetch.
+long next_weight_prefetch_bytes();
+
+// Cross-layer prefetch run from the fini_func of a GEMM loop, i.e. by each
+// thread as soon as it finished its share, while the last partial tiles of
+// the other threads are still computing. A thread prefetches into L2 the
+// head of the slice of the next weight it starts with under an even static
+// split of its output blocks, so the next GEMM does not start cold.
+class NextWeightPrefetch {
+ public:
+  NextWeightPrefetch(const void* weight, bool enabled) {
+    if (enabled && next_weight_prefetch_bytes() > 0) {
+      next = get_next_weight(weight);
+    }
+  }
+
+  void operator()() const {
+    if (next.data != nullptr) {
+      prefetch_slice();
+    }
+  }
+
+ private:
+  void prefetch_slice() const;
+
+  NextWeight next;
+};
+
+} // namespace tpp
+} // namespace torch_ipex
+#endif // _TPP_PREFETCH_H_
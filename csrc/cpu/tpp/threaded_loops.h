@@ -5,6 +5,7 @@
 #include <array>
 #include <cassert>
 #include <fstream>
+#include <functional>
 #include <initializer_list>
 #include <iostream>
 #include <sstream>
@@ -115,6 +116,45 @@ typedef void (*par_loop_kernel)(
 
 extern std::unordered_map<std::string, par_loop_kernel> pre_defined_loops;
 
+// How the parallel iterations of a ThreadedLoop are handed out to threads.
+// Static splits them evenly up front, like the generated `omp for` loops.
+// Dynamic starts from the same contiguous split, but each thread takes its
+// iterations one at a time and, once its share is done, steals half of the
+// largest share left on another thread, so ragged and remainder heavy loops
+// do not wait on stragglers. Auto picks Dynamic only when the parallel
+// iterations do not divide evenly across the threads or a loop ends with a
+// remainder block. Default follows TPP_LOOP_SCHEDULE (static, dynamic or
+// auto) and is static when unset.
+enum class LoopSchedule { Default, Static, Dynamic, Auto };
+
+LoopSchedule getDefaultLoopSchedule();
+
+// Physical loop order of a scheme for the dynamic schedule: one letter per
+// logical loop, with the upper case (parallel) loops adjacent. Schemes with
+// blocking levels, barriers or split parallel loops always run statically.
+struct DynamicLoopPlan {
+  bool valid = false;
+  int nLoops = 0;
+  int order[MAX_LOGICAL_LOOPS];
+  int parBegin = 0;
+  int parEnd = 0;
+};
+
+DynamicLoopPlan getDynamicLoopPlan(const std::string& scheme);
+
+bool isImbalancedLoop(LoopSpecs* loopSpecs, const DynamicLoopPlan& plan);
+
+// Runs the loop nest with the dynamic schedule, returns false without
+// running anything if the iteration space is too large for it. Sequential
+// loops outside the parallel ones are separated by barriers, since a block
+// of the next outer iteration may run on another thread.
+bool par_nested_loops_dynamic(
+    LoopSpecs* loopSpecs,
+    const DynamicLoopPlan& plan,
+    std::function<void(int*)> body_func,
+    std::function<void()> init_func,
+    std::function<void()> fini_func);
+
 #if 0
 void par_nested_loops(LoopSpecs *loopSpecs, std::function<void(int*)> body_func, std::function<void()> init_func, std::function<void()> fini_func)
 {
@@ -145,7 +185,8 @@ class LoopingScheme {
         ompforBefore(-1),
         nCollapsed(0),
         nLLBL{0},
-        test_kernel(NULL) {
+        test_kernel(NULL),
+        dynamicPlan(getDynamicLoopPlan(scheme)) {
     int curLoop = 0;
     for (int i = 0; i < (int)scheme.length() - 1; i++) {
       char c = scheme[i];
@@ -214,7 +255,18 @@ class LoopingScheme {
       LoopSpecs* loopSpecs,
       std::function<void(int*)> body_func,
       std::function<void()> init_func,
-      std::function<void()> fini_func) {
+      std::function<void()> fini_func,
+      LoopSchedule schedule = LoopSchedule::Static) {
+    if (schedule == LoopSchedule::Default)
+      schedule = getDefaultLoopSchedule();
+    bool dynamic = dynamicPlan.valid &&
+        (schedule == LoopSchedule::Dynamic ||
+         (schedule == LoopSchedule::Auto &&
+          isImbalancedLoop(loopSpecs, dynamicPlan)));
+    if (dynamic &&
+        par_nested_loops_dynamic(
+            loopSpecs, dynamicPlan, body_func, init_func, fini_func))
+      return;
     test_kernel(loopSpecs, body_func, init_func, fini_func);
   }
 
@@ -231,6 +283,7 @@ class LoopingScheme {
   bool isParallel[MAX_LOOPS];
   int p2lMap[MAX_LOOPS];
   par_loop_kernel test_kernel;
+  DynamicLoopPlan dynamicPlan;
 };
 
 inline LoopingScheme* getLoopingScheme(std::string scheme) {
@@ -263,8 +316,11 @@ class ThreadedLoop {
   but LoopSpecs does not have a default consturctor. So, we added a
   default constructor for LoopSpecs.
   */
-  ThreadedLoop(const LoopSpecs (&bounds)[N], std::string scheme = "")
-      : scheme(scheme) {
+  ThreadedLoop(
+      const LoopSpecs (&bounds)[N],
+      std::string scheme = "",
+      LoopSchedule schedule = LoopSchedule::Default)
+      : scheme(scheme), schedule(schedule) {
     for (size_t i = 0; i < N; ++i) {
       this->bounds[i] = bounds[i];
     }
@@ -275,11 +331,11 @@ class ThreadedLoop {
 
   template <class T>
   void operator()(T func) {
-    loopScheme->call(bounds, func, NULL, NULL);
+    loopScheme->call(bounds, func, NULL, NULL, schedule);
   }
   template <class T, class Ti, class Tf>
   void operator()(T func, Ti init, Tf fini) {
-    loopScheme->call(bounds, func, init, fini);
+    loopScheme->call(bounds, func, init, fini, schedule);
   }
 
   std::string getDefaultScheme() {
@@ -296,6 +352,7 @@ class ThreadedLoop {
  private:
   LoopSpecs bounds[N];
   std::string scheme;
+  LoopSchedule schedule;
   LoopingScheme* loopScheme;
 };
 } // namespace tpp
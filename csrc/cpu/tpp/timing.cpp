@@ -0,0 +1,329 @@
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "timing.h"
+
+namespace torch_ipex {
+namespace tpp {
+
+bool globalTimeline = false;
+
+namespace {
+
+#ifdef PROFILE_TPP
+constexpr bool kProfileTPP = true;
+#else
+constexpr bool kProfileTPP = false;
+#endif
+
+struct TimelineEvent {
+  int scope;
+  int pass;
+  double wall_us;
+  double duration;
+  double flops;
+  std::vector<double> busy;
+};
+
+std::mutex timeline_mutex;
+std::vector<TimelineEvent> timeline_events;
+long timeline_dropped = 0;
+
+// Bounds the memory of a long running timeline, later events are counted as
+// dropped. Override with TPP_TIMELINE_MAX_EVENTS.
+long timeline_max_events() {
+  static const long max_events = [] {
+    const char* val = std::getenv("TPP_TIMELINE_MAX_EVENTS");
+    return val ? std::max(0L, std::strtol(val, nullptr, 10)) : 65536L;
+  }();
+  return max_events;
+}
+
+int timer_threads() {
+  return std::min(omp_get_max_threads(), MAX_THREADS);
+}
+
+// getTime() returns rdtsc ticks scaled by ifreq, the scale to seconds is
+// calibrated once against the steady clock.
+double time_unit_seconds() {
+  static const double unit = [] {
+    auto c0 = std::chrono::steady_clock::now();
+    double t0 = getTime();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    double t1 = getTime();
+    auto c1 = std::chrono::steady_clock::now();
+    double secs = std::chrono::duration<double>(c1 - c0).count();
+    return t1 > t0 ? secs / (t1 - t0) : 0.0;
+  }();
+  return unit;
+}
+
+double wall_clock_us() {
+  return std::chrono::duration<double, std::micro>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+double thread_busy(const Scope& scope, int tid) {
+  double busy = 0.0;
+  for (int i = 0; i < LAST_TIMER; i++) {
+    busy += scope.detailed_timers[tid][i];
+  }
+  return busy;
+}
+
+void reset_scope(Scope& scope) {
+  scope.master_timer = 0.0;
+  memset(scope.detailed_timers, 0, sizeof(scope.detailed_timers));
+  memset(scope.flops, 0, sizeof(scope.flops));
+}
+
+std::string json_escape(const std::string& s) {
+  std::string out;
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      out += ' ';
+    } else {
+      out += c;
+    }
+  }
+  return out;
+}
+
+struct ThreadStats {
+  double min = 0.0;
+  double max = 0.0;
+  double mean = 0.0;
+  // max / mean, 1.0 is a perfectly balanced schedule
+  double imbalance = 0.0;
+};
+
+ThreadStats thread_stats(const std::vector<double>& times) {
+  ThreadStats st;
+  if (times.empty())
+    return st;
+  st.min = *std::min_element(times.begin(), times.end());
+  st.max = *std::max_element(times.begin(), times.end());
+  double sum = 0.0;
+  for (auto t : times)
+    sum += t;
+  st.mean = sum / times.size();
+  st.imbalance = st.mean > 0.0 ? st.max / st.mean : 0.0;
+  return st;
+}
+
+void write_scope_json(
+    std::ostringstream& os,
+    const Scope& scope,
+    int nthr,
+    double unit) {
+  std::vector<double> times(nthr);
+  double flops = 0.0;
+  for (int t = 0; t < nthr; t++) {
+    times[t] = thread_busy(scope, t) * unit;
+    flops += scope.flops[t][0];
+  }
+  auto st = thread_stats(times);
+  // achieved rate over the wall time of the scope, or over the busiest
+  // thread for the time spent outside any scope
+  double wall = scope.master_timer > 0.0 ? scope.master_timer * unit : st.max;
+  os << "{\"name\": \"" << json_escape(scope.name) << "\", \"time\": " << wall
+     << ", \"flops\": " << flops
+     << ", \"gflops\": " << (wall > 0.0 ? flops / wall * 1e-9 : 0.0)
+     << ", \"thread_time\": {\"min\": " << st.min << ", \"max\": " << st.max
+     << ", \"mean\": " << st.mean << "}, \"imbalance\": " << st.imbalance
+     << ", \"threads\": [";
+  for (int t = 0; t < nthr; t++) {
+    os << (t ? ", " : "") << "{\"time\": " << times[t]
+       << ", \"flops\": " << scope.flops[t][0] << ", \"timers\": {";
+    bool first = true;
+    for (int i = 0; i < LAST_TIMER; i++) {
+      if (scope.detailed_timers[t][i] == 0.0)
+        continue;
+      os << (first ? "" : ", ") << "\"" << DebugTimerName(i)
+         << "\": " << scope.detailed_timers[t][i] * unit;
+      first = false;
+    }
+    os << "}}";
+  }
+  os << "]}";
+}
+
+bool scope_is_empty(const Scope& scope, int nthr) {
+  if (scope.master_timer != 0.0)
+    return false;
+  for (int t = 0; t < nthr; t++) {
+    if (thread_busy(scope, t) != 0.0)
+      return false;
+  }
+  return true;
+}
+
+void write_scope_list_json(
+    std::ostringstream& os,
+    const std::vector<Scope>& list,
+    int nthr,
+    double unit) {
+  os << "[";
+  bool first = true;
+  for (auto& scope : list) {
+    if (scope_is_empty(scope, nthr))
+      continue;
+    os << (first ? "" : ", ");
+    write_scope_json(os, scope, nthr, unit);
+    first = false;
+  }
+  os << "]";
+}
+
+} // namespace
+
+void timeline_begin(int scope, TimelineMark& mark) {
+  auto& sc = get_scope_list()[scope];
+  int nthr = timer_threads();
+  mark.wall_us = wall_clock_us();
+  mark.busy.resize(nthr);
+  mark.flops.resize(nthr);
+  for (int t = 0; t < nthr; t++) {
+    mark.busy[t] = thread_busy(sc, t);
+    mark.flops[t] = sc.flops[t][0];
+  }
+}
+
+void timeline_end(int scope, double duration, const TimelineMark& mark) {
+  // enabled while the scope was already running
+  if (mark.busy.empty())
+    return;
+  auto& sc = get_scope_list()[scope];
+  TimelineEvent ev;
+  ev.scope = scope;
+  ev.pass = globalPass;
+  ev.wall_us = mark.wall_us;
+  ev.duration = duration;
+  ev.flops = 0.0;
+  ev.busy.resize(mark.busy.size());
+  for (size_t t = 0; t < mark.busy.size(); t++) {
+    ev.busy[t] = thread_busy(sc, t) - mark.busy[t];
+    ev.flops += sc.flops[t][0] - mark.flops[t];
+  }
+  std::lock_guard<std::mutex> lock(timeline_mutex);
+  if ((long)timeline_events.size() >= timeline_max_events()) {
+    timeline_dropped++;
+    return;
+  }
+  timeline_events.push_back(std::move(ev));
+}
+
+void reset_debug_timers() {
+  for (auto& scope : get_scope_list())
+    reset_scope(scope);
+  for (auto& pass : get_pass_list())
+    reset_scope(pass);
+  std::lock_guard<std::mutex> lock(timeline_mutex);
+  timeline_events.clear();
+  timeline_dropped = 0;
+}
+
+void enable_debug_timeline(bool enable) {
+  if (enable) {
+    // calibrate outside of any timed region
+    time_unit_seconds();
+  }
+  globalTimeline = enable;
+}
+
+// Accumulated timers of every pass and scope as JSON, all times in seconds:
+// {"profile_tpp": bool, "num_threads": N,
+//  "passes" / "scopes": [{"name", "time", "flops", "gflops",
+//    "thread_time": {"min", "max", "mean"}, "imbalance",
+//    "threads": [{"time", "flops", "timers": {timer name: time}}]}]}
+// Scopes and passes that never ran are left out. Without PROFILE_TPP the
+// timers are compiled out and the lists stay empty.
+std::string debug_timers_json() {
+  int nthr = timer_threads();
+  double unit = time_unit_seconds();
+  std::ostringstream os;
+  os.precision(9);
+  os << "{\"profile_tpp\": " << (kProfileTPP ? "true" : "false")
+     << ", \"num_threads\": " << nthr << ", \"passes\": ";
+  write_scope_list_json(os, get_pass_list(), nthr, unit);
+  os << ", \"scopes\": ";
+  write_scope_list_json(os, get_scope_list(), nthr, unit);
+  os << "}";
+  return os.str();
+}
+
+// Recorded timeline in the Chrome trace event format. Every scope invocation
+// is a complete event on tid 0 named like its RECORD_FUNCTION span, with the
+// flops, GFLOP/s and thread imbalance as args, and each OpenMP thread gets a
+// row (tid 1 + thread) showing its busy time inside that invocation. The pid
+// is the process id and timestamps are wall-clock microseconds since the
+// epoch, so the events can be merged with other traces of the same process.
+std::string debug_timeline_chrome_trace() {
+  const char* pass_names[] = {"OTH", "FWD", "BWD", "UPD"};
+  int nthr = timer_threads();
+  double unit = time_unit_seconds();
+#ifdef _WIN32
+  auto pid = _getpid();
+#else
+  auto pid = getpid();
+#endif
+  auto& scopes = get_scope_list();
+  std::ostringstream os;
+  os.precision(15);
+  os << "{\"traceEvents\": [";
+  os << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": " << pid
+     << ", \"args\": {\"name\": \"tpp\"}}";
+  os << ", {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << pid
+     << ", \"tid\": 0, \"args\": {\"name\": \"tpp scopes\"}}";
+  for (int t = 0; t < nthr; t++) {
+    os << ", {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << pid
+       << ", \"tid\": " << t + 1 << ", \"args\": {\"name\": \"omp thread " << t
+       << "\"}}";
+  }
+  std::lock_guard<std::mutex> lock(timeline_mutex);
+  for (auto& ev : timeline_events) {
+    auto name = json_escape(scopes[ev.scope].name);
+    double dur_us = ev.duration * unit * 1e6;
+    std::vector<double> busy_us(ev.busy.size());
+    for (size_t t = 0; t < ev.busy.size(); t++)
+      busy_us[t] = ev.busy[t] * unit * 1e6;
+    auto st = thread_stats(busy_us);
+    os << ", {\"name\": \"" << name
+       << "\", \"cat\": \"tpp_scope\", \"ph\": \"X\", \"pid\": " << pid
+       << ", \"tid\": 0, \"ts\": " << ev.wall_us << ", \"dur\": " << dur_us
+       << ", \"args\": {\"pass\": \"" << pass_names[ev.pass]
+       << "\", \"flops\": " << ev.flops << ", \"gflops\": "
+       << (dur_us > 0.0 ? ev.flops / dur_us * 1e-3 : 0.0)
+       << ", \"imbalance\": " << st.imbalance << "}}";
+    for (size_t t = 0; t < busy_us.size(); t++) {
+      if (busy_us[t] <= 0.0)
+        continue;
+      os << ", {\"name\": \"" << name
+         << "\", \"cat\": \"tpp_thread\", \"ph\": \"X\", \"pid\": " << pid
+         << ", \"tid\": " << t + 1 << ", \"ts\": " << ev.wall_us
+         << ", \"dur\": " << busy_us[t] << "}";
+    }
+  }
+  os << "], \"displayTimeUnit\": \"ms\", \"otherData\": {\"dropped_events\": "
+     << timeline_dropped << "}}";
+  return os.str();
+}
+
+} // namespace tpp
+} // namespace torch_ipex
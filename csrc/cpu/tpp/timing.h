@@ -21,6 +21,7 @@ enum DebugTimer {
   EW_MUL,
   EW_ZERO,
   EW_RED,
+  ROPE,
   OPTIM,
   LAST_TIMER
 };
@@ -43,6 +44,7 @@ inline const char* DebugTimerName(int t) {
       "MUL",
       "ZERO",
       "REDUCE",
+      "ROPE",
       "OPTIM",
       "LAST_TIMER"};
   return names[t];
@@ -83,6 +85,27 @@ inline int register_scope(std::string name) {
   return idx;
 }
 
+// Per invocation timeline of the registered scopes, recorded only while
+// enabled through enable_debug_timeline(). Each event keeps the wall-clock
+// start, the duration and the busy time of every thread spent in TPPs inside
+// the scope, so imbalanced ThreadedLoop schedules stand out.
+extern bool globalTimeline;
+
+struct TimelineMark {
+  double wall_us = 0.0;
+  std::vector<double> busy;
+  std::vector<double> flops;
+};
+
+void timeline_begin(int scope, TimelineMark& mark);
+void timeline_end(int scope, double duration, const TimelineMark& mark);
+
+// Machine readable exports of the timers, see timing.cpp for the formats.
+void reset_debug_timers();
+std::string debug_timers_json();
+void enable_debug_timeline(bool enable);
+std::string debug_timeline_chrome_trace();
+
 #ifdef PROFILE_TPP
 #define REGISTER_LOCAL_SCOPE(id, name) static int sc_##id = register_scope(name)
 #define REGISTER_SCOPE(id, name) int sc_##id = register_scope(name)
@@ -123,9 +146,13 @@ class GlobalScope {
   GlobalScope(int t) : oldScope(globalScope), start(getTime()) {
     PCL_ASSERT(t < (int)get_scope_list().size(), "Invalid scope initialized");
     globalScope = t;
+    if (globalTimeline)
+      timeline_begin(t, mark);
   }
   ~GlobalScope() {
     auto time = getTime() - start;
+    if (globalTimeline)
+      timeline_end(globalScope, time, mark);
     auto& scope = get_scope_list()[globalScope];
     scope.master_timer += time;
     if (oldScope != 0) {
@@ -137,6 +164,7 @@ class GlobalScope {
   }
   int oldScope;
   double start;
+  TimelineMark mark;
 };
 
 class GlobalPass {
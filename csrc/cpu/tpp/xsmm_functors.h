@@ -4050,6 +4050,219 @@ class LayerNormBwdTPP {
   Eqn dgamma_func, dbeta_func, db_func, ds_func, din_func;
 };
 
+template <typename T>
+class RMSNormFwdTPP {
+ public:
+  RMSNormFwdTPP() {}
+  RMSNormFwdTPP(int S1, int S2, int S3, float eps)
+      : S1(S1),
+        S2(S2),
+        S3(S3),
+        eps(eps),
+        reduce_cols_kernel(
+            S1,
+            S3,
+            S2 * S3,
+            S3,
+            XsmmDtype<T>(),
+            LIBXSMM_DATATYPE_F32,
+            LIBXSMM_DATATYPE_F32,
+            LIBXSMM_MELTW_FLAG_UNARY_REDUCE_COLS,
+            LIBXSMM_MELTW_TYPE_UNARY_REDUCE_X2_OP_ADD),
+        reduce_rows_kernel(
+            1,
+            S3,
+            S3,
+            1,
+            LIBXSMM_DATATYPE_F32,
+            LIBXSMM_DATATYPE_F32,
+            LIBXSMM_DATATYPE_F32,
+            LIBXSMM_MELTW_FLAG_UNARY_REDUCE_ROWS,
+            LIBXSMM_MELTW_TYPE_UNARY_REDUCE_X_OP_ADD) {}
+  void operator()(T* inp, T* gamma, float* rstd, T* out) {
+    LIBXSMM_ALIGNED(float tmp[S3], 64);
+    const float c = 1.0 / ((float)S1 * S3);
+    float v;
+    for (int s2 = 0; s2 < S2; s2++) {
+      reduce_cols_kernel((void*)&inp[s2 * S3], (void*)tmp);
+      reduce_rows_kernel((void*)tmp, (void*)&v);
+      v = 1.0f / ((float)sqrt(v * c + eps));
+      rstd[s2] = v;
+      scale(&inp[s2 * S3], gamma, v, &out[s2 * S3]);
+    }
+  }
+  void ref(T* pinp, T* pgamma, float* rstd, T* pout) {
+    int s1, s2, s3;
+    LIBXSMM_VLA_DECL(3, T, inp, pinp, S2, S3);
+    for (s2 = 0; s2 < S2; s2++) {
+      float v = 0;
+      float c = 1.0 / (S1 * S3);
+      for (s1 = 0; s1 < S1; s1++) {
+        for (s3 = 0; s3 < S3; s3++) {
+          float x = LIBXSMM_VLA_ACCESS(3, inp, s1, s2, s3, S2, S3);
+          v += x * x;
+        }
+      }
+      v = 1.0f / ((float)sqrt(v * c + eps));
+      rstd[s2] = v;
+      scale(&pinp[s2 * S3], pgamma, v, &pout[s2 * S3]);
+    }
+  }
+
+ private:
+  // out[s1][s2][:] = inp[s1][s2][:] * rstd * gamma[s1][:] for one row s2
+  void scale(T* inp, T* gamma, float v, T* out) {
+    for (int s1 = 0; s1 < S1; s1++) {
+      for (int s3 = 0; s3 < S3; s3++) {
+        out[s1 * S2 * S3 + s3] =
+            (float)inp[s1 * S2 * S3 + s3] * v * (float)gamma[s1 * S3 + s3];
+      }
+    }
+  }
+  int S1, S2, S3;
+  float eps;
+  UnaryTPP reduce_cols_kernel;
+  UnaryTPP reduce_rows_kernel;
+};
+
+template <typename T>
+class RMSNormBwdTPP {
+ public:
+  RMSNormBwdTPP() {}
+  RMSNormBwdTPP(int S1, int S2, int S3) : S1(S1), S2(S2), S3(S3) {}
+  // With y = x * rstd * gamma and x_hat = x * rstd:
+  //   dgamma += dout * x_hat
+  //   din = rstd * (dout * gamma - x_hat * mean(dout * gamma * x_hat))
+  void operator()(
+      T* dout,
+      T* inp,
+      float* rstd,
+      T* gamma,
+      T* din,
+      float* dgamma) {
+    const float c = 1.0 / ((float)S1 * S3);
+    for (int s2 = 0; s2 < S2; s2++) {
+      const float r = rstd[s2];
+      float ds = 0.0f;
+      for (int s1 = 0; s1 < S1; s1++) {
+        long off = (long)s1 * S2 * S3 + s2 * S3;
+        for (int s3 = 0; s3 < S3; s3++) {
+          float g = (float)dout[off + s3];
+          float x_hat = (float)inp[off + s3] * r;
+          dgamma[s1 * S3 + s3] += g * x_hat;
+          ds += g * (float)gamma[s1 * S3 + s3] * x_hat;
+        }
+      }
+      ds *= c;
+      for (int s1 = 0; s1 < S1; s1++) {
+        long off = (long)s1 * S2 * S3 + s2 * S3;
+        for (int s3 = 0; s3 < S3; s3++) {
+          float g = (float)dout[off + s3] * (float)gamma[s1 * S3 + s3];
+          float x_hat = (float)inp[off + s3] * r;
+          din[off + s3] = r * (g - x_hat * ds);
+        }
+      }
+    }
+  }
+  void ref(T* dout, T* inp, float* rstd, T* gamma, T* din, float* dgamma) {
+    (*this)(dout, inp, rstd, gamma, din, dgamma);
+  }
+
+ private:
+  int S1, S2, S3;
+};
+
+// Rotary position embedding (rotate-half form) over `rows` tokens of one
+// head, with per-token cos / sin tables of width H:
+//   out[:H/2] = x[:H/2] * cos[:H/2] - x[H/2:] * sin[:H/2]
+//   out[H/2:] = x[H/2:] * cos[H/2:] + x[:H/2] * sin[H/2:]
+// The backward applies the transposed rotation to the incoming gradient.
+template <typename T>
+class RotaryEmbTPP {
+ public:
+  RotaryEmbTPP() {}
+  RotaryEmbTPP(int rows, int H, bool backward = false)
+      : rows(rows), H(H), backward(backward) {}
+  void operator()(T* in, float* cos, float* sin, T* out) {
+    const int H2 = H / 2;
+    const float sign = backward ? -1.0f : 1.0f;
+    for (int r = 0; r < rows; r++) {
+      T* x = &in[r * H];
+      T* y = &out[r * H];
+      float* c = &cos[r * H];
+      float* s = &sin[r * H];
+      for (int h = 0; h < H2; h++) {
+        float x1 = x[h];
+        float x2 = x[h + H2];
+        // forward uses sin of the output half, backward of the input half
+        float s1 = backward ? s[h + H2] : s[h];
+        float s2 = backward ? s[h] : s[h + H2];
+        y[h] = x1 * c[h] - sign * x2 * s1;
+        y[h + H2] = x2 * c[h + H2] + sign * x1 * s2;
+      }
+    }
+  }
+  void ref(T* in, float* cos, float* sin, T* out) {
+    (*this)(in, cos, sin, out);
+  }
+
+ private:
+  int rows = 0;
+  int H = 0;
+  bool backward = false;
+};
+
+// SwiGLU gating: out = silu(gate) * up
+template <typename T>
+class SwiGLUFwdTPP {
+ public:
+  SwiGLUFwdTPP() {}
+  SwiGLUFwdTPP(int N) : SwiGLUFwdTPP(1, N) {}
+  SwiGLUFwdTPP(int rows, int cols)
+      : rows(rows), cols(cols), silu(rows, cols), mul(rows, cols) {}
+  void operator()(T* gate, T* up, T* out) {
+    T tmp[rows * cols];
+    silu(gate, tmp);
+    mul(tmp, up, out);
+  }
+  void ref(T* gate, T* up, T* out) {
+    for (int i = 0; i < rows * cols; i++) {
+      float g = gate[i];
+      out[i] = g / (1.0f + expf(-g)) * (float)up[i];
+    }
+  }
+
+ private:
+  int rows = 0;
+  int cols = 0;
+  SiLUFwdTPP<T> silu;
+  MulTPP<T, T> mul;
+};
+
+template <typename T>
+class SwiGLUBwdTPP {
+ public:
+  SwiGLUBwdTPP() {}
+  SwiGLUBwdTPP(int N) : N(N) {}
+  // dup = dout * silu(gate)
+  // dgate = dout * up * sig(gate) * (1 + gate * (1 - sig(gate)))
+  void operator()(T* dout, T* gate, T* up, T* dgate, T* dup) {
+    for (int i = 0; i < N; i++) {
+      float g = gate[i];
+      float d = dout[i];
+      float sig = 1.0f / (1.0f + expf(-g));
+      dup[i] = d * g * sig;
+      dgate[i] = d * (float)up[i] * sig * (1.0f + g * (1.0f - sig));
+    }
+  }
+  void ref(T* dout, T* gate, T* up, T* dgate, T* dup) {
+    (*this)(dout, gate, up, dgate, dup);
+  }
+
+ private:
+  int N = 0;
+};
+
 template <typename T>
 class GroupNormFwdTPP {
  public:
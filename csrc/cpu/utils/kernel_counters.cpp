@@ -0,0 +1,158 @@
+#include "kernel_counters.h"
+
+#include <memory>
+#include <mutex>
+
+namespace torch_ipex {
+namespace utils {
+
+std::atomic<bool> kernel_counters_on{false};
+
+namespace {
+
+constexpr int kNumKinds = static_cast<int>(KernelCounterKind::NumKinds);
+
+// Names of the profiler events opened around the counted calls, they must
+// outlive the events.
+const char* const kCounterNames[kNumKinds] = {
+    "woq_linear",
+    "tpp_linear",
+    "paged_attention",
+    "indirect_kv_cache_attention"};
+const char* const kProfilerNames[kNumKinds] = {
+    "ipex::roofline::woq_linear",
+    "ipex::roofline::tpp_linear",
+    "ipex::roofline::paged_attention",
+    "ipex::roofline::indirect_kv_cache_attention"};
+
+// One cache line per kind so that threads never write to a shared line.
+struct alignas(64) KernelCounterSlot {
+  std::atomic<int64_t> calls{0};
+  std::atomic<int64_t> weight_bytes{0};
+  std::atomic<int64_t> kv_bytes{0};
+  std::atomic<int64_t> activation_bytes{0};
+  std::atomic<int64_t> flops{0};
+  std::atomic<int64_t> nanoseconds{0};
+};
+
+struct KernelCounterTable {
+  KernelCounterSlot slots[kNumKinds];
+};
+
+// Tables are owned by the registry and outlive their threads, so the counts
+// of finished threads are still reported.
+std::mutex& registry_mutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::vector<std::unique_ptr<KernelCounterTable>>& registry() {
+  static std::vector<std::unique_ptr<KernelCounterTable>> tables;
+  return tables;
+}
+
+KernelCounterTable& local_table() {
+  thread_local KernelCounterTable* table = [] {
+    std::lock_guard<std::mutex> lock(registry_mutex());
+    registry().emplace_back(new KernelCounterTable());
+    return registry().back().get();
+  }();
+  return *table;
+}
+
+} // namespace
+
+void set_kernel_counters_enabled(bool enabled) {
+  kernel_counters_on.store(enabled, std::memory_order_relaxed);
+}
+
+const char* kernel_counter_name(KernelCounterKind kind) {
+  return kCounterNames[static_cast<int>(kind)];
+}
+
+void record_kernel_traffic(
+    KernelCounterKind kind,
+    const KernelTraffic& traffic,
+    double seconds) {
+  auto& slot = local_table().slots[static_cast<int>(kind)];
+  constexpr auto relaxed = std::memory_order_relaxed;
+  slot.calls.fetch_add(1, relaxed);
+  slot.weight_bytes.fetch_add(traffic.weight_bytes, relaxed);
+  slot.kv_bytes.fetch_add(traffic.kv_bytes, relaxed);
+  slot.activation_bytes.fetch_add(traffic.activation_bytes, relaxed);
+  slot.flops.fetch_add(traffic.flops, relaxed);
+  slot.nanoseconds.fetch_add(static_cast<int64_t>(seconds * 1e9), relaxed);
+}
+
+void reset_kernel_counters() {
+  constexpr auto relaxed = std::memory_order_relaxed;
+  std::lock_guard<std::mutex> lock(registry_mutex());
+  for (auto& table : registry()) {
+    for (auto& slot : table->slots) {
+      slot.calls.store(0, relaxed);
+      slot.weight_bytes.store(0, relaxed);
+      slot.kv_bytes.store(0, relaxed);
+      slot.activation_bytes.store(0, relaxed);
+      slot.flops.store(0, relaxed);
+      slot.nanoseconds.store(0, relaxed);
+    }
+  }
+}
+
+std::vector<KernelCounterStats> get_kernel_counters() {
+  constexpr auto relaxed = std::memory_order_relaxed;
+  std::vector<KernelCounterStats> stats(kNumKinds);
+  int64_t nanoseconds[kNumKinds] = {0};
+  {
+    std::lock_guard<std::mutex> lock(registry_mutex());
+    for (auto& table : registry()) {
+      for (int k = 0; k < kNumKinds; k++) {
+        auto& slot = table->slots[k];
+        stats[k].calls += slot.calls.load(relaxed);
+        stats[k].traffic.weight_bytes += slot.weight_bytes.load(relaxed);
+        stats[k].traffic.kv_bytes += slot.kv_bytes.load(relaxed);
+        stats[k].traffic.activation_bytes +=
+            slot.activation_bytes.load(relaxed);
+        stats[k].traffic.flops += slot.flops.load(relaxed);
+        nanoseconds[k] += slot.nanoseconds.load(relaxed);
+      }
+    }
+  }
+  for (int k = 0; k < kNumKinds; k++) {
+    stats[k].name = kCounterNames[k];
+    stats[k].seconds = nanoseconds[k] * 1e-9;
+  }
+  return stats;
+}
+
+void KernelCounterScope::start(const KernelTraffic& traffic) {
+  traffic_ = traffic;
+  started_ = true;
+  guard_.emplace(at::RecordScope::USER_SCOPE);
+  if (guard_->isActive()) {
+    auto name = kProfilerNames[static_cast<int>(kind_)];
+    if (guard_->needsInputs()) {
+      std::vector<c10::IValue> inputs = {
+          traffic.weight_bytes,
+          traffic.kv_bytes,
+          traffic.activation_bytes,
+          traffic.flops};
+      guard_->before(name, c10::ArrayRef<const c10::IValue>(inputs));
+    } else {
+      guard_->before(name);
+    }
+  }
+  start_ = std::chrono::steady_clock::now();
+}
+
+KernelCounterScope::~KernelCounterScope() {
+  if (!started_) {
+    return;
+  }
+  auto end = std::chrono::steady_clock::now();
+  record_kernel_traffic(
+      kind_, traffic_, std::chrono::duration<double>(end - start_).count());
+}
+
+} // namespace utils
+} // namespace torch_ipex
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <ATen/record_function.h>
+#include <Macros.h>
+#include <c10/util/Optional.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace torch_ipex {
+namespace utils {
+
+// Opt-in traffic counters of the memory bound LLM decode kernels. While
+// enabled, every call of an instrumented kernel adds the bytes it moves and
+// the FLOPs it performs to a per-thread counter table, which can be summed up
+// per kernel kind to compare the achieved bandwidth against the peak of the
+// machine. When disabled, a call only pays one relaxed atomic load.
+enum class KernelCounterKind : int {
+  WoqLinear = 0,
+  TppLinear,
+  PagedAttention,
+  IndirectKVCacheAttention,
+  NumKinds
+};
+
+// Bytes are the minimum traffic of one call, i.e. every operand read and
+// every result written once.
+struct KernelTraffic {
+  int64_t weight_bytes = 0;
+  int64_t kv_bytes = 0;
+  int64_t activation_bytes = 0;
+  int64_t flops = 0;
+};
+
+struct KernelCounterStats {
+  std::string name;
+  int64_t calls = 0;
+  KernelTraffic traffic;
+  double seconds = 0.0;
+};
+
+inline int64_t kernel_tensor_bytes(const at::Tensor& t) {
+  return t.defined() ? t.numel() * t.element_size() : 0;
+}
+
+inline int64_t kernel_tensor_bytes(at::TensorList tensors) {
+  int64_t bytes = 0;
+  for (auto& t : tensors) {
+    bytes += kernel_tensor_bytes(t);
+  }
+  return bytes;
+}
+
+extern std::atomic<bool> kernel_counters_on;
+
+inline bool kernel_counters_enabled() {
+  return kernel_counters_on.load(std::memory_order_relaxed);
+}
+
+IPEX_API void set_kernel_counters_enabled(bool enabled);
+IPEX_API void reset_kernel_counters();
+IPEX_API std::vector<KernelCounterStats> get_kernel_counters();
+IPEX_API const char* kernel_counter_name(KernelCounterKind kind);
+void record_kernel_traffic(
+    KernelCounterKind kind,
+    const KernelTraffic& traffic,
+    double seconds);
+
+// Times one kernel call and records it on destruction. The traffic is only
+// computed by the caller when counting is enabled:
+//
+//   KernelCounterScope counter(KernelCounterKind::WoqLinear);
+//   if (counter.enabled())
+//     counter.start(woq_linear_traffic(...));
+//   return kernel(...);
+//
+// If the profiler is running, start() also opens an "ipex::roofline::<kind>"
+// event around the call whose inputs are the weight, kv and activation bytes
+// and the FLOPs, shown as concrete inputs with record_shapes=True.
+class KernelCounterScope {
+ public:
+  explicit KernelCounterScope(KernelCounterKind kind)
+      : kind_(kind), enabled_(kernel_counters_enabled()) {}
+  KernelCounterScope(const KernelCounterScope&) = delete;
+  KernelCounterScope& operator=(const KernelCounterScope&) = delete;
+  ~KernelCounterScope();
+
+  bool enabled() const {
+    return enabled_;
+  }
+  void start(const KernelTraffic& traffic);
+
+ private:
+  KernelCounterKind kind_;
+  bool enabled_;
+  bool started_ = false;
+  KernelTraffic traffic_;
+  std::chrono::steady_clock::time_point start_;
+  c10::optional<at::RecordFunction> guard_;
+};
+
+} // namespace utils
+} // namespace torch_ipex
@@ -0,0 +1,306 @@
+#include "long_lived_alloc.h"
+
+#include <c10/util/accumulate.h>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+namespace torch_ipex {
+namespace utils {
+
+namespace {
+
+constexpr int64_t k2MB = 2L << 20;
+constexpr int64_t k1GB = 1L << 30;
+// Not in older libc headers.
+constexpr int kMapHugeShift = 26;
+constexpr int kMpolPreferred = 1;
+
+struct HugePageConfig {
+  std::atomic<int> mode;
+  std::atomic<int64_t> min_bytes;
+
+  HugePageConfig() {
+    const char* env_mode = getenv("IPEX_HUGE_PAGES");
+    mode = static_cast<int>(
+        env_mode ? parse_huge_page_mode(env_mode) : HugePageMode::Off);
+    const char* env_min = getenv("IPEX_HUGE_PAGES_MIN_BYTES");
+    min_bytes = env_min ? std::atoll(env_min) : k2MB;
+  }
+};
+
+HugePageConfig& config() {
+  static HugePageConfig config;
+  return config;
+}
+
+std::mutex& mappings_mutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::unordered_map<void*, LongLivedAllocation>& mappings() {
+  static std::unordered_map<void*, LongLivedAllocation> mappings;
+  return mappings;
+}
+
+int64_t round_up(int64_t n, int64_t align) {
+  return (n + align - 1) / align * align;
+}
+
+#ifndef _WIN32
+
+// Node of the calling thread, which owns the buffer.
+int current_node() {
+  unsigned cpu = 0, node = 0;
+  if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) {
+    return -1;
+  }
+  return static_cast<int>(node);
+}
+
+void prefer_node(void* addr, int64_t len, int node) {
+  constexpr int kMaxNodes = 1024;
+  constexpr int kBitsPerWord = 8 * sizeof(unsigned long);
+  if (node < 0 || node >= kMaxNodes) {
+    return;
+  }
+  unsigned long mask[kMaxNodes / kBitsPerWord] = {0};
+  mask[node / kBitsPerWord] = 1UL << (node % kBitsPerWord);
+  // Best effort, the pages are then first touched on the allocating node.
+  syscall(SYS_mbind, addr, len, kMpolPreferred, mask, kMaxNodes + 1, 0);
+}
+
+void* map_explicit(int64_t len, HugePageMode mode) {
+  int page_shift = mode == HugePageMode::Explicit1G ? 30 : 21;
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB |
+      (page_shift << kMapHugeShift);
+  void* p = mmap(nullptr, len, PROT_READ | PROT_WRITE, flags, -1, 0);
+  return p == MAP_FAILED ? nullptr : p;
+}
+
+// 2MB aligned so that the whole mapping can be backed by huge pages.
+void* map_transparent(int64_t len) {
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+  void* raw = mmap(nullptr, len + k2MB, PROT_READ | PROT_WRITE, flags, -1, 0);
+  if (raw == MAP_FAILED) {
+    return nullptr;
+  }
+  auto begin = reinterpret_cast<uintptr_t>(raw);
+  auto aligned = static_cast<uintptr_t>(round_up(begin, k2MB));
+  if (aligned > begin) {
+    munmap(raw, aligned - begin);
+  }
+  auto tail = begin + len + k2MB - (aligned + len);
+  if (tail > 0) {
+    munmap(reinterpret_cast<void*>(aligned + len), tail);
+  }
+  void* p = reinterpret_cast<void*>(aligned);
+  madvise(p, len, MADV_HUGEPAGE);
+  return p;
+}
+
+// Faults every page in parallel, which is much faster than the single
+// threaded MAP_POPULATE for hundreds of GB.
+void prefault(void* addr, int64_t len) {
+  constexpr int64_t kPage = 4096;
+  auto p = static_cast<volatile char*>(addr);
+#pragma omp parallel for schedule(static)
+  for (int64_t off = 0; off < len; off += kPage) {
+    p[off] = 0;
+  }
+}
+
+int64_t smaps_huge_bytes(void* addr, HugePageMode mode) {
+  std::ifstream smaps("/proc/self/smaps");
+  auto target = reinterpret_cast<uintptr_t>(addr);
+  const std::string key = mode == HugePageMode::Transparent
+      ? "AnonHugePages:"
+      : "Private_Hugetlb:";
+  std::string line;
+  bool in_vma = false;
+  while (std::getline(smaps, line)) {
+    uintptr_t begin = 0, end = 0;
+    char dash = 0;
+    std::istringstream header(line);
+    if (header >> std::hex >> begin >> dash >> end && dash == '-') {
+      in_vma = begin <= target && target < end;
+      continue;
+    }
+    if (in_vma && line.compare(0, key.size(), key) == 0) {
+      int64_t kb = 0;
+      std::istringstream(line.substr(key.size())) >> kb;
+      return kb * 1024;
+    }
+  }
+  return 0;
+}
+
+#endif
+
+void release_long_lived(void* p) {
+  int64_t len = 0;
+  {
+    std::lock_guard<std::mutex> lock(mappings_mutex());
+    auto it = mappings().find(p);
+    if (it == mappings().end()) {
+      return;
+    }
+    len = it->second.mapped_bytes;
+    mappings().erase(it);
+  }
+#ifndef _WIN32
+  munmap(p, len);
+#endif
+}
+
+} // namespace
+
+HugePageMode parse_huge_page_mode(const std::string& mode) {
+  if (mode == "thp") {
+    return HugePageMode::Transparent;
+  } else if (mode == "2mb") {
+    return HugePageMode::Explicit2M;
+  } else if (mode == "1gb") {
+    return HugePageMode::Explicit1G;
+  }
+  TORCH_CHECK(
+      mode == "off" || mode.empty(),
+      "Unknown huge page mode ",
+      mode,
+      ", expected one of off, thp, 2mb and 1gb");
+  return HugePageMode::Off;
+}
+
+const char* huge_page_mode_name(HugePageMode mode) {
+  switch (mode) {
+    case HugePageMode::Transparent:
+      return "thp";
+    case HugePageMode::Explicit2M:
+      return "2mb";
+    case HugePageMode::Explicit1G:
+      return "1gb";
+    default:
+      return "off";
+  }
+}
+
+void set_huge_page_mode(HugePageMode mode, int64_t min_bytes) {
+  config().mode = static_cast<int>(mode);
+  if (min_bytes >= 0) {
+    config().min_bytes = min_bytes;
+  }
+}
+
+HugePageMode get_huge_page_mode() {
+  return static_cast<HugePageMode>(config().mode.load());
+}
+
+int64_t get_huge_page_min_bytes() {
+  return config().min_bytes.load();
+}
+
+at::Tensor empty_long_lived(
+    at::IntArrayRef sizes,
+    const at::TensorOptions& options) {
+  auto mode = get_huge_page_mode();
+  int64_t numel = c10::multiply_integers(sizes);
+  int64_t nbytes = numel * options.dtype().itemsize();
+#ifdef _WIN32
+  mode = HugePageMode::Off;
+#endif
+  if (mode == HugePageMode::Off || options.device().type() != c10::kCPU ||
+      nbytes == 0 || nbytes < get_huge_page_min_bytes()) {
+    return at::empty(sizes, options);
+  }
+#ifndef _WIN32
+  LongLivedAllocation alloc;
+  alloc.bytes = nbytes;
+  alloc.node = current_node();
+  void* p = nullptr;
+  if (mode != HugePageMode::Transparent) {
+    alloc.mapped_bytes =
+        round_up(nbytes, mode == HugePageMode::Explicit1G ? k1GB : k2MB);
+    p = map_explicit(alloc.mapped_bytes, mode);
+    if (p == nullptr) {
+      static std::once_flag warned;
+      std::call_once(warned, [&] {
+        TORCH_WARN(
+            "IPEX_HUGE_PAGES=",
+            huge_page_mode_name(mode),
+            ": not enough explicit huge pages reserved, falling back to "
+            "transparent huge pages");
+      });
+    }
+  }
+  if (p == nullptr) {
+    mode = HugePageMode::Transparent;
+    alloc.mapped_bytes = round_up(nbytes, k2MB);
+    p = map_transparent(alloc.mapped_bytes);
+  }
+  if (p == nullptr) {
+    return at::empty(sizes, options);
+  }
+  alloc.address = reinterpret_cast<int64_t>(p);
+  alloc.mode = mode;
+  prefer_node(p, alloc.mapped_bytes, alloc.node);
+  prefault(p, alloc.mapped_bytes);
+  {
+    std::lock_guard<std::mutex> lock(mappings_mutex());
+    mappings()[p] = alloc;
+  }
+  return at::from_blob(p, sizes, release_long_lived, options);
+#else
+  return at::empty(sizes, options);
+#endif
+}
+
+at::Tensor to_long_lived(const at::Tensor& t) {
+  if (get_huge_page_mode() == HugePageMode::Off || t.nbytes() == 0 ||
+      (int64_t)t.nbytes() < get_huge_page_min_bytes() ||
+      t.device().type() != c10::kCPU) {
+    return t;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mappings_mutex());
+    if (mappings().count(const_cast<void*>(t.storage().data()))) {
+      return t;
+    }
+  }
+  auto result = empty_long_lived(t.sizes(), t.options());
+  result.copy_(t);
+  return result;
+}
+
+std::vector<LongLivedAllocation> get_long_lived_allocations() {
+  std::vector<LongLivedAllocation> result;
+  {
+    std::lock_guard<std::mutex> lock(mappings_mutex());
+    for (auto& m : mappings()) {
+      result.push_back(m.second);
+    }
+  }
+#ifndef _WIN32
+  for (auto& alloc : result) {
+    alloc.huge_bytes = smaps_huge_bytes(
+        reinterpret_cast<void*>(alloc.address), alloc.mode);
+  }
+#endif
+  return result;
+}
+
+} // namespace utils
+} // namespace torch_ipex
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <Macros.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace torch_ipex {
+namespace utils {
+
+// Backing of the buffers that live as long as the model: packed weights of
+// the linears (oneDNN, TPP blocked and WoQ packed) and the indirect access
+// KV cache. With hundreds of GB of them, TLB misses and first touch page
+// faults show up in decode latency and warmup, so they can be mapped on huge
+// pages and pre-faulted in parallel on the NUMA node of the allocating
+// thread. Explicit huge pages fall back to transparent ones if the pool of
+// the requested size is exhausted.
+enum class HugePageMode : int {
+  Off = 0, // default CPU allocator
+  Transparent, // 2MB aligned anonymous mapping with MADV_HUGEPAGE
+  Explicit2M, // MAP_HUGETLB with 2MB pages
+  Explicit1G, // MAP_HUGETLB with 1GB pages
+};
+
+// The mode is read from IPEX_HUGE_PAGES (off, thp, 2mb or 1gb, default off)
+// and buffers smaller than IPEX_HUGE_PAGES_MIN_BYTES (default 2MB) always use
+// the default allocator.
+IPEX_API void set_huge_page_mode(HugePageMode mode, int64_t min_bytes = -1);
+IPEX_API HugePageMode get_huge_page_mode();
+IPEX_API int64_t get_huge_page_min_bytes();
+IPEX_API HugePageMode parse_huge_page_mode(const std::string& mode);
+IPEX_API const char* huge_page_mode_name(HugePageMode mode);
+
+// at::empty for a long-lived buffer. Only CPU tensors of at least the
+// minimum size get a huge page mapping, which is unmapped with the storage.
+IPEX_API at::Tensor empty_long_lived(
+    at::IntArrayRef sizes,
+    const at::TensorOptions& options);
+
+// Returns a contiguous copy of `t` in a long-lived buffer, or `t` itself if
+// it would not get a huge page mapping or already has one.
+IPEX_API at::Tensor to_long_lived(const at::Tensor& t);
+
+// One live huge page mapping. huge_bytes is the part of it actually backed
+// by huge pages as reported by /proc/self/smaps, for transparent huge pages
+// it is taken from the whole VMA holding the buffer, which the kernel may
+// have merged with an adjacent one.
+struct LongLivedAllocation {
+  int64_t address = 0;
+  int64_t bytes = 0;
+  int64_t mapped_bytes = 0;
+  HugePageMode mode = HugePageMode::Off;
+  int node = -1;
+  int64_t huge_bytes = 0;
+};
+
+IPEX_API std::vector<LongLivedAllocation> get_long_lived_allocations();
+
+} // namespace utils
+} // namespace torch_ipex
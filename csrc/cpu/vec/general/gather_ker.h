@@ -0,0 +1,238 @@
+#pragma once
+
+#include <ATen/cpu/vec/vec.h>
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace torch_ipex {
+namespace cpu {
+namespace kernel {
+
+// Shared row-gather engine used by index_select, embedding bag and merged
+// embedding bag. Gathering rows of a large table is bound by memory latency:
+// every index touches a cold row (and often a cold page), so the engine
+// prefetches the row `prefetch_distance` indices ahead, streams large outputs
+// past the cache with non-temporal stores and can visit indices in page order
+// to cut down TLB misses.
+
+constexpr int64_t kGatherCacheLine = 64;
+constexpr int64_t kGatherPageShift = 12;
+
+struct GatherOptions {
+  // How many indices ahead the source row is prefetched. 0 disables it.
+  int64_t prefetch_distance = 8;
+  // Cap on the cache lines prefetched per row, rows longer than this are
+  // covered by the hardware streamer once the first lines are touched.
+  int64_t prefetch_max_lines = 8;
+  // Outputs larger than this (in bytes) are written with non-temporal
+  // stores so they do not evict the table from the cache.
+  int64_t streaming_store_bytes = int64_t(32) << 20;
+  // Index lists at least this long, with rows shorter than half a page and a
+  // table larger than `page_group_table_bytes`, are visited in page order.
+  int64_t page_group_min_indices = int64_t(1) << 16;
+  int64_t page_group_table_bytes = int64_t(64) << 20;
+};
+
+inline int64_t _gather_env_or(const char* name, int64_t default_value) {
+  const char* val = std::getenv(name);
+  if (val == nullptr || *val == '\0') {
+    return default_value;
+  }
+  return std::max<int64_t>(0, std::strtoll(val, nullptr, 10));
+}
+
+// Options are read once from the environment:
+//   IPEX_GATHER_PREFETCH_DISTANCE      indices to prefetch ahead
+//   IPEX_GATHER_STREAMING_STORE_BYTES  output size that turns on NT stores
+//   IPEX_GATHER_PAGE_GROUP_MIN_INDICES index count that turns on page order
+//   IPEX_GATHER_PAGE_GROUP_TABLE_BYTES table size that turns on page order
+inline const GatherOptions& gather_options() {
+  static const GatherOptions options = [] {
+    GatherOptions opt;
+    opt.prefetch_distance = _gather_env_or(
+        "IPEX_GATHER_PREFETCH_DISTANCE", opt.prefetch_distance);
+    opt.streaming_store_bytes = _gather_env_or(
+        "IPEX_GATHER_STREAMING_STORE_BYTES", opt.streaming_store_bytes);
+    opt.page_group_min_indices = _gather_env_or(
+        "IPEX_GATHER_PAGE_GROUP_MIN_INDICES", opt.page_group_min_indices);
+    opt.page_group_table_bytes = _gather_env_or(
+        "IPEX_GATHER_PAGE_GROUP_TABLE_BYTES", opt.page_group_table_bytes);
+    return opt;
+  }();
+  return options;
+}
+
+inline void gather_prefetch_row(
+    const void* row,
+    int64_t row_bytes,
+    int64_t max_lines) {
+  const char* p = static_cast<const char*>(row);
+  int64_t lines = std::min(
+      max_lines, (row_bytes + kGatherCacheLine - 1) / kGatherCacheLine);
+  for (int64_t l = 0; l < lines; l++) {
+    _mm_prefetch(p + l * kGatherCacheLine, _MM_HINT_T0);
+  }
+}
+
+// Prefetch the row referenced by `index[pos + distance]` if it lies before
+// `end`. Meant to be called once per visited index inside a gather loop.
+template <typename scalar_t, typename index_t>
+inline void gather_prefetch_ahead(
+    const scalar_t* src,
+    const index_t* index,
+    int64_t pos,
+    int64_t end,
+    int64_t row_size,
+    const GatherOptions& opt) {
+  int64_t ahead = pos + opt.prefetch_distance;
+  if (opt.prefetch_distance > 0 && ahead < end) {
+    gather_prefetch_row(
+        src + index[ahead] * row_size,
+        row_size * sizeof(scalar_t),
+        opt.prefetch_max_lines);
+  }
+}
+
+template <typename scalar_t>
+inline void gather_copy_row(scalar_t* dst, const scalar_t* src, int64_t size) {
+  using Vec = at::vec::Vectorized<scalar_t>;
+  int64_t d = 0;
+  for (; d < size - (size % Vec::size()); d += Vec::size()) {
+    Vec data_vec = Vec::loadu(src + d);
+    data_vec.store(dst + d);
+  }
+  for (; d < size; ++d) {
+    dst[d] = src[d];
+  }
+}
+
+// Copy a row with non-temporal stores. The unaligned head and the tail that
+// does not fill a whole vector go through regular stores. Callers must issue
+// gather_stream_fence() before the output is consumed by another thread.
+template <typename scalar_t>
+inline void gather_stream_row(
+    scalar_t* dst,
+    const scalar_t* src,
+    int64_t size) {
+#if defined(CPU_CAPABILITY_AVX512) || defined(CPU_CAPABILITY_AVX2)
+#if defined(CPU_CAPABILITY_AVX512)
+  constexpr int64_t kVecBytes = 64;
+#else
+  constexpr int64_t kVecBytes = 32;
+#endif
+  char* d = reinterpret_cast<char*>(dst);
+  const char* s = reinterpret_cast<const char*>(src);
+  int64_t bytes = size * sizeof(scalar_t);
+  int64_t head = (kVecBytes - (reinterpret_cast<uintptr_t>(d) % kVecBytes)) %
+      kVecBytes;
+  if (head % sizeof(scalar_t) != 0 || bytes < head + kVecBytes) {
+    gather_copy_row(dst, src, size);
+    return;
+  }
+  std::memcpy(d, s, head);
+  int64_t i = head;
+  for (; i + kVecBytes <= bytes; i += kVecBytes) {
+#if defined(CPU_CAPABILITY_AVX512)
+    _mm512_stream_si512(
+        reinterpret_cast<__m512i*>(d + i),
+        _mm512_loadu_si512(reinterpret_cast<const void*>(s + i)));
+#else
+    _mm256_stream_si256(
+        reinterpret_cast<__m256i*>(d + i),
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i)));
+#endif
+  }
+  std::memcpy(d + i, s + i, bytes - i);
+#else
+  gather_copy_row(dst, src, size);
+#endif
+}
+
+inline void gather_stream_fence() {
+#if defined(CPU_CAPABILITY_AVX512) || defined(CPU_CAPABILITY_AVX2)
+  _mm_sfence();
+#endif
+}
+
+inline bool gather_use_streaming_store(
+    int64_t output_bytes,
+    const GatherOptions& opt) {
+  return opt.streaming_store_bytes > 0 &&
+      output_bytes >= opt.streaming_store_bytes;
+}
+
+inline bool gather_use_page_grouping(
+    int64_t num_indices,
+    int64_t row_bytes,
+    int64_t table_bytes,
+    const GatherOptions& opt) {
+  return opt.page_group_min_indices > 0 &&
+      num_indices >= opt.page_group_min_indices &&
+      row_bytes * 2 <= (int64_t(1) << kGatherPageShift) &&
+      table_bytes >= opt.page_group_table_bytes;
+}
+
+// Returns the output positions [0, num_indices) ordered by the page of the
+// source row they read, so consecutive copies stay on the same page.
+template <typename index_t>
+inline std::vector<int64_t> gather_page_order(
+    const index_t* index,
+    int64_t num_indices,
+    int64_t row_bytes) {
+  std::vector<std::pair<int64_t, int64_t>> keyed(num_indices);
+  for (int64_t j = 0; j < num_indices; j++) {
+    keyed[j] = {
+        (static_cast<int64_t>(index[j]) * row_bytes) >> kGatherPageShift, j};
+  }
+  std::sort(keyed.begin(), keyed.end());
+  std::vector<int64_t> order(num_indices);
+  for (int64_t j = 0; j < num_indices; j++) {
+    order[j] = keyed[j].second;
+  }
+  return order;
+}
+
+// Gather rows [begin, end) of `index` from `src` into `dst`:
+//   dst[j * row_size : (j + 1) * row_size] = src[index[j] * row_size : ...]
+// If `order` is given, position k of the range visits output row order[k]
+// instead of k. `streaming` selects non-temporal stores for the output.
+template <typename scalar_t, typename index_t>
+inline void gather_rows(
+    scalar_t* dst,
+    const scalar_t* src,
+    const index_t* index,
+    const int64_t* order,
+    int64_t begin,
+    int64_t end,
+    int64_t row_size,
+    bool streaming,
+    const GatherOptions& opt) {
+  const int64_t row_bytes = row_size * sizeof(scalar_t);
+  for (int64_t k = begin; k < end; k++) {
+    int64_t j = order ? order[k] : k;
+    int64_t ahead = k + opt.prefetch_distance;
+    if (opt.prefetch_distance > 0 && ahead < end) {
+      int64_t j_ahead = order ? order[ahead] : ahead;
+      gather_prefetch_row(
+          src + index[j_ahead] * row_size, row_bytes, opt.prefetch_max_lines);
+    }
+    const scalar_t* src_ptr = src + index[j] * row_size;
+    scalar_t* dst_ptr = dst + j * row_size;
+    if (streaming) {
+      gather_stream_row(dst_ptr, src_ptr, row_size);
+    } else {
+      gather_copy_row(dst_ptr, src_ptr, row_size);
+    }
+  }
+  if (streaming) {
+    gather_stream_fence();
+  }
+}
+
+} // namespace kernel
+} // namespace cpu
+} // namespace torch_ipex
@@ -1,2 +1,3 @@
 #include "fill_ker.h"
+#include "gather_ker.h"
 #include "rope.h"
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <immintrin.h>
+#include "utils.h"
+
+namespace torch_ipex {
+namespace cpu {
+namespace kernel {
+
+// AVX2 version of vec512/perf_kernel/add_layernorm.h
+template <typename T>
+std::pair<float, float> _add_and_compute_mean_var(
+    const T* a_ptr,
+    const T* b_ptr,
+    const int& size,
+    float* out) {
+  // compute add and mean/var of the value after add
+  // we should firstly store add value
+  auto vec_acc_mean = _mm256_setzero_ps();
+  auto vec_acc_pow = _mm256_setzero_ps();
+
+  int i = 0;
+  for (; i <= size - 8; i += 8) {
+    auto vec_add =
+        _mm256_add_ps(_loadu_fp32x8(a_ptr + i), _loadu_fp32x8(b_ptr + i));
+    vec_acc_mean = _mm256_add_ps(vec_add, vec_acc_mean);
+    _mm256_storeu_ps(out + i, vec_add);
+    vec_acc_pow = _mm256_fmadd_ps(vec_add, vec_add, vec_acc_pow);
+  }
+
+  if (i < size) {
+    auto vec_add = _mm256_add_ps(
+        _maskz_loadu_fp32x8(a_ptr + i, size - i),
+        _maskz_loadu_fp32x8(b_ptr + i, size - i));
+    vec_acc_mean = _mm256_add_ps(vec_add, vec_acc_mean);
+    _mask_storeu_fp32x8(out + i, vec_add, size - i);
+    vec_acc_pow = _mm256_fmadd_ps(vec_add, vec_add, vec_acc_pow);
+  }
+  float mean_var = _reduce_add_fp32x8(vec_acc_mean) / float(size);
+  float var_val = _reduce_add_fp32x8(vec_acc_pow);
+  return std::make_pair(mean_var, var_val);
+}
+
+template <typename T, typename T1>
+void _normalize_kernel(
+    T* out_ptr,
+    const float* input_ptr,
+    const int& size,
+    float scale,
+    float bias,
+    const T1* gamma_ptr,
+    const T1* beta_ptr) {
+  auto vec_one = _mm256_set1_ps(1.0);
+  auto vec_zero = _mm256_setzero_ps();
+  auto vec_scale = _mm256_set1_ps(scale);
+  auto vec_bias = _mm256_set1_ps(bias);
+  int i = 0;
+  for (; i <= size - 8; i += 8) {
+    auto vec_gamma = gamma_ptr ? _loadu_fp32x8(gamma_ptr + i) : vec_one;
+    auto vec_beta = beta_ptr ? _loadu_fp32x8(beta_ptr + i) : vec_zero;
+    //(a_ptr[i] * scale + bias) * gamma + beta;
+    auto vec_norm =
+        _mm256_fmadd_ps(_mm256_loadu_ps(input_ptr + i), vec_scale, vec_bias);
+    _storeu_fp32x8(out_ptr + i, _mm256_fmadd_ps(vec_norm, vec_gamma, vec_beta));
+  }
+  if (i < size) {
+    int len = size - i;
+    auto vec_gamma =
+        gamma_ptr ? _maskz_loadu_fp32x8(gamma_ptr + i, len) : vec_one;
+    auto vec_beta =
+        beta_ptr ? _maskz_loadu_fp32x8(beta_ptr + i, len) : vec_zero;
+    auto vec_norm = _mm256_fmadd_ps(
+        _maskz_loadu_fp32x8(input_ptr + i, len), vec_scale, vec_bias);
+    _mask_storeu_fp32x8(
+        out_ptr + i, _mm256_fmadd_ps(vec_norm, vec_gamma, vec_beta), len);
+  }
+}
+
+} // namespace kernel
+} // namespace cpu
+} // namespace torch_ipex
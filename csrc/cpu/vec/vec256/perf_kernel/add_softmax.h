@@ -0,0 +1,255 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <immintrin.h>
+#include <limits>
+#include "utils.h"
+
+namespace torch_ipex {
+namespace cpu {
+namespace kernel {
+
+// AVX2 versions of the softmax and attention reductions of
+// vec512/perf_kernel/add_softmax.h that the paged attention and the indirect
+// access kv cache attention use. The tails go through the masked helpers of
+// utils.h, lanes past the tail never take part in the max or sum.
+
+inline __m256 _dil_exp_kernel(__m256 vec_src) {
+  const __m256 vec_factorial_1 = _mm256_set1_ps(0.999999701f);
+  const __m256 vec_factorial_2 = _mm256_set1_ps(0.499991506f);
+  const __m256 vec_factorial_3 = _mm256_set1_ps(0.166676521f);
+  const __m256 vec_factorial_4 = _mm256_set1_ps(0.0418978221f);
+  const __m256 vec_factorial_5 = _mm256_set1_ps(0.00828929059f);
+  const __m256 vec_exp_log2ef =
+      _mm256_castsi256_ps(_mm256_set1_epi32(0x3fb8aa3b)); // log2(e)
+  const __m256 vec_half = _mm256_set1_ps(0.5f);
+  const __m256 vec_one = _mm256_set1_ps(1.f);
+  const __m256 vec_two = _mm256_set1_ps(2.f);
+  const __m256 vec_ln2f =
+      _mm256_castsi256_ps(_mm256_set1_epi32(0x3f317218)); // ln(2)
+  const __m256 vec_ln_flt_min =
+      _mm256_castsi256_ps(_mm256_set1_epi32(0xc2aeac50));
+  const __m256 vec_ln_flt_max =
+      _mm256_castsi256_ps(_mm256_set1_epi32(0x42b17218));
+  const __m256i vec_127 = _mm256_set1_epi32(0x0000007f);
+  const int n_mantissa_bits = 23;
+
+  // exp(x) = 2^n * exp(r) with x = n * ln(2) + r
+  auto less_ln_flt_min_mask =
+      _mm256_cmp_ps(vec_src, vec_ln_flt_min, _CMP_LT_OS);
+  vec_src = _mm256_min_ps(vec_src, vec_ln_flt_max);
+  vec_src = _mm256_max_ps(vec_src, vec_ln_flt_min);
+
+  // fx = floorf(x * log2ef + 0.5)
+  auto vec_fx =
+      _mm256_floor_ps(_mm256_fmadd_ps(vec_src, vec_exp_log2ef, vec_half));
+
+  // x = x - fx * ln2
+  auto vec_exp_poly = _mm256_fnmadd_ps(vec_fx, vec_ln2f, vec_src);
+
+  // compute polynomial
+  auto vec_res =
+      _mm256_fmadd_ps(vec_exp_poly, vec_factorial_5, vec_factorial_4);
+  vec_res = _mm256_fmadd_ps(vec_exp_poly, vec_res, vec_factorial_3);
+  vec_res = _mm256_fmadd_ps(vec_exp_poly, vec_res, vec_factorial_2);
+  vec_res = _mm256_fmadd_ps(vec_exp_poly, vec_res, vec_factorial_1);
+  vec_res = _mm256_fmadd_ps(vec_exp_poly, vec_res, vec_one);
+
+  // compute 2^(n-1)
+  auto vec_exp_number_i = _mm256_cvtps_epi32(_mm256_sub_ps(vec_fx, vec_one));
+  auto vec_two_pow_n = _mm256_castsi256_ps(_mm256_slli_epi32(
+      _mm256_add_epi32(vec_exp_number_i, vec_127), n_mantissa_bits));
+  vec_two_pow_n = _mm256_andnot_ps(less_ln_flt_min_mask, vec_two_pow_n);
+
+  // y = y * 2^n
+  vec_res = _mm256_mul_ps(vec_res, vec_two_pow_n);
+  return _mm256_mul_ps(vec_res, vec_two);
+}
+
+template <typename scalar_a, typename scalar_b>
+inline void _dil_div_add_reduce_max_fusion_kernel(
+    const scalar_a* a,
+    const scalar_b* b,
+    const float& dim_per_head,
+    const int& size,
+    float* out,
+    float& max) {
+  auto vec_ps_min = _mm256_set1_ps(std::numeric_limits<float>::lowest());
+  auto vec_max = vec_ps_min;
+  auto vec_r_dim_per_head = _mm256_set1_ps(1.0 / dim_per_head);
+  int i = 0;
+  for (; i <= size - 8; i += 8) {
+    auto vec_out = _mm256_fmadd_ps(
+        _loadu_fp32x8(a + i), vec_r_dim_per_head, _loadu_fp32x8(b + i));
+    vec_max = _mm256_max_ps(vec_max, vec_out);
+    _mm256_storeu_ps(out + i, vec_out);
+  }
+  if (i < size) {
+    int len = size - i;
+    auto vec_out = _mm256_fmadd_ps(
+        _maskz_loadu_fp32x8(a + i, len),
+        vec_r_dim_per_head,
+        _maskz_loadu_fp32x8(b + i, len));
+    vec_out = _mm256_blendv_ps(
+        vec_ps_min, vec_out, _mm256_castsi256_ps(_tail_mask_epi32(len)));
+    vec_max = _mm256_max_ps(vec_max, vec_out);
+    _mask_storeu_fp32x8(out + i, vec_out, len);
+  }
+  max = _reduce_max_fp32x8(vec_max);
+}
+
+template <typename scalar_a>
+inline void _dil_div_add_alibi_and_reduce_max_fusion_kernel(
+    const scalar_a* a,
+    const float& scale,
+    const int& size,
+    float* out,
+    float& max,
+    const float alibi_slope,
+    bool use_alibi) {
+  auto vec_ps_min = _mm256_set1_ps(std::numeric_limits<float>::lowest());
+  auto vec_max = vec_ps_min;
+  auto vec_scale = _mm256_set1_ps(scale);
+  auto vec_alibi_slope = _mm256_set1_ps(alibi_slope);
+  // alibi_slope * (token_idx - context_len + 1)
+  auto vec_token_idx = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+  vec_token_idx = _mm256_sub_ps(vec_token_idx, _mm256_set1_ps(size - 1));
+  auto vec_eight = _mm256_set1_ps(8.f);
+  int i = 0;
+  for (; i <= size - 8; i += 8) {
+    auto vec_out = _mm256_mul_ps(_loadu_fp32x8(a + i), vec_scale);
+    if (use_alibi) {
+      vec_out = _mm256_fmadd_ps(vec_token_idx, vec_alibi_slope, vec_out);
+    }
+    vec_token_idx = _mm256_add_ps(vec_token_idx, vec_eight);
+    vec_max = _mm256_max_ps(vec_max, vec_out);
+    _mm256_storeu_ps(out + i, vec_out);
+  }
+  if (i < size) {
+    int len = size - i;
+    auto vec_out = _mm256_mul_ps(_maskz_loadu_fp32x8(a + i, len), vec_scale);
+    if (use_alibi) {
+      vec_out = _mm256_fmadd_ps(vec_token_idx, vec_alibi_slope, vec_out);
+    }
+    vec_out = _mm256_blendv_ps(
+        vec_ps_min, vec_out, _mm256_castsi256_ps(_tail_mask_epi32(len)));
+    vec_max = _mm256_max_ps(vec_max, vec_out);
+    _mask_storeu_fp32x8(out + i, vec_out, len);
+  }
+  max = _reduce_max_fp32x8(vec_max);
+}
+
+inline void _dil_exp_reduce_sum_fusion_kernel(
+    float* a,
+    const int& size,
+    float* out,
+    float& val) {
+  auto vec_max = _mm256_set1_ps(val);
+  auto vec_sum = _mm256_setzero_ps();
+  int i = 0;
+  for (; i <= size - 8; i += 8) {
+    auto vec_out =
+        _dil_exp_kernel(_mm256_sub_ps(_mm256_loadu_ps(a + i), vec_max));
+    vec_sum = _mm256_add_ps(vec_sum, vec_out);
+    _mm256_storeu_ps(out + i, vec_out);
+  }
+  if (i < size) {
+    int len = size - i;
+    auto vec_out = _dil_exp_kernel(
+        _mm256_sub_ps(_maskz_loadu_fp32x8(a + i, len), vec_max));
+    vec_out =
+        _mm256_and_ps(vec_out, _mm256_castsi256_ps(_tail_mask_epi32(len)));
+    vec_sum = _mm256_add_ps(vec_sum, vec_out);
+    _mask_storeu_fp32x8(out + i, vec_out, len);
+  }
+  val = _reduce_add_fp32x8(vec_sum);
+}
+
+template <typename scalar_t>
+inline void _dil_normalization_kernel(
+    const float* a,
+    const float& sum,
+    const int& size,
+    scalar_t* out) {
+  auto vec_sum = _mm256_set1_ps(sum);
+  int i = 0;
+  for (; i <= size - 8; i += 8) {
+    _storeu_fp32x8(out + i, _mm256_div_ps(_mm256_loadu_ps(a + i), vec_sum));
+  }
+  if (i < size) {
+    int len = size - i;
+    _mask_storeu_fp32x8(
+        out + i,
+        _mm256_div_ps(_maskz_loadu_fp32x8(a + i, len), vec_sum),
+        len);
+  }
+}
+
+template <typename QT, typename KT, typename CT>
+void _reduce_head(
+    const QT* q_ptr_start,
+    const KT* k_ptr_start,
+    float* attn_w_pos,
+    int64_t head_size,
+    bool store_key,
+    CT* k_cache_start) {
+  auto hsi = 0;
+  auto qk_sum_vec = _mm256_setzero_ps();
+  for (hsi = 0; hsi <= head_size - 8; hsi += 8) {
+    auto q_vec = _loadu_fp32x8(q_ptr_start + hsi);
+    auto k_vec = _loadu_fp32x8(k_ptr_start + hsi);
+    if (store_key) {
+      _storeu_fp32x8(k_cache_start + hsi, k_vec);
+    }
+    qk_sum_vec = _mm256_fmadd_ps(q_vec, k_vec, qk_sum_vec);
+  }
+  attn_w_pos[0] += _reduce_add_fp32x8(qk_sum_vec);
+  for (; hsi < head_size; hsi++) {
+    if (store_key) {
+      k_cache_start[hsi] =
+          (float)k_ptr_start[hsi]; // cat the key into the key_cache.
+    }
+    attn_w_pos[0] += (float)q_ptr_start[hsi] * (float)k_ptr_start[hsi];
+  }
+}
+
+template <typename VT, typename OT, typename CT>
+inline void _mul_and_accumulate(
+    const float& attn_w,
+    const VT* v_ptr_start,
+    OT* attn_out_start,
+    int64_t head_size,
+    bool store_value,
+    CT* v_cache_start,
+    int accumulated) {
+  auto attn_w_vec = _mm256_set1_ps(attn_w);
+  auto hsi = 0;
+  for (hsi = 0; hsi <= head_size - 8; hsi += 8) {
+    auto v_vec = _loadu_fp32x8(v_ptr_start + hsi);
+    if (accumulated) {
+      auto attn_out_vec = _loadu_fp32x8(attn_out_start + hsi);
+      _storeu_fp32x8(
+          attn_out_start + hsi,
+          _mm256_fmadd_ps(attn_w_vec, v_vec, attn_out_vec));
+    } else {
+      _storeu_fp32x8(attn_out_start + hsi, _mm256_mul_ps(attn_w_vec, v_vec));
+    }
+    if (store_value) {
+      _storeu_fp32x8(v_cache_start + hsi, v_vec);
+    }
+  }
+  for (; hsi < head_size; hsi++) {
+    if (accumulated) {
+      attn_out_start[hsi] += attn_w * (float)v_ptr_start[hsi];
+    } else {
+      attn_out_start[hsi] = attn_w * (float)v_ptr_start[hsi];
+    }
+    if (store_value) {
+      v_cache_start[hsi] = (float)v_ptr_start[hsi];
+    }
+  }
+}
+
+} // namespace kernel
+} // namespace cpu
+} // namespace torch_ipex
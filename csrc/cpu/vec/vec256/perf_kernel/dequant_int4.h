@@ -0,0 +1,47 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <immintrin.h>
+#include "utils.h"
+
+namespace torch_ipex {
+namespace cpu {
+namespace kernel {
+
+// Dequantizes one row of a quint4x2 weight, two 4 bit values per byte with
+// the lower nibble first, to fp32: out[k] = (w[k] - zero_point) * scale.
+// `size` is the number of 4 bit values and has to be even.
+inline void _dequant_int4_row(
+    const uint8_t* w_ptr,
+    float* out_ptr,
+    int64_t size,
+    float scale,
+    float zero_point) {
+  auto vec_scale = _mm256_set1_ps(scale);
+  auto vec_zero_point = _mm256_set1_ps(zero_point);
+  auto vec_low_nibble = _mm256_set1_epi32(0xF);
+  int64_t k = 0;
+  for (; k <= size - 16; k += 16) {
+    // 8 bytes -> 16 values
+    auto bytes =
+        _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i*)(w_ptr + k / 2)));
+    auto lo = _mm256_cvtepi32_ps(_mm256_and_si256(bytes, vec_low_nibble));
+    auto hi = _mm256_cvtepi32_ps(_mm256_srli_epi32(bytes, 4));
+    lo = _mm256_mul_ps(_mm256_sub_ps(lo, vec_zero_point), vec_scale);
+    hi = _mm256_mul_ps(_mm256_sub_ps(hi, vec_zero_point), vec_scale);
+    // interleave back to the element order
+    auto x0 = _mm256_unpacklo_ps(lo, hi);
+    auto x1 = _mm256_unpackhi_ps(lo, hi);
+    _mm256_storeu_ps(out_ptr + k, _mm256_permute2f128_ps(x0, x1, 0x20));
+    _mm256_storeu_ps(out_ptr + k + 8, _mm256_permute2f128_ps(x0, x1, 0x31));
+  }
+  for (; k < size; k += 2) {
+    uint8_t byte = w_ptr[k / 2];
+    out_ptr[k] = (float(byte & 0xF) - zero_point) * scale;
+    out_ptr[k + 1] = (float(byte >> 4) - zero_point) * scale;
+  }
+}
+
+} // namespace kernel
+} // namespace cpu
+} // namespace torch_ipex
@@ -0,0 +1,5 @@
+#include "add_layernorm.h"
+#include "add_softmax.h"
+#include "dequant_int4.h"
+#include "rmsnorm.h"
+#include "update_batch.h"
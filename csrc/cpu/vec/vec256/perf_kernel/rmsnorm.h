@@ -0,0 +1,52 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <immintrin.h>
+#include "utils.h"
+
+namespace torch_ipex {
+namespace cpu {
+namespace kernel {
+
+// AVX2 version of vec512/perf_kernel/rmsnorm.h
+template <typename T, typename T1>
+void _compute_rmsnorm(
+    const T* a_ptr,
+    const int& size,
+    float eps,
+    const T1* gamma_ptr,
+    T* out_ptr) {
+  auto vec_acc_pow = _mm256_setzero_ps();
+  int i;
+  for (i = 0; i <= size - 8; i += 8) {
+    auto vec_a = _loadu_fp32x8(a_ptr + i);
+    vec_acc_pow = _mm256_fmadd_ps(vec_a, vec_a, vec_acc_pow);
+  }
+  if (i < size) {
+    auto vec_a = _maskz_loadu_fp32x8(a_ptr + i, size - i);
+    vec_acc_pow = _mm256_fmadd_ps(vec_a, vec_a, vec_acc_pow);
+  }
+  float var_val = _reduce_add_fp32x8(vec_acc_pow) / static_cast<float>(size);
+  float scale = float(1.0) / std::sqrt(var_val + eps);
+  auto vec_scale = _mm256_set1_ps(scale);
+  for (i = 0; i <= size - 8; i += 8) {
+    auto vec_res = _mm256_mul_ps(_loadu_fp32x8(a_ptr + i), vec_scale);
+    if (gamma_ptr) {
+      vec_res = _mm256_mul_ps(vec_res, _loadu_fp32x8(gamma_ptr + i));
+    }
+    _storeu_fp32x8(out_ptr + i, vec_res);
+  }
+  if (i < size) {
+    auto vec_res =
+        _mm256_mul_ps(_maskz_loadu_fp32x8(a_ptr + i, size - i), vec_scale);
+    if (gamma_ptr) {
+      vec_res =
+          _mm256_mul_ps(vec_res, _maskz_loadu_fp32x8(gamma_ptr + i, size - i));
+    }
+    _mask_storeu_fp32x8(out_ptr + i, vec_res, size - i);
+  }
+}
+
+} // namespace kernel
+} // namespace cpu
+} // namespace torch_ipex
@@ -0,0 +1,261 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <immintrin.h>
+#include "utils.h"
+
+namespace torch_ipex {
+namespace cpu {
+namespace kernel {
+
+// AVX2 version of vec512/perf_kernel/update_batch.h, 8 batch lanes per step.
+// The compare results are all-ones lanes instead of mask registers, so the
+// 0/1 flags are and-ed out of them and the +1s are subtractions of them.
+
+inline __m256i _cvtepi64x2_epi32(__m256i lo, __m256i hi) {
+  const auto even = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+  auto lo_epi32 = _mm256_permutevar8x32_epi32(lo, even);
+  auto hi_epi32 = _mm256_permutevar8x32_epi32(hi, even);
+  return _mm256_permute2x128_si256(lo_epi32, hi_epi32, 0x20);
+}
+
+inline void update_batch_kernel_impl(
+    const __m256i& max_symbols_epi32,
+    const __m256i& flag_1_epi32,
+    const __m256i& blank_id_epi32,
+    const __m256i& k_right_epi64,
+    const __m256i& k_left_epi64,
+    const __m256i& out_lens_epi32,
+    const __m256i& sos_epi32,
+    __m256i& lable_col_epi32,
+    __m256i& symbols_added_epi32,
+    __m256i& time_idxs_epi32,
+    __m256i& blankness_out_epi32,
+    __m256i& blankvec_out_epi32,
+    __m256i& not_blank_out_epi32,
+    __m256i& label_to_put_out_right_epi64,
+    __m256i& label_to_put_out_left_epi64) {
+  auto k_epi32 = _cvtepi64x2_epi32(k_right_epi64, k_left_epi64);
+
+  // blankness = k.eq(self._blank_id)
+  auto blankness_eq = _mm256_cmpeq_epi32(k_epi32, blank_id_epi32);
+  // symbols_added *= blankness.logical_not()
+  symbols_added_epi32 = _mm256_andnot_si256(blankness_eq, symbols_added_epi32);
+  // time_idxs = time_idxs + blankness
+  time_idxs_epi32 = _mm256_sub_epi32(time_idxs_epi32, blankness_eq);
+  // blank_vec = time_idxs.ge(out_lens)
+  auto blank_vec_ge = _mm256_or_si256(
+      _mm256_cmpgt_epi32(time_idxs_epi32, out_lens_epi32),
+      _mm256_cmpeq_epi32(time_idxs_epi32, out_lens_epi32));
+
+  // not_blank = tmp_blank_vec.eq(0)
+  not_blank_out_epi32 = _mm256_andnot_si256(
+      _mm256_or_si256(blankness_eq, blank_vec_ge), flag_1_epi32);
+
+  // label_col += not_blank
+  lable_col_epi32 = _mm256_add_epi32(lable_col_epi32, not_blank_out_epi32);
+  // symbols_added += not_blank
+  symbols_added_epi32 =
+      _mm256_add_epi32(symbols_added_epi32, not_blank_out_epi32);
+
+  auto symbols_lt = _mm256_cmpgt_epi32(max_symbols_epi32, symbols_added_epi32);
+  // time_idxs += need_add
+  time_idxs_epi32 = _mm256_add_epi32(
+      time_idxs_epi32, _mm256_andnot_si256(symbols_lt, flag_1_epi32));
+  // symbols_added *= symbols_added.lt(max_symbols)
+  symbols_added_epi32 = _mm256_and_si256(symbols_added_epi32, symbols_lt);
+
+  // blankness.logical_or_(need_add)
+  blankness_out_epi32 = _mm256_or_si256(
+      _mm256_and_si256(blankness_eq, flag_1_epi32),
+      _mm256_andnot_si256(symbols_lt, flag_1_epi32));
+  blankvec_out_epi32 = _mm256_and_si256(blank_vec_ge, flag_1_epi32);
+
+  // (k-self._SOS)*not_blank
+  auto label_to_put_epi32 = _mm256_mullo_epi32(
+      _mm256_sub_epi32(k_epi32, sos_epi32), not_blank_out_epi32);
+  label_to_put_out_right_epi64 =
+      _mm256_cvtepi32_epi64(_mm256_castsi256_si128(label_to_put_epi32));
+  label_to_put_out_left_epi64 =
+      _mm256_cvtepi32_epi64(_mm256_extracti128_si256(label_to_put_epi32, 1));
+}
+
+inline void update_batch_kernel(
+    const at::Tensor& k,
+    const at::Tensor& out_lens,
+    at::Tensor label_col,
+    at::Tensor symbols_added,
+    at::Tensor time_idxs,
+    at::Tensor blankness_out,
+    at::Tensor blankvec_out,
+    at::Tensor not_blank_out,
+    at::Tensor label_to_put_out,
+    int max_symbols,
+    int blank_id,
+    int len,
+    int _SOS) {
+  auto k_ptr = static_cast<int64_t*>(k.data_ptr());
+  auto out_lens_ptr = static_cast<int32_t*>(out_lens.data_ptr());
+  auto lable_col_ptr = static_cast<int32_t*>(label_col.data_ptr());
+  auto symbols_added_ptr = static_cast<int32_t*>(symbols_added.data_ptr());
+  auto time_idxs_ptr = static_cast<int32_t*>(time_idxs.data_ptr());
+  auto blankness_out_ptr = static_cast<int32_t*>(blankness_out.data_ptr());
+  auto blankvec_out_ptr = static_cast<int32_t*>(blankvec_out.data_ptr());
+  auto not_blank_out_ptr = static_cast<int32_t*>(not_blank_out.data_ptr());
+  auto label_to_put_out_ptr =
+      static_cast<int64_t*>(label_to_put_out.data_ptr());
+
+  auto max_symbols_epi32 = _mm256_set1_epi32(max_symbols);
+  auto flag_1_epi32 = _mm256_set1_epi32(1);
+  auto sos_epi32 = _mm256_set1_epi32(_SOS);
+  auto blank_id_epi32 = _mm256_set1_epi32(blank_id);
+  auto blankness_out_epi32 = _mm256_setzero_si256();
+  auto blankvec_out_epi32 = _mm256_setzero_si256();
+  auto not_blank_out_epi32 = _mm256_setzero_si256();
+  auto label_to_put_out_right_epi64 = _mm256_setzero_si256();
+  auto label_to_put_out_left_epi64 = _mm256_setzero_si256();
+
+  auto load = [](const void* p) {
+    return _mm256_loadu_si256((const __m256i*)p);
+  };
+  auto store = [](void* p, __m256i v) { _mm256_storeu_si256((__m256i*)p, v); };
+
+  int i = 0;
+  for (; i <= len - 8; i += 8) {
+    auto k_right_epi64 = load(k_ptr + i + 0);
+    auto k_left_epi64 = load(k_ptr + i + 4);
+    auto out_lens_epi32 = load(out_lens_ptr + i);
+    auto lable_col_epi32 = load(lable_col_ptr + i);
+    auto symbols_added_epi32 = load(symbols_added_ptr + i);
+    auto time_idxs_epi32 = load(time_idxs_ptr + i);
+
+    update_batch_kernel_impl(
+        max_symbols_epi32,
+        flag_1_epi32,
+        blank_id_epi32,
+        k_right_epi64,
+        k_left_epi64,
+        out_lens_epi32,
+        sos_epi32,
+        lable_col_epi32,
+        symbols_added_epi32,
+        time_idxs_epi32,
+        blankness_out_epi32,
+        blankvec_out_epi32,
+        not_blank_out_epi32,
+        label_to_put_out_right_epi64,
+        label_to_put_out_left_epi64);
+
+    store(symbols_added_ptr + i, symbols_added_epi32);
+    store(time_idxs_ptr + i, time_idxs_epi32);
+    store(lable_col_ptr + i, lable_col_epi32);
+    store(blankness_out_ptr + i, blankness_out_epi32);
+    store(blankvec_out_ptr + i, blankvec_out_epi32);
+    store(not_blank_out_ptr + i, not_blank_out_epi32);
+    store(label_to_put_out_ptr + i + 0, label_to_put_out_right_epi64);
+    store(label_to_put_out_ptr + i + 4, label_to_put_out_left_epi64);
+  }
+
+  if (i < len) {
+    auto mask = _tail_mask_epi32(len - i);
+    auto mask_right = _mm256_cvtepi32_epi64(_mm256_castsi256_si128(mask));
+    auto mask_left = _mm256_cvtepi32_epi64(_mm256_extracti128_si256(mask, 1));
+    auto k_right_epi64 =
+        _mm256_maskload_epi64((const long long*)(k_ptr + i + 0), mask_right);
+    auto k_left_epi64 =
+        _mm256_maskload_epi64((const long long*)(k_ptr + i + 4), mask_left);
+    auto out_lens_epi32 = _mm256_maskload_epi32(out_lens_ptr + i, mask);
+    auto lable_col_epi32 = _mm256_maskload_epi32(lable_col_ptr + i, mask);
+    auto symbols_added_epi32 =
+        _mm256_maskload_epi32(symbols_added_ptr + i, mask);
+    auto time_idxs_epi32 = _mm256_maskload_epi32(time_idxs_ptr + i, mask);
+
+    update_batch_kernel_impl(
+        max_symbols_epi32,
+        flag_1_epi32,
+        blank_id_epi32,
+        k_right_epi64,
+        k_left_epi64,
+        out_lens_epi32,
+        sos_epi32,
+        lable_col_epi32,
+        symbols_added_epi32,
+        time_idxs_epi32,
+        blankness_out_epi32,
+        blankvec_out_epi32,
+        not_blank_out_epi32,
+        label_to_put_out_right_epi64,
+        label_to_put_out_left_epi64);
+
+    _mm256_maskstore_epi32(symbols_added_ptr + i, mask, symbols_added_epi32);
+    _mm256_maskstore_epi32(time_idxs_ptr + i, mask, time_idxs_epi32);
+    _mm256_maskstore_epi32(lable_col_ptr + i, mask, lable_col_epi32);
+    _mm256_maskstore_epi32(blankness_out_ptr + i, mask, blankness_out_epi32);
+    _mm256_maskstore_epi32(blankvec_out_ptr + i, mask, blankvec_out_epi32);
+    _mm256_maskstore_epi32(not_blank_out_ptr + i, mask, not_blank_out_epi32);
+    _mm256_maskstore_epi64(
+        (long long*)(label_to_put_out_ptr + i + 0),
+        mask_right,
+        label_to_put_out_right_epi64);
+    _mm256_maskstore_epi64(
+        (long long*)(label_to_put_out_ptr + i + 4),
+        mask_left,
+        label_to_put_out_left_epi64);
+  }
+}
+
+inline bool should_update_feature(const at::Tensor& blankness_out, int len) {
+  // if blankness_out.nonzero().size(0) > 0, return true; else return false
+  auto blankness_out_ptr = static_cast<int32_t*>(blankness_out.data_ptr());
+  int i = 0;
+  for (; i <= len - 8; i += 8) {
+    auto blankness_out_epi32 =
+        _mm256_loadu_si256((const __m256i*)(blankness_out_ptr + i));
+    if (!_mm256_testz_si256(blankness_out_epi32, blankness_out_epi32)) {
+      return true;
+    }
+  }
+
+  if (i < len) {
+    auto blankness_out_epi32 = _mm256_maskload_epi32(
+        blankness_out_ptr + i, _tail_mask_epi32(len - i));
+    if (!_mm256_testz_si256(blankness_out_epi32, blankness_out_epi32)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+inline bool all_time_idxs_processed_kernel(
+    const at::Tensor& blankvec_out,
+    int len) {
+  // if blank_vec.nonzero().size(0) == batch_size, return true; else return
+  // false. blank_vec only holds 0/1, so it is checked to have no zero lane.
+  auto blankvec_out_ptr = static_cast<int32_t*>(blankvec_out.data_ptr());
+  auto zero_epi32 = _mm256_setzero_si256();
+  int i = 0;
+  for (; i <= len - 8; i += 8) {
+    auto blankvec_out_epi32 =
+        _mm256_loadu_si256((const __m256i*)(blankvec_out_ptr + i));
+    auto is_zero = _mm256_cmpeq_epi32(blankvec_out_epi32, zero_epi32);
+    if (!_mm256_testz_si256(is_zero, is_zero)) {
+      return false;
+    }
+  }
+
+  if (i < len) {
+    auto mask = _tail_mask_epi32(len - i);
+    auto blankvec_out_epi32 = _mm256_maskload_epi32(blankvec_out_ptr + i, mask);
+    auto is_zero = _mm256_and_si256(
+        _mm256_cmpeq_epi32(blankvec_out_epi32, zero_epi32), mask);
+    if (!_mm256_testz_si256(is_zero, is_zero)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace kernel
+} // namespace cpu
+} // namespace torch_ipex
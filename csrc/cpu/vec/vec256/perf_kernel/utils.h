@@ -0,0 +1,59 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <immintrin.h>
+#include <cstring>
+#include "../vec256_fp8_cast.h"
+
+namespace torch_ipex {
+namespace cpu {
+namespace kernel {
+
+// AVX2 has no mask registers, the tails of the perf kernels below load and
+// store the remaining `len` (< 8) elements through these helpers instead of
+// the __mmask16 loads/stores of vec512/perf_kernel/utils.h.
+
+inline __m256i _tail_mask_epi32(int len) {
+  return _mm256_cmpgt_epi32(
+      _mm256_set1_epi32(len), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+
+inline __m256 _maskz_loadu_fp32x8(const float* data_base, int len) {
+  return _mm256_maskload_ps(data_base, _tail_mask_epi32(len));
+}
+
+template <typename T>
+inline __m256 _maskz_loadu_fp32x8(const T* data_base, int len) {
+  T buf[8] = {};
+  std::memcpy(buf, data_base, len * sizeof(T));
+  return _loadu_fp32x8(buf);
+}
+
+inline void _mask_storeu_fp32x8(float* data_base, __m256 a, int len) {
+  _mm256_maskstore_ps(data_base, _tail_mask_epi32(len), a);
+}
+
+template <typename T>
+inline void _mask_storeu_fp32x8(T* data_base, __m256 a, int len) {
+  T buf[8];
+  _storeu_fp32x8(buf, a);
+  std::memcpy(data_base, buf, len * sizeof(T));
+}
+
+inline float _reduce_add_fp32x8(__m256 a) {
+  __m128 x = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+  x = _mm_add_ps(x, _mm_movehl_ps(x, x));
+  x = _mm_add_ss(x, _mm_movehdup_ps(x));
+  return _mm_cvtss_f32(x);
+}
+
+inline float _reduce_max_fp32x8(__m256 a) {
+  __m128 x = _mm_max_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+  x = _mm_max_ps(x, _mm_movehl_ps(x, x));
+  x = _mm_max_ss(x, _mm_movehdup_ps(x));
+  return _mm_cvtss_f32(x);
+}
+
+} // namespace kernel
+} // namespace cpu
+} // namespace torch_ipex
@@ -117,6 +117,64 @@ inline void packed_bf16_add_ker(
   }
 }
 
+template <>
+IPEX_FORCE_INLINE void move_ker(float* out, const float* in, int64_t len) {
+  int64_t i = 0;
+#pragma unroll(4)
+  for (i = 0; i < len - 7; i += 8) {
+    _mm256_storeu_ps(out + i, _mm256_loadu_ps(in + i));
+  }
+
+  if (i < len) {
+    auto mask = _mm256_cmpgt_epi32(
+        _mm256_set1_epi32(len - i), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    _mm256_maskstore_ps(out + i, mask, _mm256_maskload_ps(in + i, mask));
+  }
+}
+
+template <>
+IPEX_FORCE_INLINE void move_ker(
+    at::BFloat16* out,
+    const at::BFloat16* in,
+    int64_t len) {
+  int64_t i = 0;
+#pragma unroll(4)
+  for (i = 0; i < len - 15; i += 16) {
+    _mm256_storeu_si256(
+        (__m256i*)(out + i), _mm256_loadu_si256((const __m256i*)(in + i)));
+  }
+
+  for (; i < len; i++) {
+    out[i] = in[i];
+  }
+}
+
+static IPEX_FORCE_INLINE void zero_ker(float* out, int64_t len) {
+  int64_t i = 0;
+  __m256 zero_256 = _mm256_setzero_ps();
+#pragma unroll(4)
+  for (i = 0; i < len - 7; i += 8) {
+    _mm256_storeu_ps(out + i, zero_256);
+  }
+
+  for (; i < len; i++) {
+    out[i] = 0;
+  }
+}
+
+static IPEX_FORCE_INLINE void zero_ker(at::BFloat16* out, int64_t len) {
+  int64_t i = 0;
+  __m256i zero_256 = _mm256_setzero_si256();
+#pragma unroll(4)
+  for (i = 0; i < len - 15; i += 16) {
+    _mm256_storeu_si256((__m256i*)(out + i), zero_256);
+  }
+
+  for (; i < len; i++) {
+    out[i].x = 0;
+  }
+}
+
 static IPEX_FORCE_INLINE void move_ker_load_aligned(
     at::BFloat16* out,
     const float* in,
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <c10/util/Float8_e4m3fn.h>
+#include <c10/util/Float8_e5m2.h>
+#include <immintrin.h>
+
+namespace torch_ipex {
+namespace cpu {
+namespace kernel {
+
+// AVX2 counterparts of the fp8 conversions in vec512/perf_kernel/fp8_cast.h,
+// see there for the rounding and saturation rules. 8 values are converted at
+// a time, the fp8 results are held in the low 8 bytes of a __m128i.
+
+inline __m128i _pack_low_bytes_epi32(const __m256i src) {
+  const __m256i shuffle = _mm256_setr_epi8(
+      0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+      0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+  __m256i res = _mm256_shuffle_epi8(src, shuffle);
+  res = _mm256_permutevar8x32_epi32(
+      res, _mm256_setr_epi32(0, 4, 1, 2, 3, 5, 6, 7));
+  return _mm256_castsi256_si128(res);
+}
+
+inline __m128i cvt_fp32_to_fp8_e4m3(const __m256 src) {
+  const __m256i denorm_magic = _mm256_set1_epi32(141 << 23);
+  __m256i bits = _mm256_castps_si256(src);
+  __m256i sign = _mm256_and_si256(bits, _mm256_set1_epi32(0x80000000));
+  __m256i abs = _mm256_xor_si256(bits, sign);
+  // abs is below 2^31, so the signed comparisons are safe
+  __m256i nan_mask = _mm256_cmpgt_epi32(abs, _mm256_set1_epi32(0x7F800000));
+  abs = _mm256_min_epi32(abs, _mm256_set1_epi32(0x43E00000));
+  __m256i denorm_mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(121 << 23), abs);
+  __m256i denorm = _mm256_sub_epi32(
+      _mm256_castps_si256(_mm256_add_ps(
+          _mm256_castsi256_ps(abs), _mm256_castsi256_ps(denorm_magic))),
+      denorm_magic);
+  __m256i mant_odd =
+      _mm256_and_si256(_mm256_srli_epi32(abs, 20), _mm256_set1_epi32(1));
+  __m256i norm = _mm256_add_epi32(
+      abs,
+      _mm256_set1_epi32(static_cast<int32_t>(
+          (static_cast<uint32_t>(7 - 127) << 23) + 0x7FFFF)));
+  norm = _mm256_srli_epi32(_mm256_add_epi32(norm, mant_odd), 20);
+  __m256i res = _mm256_blendv_epi8(norm, denorm, denorm_mask);
+  res = _mm256_blendv_epi8(res, _mm256_set1_epi32(0x7F), nan_mask);
+  res = _mm256_or_si256(res, _mm256_srli_epi32(sign, 24));
+  return _pack_low_bytes_epi32(res);
+}
+
+inline __m128i cvt_fp32_to_fp8_e5m2(const __m256 src) {
+  const __m256i denorm_magic = _mm256_set1_epi32(134 << 23);
+  __m256i bits = _mm256_castps_si256(src);
+  __m256i sign = _mm256_and_si256(bits, _mm256_set1_epi32(0x80000000));
+  __m256i abs = _mm256_xor_si256(bits, sign);
+  __m256i nan_mask = _mm256_cmpgt_epi32(abs, _mm256_set1_epi32(0x7F800000));
+  abs = _mm256_min_epi32(abs, _mm256_set1_epi32(0x47600000));
+  __m256i denorm_mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(113 << 23), abs);
+  __m256i denorm = _mm256_sub_epi32(
+      _mm256_castps_si256(_mm256_add_ps(
+          _mm256_castsi256_ps(abs), _mm256_castsi256_ps(denorm_magic))),
+      denorm_magic);
+  __m256i mant_odd =
+      _mm256_and_si256(_mm256_srli_epi32(abs, 21), _mm256_set1_epi32(1));
+  __m256i norm = _mm256_add_epi32(
+      abs,
+      _mm256_set1_epi32(static_cast<int32_t>(
+          (static_cast<uint32_t>(15 - 127) << 23) + 0xFFFFF)));
+  norm = _mm256_srli_epi32(_mm256_add_epi32(norm, mant_odd), 21);
+  __m256i res = _mm256_blendv_epi8(norm, denorm, denorm_mask);
+  res = _mm256_blendv_epi8(res, _mm256_set1_epi32(0x7F), nan_mask);
+  res = _mm256_or_si256(res, _mm256_srli_epi32(sign, 24));
+  return _pack_low_bytes_epi32(res);
+}
+
+inline __m256 cvt_fp8_e4m3_to_fp32(const __m128i src) {
+  __m256i bits = _mm256_cvtepu8_epi32(src);
+  __m256i sign =
+      _mm256_slli_epi32(_mm256_and_si256(bits, _mm256_set1_epi32(0x80)), 24);
+  __m256i abs = _mm256_and_si256(bits, _mm256_set1_epi32(0x7F));
+  __m256i norm = _mm256_add_epi32(
+      _mm256_slli_epi32(abs, 20), _mm256_set1_epi32((127 - 7) << 23));
+  __m256 denorm =
+      _mm256_mul_ps(_mm256_cvtepi32_ps(abs), _mm256_set1_ps(1.0f / 512));
+  __m256i res = _mm256_blendv_epi8(
+      norm,
+      _mm256_castps_si256(denorm),
+      _mm256_cmpgt_epi32(_mm256_set1_epi32(8), abs));
+  res = _mm256_blendv_epi8(
+      res,
+      _mm256_set1_epi32(0x7FC00000),
+      _mm256_cmpeq_epi32(abs, _mm256_set1_epi32(0x7F)));
+  return _mm256_castsi256_ps(_mm256_or_si256(res, sign));
+}
+
+inline __m256 cvt_fp8_e5m2_to_fp32(const __m128i src) {
+  return _mm256_cvtph_ps(_mm_slli_epi16(_mm_cvtepu8_epi16(src), 8));
+}
+
+template <typename fp8_t>
+inline __m128i cvt_fp32_to_fp8(const __m256 src);
+
+template <>
+inline __m128i cvt_fp32_to_fp8<at::Float8_e4m3fn>(const __m256 src) {
+  return cvt_fp32_to_fp8_e4m3(src);
+}
+
+template <>
+inline __m128i cvt_fp32_to_fp8<at::Float8_e5m2>(const __m256 src) {
+  return cvt_fp32_to_fp8_e5m2(src);
+}
+
+template <typename fp8_t>
+inline __m256 cvt_fp8_to_fp32(const __m128i src);
+
+template <>
+inline __m256 cvt_fp8_to_fp32<at::Float8_e4m3fn>(const __m128i src) {
+  return cvt_fp8_e4m3_to_fp32(src);
+}
+
+template <>
+inline __m256 cvt_fp8_to_fp32<at::Float8_e5m2>(const __m128i src) {
+  return cvt_fp8_e5m2_to_fp32(src);
+}
+
+inline __m256 _loadu_fp32x8(const float* data_base) {
+  return _mm256_loadu_ps(data_base);
+}
+
+inline __m256 _loadu_fp32x8(const at::BFloat16* data_base) {
+  return _mm256_castsi256_ps(_mm256_slli_epi32(
+      _mm256_cvtepu16_epi32(_mm_loadu_si128((__m128i*)data_base)), 16));
+}
+
+inline __m256 _loadu_fp32x8(const at::Half* data_base) {
+  return _mm256_cvtph_ps(_mm_loadu_si128((__m128i*)data_base));
+}
+
+inline void _storeu_fp32x8(float* data_base, __m256 a) {
+  _mm256_storeu_ps(data_base, a);
+}
+
+// round-to-nearest-even, NaN is kept as a quiet NaN
+inline void _storeu_fp32x8(at::BFloat16* data_base, __m256 a) {
+  __m256i bits = _mm256_castps_si256(a);
+  __m256i lsb =
+      _mm256_and_si256(_mm256_srli_epi32(bits, 16), _mm256_set1_epi32(1));
+  __m256i rounded = _mm256_add_epi32(
+      _mm256_add_epi32(bits, _mm256_set1_epi32(0x7FFF)), lsb);
+  rounded = _mm256_blendv_epi8(
+      rounded,
+      _mm256_set1_epi32(0x7FC00000),
+      _mm256_castps_si256(_mm256_cmp_ps(a, a, _CMP_UNORD_Q)));
+  rounded = _mm256_srli_epi32(rounded, 16);
+  __m128i res = _mm_packus_epi32(
+      _mm256_castsi256_si128(rounded), _mm256_extracti128_si256(rounded, 1));
+  _mm_storeu_si128((__m128i*)data_base, res);
+}
+
+inline void _storeu_fp32x8(at::Half* data_base, __m256 a) {
+  _mm_storeu_si128(
+      (__m128i*)data_base,
+      _mm256_cvtps_ph(a, (_MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)));
+}
+
+template <typename fp8_t>
+inline fp8_t _fp8_saturate_cast(float val) {
+  constexpr float fp8_max =
+      std::is_same<fp8_t, at::Float8_e4m3fn>::value ? 448.f : 57344.f;
+  return static_cast<fp8_t>(std::max(std::min(val, fp8_max), -fp8_max));
+}
+
+template <typename T, typename fp8_t>
+inline float _fp8_quantize(
+    const T* in,
+    fp8_t* out,
+    int64_t len,
+    float scale) {
+  auto vscale = _mm256_set1_ps(scale);
+  auto vsign = _mm256_set1_ps(-0.f);
+  auto vamax = _mm256_setzero_ps();
+  int64_t i = 0;
+  for (; i < len - 7; i += 8) {
+    auto x = _loadu_fp32x8(in + i);
+    // NaN in the input is skipped by max_ps, as fmaxf does
+    vamax = _mm256_max_ps(_mm256_andnot_ps(vsign, x), vamax);
+    _mm_storel_epi64(
+        (__m128i*)(out + i), cvt_fp32_to_fp8<fp8_t>(_mm256_mul_ps(x, vscale)));
+  }
+  float amax_arr[8];
+  _mm256_storeu_ps(amax_arr, vamax);
+  float amax = *std::max_element(amax_arr, amax_arr + 8);
+  for (; i < len; i++) {
+    float x = static_cast<float>(in[i]);
+    amax = fmaxf(fabsf(x), amax);
+    out[i] = _fp8_saturate_cast<fp8_t>(x * scale);
+  }
+  return amax;
+}
+
+template <typename fp8_t, typename T>
+inline void _fp8_dequantize(
+    const fp8_t* in,
+    T* out,
+    int64_t len,
+    float scale_inv) {
+  auto vscale_inv = _mm256_set1_ps(scale_inv);
+  int64_t i = 0;
+  for (; i < len - 7; i += 8) {
+    auto x = cvt_fp8_to_fp32<fp8_t>(_mm_loadl_epi64((__m128i*)(in + i)));
+    _storeu_fp32x8(out + i, _mm256_mul_ps(x, vscale_inv));
+  }
+  for (; i < len; i++) {
+    out[i] = static_cast<T>(static_cast<float>(in[i]) * scale_inv);
+  }
+}
+
+} // namespace kernel
+} // namespace cpu
+} // namespace torch_ipex
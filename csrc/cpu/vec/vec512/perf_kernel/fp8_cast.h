@@ -0,0 +1,182 @@
+#pragma once
+
+#include <c10/util/Float8_e4m3fn.h>
+#include <c10/util/Float8_e5m2.h>
+#include <immintrin.h>
+#include "utils.h"
+
+namespace torch_ipex {
+namespace cpu {
+namespace kernel {
+
+// Conversions between fp32 and the fp8 formats (e4m3fn and e5m2) with
+// round-to-nearest-even. Finite values beyond the fp8 range, including inf,
+// saturate to the largest finite fp8 value (448 for e4m3fn, 57344 for e5m2)
+// and NaN is kept as NaN. The rounding follows c10::Float8_e4m3fn and
+// c10::Float8_e5m2: values below the smallest fp8 normal are rounded by
+// an fp32 addition with a magic number, normal values by integer arithmetic
+// on the fp32 bits.
+inline __m128i cvt_fp32_to_fp8_e4m3(const __m512 src) {
+  const __m512i denorm_magic = _mm512_set1_epi32(141 << 23);
+  __m512i bits = _mm512_castps_si512(src);
+  __m512i sign = _mm512_and_si512(bits, _mm512_set1_epi32(0x80000000));
+  __m512i abs = _mm512_xor_si512(bits, sign);
+  __mmask16 nan_mask =
+      _mm512_cmpgt_epu32_mask(abs, _mm512_set1_epi32(0x7F800000));
+  abs = _mm512_min_epu32(abs, _mm512_set1_epi32(0x43E00000));
+  __mmask16 denorm_mask =
+      _mm512_cmplt_epu32_mask(abs, _mm512_set1_epi32(121 << 23));
+  __m512i denorm = _mm512_sub_epi32(
+      _mm512_castps_si512(_mm512_add_ps(
+          _mm512_castsi512_ps(abs), _mm512_castsi512_ps(denorm_magic))),
+      denorm_magic);
+  __m512i mant_odd =
+      _mm512_and_si512(_mm512_srli_epi32(abs, 20), _mm512_set1_epi32(1));
+  __m512i norm = _mm512_add_epi32(
+      abs,
+      _mm512_set1_epi32(static_cast<int32_t>(
+          (static_cast<uint32_t>(7 - 127) << 23) + 0x7FFFF)));
+  norm = _mm512_srli_epi32(_mm512_add_epi32(norm, mant_odd), 20);
+  __m512i res = _mm512_mask_blend_epi32(denorm_mask, norm, denorm);
+  res = _mm512_mask_mov_epi32(res, nan_mask, _mm512_set1_epi32(0x7F));
+  res = _mm512_or_si512(res, _mm512_srli_epi32(sign, 24));
+  return _mm512_cvtepi32_epi8(res);
+}
+
+inline __m128i cvt_fp32_to_fp8_e5m2(const __m512 src) {
+  const __m512i denorm_magic = _mm512_set1_epi32(134 << 23);
+  __m512i bits = _mm512_castps_si512(src);
+  __m512i sign = _mm512_and_si512(bits, _mm512_set1_epi32(0x80000000));
+  __m512i abs = _mm512_xor_si512(bits, sign);
+  __mmask16 nan_mask =
+      _mm512_cmpgt_epu32_mask(abs, _mm512_set1_epi32(0x7F800000));
+  abs = _mm512_min_epu32(abs, _mm512_set1_epi32(0x47600000));
+  __mmask16 denorm_mask =
+      _mm512_cmplt_epu32_mask(abs, _mm512_set1_epi32(113 << 23));
+  __m512i denorm = _mm512_sub_epi32(
+      _mm512_castps_si512(_mm512_add_ps(
+          _mm512_castsi512_ps(abs), _mm512_castsi512_ps(denorm_magic))),
+      denorm_magic);
+  __m512i mant_odd =
+      _mm512_and_si512(_mm512_srli_epi32(abs, 21), _mm512_set1_epi32(1));
+  __m512i norm = _mm512_add_epi32(
+      abs,
+      _mm512_set1_epi32(static_cast<int32_t>(
+          (static_cast<uint32_t>(15 - 127) << 23) + 0xFFFFF)));
+  norm = _mm512_srli_epi32(_mm512_add_epi32(norm, mant_odd), 21);
+  __m512i res = _mm512_mask_blend_epi32(denorm_mask, norm, denorm);
+  res = _mm512_mask_mov_epi32(res, nan_mask, _mm512_set1_epi32(0x7F));
+  res = _mm512_or_si512(res, _mm512_srli_epi32(sign, 24));
+  return _mm512_cvtepi32_epi8(res);
+}
+
+// fp8 e4m3fn normals are rebiased in the integer domain, subnormals are
+// converted through cvtepi32_ps so the result does not depend on the
+// denormals-are-zero mode.
+inline __m512 cvt_fp8_e4m3_to_fp32(const __m128i src) {
+  __m512i bits = _mm512_cvtepu8_epi32(src);
+  __m512i sign =
+      _mm512_slli_epi32(_mm512_and_si512(bits, _mm512_set1_epi32(0x80)), 24);
+  __m512i abs = _mm512_and_si512(bits, _mm512_set1_epi32(0x7F));
+  __m512i norm = _mm512_add_epi32(
+      _mm512_slli_epi32(abs, 20), _mm512_set1_epi32((127 - 7) << 23));
+  __m512 denorm =
+      _mm512_mul_ps(_mm512_cvtepi32_ps(abs), _mm512_set1_ps(1.0f / 512));
+  __m512i res = _mm512_mask_blend_epi32(
+      _mm512_cmplt_epu32_mask(abs, _mm512_set1_epi32(8)),
+      norm,
+      _mm512_castps_si512(denorm));
+  res = _mm512_mask_mov_epi32(
+      res,
+      _mm512_cmpeq_epu32_mask(abs, _mm512_set1_epi32(0x7F)),
+      _mm512_set1_epi32(0x7FC00000));
+  return _mm512_castsi512_ps(_mm512_or_si512(res, sign));
+}
+
+// fp8 e5m2 is the upper byte of fp16
+inline __m512 cvt_fp8_e5m2_to_fp32(const __m128i src) {
+  return _mm512_cvtph_ps(_mm256_slli_epi16(_mm256_cvtepu8_epi16(src), 8));
+}
+
+template <typename fp8_t>
+inline __m128i cvt_fp32_to_fp8(const __m512 src);
+
+template <>
+inline __m128i cvt_fp32_to_fp8<at::Float8_e4m3fn>(const __m512 src) {
+  return cvt_fp32_to_fp8_e4m3(src);
+}
+
+template <>
+inline __m128i cvt_fp32_to_fp8<at::Float8_e5m2>(const __m512 src) {
+  return cvt_fp32_to_fp8_e5m2(src);
+}
+
+template <typename fp8_t>
+inline __m512 cvt_fp8_to_fp32(const __m128i src);
+
+template <>
+inline __m512 cvt_fp8_to_fp32<at::Float8_e4m3fn>(const __m128i src) {
+  return cvt_fp8_e4m3_to_fp32(src);
+}
+
+template <>
+inline __m512 cvt_fp8_to_fp32<at::Float8_e5m2>(const __m128i src) {
+  return cvt_fp8_e5m2_to_fp32(src);
+}
+
+// out = saturate(in * scale), returns max(abs(in)) of the unscaled input so
+// that the amax used by delayed scaling costs no extra pass over the input.
+template <typename T, typename fp8_t>
+inline float _fp8_quantize(
+    const T* in,
+    fp8_t* out,
+    int64_t len,
+    float scale) {
+  auto vscale = _mm512_set1_ps(scale);
+  // NaN in the input is skipped by max_ps, as fmaxf does
+  auto vamax = _mm512_setzero_ps();
+  int64_t i = 0;
+  for (; i < len - 31; i += 32) {
+    auto x0 = _loadu(in + i);
+    auto x1 = _loadu(in + i + 16);
+    vamax = _mm512_max_ps(_mm512_abs_ps(x0), vamax);
+    vamax = _mm512_max_ps(_mm512_abs_ps(x1), vamax);
+    _mm_storeu_si128(
+        (__m128i*)(out + i), cvt_fp32_to_fp8<fp8_t>(_mm512_mul_ps(x0, vscale)));
+    _mm_storeu_si128(
+        (__m128i*)(out + i + 16),
+        cvt_fp32_to_fp8<fp8_t>(_mm512_mul_ps(x1, vscale)));
+  }
+  for (; i < len; i += 16) {
+    __mmask16 mask = len - i >= 16 ? 0xFFFF : (1 << (len - i)) - 1;
+    auto x = _maskz_loadu(in + i, mask);
+    vamax = _mm512_max_ps(_mm512_abs_ps(x), vamax);
+    _mm_mask_storeu_epi8(
+        out + i, mask, cvt_fp32_to_fp8<fp8_t>(_mm512_mul_ps(x, vscale)));
+  }
+  return _mm512_reduce_max_ps(vamax);
+}
+
+// out = in * scale_inv
+template <typename fp8_t, typename T>
+inline void _fp8_dequantize(
+    const fp8_t* in,
+    T* out,
+    int64_t len,
+    float scale_inv) {
+  auto vscale_inv = _mm512_set1_ps(scale_inv);
+  int64_t i = 0;
+  for (; i < len - 15; i += 16) {
+    auto x = cvt_fp8_to_fp32<fp8_t>(_mm_loadu_si128((__m128i*)(in + i)));
+    _storeu(out + i, _mm512_mul_ps(x, vscale_inv));
+  }
+  if (i < len) {
+    __mmask16 mask = (1 << (len - i)) - 1;
+    auto x = cvt_fp8_to_fp32<fp8_t>(_mm_maskz_loadu_epi8(mask, in + i));
+    _mask_storeu(out + i, _mm512_mul_ps(x, vscale_inv), mask);
+  }
+}
+
+} // namespace kernel
+} // namespace cpu
+} // namespace torch_ipex
@@ -2,5 +2,6 @@
 #include "add_softmax.h"
 #include "add_swish.h"
 #include "concat_bn_relu.h"
+#include "fp8_cast.h"
 #include "rmsnorm.h"
 #include "update_batch.h"
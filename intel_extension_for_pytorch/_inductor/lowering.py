@@ -55,6 +55,8 @@ make_fallback(torch.ops.torch_ipex.ROIAlign_backward)
 make_fallback(torch.ops.torch_ipex.batch_norm_forward)
 make_fallback(torch.ops.torch_ipex.batch_norm_backward)
 make_fallback(torch.ops.torch_ipex.cumsum)
+make_fallback(torch.ops.torch_ipex.cumprod)
+make_fallback(torch.ops.torch_ipex.logcumsumexp)
 make_fallback(torch.ops.torch_ipex.tpp_linear)
 make_fallback(torch.ops.torch_ipex.tpp_linear_bias)
 make_fallback(torch.ops.torch_ipex.tpp_linear_gelu)
@@ -63,6 +65,7 @@ make_fallback(torch.ops.torch_ipex.tpp_linear_relu)
 make_fallback(torch.ops.torch_ipex.tpp_linear_silu)
 make_fallback(torch.ops.torch_ipex.tpp_linear_add)
 make_fallback(torch.ops.torch_ipex.tpp_linear_mul)
+make_fallback(torch.ops.torch_ipex.tpp_linear_lora)
 make_fallback(torch.ops.torch_ipex.masked_multihead_self_attention)
 make_fallback(torch.ops.torch_ipex.rotary_position_embedding)
 
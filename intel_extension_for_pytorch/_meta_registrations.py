@@ -498,6 +498,29 @@ def meta_cumsum(
     input,
     dim,
     dtype=None,
+    exclusive=False,
+    reverse=False,
+):
+    return input.new_empty(input.shape)
+
+
+@register_meta("cumprod")
+def meta_cumprod(
+    input,
+    dim,
+    dtype=None,
+    exclusive=False,
+    reverse=False,
+):
+    return input.new_empty(input.shape)
+
+
+@register_meta("logcumsumexp")
+def meta_logcumsumexp(
+    input,
+    dim,
+    exclusive=False,
+    reverse=False,
 ):
     return input.new_empty(input.shape)
 
@@ -587,6 +610,39 @@ def meta_tpp_linear_mul(
     return input.new_empty((*input.shape[:-1], out_features))
 
 
+@register_meta("tpp_linear_lora")
+def meta_tpp_linear_lora(
+    input,
+    weight,
+    bias,
+    lora_a,
+    lora_b,
+    adapter_idx,
+    scale,
+    out_features=None,
+):
+    if out_features is None:
+        out_features = lora_b.size(-1)
+    return input.new_empty((*input.shape[:-1], out_features))
+
+
+@register_meta("tpp_linear_lora_backward")
+def meta_tpp_linear_lora_backward(
+    grad_out,
+    input,
+    weight,
+    lora_a,
+    lora_b,
+    adapter_idx,
+    scale,
+):
+    return (
+        input.new_empty(input.shape),
+        torch.empty_like(lora_a),
+        torch.empty_like(lora_b),
+    )
+
+
 @register_meta("masked_multihead_self_attention")
 def meta_masked_multihead_self_attention(
     query,
@@ -601,6 +657,7 @@ def meta_masked_multihead_self_attention(
     head_mask,
     attention_mask,
     add_casual_mask=None,
+    tree_mask=None,
 ):
     attn_output = query.new_empty(
         (query.shape[0], query.shape[2], query.shape[1], query.shape[3])
@@ -626,6 +683,32 @@ def meta_masked_multihead_self_attention(
     return (attn_output, attn_weights, key_cache_out, value_cache_out, beam_idx_out)
 
 
+@register_meta("tree_attention_mask")
+def meta_tree_attention_mask(parents):
+    num_candidates = parents.shape[0]
+    return parents.new_empty(
+        (num_candidates, (num_candidates + 63) // 64), dtype=torch.long
+    )
+
+
+@register_meta("indirect_kv_cache_compact")
+def meta_indirect_kv_cache_compact(key_cache, value_cache, beam_idx, offset, accepted):
+    # key_cache, value_cache and beam_idx are compacted in place
+    return None
+
+
+@register_meta("paged_kv_cache_compact")
+def meta_paged_kv_cache_compact(key_cache, value_cache, src_slots, dst_slots):
+    # key_cache and value_cache are compacted in place
+    torch._check(
+        src_slots.dtype == torch.int
+        and dst_slots.dtype == torch.int
+        and src_slots.numel() == dst_slots.numel(),
+        lambda: "src_slots and dst_slots should be int32 of the same size",
+    )
+    return None
+
+
 @register_meta("rotary_position_embedding")
 def meta_rotary_position_embedding(
     t_in,
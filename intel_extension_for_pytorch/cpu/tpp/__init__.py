@@ -1,6 +1,10 @@
 import pkg_resources
 import warnings
 from . import fused_bert
+from . import fused_llama
+from . import fused_lora
 from . import utils
 from . import optim
+from . import profiling
+from . import prefetch
 from .utils.blocked_layout import block_model_params as block
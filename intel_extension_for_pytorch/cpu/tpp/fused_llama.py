@@ -0,0 +1,300 @@
+import torch
+from torch import nn
+from .utils.blocked_layout import (
+    BlockedParameter,
+    BlockedModule,
+    BlockedTensor,
+    get_blocking_signature,
+)
+from .fused_bert import DummyLinear, generate_mask, UnpadInput, PadInput
+import intel_extension_for_pytorch._C as torch_ipex_cpp  # noqa: F401
+
+layer_use_bf16 = False
+
+
+def rotary_cos_sin(seq_offsets, S2, head_dim, base=10000.0):
+    """Per token cos / sin tables [S1 * S2, head_dim] for the unpadded layout.
+
+    seq_offsets holds the cumulative number of S2 sized blocks per sequence,
+    positions restart at 0 at the first block of every sequence.
+    """
+    blocks = seq_offsets[1:] - seq_offsets[:-1]
+    pos = torch.cat([torch.arange(int(b) * S2) for b in blocks]).float()
+    inv_freq = 1.0 / (
+        base ** (torch.arange(0, head_dim, 2, dtype=torch.float) / head_dim)
+    )
+    freqs = torch.outer(pos, inv_freq)
+    emb = torch.cat((freqs, freqs), dim=-1)
+    return emb.cos().contiguous(), emb.sin().contiguous()
+
+
+def _bf16_weight_blocking(H):
+    return ([H, [H // 2, 2]], [0, 2, 3, 1, 4], torch.bfloat16)
+
+
+class LlamaRMSNormFunction(torch.autograd.Function):
+    @staticmethod
+    def forward(ctx, eps, input, gamma):
+        out, rstd = torch.ops.torch_ipex.fused_rmsnorm_fwd_unpad(eps, input, gamma)
+        ctx.save_for_backward(input, gamma, rstd)
+        return out
+
+    @staticmethod
+    def backward(ctx, grad_out):
+        input, gamma, rstd = ctx.saved_tensors
+        grad_out = grad_out.contiguous()
+        grad_inp, grad_gamma = torch.ops.torch_ipex.fused_rmsnorm_bwd_unpad(
+            grad_out, input, gamma, rstd
+        )
+        return (None, grad_inp, grad_gamma)
+
+
+class LlamaRMSNorm(BlockedModule):
+    def __init__(self, hidden_size, eps=1e-6, block_size=64):
+        super().__init__()
+        self.weight = BlockedParameter(torch.ones(hidden_size))
+        self.variance_epsilon = eps
+        self.block_size = block_size
+        self.blocked_input_signature = get_blocking_signature("SF", "SFSF")
+        self.use_bf16 = layer_use_bf16
+
+    def forward(self, hidden_states):
+        orig_hidden_states = hidden_states
+        hidden_states = self.get_blocked_tensor(
+            hidden_states,
+            self.blocked_input_signature,
+            [None, self.block_size],
+        )
+        inputs = [hidden_states, self.weight]
+        if self.use_bf16:
+            inputs = [i.to(torch.bfloat16) for i in inputs]
+        ret = LlamaRMSNormFunction.apply(self.variance_epsilon, *inputs)
+        return BlockedTensor(
+            ret, self.blocked_input_signature, orig_hidden_states.dtype
+        )
+
+
+class LlamaDenseAddFunction(torch.autograd.Function):
+    @staticmethod
+    def forward(ctx, input, residual, weight):
+        (out,) = torch.ops.torch_ipex.fused_dense_add_fwd_unpad(input, residual, weight)
+        ctx.save_for_backward(input, weight)
+        return out
+
+    @staticmethod
+    def backward(ctx, grad_out):
+        input, weight = ctx.saved_tensors
+        grad_out = grad_out.contiguous()
+        grad_inp, grad_wt = torch.ops.torch_ipex.fused_dense_add_bwd_unpad(
+            grad_out, input, weight
+        )
+        return (grad_inp, grad_out, grad_wt)
+
+
+class LlamaAttentionFunction(torch.autograd.Function):
+    @staticmethod
+    def forward(ctx, training, *inputs):
+        (
+            context_layer,
+            hs_t,
+            ql_t,
+            kl_v,
+            vl_tv,
+            ap,
+            ap_t,
+        ) = torch.ops.torch_ipex.fused_llama_attention_fwd_unpad(inputs, training)
+        qw, kw, vw, hs, cos, sin, offs, offs2 = inputs
+        ctx.save_for_backward(
+            qw, kw, vw, hs_t, ql_t, kl_v, vl_tv, ap, ap_t, cos, sin, offs, offs2
+        )
+        return context_layer
+
+    @staticmethod
+    def backward(ctx, grad_out):
+        inputs = [grad_out.contiguous()]
+        inputs += ctx.saved_tensors
+        (
+            dqw,
+            dkw,
+            dvw,
+            dhs,
+        ) = torch.ops.torch_ipex.fused_llama_attention_bwd_unpad(inputs)
+        return (None, dqw, dkw, dvw, dhs, None, None, None, None)
+
+
+class LlamaSwiGLUFunction(torch.autograd.Function):
+    @staticmethod
+    def forward(ctx, training, input, weight):
+        out, y = torch.ops.torch_ipex.fused_dense_swiglu_fwd_unpad(
+            input, weight, training
+        )
+        ctx.save_for_backward(input, weight, y)
+        return out
+
+    @staticmethod
+    def backward(ctx, grad_out):
+        input, weight, y = ctx.saved_tensors
+        grad_out = grad_out.contiguous()
+        grad_inp, grad_wt = torch.ops.torch_ipex.fused_dense_swiglu_bwd_unpad(
+            grad_out, y, input, weight
+        )
+        return (None, grad_inp, grad_wt)
+
+
+class LlamaAttention(BlockedModule):
+    r"""Rotary-embedded causal GQA self attention followed by o_proj and the
+    residual add, using libxsmm blocked GEMMs"""
+
+    def __init__(self, config):
+        super().__init__()
+        self.hidden_size = config.hidden_size
+        self.num_heads = config.num_attention_heads
+        self.head_dim = self.hidden_size // self.num_heads
+        self.num_key_value_heads = getattr(
+            config, "num_key_value_heads", self.num_heads
+        )
+        assert (
+            self.num_heads % self.num_key_value_heads == 0
+        ), "num_attention_heads must be a multiple of num_key_value_heads"
+        kv_size = self.num_key_value_heads * self.head_dim
+
+        self.q_proj = DummyLinear(self.hidden_size, self.hidden_size, bias=False)
+        self.k_proj = DummyLinear(self.hidden_size, kv_size, bias=False)
+        self.v_proj = DummyLinear(self.hidden_size, kv_size, bias=False)
+        self.o_proj = DummyLinear(self.hidden_size, self.hidden_size, bias=False)
+        H = self.head_dim
+        for proj in [self.q_proj, self.k_proj, self.v_proj, self.o_proj]:
+            proj.weight.set_blocking_param(([H, H], [0, 2, 3, 1]))
+            if layer_use_bf16:
+                proj.weight.set_blocking_param(_bf16_weight_blocking(H))
+        self.blocked_input_signature = get_blocking_signature("SF", "SFSF")
+        self.use_bf16 = layer_use_bf16
+
+    def maybe_block_params(self):
+        self.q_proj.weight.block()
+        self.k_proj.weight.block()
+        self.v_proj.weight.block()
+        self.o_proj.weight.block()
+
+    def forward(self, hidden_states, residual, cos, sin, seq_offsets, seq_sqr_offsets):
+        self.maybe_block_params()
+        orig_hidden_states = residual
+        hidden_states = self.get_blocked_tensor(
+            hidden_states,
+            self.blocked_input_signature,
+            [None, self.head_dim],
+        )
+        residual = self.get_blocked_tensor(
+            residual,
+            self.blocked_input_signature,
+            [None, self.head_dim],
+        )
+        inputs = [
+            self.q_proj.weight,
+            self.k_proj.weight,
+            self.v_proj.weight,
+            hidden_states,
+        ]
+        o_inputs = [residual, self.o_proj.weight]
+        if self.use_bf16:
+            inputs = [i.to(torch.bfloat16) for i in inputs]
+            o_inputs = [i.to(torch.bfloat16) for i in o_inputs]
+        inputs += [cos, sin, seq_offsets, seq_sqr_offsets]
+        context_layer = LlamaAttentionFunction.apply(self.training, *inputs)
+        ret = LlamaDenseAddFunction.apply(context_layer, *o_inputs)
+        return BlockedTensor(
+            ret, self.blocked_input_signature, orig_hidden_states.dtype
+        )
+
+
+class LlamaMLP(BlockedModule):
+    r"""SwiGLU MLP followed by down_proj and the residual add, using libxsmm
+    blocked GEMMs. gate_proj and up_proj run as one GEMM over the packed
+    weight."""
+
+    def __init__(self, config, block_size=64):
+        super().__init__()
+        self.hidden_size = config.hidden_size
+        self.intermediate_size = config.intermediate_size
+        assert getattr(config, "hidden_act", "silu") == "silu", (
+            "Only SiLU gating is supported in fused op, %s is given" % config.hidden_act
+        )
+        self.gate_proj = DummyLinear(
+            self.hidden_size, self.intermediate_size, bias=False
+        )
+        self.up_proj = DummyLinear(self.hidden_size, self.intermediate_size, bias=False)
+        self.down_proj = DummyLinear(
+            self.intermediate_size, self.hidden_size, bias=False
+        )
+        H = block_size
+        self.block_size = block_size
+        for proj in [self.gate_proj, self.up_proj, self.down_proj]:
+            proj.weight.set_blocking_param(([H, H], [0, 2, 3, 1]))
+            if layer_use_bf16:
+                proj.weight.set_blocking_param(_bf16_weight_blocking(H))
+        self.blocked_input_signature = get_blocking_signature("SF", "SFSF")
+        self.use_bf16 = layer_use_bf16
+
+    def maybe_block_params(self):
+        self.gate_proj.weight.block()
+        self.up_proj.weight.block()
+        self.down_proj.weight.block()
+
+    def forward(self, hidden_states, residual):
+        self.maybe_block_params()
+        orig_hidden_states = residual
+        hidden_states = self.get_blocked_tensor(
+            hidden_states,
+            self.blocked_input_signature,
+            [None, self.block_size],
+        )
+        residual = self.get_blocked_tensor(
+            residual,
+            self.blocked_input_signature,
+            [None, self.block_size],
+        )
+        gate_up = torch.cat([self.gate_proj.weight, self.up_proj.weight], dim=0)
+        inputs = [hidden_states, gate_up]
+        o_inputs = [residual, self.down_proj.weight]
+        if self.use_bf16:
+            inputs = [i.to(torch.bfloat16) for i in inputs]
+            o_inputs = [i.to(torch.bfloat16) for i in o_inputs]
+        act = LlamaSwiGLUFunction.apply(self.training, *inputs)
+        ret = LlamaDenseAddFunction.apply(act, *o_inputs)
+        return BlockedTensor(
+            ret, self.blocked_input_signature, orig_hidden_states.dtype
+        )
+
+
+class LlamaDecoderLayer(nn.Module):
+    def __init__(self, config):
+        super().__init__()
+        eps = getattr(config, "rms_norm_eps", 1e-6)
+        head_dim = config.hidden_size // config.num_attention_heads
+        self.self_attn = LlamaAttention(config)
+        self.mlp = LlamaMLP(config, head_dim)
+        self.input_layernorm = LlamaRMSNorm(config.hidden_size, eps, head_dim)
+        self.post_attention_layernorm = LlamaRMSNorm(config.hidden_size, eps, head_dim)
+
+    def forward(self, hidden_states, cos, sin, seq_offsets, seq_sqr_offsets):
+        # hidden_states is unpadded [S1 * S2, hidden_size], see generate_mask
+        residual = hidden_states
+        hidden_states = self.input_layernorm(hidden_states)
+        hidden_states = self.self_attn(
+            hidden_states, residual, cos, sin, seq_offsets, seq_sqr_offsets
+        )
+        residual = hidden_states
+        hidden_states = self.post_attention_layernorm(hidden_states)
+        return self.mlp(hidden_states, residual)
+
+
+__all__ = [
+    "generate_mask",
+    "rotary_cos_sin",
+    "LlamaRMSNorm",
+    "LlamaAttention",
+    "LlamaMLP",
+    "LlamaDecoderLayer",
+    "PadInput",
+    "UnpadInput",
+]
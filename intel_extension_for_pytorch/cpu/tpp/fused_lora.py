@@ -0,0 +1,65 @@
+import torch
+import intel_extension_for_pytorch._C as torch_ipex_cpp  # noqa: F401
+
+
+class TPPLoRALinearFunction(torch.autograd.Function):
+    @staticmethod
+    def forward(ctx, input, weight, bias, lora_a, lora_b, adapter_idx, scale):
+        out = torch.ops.torch_ipex.tpp_linear_lora(
+            input, weight, bias, lora_a, lora_b, adapter_idx, scale
+        )
+        ctx.scale = scale
+        ctx.save_for_backward(input, weight, lora_a, lora_b, adapter_idx)
+        return out
+
+    @staticmethod
+    def backward(ctx, grad_out):
+        input, weight, lora_a, lora_b, adapter_idx = ctx.saved_tensors
+        grad_out = grad_out.contiguous()
+        grad_inp, grad_a, grad_b = torch.ops.torch_ipex.tpp_linear_lora_backward(
+            grad_out, input, weight, lora_a, lora_b, adapter_idx, ctx.scale
+        )
+        return (grad_inp, None, None, grad_a, grad_b, None, None)
+
+
+def tpp_linear_lora(input, weight, bias, lora_a, lora_b, adapter_idx=None, scale=1.0):
+    r"""Computes ``input * W^T + bias + scale * (input * A) * B`` with the
+    TPP linear kernels. The rank sized ``input * A`` is computed in a pass
+    ahead of the base GEMM and its up projection is added in the epilogue of
+    the base GEMM, so no full size intermediate is written and read back.
+
+    Args:
+        input: activation of shape [batch, seq_len, in_features].
+        weight: TPP blocked weight of a linear optimized with TPP enabled.
+        bias: bias of the linear or None.
+        lora_a: adapter down projection [in_features, rank], or
+            [n_adapters, in_features, rank] for several stacked adapters.
+        lora_b: adapter up projection [rank, out_features], or
+            [n_adapters, rank, out_features].
+        adapter_idx: int64 tensor with the adapter of each of the
+            batch * seq_len rows, a negative index leaves the row with the
+            base linear only. None applies adapter 0 to every row.
+        scale: LoRA scaling, usually lora_alpha / rank.
+
+    The base weight and bias are treated as frozen, gradients are returned for
+    the input and the adapters only.
+    """
+    input = input.to(weight.dtype).contiguous()
+    if bias is None:
+        bias = input.new_empty(0)
+    if adapter_idx is None:
+        adapter_idx = torch.empty(0, dtype=torch.long)
+    return TPPLoRALinearFunction.apply(
+        input,
+        weight.detach(),
+        bias.detach(),
+        lora_a.to(weight.dtype),
+        lora_b.to(weight.dtype),
+        adapter_idx.contiguous(),
+        scale,
+    )
+
+
+__all__ = [
+    "tpp_linear_lora",
+]
@@ -92,7 +92,7 @@ class SGD(Optimizer):
                     ipex_cpp.tpp_bf16_split_add_(p.data, buf, d_p, -group["lr"])
                 else:
                     if d_p.is_sparse:
-                        ipex_cpp.tpp_dense_sparse_add(p.data, d_p, -group["lr"])
+                        ipex_cpp.tpp_dense_sparse_add_(p.data, d_p, -group["lr"])
                     else:
                         p.data.add_(d_p, alpha=-group["lr"])
 
@@ -0,0 +1,67 @@
+import torch
+import intel_extension_for_pytorch._C as torch_ipex_cpp
+
+
+def set_next_weight(weight, next_weight):
+    r"""Hints that the linear reading ``weight`` is followed by the one
+    reading ``next_weight``.
+
+    During decode (at most 8 rows), the TPP and weight only quantized linear
+    kernels then use the tail of the GEMM, when threads that finished their
+    share wait for the last tiles of the others, to prefetch the head of
+    ``next_weight`` into L2. Both are the packed weights the kernels read.
+    Only weak references to them are kept, the hint is dropped once either
+    weight is freed.
+    """
+    torch_ipex_cpp.tpp_set_next_weight(weight, next_weight)
+
+
+def clear():
+    r"""Drops all hints."""
+    torch_ipex_cpp.tpp_clear_next_weights()
+
+
+def _kernel_weight(module):
+    from ...nn.utils._weight_prepack import _IPEXLinear
+    from ...nn.modules.weight_only_quantization import IpexWoqLinear
+
+    if isinstance(module, IpexWoqLinear):
+        return module._op_context.get_weight()
+    if (
+        isinstance(module, _IPEXLinear)
+        and getattr(module, "use_tpp", False)
+        and not module.tpp_fallback
+    ):
+        return module.weight.detach()
+    return None
+
+
+def register_layer_order(modules, cyclic=True):
+    r"""Registers the order in which the linears of a model run.
+
+    Args:
+        modules: a model optimized by ``ipex.optimize`` or
+            ``ipex.llm.optimize``, whose TPP and weight only quantized linears
+            are taken in the order they are defined (which is the execution
+            order of the usual decoder layers: q, k, v, o, gate, up, down),
+            or an explicit list of such linears in execution order.
+        cyclic: also hint the first linear after the last one, as the next
+            decode step starts over.
+
+    Returns the number of linears registered.
+    """
+    if isinstance(modules, torch.nn.Module):
+        modules = modules.modules()
+    weights = [w for w in (_kernel_weight(m) for m in modules) if w is not None]
+    for weight, next_weight in zip(weights, weights[1:]):
+        set_next_weight(weight, next_weight)
+    if cyclic and len(weights) > 1:
+        set_next_weight(weights[-1], weights[0])
+    return len(weights)
+
+
+__all__ = [
+    "set_next_weight",
+    "clear",
+    "register_layer_order",
+]
@@ -0,0 +1,65 @@
+import json
+from contextlib import contextmanager
+import intel_extension_for_pytorch._C as torch_ipex_cpp
+
+
+def reset_timers():
+    r"""Clears the accumulated TPP debug timers and the recorded timeline."""
+    torch_ipex_cpp.tpp_reset_debug_timers()
+
+
+def debug_timers():
+    r"""Returns the accumulated TPP debug timers as a dict.
+
+    Holds one entry per pass (OTH / FWD / BWD / UPD) and per registered scope
+    that ran, with the time in seconds, the BRGEMM flops and achieved GFLOP/s,
+    the per thread time and flops split by timer kind, and the thread
+    imbalance (max / mean thread time). The timers are only collected when the
+    extension is built with PROFILE_TPP, ``profile_tpp`` tells if it was.
+    """
+    return json.loads(torch_ipex_cpp.tpp_debug_timers_json())
+
+
+def enable_timeline(enable=True):
+    r"""Starts or stops recording one event per scope invocation."""
+    torch_ipex_cpp.tpp_enable_debug_timeline(enable)
+
+
+def export_chrome_trace(path):
+    r"""Writes the recorded timeline to ``path`` in the Chrome trace format.
+
+    Scope events use wall-clock microsecond timestamps, the process id and the
+    names of the matching ``torch.profiler`` spans, so the file can be opened
+    in chrome://tracing or Perfetto next to a profiler trace of the same run.
+    """
+    with open(path, "w") as f:
+        f.write(torch_ipex_cpp.tpp_debug_timeline_chrome_trace())
+
+
+@contextmanager
+def timeline(path=None):
+    r"""Records the TPP timeline of the enclosed region, writing it to
+    ``path`` as a Chrome trace on exit if given.
+
+    Example::
+
+        with tpp.profiling.timeline("tpp_trace.json"):
+            model(inputs)
+    """
+    reset_timers()
+    enable_timeline(True)
+    try:
+        yield
+    finally:
+        enable_timeline(False)
+        if path is not None:
+            export_chrome_trace(path)
+
+
+__all__ = [
+    "reset_timers",
+    "debug_timers",
+    "enable_timeline",
+    "export_chrome_trace",
+    "timeline",
+]
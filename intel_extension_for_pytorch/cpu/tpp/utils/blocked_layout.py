@@ -1,5 +1,6 @@
 import torch
 import torch.utils._pytree as pytree
+import intel_extension_for_pytorch._C as torch_ipex_cpp
 
 # import math
 # from enum import Enum
@@ -253,6 +254,8 @@ class BlockedParameter(torch.nn.Parameter):
                 permute=self.blocking_param[1],
             )
         self._data = self.blocking_manager.block(self._data).to(self.blocked_dtype)
+        # blocked weights live as long as the model, see cpu.utils.huge_pages
+        self._data = torch_ipex_cpp._to_long_lived(self._data)
         if self.grad is not None:
             self.grad.data = self.blocking_manager.block(self.grad.data).to(
                 self.blocked_dtype
@@ -0,0 +1,80 @@
+r"""
+Huge page backing of the buffers that live as long as the model.
+
+The packed weights of the oneDNN, TPP and weight only quantized linears and
+the indirect access KV cache can be mapped on huge pages and pre-faulted in
+parallel on the NUMA node of the allocating thread, which removes the TLB
+misses and first touch page faults they otherwise cause in decode latency
+and warmup. The option must be set before the model is optimized (or with
+``IPEX_HUGE_PAGES`` in the environment), the packing routines then use it:
+
+.. highlight:: python
+.. code-block:: python
+
+    from intel_extension_for_pytorch.cpu.utils import huge_pages
+    huge_pages.set_mode("thp")
+    model = ipex.llm.optimize(model, dtype=torch.bfloat16)
+    print(huge_pages.report())
+
+Explicit huge pages (``"2mb"``, ``"1gb"``) need a reserved pool, e.g.
+``/proc/sys/vm/nr_hugepages``, and fall back to transparent huge pages with a
+warning when it is exhausted.
+"""
+
+import intel_extension_for_pytorch._C as core
+
+_MODES = ("off", "thp", "2mb", "1gb")
+
+
+def set_mode(mode, min_bytes=None):
+    r"""Sets how long-lived buffers are allocated.
+
+    Args:
+        mode: ``"off"`` (default CPU allocator), ``"thp"`` (2MB aligned
+            mapping advised for transparent huge pages), ``"2mb"`` or
+            ``"1gb"`` (explicit huge pages of that size).
+        min_bytes: buffers smaller than this keep the default allocator
+            (2MB unless ``IPEX_HUGE_PAGES_MIN_BYTES`` is set). Unchanged if
+            None.
+    """
+    assert mode in _MODES, f"mode must be one of {_MODES}, got {mode}"
+    core._set_huge_page_mode(mode, -1 if min_bytes is None else min_bytes)
+
+
+def get_mode():
+    return core._get_huge_page_mode()
+
+
+def get_min_bytes():
+    return core._get_huge_page_min_bytes()
+
+
+def allocations():
+    r"""Returns the live huge page mappings, each with its address, requested
+    and mapped bytes, the mode it got (after the fallback from explicit huge
+    pages), the NUMA node it was bound to and the bytes actually backed by
+    huge pages according to ``/proc/self/smaps``."""
+    return core._get_long_lived_allocations()
+
+
+def report():
+    r"""Formats a summary of ``allocations()``."""
+    allocs = allocations()
+    lines = [f"huge page mode {get_mode()}, {len(allocs)} mappings"]
+    totals = {}
+    for a in allocs:
+        t = totals.setdefault((a["mode"], a["node"]), [0, 0, 0, 0])
+        t[0] += 1
+        t[1] += a["bytes"]
+        t[2] += a["mapped_bytes"]
+        t[3] += a["huge_bytes"]
+    lines.append(
+        f"{'mode':<6}{'node':>6}{'count':>8}{'GB':>10}{'mapped GB':>11}{'huge %':>8}"
+    )
+    for (mode, node), (count, nbytes, mapped, huge) in sorted(totals.items()):
+        huge_pct = huge / mapped * 100 if mapped > 0 else 0.0
+        lines.append(
+            f"{mode:<6}{node:>6}{count:>8}{nbytes * 1e-9:>10.3f}"
+            f"{mapped * 1e-9:>11.3f}{huge_pct:>8.1f}"
+        )
+    return "\n".join(lines)
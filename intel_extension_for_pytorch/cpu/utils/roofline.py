@@ -0,0 +1,128 @@
+r"""
+Roofline counters of the LLM decode kernels.
+
+While enabled, the weight only quantized linear, the TPP linears, the paged
+attention and the indirect access kv cache attention add the bytes they move
+and the FLOPs they perform per call to per-thread counters. ``report()`` sums
+them per kernel kind and compares the achieved bandwidth with the peak of the
+machine:
+
+.. highlight:: python
+.. code-block:: python
+
+    from intel_extension_for_pytorch.cpu.utils import roofline
+    with roofline.record():
+        model.generate(input_ids, max_new_tokens=32)
+    print(roofline.report())
+
+If ``torch.profiler`` runs at the same time, each counted call also shows an
+``ipex::roofline::<kind>`` event whose inputs are the weight, kv and
+activation bytes and the FLOPs (visible with ``record_shapes=True``).
+"""
+
+import time
+from contextlib import contextmanager
+
+import torch
+import intel_extension_for_pytorch._C as core
+
+
+def enable(enabled=True):
+    core._set_kernel_counters_enabled(enabled)
+
+
+def disable():
+    core._set_kernel_counters_enabled(False)
+
+
+def reset():
+    core._reset_kernel_counters()
+
+
+def counters():
+    r"""Returns the accumulated counters of every kernel kind, with the total
+    bytes and the achieved GB/s and GFLOP/s added."""
+    result = []
+    for c in core._get_kernel_counters():
+        c = dict(c)
+        c["bytes"] = c["weight_bytes"] + c["kv_bytes"] + c["activation_bytes"]
+        seconds = c["seconds"]
+        c["gbps"] = c["bytes"] / seconds * 1e-9 if seconds > 0 else 0.0
+        c["gflops"] = c["flops"] / seconds * 1e-9 if seconds > 0 else 0.0
+        c["intensity"] = c["flops"] / c["bytes"] if c["bytes"] > 0 else 0.0
+        result.append(c)
+    return result
+
+
+@contextmanager
+def record(reset_counters=True):
+    r"""Counts the instrumented kernels called inside the block."""
+    if reset_counters:
+        reset()
+    enable(True)
+    try:
+        yield
+    finally:
+        disable()
+
+
+def measure_peak_bandwidth(nbytes=1 << 29, repeat=5):
+    r"""Rough STREAM copy style estimate of the memory bandwidth in GB/s,
+    counting one read and one write of a buffer much larger than the LLC."""
+    src = torch.ones(nbytes // 4, dtype=torch.float)
+    dst = torch.empty_like(src)
+    best = float("inf")
+    for _ in range(repeat):
+        start = time.perf_counter()
+        dst.copy_(src)
+        best = min(best, time.perf_counter() - start)
+    return 2 * nbytes / best * 1e-9
+
+
+def measure_peak_gflops(size=4096, dtype=torch.bfloat16, repeat=3):
+    r"""Rough estimate of the GEMM peak in GFLOP/s for ``dtype``."""
+    a = torch.randn(size, size).to(dtype)
+    b = torch.randn(size, size).to(dtype)
+    torch.mm(a, b)
+    best = float("inf")
+    for _ in range(repeat):
+        start = time.perf_counter()
+        torch.mm(a, b)
+        best = min(best, time.perf_counter() - start)
+    return 2 * size**3 / best * 1e-9
+
+
+def report(peak_gbps=None, peak_gflops=None):
+    r"""Formats the counters as an achieved vs. peak table per kernel kind.
+
+    Args:
+        peak_gbps: memory bandwidth of the machine in GB/s, measured with
+            ``measure_peak_bandwidth()`` if None.
+        peak_gflops: compute peak in GFLOP/s used to tell memory from compute
+            bound kernels, measured with ``measure_peak_gflops()`` if None.
+    """
+    if peak_gbps is None:
+        peak_gbps = measure_peak_bandwidth()
+    if peak_gflops is None:
+        peak_gflops = measure_peak_gflops()
+    ridge = peak_gflops / peak_gbps
+    header = (
+        f"{'kernel':<28}{'calls':>8}{'GB':>10}{'ms':>10}{'GB/s':>9}"
+        f"{'%peak':>7}{'GFLOP/s':>9}{'FLOP/B':>8}  bound"
+    )
+    lines = [
+        f"peak {peak_gbps:.1f} GB/s, {peak_gflops:.1f} GFLOP/s, "
+        f"ridge point {ridge:.1f} FLOP/B",
+        header,
+    ]
+    for c in counters():
+        if c["calls"] == 0:
+            continue
+        bound = "memory" if c["intensity"] < ridge else "compute"
+        lines.append(
+            f"{c['name']:<28}{c['calls']:>8}{c['bytes'] * 1e-9:>10.3f}"
+            f"{c['seconds'] * 1e3:>10.2f}{c['gbps']:>9.1f}"
+            f"{c['gbps'] / peak_gbps * 100:>7.1f}{c['gflops']:>9.1f}"
+            f"{c['intensity']:>8.2f}  {bound}"
+        )
+    return "\n".join(lines)
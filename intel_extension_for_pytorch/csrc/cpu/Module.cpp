@@ -16,6 +16,7 @@
 #include <torch/csrc/jit/runtime/operator_options.h>
 #include "jit/fusion_pass.h"
 
+#include <algorithm>
 #include <cstring>
 #include <sstream>
 #include <string>
@@ -24,6 +25,8 @@
 #include "jit/auto_opt_config.h"
 #include "jit/cpu/tensorexpr/nnc_fuser_register.h"
 #include "utils/fpmath_mode.h"
+#include "utils/kernel_counters.h"
+#include "utils/long_lived_alloc.h"
 #include "utils/module_version.h"
 #include "utils/onednn_utils.h"
 
@@ -39,6 +42,8 @@
 #include "runtime/TaskExecutor.h"
 #include "toolkit/sklearn.h"
 #include "tpp/optim.h"
+#include "tpp/prefetch.h"
+#include "tpp/timing.h"
 #include "tpp/utils.h"
 
 namespace torch_ipex {
@@ -84,6 +89,120 @@ void InitIpexModuleBindings(py::module m) {
     return get_highest_binary_support_isa_level();
   });
 
+  m.def("_get_dispatch_stub_info", []() {
+    using namespace torch_ipex::cpu;
+    auto isa_or_none = [](CPUCapability isa) -> py::object {
+      if (isa == CPUCapability::NUM_OPTIONS) {
+        return py::none();
+      }
+      return py::str(CPUCapabilityToString(isa));
+    };
+    py::list stubs;
+    for (const auto& info : get_dispatch_stub_info()) {
+      py::list compiled;
+      for (auto isa : info.compiled) {
+        compiled.append(CPUCapabilityToString(isa));
+      }
+      py::dict calls;
+      for (size_t i = 0; i < info.calls.size(); i++) {
+        if (info.calls[i] > 0) {
+          calls[CPUCapabilityToString(static_cast<CPUCapability>(i))] =
+              info.calls[i];
+        }
+      }
+      py::dict stub;
+      stub["name"] = info.name;
+      stub["compiled"] = compiled;
+      stub["selected"] = isa_or_none(info.selected);
+      stub["override"] = isa_or_none(info.override_isa);
+      stub["calls"] = calls;
+      stubs.append(stub);
+    }
+    return stubs;
+  });
+
+  m.def(
+      "_set_dispatch_stub_capability",
+      [](const std::string& pattern, std::string isa_name) {
+        using namespace torch_ipex::cpu;
+        std::transform(
+            isa_name.begin(), isa_name.end(), isa_name.begin(), ::tolower);
+        CPUCapability isa;
+        TORCH_CHECK(
+            parse_cpu_capability(isa_name.c_str(), isa),
+            "invalid ISA level: ",
+            isa_name);
+        return set_dispatch_stub_capability(pattern, isa);
+      });
+
+  m.def(
+      "_reset_dispatch_stub_capability",
+      &torch_ipex::cpu::reset_dispatch_stub_capability);
+
+  m.def(
+      "_set_dispatch_stub_call_counting",
+      &torch_ipex::cpu::set_dispatch_stub_call_counting);
+
+  m.def(
+      "_reset_dispatch_stub_call_counts",
+      &torch_ipex::cpu::reset_dispatch_stub_call_counts);
+
+  m.def("_get_kernel_counters", []() {
+    py::list counters;
+    for (const auto& stats : torch_ipex::utils::get_kernel_counters()) {
+      py::dict counter;
+      counter["name"] = stats.name;
+      counter["calls"] = stats.calls;
+      counter["weight_bytes"] = stats.traffic.weight_bytes;
+      counter["kv_bytes"] = stats.traffic.kv_bytes;
+      counter["activation_bytes"] = stats.traffic.activation_bytes;
+      counter["flops"] = stats.traffic.flops;
+      counter["seconds"] = stats.seconds;
+      counters.append(counter);
+    }
+    return counters;
+  });
+
+  m.def(
+      "_set_kernel_counters_enabled",
+      &torch_ipex::utils::set_kernel_counters_enabled);
+
+  m.def("_reset_kernel_counters", &torch_ipex::utils::reset_kernel_counters);
+
+  m.def(
+      "_set_huge_page_mode",
+      [](const std::string& mode, int64_t min_bytes) {
+        torch_ipex::utils::set_huge_page_mode(
+            torch_ipex::utils::parse_huge_page_mode(mode), min_bytes);
+      },
+      py::arg("mode"),
+      py::arg("min_bytes") = -1);
+
+  m.def("_get_huge_page_mode", []() {
+    return std::string(torch_ipex::utils::huge_page_mode_name(
+        torch_ipex::utils::get_huge_page_mode()));
+  });
+
+  m.def(
+      "_get_huge_page_min_bytes", &torch_ipex::utils::get_huge_page_min_bytes);
+
+  m.def("_get_long_lived_allocations", []() {
+    py::list allocations;
+    for (const auto& alloc : torch_ipex::utils::get_long_lived_allocations()) {
+      py::dict allocation;
+      allocation["address"] = alloc.address;
+      allocation["bytes"] = alloc.bytes;
+      allocation["mapped_bytes"] = alloc.mapped_bytes;
+      allocation["mode"] = torch_ipex::utils::huge_page_mode_name(alloc.mode);
+      allocation["node"] = alloc.node;
+      allocation["huge_bytes"] = alloc.huge_bytes;
+      allocations.append(allocation);
+    }
+    return allocations;
+  });
+
+  m.def("_to_long_lived", &torch_ipex::utils::to_long_lived);
+
   m.def("mkldnn_set_verbose", &torch_ipex::utils::onednn_set_verbose);
   m.def("onednn_has_bf16_support", []() {
     return torch_ipex::utils::onednn_has_bf16_type_support();
@@ -232,6 +351,14 @@ void InitIpexModuleBindings(py::module m) {
   // libxsmm
   m.def("xsmm_manual_seed", &torch_ipex::tpp::xsmm_manual_seed);
   m.def("init_libxsmm", &torch_ipex::tpp::init_libxsmm);
+  m.def("tpp_reset_debug_timers", &torch_ipex::tpp::reset_debug_timers);
+  m.def("tpp_debug_timers_json", &torch_ipex::tpp::debug_timers_json);
+  m.def("tpp_enable_debug_timeline", &torch_ipex::tpp::enable_debug_timeline);
+  m.def(
+      "tpp_debug_timeline_chrome_trace",
+      &torch_ipex::tpp::debug_timeline_chrome_trace);
+  m.def("tpp_set_next_weight", &torch_ipex::tpp::set_next_weight);
+  m.def("tpp_clear_next_weights", &torch_ipex::tpp::clear_next_weights);
 
   // tpp-for-optimizer
   m.def("tpp_dense_sparse_add_", &torch_ipex::tpp::dense_sparse_add_);
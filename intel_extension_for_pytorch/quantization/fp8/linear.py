@@ -7,6 +7,7 @@ from torch.nn import init
 from intel_extension_for_pytorch.quantization.fp8.util import (
     cast_if_needed,
     cast_to_fp8,
+    cast_transpose_to_fp8,
 )
 import intel_extension_for_pytorch._isa_help as ipex
 from .base import Fp8BaseModule, prepare_backward
@@ -88,9 +89,7 @@ class _FP8Linear(torch.autograd.Function):
 
         if is_grad_enabled:
             ctx.save_for_backward(
-                inputmat,
                 inputmat_fp8,
-                weight,
                 weight_fp8,
                 fp8_meta["scaling_fwd"].scale_inv.clone(),
             )
@@ -107,23 +106,18 @@ class _FP8Linear(torch.autograd.Function):
     ) -> Tuple[Union[torch.Tensor, None], ...]:
         with prepare_backward(ctx.fp8_meta):
             (
-                inp,
                 inp_fp8,
-                weight,
                 weight_fp8,
                 fwd_scale_inverses,
             ) = ctx.saved_tensors
-            fp8_dtype_forward = get_fp8_dtype(
-                ctx.fp8_meta["recipe"], fprop_tensor=False
-            )
             fp8_dtype_backward = get_fp8_dtype(
                 ctx.fp8_meta["recipe"], fprop_tensor=False
             )
 
-            # grad_output preprocess
+            # grad_output preprocess, the transpose feeds the wgrad GEMM
             grad_output = grad_output.contiguous()
             grad_output_mat = grad_output.view((-1, grad_output.shape[-1]))
-            grad_output_fp8 = cast_to_fp8(
+            grad_output_fp8, grad_output_t_fp8 = cast_transpose_to_fp8(
                 grad_output_mat,
                 ctx.fp8_meta["scaling_bwd"],
                 ipex.FP8BwdTensors.GRAD_OUTPUT1,
@@ -134,35 +128,21 @@ class _FP8Linear(torch.autograd.Function):
             else:
                 grad_bias = None
 
-            # TODO:  Should store weight transpose
-            dgrad = torch.ops.torch_ipex.fp8_linear(
+            dgrad, wgrad = torch.ops.torch_ipex.fp8_linear_backward(
                 grad_output_fp8,
+                grad_output_t_fp8,
                 ctx.fp8_meta["scaling_bwd"].scale_inv,
                 ipex.FP8BwdTensors.GRAD_OUTPUT1,
-                fp8_dtype_backward,
-                weight_fp8.transpose(0, 1).contiguous(),
+                weight_fp8,
+                inp_fp8,
                 fwd_scale_inverses,
                 ipex.FP8FwdTensors.GEMM1_WEIGHT,
-                fp8_dtype_forward,
-                None,
-                None,
-            )
-
-            # TODO:  Should store inp transpose
-            wgrad = torch.ops.torch_ipex.fp8_linear(
-                grad_output_fp8.transpose(0, 1).contiguous(),
-                ctx.fp8_meta["scaling_bwd"].scale_inv,
-                ipex.FP8BwdTensors.GRAD_OUTPUT1,
-                fp8_dtype_backward,
-                inp_fp8.transpose(0, 1).contiguous(),
-                fwd_scale_inverses,
                 ipex.FP8FwdTensors.GEMM1_INPUT,
-                fp8_dtype_forward,
-                None,
-                None,
+                ctx.activation_dtype,
+                [ctx.needs_input_grad[0], ctx.needs_input_grad[1]],
             )
         return (
-            dgrad.view(ctx.inp_shape),
+            dgrad.view(ctx.inp_shape) if dgrad is not None else None,
             wgrad,
             grad_bias,
             None,
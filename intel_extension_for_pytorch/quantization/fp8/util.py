@@ -1,4 +1,6 @@
 """Utility functions for IPEX FP8 modules"""
+from typing import Tuple
+
 import torch
 from intel_extension_for_pytorch.frontend import _copy_model_and_optimizer
 
@@ -25,6 +27,23 @@ def cast_to_fp8(
     )
 
 
+def cast_transpose_to_fp8(
+    inp,
+    fp8_meta_tensor,
+    fp8_tensor,
+    otype,
+) -> Tuple[torch.Tensor, torch.Tensor]:
+    """Cast 2D input to FP8, also returns the transpose of the FP8 output"""
+    return torch.ops.torch_ipex.cast_transpose_to_fp8(
+        inp,
+        fp8_meta_tensor.scale,
+        fp8_meta_tensor.amax_history[0],
+        fp8_meta_tensor.scale_inv,
+        fp8_tensor,
+        otype,
+    )
+
+
 def cast_from_fp8(
     inp,
     fp8_meta_tensor,
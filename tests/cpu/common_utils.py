@@ -142,6 +142,40 @@ def shell(command, cwd=None):
         p.wait()
 
 
+_ISA_LEVELS = [
+    "default",
+    "avx2",
+    "avx2_vnni",
+    "avx512",
+    "avx512_vnni",
+    "avx512_bf16",
+    "amx",
+    "avx512_fp16",
+]
+
+
+def cpu_supports_isa(isa):
+    highest = ipex._C._get_highest_cpu_support_isa_level().lower()
+    if highest not in _ISA_LEVELS:
+        return False
+    return _ISA_LEVELS.index(highest) >= _ISA_LEVELS.index(isa)
+
+
+# Runs `test_id` (module.Class.test) in a subprocess with the IPEX kernels
+# dispatched to `isa`, e.g. to cover the AVX2 kernels on an AVX512 machine.
+# Returns the exit code and the output of the run.
+def run_test_with_isa(test_id, isa):
+    env = dict(os.environ, ATEN_CPU_CAPABILITY=isa)
+    result = subprocess.run(
+        [sys.executable, "-m", "unittest", test_id],
+        cwd=os.path.dirname(os.path.abspath(__file__)),
+        env=env,
+        stdout=subprocess.PIPE,
+        stderr=subprocess.STDOUT,
+    )
+    return result.returncode, result.stdout.decode()
+
+
 # Used to run the same test with different tensor types
 def repeat_test_for_types(dtypes):
     def repeat_helper(f):
@@ -1,7 +1,7 @@
 import unittest
 
 import torch
-from common_utils import TestCase
+from common_utils import TestCase, cpu_supports_isa, run_test_with_isa
 
 
 class add_layernorm(torch.nn.Module):
@@ -49,6 +49,13 @@ class AddLayerNormTester(TestCase):
                     # and causes mismatch with eager mode.
                     self.assertEqual(y1_bf16, y2_bf16, prec=5e-2)
 
+    @unittest.skipIf(not cpu_supports_isa("avx2"), "AVX2 is not supported")
+    def test_add_layernorm_avx2(self):
+        returncode, output = run_test_with_isa(
+            "test_add_layernorm.AddLayerNormTester.test_add_layernorm", "avx2"
+        )
+        self.assertEqual(returncode, 0, output)
+
 
 if __name__ == "__main__":
     test = unittest.main()
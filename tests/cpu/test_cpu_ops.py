@@ -1,5 +1,8 @@
 import unittest
 import copy
+import os
+import subprocess
+import sys
 import torch
 import torch.nn as nn
 import torch.nn.functional as F
@@ -859,6 +862,57 @@ class CPUOPsTester(TestCase):
         self.assertTrue(x_bf16.grad.dtype == torch.bfloat16)
         self.assertEqual(x_bf16.grad, x2.grad, prec=prec)
 
+    def test_group_norm_act(self):
+        def ref(x, groups, w, b, act, approximate, residual, scale):
+            y = F.group_norm(x, groups, w, b, 1e-5)
+            if act == "silu":
+                y = F.silu(y)
+            elif act == "gelu":
+                y = F.gelu(y, approximate=approximate)
+            if residual is not None:
+                y = y + residual
+            return y * scale
+
+        # HxW below and above the threshold of the two channels last impls
+        sizes = [(2, 64, 8, 8), (2, 64, 40, 40), (2, 32, 6, 5, 7)]
+        acts = [("silu", "none"), ("gelu", "none"), ("gelu", "tanh"), ("none", "none")]
+        for size, (act, approximate), dtype, affine, channels_last in itertools.product(
+            sizes, acts, [torch.float, torch.bfloat16], [True, False], [True, False]
+        ):
+            x = torch.randn(size)
+            if channels_last:
+                x = x.to(
+                    memory_format=torch.channels_last
+                    if x.dim() == 4
+                    else torch.channels_last_3d
+                )
+            w = torch.randn(size[1]) if affine else None
+            b = torch.randn(size[1]) if affine else None
+            for residual, scale in [(None, 1.0), (torch.randn(size), 0.5)]:
+                expected = ref(x, 16, w, b, act, approximate, residual, scale)
+                x_dtype = x.to(dtype)
+                w_dtype = w.to(dtype) if affine else None
+                b_dtype = b.to(dtype) if affine else None
+                r_dtype = residual.to(dtype) if residual is not None else None
+                y = torch.ops.torch_ipex.group_norm_act(
+                    x_dtype,
+                    16,
+                    w_dtype,
+                    b_dtype,
+                    1e-5,
+                    act,
+                    approximate,
+                    r_dtype,
+                    scale,
+                )
+                self.assertEqual(y.dtype, dtype)
+                self.assertEqual(
+                    y.is_contiguous(memory_format=torch.channels_last),
+                    x.is_contiguous(memory_format=torch.channels_last),
+                )
+                prec = 0.1 if dtype == torch.bfloat16 else None
+                self.assertEqual(y.float(), expected, prec=prec)
+
     def test_avg_pool2d(self):
         def helper(self, m, x):
             x1 = x.clone().detach().requires_grad_()
@@ -1322,6 +1376,42 @@ class CPUOPsTester(TestCase):
                 y1_5 = torch.index_select(x1_5, dim, indices, out=torch.empty(0))
                 self.assertTrue(y1_5.dtype == torch.float32)
 
+    def test_index_select_gather(self):
+        # long random index lists go through the prefetching gather engine
+        for datatype in [torch.float32, torch.bfloat16, torch.double]:
+            for inner in [1, 7, 64, 20000]:
+                x = torch.randn((3000, inner), dtype=datatype)
+                indices = torch.randint(3000, (5000,))
+                y = x.index_select(0, indices)
+                y_ref = torch.stack([x[i] for i in indices.tolist()])
+                self.assertEqual(y, y_ref)
+
+    def test_index_select_gather_streaming_page_order(self):
+        # lower the thresholds so streaming stores and page-ordered visiting
+        # are exercised by the small shapes of test_index_select_gather
+        for knobs in [
+            {"IPEX_GATHER_STREAMING_STORE_BYTES": "1"},
+            {
+                "IPEX_GATHER_PAGE_GROUP_MIN_INDICES": "1",
+                "IPEX_GATHER_PAGE_GROUP_TABLE_BYTES": "1",
+            },
+        ]:
+            env = dict(os.environ, IPEX_GATHER_PREFETCH_DISTANCE="3", **knobs)
+            command = [
+                sys.executable,
+                "-m",
+                "unittest",
+                "test_cpu_ops.CPUOPsTester.test_index_select_gather",
+            ]
+            result = subprocess.run(
+                command,
+                cwd=os.path.dirname(os.path.abspath(__file__)),
+                env=env,
+                stdout=subprocess.PIPE,
+                stderr=subprocess.STDOUT,
+            )
+            self.assertEqual(result.returncode, 0, result.stdout.decode())
+
     def test_cat(self):
         for datatype in [torch.float32, torch.double, torch.bfloat16, torch.float16]:
             for dim, size in itertools.product([0, 1], [[2, 1], [2, 2], [5, 10]]):
@@ -52,6 +52,62 @@ class TestCumSum(TestCase):
         # Check that output maintained correct shape
         self.assertEqual(raw_tensor.shape, raw_tensor.grad.shape)
 
+    def test_cumulative_scan(self):
+        def reference(op, x, dim, exclusive, reverse):
+            if reverse:
+                x = x.flip(dim)
+            out = op(x, dim)
+            if exclusive:
+                identity = {torch.cumsum: 0, torch.cumprod: 1}.get(op, -float("inf"))
+                first = torch.full_like(out.narrow(dim, 0, 1), identity)
+                out = torch.cat([first, out.narrow(dim, 0, out.size(dim) - 1)], dim)
+            return out.flip(dim) if reverse else out
+
+        ops = [
+            (torch.ops.torch_ipex.cumsum, torch.cumsum),
+            (torch.ops.torch_ipex.cumprod, torch.cumprod),
+            (torch.ops.torch_ipex.logcumsumexp, torch.logcumsumexp),
+        ]
+        # inner lanes, rows, and a few long rows for the blocked scan
+        shapes = [[3, 37, 65], [129, 7], [2, 40000]]
+        for ipex_op, op in ops:
+            for dtype in [torch.float, torch.double, torch.long]:
+                if op is torch.logcumsumexp and dtype is torch.long:
+                    continue
+                for shape in shapes:
+                    x = torch.rand(shape) + 0.5
+                    x = (x * 3).to(dtype) if dtype is torch.long else x.to(dtype)
+                    if op is torch.cumprod and dtype is torch.long:
+                        # signs only, any longer product of 1..4 overflows
+                        x = torch.randint(0, 2, shape) * 2 - 1
+                    elif op is torch.cumprod:
+                        # keep the products of long rows in range
+                        x = 1 + (x - 1) / shape[-1]
+                    for dim in range(len(shape)):
+                        for exclusive in [False, True]:
+                            for reverse in [False, True]:
+                                res = ipex_op(
+                                    x, dim, exclusive=exclusive, reverse=reverse
+                                )
+                                ref = reference(op, x, dim, exclusive, reverse)
+                                self.assertEqual(res, ref)
+
+        x = torch.randn(5, 17, 3)
+        y = x.clone()
+        torch.ops.torch_ipex.cumsum_(y, 1, exclusive=True, reverse=True)
+        self.assertEqual(y, reference(torch.cumsum, x, 1, True, True))
+
+        # the backward scans in the opposite direction
+        for ipex_op, op in ops:
+            for exclusive in [False, True]:
+                for reverse in [False, True]:
+                    x1 = torch.rand(4, 33, 6).requires_grad_()
+                    x2 = x1.detach().clone().requires_grad_()
+                    grad = torch.randn(4, 33, 6)
+                    ipex_op(x1, 1, exclusive=exclusive, reverse=reverse).backward(grad)
+                    reference(op, x2, 1, exclusive, reverse).backward(grad)
+                    self.assertEqual(x1.grad, x2.grad)
+
 
 if __name__ == "__main__":
     test = unittest.main()
@@ -2,6 +2,8 @@ import unittest
 import os
 import subprocess
 
+import torch
+import intel_extension_for_pytorch  # noqa: F401
 import intel_extension_for_pytorch._C as core
 
 supported_isa_set = [
@@ -117,6 +119,42 @@ class TestDynDisp(unittest.TestCase):
             cur_ipex_isa_1 = str(out[-1], "utf-8").strip()
             self.assertTrue(cur_ipex_isa == cur_ipex_isa_1)
 
+    def test_dispatch_stub_override(self):
+        def get_stub(name):
+            for stub in core._get_dispatch_stub_info():
+                if stub["name"] == name:
+                    return stub
+            return None
+
+        stub = get_stub("rmsnorm_kernel_stub")
+        self.assertTrue(stub is not None)
+        self.assertTrue("DEFAULT" in stub["compiled"])
+        with self.assertRaises(RuntimeError):
+            core._set_dispatch_stub_capability("rmsnorm_kernel_stub", "avx3")
+        if "AVX2" not in stub["compiled"] or get_isa_val(
+            get_highest_cpu_support_isa_level()
+        ) < get_isa_val("avx2"):
+            self.skipTest("AVX2 kernel is not compiled or not supported")
+
+        x = torch.randn(4, 67)
+        weight = torch.randn(67)
+        ref = torch.ops.torch_ipex.rmsnorm(x, weight, 1e-6)
+        core._reset_dispatch_stub_call_counts()
+        core._set_dispatch_stub_call_counting(True)
+        try:
+            self.assertEqual(core._set_dispatch_stub_capability("rmsnorm_*", "avx2"), 1)
+            out = torch.ops.torch_ipex.rmsnorm(x, weight, 1e-6)
+            stub = get_stub("rmsnorm_kernel_stub")
+            self.assertEqual(stub["override"], "AVX2")
+            self.assertEqual(stub["selected"], "AVX2")
+            self.assertEqual(stub["calls"], {"AVX2": 1})
+            self.assertTrue(torch.allclose(ref, out, rtol=1e-5, atol=1e-5))
+        finally:
+            core._reset_dispatch_stub_capability("*")
+            core._set_dispatch_stub_call_counting(False)
+        stub = get_stub("rmsnorm_kernel_stub")
+        self.assertTrue(stub["override"] is None)
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -378,6 +378,26 @@ class TestFakeCases(TestCase):
                     self.assertTrue(hy_fake[0].dtype == dtype)
                     self.assertTrue(hy_fake[1].dtype == dtype)
 
+    def test_kv_cache_compact(self):
+        # the compaction ops work in place and return nothing
+        mode = FakeTensorMode(allow_fallback_kernels=False)
+        with mode:
+            key_cache = torch.empty(32, 2, 4, 64)
+            value_cache = torch.empty(32, 2, 4, 64)
+            beam_idx = torch.empty(32, 2, dtype=torch.long)
+            accepted = torch.tensor([0, 2, 5])
+            torch.ops.torch_ipex.indirect_kv_cache_compact(
+                key_cache, value_cache, beam_idx, 9, accepted
+            )
+            key_cache = torch.empty(8, 16, 4, 64)
+            value_cache = torch.empty(8, 16, 4, 64)
+            slots = torch.tensor([20, 21, 22], dtype=torch.int)
+            torch.ops.torch_ipex.paged_kv_cache_compact(
+                key_cache, value_cache, slots, slots - 10
+            )
+            self.assertTrue(isinstance(key_cache, FakeTensor))
+            self.assertEqual(key_cache.size(), torch.Size([8, 16, 4, 64]))
+
 
 if __name__ == "__main__":
     torch.manual_seed(2020)
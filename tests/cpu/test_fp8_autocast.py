@@ -9,7 +9,12 @@ from intel_extension_for_pytorch.quantization.fp8 import (
     Format,
     prepare_fp8,
 )
+from intel_extension_for_pytorch.quantization.fp8.util import (
+    cast_to_fp8,
+    cast_transpose_to_fp8,
+)
 import intel_extension_for_pytorch._C as core
+import intel_extension_for_pytorch._isa_help as ipex_isa
 
 from torch.testing._internal.common_utils import TestCase
 from torch.optim import SGD
@@ -20,6 +25,48 @@ def get_rand_seed():
 
 
 class TestFP8Cases(TestCase):
+    def test_fp8_linear_backward(self):
+        fp8_e4m3 = ipex_isa.Float8Format.kFloat8_E4M3
+        fp8_e5m2 = ipex_isa.Float8Format.kFloat8_E5M2
+        M, N, K = 12, 8, 20
+        inp = torch.randn(M, K)
+        weight = torch.randn(N, K)
+        grad_output = torch.randn(M, N)
+
+        def make_meta(num):
+            meta = ipex_isa.FP8TensorMeta()
+            meta.scale = torch.ones(num) * 2
+            meta.scale_inv = torch.ones(num)
+            meta.amax_history = torch.zeros([1, num])
+            return meta
+
+        fwd_meta, bwd_meta = make_meta(3), make_meta(2)
+        inp_fp8 = cast_to_fp8(
+            inp, fwd_meta, ipex_isa.FP8FwdTensors.GEMM1_INPUT, fp8_e4m3
+        )
+        weight_fp8 = cast_to_fp8(
+            weight, fwd_meta, ipex_isa.FP8FwdTensors.GEMM1_WEIGHT, fp8_e4m3
+        )
+        grad_fp8, grad_fp8_t = cast_transpose_to_fp8(
+            grad_output, bwd_meta, ipex_isa.FP8BwdTensors.GRAD_OUTPUT1, fp8_e5m2
+        )
+        dgrad, wgrad = torch.ops.torch_ipex.fp8_linear_backward(
+            grad_fp8,
+            grad_fp8_t,
+            bwd_meta.scale_inv,
+            ipex_isa.FP8BwdTensors.GRAD_OUTPUT1,
+            weight_fp8,
+            inp_fp8,
+            fwd_meta.scale_inv,
+            ipex_isa.FP8FwdTensors.GEMM1_WEIGHT,
+            ipex_isa.FP8FwdTensors.GEMM1_INPUT,
+            torch.float,
+            [True, True],
+        )
+        grad_ref = grad_fp8.float() * 0.5
+        self.assertEqual(dgrad, grad_ref @ (weight_fp8.float() * 0.5))
+        self.assertEqual(wgrad, grad_ref.t() @ (inp_fp8.float() * 0.5))
+
     @unittest.skipIf(
         not core.onednn_has_fp8_support(),
         "IPEX FP8 is not supported on this CPU device",
@@ -1,7 +1,15 @@
 import torch
 import unittest
+import itertools
 import intel_extension_for_pytorch as ipex
-from intel_extension_for_pytorch.quantization.fp8.util import cast_to_fp8, cast_from_fp8
+from intel_extension_for_pytorch.quantization.fp8.util import (
+    cast_to_fp8,
+    cast_from_fp8,
+    cast_transpose_to_fp8,
+)
+from intel_extension_for_pytorch.quantization.fp8.fp8 import (
+    default_amax_and_scale_update,
+)
 from torch.testing._internal.common_utils import TestCase
 
 
@@ -73,5 +81,75 @@ class TestFP8Cast(TestCase):
         self.assertEqual(a, a_dequtized)
 
 
+    def test_fp8_cast_rounding_and_saturation(self):
+        formats = [
+            (ipex._isa_help.Float8Format.kFloat8_E4M3, torch.float8_e4m3fn, 448.0),
+            (ipex._isa_help.Float8Format.kFloat8_E5M2, torch.float8_e5m2, 57344.0),
+        ]
+        for (fp8_dtype, torch_fp8_dtype, fp8_max), dtype, numel in itertools.product(
+            formats, [torch.float, torch.bfloat16, torch.half], [1, 15, 33, 1031]
+        ):
+            a = torch.randn(numel) * 100
+            a[0] = 1e5
+            a = a.to(dtype)
+            fp8_meta = ipex._isa_help.FP8TensorMeta()
+            fp8_meta.scale = torch.ones(1) * 4
+            fp8_meta.scale_inv = torch.ones(1)
+            fp8_meta.amax_history = torch.zeros([1, 1])
+            fp8_tensor = ipex._isa_help.FP8FwdTensors.GEMM1_INPUT
+
+            a_quantized = cast_to_fp8(a, fp8_meta, fp8_tensor, fp8_dtype)
+            ref = (
+                (a.float() * 4).clamp(-fp8_max, fp8_max).to(torch_fp8_dtype).float()
+            )
+            self.assertEqual(a_quantized.float(), ref, atol=0, rtol=0)
+            self.assertEqual(fp8_meta.amax_history[0][0], a.float().abs().max())
+            self.assertEqual(fp8_meta.scale_inv[0], 0.25)
+
+            a_dequantized = cast_from_fp8(
+                a_quantized, fp8_meta, fp8_tensor, fp8_dtype, dtype
+            )
+            self.assertEqual(a_dequantized, (ref * 0.25).to(dtype), atol=0, rtol=0)
+
+    def test_fp8_cast_transpose(self):
+        fp8_dtype = ipex._isa_help.Float8Format.kFloat8_E5M2
+        for dtype, shape in itertools.product(
+            [torch.float, torch.bfloat16], [[3, 5], [65, 130], [128, 64]]
+        ):
+            a = (torch.randn(shape) * 10).to(dtype)
+            fp8_meta = ipex._isa_help.FP8TensorMeta()
+            fp8_meta.scale = torch.ones(1) * 2
+            fp8_meta.scale_inv = torch.ones(1)
+            fp8_meta.amax_history = torch.zeros([1, 1])
+            fp8_tensor = ipex._isa_help.FP8BwdTensors.GRAD_OUTPUT1
+
+            ref = cast_to_fp8(a, fp8_meta, fp8_tensor, fp8_dtype)
+            ref_amax = fp8_meta.amax_history[0][0].clone()
+            fp8_meta.amax_history.zero_()
+            a_fp8, a_fp8_t = cast_transpose_to_fp8(a, fp8_meta, fp8_tensor, fp8_dtype)
+            self.assertEqual(a_fp8.float(), ref.float(), atol=0, rtol=0)
+            self.assertEqual(a_fp8_t.float(), ref.float().t(), atol=0, rtol=0)
+            self.assertEqual(fp8_meta.amax_history[0][0], ref_amax)
+
+    def test_fp8_amax_and_scale_update(self):
+        for amax_compute_algo, history_len, margin in itertools.product(
+            ["max", "most_recent"], [1, 4], [0, 1]
+        ):
+            amax_history = torch.rand([history_len, 4]) * 100
+            amax_history[0][1] = 0
+            amax_history[0][2] = float("inf")
+            scale = torch.rand(4) + 1
+            scale_inv = 1.0 / scale
+            ref_history, ref_scale, ref_scale_inv = default_amax_and_scale_update(
+                amax_history.clone(), scale.clone(), 448.0, margin, amax_compute_algo
+            )
+            torch.ops.torch_ipex.fp8_amax_and_scale_update(
+                amax_history, scale, scale_inv, 448.0, margin, amax_compute_algo
+            )
+            self.assertEqual(amax_history, ref_history)
+            self.assertEqual(scale, ref_scale)
+            self.assertEqual(scale_inv, ref_scale_inv)
+
+
 if __name__ == "__main__":
     test = unittest.main()
@@ -516,6 +516,28 @@ class TestOptimizeCases(TestCase):
                     self.assertEqual(traced_M(input), loaded_M(input))
                     os.remove("traced_m.pt")
 
+    def test_traced_model_packed_weight_serialization(self):
+        for module, name in [(ConvBatchNorm, "conv"), (OneLayerMLP, "l1")]:
+            for dtype, auto_kernel_selection in itertools.product(
+                [torch.float, torch.bfloat16], [True, False]
+            ):
+                M = module().eval()
+                input = M.input1.to(dtype)
+                opt_M = ipex.optimize(
+                    M, dtype=dtype, auto_kernel_selection=auto_kernel_selection
+                )
+                with torch.no_grad():
+                    traced_M = torch.jit.trace(opt_M, input).eval()
+                    traced_M.save("traced_m.pt")
+                    loaded_M = torch.jit.load("traced_m.pt")
+                    # packed weights are restored in their packed layout
+                    self.assertEqual(
+                        getattr(traced_M, name).ctx.get_weight(),
+                        getattr(loaded_M, name).ctx.get_weight(),
+                    )
+                    self.assertEqual(traced_M(input), loaded_M(input))
+                    os.remove("traced_m.pt")
+
     def test_optimized_model_with_fx(self):
         for module in [ConvBatchNorm, OneLayerMLP, ConvTranspose2d]:
             for dtype in [torch.float, torch.bfloat16]:
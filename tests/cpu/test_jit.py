@@ -477,6 +477,39 @@ class Conv_Relu_Add(nn.Module):
         return torch.add(F.relu(self.conv1(x), inplace=True), self.conv2(x))
 
 
+class ConvPostOpChain(nn.Module):
+    def __init__(self, dim, in_channels, out_channels, **kwargs):
+        super(ConvPostOpChain, self).__init__()
+        seed = 2018
+        torch.manual_seed(seed)
+        self.conv = conv_module[dim](in_channels, out_channels, **kwargs)
+
+    def forward(self, x):
+        return torch.sigmoid(F.relu(self.conv(x))) * 2.0
+
+
+class ConvSumPostOpChain(nn.Module):
+    def __init__(self, dim, in_channels, out_channels, **kwargs):
+        super(ConvSumPostOpChain, self).__init__()
+        seed = 2018
+        torch.manual_seed(seed)
+        self.conv = conv_module[dim](in_channels, out_channels, **kwargs)
+
+    def forward(self, x, y):
+        return F.relu(self.conv(x) + y) * 2.0
+
+
+class ConvHardPostOpChain(nn.Module):
+    def __init__(self, dim, in_channels, out_channels, **kwargs):
+        super(ConvHardPostOpChain, self).__init__()
+        seed = 2018
+        torch.manual_seed(seed)
+        self.conv = conv_module[dim](in_channels, out_channels, **kwargs)
+
+    def forward(self, x):
+        return F.hardsigmoid(F.hardswish(self.conv(x)) * 2.0)
+
+
 class Conv_Scalar_Binary(nn.Module):
     def __init__(self, op, dim, in_channels, out_channels, **kwargs):
         super(Conv_Scalar_Binary, self).__init__()
@@ -776,6 +809,35 @@ class LinearAddRelu(nn.Module):
         return F.relu(a.add_(b), inplace=self.inplace)
 
 
+class LinearPostOpChain(nn.Module):
+    def __init__(self, in_channels, out_channels, **kwargs):
+        super(LinearPostOpChain, self).__init__()
+        self.linear = nn.Linear(in_channels, out_channels, **kwargs)
+
+    def forward(self, x, other, other2):
+        y = self.linear(x)
+        y = torch.mul(torch.add(y, other), other2)
+        return torch.clamp(F.gelu(y), min=-0.5, max=0.5)
+
+
+class LinearEltwiseChain(nn.Module):
+    def __init__(self, in_channels, out_channels, **kwargs):
+        super(LinearEltwiseChain, self).__init__()
+        self.linear = nn.Linear(in_channels, out_channels, **kwargs)
+
+    def forward(self, x):
+        return torch.clamp(F.gelu(self.linear(x)), min=-0.5, max=0.5)
+
+
+class LinearHardPostOpChain(nn.Module):
+    def __init__(self, in_channels, out_channels, **kwargs):
+        super(LinearHardPostOpChain, self).__init__()
+        self.linear = nn.Linear(in_channels, out_channels, **kwargs)
+
+    def forward(self, x, other):
+        return F.hardsigmoid(F.hardswish(self.linear(x) + other))
+
+
 class LinearMulAdd(nn.Module):
     def __init__(self, in_features, num_layers, low_rank):
         super(LinearMulAdd, self).__init__()
@@ -1365,6 +1427,16 @@ class AddLayerNorm_v2(torch.nn.Module):
         )
 
 
+class GroupNormAct(torch.nn.Module):
+    def __init__(self, channels, groups, act):
+        super(GroupNormAct, self).__init__()
+        self.norm = torch.nn.GroupNorm(groups, channels)
+        self.act = act
+
+    def forward(self, x):
+        return self.act(self.norm(x))
+
+
 class ConcatBnRelu(torch.nn.Module):
     def __init__(self, dim, cat_dim, in_channels, **kwargs):
         super(ConcatBnRelu, self).__init__()
@@ -1489,6 +1561,37 @@ class Bottleneck_v2(nn.Module):
         return y3.relu_()
 
 
+class InvertedResidual(nn.Module):
+    def __init__(self, in_channels, out_channels, stride, expand_ratio, activation):
+        super(InvertedResidual, self).__init__()
+        hidden = in_channels * expand_ratio
+        self.use_res_connect = stride == 1 and in_channels == out_channels
+        self.conv = nn.Sequential(
+            nn.Conv2d(in_channels, hidden, 1, bias=False),
+            nn.BatchNorm2d(hidden),
+            activation(inplace=True),
+            nn.Conv2d(hidden, hidden, 3, stride, 1, groups=hidden, bias=False),
+            nn.BatchNorm2d(hidden),
+            activation(inplace=True),
+            nn.Conv2d(hidden, out_channels, 1, bias=False),
+            nn.BatchNorm2d(out_channels),
+        )
+
+    def forward(self, x):
+        if self.use_res_connect:
+            return x + self.conv(x)
+        return self.conv(x)
+
+
+class Einsum(nn.Module):
+    def __init__(self, equation):
+        super(Einsum, self).__init__()
+        self.equation = equation
+
+    def forward(self, *inputs):
+        return torch.einsum(self.equation, *inputs)
+
+
 class EinsumAdd(nn.Module):
     def __init__(self, equation):
         super(EinsumAdd, self).__init__()
@@ -1688,6 +1791,54 @@ class Tester(TestCase):
                     )
                 )
 
+    def _test_post_op_chain(
+        self,
+        base_model,
+        x,
+        srcs,
+        kind_in_graph,
+        kind_not_in_graph=None,
+        auto_kernel_selection=False,
+        prec=None,
+    ):
+        # The binary sources are graph inputs so that they are neither folded
+        # into the weights nor constants of another dtype than the chain.
+        def _has_kind(graph, kind):
+            for n in graph.nodes():
+                if n.kind() == kind:
+                    return True
+                if n.hasAttribute("Subgraph") and _has_kind(n.g("Subgraph"), kind):
+                    return True
+                if any(_has_kind(b, kind) for b in n.blocks()):
+                    return True
+            return False
+
+        dtypes = [torch.float32]
+        if ipex._C.onednn_has_bf16_support():
+            dtypes.append(torch.bfloat16)
+        for dtype, use_te in itertools.product(dtypes, [True, False]):
+            with self._texpr_enable(use_te):
+                model = ipex.optimize(
+                    copy.deepcopy(base_model).eval(),
+                    dtype=dtype,
+                    auto_kernel_selection=auto_kernel_selection,
+                )
+                inputs = (x,) + tuple(src.to(dtype) for src in srcs)
+                with torch.cpu.amp.autocast(
+                    enabled=dtype == torch.bfloat16, dtype=torch.bfloat16
+                ), torch.no_grad():
+                    result = model(*inputs)
+                    traced = torch.jit.freeze(torch.jit.trace(model, inputs))
+                    traced(*inputs)
+                    trace_graph = traced.graph_for(*inputs)
+                    tresult = traced(*inputs)
+                self.assertEqual(
+                    result, tresult, prec=prec if dtype == torch.bfloat16 else None
+                )
+                self.assertTrue(_has_kind(trace_graph, kind_in_graph))
+                if kind_not_in_graph is not None:
+                    self.assertFalse(_has_kind(trace_graph, kind_not_in_graph))
+
     def _test_output_bf16(
         self,
         base_model,
@@ -2059,6 +2210,33 @@ class Tester(TestCase):
                 torch._C._jit_set_texpr_fuser_enabled(pre_te_enable_status)
                 self.assertTrue(any(n.kind() == node for n in trace_graph.nodes()))
 
+    def test_group_norm_act(self):
+        acts = [
+            torch.nn.SiLU(),
+            torch.nn.SiLU(inplace=True),
+            torch.nn.GELU(),
+            torch.nn.GELU(approximate="tanh"),
+        ]
+        memory_formats = [torch.contiguous_format, torch.channels_last]
+        for act, memory_format in itertools.product(acts, memory_formats):
+            with torch.no_grad():
+                model = GroupNormAct(64, 32, act).eval()
+                x = torch.randn(2, 64, 16, 16).to(memory_format=memory_format)
+                pre_te_enable_status = torch._C._jit_texpr_fuser_enabled()
+                torch._C._jit_set_texpr_fuser_enabled(False)
+                jit_model = torch.jit.freeze(torch.jit.trace(model, x))
+                for _ in range(2):
+                    jit_res = jit_model(x)
+                trace_graph = jit_model.graph_for(x)
+                torch._C._jit_set_texpr_fuser_enabled(pre_te_enable_status)
+                self.assertEqual(jit_res, model(x))
+                self.assertTrue(
+                    any(
+                        n.kind() == "torch_ipex::group_norm_act"
+                        for n in trace_graph.nodes()
+                    )
+                )
+
     def test_concat_bn_relu(self):
         batch_size = 3
         image_size = 16
@@ -3004,6 +3182,76 @@ class Tester(TestCase):
                 kind_not_in_graph="ipex_prepack::convolution_relu_prepack",
             )
 
+    def test_output_conv_post_op_chain(self):
+        batch_size = 2
+        out_channels = 12
+        in_channels = 3
+        kernel_size = 3
+        image_size = 24
+        for dim in [2, 3]:
+            input_size = [batch_size, in_channels, image_size, image_size]
+            if dim == 3:
+                input_size.append(image_size)
+            x = torch.randn(input_size)
+            self._test_output(
+                ConvPostOpChain(
+                    dim, in_channels, out_channels, kernel_size=kernel_size, stride=1
+                ),
+                x,
+                kind_in_graph="ipex_prepack::convolution_post_ops_run",
+                kind_not_in_graph="aten::sigmoid",
+            )
+
+    def test_output_conv_hard_post_op_chain(self):
+        # hardswish and hardsigmoid take their 1/6 and 1/2 from alpha and beta
+        batch_size = 2
+        out_channels = 12
+        in_channels = 3
+        kernel_size = 3
+        image_size = 24
+        for dim in [2, 3]:
+            input_size = [batch_size, in_channels, image_size, image_size]
+            if dim == 3:
+                input_size.append(image_size)
+            x = torch.randn(input_size) * 4
+            self._test_post_op_chain(
+                ConvHardPostOpChain(
+                    dim, in_channels, out_channels, kernel_size=kernel_size, stride=1
+                ),
+                x,
+                [],
+                kind_in_graph="ipex_prepack::convolution_post_ops_run",
+                kind_not_in_graph="aten::hardswish",
+                prec=0.02,
+            )
+
+    def test_output_conv_sum_post_op_chain(self):
+        batch_size = 2
+        out_channels = 12
+        in_channels = 3
+        kernel_size = 3
+        image_size = 24
+        for dim in [2, 3]:
+            input_size = [batch_size, in_channels, image_size, image_size]
+            output_size = [batch_size, out_channels, image_size - 2, image_size - 2]
+            if dim == 3:
+                input_size.append(image_size)
+                output_size.append(image_size - 2)
+            x = torch.randn(input_size)
+            m = ConvSumPostOpChain(
+                dim, in_channels, out_channels, kernel_size=kernel_size, stride=1
+            )
+            # a full size accumulator, and a per channel one that is broadcast
+            for y_size in [output_size, [1, out_channels] + [1] * dim]:
+                self._test_post_op_chain(
+                    m,
+                    x,
+                    [torch.randn(y_size)],
+                    kind_in_graph="ipex_prepack::convolution_sum_post_ops_run",
+                    kind_not_in_graph="aten::relu",
+                    prec=0.02,
+                )
+
     def test_output_conv_scalar_binary(self):
         batch_size = 2
         out_channels = 12
@@ -3882,6 +4130,39 @@ class Tester(TestCase):
                 eager_y = m(x2)
                 self.assertEqual(eager_y, traced_y)
 
+    def test_inverted_residual_fusion(self):
+        x = torch.randn(2, 24, 17, 19)
+        for activation, (out_channels, stride) in itertools.product(
+            [nn.ReLU6, nn.SiLU, nn.Hardswish], [(24, 1), (32, 1), (40, 2)]
+        ):
+            m = InvertedResidual(24, out_channels, stride, 6, activation)
+            self._test_output(
+                m,
+                x,
+                kind_in_graph="ipex_prepack::convolution_inverted_residual_run",
+                prec=1e-4,
+                use_channels_last=[True],
+                levels=["O1"],
+            )
+            self._test_output_bf16(
+                m,
+                x,
+                kind_in_graph="ipex_prepack::convolution_inverted_residual_run",
+                prec=0.05,
+                use_channels_last=[True],
+                levels=["O1"],
+            )
+        # dynamic shape
+        m = InvertedResidual(24, 24, 1, 6, nn.ReLU6).eval()
+        m = m.to(memory_format=torch.channels_last)
+        x = x.to(memory_format=torch.channels_last)
+        with torch.no_grad():
+            traced = torch.jit.freeze(torch.jit.trace(m, x))
+            traced(x)
+            traced(x)
+            x2 = torch.randn(1, 24, 7, 9).to(memory_format=torch.channels_last)
+            self.assertEqual(m(x2), traced(x2), prec=1e-4)
+
     def test_jit_conv_sum_in_diff_block(self):
         batch_size = 8
         out_channels = 32
@@ -4200,10 +4481,10 @@ class Tester(TestCase):
 
                 if not auto_select_kernel and level == "O1":
                     # for auto_select_kernel is False and level is O1 (weights_prepack is True),
-                    # we will use ipex prepacked MKL linear
+                    # we will use ipex prepacked MKL linear with relu as its post-op
                     self.assertTrue(
                         any(
-                            n.kind() == "ipex_prepack::mkl_sgemm_run"
+                            n.kind() == "ipex_prepack::mkl_sgemm_post_ops_run"
                             for n in trace_graph.nodes()
                         )
                     )
@@ -4420,7 +4701,9 @@ class Tester(TestCase):
                 m = _cls(eltwise, in_channels, out_channels, bias, **op_input_list)
 
                 self._test_output(m, x, kind_in_graph="aten::linear")
-                self._test_mkl_fp32(m, x, kind_in_graph="ipex_prepack::mkl_sgemm_run")
+                self._test_mkl_fp32(
+                    m, x, kind_in_graph="ipex_prepack::mkl_sgemm_post_ops_run"
+                )
                 self._test_dnnl_fp32(
                     m, x, kind_in_graph="ipex_prepack::linear_%s_run" % ipex_eltwise_op
                 )
@@ -4506,6 +4789,62 @@ class Tester(TestCase):
                 prec=5e-2,
             )
 
+    def test_output_linear_post_op_chain(self):
+        m = LinearPostOpChain(3, 8, bias=True)
+        x = torch.randn(4, 3)
+        # full size sources, and sources broadcast along rows or columns
+        for other_size, other2_size in [
+            ([4, 8], [4, 8]),
+            ([8], [1]),
+            ([4, 1], [8]),
+        ]:
+            self._test_post_op_chain(
+                m,
+                x,
+                [torch.randn(other_size), torch.rand(other2_size)],
+                kind_in_graph="ipex_prepack::linear_binary2_post_ops_run",
+                kind_not_in_graph="aten::clamp",
+                auto_kernel_selection=True,
+                prec=5e-2,
+            )
+
+    def test_output_linear_hard_post_op_chain(self):
+        m = LinearHardPostOpChain(3, 8, bias=True)
+        x = torch.randn(4, 3) * 4
+        self._test_post_op_chain(
+            m,
+            x,
+            [torch.randn(4, 8)],
+            kind_in_graph="ipex_prepack::linear_binary_post_ops_run",
+            kind_not_in_graph="aten::hardsigmoid",
+            auto_kernel_selection=True,
+            prec=5e-2,
+        )
+
+    def test_output_linear_mkl_post_ops(self):
+        # the small shape runs the JIT sgemm, 333 output features split into
+        # uneven column blocks per thread with a tail in the epilogue
+        for in_features, out_features in [(16, 64), (64, 333)]:
+            m = LinearEltwiseChain(in_features, out_features, bias=True).eval()
+            x = torch.randn(4, in_features)
+            self._test_mkl_fp32(
+                m, x, kind_in_graph="ipex_prepack::mkl_sgemm_post_ops_run"
+            )
+            for num_threads in [1, 3, 4, 0]:
+                model = ipex.optimize(
+                    copy.deepcopy(m), dtype=torch.float32, sample_input=x
+                )
+                # set before tracing, so the frozen graph runs this context
+                model.linear.ctx.set_num_threads(num_threads)
+                with torch.no_grad():
+                    traced = torch.jit.freeze(torch.jit.trace(model, x))
+                    # 4 is the packed batch size, others run the unpacked weight
+                    for batch in [4, 1, 37]:
+                        y = torch.randn(batch, in_features)
+                        ref = m(y)
+                        self.assertEqual(model(y), ref)
+                        self.assertEqual(traced(y), ref)
+
     def test_output_linear_mul_add(self):
         m = LinearMulAdd(4, 2, 8)
         x = torch.ones(2, 4)
@@ -4939,7 +5278,7 @@ class Tester(TestCase):
         input1 = torch.randn(4, 3, 768)
         input2 = torch.randn(768, 2304)
         model_v1 = EinsumAddInplaceV1("bsh,ho->bso")
-        _test_fp32(model_v1, input1, input2, bias, kind_in_graph="aten::einsum")
+        _test_fp32(model_v1, input1, input2, bias, kind_in_graph="ipex::einsum")
 
         bias1 = torch.randn(2, 4, 128, 128)
         input3 = torch.randn(2, 4, 128, 768)
@@ -5133,6 +5472,51 @@ class Tester(TestCase):
         model_from_vit_alphafold2_v3 = EinsumAdd("bsh,bho->bso")
         _test_fp32(model_from_vit_alphafold2_v3, input1, input2, bias)
 
+    def test_einsum(self):
+        def _test(equation, *inputs):
+            model = Einsum(equation).eval()
+            with torch.no_grad():
+                tr_model = torch.jit.freeze(torch.jit.trace(model, inputs))
+                tr_model(*inputs)
+                tr_model(*inputs)
+                trace_graph = tr_model.graph_for(*inputs)
+                self.assertEqual(tr_model(*inputs), model(*inputs), prec=1e-3)
+                self.assertTrue(
+                    any(n.kind() == "ipex::einsum" for n in trace_graph.nodes())
+                )
+
+        # attention with the heads not outermost, no transposed copies needed
+        q = torch.randn(2, 64, 4, 32)
+        k = torch.randn(2, 48, 4, 32)
+        v = torch.randn(2, 48, 4, 32)
+        _test("bqhd,bkhd->bhqk", q, k)
+        _test("bhqk,bkhd->bqhd", torch.randn(2, 4, 64, 48), v)
+        # transposed operands
+        _test("ij,jk->ik", torch.randn(40, 64).t(), torch.randn(48, 40).t())
+        _test("ij,jk->ki", torch.randn(64, 40), torch.randn(40, 48))
+        # tensor networks with several operands and contraction indices
+        _test(
+            "abc,cd,de->abe",
+            torch.randn(4, 8, 16),
+            torch.randn(16, 32),
+            torch.randn(32, 8),
+        )
+        _test(
+            "ab,bc,cd,da->",
+            torch.randn(8, 16),
+            torch.randn(16, 32),
+            torch.randn(32, 24),
+            torch.randn(24, 8),
+        )
+        _test("abcd,dcbe->ae", torch.randn(2, 3, 4, 40), torch.randn(40, 4, 3, 6))
+        # repeated labels, labels summed out of one operand and ellipsis
+        _test("ii,ij->j", torch.randn(16, 16), torch.randn(16, 8))
+        _test("ijk,jl->il", torch.randn(4, 8, 16), torch.randn(8, 32))
+        _test("...ij,...jk->...ik", torch.randn(2, 3, 8, 16), torch.randn(3, 16, 4))
+        # fallback of broadcast dims and other dtypes
+        _test("bij,bjk->bik", torch.randn(1, 8, 16), torch.randn(4, 16, 8))
+        _test("ij,jk->ik", torch.randn(8, 16).double(), torch.randn(16, 8).double())
+
     def test_ipex_softmax(self):
         self._test_output(
             AtenSoftmaxRepalce(), torch.rand(3, 4, 4), kind_in_graph="ipex::softmax"
@@ -1,6 +1,6 @@
 import torch
 import torch.nn as nn
-from common_utils import TestCase
+from common_utils import TestCase, cpu_supports_isa, run_test_with_isa
 import unittest
 from typing import Tuple
 import intel_extension_for_pytorch as ipex
@@ -774,10 +774,111 @@ class MaskedMHATest(TestCase):
                             value_cache_iakv_half[offset, :, :, :],
                         )
 
+    def test_mha_tree_attention(self):
+        torch.manual_seed(0)
+        head_num, head_num_kv, head_size = 8, 2, 64
+        group = head_num // head_num_kv
+        prompt_len, max_seq_len = 9, 32
+        # 0 -> (1, 2), 1 -> 3, 2 -> (4, 5)
+        parents = torch.tensor([-1, 0, 0, 1, 2, 2])
+        num_candidates = parents.size(0)
+        tree_mask = torch.ops.torch_ipex.tree_attention_mask(parents)
+        scale = head_size**0.5
+        for dtype, batch_size in [
+            (torch.float, 1),
+            (torch.float, 2),
+            (torch.bfloat16, 2),
+        ]:
+
+            def qkv(seq_len):
+                return [
+                    torch.randn(batch_size, seq_len, n, head_size).to(dtype)
+                    for n in (head_num, head_num_kv, head_num_kv)
+                ]
+
+            query_p, key_p, value_p = qkv(prompt_len)
+            _, _, key_cache, value_cache, beam_idx = (
+                torch.ops.torch_ipex.masked_multihead_self_attention(
+                    query_p,
+                    key_p,
+                    value_p,
+                    torch.zeros(1, 1, 1, 1, dtype=dtype),
+                    torch.zeros(1, 1, 1, 1, dtype=dtype),
+                    torch.zeros(1, batch_size, dtype=torch.long),
+                    torch.tensor(0),
+                    scale,
+                    max_seq_len,
+                    None,
+                    torch.zeros(batch_size, 1, prompt_len, prompt_len, dtype=dtype),
+                )
+            )
+            # verify all the candidates in one step
+            query_t, key_t, value_t = qkv(num_candidates)
+            seq_len = prompt_len + num_candidates
+            out, _, key_cache, value_cache, beam_idx = (
+                torch.ops.torch_ipex.masked_multihead_self_attention(
+                    query_t,
+                    key_t,
+                    value_t,
+                    key_cache,
+                    value_cache,
+                    beam_idx,
+                    torch.tensor(prompt_len),
+                    scale,
+                    max_seq_len,
+                    None,
+                    torch.zeros(batch_size, 1, num_candidates, seq_len, dtype=dtype),
+                    None,
+                    tree_mask,
+                )
+            )
+            for b in range(batch_size):
+                for i in range(num_candidates):
+                    visible = [
+                        j
+                        for j in range(num_candidates)
+                        if (int(tree_mask[i, 0]) >> j) & 1
+                    ]
+                    k = torch.cat([key_p[b], key_t[b, visible]]).float()
+                    v = torch.cat([value_p[b], value_t[b, visible]]).float()
+                    k = k.repeat_interleave(group, dim=1)
+                    v = v.repeat_interleave(group, dim=1)
+                    w = torch.einsum("hd,lhd->hl", query_t[b, i].float(), k)
+                    w = (w / scale).softmax(-1)
+                    ref = torch.einsum("hl,lhd->hd", w, v)
+                    tol = 5e-2 if dtype is torch.bfloat16 else 1e-4
+                    self.assertEqual(out[b, :, i].float(), ref, atol=tol, rtol=tol)
+
+            # keep the accepted path 0 -> 2 -> 5 right after the prompt, with
+            # distinct beam_idx entries to see them move along
+            accepted = torch.tensor([0, 2, 5])
+            beam_idx[prompt_len:seq_len] = torch.arange(
+                num_candidates * batch_size
+            ).view(num_candidates, batch_size)
+            ref_beam_idx = beam_idx[prompt_len + accepted].clone()
+            torch.ops.torch_ipex.indirect_kv_cache_compact(
+                key_cache, value_cache, beam_idx, prompt_len, accepted
+            )
+            self.assertEqual(beam_idx[prompt_len : prompt_len + 3], ref_beam_idx)
+            for b in range(batch_size):
+                self.assertEqual(
+                    key_cache[prompt_len : prompt_len + 3, b], key_t[b, accepted]
+                )
+                self.assertEqual(
+                    value_cache[prompt_len : prompt_len + 3, b], value_t[b, accepted]
+                )
+
     def test_mha(self):
         self._test_mha(torchcompile=False)
         self._test_mha_fp16(torchcompile=False)
 
+    @unittest.skipIf(not cpu_supports_isa("avx2"), "AVX2 is not supported")
+    def test_mha_avx2(self):
+        returncode, output = run_test_with_isa(
+            "test_masked_mha.MaskedMHATest.test_mha", "avx2"
+        )
+        self.assertEqual(returncode, 0, output)
+
     def test_mha_torchcompile(self):
         self._test_mha(torchcompile=True)
         self._test_mha_fp16(torchcompile=True)
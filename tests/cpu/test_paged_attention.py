@@ -1,5 +1,5 @@
 import torch
-from common_utils import TestCase
+from common_utils import TestCase, cpu_supports_isa, run_test_with_isa
 import unittest
 import random
 from typing import List, Optional, Tuple
@@ -224,6 +224,100 @@ class PagedAttentionTest(TestCase):
                 seed,
             )
 
+    def test_paged_attention_ragged(self):
+        # head sizes that are not a multiple of the vector width, to cover the
+        # scalar tails of the head reductions
+        num_blocks = 128
+        for head_size, use_alibi, block_size, dtype in product(
+            [36, 100], [True, False], [16], [torch.bfloat16, torch.float]
+        ):
+            self._test_paged_attention_func(
+                7, (16, 4), head_size, use_alibi, num_blocks, block_size, dtype, 0
+            )
+
+    @unittest.skipIf(not cpu_supports_isa("avx2"), "AVX2 is not supported")
+    def test_paged_attention_avx2(self):
+        for test in ["test_paged_attention", "test_paged_attention_ragged"]:
+            returncode, output = run_test_with_isa(
+                "test_paged_attention.PagedAttentionTest." + test, "avx2"
+            )
+            self.assertEqual(returncode, 0, output)
+
+    def test_paged_attention_tree(self):
+        torch.manual_seed(0)
+        num_blocks, block_size, num_head, head_size = 16, 16, 4, 64
+        scale = float(1.0 / (head_size**0.5))
+        # two levels of three and two candidates plus a lone third level one
+        parents = torch.tensor([-1, -1, -1, 0, 0, 1, 3])
+        tree_mask = torch.ops.torch_ipex.tree_attention_mask(parents)
+        num_candidates = parents.size(0)
+        for dtype, prefix_len in product([torch.float, torch.bfloat16], [1, 37]):
+            key_caches, value_caches = self.create_kv_caches(
+                num_blocks, block_size, 1, num_head, head_size, dtype, 0
+            )
+            key_cache, value_cache = key_caches[0], value_caches[0]
+            block_table = torch.randperm(num_blocks, dtype=torch.int)[:4]
+            block_tables = block_table.repeat(num_candidates, 1)
+            # every candidate is a query whose context ends with itself
+            context_lens = prefix_len + 1 + torch.arange(num_candidates).int()
+            query = torch.empty(num_candidates, num_head, head_size, dtype=dtype)
+            query.uniform_(-scale, scale)
+            head_mapping = torch.arange(num_head, dtype=torch.int32)
+            output = torch.empty_like(query)
+            torch.ops.torch_ipex.single_query_cached_kv_attention(
+                output,
+                query,
+                key_cache,
+                value_cache,
+                head_mapping,
+                scale,
+                block_tables,
+                context_lens,
+                block_size,
+                int(context_lens.max()),
+                None,
+                tree_mask,
+            )
+
+            def slot(pos):
+                return int(block_table[pos // block_size]) * block_size + (
+                    pos % block_size
+                )
+
+            flat_keys = key_cache.view(-1, num_head, head_size)
+            flat_values = value_cache.view(-1, num_head, head_size)
+            for i in range(num_candidates):
+                visible = list(range(prefix_len))
+                visible += [
+                    prefix_len + j
+                    for j in range(i + 1)
+                    if (int(tree_mask[i, 0]) >> j) & 1
+                ]
+                slots = torch.tensor([slot(p) for p in visible])
+                ref = self.ref_masked_attention(
+                    query[i].unsqueeze(0),
+                    flat_keys[slots],
+                    flat_values[slots],
+                    scale,
+                )
+                self.assertEqual(
+                    output[i], ref.view(num_head, head_size), atol=5e-3, rtol=1e-3
+                )
+
+            # keep the accepted path 0 -> 3 -> 6 right after the prefix
+            accepted = [0, 3, 6]
+            src_slots = torch.tensor([slot(prefix_len + j) for j in accepted]).int()
+            dst_slots = torch.tensor(
+                [slot(prefix_len + k) for k in range(len(accepted))]
+            ).int()
+            ref_keys = flat_keys[src_slots.long()].clone()
+            ref_values = flat_values[src_slots.long()].clone()
+            torch.ops.torch_ipex.paged_kv_cache_compact(
+                key_cache, value_cache, src_slots, dst_slots
+            )
+            self.assertEqual(flat_keys[dst_slots.long()], ref_keys)
+            self.assertEqual(flat_values[dst_slots.long()], ref_values)
+
     def _test_reshape_and_cache_func(
         self,
         num_token: int,
@@ -15,7 +15,7 @@ import unittest
 import transformers
 from transformers import AutoConfig
 import numpy
-from common_utils import TestCase
+from common_utils import TestCase, cpu_supports_isa, run_test_with_isa
 
 import intel_extension_for_pytorch as ipex
 from test_ao_jit_llga_utils import JitLlgaTestCase, LLGA_FUSION_GROUP
@@ -1070,6 +1070,15 @@ class WeightOnlyQuantizationTester(TestCase):
         for shape, use_bias in cases:
             test(shape, use_bias)
 
+    @unittest.skipIf(not cpu_supports_isa("avx2"), "AVX2 is not supported")
+    def test_weight_only_quantization_quint4x2_weight_avx2(self):
+        returncode, output = run_test_with_isa(
+            "test_quantization_default_recipe.WeightOnlyQuantizationTester."
+            "test_weight_only_quantization_quint4x2_weight",
+            "avx2",
+        )
+        self.assertEqual(returncode, 0, output)
+
     def test_weight_only_quantization_gelu_fused_op(self):
         class Mod(nn.Module):
             def __init__(self, bias):
@@ -2,6 +2,9 @@ import torch
 import torch.nn as nn
 from common_utils import TestCase
 import unittest
+import os
+import subprocess
+import sys
 
 
 class RMSNorm(nn.Module):
@@ -67,6 +70,24 @@ class RMSNormTester(TestCase):
                 y2_bf16 = compiled_model(x_bf16, fused_rmsnorm=True)
                 self.assertEqual(y1_bf16, y2_bf16)
 
+    def test_RMSNorm_avx2(self):
+        # force the 256-bit kernel, also on machines with AVX512
+        env = dict(os.environ, ATEN_CPU_CAPABILITY="avx2")
+        command = [
+            sys.executable,
+            "-m",
+            "unittest",
+            "test_rmsnorm.RMSNormTester.test_RMSNorm",
+        ]
+        result = subprocess.run(
+            command,
+            cwd=os.path.dirname(os.path.abspath(__file__)),
+            env=env,
+            stdout=subprocess.PIPE,
+            stderr=subprocess.STDOUT,
+        )
+        self.assertEqual(result.returncode, 0, result.stdout.decode())
+
 
 if __name__ == "__main__":
     test = unittest.main()
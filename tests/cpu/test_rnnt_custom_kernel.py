@@ -146,13 +146,19 @@ class TestRNNTUpdateBatch(TestCase):
     def test_rnnt_update_batch(self):
         self._SOS = -1
         self.max_len = 192
-        dtypes = [torch.float, torch.bfloat16]
+        # (dtype of x and hidden, dtype of hidden_prime)
+        dtypes = [
+            (torch.float, torch.float),
+            (torch.bfloat16, torch.bfloat16),
+            (torch.bfloat16, torch.float),
+            (torch.float, torch.bfloat16),
+        ]
         loop_cnts = [1, 10, 30]
         batch_sizes = [1, 15, 64, 448]
         max_symbols = [30]
         blank_ids = [1, 21]
 
-        for batch_size, max_symbol, blank_id, loop_cnt, dtype in list(
+        for batch_size, max_symbol, blank_id, loop_cnt, (dtype, prime_dtype) in list(
             product(batch_sizes, max_symbols, blank_ids, loop_cnts, dtypes)
         ):
             x_org = torch.randn([self.max_len, batch_size, 2], dtype=dtype)
@@ -162,8 +168,8 @@ class TestRNNTUpdateBatch(TestCase):
                 torch.zeros([2, batch_size, 320], dtype=dtype),
             ]
             hidden_prime = [
-                torch.randn([2, batch_size, 320], dtype=dtype),
-                torch.randn([2, batch_size, 320], dtype=dtype),
+                torch.randn([2, batch_size, 320], dtype=prime_dtype),
+                torch.randn([2, batch_size, 320], dtype=prime_dtype),
             ]
 
             (
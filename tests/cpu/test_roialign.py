@@ -213,6 +213,35 @@ class RoIAlignTester(TestCase):
                 torch.allclose(gt_x.grad.to(x4.dtype), x4.grad, rtol=1e-5, atol=1e-5)
             )
 
+    def test_roialign_backward_parallel(self):
+        # overlapping ROIs of several images, the parallel backward must match
+        # the single thread result exactly
+        torch.manual_seed(0)
+        batch_size, n_rois = 3, 64
+        boxes = torch.rand(n_rois, 4) * 24
+        rois = torch.cat(
+            [
+                torch.randint(0, batch_size, (n_rois, 1)).float(),
+                torch.min(boxes[:, :2], boxes[:, 2:]),
+                torch.max(boxes[:, :2], boxes[:, 2:]),
+            ],
+            dim=1,
+        )
+        num_threads = torch.get_num_threads()
+        for n_channels, channels_last in itertools.product([3, 37], [False, True]):
+            x = torch.rand(batch_size, n_channels, 25, 25)
+            if channels_last:
+                x = x.to(memory_format=torch.channels_last)
+            grads = []
+            for threads in [1, num_threads]:
+                torch.set_num_threads(threads)
+                x1 = x.clone().detach().requires_grad_()
+                y = fn(x1, rois, 7, 7, spatial_scale=1, sampling_ratio=2)
+                y.backward(torch.ones_like(y))
+                grads.append(x1.grad)
+            torch.set_num_threads(num_threads)
+            self.assertEqual(grads[0], grads[1], atol=0, rtol=0)
+
     @skipIfNoTorchVision
     def test_torchvision_roialign(self):
         pool_size = 5
@@ -1,5 +1,8 @@
 import unittest
 import itertools
+import os
+import subprocess
+import sys
 import torch
 import intel_extension_for_pytorch as ipex
 from torch.testing._internal.common_utils import TestCase
@@ -92,6 +95,25 @@ class Linear_add_add(torch.nn.Module):
         return self.mlp(x) + x + x
 
 
+class Linear_lora(torch.nn.Module):
+    def __init__(self, in_feature, out_feature):
+        super(Linear_lora, self).__init__()
+        self.mlp = torch.nn.Linear(in_feature, out_feature)
+
+    def forward(self, x):
+        return self.mlp(x)
+
+
+def lora_ref(x, weight, bias, lora_a, lora_b, adapter_idx, scale):
+    x2 = x.reshape(-1, x.size(-1))
+    idx = adapter_idx.clamp(min=0)
+    out = torch.nn.functional.linear(x2, weight, bias)
+    xa = torch.einsum("nc,ncr->nr", x2, lora_a[idx])
+    delta = torch.einsum("nr,nrk->nk", xa, lora_b[idx]) * scale
+    mask = (adapter_idx >= 0).unsqueeze(1).to(out.dtype)
+    return (out + delta * mask).view(*x.shape[:-1], -1)
+
+
 class Linear_tpp_fallback_dnnl(torch.nn.Module):
     def __init__(self):
         super(Linear_tpp_fallback_dnnl, self).__init__()
@@ -145,6 +167,115 @@ class TestTPPlinear(TestCase):
             self.assertEqual(out_nb, ref_out_nb)
             _disable_tpp()
 
+    def test_tpp_linear_roofline_counters(self):
+        from intel_extension_for_pytorch.cpu.utils import roofline
+
+        x = torch.rand(1, 1, 4096)
+        _enable_tpp()
+        model = ipex.optimize(Linear_with_bias().eval(), dtype=torch.float)
+        model(x)
+        with roofline.record():
+            model(x)
+            model(x)
+        model(x)
+        _disable_tpp()
+        counters = {c["name"]: c for c in roofline.counters()}
+        tpp = counters["tpp_linear"]
+        self.assertEqual(tpp["calls"], 2)
+        self.assertEqual(tpp["weight_bytes"], 2 * (4096 * 4096 + 4096) * 4)
+        self.assertEqual(tpp["activation_bytes"], 2 * 2 * 4096 * 4)
+        self.assertEqual(tpp["flops"], 2 * 2 * 4096 * 4096)
+        self.assertGreater(tpp["seconds"], 0)
+        self.assertEqual(counters["woq_linear"]["calls"], 0)
+        text = roofline.report(peak_gbps=100.0, peak_gflops=1000.0)
+        self.assertIn("tpp_linear", text)
+        roofline.reset()
+        self.assertEqual(roofline.counters()[1]["calls"], 0)
+
+    def test_tpp_linear_dynamic_loop_schedule(self):
+        # 111 rows leave a remainder block, the schedule is read once per
+        # process so each one runs in a fresh interpreter
+        code = (
+            "import torch\n"
+            "import intel_extension_for_pytorch as ipex\n"
+            "from intel_extension_for_pytorch.cpu._auto_kernel_selection "
+            "import _enable_tpp\n"
+            "x = torch.rand(3, 37, 4096)\n"
+            "model = torch.nn.Linear(4096, 4096).eval()\n"
+            "ref = model(x)\n"
+            "_enable_tpp()\n"
+            "out = ipex.optimize(model, dtype=torch.float)(x)\n"
+            "torch.testing.assert_close(out, ref, rtol=1e-4, atol=1e-4)\n"
+        )
+        for schedule in ["dynamic", "auto"]:
+            env = dict(os.environ, TPP_LOOP_SCHEDULE=schedule)
+            result = subprocess.run(
+                [sys.executable, "-c", code],
+                env=env,
+                stdout=subprocess.PIPE,
+                stderr=subprocess.STDOUT,
+            )
+            self.assertEqual(result.returncode, 0, result.stdout.decode())
+
+    def test_tpp_linear_gemv_weight_stream(self):
+        # up to 8 rows run in the weight streaming mode, 9 rows do not
+        for rows, dtype in itertools.product(
+            [1, 4, 8, 9], [torch.float32, torch.bfloat16]
+        ):
+            x = torch.rand(1, rows, 4096).to(dtype)
+            model = Linear_with_bias().to(dtype).eval()
+            with torch.no_grad():
+                ref_out = model(x)
+            _enable_tpp()
+            opt_model = ipex.optimize(model, dtype=dtype)
+            with torch.no_grad():
+                out = opt_model(x)
+            _disable_tpp()
+            self.assertEqual(out, ref_out)
+
+    def test_tpp_linear_next_weight_prefetch(self):
+        from intel_extension_for_pytorch.cpu.tpp import prefetch
+
+        model = torch.nn.Sequential(
+            Linear_with_bias(), Linear_without_bias(), Linear_silu()
+        ).eval()
+        x = torch.rand(1, 1, 4096)
+        with torch.no_grad():
+            ref_out = model(x)
+        _enable_tpp()
+        opt_model = ipex.optimize(model, dtype=torch.float)
+        self.assertEqual(prefetch.register_layer_order(opt_model), 3)
+        with torch.no_grad():
+            out = opt_model(x)
+            out_2 = opt_model(x)
+        prefetch.clear()
+        _disable_tpp()
+        self.assertEqual(out, ref_out)
+        self.assertEqual(out_2, ref_out)
+
+    def test_tpp_linear_huge_pages(self):
+        from intel_extension_for_pytorch.cpu.utils import huge_pages
+
+        x = torch.rand(1, 4, 4096)
+        model = Linear_with_bias().eval()
+        with torch.no_grad():
+            ref_out = model(x)
+        huge_pages.set_mode("thp")
+        _enable_tpp()
+        opt_model = ipex.optimize(model, dtype=torch.float)
+        with torch.no_grad():
+            out = opt_model(x)
+        allocs = huge_pages.allocations()
+        self.assertEqual(huge_pages.get_mode(), "thp")
+        self.assertTrue(len(allocs) > 0)
+        for alloc in allocs:
+            self.assertTrue(alloc["mapped_bytes"] >= alloc["bytes"])
+            self.assertEqual(alloc["mapped_bytes"] % (2 << 20), 0)
+        self.assertTrue(huge_pages.report().startswith("huge page mode thp"))
+        huge_pages.set_mode("off")
+        _disable_tpp()
+        self.assertEqual(out, ref_out)
+
     def test_tpp_linear_torchcompile(self):
         x = torch.rand(2, 2, 4096)
 
@@ -588,6 +719,119 @@ class TestTPPlinear(TestCase):
             self.assertTrue(out.dtype == dtype)
             _disable_tpp()
 
+    def test_tpp_linear_lora(self):
+        in_feature, out_feature, rank, n_adapters = 256, 128, 8, 3
+        scale = 2.0
+        lora_a = torch.randn(n_adapters, in_feature, rank) * 0.1
+        lora_b = torch.randn(n_adapters, rank, out_feature) * 0.1
+        # 140 and 300 rows cover the remainder block and the first token path,
+        # the first sequence uses one adapter and the second one mixes
+        # adapters with rows that have none
+        for seq_len, dtype in itertools.product(
+            [70, 150], [torch.float, torch.bfloat16]
+        ):
+            x = torch.randn(2, seq_len, in_feature).to(dtype)
+            adapter_idx = torch.cat(
+                [
+                    torch.full((seq_len,), 1, dtype=torch.long),
+                    torch.randint(-1, n_adapters, (seq_len,)),
+                ]
+            )
+            model = Linear_lora(in_feature, out_feature).eval().to(dtype)
+            ref_model = copy.deepcopy(model).float()
+            a, b = lora_a.to(dtype).float(), lora_b.to(dtype).float()
+            ref_out = lora_ref(
+                x.float(),
+                ref_model.mlp.weight,
+                ref_model.mlp.bias,
+                a,
+                b,
+                adapter_idx,
+                scale,
+            )
+            ref_out_single = lora_ref(
+                x.float(),
+                ref_model.mlp.weight,
+                ref_model.mlp.bias,
+                a,
+                b,
+                torch.zeros_like(adapter_idx),
+                scale,
+            )
+
+            _enable_tpp()
+            model = ipex.optimize(model, dtype=dtype)
+            with torch.no_grad():
+                out = ipex.cpu.tpp.fused_lora.tpp_linear_lora(
+                    x,
+                    model.mlp.weight,
+                    model.mlp.bias,
+                    lora_a.to(dtype),
+                    lora_b.to(dtype),
+                    adapter_idx,
+                    scale,
+                )
+                out_single = ipex.cpu.tpp.fused_lora.tpp_linear_lora(
+                    x,
+                    model.mlp.weight,
+                    model.mlp.bias,
+                    lora_a[0].to(dtype),
+                    lora_b[0].to(dtype),
+                    None,
+                    scale,
+                )
+            tol = 5e-2 if dtype is torch.bfloat16 else 1e-4
+            self.assertEqual(out.float(), ref_out, atol=tol, rtol=tol)
+            self.assertEqual(out_single.float(), ref_out_single, atol=tol, rtol=tol)
+            _disable_tpp()
+
+    def test_tpp_linear_lora_backward(self):
+        in_feature, out_feature, rank, n_adapters = 256, 128, 8, 3
+        scale = 0.5
+        x = torch.randn(2, 70, in_feature)
+        adapter_idx = torch.randint(-1, n_adapters, (140,))
+        lora_a = torch.randn(n_adapters, in_feature, rank) * 0.1
+        lora_b = torch.randn(n_adapters, rank, out_feature) * 0.1
+        grad_out = torch.randn(2, 70, out_feature)
+        model = Linear_lora(in_feature, out_feature).eval()
+        ref_model = copy.deepcopy(model)
+        for multi_adapter in [True, False]:
+            idx = adapter_idx if multi_adapter else torch.zeros_like(adapter_idx)
+            ref_x = x.clone().requires_grad_()
+            ref_a = lora_a.clone().requires_grad_()
+            ref_b = lora_b.clone().requires_grad_()
+            ref_out = lora_ref(
+                ref_x,
+                ref_model.mlp.weight.detach(),
+                ref_model.mlp.bias.detach(),
+                ref_a,
+                ref_b,
+                idx,
+                scale,
+            )
+            ref_out.backward(grad_out)
+
+            _enable_tpp()
+            tpp_model = ipex.optimize(copy.deepcopy(model), dtype=torch.float)
+            tpp_x = x.clone().requires_grad_()
+            tpp_a = lora_a.clone().requires_grad_()
+            tpp_b = lora_b.clone().requires_grad_()
+            out = ipex.cpu.tpp.fused_lora.tpp_linear_lora(
+                tpp_x,
+                tpp_model.mlp.weight,
+                tpp_model.mlp.bias,
+                tpp_a,
+                tpp_b,
+                adapter_idx if multi_adapter else None,
+                scale,
+            )
+            out.backward(grad_out)
+            self.assertEqual(out, ref_out, atol=1e-4, rtol=1e-4)
+            self.assertEqual(tpp_x.grad, ref_x.grad, atol=1e-4, rtol=1e-4)
+            self.assertEqual(tpp_a.grad, ref_a.grad, atol=1e-4, rtol=1e-4)
+            self.assertEqual(tpp_b.grad, ref_b.grad, atol=1e-4, rtol=1e-4)
+            _disable_tpp()
+
 
 if __name__ == "__main__":
     test = unittest.main()
@@ -1,4 +1,7 @@
 import unittest
+import json
+import os
+import tempfile
 import torch
 import random
 import numpy
@@ -81,6 +84,72 @@ class TPPOPsTester(TestCase):
             else:
                 self.assertEqual(param_hf.grad, param_tpp.grad, prec=0.005)
 
+    def test_tpp_dense_sparse_add(self):
+        # duplicated indices must be applied once each, like index_add_
+        for dtype, prec in [
+            (torch.float, 1e-5),
+            (torch.bfloat16, 1e-1),
+            (torch.half, 1e-2),
+        ]:
+            for num_rows, nnz in [(3, 50), (1000, 4000)]:
+                dense = torch.randn(num_rows, 64).to(dtype)
+                indices = torch.randint(num_rows, (nnz,))
+                values = torch.randn(nnz, 64).to(dtype)
+                sparse = torch.sparse_coo_tensor(
+                    indices.unsqueeze(0), values, dense.size()
+                )
+                ref = dense.float().index_add(0, indices, values.float(), alpha=-0.1)
+                torch_ipex_cpp.tpp_dense_sparse_add_(dense, sparse, -0.1)
+                self.assertEqual(dense.float(), ref, prec=prec)
+
+    @unittest.skipIf(
+        not ipex.cpu.tpp.profiling.debug_timers()["profile_tpp"],
+        "TPP timers are only collected when built with PROFILE_TPP",
+    )
+    def test_tpp_debug_timers_export(self):
+        profiling = ipex.cpu.tpp.profiling
+        dense = torch.randn(16, 64)
+        sparse = torch.sparse_coo_tensor(
+            torch.randint(16, (1, 32)), torch.randn(32, 64), dense.size()
+        )
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, "tpp_trace.json")
+            with profiling.timeline(path):
+                for _ in range(3):
+                    torch_ipex_cpp.tpp_dense_sparse_add_(dense, sparse, -0.1)
+            with open(path) as f:
+                trace = json.load(f)
+
+        events = trace["traceEvents"]
+        self.assertTrue(any(e["ph"] == "M" for e in events))
+        scope_events = [e for e in events if e.get("cat") == "tpp_scope"]
+        self.assertEqual(len(scope_events), 3)
+        for e in scope_events:
+            self.assertEqual(e["name"], "sprse_add")
+            self.assertEqual(e["args"]["pass"], "UPD")
+            self.assertGreater(e["dur"], 0)
+        for e in events:
+            if e.get("cat") != "tpp_thread":
+                continue
+            self.assertEqual(e["name"], "sprse_add")
+            self.assertGreater(e["dur"], 0)
+            self.assertGreaterEqual(e["tid"], 1)
+        self.assertEqual(trace["otherData"]["dropped_events"], 0)
+
+        timers = profiling.debug_timers()
+        self.assertGreater(timers["num_threads"], 0)
+        scopes = {scope["name"]: scope for scope in timers["scopes"]}
+        self.assertIn("sprse_add", scopes)
+        scope = scopes["sprse_add"]
+        self.assertGreater(scope["time"], 0)
+        self.assertEqual(len(scope["threads"]), timers["num_threads"])
+        self.assertLessEqual(scope["thread_time"]["min"], scope["thread_time"]["max"])
+        for scope in timers["passes"] + timers["scopes"]:
+            self.assertEqual(len(scope["threads"]), timers["num_threads"])
+
+        profiling.reset_timers()
+        self.assertEqual(profiling.debug_timers()["scopes"], [])
+
     def test_tpp_bert_embeddings(self):
         hf_embs = transformers.models.bert.modeling_bert.BertEmbeddings(self.config)
         tpp_embs = ipex.cpu.tpp.fused_bert.BertEmbeddings(self.config)
@@ -186,6 +255,135 @@ class TPPOPsTester(TestCase):
             hf_res, tpp_res, hf_intermediate, tpp_intermediate, prec=0.01
         )
 
+    def _llama_config(self):
+        return transformers.LlamaConfig(
+            hidden_size=512,
+            intermediate_size=1024,
+            num_attention_heads=8,
+            num_key_value_heads=2,
+            rms_norm_eps=1e-6,
+        )
+
+    def test_tpp_llama_rmsnorm(self):
+        config = self._llama_config()
+        hf_norm = transformers.models.llama.modeling_llama.LlamaRMSNorm(
+            config.hidden_size, eps=config.rms_norm_eps
+        )
+        tpp_norm = ipex.cpu.tpp.fused_llama.LlamaRMSNorm(
+            config.hidden_size, eps=config.rms_norm_eps
+        )
+        with torch.no_grad():
+            hf_norm.weight.uniform_(0.5, 1.5)
+        tpp_norm.load_state_dict(hf_norm.state_dict())
+        hidden_states = torch.randn(self.batch, 128, config.hidden_size)
+        hf_res = hf_norm(hidden_states)
+        tpp_res = (
+            tpp_norm(hidden_states.view(-1, config.hidden_size))
+            .unblocked_tensor()
+            .view(self.batch, 128, -1)
+        )
+        self.assertEqual(hf_res, tpp_res, prec=0.0001)
+        self._test_backward(hf_res, tpp_res, hf_norm, tpp_norm)
+
+    def test_tpp_llama_mlp(self):
+        config = self._llama_config()
+        hf_mlp = transformers.models.llama.modeling_llama.LlamaMLP(config)
+        tpp_mlp = ipex.cpu.tpp.fused_llama.LlamaMLP(config)
+        tpp_mlp.load_state_dict(hf_mlp.state_dict())
+        hidden_states = torch.randn(self.batch, 128, config.hidden_size)
+        residual = torch.randn(self.batch, 128, config.hidden_size)
+        hf_res = hf_mlp(hidden_states) + residual
+        tpp_res = (
+            tpp_mlp(
+                hidden_states.view(-1, config.hidden_size),
+                residual.view(-1, config.hidden_size),
+            )
+            .unblocked_tensor()
+            .view(self.batch, 128, -1)
+        )
+        self.assertEqual(hf_res, tpp_res, prec=0.001)
+        self._test_backward(hf_res, tpp_res, hf_mlp, tpp_mlp, prec=0.01)
+
+    def _llama_rotary_inputs(self, config, head_dim, S):
+        # causal mask and position ids for HF, and the rotary tables and
+        # sequence offsets of the unpadded layout for TPP
+        causal_mask = torch.full((S, S), torch.finfo(torch.float).min).triu(1)
+        causal_mask = causal_mask.expand(self.batch, 1, S, S)
+        position_ids = torch.arange(S).expand(self.batch, -1)
+        attention_mask = torch.zeros(self.batch, 1, 1, S)
+        _, _, seq_offsets, seq_sqr_offsets = ipex.cpu.tpp.fused_bert.generate_mask(
+            attention_mask
+        )
+        blocked_layout = ipex.cpu.tpp.utils.blocked_layout
+        _, S2 = blocked_layout.BlockedModule.default_blocking_factors(S)
+        cos, sin = ipex.cpu.tpp.fused_llama.rotary_cos_sin(
+            seq_offsets, S2, head_dim, config.rope_theta
+        )
+        return causal_mask, position_ids, (cos, sin, seq_offsets, seq_sqr_offsets)
+
+    def test_tpp_llama_attention(self):
+        # causal GQA attention with rotary embedding, two kv heads shared by
+        # eight query heads
+        unpad = ipex.cpu.tpp.fused_bert.unpad
+        ipex.cpu.tpp.fused_bert.unpad = False
+        try:
+            config = self._llama_config()
+            S = 128
+            hf_att = transformers.models.llama.modeling_llama.LlamaAttention(config, 0)
+            tpp_att = ipex.cpu.tpp.fused_llama.LlamaAttention(config)
+            tpp_att.load_state_dict(hf_att.state_dict(), strict=False)
+            hidden_states = torch.randn(self.batch, S, config.hidden_size)
+            residual = torch.randn(self.batch, S, config.hidden_size)
+            causal_mask, position_ids, rotary_inputs = self._llama_rotary_inputs(
+                config, tpp_att.head_dim, S
+            )
+            hf_res = (
+                hf_att(hidden_states, causal_mask, position_ids=position_ids)[0]
+                + residual
+            )
+            tpp_res = (
+                tpp_att(
+                    hidden_states.view(-1, config.hidden_size),
+                    residual.view(-1, config.hidden_size),
+                    *rotary_inputs,
+                )
+                .unblocked_tensor()
+                .view(self.batch, S, -1)
+            )
+            self.assertEqual(hf_res, tpp_res, prec=0.0005)
+            self._test_backward(hf_res, tpp_res, hf_att, tpp_att, prec=0.005)
+        finally:
+            ipex.cpu.tpp.fused_bert.unpad = unpad
+
+    def test_tpp_llama_decoder_layer(self):
+        unpad = ipex.cpu.tpp.fused_bert.unpad
+        ipex.cpu.tpp.fused_bert.unpad = False
+        try:
+            config = self._llama_config()
+            S = 128
+            hf_layer = transformers.models.llama.modeling_llama.LlamaDecoderLayer(
+                config, 0
+            )
+            with torch.no_grad():
+                hf_layer.input_layernorm.weight.uniform_(0.5, 1.5)
+                hf_layer.post_attention_layernorm.weight.uniform_(0.5, 1.5)
+            tpp_layer = ipex.cpu.tpp.fused_llama.LlamaDecoderLayer(config)
+            tpp_layer.load_state_dict(hf_layer.state_dict(), strict=False)
+            hidden_states = torch.randn(self.batch, S, config.hidden_size)
+            causal_mask, position_ids, rotary_inputs = self._llama_rotary_inputs(
+                config, tpp_layer.self_attn.head_dim, S
+            )
+            hf_res = hf_layer(hidden_states, causal_mask, position_ids=position_ids)[0]
+            tpp_res = (
+                tpp_layer(hidden_states.view(-1, config.hidden_size), *rotary_inputs)
+                .unblocked_tensor()
+                .view(self.batch, S, -1)
+            )
+            self.assertEqual(hf_res, tpp_res, prec=0.001)
+            self._test_backward(hf_res, tpp_res, hf_layer, tpp_layer, prec=0.01)
+        finally:
+            ipex.cpu.tpp.fused_bert.unpad = unpad
+
 
 if __name__ == "__main__":
     test = unittest.main()